@@ -46,6 +46,8 @@
 // Vector
 #include "sctl/vector.hpp"
 #include "sctl/vector.txx"
+#include "sctl/mapped_file.hpp"
+#include "sctl/mapped_file.txx"
 
 // Matrix, Permutation operators
 #include "sctl/permutation.hpp"
@@ -63,6 +65,8 @@
 #include "sctl/vec-test.hpp"
 #include "sctl/vec-test.hpp"
 #include "sctl/intrin-wrapper.hpp"
+#include "sctl/cpu-dispatch.hpp"
+#include "sctl/cpu-dispatch.txx"
 
 // OpenMP merge-sort and scan
 #include "sctl/ompUtils.hpp"
@@ -78,6 +82,8 @@
 // Morton
 #include "sctl/morton.hpp"
 #include "sctl/morton.txx"
+#include "sctl/hilbert.hpp"
+#include "sctl/hilbert.txx"
 
 // Spherical Harmonics
 #include "sctl/sph_harm.hpp"
@@ -92,6 +98,10 @@
 #include "sctl/profile.hpp"
 #include "sctl/profile.txx"
 
+// Metrics registry
+#include "sctl/metrics.hpp"
+#include "sctl/metrics.txx"
+
 // Print stack trace
 #include "sctl/stacktrace.h"
 
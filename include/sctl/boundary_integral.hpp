@@ -1,6 +1,7 @@
 #ifndef _SCTL_BOUNDARY_INTEGRAL_HPP_
 #define _SCTL_BOUNDARY_INTEGRAL_HPP_
 
+#include <cstdint>               // for uint64_t
 #include <map>                   // for map
 #include <string>                // for basic_string, to_string, string
 #include <typeinfo>              // for type_info
@@ -13,12 +14,17 @@
 
 namespace sctl {
 
+  class MemoryArena;
   template <class ValueType> class Matrix;
 
   /**
    * Given N target points and K elements (each made of a set of source nodes with given radius that describes its near
    * region), return vectors containing the set of near targets (coordinates and normals) for each element.
    *
+   * The sources are binned in Morton boxes with size comparable to their radius (a hierarchical cell-list), and the
+   * near targets of each element are found by searching the neighboring boxes. The search is parallelized over the
+   * elements with OpenMP; the output does not depend on the number of threads.
+   *
    * @param[in] Xtrg vector of length N*DIM, containing the target coordinates in AoS order {x1,y1,z1,..., xn,,yn,zn}.
    *
    * @param[in] Xn_trg vector of target normals in AoS order (can be empty).
@@ -212,6 +218,15 @@ namespace sctl {
       virtual bool MatrixFree() const;
   };
 
+  /**
+   * Storage format of the near-interaction matrices precomputed by BoundaryIntegralOp.
+   */
+  enum class NearCompression {
+    NONE,    ///< dense matrices in working precision
+    FLOAT,   ///< dense matrices in single precision (same as NONE if Real is float)
+    LOWRANK  ///< truncated SVD of each element's matrix, with relative tolerance set by SetAccuracy()
+  };
+
   /**
    * Implements parallel computation of boundary integrals.
    *
@@ -280,6 +295,56 @@ namespace sctl {
        */
       Real GetAccuracy() const;
 
+      /**
+       * Set the storage format of the precomputed near-interaction matrices (default NearCompression::NONE).
+       * Compressed matrices reduce the memory footprint after Setup(). With compression, the matrices are also
+       * computed in batches of elements, so that the uncompressed matrices are never stored all at once.
+       */
+      void SetNearCompression(NearCompression near_compression);
+
+      /**
+       * Get the storage format of the near-interaction matrices.
+       */
+      NearCompression GetNearCompression() const;
+
+      /**
+       * Set the maximum memory (in bytes) used to store precomputed near-interaction matrices (default -1, no limit).
+       * When the matrices of all elements do not fit in the budget, elements are precomputed in Setup() in increasing
+       * order of their number of nodes (each near target of an element stores one matrix row per node, so this covers
+       * the most element-target pairs within the budget), and the rest are recomputed in each call to
+       * ComputePotential(). This trades the memory of Setup() against the cost of each evaluation.
+       */
+      void SetNearMemoryBudget(Long max_bytes);
+
+      /**
+       * Get the memory budget for precomputed near-interaction matrices.
+       */
+      Long GetNearMemoryBudget() const;
+
+      /**
+       * Set a path prefix for caching the setup data on disk (default empty, no caching). The self-interaction
+       * matrices (K_self), the near-interaction lists, scatter indices and matrices (K_near) are then read in Setup()
+       * from the files `<prefix>-<key>-<rank>.bin` when they exist on all processes, and are otherwise computed and
+       * written to these files. The key is a hash of the element-list discretizations (nodes, normals and far-field
+       * quadrature nodes), the target points, the kernel type, the accuracy, periodicity and near-compression
+       * settings, and the partition of the elements and targets across processes. The files are binary (one per
+       * process), with 64-byte aligned arrays so that they can be memory-mapped.
+       *
+       * The key does not include the state of the kernel object (e.g. the context set by GenericKernel::SetCtxPtr)
+       * or element-list parameters that do not change the discretization nodes. These must be identified by the
+       * caller-supplied `key`, which is included in the hash; caching is disabled when the kernel has a context and
+       * `key` is empty.
+       *
+       * @param[in] prefix Path prefix of the cache files.
+       * @param[in] key Identifies the kernel context and other parameters not included in the hash.
+       */
+      void SetSetupCache(const std::string& prefix, const std::string& key = "");
+
+      /**
+       * Get the path prefix of the setup cache files.
+       */
+      const std::string& GetSetupCache() const;
+
       /**
        * Set kernel functions for FMM translation operators (@see pvfmm.org).
        *
@@ -371,6 +436,20 @@ namespace sctl {
        */
       void ComputePotential(Vector<Real>& U, const Vector<Real>& F) const;
 
+      /**
+       * Evaluate the boundary integral operator for a batch of densities. The
+       * far-field kernel evaluations and the near-interaction matrices are
+       * shared by all densities in the batch. This can be used directly as the
+       * operator for block GMRES (GMRES::BlockParallelOp).
+       *
+       * @param[out] U the potential computed at each target point, one row for
+       * each density, in array-of-struct order.
+       *
+       * @param[in] F the charge densities at each surface discretization node,
+       * one density per row, in array-of-struct order.
+       */
+      void ComputePotential(Matrix<Real>& U, const Matrix<Real>& F) const;
+
       /**
        * Scale input vector by sqrt of the area of the element.
        * TODO: replace by sqrt of surface quadrature weights (not sure if it makes a difference though)
@@ -383,15 +462,51 @@ namespace sctl {
        */
       void InvSqrtScaling(Vector<Real>& U) const;
 
+      /**
+       * Apply the block-Jacobi preconditioner built from the self-interaction
+       * blocks: for each element, U = F * inv(alpha*I + K_self), where K_self is
+       * the (singular) interaction of the element with its own discretization
+       * nodes. For a second-kind integral equation (alpha*I + K) F = U, this
+       * inverts the dominant diagonal blocks, which is effective for elements
+       * with high aspect-ratio. The inverses are computed (using the
+       * pseudo-inverse) on the first call and recomputed when alpha or the setup
+       * changes. The elements are processed in parallel with OpenMP and no
+       * communication is needed. The preconditioner can be set in a
+       * KrylovPrecond object and passed to GMRES.
+       *
+       * @param[out] U the preconditioned vector (may be the same as F).
+       *
+       * @param[in] F the input vector at each surface discretization node in
+       * array-of-struct order.
+       *
+       * @param[in] alpha coefficient of the identity in the operator.
+       *
+       * @note Requires on-surface targets (SetTargetCoord() not called) and
+       * equal source and target dimensions of the kernel. The elements of
+       * matrix-free element-lists are scaled by 1/alpha (or unchanged when alpha
+       * is zero).
+       */
+      void SelfPrecond(Vector<Real>& U, const Vector<Real>& F, const Real alpha) const;
+
     private:
 
       void SetupBasic() const;
       void SetupFar() const;
       void SetupSelf() const;
       void SetupNear() const;
+      void SetupSelfPrecond(const Real alpha) const;
+
+      uint64_t SetupCacheKey() const; // collective
+      bool ReadSetupCache(const std::string& fname, const uint64_t key) const;
+      bool WriteSetupCache(const std::string& fname, const uint64_t key) const;
 
-      void ComputeFarField(Vector<Real>& U, const Vector<Real>& F) const;
-      void ComputeNearInterac(Vector<Real>& U, const Vector<Real>& F) const;
+      void ComputeFarField(Matrix<Real>& U, const Matrix<Real>& F) const;
+      void ComputeNearInterac(Matrix<Real>& U, const Matrix<Real>& F) const;
+
+      static void LowRankNear(Matrix<Real>& U, Matrix<Real>& V, const Matrix<Real>& K, const Real tol); // K ~ U * V, truncated at relative tolerance tol
+      void ApplyNear(Matrix<Real>& U, const Matrix<Real>& F, const Long elem_idx) const; // U <-- F * K_near[elem_idx]
+      void NearMatrixTrg(Matrix<Real>& K_near_, const Long elem_idx, const Long k, MemoryArena& arena) const; // set columns of K_near_ for the k-th near target of elem_idx
+      void NearMatrixSubtractDirect(Matrix<Real>& K_near_, const Long elem_idx, MemoryArena& arena) const; // subtract direct-interaction part from K_near_
 
       struct ElemLstData {
         void (*SelfInterac)(Vector<Matrix<Real>>&, const Kernel&, Real, bool, const ElementListBase<Real>*);
@@ -405,6 +520,10 @@ namespace sctl {
       Periodicity periodicity_ = Periodicity::NONE;
       Real period_length_ = 0;
       Real tol_;
+      NearCompression near_compression_ = NearCompression::NONE;
+      Long near_mem_budget_ = -1;
+      std::string setup_cache_;
+      std::string setup_cache_key_;
       Kernel ker_;
       bool trg_normal_dot_prod_;
       Comm comm_;
@@ -433,9 +552,16 @@ namespace sctl {
       mutable Vector<Long> near_elem_cnt, near_elem_dsp; // cnt and dsp of near-interaction for each element (size=Nelem)
       mutable Vector<Long> K_near_cnt, K_near_dsp; // cnt and dsp of element wise near-interaction matrix (size=Nelem)
       mutable Vector<Real> K_near;
+      mutable Vector<Matrix<float>> K_near_f; // element wise near-interaction matrices in single precision (NearCompression::FLOAT)
+      mutable Vector<Matrix<Real>> K_near_U, K_near_V; // element wise low-rank factors K_near = U * V, or the dense matrix in U (NearCompression::LOWRANK)
+      mutable Vector<Long> near_onfly_elem; // elements with near-interaction matrices computed in each evaluation (near_mem_budget_)
 
       mutable bool setup_self_flag;
       mutable Vector<Matrix<Real>> K_self;
+
+      mutable bool setup_self_precond_flag;
+      mutable Real self_precond_alpha;
+      mutable Vector<Matrix<Real>> K_self_inv; // inv(alpha*I + K_self) for each element (size=Nelem, empty for matrix-free elements)
   };
 
 }
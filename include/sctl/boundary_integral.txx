@@ -2,13 +2,19 @@
 #define _SCTL_BOUNDARY_INTEGRAL_TXX_
 
 #include <omp.h>                       // for omp_get_num_threads, omp_get_t...
+#include <stdio.h>                     // for fopen, fread, fwrite, fseek, ftell
 #include <algorithm>                   // for lower_bound, max, min, upper_b...
+#include <cstdint>                     // for uint64_t, uint8_t
+#include <cstdio>                      // for rename, remove
+#include <iomanip>                     // for setw, setfill
 #include <map>                         // for map
 #include <set>                         // for set, __tree_const_iterator
+#include <sstream>                     // for ostringstream
 #include <string>                      // for basic_string, string, to_string
 #include <type_traits>                 // for is_copy_constructible
 #include <typeinfo>                    // for type_info
 #include <utility>                     // for pair, make_pair
+#include <vector>                      // for vector
 
 #include "sctl/common.hpp"             // for Long, Integer, SCTL_ASSERT
 #include "sctl/boundary_integral.hpp"  // for BoundaryIntegralOp, BuildNearList
@@ -18,6 +24,10 @@
 #include "sctl/iterator.txx"           // for Iterator::Iterator<ValueType>
 #include "sctl/math_utils.hpp"         // for log, sqrt
 #include "sctl/matrix.hpp"             // for Matrix
+#include "sctl/mem_mgr.hpp"            // for MemoryArena
+#include "sctl/mem_mgr.txx"            // for MemoryArena::Scope, MemoryArena::MemoryArena
+#include "sctl/metrics.hpp"            // for Metrics, Metric
+#include "sctl/metrics.txx"            // for Metrics::Record
 #include "sctl/morton.hpp"             // for Morton
 #include "sctl/ompUtils.txx"           // for scan, merge_sort
 #include "sctl/profile.hpp"            // for Profile
@@ -43,6 +53,69 @@ namespace sctl {
     }
   }
 
+  static uint64_t fnv1a_hash(const void* ptr, Long bytes, uint64_t hash = 14695981039346656037ULL) {
+    const uint8_t* p = (const uint8_t*)ptr;
+    for (Long i = 0; i < bytes; i++) hash = (hash ^ p[i]) * 1099511628211ULL;
+    return hash;
+  }
+  template <class T> static uint64_t fnv1a_hash(const Vector<T>& v, uint64_t hash) {
+    return (v.Dim() ? fnv1a_hash(&v[0], v.Dim() * (Long)sizeof(T), hash) : hash);
+  }
+
+  static bool setup_cache_align(FILE* f, bool write) { // pad (or skip when reading) to the next 64-byte boundary
+    constexpr long align = 64;
+    const long pos = ftell(f);
+    if (pos < 0) return false;
+    const long pad = (align - pos % align) % align;
+    if (!write) return !fseek(f, pad, SEEK_CUR);
+    static const char zeros[align] = {};
+    return fwrite(zeros, 1, pad, f) == (size_t)pad;
+  }
+  template <class T> static bool setup_cache_write(FILE* f, const Vector<T>& v) {
+    const Long N = v.Dim();
+    if (fwrite(&N, sizeof(Long), 1, f) != 1 || !setup_cache_align(f, true)) return false;
+    if (N && fwrite(&v[0], sizeof(T), N, f) != (size_t)N) return false;
+    return setup_cache_align(f, true);
+  }
+  template <class T> static bool setup_cache_read(FILE* f, Vector<T>& v, const Long max_bytes) {
+    Long N;
+    if (fread(&N, sizeof(Long), 1, f) != 1 || N < 0 || N > max_bytes / (Long)sizeof(T) || !setup_cache_align(f, false)) return false;
+    v.ReInit(N);
+    if (N && fread(&v[0], sizeof(T), N, f) != (size_t)N) return false;
+    return setup_cache_align(f, false);
+  }
+  template <class T> static bool setup_cache_write(FILE* f, const Vector<Matrix<T>>& M) {
+    Vector<Long> dim(2*M.Dim());
+    for (Long i = 0; i < M.Dim(); i++) {
+      dim[i*2+0] = M[i].Dim(0);
+      dim[i*2+1] = M[i].Dim(1);
+    }
+    if (!setup_cache_write(f, dim)) return false;
+    for (const auto& M_ : M) { // data of all matrices in one contiguous block
+      const Long N = M_.Dim(0) * M_.Dim(1);
+      if (N && fwrite(&M_[0][0], sizeof(T), N, f) != (size_t)N) return false;
+    }
+    return setup_cache_align(f, true);
+  }
+  template <class T> static bool setup_cache_read(FILE* f, Vector<Matrix<T>>& M, const Long max_bytes) {
+    Vector<Long> dim;
+    if (!setup_cache_read(f, dim, max_bytes) || dim.Dim() % 2) return false;
+    Long total = 0;
+    for (Long i = 0; i < dim.Dim()/2; i++) {
+      if (dim[i*2+0] < 0 || dim[i*2+1] < 0) return false;
+      if (dim[i*2+1] && dim[i*2+0] > max_bytes / (Long)sizeof(T) / dim[i*2+1]) return false;
+      total += dim[i*2+0] * dim[i*2+1];
+      if (total > max_bytes / (Long)sizeof(T)) return false;
+    }
+    M.ReInit(dim.Dim()/2);
+    for (Long i = 0; i < M.Dim(); i++) {
+      const Long N = dim[i*2+0] * dim[i*2+1];
+      M[i].ReInit(dim[i*2+0], dim[i*2+1]);
+      if (N && fread(&M[i][0][0], sizeof(T), N, f) != (size_t)N) return false;
+    }
+    return setup_cache_align(f, false);
+  }
+
   template <class Real, Integer COORD_DIM> void BuildNearList(Vector<Real>& Xtrg_near, Vector<Real>& Xn_trg_near, Vector<Long>& near_elem_cnt, Vector<Long>& near_elem_dsp, Vector<Long>& near_scatter_index, Vector<Long>& near_trg_cnt, Vector<Long>& near_trg_dsp, const Vector<Real>& Xtrg, const Vector<Real>& Xn_trg, const Vector<Real>& Xsrc, const Vector<Real>& src_radius, const Vector<Long>& src_elem_nds_cnt, const Vector<Long>& src_elem_nds_dsp, const Comm& comm) {
     // Input: Xtrg, Xn_trg, Xsrc, src_radius, src_elem_nds_cnt, src_elem_nds_dsp, comm
     // Output: Xtrg_near, Xn_trg_near, near_elem_cnt, near_elem_dsp, near_scatter_index, near_trg_cnt, near_trg_dsp
@@ -145,6 +218,7 @@ namespace sctl {
         BBlen_inv /= 1.1;
       }
 
+      #pragma omp parallel for schedule(static)
       for (Long i = 0; i < Ntrg; i++) { // Set trg_nodes
         StaticArray<Real,COORD_DIM> Xmid;
         trg_nodes[i].idx = trg_offset + i;
@@ -158,6 +232,7 @@ namespace sctl {
         trg_nodes[i].elem_idx = 0;
         trg_nodes[i].pid = rank;
       }
+      #pragma omp parallel for schedule(static)
       for (Long i = 0; i < Nsrc; i++) { // Set src_nodes
         Integer depth = (Integer)(log(src_radius[i]*BBlen_inv+machine_eps<Real>())/log(0.5));
         depth = std::min(Morton<COORD_DIM>::MaxDepth(), std::max<Integer>(depth,0));
@@ -171,6 +246,7 @@ namespace sctl {
         src_nodes[i].mid = Morton<COORD_DIM>((ConstIterator<Real>)Xmid, depth);
         src_nodes[i].pid = rank;
       }
+      #pragma omp parallel for schedule(static)
       for (Long i = 0; i < Nelem; i++) { // Set src_nodes.elem_idx
         for (Long j = 0; j < src_elem_nds_cnt[i]; j++) {
           src_nodes[src_elem_nds_dsp[i]+j].elem_idx = elem_offset + i;
@@ -201,28 +277,38 @@ namespace sctl {
 
     Vector<NodeData> src_nodes1;
     if (1) { // Set src_nodes1 <- src_nodes0 + halo
+      const auto proc_split_srch = [&splitter_nodes,&comp_node_mid](const Morton<COORD_DIM>& m) {
+        NodeData srch_node; srch_node.mid = m;
+        return  std::upper_bound(splitter_nodes.begin(), splitter_nodes.end(), srch_node, comp_node_mid) - splitter_nodes.begin() - 1;
+      };
       Vector<std::pair<Long,Long>> proc_srcidx_lst;
-      std::set<Long> user_proc_set; // tmp
-      Vector<Morton<COORD_DIM>> nbr_lst; // tmp
-      for (Long i = 0; i < src_nodes0.Dim(); i++) {
-        user_proc_set.clear();
-        src_nodes0[i].mid.NbrList(nbr_lst, src_nodes0[i].mid.Depth(), false);
-        for (const auto nbr : nbr_lst) if (nbr.Depth() >= 0) {
-          const auto proc_split_srch = [&splitter_nodes,&comp_node_mid](const Morton<COORD_DIM>& m) {
-            NodeData srch_node; srch_node.mid = m;
-            return  std::upper_bound(splitter_nodes.begin(), splitter_nodes.end(), srch_node, comp_node_mid) - splitter_nodes.begin() - 1;
-          };
-          Long p0 = proc_split_srch(nbr);
-          Long p1 = proc_split_srch(nbr.Next());
-          if (p1 < comm_.Size() && splitter_nodes[p1].mid < nbr.Next()) p1++;
-          for (Long k = p0; k < p1; k++) {
-            if (k != rank) user_proc_set.insert(k);
+      Vector<Vector<std::pair<Long,Long>>> proc_srcidx_lst_(omp_get_max_threads());
+      #pragma omp parallel
+      { // Set proc_srcidx_lst
+        const Integer tid = omp_get_thread_num();
+        const Integer omp_p = omp_get_num_threads();
+        const Long i0 = src_nodes0.Dim()*(tid+0)/omp_p;
+        const Long i1 = src_nodes0.Dim()*(tid+1)/omp_p;
+
+        std::set<Long> user_proc_set; // tmp
+        Vector<Morton<COORD_DIM>> nbr_lst; // tmp
+        for (Long i = i0; i < i1; i++) {
+          user_proc_set.clear();
+          src_nodes0[i].mid.NbrList(nbr_lst, src_nodes0[i].mid.Depth(), false);
+          for (const auto nbr : nbr_lst) if (nbr.Depth() >= 0) {
+            Long p0 = proc_split_srch(nbr);
+            Long p1 = proc_split_srch(nbr.Next());
+            if (p1 < comm_.Size() && splitter_nodes[p1].mid < nbr.Next()) p1++;
+            for (Long k = p0; k < p1; k++) {
+              if (k != rank) user_proc_set.insert(k);
+            }
+          }
+          for (const auto& p : user_proc_set) {
+            proc_srcidx_lst_[tid].PushBack(std::make_pair(p, i));
           }
-        }
-        for (const auto& p : user_proc_set) {
-          proc_srcidx_lst.PushBack(std::make_pair(p, i));
         }
       }
+      concat_vecs(proc_srcidx_lst, proc_srcidx_lst_);
       omp_par::merge_sort(proc_srcidx_lst.begin(), proc_srcidx_lst.end());
 
       Vector<Long> scnt(np), sdsp(np); scnt = 0; sdsp = 0;
@@ -271,105 +357,113 @@ namespace sctl {
       };
       omp_par::merge_sort(src_nodes1.begin(), src_nodes1.end(), comp_elem_idx_mid);
 
-      // Preallocate memory // TODO: parallelize
-      Vector<Morton<COORD_DIM>> src_mid_lst, trg_mid_lst, nbr_lst;
-      Vector<std::pair<Long,Long>> trg_src_near_mid;
-      std::set<Morton<COORD_DIM>> trg_mid_set;
-      Vector<Long> src_range, trg_range;
-
-      Long eid0 = src_nodes1[0].elem_idx;
-      Long eid1 = src_nodes1[src_nodes1.Dim()-1].elem_idx + 1;
-      for (Long eid = eid0; eid < eid1; eid++) { // loop over all elements
-        Long src_idx0, src_idx1;
-        { // Set (src_idx0, src_idx1) the index range of nodes with elem_idx eid
-          NodeData srch_node;
-          srch_node.elem_idx = eid;
-          src_idx0 = std::lower_bound(src_nodes1.begin(), src_nodes1.end(), srch_node, [](const NodeData& A, const NodeData& B){return A.elem_idx<B.elem_idx;}) - src_nodes1.begin();
-          src_idx1 = std::upper_bound(src_nodes1.begin(), src_nodes1.end(), srch_node, [](const NodeData& A, const NodeData& B){return A.elem_idx<B.elem_idx;}) - src_nodes1.begin();
-        }
-        { // build near-list for element eid
-          trg_src_near_mid.ReInit(0); // list of neighbor pairs from (trg_mid_lst x src_mid_lst), sorted by trg-mid first and then src-mid
-          src_mid_lst.ReInit(0); // unique covering nodes of element-eid
-          trg_mid_lst.ReInit(0); // unique neighbor nodes of src_mid_lst
-          src_range.ReInit(0); // range of src-spheres (src_nodes1) contained in each src_mid_lst
-          trg_range.ReInit(0); // range of trg-points (trg_nodes0) contained in each trg_mid_lst
-          trg_mid_set.clear(); // tmp
-          { // build src_mid_lst, src_range
-            Long src_idx = src_idx0;
-            while (src_idx < src_idx1) {
-              NodeData nxt_node;
-              nxt_node.mid = src_nodes1[src_idx].mid.Next();
-              Long src_idx_new = std::lower_bound(src_nodes1.begin()+src_idx, src_nodes1.begin()+src_idx1, nxt_node, comp_node_mid) - src_nodes1.begin();
-              src_mid_lst.PushBack(src_nodes1[src_idx].mid);
-              src_range.PushBack(src_idx    );
-              src_range.PushBack(src_idx_new);
-              src_idx = src_idx_new;
-            }
+      const Long eid0 = src_nodes1[0].elem_idx;
+      const Long eid1 = src_nodes1[src_nodes1.Dim()-1].elem_idx + 1;
+      Vector<Vector<NodeData>> near_lst_(omp_get_max_threads());
+      #pragma omp parallel
+      { // each thread builds the near-list for a subset of elements
+        const Integer tid = omp_get_thread_num();
+
+        // Preallocate memory
+        Vector<Morton<COORD_DIM>> src_mid_lst, trg_mid_lst, nbr_lst;
+        Vector<std::pair<Long,Long>> trg_src_near_mid;
+        std::set<Morton<COORD_DIM>> trg_mid_set;
+        Vector<Long> src_range, trg_range;
+
+        #pragma omp for schedule(dynamic,16)
+        for (Long eid = eid0; eid < eid1; eid++) { // loop over all elements
+          Long src_idx0, src_idx1;
+          { // Set (src_idx0, src_idx1) the index range of nodes with elem_idx eid
+            NodeData srch_node;
+            srch_node.elem_idx = eid;
+            src_idx0 = std::lower_bound(src_nodes1.begin(), src_nodes1.end(), srch_node, [](const NodeData& A, const NodeData& B){return A.elem_idx<B.elem_idx;}) - src_nodes1.begin();
+            src_idx1 = std::upper_bound(src_nodes1.begin(), src_nodes1.end(), srch_node, [](const NodeData& A, const NodeData& B){return A.elem_idx<B.elem_idx;}) - src_nodes1.begin();
           }
-          { // build trg_mid_lst, trg_range
-            Morton<COORD_DIM> nxt_node;
-            for (const auto& src_mid : src_mid_lst) {
-              src_mid.NbrList(nbr_lst, src_mid.Depth(), false);
-              for (const auto& mid : nbr_lst) if (mid.Depth() >= 0) {
-                trg_mid_set.insert(mid);
+          { // build near-list for element eid
+            trg_src_near_mid.ReInit(0); // list of neighbor pairs from (trg_mid_lst x src_mid_lst), sorted by trg-mid first and then src-mid
+            src_mid_lst.ReInit(0); // unique covering nodes of element-eid
+            trg_mid_lst.ReInit(0); // unique neighbor nodes of src_mid_lst
+            src_range.ReInit(0); // range of src-spheres (src_nodes1) contained in each src_mid_lst
+            trg_range.ReInit(0); // range of trg-points (trg_nodes0) contained in each trg_mid_lst
+            trg_mid_set.clear(); // tmp
+            { // build src_mid_lst, src_range
+              Long src_idx = src_idx0;
+              while (src_idx < src_idx1) {
+                NodeData nxt_node;
+                nxt_node.mid = src_nodes1[src_idx].mid.Next();
+                Long src_idx_new = std::lower_bound(src_nodes1.begin()+src_idx, src_nodes1.begin()+src_idx1, nxt_node, comp_node_mid) - src_nodes1.begin();
+                src_mid_lst.PushBack(src_nodes1[src_idx].mid);
+                src_range.PushBack(src_idx    );
+                src_range.PushBack(src_idx_new);
+                src_idx = src_idx_new;
               }
             }
-            for (const auto& trg_mid : trg_mid_set) {
-              if (trg_mid >= nxt_node) {
-                nxt_node = trg_mid.Next();
-                NodeData node0, node1;
-                node0.mid = trg_mid;
-                node1.mid = nxt_node;
-                Long trg_range0 = std::lower_bound(trg_nodes0.begin(), trg_nodes0.end(), node0, comp_node_mid) - trg_nodes0.begin();
-                Long trg_range1 = std::lower_bound(trg_nodes0.begin(), trg_nodes0.end(), node1, comp_node_mid) - trg_nodes0.begin();
-                if (trg_range1 > trg_range0) {
-                  trg_range.PushBack(trg_range0);
-                  trg_range.PushBack(trg_range1);
-                  trg_mid_lst.PushBack(trg_mid);
+            { // build trg_mid_lst, trg_range
+              Morton<COORD_DIM> nxt_node;
+              for (const auto& src_mid : src_mid_lst) {
+                src_mid.NbrList(nbr_lst, src_mid.Depth(), false);
+                for (const auto& mid : nbr_lst) if (mid.Depth() >= 0) {
+                  trg_mid_set.insert(mid);
+                }
+              }
+              for (const auto& trg_mid : trg_mid_set) {
+                if (trg_mid >= nxt_node) {
+                  nxt_node = trg_mid.Next();
+                  NodeData node0, node1;
+                  node0.mid = trg_mid;
+                  node1.mid = nxt_node;
+                  Long trg_range0 = std::lower_bound(trg_nodes0.begin(), trg_nodes0.end(), node0, comp_node_mid) - trg_nodes0.begin();
+                  Long trg_range1 = std::lower_bound(trg_nodes0.begin(), trg_nodes0.end(), node1, comp_node_mid) - trg_nodes0.begin();
+                  if (trg_range1 > trg_range0) {
+                    trg_range.PushBack(trg_range0);
+                    trg_range.PushBack(trg_range1);
+                    trg_mid_lst.PushBack(trg_mid);
+                  }
                 }
               }
             }
-          }
-          { // build interaction list trg_src_near_mid
-            for (Long i = 0; i < src_mid_lst.Dim(); i++) {
-              src_mid_lst[i].NbrList(nbr_lst, src_mid_lst[i].Depth(), false);
-              for (const auto& mid : nbr_lst) if (mid.Depth() >= 0) {
-                Long j = std::upper_bound(trg_mid_lst.begin(), trg_mid_lst.end(), mid) - trg_mid_lst.begin() - 1;
-                if (j>=0 && mid.Ancestor(trg_mid_lst[j].Depth()) == trg_mid_lst[j]) {
-                  trg_src_near_mid.PushBack(std::pair<Long,Long>(j,i));
+            { // build interaction list trg_src_near_mid
+              for (Long i = 0; i < src_mid_lst.Dim(); i++) {
+                src_mid_lst[i].NbrList(nbr_lst, src_mid_lst[i].Depth(), false);
+                for (const auto& mid : nbr_lst) if (mid.Depth() >= 0) {
+                  Long j = std::upper_bound(trg_mid_lst.begin(), trg_mid_lst.end(), mid) - trg_mid_lst.begin() - 1;
+                  if (j>=0 && mid.Ancestor(trg_mid_lst[j].Depth()) == trg_mid_lst[j]) {
+                    trg_src_near_mid.PushBack(std::pair<Long,Long>(j,i));
+                  }
                 }
               }
+              std::sort(trg_src_near_mid.begin(), trg_src_near_mid.end());
             }
-            std::sort(trg_src_near_mid.begin(), trg_src_near_mid.end());
-          }
-          { // build near_lst
-            for (Long i = 0; i < trg_mid_lst.Dim(); i++) { // loop over trg_mid
-              Long j0 = std::lower_bound(trg_src_near_mid.begin(), trg_src_near_mid.end(), std::pair<Long,Long>(i+0,0)) - trg_src_near_mid.begin();
-              Long j1 = std::lower_bound(trg_src_near_mid.begin(), trg_src_near_mid.end(), std::pair<Long,Long>(i+1,0)) - trg_src_near_mid.begin();
-              for (Long ii = trg_range[2*i+0]; ii < trg_range[2*i+1]; ii++) { // loop over trg_nodes0
-                const NodeData& trg_node = trg_nodes0[ii];
-                bool is_near = false;
-                for (Long j = j0; j < j1; j++) { // loop over near src_mid
-                  Long jj = trg_src_near_mid[j].second;
-                  if (j==j0 || trg_src_near_mid[j-1].second!=jj) {
-                    for (Long jjj = src_range[jj*2+0]; jjj < src_range[jj*2+1]; jjj++) { // loop over src_nodes1
-                      const NodeData& src_node = src_nodes1[jjj];
-                      is_near = (node_dist2(src_node,trg_node) < src_node.rad*src_node.rad);
-                      if (is_near) break;
+            { // build near_lst
+              for (Long i = 0; i < trg_mid_lst.Dim(); i++) { // loop over trg_mid
+                Long j0 = std::lower_bound(trg_src_near_mid.begin(), trg_src_near_mid.end(), std::pair<Long,Long>(i+0,0)) - trg_src_near_mid.begin();
+                Long j1 = std::lower_bound(trg_src_near_mid.begin(), trg_src_near_mid.end(), std::pair<Long,Long>(i+1,0)) - trg_src_near_mid.begin();
+                for (Long ii = trg_range[2*i+0]; ii < trg_range[2*i+1]; ii++) { // loop over trg_nodes0
+                  const NodeData& trg_node = trg_nodes0[ii];
+                  bool is_near = false;
+                  for (Long j = j0; j < j1; j++) { // loop over near src_mid
+                    Long jj = trg_src_near_mid[j].second;
+                    if (j==j0 || trg_src_near_mid[j-1].second!=jj) {
+                      for (Long jjj = src_range[jj*2+0]; jjj < src_range[jj*2+1]; jjj++) { // loop over src_nodes1
+                        const NodeData& src_node = src_nodes1[jjj];
+                        is_near = (node_dist2(src_node,trg_node) < src_node.rad*src_node.rad);
+                        if (is_near) break;
+                      }
                     }
+                    if (is_near) break;
+                  }
+                  if (is_near) {
+                    NodeData node = trg_node;
+                    node.elem_idx = eid;
+                    near_lst_[tid].PushBack(node);
                   }
-                  if (is_near) break;
-                }
-                if (is_near) {
-                  NodeData node = trg_node;
-                  node.elem_idx = eid;
-                  near_lst.PushBack(node);
                 }
               }
             }
           }
         }
       }
+      concat_vecs(near_lst, near_lst_);
     }
     { // sort and partition by elem-ID
       Vector<NodeData> near_lst0;
@@ -535,6 +629,7 @@ namespace sctl {
     if (tol == tol_) return;
     setup_far_flag = false;
     setup_self_flag = false;
+    setup_self_precond_flag = false;
     setup_near_flag = false;
     tol_ = tol;
     fmm.SetAccuracy((Integer)(log(tol_)/log(0.1))+1);
@@ -544,6 +639,36 @@ namespace sctl {
     return tol_;
   }
 
+  template <class Real, class Kernel> void BoundaryIntegralOp<Real,Kernel>::SetNearCompression(NearCompression near_compression) {
+    if (near_compression == near_compression_) return;
+    setup_near_flag = false;
+    near_compression_ = near_compression;
+  }
+
+  template <class Real, class Kernel> NearCompression BoundaryIntegralOp<Real,Kernel>::GetNearCompression() const {
+    return near_compression_;
+  }
+
+  template <class Real, class Kernel> void BoundaryIntegralOp<Real,Kernel>::SetNearMemoryBudget(Long max_bytes) {
+    if (max_bytes < 0) max_bytes = -1;
+    if (max_bytes == near_mem_budget_) return;
+    setup_near_flag = false;
+    near_mem_budget_ = max_bytes;
+  }
+
+  template <class Real, class Kernel> Long BoundaryIntegralOp<Real,Kernel>::GetNearMemoryBudget() const {
+    return near_mem_budget_;
+  }
+
+  template <class Real, class Kernel> void BoundaryIntegralOp<Real,Kernel>::SetSetupCache(const std::string& prefix, const std::string& key) {
+    setup_cache_ = prefix;
+    setup_cache_key_ = key;
+  }
+
+  template <class Real, class Kernel> const std::string& BoundaryIntegralOp<Real,Kernel>::GetSetupCache() const {
+    return setup_cache_;
+  }
+
   template <class Real, class Kernel> template <class KerS2M, class KerS2L, class KerS2T, class KerM2M, class KerM2L, class KerM2T, class KerL2L, class KerL2T> void BoundaryIntegralOp<Real,Kernel>::SetFMMKer(const KerS2M& k_s2m, const KerS2L& k_s2l, const KerS2T& k_s2t, const KerM2M& k_m2m, const KerM2L& k_m2l, const KerM2T& k_m2t, const KerL2L& k_l2l, const KerL2T& k_l2t, const typename ParticleFMM<Real,COORD_DIM>::VolPotenT m2l_vol_poten, const typename ParticleFMM<Real,COORD_DIM>::VolPotenT m2t_vol_poten) {
     fmm.DeleteSrc("Src");
     fmm.DeleteTrg("Trg");
@@ -615,8 +740,34 @@ namespace sctl {
     Profile::Tic("Setup", &comm_, true, 5);
     SetupBasic();
     SetupFar();
+
+    std::string cache_fname;
+    uint64_t cache_key = 0;
+    const bool ker_ctx = (ker_.GetCtxPtr() != nullptr && setup_cache_key_.empty()); // the kernel context is not in the key
+    if (!setup_cache_.empty() && ker_ctx) SCTL_WARN("BoundaryIntegralOp: setup cache disabled for a kernel with context and no cache key");
+    if (!setup_cache_.empty() && !ker_ctx && !(setup_self_flag && setup_near_flag)) { // Read K_self and near-interaction data from cache
+      Profile::Tic("ReadSetupCache", &comm_, true, 6);
+      cache_key = SetupCacheKey();
+      std::ostringstream fname;
+      fname << setup_cache_ << '-' << std::hex << std::setw(16) << std::setfill('0') << cache_key << std::dec << '-' << comm_.Rank() << ".bin";
+      cache_fname = fname.str();
+
+      const Integer read_flag = ReadSetupCache(cache_fname, cache_key);
+      Integer read_flag_glb = 0;
+      comm_.Allreduce(Ptr2ConstItr<Integer>(&read_flag,1), Ptr2Itr<Integer>(&read_flag_glb,1), 1, CommOp::MIN);
+      if (read_flag_glb) {
+        cache_fname.clear();
+      } else { // BuildNearList is collective, so recompute the near-interactions on all processes
+        setup_near_flag = false;
+      }
+      Profile::Toc();
+    }
+
     SetupSelf();
     SetupNear();
+    if (!cache_fname.empty() && !WriteSetupCache(cache_fname, cache_key)) {
+      SCTL_WARN("BoundaryIntegralOp: could not write setup cache file " << cache_fname);
+    }
     Profile::Toc();
   }
 
@@ -624,10 +775,21 @@ namespace sctl {
     setup_flag = false;
     setup_far_flag = false;
     setup_self_flag = false;
+    setup_self_precond_flag = false;
     setup_near_flag = false;
   }
 
   template <class Real, class Kernel> void BoundaryIntegralOp<Real,Kernel>::ComputePotential(Vector<Real>& U, const Vector<Real>& F) const {
+    const Matrix<Real> F_(1, F.Dim(), (Iterator<Real>)F.begin(), false);
+    Matrix<Real> U_;
+    ComputePotential(U_, F_);
+
+    const Long N = U_.Dim(0) * U_.Dim(1);
+    if (U.Dim() != N) U.ReInit(N);
+    if (N) memcopy(U.begin(), U_.begin(), N);
+  }
+
+  template <class Real, class Kernel> void BoundaryIntegralOp<Real,Kernel>::ComputePotential(Matrix<Real>& U, const Matrix<Real>& F) const {
     Setup();
     Profile::Tic("Eval", &comm_, true, 5);
     ComputeFarField(U, F);
@@ -699,6 +861,35 @@ namespace sctl {
     }
   }
 
+  template <class Real, class Kernel> void BoundaryIntegralOp<Real,Kernel>::SelfPrecond(Vector<Real>& U, const Vector<Real>& F, const Real alpha) const {
+    const Integer KDIM1_ = (trg_normal_dot_prod_ ? KDIM1/COORD_DIM : KDIM1);
+    SCTL_ASSERT_MSG(KDIM0 == KDIM1_, "BoundaryIntegralOp::SelfPrecond requires equal source and target dimensions.");
+    SCTL_ASSERT_MSG(Xt.Dim() == 0, "BoundaryIntegralOp::SelfPrecond requires on-surface targets.");
+    Setup();
+    if (!setup_self_precond_flag || self_precond_alpha != alpha) SetupSelfPrecond(alpha);
+
+    const Long Nelem = elem_nds_cnt.Dim();
+    const Long Nsrc = (Nelem ? elem_nds_dsp[Nelem-1] + elem_nds_cnt[Nelem-1] : 0);
+    SCTL_ASSERT(F.Dim() == Nsrc * KDIM0);
+    if (U.Dim() != F.Dim()) U.ReInit(F.Dim());
+
+    const Real alpha_inv = (alpha != 0 ? 1/alpha : (Real)1);
+    #pragma omp parallel for schedule(static)
+    for (Long elem = 0; elem < Nelem; elem++) {
+      const Long N = elem_nds_cnt[elem] * KDIM0;
+      const Matrix<Real> F_(1, N, (Iterator<Real>)F.begin() + elem_nds_dsp[elem]*KDIM0, false);
+      Matrix<Real> U_(1, N, U.begin() + elem_nds_dsp[elem]*KDIM0, false);
+
+      const auto& Minv = K_self_inv[elem];
+      if (Minv.Dim(0) && Minv.Dim(1)) {
+        SCTL_ASSERT(Minv.Dim(0) == N && Minv.Dim(1) == N);
+        U_ = F_ * Minv; // F_ and U_ may overlap
+      } else {
+        for (Long i = 0; i < N; i++) U_[0][i] = F_[0][i] * alpha_inv;
+      }
+    }
+  }
+
 
 
   template <class Real, class Kernel> void BoundaryIntegralOp<Real,Kernel>::SetupBasic() const {
@@ -835,6 +1026,38 @@ namespace sctl {
     setup_self_flag = true;
   }
 
+  template <class Real, class Kernel> void BoundaryIntegralOp<Real,Kernel>::SetupSelfPrecond(const Real alpha) const {
+    const Long Nlst = elem_lst_map.size();
+    const Long Nelem = elem_nds_cnt.Dim();
+    Vector<Long> K_self_idx(Nelem); // index of each element in K_self (or -1 for matrix-free elements)
+    for (Long i = 0, offset = 0; i < Nlst; i++) {
+      const bool matrix_free = elem_lst_map.at(elem_lst_name[i])->MatrixFree();
+      for (Long j = 0; j < elem_lst_cnt[i]; j++) {
+        K_self_idx[elem_lst_dsp[i]+j] = (matrix_free ? -1 : offset+j);
+      }
+      if (!matrix_free) offset += elem_lst_cnt[i];
+    }
+
+    Profile::Tic("SetupSelfPrecond", &comm_, false, 6);
+    if (K_self_inv.Dim() != Nelem) K_self_inv.ReInit(Nelem);
+    #pragma omp parallel for schedule(dynamic)
+    for (Long elem = 0; elem < Nelem; elem++) {
+      const Long idx = K_self_idx[elem];
+      if (idx < 0 || idx >= K_self.Dim() || !K_self[idx].Dim(0) || !K_self[idx].Dim(1)) {
+        K_self_inv[elem].ReInit(0,0);
+        continue;
+      }
+      Matrix<Real> M = K_self[idx];
+      SCTL_ASSERT(M.Dim(0) == M.Dim(1));
+      for (Long i = 0; i < M.Dim(0); i++) M[i][i] += alpha;
+      K_self_inv[elem] = M.pinv(); // pseudo-inverse, robust to (nearly) singular blocks
+    }
+    Profile::Toc();
+
+    self_precond_alpha = alpha;
+    setup_self_precond_flag = true;
+  }
+
   template <class Real, class Kernel> void BoundaryIntegralOp<Real,Kernel>::SetupNear() const {
     if (setup_near_flag) return;
     Xtrg_near.ReInit(0);
@@ -846,6 +1069,10 @@ namespace sctl {
     K_near_cnt.ReInit(0);
     K_near_dsp.ReInit(0);
     K_near.ReInit(0);
+    K_near_f.ReInit(0);
+    K_near_U.ReInit(0);
+    K_near_V.ReInit(0);
+    near_onfly_elem.ReInit(0);
     SetupBasic();
     SetupFar();
     SetupSelf();
@@ -880,6 +1107,7 @@ namespace sctl {
 
       const Long Ntrg = Xtrg.Dim()/COORD_DIM;
       Vector<Real> Xtrg_(Ntrg*COORD_DIM*Ncopy), Xn_trg_;
+      #pragma omp parallel for schedule(static)
       for (Long i = 0; i < Ntrg; i++) { // Set Xtrg_
         for (Long j = 0; j < Ncopy; j++) {
           for (Long k = 0; k < COORD_DIM; k++) {
@@ -889,6 +1117,7 @@ namespace sctl {
       }
       if (Xn_trg.Dim()) { // Set Xn_trg_
         Xn_trg_.ReInit(Ntrg*COORD_DIM*Ncopy);
+        #pragma omp parallel for schedule(static)
         for (Long i = 0; i < Ntrg; i++) {
           for (Long j = 0; j < Ncopy; j++) {
             for (Long k = 0; k < COORD_DIM; k++) {
@@ -904,6 +1133,7 @@ namespace sctl {
 
       near_trg_cnt.ReInit(Ntrg);
       near_trg_dsp.ReInit(Ntrg);
+      #pragma omp parallel for schedule(static)
       for (Long i = 0; i < Ntrg; i++) {
         near_trg_cnt[i] = 0;
         for (Long j = 0; j < Ncopy; j++) {
@@ -919,6 +1149,8 @@ namespace sctl {
       const Long Nlst = elem_lst_map.size();
       const Long Nelem = near_elem_cnt.Dim();
       SCTL_ASSERT(Nelem == elem_nds_cnt.Dim());
+      const bool compress_float = (near_compression_ == NearCompression::FLOAT && sizeof(Real) > sizeof(float));
+      const bool compress_lowrank = (near_compression_ == NearCompression::LOWRANK);
       if (Nelem) { // Set K_near_cnt, K_near_dsp
         K_near_cnt.ReInit(Nelem);
         K_near_dsp.ReInit(Nelem);
@@ -933,158 +1165,92 @@ namespace sctl {
             K_near_cnt[elem_idx] = elem_nds_cnt[elem_idx]*near_elem_cnt[elem_idx];
           }
         }
+        if (near_mem_budget_ >= 0) { // precompute matrices within the memory budget, compute the rest in each evaluation
+          const Long entry_size = (compress_float ? sizeof(float) : sizeof(Real)) * KDIM0*KDIM1_; // upper bound for LOWRANK
+          Vector<Long> elem_order(Nelem);
+          for (Long i = 0; i < Nelem; i++) elem_order[i] = i;
+          std::stable_sort(elem_order.begin(), elem_order.end(), [this](const Long a, const Long b) { // fewest nodes (stored entries per near target) first
+            return elem_nds_cnt[a] < elem_nds_cnt[b];
+          });
+
+          Long mem_size = 0;
+          for (const Long elem_idx : elem_order) {
+            const Long elem_mem_size = K_near_cnt[elem_idx] * entry_size;
+            if (!elem_mem_size) continue;
+            if (mem_size + elem_mem_size <= near_mem_budget_) {
+              mem_size += elem_mem_size;
+            } else {
+              near_onfly_elem.PushBack(elem_idx);
+              K_near_cnt[elem_idx] = 0;
+            }
+          }
+          std::sort(near_onfly_elem.begin(), near_onfly_elem.end());
+        }
         omp_par::scan(K_near_cnt.begin(), K_near_dsp.begin(), Nelem);
       }
-      if (Nelem) { // Set K_near
-        K_near.ReInit((K_near_dsp[Nelem-1]+K_near_cnt[Nelem-1])*KDIM0*KDIM1_);
+
+      if (compress_float) K_near_f.ReInit(Nelem);
+      if (compress_lowrank) {
+        K_near_U.ReInit(Nelem);
+        K_near_V.ReInit(Nelem);
+      }
+
+      Vector<Real> K_near_batch; // uncompressed near-interaction matrices of the current batch of elements
+      for (Long elem0 = 0, elem1 = 0; elem0 < Nelem; elem0 = elem1) { // process elements in batches (a single batch without compression)
+        elem1 = elem0 + 1;
+        if (compress_float || compress_lowrank) { // bound the size of uncompressed matrices in each batch
+          constexpr Long max_batch_size = 1L<<24;
+          while (elem1 < Nelem && (K_near_dsp[elem1]+K_near_cnt[elem1]-K_near_dsp[elem0])*KDIM0*KDIM1_ <= max_batch_size) elem1++;
+        } else {
+          elem1 = Nelem;
+        }
+        Vector<Real>& K_near__ = (compress_float || compress_lowrank ? K_near_batch : K_near);
+        K_near__.ReInit((K_near_dsp[elem1-1]+K_near_cnt[elem1-1]-K_near_dsp[elem0])*KDIM0*KDIM1_);
+        const Long K_near_dsp0 = K_near_dsp[elem0];
 
         constexpr Long cache_line_size = 512;
-        const Long N_near = near_elem_dsp[Nelem-1] + near_elem_cnt[Nelem-1];
-        const Long omp_chunk_size = std::max(N_near/omp_get_max_threads()/32, (cache_line_size+KDIM1_-1)/KDIM1_);
+        const Long near0 = near_elem_dsp[elem0];
+        const Long near1 = near_elem_dsp[elem1-1] + near_elem_cnt[elem1-1];
+        const Long omp_chunk_size = std::max((near1-near0)/omp_get_max_threads()/32, (cache_line_size+KDIM1_-1)/KDIM1_);
+        std::vector<MemoryArena> arena_lst(omp_get_max_threads()); // scratch memory for each thread
         #pragma omp parallel for schedule(dynamic,omp_chunk_size)
-        for (Long i = 0; i < N_near; i++) { // loop over all pairs of elements and their near targets
+        for (Long i = near0; i < near1; i++) { // loop over all pairs of elements and their near targets
+          MemoryArena& arena = arena_lst[omp_get_thread_num()];
           const Long elem_idx = std::lower_bound(near_elem_dsp.begin(), near_elem_dsp.end(), i+1) - near_elem_dsp.begin() - 1;
-          const Long elem_lst_idx = std::lower_bound(elem_lst_dsp.begin(), elem_lst_dsp.end(), elem_idx+1) - elem_lst_dsp.begin() - 1;
+          if (!K_near_cnt[elem_idx]) continue; // matrix-free, or computed in each evaluation
 
-          const auto& name = elem_lst_name[elem_lst_idx];
-          const auto& elem_lst = elem_lst_map.at(name);
-          const auto& elem_data = elem_data_map.at(name);
-
-          if (!elem_lst->MatrixFree()) {
-            const Long j = elem_idx - elem_lst_dsp[elem_lst_idx]; // element index in elem_lst
-
-            const Long N0 = elem_nds_cnt[elem_idx]*KDIM0;
-            const Vector<Real> Xsurf_(elem_nds_cnt[elem_idx]*COORD_DIM, Xsurf.begin()+elem_nds_dsp[elem_idx]*COORD_DIM, false);
-            Matrix<Real> K_near_(N0,near_elem_cnt[elem_idx]*KDIM1_, K_near.begin()+K_near_dsp[elem_idx]*KDIM0*KDIM1_, false);
-
-            {
-              const Long k = i - near_elem_dsp[elem_idx]; // target index in near-list of elem_idx
-              Long min_Xt = -1, min_Xsurf = -1;
-              const Vector<Real> Xt(COORD_DIM, Xtrg_near.begin()+(near_elem_dsp[elem_idx]+k)*COORD_DIM, false);
-              const Vector<Real> Xn((trg_normal_dot_prod_ ? COORD_DIM : 0), Xn_trg_near.begin()+(near_elem_dsp[elem_idx]+k)*COORD_DIM, false);
-              auto compute_min_dist2 = [](Long& min_idx, Long& min_idy, const Vector<Real>& X, const Vector<Real>& Y) {
-                const Long Nx = X.Dim() / COORD_DIM;
-                const Long Ny = Y.Dim() / COORD_DIM;
-                Real min_r2 = -1;
-                for (Long i = 0 ; i < Nx; i++) {
-                  for (Long j = 0 ; j < Ny; j++) {
-                    Real r2 = 0;
-                    for (Long k = 0; k < COORD_DIM; k++) {
-                      Real d = X[i*COORD_DIM+k] - Y[j*COORD_DIM+k];
-                      r2 += d*d;
-                    }
-                    if (min_r2<0 || r2<min_r2) {
-                      min_idx = i;
-                      min_idy = j;
-                      min_r2 = r2;
-                    }
-                  }
-                }
-                return min_r2;
-              };
-              const Real trg_elem_dist2 = compute_min_dist2(min_Xt, min_Xsurf, Xt, Xsurf_);
-              SCTL_ASSERT(min_Xt >= 0 && min_Xsurf >= 0);
-
-              if (trg_elem_dist2 == 0) { // Set K_near_
-                if (K_self.Dim() && K_self[elem_idx].Dim(0) && K_self[elem_idx].Dim(1)) {
-                  const auto& K_near0 = K_self[elem_idx];
-                  SCTL_ASSERT(K_near0.Dim(0) == N0);
-                  for (Long l = 0; l < N0; l++) {
-                    for (Long k1 = 0; k1 < KDIM1_; k1++) {
-                      K_near_[l][k*KDIM1_+k1] = K_near0[l][min_Xsurf*KDIM1_+k1];
-                    }
-                  }
-                } else {
-                  for (Long l = 0; l < N0; l++) {
-                    for (Long k1 = 0; k1 < KDIM1_; k1++) {
-                      K_near_[l][k*KDIM1_+k1] = 0;
-                    }
-                  }
-                }
-              } else {
-                StaticArray<Real,10000> buff0;
-                Matrix<Real> K_near0(N0, KDIM1_, (N0*KDIM1_>10000?NullIterator<Real>():buff0), (N0*KDIM1_>10000));
-                elem_data.NearInterac(K_near0, Xt, Xn, ker_, tol_, j, elem_lst);
-
-                if (K_near0.Dim(0) != 0 && K_near0.Dim(1) != 0) {
-                  for (Long l = 0; l < N0; l++) {
-                    for (Long k1 = 0; k1 < KDIM1_; k1++) {
-                      K_near_[l][k*KDIM1_+k1] = K_near0[l][k1];
-                    }
-                  }
-                } else {
-                  for (Long l = 0; l < N0; l++) {
-                    for (Long k1 = 0; k1 < KDIM1_; k1++) {
-                      K_near_[l][k*KDIM1_+k1] = 0;
-                    }
-                  }
-                }
-              }
-            }
-          }
+          Matrix<Real> K_near_(elem_nds_cnt[elem_idx]*KDIM0, near_elem_cnt[elem_idx]*KDIM1_, K_near__.begin()+(K_near_dsp[elem_idx]-K_near_dsp0)*KDIM0*KDIM1_, false);
+          NearMatrixTrg(K_near_, elem_idx, i - near_elem_dsp[elem_idx], arena);
         }
-      }
 
-      for (Long i = 0; i < Nlst; i++) { // Subtract direct-interaction part from K_near
-        const auto& elem_lst = elem_lst_map.at(elem_lst_name[i]);
-        if (elem_lst->MatrixFree()) continue;
-        #pragma omp parallel for if(elem_lst_cnt[i] > omp_get_max_threads()) schedule(dynamic)
-        for (Long j = 0; j < elem_lst_cnt[i]; j++) { // subtract direct sum
-          const Long elem_idx = elem_lst_dsp[i]+j;
-          const Long trg_cnt = near_elem_cnt[elem_idx];
-          const Long trg_dsp = near_elem_dsp[elem_idx];
-          const Vector<Real> Xtrg_near_(trg_cnt*COORD_DIM, Xtrg_near.begin()+trg_dsp*COORD_DIM, false);
-          const Vector<Real> Xn_trg_near_((trg_normal_dot_prod_ ? trg_cnt*COORD_DIM : 0), Xn_trg_near.begin()+trg_dsp*COORD_DIM, false);
-          if (!trg_cnt) continue;
-
-          const Long far_src_cnt = elem_nds_cnt_far[elem_idx];
-          const Long far_src_dsp = elem_nds_dsp_far[elem_idx];
-          const Vector<Real> X (far_src_cnt*COORD_DIM,  X_far.begin() + far_src_dsp*COORD_DIM, false);
-          const Vector<Real> Xn(far_src_cnt*COORD_DIM, Xn_far.begin() + far_src_dsp*COORD_DIM, false);
-          const Vector<Real> wts(far_src_cnt, wts_far.begin() + far_src_dsp, false);
-
-          SCTL_ASSERT(K_near_cnt[elem_idx] == elem_nds_cnt[elem_idx]*trg_cnt);
-          Matrix<Real> K_near_(elem_nds_cnt[elem_idx]*KDIM0, trg_cnt*KDIM1_, K_near.begin()+K_near_dsp[elem_idx]*KDIM0*KDIM1_, false);
-          { // Set K_near_
-            Matrix<Real> Mker(far_src_cnt*KDIM0, trg_cnt*KDIM1_);
-            if (trg_normal_dot_prod_) {
-              Matrix<Real> Mker_;
-              constexpr Integer KDIM1_ = KDIM1/COORD_DIM;
-              ker_.template KernelMatrix<Real,true>(Mker_, Xtrg_near_, X, Xn);
-              #pragma omp parallel for schedule(static)
-              for (Long s = 0; s < far_src_cnt; s++) {
-                for (Long k0 = 0; k0 < KDIM0; k0++) {
-                  for (Long t = 0; t < trg_cnt; t++) {
-                    for (Long k1 = 0; k1 < KDIM1_; k1++) {
-                      Mker[s*KDIM0+k0][t*KDIM1_+k1] = 0;
-                      for (Long l = 0; l < COORD_DIM; l++) {
-                        Mker[s*KDIM0+k0][t*KDIM1_+k1] += Mker_[s*KDIM0+k0][(t*KDIM1_+k1)*COORD_DIM+l] * wts[s] * Xn_trg_near_[t*COORD_DIM+l];
-                      }
-                    }
-                  }
-                }
-              }
-            } else {
-              ker_.template KernelMatrix<Real,true>(Mker, Xtrg_near_, X, Xn);
-              #pragma omp parallel for schedule(static)
-              for (Long s = 0; s < far_src_cnt; s++) {
-                for (Long k0 = 0; k0 < KDIM0; k0++) {
-                  for (Long t = 0; t < trg_cnt*KDIM1; t++) {
-                    Mker[s*KDIM0+k0][t] *= wts[s];
-                  }
-                }
-              }
-            }
+        for (Long i = 0; i < Nlst; i++) { // Subtract direct-interaction part from K_near
+          const auto& elem_lst = elem_lst_map.at(elem_lst_name[i]);
+          if (elem_lst->MatrixFree()) continue;
+          const Long j0 = std::max<Long>(elem0, elem_lst_dsp[i]) - elem_lst_dsp[i];
+          const Long j1 = std::min<Long>(elem1, elem_lst_dsp[i]+elem_lst_cnt[i]) - elem_lst_dsp[i];
+          std::vector<MemoryArena> arena_lst(omp_get_max_threads()); // scratch memory for each thread
+          #pragma omp parallel for if(j1-j0 > omp_get_max_threads()) schedule(dynamic)
+          for (Long j = j0; j < j1; j++) { // subtract direct sum
+            MemoryArena& arena = arena_lst[omp_get_thread_num()];
+            const Long elem_idx = elem_lst_dsp[i]+j;
+            if (!K_near_cnt[elem_idx]) continue;
+            SCTL_ASSERT(K_near_cnt[elem_idx] == elem_nds_cnt[elem_idx]*near_elem_cnt[elem_idx]);
+            Matrix<Real> K_near_(elem_nds_cnt[elem_idx]*KDIM0, near_elem_cnt[elem_idx]*KDIM1_, K_near__.begin()+(K_near_dsp[elem_idx]-K_near_dsp0)*KDIM0*KDIM1_, false);
+            NearMatrixSubtractDirect(K_near_, elem_idx, arena);
+          }
+        }
 
-            Matrix<Real> K_direct;
-            elem_lst->FarFieldDensityOperatorTranspose(K_direct, Mker, j);
-            const Long N = K_near_.Dim(0)*K_near_.Dim(1);
-            if (K_direct.Dim(0) != 0 && K_direct.Dim(1) != 0) {
-              #pragma omp parallel for schedule(static)
-              for (Long k = 0; k < N; k++) K_near_[0][k] -= K_direct[0][k];
+        if (compress_float || compress_lowrank) { // Compress near-interaction matrices of the batch
+          #pragma omp parallel for schedule(dynamic)
+          for (Long elem_idx = elem0; elem_idx < elem1; elem_idx++) {
+            if (!K_near_cnt[elem_idx]) continue;
+            const Matrix<Real> K_near_(elem_nds_cnt[elem_idx]*KDIM0, near_elem_cnt[elem_idx]*KDIM1_, K_near__.begin()+(K_near_dsp[elem_idx]-K_near_dsp0)*KDIM0*KDIM1_, false);
+            if (compress_float) {
+              const Long N = K_near_.Dim(0)*K_near_.Dim(1);
+              K_near_f[elem_idx].ReInit(K_near_.Dim(0), K_near_.Dim(1));
+              for (Long k = 0; k < N; k++) K_near_f[elem_idx][0][k] = (float)K_near_[0][k];
             } else {
-              #pragma omp parallel for schedule(static)
-              for (Long k = 0; k < N; k++) K_near_[0][k] -= Mker[0][k];
+              LowRankNear(K_near_U[elem_idx], K_near_V[elem_idx], K_near_, tol_);
             }
           }
         }
@@ -1092,34 +1258,338 @@ namespace sctl {
     }
     Profile::Toc();
 
+    { // record the size of the near interactions
+      Long near_pairs = 0, near_bytes = K_near.Dim() * (Long)sizeof(Real);
+      for (Long i = 0; i < near_elem_cnt.Dim(); i++) near_pairs += near_elem_cnt[i];
+      for (Long i = 0; i < K_near_f.Dim(); i++) near_bytes += K_near_f[i].Dim(0) * K_near_f[i].Dim(1) * (Long)sizeof(float);
+      for (Long i = 0; i < K_near_U.Dim(); i++) near_bytes += (K_near_U[i].Dim(0) * K_near_U[i].Dim(1) + K_near_V[i].Dim(0) * K_near_V[i].Dim(1)) * (Long)sizeof(Real);
+      Metrics::Record(Metric::BIOP_NEAR_PAIRS, (double)near_pairs);
+      Metrics::Record(Metric::BIOP_NEAR_BYTES, (double)near_bytes);
+    }
+
     setup_near_flag = true;
   }
 
-  template <class Real, class Kernel> void BoundaryIntegralOp<Real,Kernel>::ComputeFarField(Vector<Real>& U, const Vector<Real>& F) const {
+  template <class Real, class Kernel> uint64_t BoundaryIntegralOp<Real,Kernel>::SetupCacheKey() const {
+    uint64_t hash = fnv1a_hash(nullptr, 0);
+    const std::string ker_name = typeid(Kernel).name();
+    hash = fnv1a_hash(ker_name.c_str(), (Long)ker_name.size(), hash);
+    hash = fnv1a_hash(setup_cache_key_.c_str(), (Long)setup_cache_key_.size(), hash);
+    const Long params[] = {(Long)sizeof(Real), KDIM0, KDIM1, COORD_DIM, (Long)trg_normal_dot_prod_, (Long)periodicity_, (Long)near_compression_, near_mem_budget_, comm_.Size()};
+    const Real params_real[] = {tol_, period_length_};
+    hash = fnv1a_hash(params, sizeof(params), hash);
+    hash = fnv1a_hash(params_real, sizeof(params_real), hash);
+    for (const auto& name : elem_lst_name) {
+      const Long matrix_free = elem_lst_map.at(name)->MatrixFree();
+      hash = fnv1a_hash(name.c_str(), (Long)name.size(), hash);
+      hash = fnv1a_hash(&matrix_free, sizeof(Long), hash);
+    }
+    hash = fnv1a_hash(elem_lst_cnt, hash);
+    hash = fnv1a_hash(elem_nds_cnt, hash);
+    hash = fnv1a_hash(Xsurf, hash);
+    hash = fnv1a_hash(Xn_surf, hash);
+    hash = fnv1a_hash(Xtrg, hash);
+    hash = fnv1a_hash(Xn_trg, hash);
+    hash = fnv1a_hash(elem_nds_cnt_far, hash);
+    hash = fnv1a_hash(X_far, hash);
+    hash = fnv1a_hash(wts_far, hash);
+    hash = fnv1a_hash(dist_far, hash);
+
+    Vector<uint64_t> hash_glb(comm_.Size());
+    comm_.Allgather(Ptr2ConstItr<uint64_t>(&hash,1), 1, hash_glb.begin(), 1);
+    return fnv1a_hash(&hash_glb[0], hash_glb.Dim() * (Long)sizeof(uint64_t));
+  }
+
+  template <class Real, class Kernel> bool BoundaryIntegralOp<Real,Kernel>::ReadSetupCache(const std::string& fname, const uint64_t key) const {
+    FILE* f = fopen(fname.c_str(), "rb");
+    if (!f) return false;
+
+    Long max_bytes = 0;
+    if (!fseek(f, 0, SEEK_END)) max_bytes = ftell(f);
+    bool success = !fseek(f, 0, SEEK_SET);
+
+    { // Check header
+      char magic[8];
+      uint64_t key_;
+      Vector<Long> info;
+      success = success && fread(magic, 1, 8, f) == 8 && !std::string(magic, 8).compare("SCTL-BIO");
+      success = success && fread(&key_, sizeof(uint64_t), 1, f) == 1 && key_ == key;
+      success = success && setup_cache_align(f, false) && setup_cache_read(f, info, max_bytes);
+      success = success && info.Dim() == 5 && info[0] == 1 && info[1] == (Long)sizeof(Real) && info[2] == KDIM0 && info[3] == KDIM1 && info[4] == COORD_DIM;
+    }
+    if (success) { // Read data (overwrites the current setup)
+      setup_self_flag = false;
+      setup_self_precond_flag = false;
+      setup_near_flag = false;
+      success = success && setup_cache_read(f, K_self, max_bytes);
+      success = success && setup_cache_read(f, Xtrg_near, max_bytes);
+      success = success && setup_cache_read(f, Xn_trg_near, max_bytes);
+      success = success && setup_cache_read(f, near_scatter_index, max_bytes);
+      success = success && setup_cache_read(f, near_trg_cnt, max_bytes);
+      success = success && setup_cache_read(f, near_trg_dsp, max_bytes);
+      success = success && setup_cache_read(f, near_elem_cnt, max_bytes);
+      success = success && setup_cache_read(f, near_elem_dsp, max_bytes);
+      success = success && setup_cache_read(f, K_near_cnt, max_bytes);
+      success = success && setup_cache_read(f, K_near_dsp, max_bytes);
+      success = success && setup_cache_read(f, K_near, max_bytes);
+      success = success && setup_cache_read(f, K_near_f, max_bytes);
+      success = success && setup_cache_read(f, K_near_U, max_bytes);
+      success = success && setup_cache_read(f, K_near_V, max_bytes);
+      success = success && setup_cache_read(f, near_onfly_elem, max_bytes);
+      success = success && near_elem_cnt.Dim() == elem_nds_cnt.Dim() && near_trg_cnt.Dim() == Xtrg.Dim()/COORD_DIM;
+      setup_self_flag = success;
+      setup_near_flag = success;
+    }
+    fclose(f);
+    return success;
+  }
+
+  template <class Real, class Kernel> bool BoundaryIntegralOp<Real,Kernel>::WriteSetupCache(const std::string& fname, const uint64_t key) const {
+    const std::string fname_tmp = fname + ".tmp";
+    FILE* f = fopen(fname_tmp.c_str(), "wb");
+    if (!f) return false;
+
+    const Vector<Long> info{1, (Long)sizeof(Real), KDIM0, KDIM1, COORD_DIM}; // version, ...
+    bool success = fwrite("SCTL-BIO", 1, 8, f) == 8;
+    success = success && fwrite(&key, sizeof(uint64_t), 1, f) == 1;
+    success = success && setup_cache_align(f, true) && setup_cache_write(f, info);
+    success = success && setup_cache_write(f, K_self);
+    success = success && setup_cache_write(f, Xtrg_near);
+    success = success && setup_cache_write(f, Xn_trg_near);
+    success = success && setup_cache_write(f, near_scatter_index);
+    success = success && setup_cache_write(f, near_trg_cnt);
+    success = success && setup_cache_write(f, near_trg_dsp);
+    success = success && setup_cache_write(f, near_elem_cnt);
+    success = success && setup_cache_write(f, near_elem_dsp);
+    success = success && setup_cache_write(f, K_near_cnt);
+    success = success && setup_cache_write(f, K_near_dsp);
+    success = success && setup_cache_write(f, K_near);
+    success = success && setup_cache_write(f, K_near_f);
+    success = success && setup_cache_write(f, K_near_U);
+    success = success && setup_cache_write(f, K_near_V);
+    success = success && setup_cache_write(f, near_onfly_elem);
+    success = !fclose(f) && success;
+
+    success = success && !std::rename(fname_tmp.c_str(), fname.c_str()); // replace atomically
+    if (!success) std::remove(fname_tmp.c_str());
+    return success;
+  }
+
+  template <class Real, class Kernel> void BoundaryIntegralOp<Real,Kernel>::NearMatrixTrg(Matrix<Real>& K_near_, const Long elem_idx, const Long k, MemoryArena& arena) const {
+    const Integer KDIM1_ = (trg_normal_dot_prod_ ? KDIM1/COORD_DIM : KDIM1);
+    const Long elem_lst_idx = std::lower_bound(elem_lst_dsp.begin(), elem_lst_dsp.end(), elem_idx+1) - elem_lst_dsp.begin() - 1;
+    const auto& name = elem_lst_name[elem_lst_idx];
+    const auto& elem_lst = elem_lst_map.at(name);
+    const auto& elem_data = elem_data_map.at(name);
+    const Long j = elem_idx - elem_lst_dsp[elem_lst_idx]; // element index in elem_lst
+
+    const Long N0 = elem_nds_cnt[elem_idx]*KDIM0;
+    const Vector<Real> Xsurf_(elem_nds_cnt[elem_idx]*COORD_DIM, Xsurf.begin()+elem_nds_dsp[elem_idx]*COORD_DIM, false);
+    SCTL_ASSERT(K_near_.Dim(0) == N0 && K_near_.Dim(1) == near_elem_cnt[elem_idx]*KDIM1_);
+
+    MemoryArena::Scope arena_scope(arena);
+    Long min_Xt = -1, min_Xsurf = -1;
+    const Vector<Real> Xt(COORD_DIM, Xtrg_near.begin()+(near_elem_dsp[elem_idx]+k)*COORD_DIM, false);
+    const Vector<Real> Xn((trg_normal_dot_prod_ ? COORD_DIM : 0), Xn_trg_near.begin()+(near_elem_dsp[elem_idx]+k)*COORD_DIM, false);
+    auto compute_min_dist2 = [](Long& min_idx, Long& min_idy, const Vector<Real>& X, const Vector<Real>& Y) {
+      const Long Nx = X.Dim() / COORD_DIM;
+      const Long Ny = Y.Dim() / COORD_DIM;
+      Real min_r2 = -1;
+      for (Long i = 0 ; i < Nx; i++) {
+        for (Long j = 0 ; j < Ny; j++) {
+          Real r2 = 0;
+          for (Long k = 0; k < COORD_DIM; k++) {
+            Real d = X[i*COORD_DIM+k] - Y[j*COORD_DIM+k];
+            r2 += d*d;
+          }
+          if (min_r2<0 || r2<min_r2) {
+            min_idx = i;
+            min_idy = j;
+            min_r2 = r2;
+          }
+        }
+      }
+      return min_r2;
+    };
+    const Real trg_elem_dist2 = compute_min_dist2(min_Xt, min_Xsurf, Xt, Xsurf_);
+    SCTL_ASSERT(min_Xt >= 0 && min_Xsurf >= 0);
+
+    if (trg_elem_dist2 == 0) { // Set K_near_
+      if (K_self.Dim() && K_self[elem_idx].Dim(0) && K_self[elem_idx].Dim(1)) {
+        const auto& K_near0 = K_self[elem_idx];
+        SCTL_ASSERT(K_near0.Dim(0) == N0);
+        for (Long l = 0; l < N0; l++) {
+          for (Long k1 = 0; k1 < KDIM1_; k1++) {
+            K_near_[l][k*KDIM1_+k1] = K_near0[l][min_Xsurf*KDIM1_+k1];
+          }
+        }
+      } else {
+        for (Long l = 0; l < N0; l++) {
+          for (Long k1 = 0; k1 < KDIM1_; k1++) {
+            K_near_[l][k*KDIM1_+k1] = 0;
+          }
+        }
+      }
+    } else {
+      Matrix<Real> K_near0(N0, KDIM1_, arena);
+      elem_data.NearInterac(K_near0, Xt, Xn, ker_, tol_, j, elem_lst);
+
+      if (K_near0.Dim(0) != 0 && K_near0.Dim(1) != 0) {
+        for (Long l = 0; l < N0; l++) {
+          for (Long k1 = 0; k1 < KDIM1_; k1++) {
+            K_near_[l][k*KDIM1_+k1] = K_near0[l][k1];
+          }
+        }
+      } else {
+        for (Long l = 0; l < N0; l++) {
+          for (Long k1 = 0; k1 < KDIM1_; k1++) {
+            K_near_[l][k*KDIM1_+k1] = 0;
+          }
+        }
+      }
+    }
+  }
+
+  template <class Real, class Kernel> void BoundaryIntegralOp<Real,Kernel>::NearMatrixSubtractDirect(Matrix<Real>& K_near_, const Long elem_idx, MemoryArena& arena) const {
+    const Integer KDIM1_ = (trg_normal_dot_prod_ ? KDIM1/COORD_DIM : KDIM1);
+    const Long elem_lst_idx = std::lower_bound(elem_lst_dsp.begin(), elem_lst_dsp.end(), elem_idx+1) - elem_lst_dsp.begin() - 1;
+    const auto& elem_lst = elem_lst_map.at(elem_lst_name[elem_lst_idx]);
+    const Long j = elem_idx - elem_lst_dsp[elem_lst_idx]; // element index in elem_lst
+
+    MemoryArena::Scope arena_scope(arena);
+    const Long trg_cnt = near_elem_cnt[elem_idx];
+    const Long trg_dsp = near_elem_dsp[elem_idx];
+    const Vector<Real> Xtrg_near_(trg_cnt*COORD_DIM, Xtrg_near.begin()+trg_dsp*COORD_DIM, false);
+    const Vector<Real> Xn_trg_near_((trg_normal_dot_prod_ ? trg_cnt*COORD_DIM : 0), Xn_trg_near.begin()+trg_dsp*COORD_DIM, false);
+    if (!trg_cnt) return;
+
+    const Long far_src_cnt = elem_nds_cnt_far[elem_idx];
+    const Long far_src_dsp = elem_nds_dsp_far[elem_idx];
+    const Vector<Real> X (far_src_cnt*COORD_DIM,  X_far.begin() + far_src_dsp*COORD_DIM, false);
+    const Vector<Real> Xn(far_src_cnt*COORD_DIM, Xn_far.begin() + far_src_dsp*COORD_DIM, false);
+    const Vector<Real> wts(far_src_cnt, wts_far.begin() + far_src_dsp, false);
+
+    SCTL_ASSERT(K_near_.Dim(0) == elem_nds_cnt[elem_idx]*KDIM0 && K_near_.Dim(1) == trg_cnt*KDIM1_);
+    Matrix<Real> Mker(far_src_cnt*KDIM0, trg_cnt*KDIM1_, arena);
+    if (trg_normal_dot_prod_) {
+      Matrix<Real> Mker_(0, 0, arena);
+      constexpr Integer KDIM1_ = KDIM1/COORD_DIM;
+      ker_.template KernelMatrix<Real,true>(Mker_, Xtrg_near_, X, Xn);
+      #pragma omp parallel for schedule(static)
+      for (Long s = 0; s < far_src_cnt; s++) {
+        for (Long k0 = 0; k0 < KDIM0; k0++) {
+          for (Long t = 0; t < trg_cnt; t++) {
+            for (Long k1 = 0; k1 < KDIM1_; k1++) {
+              Mker[s*KDIM0+k0][t*KDIM1_+k1] = 0;
+              for (Long l = 0; l < COORD_DIM; l++) {
+                Mker[s*KDIM0+k0][t*KDIM1_+k1] += Mker_[s*KDIM0+k0][(t*KDIM1_+k1)*COORD_DIM+l] * wts[s] * Xn_trg_near_[t*COORD_DIM+l];
+              }
+            }
+          }
+        }
+      }
+    } else {
+      ker_.template KernelMatrix<Real,true>(Mker, Xtrg_near_, X, Xn);
+      #pragma omp parallel for schedule(static)
+      for (Long s = 0; s < far_src_cnt; s++) {
+        for (Long k0 = 0; k0 < KDIM0; k0++) {
+          for (Long t = 0; t < trg_cnt*KDIM1; t++) {
+            Mker[s*KDIM0+k0][t] *= wts[s];
+          }
+        }
+      }
+    }
+
+    Matrix<Real> K_direct(0, 0, arena);
+    elem_lst->FarFieldDensityOperatorTranspose(K_direct, Mker, j);
+    const Long N = K_near_.Dim(0)*K_near_.Dim(1);
+    if (K_direct.Dim(0) != 0 && K_direct.Dim(1) != 0) {
+      #pragma omp parallel for schedule(static)
+      for (Long k = 0; k < N; k++) K_near_[0][k] -= K_direct[0][k];
+    } else {
+      #pragma omp parallel for schedule(static)
+      for (Long k = 0; k < N; k++) K_near_[0][k] -= Mker[0][k];
+    }
+  }
+
+  template <class Real, class Kernel> void BoundaryIntegralOp<Real,Kernel>::LowRankNear(Matrix<Real>& U, Matrix<Real>& V, const Matrix<Real>& K, const Real tol) {
+    const Long N0 = K.Dim(0), N1 = K.Dim(1);
+    Matrix<Real> K_ = K, U_, S_, V_;
+    K_.SVD(U_, S_, V_);
+
+    Long rank = 0;
+    const Long N = std::min(N0, N1);
+    while (rank < N && S_[rank][rank] > tol * S_[0][0]) rank++;
+    if (rank * (N0 + N1) < N0 * N1) { // K = U * V, with U <-- U_ * S_
+      U.ReInit(N0, rank);
+      V.ReInit(rank, N1);
+      for (Long i = 0; i < N0; i++) {
+        for (Long j = 0; j < rank; j++) U[i][j] = U_[i][j] * S_[j][j];
+      }
+      for (Long i = 0; i < rank; i++) {
+        for (Long j = 0; j < N1; j++) V[i][j] = V_[i][j];
+      }
+    } else { // store the dense matrix in U
+      U = K;
+      V.ReInit(0, 0);
+    }
+  }
+
+  template <class Real, class Kernel> void BoundaryIntegralOp<Real,Kernel>::ApplyNear(Matrix<Real>& U, const Matrix<Real>& F, const Long elem_idx) const {
+    const Integer KDIM1_ = (trg_normal_dot_prod_ ? KDIM1/COORD_DIM : KDIM1);
+    const Long src_dof = F.Dim(1), trg_dof = U.Dim(1);
+    if (K_near_f.Dim()) { // single precision
+      const Matrix<float>& K_near_ = K_near_f[elem_idx];
+      const Long Nd = F.Dim(0);
+      Matrix<float> F_(Nd, src_dof), U_(Nd, trg_dof); // densities are rounded like the matrix, so K_near_ is never converted
+      for (Long k = 0; k < Nd*src_dof; k++) F_[0][k] = (float)F[0][k];
+      Matrix<float>::GEMM(U_, F_, K_near_);
+      for (Long k = 0; k < Nd*trg_dof; k++) U[0][k] = (Real)U_[0][k];
+    } else if (K_near_U.Dim()) { // low-rank
+      const Matrix<Real>& K_near_U_ = K_near_U[elem_idx];
+      const Matrix<Real>& K_near_V_ = K_near_V[elem_idx];
+      if (!K_near_V_.Dim(1)) { // dense
+        Matrix<Real>::GEMM(U, F, K_near_U_);
+      } else if (!K_near_U_.Dim(1)) { // rank zero
+        U.SetZero();
+      } else {
+        Matrix<Real> FU(F.Dim(0), K_near_U_.Dim(1));
+        Matrix<Real>::GEMM(FU, F, K_near_U_);
+        Matrix<Real>::GEMM(U, FU, K_near_V_);
+      }
+    } else {
+      const Matrix<Real> K_near_(src_dof, trg_dof, K_near.begin() + K_near_dsp[elem_idx]*KDIM0*KDIM1_, false);
+      Matrix<Real>::GEMM(U, F, K_near_);
+    }
+  }
+
+  template <class Real, class Kernel> void BoundaryIntegralOp<Real,Kernel>::ComputeFarField(Matrix<Real>& U, const Matrix<Real>& F) const {
     Profile::Tic("EvalFar", &comm_, true, 6);
     const Long Nsrc = X_far.Dim()/COORD_DIM;
     const Long Ntrg = Xtrg.Dim()/COORD_DIM;
+    const Long Nd = F.Dim(0);
 
-    { // Set F_far
+    if (F_far.Dim() != Nd*Nsrc*KDIM0) F_far.ReInit(Nd*Nsrc*KDIM0);
+    for (Long d = 0; d < Nd; d++) { // Set F_far
       const Long Nlst = elem_lst_map.size();
-      if (F_far.Dim() != Nsrc*KDIM0) F_far.ReInit(Nsrc*KDIM0);
       for (Long i = 0; i < Nlst; i++) { // Init F_far
         Long elem_idx0 = elem_lst_dsp[i];
         Long elem_idx1 = elem_lst_dsp[i]+elem_lst_cnt[i];
         Long offset0 = (!elem_lst_cnt[i] ? 0 : elem_nds_dsp[elem_idx0]);
         Long offset1 = (!elem_lst_cnt[i] ? 0 : elem_nds_dsp[elem_idx1-1] + elem_nds_cnt[elem_idx1-1]);
-        const Vector<Real> F_((offset1-offset0)*KDIM0, (Iterator<Real>)F.begin() + offset0*KDIM0, false);
+        const Vector<Real> F_((offset1-offset0)*KDIM0, (Iterator<Real>)F[d] + offset0*KDIM0, false);
 
         Long offset0_far = (!elem_lst_cnt[i] ? 0 : elem_nds_dsp_far[elem_idx0]);
         Long offset1_far = (!elem_lst_cnt[i] ? 0 : elem_nds_dsp_far[elem_idx1-1] + elem_nds_cnt_far[elem_idx1-1]);
-        Vector<Real> F_far_((offset1_far-offset0_far)*KDIM0, F_far.begin() + offset0_far*KDIM0, false);
+        Iterator<Real> F_far_d = F_far.begin() + d*Nsrc*KDIM0;
+        Vector<Real> F_far_((offset1_far-offset0_far)*KDIM0, F_far_d + offset0_far*KDIM0, false);
 
         elem_lst_map.at(elem_lst_name[i])->GetFarFieldDensity(F_far_, F_);
         if (F_far_.Dim()) { // F_far <-- F_far * wts_far
           #pragma omp parallel for schedule(static)
           for (Long i = offset0_far; i < offset1_far; i++) {
             for (Long j = 0; j < KDIM0; j++) {
-              F_far[i*KDIM0+j] *= wts_far[i];
+              F_far_d[i*KDIM0+j] *= wts_far[i];
             }
           }
         } else { // F_far <-- F_ * wts_far
@@ -1127,27 +1597,29 @@ namespace sctl {
           for (Long i = offset0_far; i < offset1_far; i++) {
             const Long i_ = i - offset0_far;
             for (Long j = 0; j < KDIM0; j++) {
-              F_far[i*KDIM0+j] = F_[i_*KDIM0+j] * wts_far[i];
+              F_far_d[i*KDIM0+j] = F_[i_*KDIM0+j] * wts_far[i];
             }
           }
         }
       }
     }
-    fmm.SetSrcDensity("Src", F_far);
+    fmm.SetSrcDensity("Src", Matrix<Real>(Nd, Nsrc*KDIM0, F_far.begin(), false));
 
     const Integer KDIM1_ = (trg_normal_dot_prod_ ? KDIM1/COORD_DIM : KDIM1);
-    if (U.Dim() != Ntrg*KDIM1_) U.ReInit(Ntrg*KDIM1_);
+    if (U.Dim(0) != Nd || U.Dim(1) != Ntrg*KDIM1_) U.ReInit(Nd, Ntrg*KDIM1_);
     U.SetZero();
 
     if (trg_normal_dot_prod_) {
       constexpr Integer KDIM1_ = KDIM1/COORD_DIM;
-      Vector<Real> U_(Ntrg * KDIM1); U_.SetZero();
+      Matrix<Real> U_(Nd, Ntrg * KDIM1); U_.SetZero();
       fmm.Eval(U_, "Trg");
-      #pragma omp parallel for schedule(static)
-      for (Long i = 0; i < Ntrg; i++) {
-        for (Long k = 0; k < KDIM1_; k++) {
-          for (Long l = 0; l < COORD_DIM; l++) {
-            U[i*KDIM1_+k] += U_[(i*KDIM1_+k)*COORD_DIM+l] * Xn_trg[i*COORD_DIM+l];
+      for (Long d = 0; d < Nd; d++) {
+        #pragma omp parallel for schedule(static)
+        for (Long i = 0; i < Ntrg; i++) {
+          for (Long k = 0; k < KDIM1_; k++) {
+            for (Long l = 0; l < COORD_DIM; l++) {
+              U[d][i*KDIM1_+k] += U_[d][(i*KDIM1_+k)*COORD_DIM+l] * Xn_trg[i*COORD_DIM+l];
+            }
           }
         }
       }
@@ -1158,29 +1630,66 @@ namespace sctl {
     Profile::Toc();
   }
 
-  template <class Real, class Kernel> void BoundaryIntegralOp<Real,Kernel>::ComputeNearInterac(Vector<Real>& U, const Vector<Real>& F) const {
+  template <class Real, class Kernel> void BoundaryIntegralOp<Real,Kernel>::ComputeNearInterac(Matrix<Real>& U, const Matrix<Real>& F) const {
     const Integer KDIM1_ = (trg_normal_dot_prod_ ? KDIM1/COORD_DIM : KDIM1);
 
     Profile::Tic("EvalNear", &comm_, true, 6);
     const Long Ntrg = Xtrg.Dim()/COORD_DIM;
     const Long Nelem = near_elem_cnt.Dim();
+    const Long Nd = F.Dim(0);
     SCTL_ASSERT(Nelem == elem_nds_cnt.Dim());
-    if (U.Dim() != Ntrg*KDIM1_) {
-      U.ReInit(Ntrg*KDIM1_);
+    if (U.Dim(0) != Nd || U.Dim(1) != Ntrg*KDIM1_) {
+      U.ReInit(Nd, Ntrg*KDIM1_);
       U.SetZero();
     }
 
-    Vector<Real> U_near(Nelem ? (near_elem_dsp[Nelem-1]+near_elem_cnt[Nelem-1])*KDIM1_ : 0);
+    // near-interactions for each target, with all densities stored contiguously: U_near[near_idx][density][KDIM1_]
+    Vector<Real> U_near(Nelem ? (near_elem_dsp[Nelem-1]+near_elem_cnt[Nelem-1])*Nd*KDIM1_ : 0);
+    auto copy_matrix = [](Iterator<Real> B, Long ldb, ConstIterator<Real> A, Long lda, Long N0, Long N1) { // B[i][j] <-- A[i][j]
+      for (Long i = 0; i < N0; i++) {
+        for (Long j = 0; j < N1; j++) B[i*ldb+j] = A[i*lda+j];
+      }
+    };
     #pragma omp parallel for if(Nelem > omp_get_max_threads()) schedule(dynamic)
     for (Long elem_idx = 0; elem_idx < Nelem; elem_idx++) { // Compute near-interactions from precomputed operator matrix
       const Long src_dof = elem_nds_cnt[elem_idx]*KDIM0;
       const Long trg_dof = near_elem_cnt[elem_idx]*KDIM1_;
       if (src_dof==0 || trg_dof == 0 || K_near_cnt[elem_idx] == 0) continue;
       SCTL_ASSERT(src_dof * trg_dof == K_near_cnt[elem_idx]*KDIM0*KDIM1_);
-      const Matrix<Real> K_near_(src_dof, trg_dof, K_near.begin() + K_near_dsp[elem_idx]*KDIM0*KDIM1_, false);
-      const Matrix<Real> F_(1, src_dof, (Iterator<Real>)F.begin() + elem_nds_dsp[elem_idx]*KDIM0, false);
-      Matrix<Real> U_(1, trg_dof, U_near.begin() + near_elem_dsp[elem_idx]*KDIM1_, false);
-      Matrix<Real>::GEMM(U_, F_, K_near_);
+      if (Nd == 1) {
+        const Matrix<Real> F_(1, src_dof, (Iterator<Real>)F.begin() + elem_nds_dsp[elem_idx]*KDIM0, false);
+        Matrix<Real> U_(1, trg_dof, U_near.begin() + near_elem_dsp[elem_idx]*KDIM1_, false);
+        ApplyNear(U_, F_, elem_idx);
+      } else {
+        Matrix<Real> F_(Nd, src_dof), U_(Nd, trg_dof);
+        copy_matrix(F_.begin(), src_dof, F.begin() + elem_nds_dsp[elem_idx]*KDIM0, F.Dim(1), Nd, src_dof);
+        ApplyNear(U_, F_, elem_idx);
+        for (Long j = 0; j < near_elem_cnt[elem_idx]; j++) { // U_near <-- U_
+          copy_matrix(U_near.begin() + (near_elem_dsp[elem_idx]+j)*Nd*KDIM1_, KDIM1_, U_.begin() + j*KDIM1_, trg_dof, Nd, KDIM1_);
+        }
+      }
+    }
+
+    if (near_onfly_elem.Dim()) { // Compute near-interactions for elements without precomputed matrices (exceeding near_mem_budget_)
+      std::vector<MemoryArena> arena_lst(omp_get_max_threads()); // scratch memory for each thread
+      #pragma omp parallel for if(near_onfly_elem.Dim() > omp_get_max_threads()) schedule(dynamic)
+      for (Long i = 0; i < near_onfly_elem.Dim(); i++) {
+        MemoryArena& arena = arena_lst[omp_get_thread_num()];
+        MemoryArena::Scope arena_scope(arena);
+        const Long elem_idx = near_onfly_elem[i];
+        const Long src_dof = elem_nds_cnt[elem_idx]*KDIM0;
+        const Long trg_dof = near_elem_cnt[elem_idx]*KDIM1_;
+        Matrix<Real> K_near_(src_dof, trg_dof, arena);
+        for (Long k = 0; k < near_elem_cnt[elem_idx]; k++) NearMatrixTrg(K_near_, elem_idx, k, arena);
+        NearMatrixSubtractDirect(K_near_, elem_idx, arena);
+
+        Matrix<Real> F_(Nd, src_dof, arena), U_(Nd, trg_dof, arena);
+        copy_matrix(F_.begin(), src_dof, F.begin() + elem_nds_dsp[elem_idx]*KDIM0, F.Dim(1), Nd, src_dof);
+        Matrix<Real>::GEMM(U_, F_, K_near_);
+        for (Long j = 0; j < near_elem_cnt[elem_idx]; j++) { // U_near <-- U_
+          copy_matrix(U_near.begin() + (near_elem_dsp[elem_idx]+j)*Nd*KDIM1_, KDIM1_, U_.begin() + j*KDIM1_, trg_dof, Nd, KDIM1_);
+        }
+      }
     }
 
     for (Long i = 0; i < (Long)elem_lst_map.size(); i++) { // Compute near-interactions matrix-free (if EvalNearInterac is implemented)
@@ -1195,13 +1704,20 @@ namespace sctl {
         const Vector<Real> Xt(Ntrg*COORD_DIM, Xtrg_near.begin() + near_elem_dsp[elem_idx]*COORD_DIM, false);
         const Vector<Real> Xn(Ntrg*(trg_normal_dot_prod_ ? COORD_DIM : 0), Xn_trg_near.begin() + near_elem_dsp[elem_idx]*COORD_DIM, false);
 
-        {
-          const Long src_dof = elem_nds_cnt[elem_idx]*KDIM0;
-          const Long trg_dof = near_elem_cnt[elem_idx]*KDIM1_;
-          if (src_dof==0 || trg_dof == 0) continue;
-          const Vector<Real> F_(src_dof, (Iterator<Real>)F.begin() + elem_nds_dsp[elem_idx]*KDIM0, false);
-          Vector<Real> U_(trg_dof, U_near.begin() + near_elem_dsp[elem_idx]*KDIM1_, false);
-          elem_data.EvalNearInterac(U_, F_, Xt, Xn, ker_, tol_, elem_idx, elem_lst);
+        const Long src_dof = elem_nds_cnt[elem_idx]*KDIM0;
+        const Long trg_dof = near_elem_cnt[elem_idx]*KDIM1_;
+        if (src_dof==0 || trg_dof == 0) continue;
+        for (Long d = 0; d < Nd; d++) {
+          const Vector<Real> F_(src_dof, (Iterator<Real>)F[d] + elem_nds_dsp[elem_idx]*KDIM0, false);
+          if (Nd == 1) {
+            Vector<Real> U_(trg_dof, U_near.begin() + near_elem_dsp[elem_idx]*KDIM1_, false);
+            elem_data.EvalNearInterac(U_, F_, Xt, Xn, ker_, tol_, elem_idx, elem_lst);
+          } else {
+            Vector<Real> U_(trg_dof);
+            U_.SetZero();
+            elem_data.EvalNearInterac(U_, F_, Xt, Xn, ker_, tol_, elem_idx, elem_lst);
+            copy_matrix(U_near.begin() + (near_elem_dsp[elem_idx]*Nd+d)*KDIM1_, Nd*KDIM1_, U_.begin(), KDIM1_, Ntrg, KDIM1_);
+          }
         }
       }
     }
@@ -1210,13 +1726,15 @@ namespace sctl {
     Profile::Tic("Comm", &comm_, true, 7);
     comm_.ScatterForward(U_near, near_scatter_index);
     Profile::Toc();
-    #pragma omp parallel for // schedule(static)
-    for (Long i = 0; i < Ntrg; i++) { // Accumulate result to U
-      Long near_cnt = near_trg_cnt[i];
-      Long near_dsp = near_trg_dsp[i];
-      for (Long j = 0; j < near_cnt; j++) {
-        for (Long k = 0; k < KDIM1_; k++) {
-          U[i*KDIM1_+k] += U_near[(near_dsp+j)*KDIM1_+k];
+    for (Long d = 0; d < Nd; d++) {
+      #pragma omp parallel for // schedule(static)
+      for (Long i = 0; i < Ntrg; i++) { // Accumulate result to U
+        Long near_cnt = near_trg_cnt[i];
+        Long near_dsp = near_trg_dsp[i];
+        for (Long j = 0; j < near_cnt; j++) {
+          for (Long k = 0; k < KDIM1_; k++) {
+            U[d][i*KDIM1_+k] += U_near[((near_dsp+j)*Nd+d)*KDIM1_+k];
+          }
         }
       }
     }
@@ -1,6 +1,7 @@
 #ifndef _SCTL_BOUNDARY_QUADRATURE_HPP_
 #define _SCTL_BOUNDARY_QUADRATURE_HPP_
 
+#include <omp.h>                      // for omp_get_max_threads, omp_get_thread_num
 #include <algorithm>                  // for max, min, lower_bound, sort
 #include <atomic>                     // for atomic, memory_order, atomic_th...
 #include <functional>                 // for function
@@ -10,6 +11,7 @@
 #include <string>                     // for basic_string
 #include <tuple>                      // for make_tuple, tie
 #include <type_traits>                // for is_same
+#include <vector>                     // for vector
 
 #include "sctl/common.hpp"            // for Long, Integer, SCTL_ASSERT, SCT...
 #include "sctl/cheb_utils.hpp"        // for ChebBasis
@@ -19,9 +21,11 @@
 #include "sctl/iterator.hpp"          // for Iterator, ConstIterator
 #include "sctl/iterator.txx"          // for Iterator::Iterator<ValueType>
 #include "sctl/kernel_functions.hpp"  // for Laplace3D_DxU, Laplace3D_FxU
-#include "sctl/math_utils.hpp"        // for sqrt, fabs, const_pi, cos, sin
+#include "sctl/math_utils.hpp"        // for sqrt, fabs, const_pi, cos, sin, round
 #include "sctl/math_utils.txx"        // for pow, machine_eps
 #include "sctl/matrix.hpp"            // for Matrix
+#include "sctl/mem_mgr.hpp"           // for MemoryArena
+#include "sctl/mem_mgr.txx"           // for MemoryArena::Scope, MemoryArena::MemoryArena
 #include "sctl/morton.hpp"            // for Morton
 #include "sctl/ompUtils.txx"          // for merge_sort, scan
 #include "sctl/profile.hpp"           // for Profile
@@ -29,6 +33,8 @@
 #include "sctl/static-array.hpp"      // for StaticArray
 #include "sctl/tensor.hpp"            // for Tensor
 #include "sctl/tree.hpp"              // for Morton, Tree
+#include "sctl/vec.hpp"               // for Vec, FMA
+#include "sctl/vec.txx"               // for DefaultVecLen
 #include "sctl/vector.hpp"            // for Vector
 #include "sctl/vector.txx"            // for Vector::operator[], Vector::begin
 #include "sctl/vtudata.hpp"           // for VTUData
@@ -266,6 +272,24 @@ template <Integer COORD_DIM, class Basis> class ElemList {
 
 template <class Real> class Quadrature {
 
+    /**
+     * Near-singular corrections in block-CSR format: one row for each target (in increasing order of the global
+     * target index) which is near at least one local source element, with one block for each such element. Each block
+     * is a KDIM1 x (KDIM0 * DensityBasis::Size()) matrix stored in row-major order. The communication pattern which
+     * sends the row sums to the processes owning the targets is also precomputed so that it can be reused by each Eval.
+     */
+    struct NearSingularBSR {
+      Long block_size = 0;    ///< KDIM0 * DensityBasis::Size()
+      Integer KDIM1 = 0;
+      Vector<Long> row_ptr;   ///< blocks of row i are [row_ptr[i], row_ptr[i+1])
+      Vector<Long> col_idx;   ///< local source element index of each block
+      Vector<Real> val;       ///< block values
+
+      Vector<Long> send_cnt, send_dsp;  ///< rows sent to each process
+      Vector<Long> recv_cnt, recv_dsp;  ///< rows received from each process
+      Vector<Long> recv_index;          ///< local target index of each received row
+    };
+
     template <Integer DIM> static void DuffyQuad(Matrix<Real>& nodes, Vector<Real>& weights, const Vector<Real>& coord, Integer order, Real adapt = -1.0) {
       SCTL_ASSERT(coord.Dim() == DIM);
       constexpr Real eps = machine_eps<Real>()*16;
@@ -681,12 +705,14 @@ template <class Real> class Quadrature {
 
         PtSrc.ReInit(N);
         const Real R0inv = 1.0 / R0;
+        #pragma omp parallel for schedule(static)
         for (Long i = 0; i < N; i++) { // Set coord
           for (Integer k = 0; k < CoordDim; k++) {
             PtSrc[i].coord[k] = (X[i*CoordDim+k] - X0[k]) * R0inv;
           }
         }
         if (period_length > 0) { // Wrap-around coord
+          #pragma omp parallel for schedule(static)
           for (Long i = 0; i < N; i++) {
             auto& x = PtSrc[i].coord;
             for (Integer k = 0; k < CoordDim; k++) {
@@ -694,6 +720,7 @@ template <class Real> class Quadrature {
             }
           }
         }
+        #pragma omp parallel for schedule(static)
         for (Long i = 0; i < N; i++) { // Set radius2, mid, rank
           Integer depth = 0;
           { // Set radius2, depth
@@ -718,6 +745,7 @@ template <class Real> class Quadrature {
           PtSrc[i].mid = Morton<CoordDim>((Iterator<Real>)PtSrc[i].coord, std::min(Morton<CoordDim>::MaxDepth(),depth));
           PtSrc[i].rank = rank_offset + i;
         }
+        #pragma omp parallel for schedule(static)
         for (Long i = 0 ; i < Nelem; i++) { // Set surf_rank
           for (Long j = 0; j < Nnds; j++) {
             PtSrc[i*Nnds+j].surf_rank = surf_rank_offset + i;
@@ -740,12 +768,14 @@ template <class Real> class Quadrature {
 
         PtTrg.ReInit(N);
         const Real R0inv = 1.0 / R0;
+        #pragma omp parallel for schedule(static)
         for (Long i = 0; i < N; i++) { // Set coord
           for (Integer k = 0; k < CoordDim; k++) {
             PtTrg[i].coord[k] = (Xt[i*CoordDim+k] - X0[k]) * R0inv;
           }
         }
         if (period_length > 0) { // Wrap-around coord
+          #pragma omp parallel for schedule(static)
           for (Long i = 0; i < N; i++) {
             auto& x = PtTrg[i].coord;
             for (Integer k = 0; k < CoordDim; k++) {
@@ -753,6 +783,7 @@ template <class Real> class Quadrature {
             }
           }
         }
+        #pragma omp parallel for schedule(static)
         for (Long i = 0; i < N; i++) { // Set radius2, mid, rank
           PtTrg[i].radius2 = 0;
           PtTrg[i].mid = Morton<CoordDim>((Iterator<Real>)PtTrg[i].coord);
@@ -781,11 +812,13 @@ template <class Real> class Quadrature {
           Xall.ReInit((PtSrc.Dim()+PtTrg.Dim())*CoordDim);
           Long Nsrc = PtSrc.Dim();
           Long Ntrg = PtTrg.Dim();
+          #pragma omp parallel for schedule(static)
           for (Long i = 0; i < Nsrc; i++) {
             for (Integer k = 0; k < CoordDim; k++) {
               Xall[i*CoordDim+k] = PtSrc[i].coord[k];
             }
           }
+          #pragma omp parallel for schedule(static)
           for (Long i = 0; i < Ntrg; i++) {
             for (Integer k = 0; k < CoordDim; k++) {
               Xall[(Nsrc+i)*CoordDim+k] = PtTrg[i].coord[k];
@@ -806,6 +839,7 @@ template <class Real> class Quadrature {
         SCTL_ASSERT(N);
 
         Vector<Long> dsp(N), cnt(N);
+        #pragma omp parallel for schedule(static)
         for (Long i = 0; i < N; i++) {
           PtData m0;
           m0.mid = node_mid[i];
@@ -826,61 +860,71 @@ template <class Real> class Quadrature {
         const auto& node_mid = tree.GetNodeMID();
         const auto& node_attr = tree.GetNodeAttr();
 
-        Vector<Morton<CoordDim>> nbr_mid_tmp;
-        for (Long i = 0; i < node_mid.Dim(); i++) {
-          if (node_attr[i].Leaf && !node_attr[i].Ghost) {
-            Vector<Morton<CoordDim>> child_mid;
-            node_mid[i].Children(child_mid);
-            for (const auto& trg_mid : child_mid) {
-              Integer d0 = trg_mid.Depth();
-              Vector<PtData> Src, Trg;
-              { // Set Trg
-                PtData m0, m1;
-                m0.mid = trg_mid;
-                m1.mid = trg_mid.Next();
-                Long a = std::lower_bound(PtTrg.begin(), PtTrg.end(), m0) - PtTrg.begin();
-                Long b = std::lower_bound(PtTrg.begin(), PtTrg.end(), m1) - PtTrg.begin();
-                Trg.ReInit(b-a, PtTrg.begin()+a, false);
-                if (!Trg.Dim()) continue;
-              }
-
-              Vector<std::set<Long>> near_elem(Trg.Dim());
-              for (Integer d = 0; d <= d0; d++) {
-                trg_mid.NbrList(nbr_mid_tmp, d, period_length>0);
-                for (const auto& src_mid : nbr_mid_tmp) if (src_mid.Depth() >= 0) { // Set Src
+        Vector<Vector<Pair<Long,Long>>> pair_lst_(omp_get_max_threads());
+        #pragma omp parallel
+        { // each thread builds pair_lst_[tid] for a subset of the leaf nodes
+          const Integer tid = omp_get_thread_num();
+          Vector<Morton<CoordDim>> nbr_mid_tmp;
+          #pragma omp for schedule(dynamic)
+          for (Long i = 0; i < node_mid.Dim(); i++) {
+            if (node_attr[i].Leaf && !node_attr[i].Ghost) {
+              Vector<Morton<CoordDim>> child_mid;
+              node_mid[i].Children(child_mid);
+              for (const auto& trg_mid : child_mid) {
+                Integer d0 = trg_mid.Depth();
+                Vector<PtData> Src, Trg;
+                { // Set Trg
                   PtData m0, m1;
-                  m0.mid = src_mid;
-                  m1.mid = (d==d0 ? src_mid.Next() : src_mid.Ancestor(d+1));
-                  Long a = std::lower_bound(PtSrc.begin(), PtSrc.end(), m0) - PtSrc.begin();
-                  Long b = std::lower_bound(PtSrc.begin(), PtSrc.end(), m1) - PtSrc.begin();
-                  Src.ReInit(b-a, PtSrc.begin()+a, false);
-                  if (!Src.Dim()) continue;
-
-                  for (Long t = 0; t < Trg.Dim(); t++) { // set near_elem[t] <-- {s : dist(s,t) < radius(s)}
-                    for (Long s = 0; s < Src.Dim(); s++) {
-                      if (Trg[t].surf_rank != Src[s].surf_rank) {
-                        Real R2 = 0;
-                        for (Integer k = 0; k < CoordDim; k++) {
-                          Real dx = (Src[s].coord[k] - Trg[t].coord[k]);
-                          R2 += dx * dx;
-                        }
-                        if (R2 < Src[s].radius2) {
-                          near_elem[t].insert(Src[s].surf_rank);
+                  m0.mid = trg_mid;
+                  m1.mid = trg_mid.Next();
+                  Long a = std::lower_bound(PtTrg.begin(), PtTrg.end(), m0) - PtTrg.begin();
+                  Long b = std::lower_bound(PtTrg.begin(), PtTrg.end(), m1) - PtTrg.begin();
+                  Trg.ReInit(b-a, PtTrg.begin()+a, false);
+                  if (!Trg.Dim()) continue;
+                }
+
+                Vector<std::set<Long>> near_elem(Trg.Dim());
+                for (Integer d = 0; d <= d0; d++) {
+                  trg_mid.NbrList(nbr_mid_tmp, d, period_length>0);
+                  for (const auto& src_mid : nbr_mid_tmp) if (src_mid.Depth() >= 0) { // Set Src
+                    PtData m0, m1;
+                    m0.mid = src_mid;
+                    m1.mid = (d==d0 ? src_mid.Next() : src_mid.Ancestor(d+1));
+                    Long a = std::lower_bound(PtSrc.begin(), PtSrc.end(), m0) - PtSrc.begin();
+                    Long b = std::lower_bound(PtSrc.begin(), PtSrc.end(), m1) - PtSrc.begin();
+                    Src.ReInit(b-a, PtSrc.begin()+a, false);
+                    if (!Src.Dim()) continue;
+
+                    for (Long t = 0; t < Trg.Dim(); t++) { // set near_elem[t] <-- {s : dist(s,t) < radius(s)}
+                      for (Long s = 0; s < Src.Dim(); s++) {
+                        if (Trg[t].surf_rank != Src[s].surf_rank) {
+                          Real R2 = 0;
+                          for (Integer k = 0; k < CoordDim; k++) {
+                            Real dx = (Src[s].coord[k] - Trg[t].coord[k]);
+                            if (period_length > 0) dx -= round(dx); // nearest periodic image
+                            R2 += dx * dx;
+                          }
+                          if (R2 < Src[s].radius2) {
+                            near_elem[t].insert(Src[s].surf_rank);
+                          }
                         }
                       }
                     }
                   }
                 }
-              }
 
-              for (Long t = 0; t < Trg.Dim(); t++) { // Set pair_lst
-                for (Long elem_idx : near_elem[t]) {
-                  pair_lst.PushBack(Pair<Long,Long>(elem_idx,Trg[t].rank));
+                for (Long t = 0; t < Trg.Dim(); t++) { // Set pair_lst
+                  for (Long elem_idx : near_elem[t]) {
+                    pair_lst_[tid].PushBack(Pair<Long,Long>(elem_idx,Trg[t].rank));
+                  }
                 }
               }
             }
           }
         }
+        for (const auto& pair_lst0 : pair_lst_) { // concatenate
+          for (const auto& p : pair_lst0) pair_lst.PushBack(p);
+        }
       }
       { // Sort and repartition pair_lst
         Vector<Pair<Long,Long>> pair_lst_sorted;
@@ -978,7 +1022,7 @@ template <class Real> class Quadrature {
       }
     }
 
-    template <class DensityBasis, class ElemList, class Kernel> static void SetupNearSingular(Matrix<Real>& M_near_singular, Vector<Pair<Long,Long>>& pair_lst, const Vector<Real>& Xt_, const Vector<Long>& trg_surf, const ElemList& elem_lst, const Kernel& kernel, Integer order_singular, Integer order_direct, Real period_length, const Comm& comm) {
+    template <class DensityBasis, class ElemList, class Kernel> static void SetupNearSingular(NearSingularBSR& M_near_singular, const Vector<Real>& Xt_, const Vector<Long>& trg_surf, const ElemList& elem_lst, const Kernel& kernel, Integer order_singular, Integer order_direct, Real period_length, const Comm& comm) {
       static_assert(std::is_same<Real,typename DensityBasis::ValueType>::value, "Density basis must have the same precision as the boundary quadrature.");
       static_assert(std::is_same<Real,typename ElemList::CoordType>::value, "Surface coordinates must have the same precision as the boundary quadrature.");
       static_assert(DensityBasis::Dim() == ElemList::ElemDim(), "Density basis must have the same dimension as the surface.");
@@ -992,6 +1036,7 @@ template <class Real> class Quadrature {
       constexpr Integer KDIM1 = Kernel::TrgDim();
       const Long Nelem = elem_lst.NElem();
 
+      Vector<Pair<Long,Long>> pair_lst;
       BuildNbrList(pair_lst, Xt_, trg_surf, elem_lst, 2.5/order_direct, period_length, comm);
       const Long Ninterac = pair_lst.Dim();
 
@@ -1079,10 +1124,12 @@ template <class Real> class Quadrature {
         elem_rank_offset -= Nelem;
       }
 
-      auto& M = M_near_singular;
-      M.ReInit(Ninterac * KDIM0 * DensityBasis::Size(), KDIM1);
+      Matrix<Real> M(Ninterac * KDIM0 * DensityBasis::Size(), KDIM1);
+      std::vector<MemoryArena> arena_lst(omp_get_max_threads()); // scratch memory for each thread
       #pragma omp parallel for schedule(static)
       for (Long j = 0; j < Ninterac; j++) { // Set M (near-singular)
+        MemoryArena& arena = arena_lst[omp_get_thread_num()];
+        MemoryArena::Scope arena_scope(arena);
         const Long src_idx = pair_lst[j].first - elem_rank_offset;
 
         Real adapt = -1.0;
@@ -1110,7 +1157,7 @@ template <class Real> class Quadrature {
           }
 
           for (Integer i = 0; i < 2; i++) { // iterate
-            Matrix<Real> X_, dX_;
+            Matrix<Real> X_(0, 0, arena), dX_(0, 0, arena);
             for (Integer k = 0; k < ElemDim; k++) {
               u0(k,0) = std::min(1.0, u0(k,0));
               u0(k,0) = std::max(0.0, u0(k,0));
@@ -1139,13 +1186,13 @@ template <class Real> class Quadrature {
           }
         }
 
-        Matrix<Real> quad_nds;
-        Vector<Real> quad_wts;
+        Matrix<Real> quad_nds(0, 0, arena);
+        Vector<Real> quad_wts(0, arena);
         DuffyQuad<ElemDim>(quad_nds, quad_wts, Vector<Real>(ElemDim,u0.begin(),false), order_singular, adapt);
         const CoordEvalOpType CoordEvalOp = CoordBasis::SetupEval(quad_nds);
         Integer Nnds = quad_wts.Dim();
 
-        Vector<Real> X_, dX_, Xa_, Xn_;
+        Vector<Real> X_(0, arena), dX_(0, arena), Xa_(0, arena), Xn_(0, arena);
         { // Set X_, dX_
           const Vector<CoordBasis> X__(CoordDim, (Iterator<CoordBasis>)X.begin() + src_idx * CoordDim, false);
           const Vector<CoordBasis> dX__(CoordDim * ElemDim, (Iterator<CoordBasis>)dX.begin() + src_idx * CoordDim * ElemDim, false);
@@ -1175,7 +1222,7 @@ template <class Real> class Quadrature {
           DensityEvalOp = DensityBasis::SetupEval(quad_nds);
         }
 
-        Matrix<Real> M__(Nnds * KDIM0, KDIM1);
+        Matrix<Real> M__(Nnds * KDIM0, KDIM1, arena);
         { // Set kernel matrix M__
           const Vector<Real> X0_(CoordDim, (Iterator<Real>)Xt.begin() + j * CoordDim, false);
           kernel.template KernelMatrix<Real>(M__, X0_, X_, Xn_);
@@ -1254,107 +1301,151 @@ template <class Real> class Quadrature {
           }
         }
       }
+      SetupNearSingularBSR(M_near_singular, M, pair_lst, Nelem, Xt_.Dim() / CoordDim, KDIM0 * DensityBasis::Size(), KDIM1, comm);
     }
 
-    template <class DensityBasis> static void EvalNearSingular(Vector<Real>& U, const Vector<DensityBasis>& density, const Matrix<Real>& M, const Vector<Pair<Long,Long>>& pair_lst, Long Nelem_, Long Ntrg_, Integer KDIM0_, Integer KDIM1_, const Comm& comm) {
+    static void SetupNearSingularBSR(NearSingularBSR& bsr, const Matrix<Real>& M, const Vector<Pair<Long,Long>>& pair_lst, Long Nelem, Long Ntrg, Long block_size, Integer KDIM1, const Comm& comm) {
       const Long Ninterac = pair_lst.Dim();
-      const Integer dof = density.Dim() / Nelem_ / KDIM0_;
-      SCTL_ASSERT(density.Dim() == Nelem_ * dof * KDIM0_);
+      SCTL_ASSERT(M.Dim(0) == Ninterac * block_size && M.Dim(1) == KDIM1);
+      const Integer rank = comm.Rank();
+      const Integer np = comm.Size();
 
       Long elem_rank_offset;
       { // Set elem_rank_offset
-        comm.Scan(Ptr2ConstItr<Long>(&Nelem_,1), Ptr2Itr<Long>(&elem_rank_offset,1), 1, CommOp::SUM);
-        elem_rank_offset -= Nelem_;
+        comm.Scan(Ptr2ConstItr<Long>(&Nelem,1), Ptr2Itr<Long>(&elem_rank_offset,1), 1, CommOp::SUM);
+        elem_rank_offset -= Nelem;
       }
 
-      Vector<Real> U_loc(Ninterac*dof*KDIM1_);
-      for (Long j = 0; j < Ninterac; j++) {
-        const Long src_idx = pair_lst[j].first - elem_rank_offset;
-        const Matrix<Real> M_(KDIM0_ * DensityBasis::Size(), KDIM1_, (Iterator<Real>)M[j * KDIM0_ * DensityBasis::Size()], false);
-        Matrix<Real> U_(dof, KDIM1_, U_loc.begin() + j*dof*KDIM1_, false);
-        Matrix<Real> F_(dof, KDIM0_ * DensityBasis::Size());
-        for (Long i = 0; i < dof; i++) {
-          for (Long k = 0; k < KDIM0_; k++) {
-            for (Long l = 0; l < DensityBasis::Size(); l++) {
-              F_[i][k * DensityBasis::Size() + l] = density[(src_idx * dof + i) * KDIM0_ + k][l];
-            }
+      Vector<Long> splitter_ranks;
+      { // Set splitter_ranks
+        Vector<Long> cnt(np);
+        comm.Allgather(Ptr2ConstItr<Long>(&Ntrg,1), 1, cnt.begin(), 1);
+        scan(splitter_ranks, cnt);
+      }
+
+      Vector<Long> send_index; // global target index of each row
+      Vector<Long> pair_order; // interactions sorted by target
+      { // Set send_index, pair_order, bsr.row_ptr
+        Vector<Pair<Long,Long>> scatter_pair(Ninterac);
+        for (Long i = 0; i < Ninterac; i++) {
+          scatter_pair[i] = Pair<Long,Long>(pair_lst[i].second,i);
+        }
+        omp_par::merge_sort(scatter_pair.begin(), scatter_pair.end());
+
+        pair_order.ReInit(Ninterac);
+        bsr.row_ptr.ReInit(0);
+        for (Long i = 0; i < Ninterac; i++) {
+          if (!i || scatter_pair[i].first != scatter_pair[i-1].first) {
+            send_index.PushBack(scatter_pair[i].first);
+            bsr.row_ptr.PushBack(i);
           }
+          pair_order[i] = scatter_pair[i].second;
         }
-        Matrix<Real>::GEMM(U_, F_, M_);
+        bsr.row_ptr.PushBack(Ninterac);
       }
 
-      if (U.Dim() != Ntrg_ * dof * KDIM1_) {
-        U.ReInit(Ntrg_ * dof * KDIM1_);
-        U = 0;
+      bsr.block_size = block_size;
+      bsr.KDIM1 = KDIM1;
+      bsr.col_idx.ReInit(Ninterac);
+      bsr.val.ReInit(Ninterac * KDIM1 * block_size);
+      #pragma omp parallel for schedule(static)
+      for (Long b = 0; b < Ninterac; b++) { // Set col_idx, val (transpose of each block of M)
+        const Long j = pair_order[b];
+        bsr.col_idx[b] = pair_lst[j].first - elem_rank_offset;
+        for (Integer k1 = 0; k1 < KDIM1; k1++) {
+          for (Long k = 0; k < block_size; k++) {
+            bsr.val[(b * KDIM1 + k1) * block_size + k] = M[j * block_size + k][k1];
+          }
+        }
       }
-      { // Set U
-        Integer rank = comm.Rank();
-        Integer np = comm.Size();
 
-        Vector<Long> splitter_ranks;
-        { // Set splitter_ranks
-          Vector<Long> cnt(np);
-          comm.Allgather(Ptr2ConstItr<Long>(&Ntrg_,1), 1, cnt.begin(), 1);
-          scan(splitter_ranks, cnt);
-        }
+      bsr.send_cnt.ReInit(np);
+      bsr.send_dsp.ReInit(np);
+      for (Integer i = 0; i < np; i++) {
+        bsr.send_dsp[i] = std::lower_bound(send_index.begin(), send_index.end(), splitter_ranks[i]) - send_index.begin();
+      }
+      for (Integer i = 0; i < np-1; i++) {
+        bsr.send_cnt[i] = bsr.send_dsp[i+1] - bsr.send_dsp[i];
+      }
+      bsr.send_cnt[np-1] = send_index.Dim() - bsr.send_dsp[np-1];
+
+      bsr.recv_cnt.ReInit(np);
+      comm.Alltoall(bsr.send_cnt.begin(), 1, bsr.recv_cnt.begin(), 1);
+      scan(bsr.recv_dsp, bsr.recv_cnt);
+      bsr.recv_index.ReInit(bsr.recv_cnt[np-1] + bsr.recv_dsp[np-1]);
+      comm.Alltoallv(send_index.begin(), bsr.send_cnt.begin(), bsr.send_dsp.begin(), bsr.recv_index.begin(), bsr.recv_cnt.begin(), bsr.recv_dsp.begin());
+      for (auto& idx : bsr.recv_index) idx -= splitter_ranks[rank];
+    }
 
-        Vector<Long> scatter_index, send_index, send_cnt(np), send_dsp(np);
-        { // Set scatter_index, send_index, send_cnt, send_dsp
-          { // Set scatter_index, send_index
-            Vector<Pair<Long,Long>> scatter_pair(pair_lst.Dim());
-            for (Long i = 0; i < pair_lst.Dim(); i++) {
-              scatter_pair[i] = Pair<Long,Long>(pair_lst[i].second,i);
+    template <class DensityBasis> static void EvalNearSingular(Vector<Real>& U, const Vector<DensityBasis>& density, const NearSingularBSR& M, Long Nelem_, Long Ntrg_, Integer KDIM0_, Integer KDIM1_, const Comm& comm) {
+      static constexpr Integer VecLen = DefaultVecLen<Real>();
+      using VecType = Vec<Real,VecLen>;
+      const Integer dof = density.Dim() / Nelem_ / KDIM0_;
+      SCTL_ASSERT(density.Dim() == Nelem_ * dof * KDIM0_);
+      SCTL_ASSERT(M.row_ptr.Dim() == 0 || (M.block_size == KDIM0_ * DensityBasis::Size() && M.KDIM1 == KDIM1_));
+
+      const Long Nrows = (M.row_ptr.Dim() ? M.row_ptr.Dim() - 1 : 0);
+      const Long K = KDIM0_ * DensityBasis::Size();
+      const Long K_ = (K / VecLen) * VecLen;
+      const Long Nout = dof * KDIM1_;
+
+      Vector<Real> U_send(Nrows * Nout);
+      #pragma omp parallel
+      {
+        Vector<Real> F_(dof * K); // density of one source element
+        #pragma omp for schedule(static)
+        for (Long i = 0; i < Nrows; i++) { // block-CSR SpMV
+          Iterator<Real> U_ = U_send.begin() + i * Nout;
+          for (Long k = 0; k < Nout; k++) U_[k] = 0;
+          for (Long b = M.row_ptr[i]; b < M.row_ptr[i+1]; b++) {
+            const Long src_idx = M.col_idx[b];
+            for (Long d = 0; d < dof; d++) {
+              for (Long k = 0; k < KDIM0_; k++) {
+                const DensityBasis& f = density[(src_idx * dof + d) * KDIM0_ + k];
+                for (Long l = 0; l < DensityBasis::Size(); l++) {
+                  F_[(d * KDIM0_ + k) * DensityBasis::Size() + l] = f[l];
+                }
+              }
             }
-            omp_par::merge_sort(scatter_pair.begin(), scatter_pair.end());
 
-            send_index.ReInit(scatter_pair.Dim());
-            scatter_index.ReInit(scatter_pair.Dim());
-            for (Long i = 0; i < scatter_index.Dim(); i++) {
-              send_index[i] = scatter_pair[i].first;
-              scatter_index[i] = scatter_pair[i].second;
+            const Real* M_ = &M.val[b * KDIM1_ * K];
+            for (Long d = 0; d < dof; d++) {
+              const Real* F = &F_[d * K];
+              for (Integer k1 = 0; k1 < KDIM1_; k1++) {
+                const Real* Mk = M_ + k1 * K;
+                VecType sum = VecType::Zero();
+                for (Long k = 0; k < K_; k += VecLen) {
+                  sum = FMA(VecType::Load(F + k), VecType::Load(Mk + k), sum);
+                }
+                Real sum_ = 0;
+                for (Integer v = 0; v < VecLen; v++) sum_ += sum[v];
+                for (Long k = K_; k < K; k++) sum_ += F[k] * Mk[k];
+                U_[d * KDIM1_ + k1] += sum_;
+              }
             }
           }
-          for (Integer i = 0; i < np; i++) {
-            send_dsp[i] = std::lower_bound(send_index.begin(), send_index.end(), splitter_ranks[i]) - send_index.begin();
-          }
-          for (Integer i = 0; i < np-1; i++) {
-            send_cnt[i] = send_dsp[i+1] - send_dsp[i];
-          }
-          send_cnt[np-1] = send_index.Dim() - send_dsp[np-1];
-        }
-
-        Vector<Long> recv_index, recv_cnt(np), recv_dsp(np);
-        { // Set recv_index, recv_cnt, recv_dsp
-          comm.Alltoall(send_cnt.begin(), 1, recv_cnt.begin(), 1);
-          scan(recv_dsp, recv_cnt);
-          recv_index.ReInit(recv_cnt[np-1] + recv_dsp[np-1]);
-          comm.Alltoallv(send_index.begin(), send_cnt.begin(), send_dsp.begin(), recv_index.begin(), recv_cnt.begin(), recv_dsp.begin());
-        }
-
-        Vector<Real> U_send(scatter_index.Dim() * dof * KDIM1_);
-        for (Long i = 0; i < scatter_index.Dim(); i++) {
-          Long idx = scatter_index[i]*dof*KDIM1_;
-          for (Long k = 0; k < dof * KDIM1_; k++) {
-            U_send[i*dof*KDIM1_ + k] = U_loc[idx + k];
-          }
         }
+      }
 
-        Vector<Real> U_recv(recv_index.Dim() * dof * KDIM1_);
-        { // Set U_recv
-          for (Long i = 0; i < np; i++) {
-            send_cnt[i] *= dof * KDIM1_;
-            send_dsp[i] *= dof * KDIM1_;
-            recv_cnt[i] *= dof * KDIM1_;
-            recv_dsp[i] *= dof * KDIM1_;
-          }
-          comm.Alltoallv(U_send.begin(), send_cnt.begin(), send_dsp.begin(), U_recv.begin(), recv_cnt.begin(), recv_dsp.begin());
-        }
+      Vector<Real> U_recv(M.recv_index.Dim() * Nout);
+      { // Set U_recv
+        const Integer np = comm.Size();
+        Vector<Long> send_cnt(np), send_dsp(np), recv_cnt(np), recv_dsp(np);
+        for (Integer i = 0; i < np; i++) {
+          send_cnt[i] = M.send_cnt[i] * Nout;
+          send_dsp[i] = M.send_dsp[i] * Nout;
+          recv_cnt[i] = M.recv_cnt[i] * Nout;
+          recv_dsp[i] = M.recv_dsp[i] * Nout;
+        }
+        comm.Alltoallv(U_send.begin(), send_cnt.begin(), send_dsp.begin(), U_recv.begin(), recv_cnt.begin(), recv_dsp.begin());
+      }
 
-        for (Long i = 0; i < recv_index.Dim(); i++) { // Set U
-          Long idx = (recv_index[i] - splitter_ranks[rank]) * dof * KDIM1_;
-          for (Integer k = 0; k < dof * KDIM1_; k++) {
-            U[idx + k] += U_recv[i*dof*KDIM1_ + k];
-          }
+      if (U.Dim() != Ntrg_ * Nout) U.ReInit(Ntrg_ * Nout);
+      U = 0;
+      for (Long i = 0; i < M.recv_index.Dim(); i++) { // Set U
+        const Long idx = M.recv_index[i] * Nout;
+        for (Long k = 0; k < Nout; k++) {
+          U[idx + k] += U_recv[i * Nout + k];
         }
       }
     }
@@ -1455,7 +1546,7 @@ template <class Real> class Quadrature {
       M_singular.ReInit(0,0);
 
       Profile::Tic("SetupNearSingular", &comm_);
-      SetupNearSingular<DensityBasis>(M_near_singular, pair_lst, Xt_, Vector<Long>(), elem_lst, kernel, order_singular, order_direct_, period_length_, comm_);
+      SetupNearSingular<DensityBasis>(M_near_singular, Xt_, Vector<Long>(), elem_lst, kernel, order_singular, order_direct_, period_length_, comm_);
       Profile::Toc();
 
       Profile::Toc();
@@ -1502,7 +1593,7 @@ template <class Real> class Quadrature {
       Profile::Toc();
 
       Profile::Tic("SetupNearSingular", &comm_);
-      SetupNearSingular<DensityBasis>(M_near_singular, pair_lst, Xt_, trg_surf, elem_lst, kernel, order_singular, order_direct_, period_length_, comm_);
+      SetupNearSingular<DensityBasis>(M_near_singular, Xt_, trg_surf, elem_lst, kernel, order_singular, order_direct_, period_length_, comm_);
       Profile::Toc();
 
       Profile::Toc();
@@ -1522,7 +1613,7 @@ template <class Real> class Quadrature {
       Profile::Toc();
 
       Profile::Tic("EvalNearSingular", &comm_);
-      EvalNearSingular(U_near_sing, F, M_near_singular, pair_lst, elements.NElem(), Xt_.Dim() / ElemList::CoordDim(), kernel.SrcDim(), kernel.TrgDim(), comm_);
+      EvalNearSingular(U_near_sing, F, M_near_singular, elements.NElem(), Xt_.Dim() / ElemList::CoordDim(), kernel.SrcDim(), kernel.TrgDim(), comm_);
       SCTL_ASSERT(U_near_sing.Dim() == U_direct.Dim());
       Profile::Toc();
 
@@ -1558,7 +1649,7 @@ template <class Real> class Quadrature {
       Profile::Toc();
 
       Profile::Tic("EvalNearSingular", &comm_);
-      EvalNearSingular(U_near_sing, F, M_near_singular, pair_lst, elements.NElem(), Xt_.Dim() / ElemList::CoordDim(), kernel.SrcDim(), kernel.TrgDim(), comm_);
+      EvalNearSingular(U_near_sing, F, M_near_singular, elements.NElem(), Xt_.Dim() / ElemList::CoordDim(), kernel.SrcDim(), kernel.TrgDim(), comm_);
       SCTL_ASSERT(U_near_sing.Dim() == U_direct.Dim());
       Profile::Toc();
 
@@ -1799,8 +1890,7 @@ template <class Real> class Quadrature {
 
     Vector<Real> Xt_;
     Matrix<Real> M_singular;
-    Matrix<Real> M_near_singular;
-    Vector<Pair<Long,Long>> pair_lst;
+    NearSingularBSR M_near_singular;
     Integer order_direct_;
 
     Real period_length_;
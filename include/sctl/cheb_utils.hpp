@@ -2,10 +2,14 @@
 #define _SCTL_CHEB_UTILS_HPP_
 
 #include <algorithm>              // for max, sort
+#include <atomic>                 // for atomic, memory_order
 #include <cassert>                // for assert
 #include <functional>             // for function
+#include <memory>                 // for unique_ptr
 
 #include "sctl/common.hpp"        // for Integer, Long, SCTL_ASSERT, SCTL_NA...
+#include "sctl/fft_wrapper.hpp"   // for FFT, FFT_Type
+#include "sctl/fft_wrapper.txx"   // for FFT::Setup, FFT::Execute
 #include "sctl/iterator.hpp"      // for ConstIterator, Iterator
 #include "sctl/math_utils.hpp"    // for fabs, const_pi, cos
 #include "sctl/math_utils.txx"    // for pow, machine_eps
@@ -49,28 +53,12 @@ template <class ValueType, class Derived> class BasisInterface {
   }
 
   /**
-   * Computes approximation from function values at node points.
+   * Computes approximation from function values at node points. The values on many cells can be transformed in a
+   * single (batched) call by stacking them along dof.
    * \param[in] fn_v Function values at node points (dof x order^DIM).
    * \param[out] coeff Coefficient values (dof x Ncoeff).
    */
   template <Integer DIM> static void Approx(Integer order, const Vector<ValueType>& fn_v, Vector<ValueType>& coeff) {
-    Matrix<ValueType> Mp;
-    {  // Precompute
-      static Vector<Matrix<ValueType>> precomp(1000);
-      SCTL_ASSERT(order < precomp.Dim());
-      if (precomp[order].Dim(0) * precomp[order].Dim(1) == 0) {
-        #pragma omp critical(SCTL_BASIS_APPROX)
-        if (precomp[order].Dim(0) * precomp[order].Dim(1) == 0) {
-          Vector<ValueType> x, p;
-          Derived::Nodes1D(order, x);
-          Derived::EvalBasis1D(order, x, p);
-          Matrix<ValueType> Mp1(order, order, p.begin(), false);
-          Mp1.pinv(machine_eps<ValueType>()).Swap(precomp[order]);
-        }
-      }
-      Mp.ReInit(precomp[order].Dim(0), precomp[order].Dim(1), precomp[order].begin(), false);
-    }
-
     Integer order_DIM = pow<Integer>(order, DIM);
     Integer order_DIM_ = pow<Integer>(order, DIM - 1);
     Long dof = fn_v.Dim() / order_DIM;
@@ -86,7 +74,7 @@ template <class ValueType, class Derived> class BasisInterface {
     for (Integer k = 0; k < DIM; k++) {  // Apply Mp along k-dimension
       Matrix<ValueType> Mi(dof * order_DIM_, order, fn.begin(), false);
       Matrix<ValueType> Mo(dof * order_DIM_, order, buff2, false);
-      Matrix<ValueType>::GEMM(Mo, Mi, Mp);
+      if (!Derived::NodesToCoeff1D(order, Mi, Mo)) Matrix<ValueType>::GEMM(Mo, Mi, ApproxMatrix1D(order));
 
       Matrix<ValueType> Mo_t(order, dof * order_DIM_, buff1, false);
       for (Long i = 0; i < Mo.Dim(0); i++) {
@@ -104,22 +92,33 @@ template <class ValueType, class Derived> class BasisInterface {
   }
 
   template <Integer DIM> static void Approx_(Integer order, const Vector<ValueType>& fn_v, Vector<ValueType>& coeff, ValueType scale) {
+    const auto build_matrix = [order, scale]() {
+      Vector<ValueType> x, p;
+      Derived::Nodes1D(order, x);
+      for (Integer i = 0; i < order; i++) x[i] = (x[i] - 0.5) * scale + 0.5;
+      Derived::EvalBasis1D(order, x, p);
+      Matrix<ValueType> Mp1(order, order, p.begin(), false);
+      return Mp1.pinv(machine_eps<ValueType>());
+    };
     Matrix<ValueType> Mp;
-    {  // Precompute
+    {  // Precompute (cached for the first scale used with each order)
       static Vector<Matrix<ValueType>> precomp(1000);
+      static Vector<ValueType> precomp_scale(1000);
+      static std::atomic<bool> ready[1000];
       SCTL_ASSERT(order < precomp.Dim());
-      if (precomp[order].Dim(0) * precomp[order].Dim(1) == 0) {
+      if (!ready[order].load(std::memory_order_acquire)) {
         #pragma omp critical(SCTL_BASIS_APPROX)
-        if (precomp[order].Dim(0) * precomp[order].Dim(1) == 0) {
-          Vector<ValueType> x, p;
-          Derived::Nodes1D(order, x);
-          for (Integer i = 0; i < order; i++) x[i] = (x[i] - 0.5) * scale + 0.5;
-          Derived::EvalBasis1D(order, x, p);
-          Matrix<ValueType> Mp1(order, order, p.begin(), false);
-          Mp1.pinv(machine_eps<ValueType>()).Swap(precomp[order]);
+        if (!ready[order].load(std::memory_order_relaxed)) {
+          build_matrix().Swap(precomp[order]);
+          precomp_scale[order] = scale;
+          ready[order].store(true, std::memory_order_release);
         }
       }
-      Mp.ReInit(precomp[order].Dim(0), precomp[order].Dim(1), precomp[order].begin(), false);
+      if (precomp_scale[order] == scale) {
+        Mp.ReInit(precomp[order].Dim(0), precomp[order].Dim(1), precomp[order].begin(), false);
+      } else {
+        build_matrix().Swap(Mp);
+      }
     }
 
     Integer order_DIM = pow<Integer>(order, DIM);
@@ -202,7 +201,7 @@ template <class ValueType, class Derived> class BasisInterface {
 
       Matrix<ValueType> Mi(dof * order_DIM, order, buff1, false);
       Matrix<ValueType> Mo(dof * order_DIM, in_x[k].Dim(), buff2, false);
-      Matrix<ValueType>::GEMM(Mo, Mi, Mp[k]);
+      if (!Derived::CoeffToNodes1D(order, in_x[k], Mi, Mo)) Matrix<ValueType>::GEMM(Mo, Mi, Mp[k]);
 
       Matrix<ValueType> Mo_t(in_x[k].Dim(), dof * order_DIM, buff1, false);
       if (k == DIM - 1) Mo_t.ReInit(in_x[k].Dim(), dof * order_DIM, out.begin(), false);
@@ -274,13 +273,15 @@ template <class ValueType, class Derived> class BasisInterface {
     Matrix<ValueType> Mdiff;
     {  // Precompute
       static Vector<Matrix<ValueType>> precomp(1000);
+      static std::atomic<bool> ready[1000];
       SCTL_ASSERT(order < precomp.Dim());
-      if (precomp[order].Dim(0) * precomp[order].Dim(1) == 0) {
+      if (!ready[order].load(std::memory_order_acquire)) {
         #pragma omp critical(SCTL_BASIS_GRAD)
-        if (precomp[order].Dim(0) * precomp[order].Dim(1) == 0) {
+        if (!ready[order].load(std::memory_order_relaxed)) {
           Matrix<ValueType> M;
           diff_1d(order, &M);
           M.Swap(precomp[order]);
+          ready[order].store(true, std::memory_order_release);
         }
       }
       Mdiff.ReInit(precomp[order].Dim(0), precomp[order].Dim(1), precomp[order].begin(), false);
@@ -1044,6 +1045,36 @@ template <class ValueType, class Derived> class BasisInterface {
     void (*Nodes1D)(Integer, Vector<ValueType>&) = Derived::Nodes1D;
   }
 
+  /**
+   * Returns the (order x order) matrix which maps the values at the nodes to the coefficients along one dimension.
+   * It is computed once for each order; the cache is safe to use from multiple threads.
+   */
+  static const Matrix<ValueType>& ApproxMatrix1D(Integer order) {
+    static Vector<Matrix<ValueType>> precomp(1000);
+    static std::atomic<bool> ready[1000];
+    SCTL_ASSERT(order < precomp.Dim());
+    if (!ready[order].load(std::memory_order_acquire)) {
+      #pragma omp critical(SCTL_BASIS_APPROX)
+      if (!ready[order].load(std::memory_order_relaxed)) {
+        Vector<ValueType> x, p;
+        Derived::Nodes1D(order, x);
+        Derived::EvalBasis1D(order, x, p);
+        Matrix<ValueType> Mp1(order, order, p.begin(), false);
+        Mp1.pinv(machine_eps<ValueType>()).Swap(precomp[order]);
+        ready[order].store(true, std::memory_order_release);
+      }
+    }
+    return precomp[order];
+  }
+
+  /**
+   * Fast transforms which the derived class may provide. NodesToCoeff1D computes the coefficients from the values at
+   * the nodes for each row of Mi (N x order), and CoeffToNodes1D evaluates the coefficients in each row of Mi at the
+   * points x. They return false (and the dense matrices are used instead) if the transform is not available.
+   */
+  static bool NodesToCoeff1D(Integer order, const Matrix<ValueType>& Mi, Matrix<ValueType>& Mo) { return false; }
+  static bool CoeffToNodes1D(Integer order, const Vector<ValueType>& x, const Matrix<ValueType>& Mi, Matrix<ValueType>& Mo) { return false; }
+
   static void cheb_nodes_1d(Integer order, Vector<ValueType>& nodes) {
     if (nodes.Dim() != order) nodes.ReInit(order);
     for (Integer i = 0; i < order; i++) {
@@ -1376,6 +1407,124 @@ template <class ValueType> class ChebBasis : public BasisInterface<ValueType, Ch
    */
   static void EvalBasis1D(Integer order, const Vector<ValueType>& x, Vector<ValueType>& y) { BasisInterface<ValueType, ChebBasis<ValueType>>::cheb_basis_1d(order, x, y); }
 
+  /**
+   * At the Chebyshev nodes x_i = (1 - cos((i+1/2) pi/n)) / 2, the values f_i = sum_k c_k T_k(2 x_i - 1) =
+   * sum_k (-1)^k c_k cos(k (i+1/2) pi/n) are a DCT-III of the coefficients, so the transforms between the values and the
+   * coefficients are computed in O(n log n) using an FFT of length n (J. Makhoul, IEEE Trans. ASSP 28(1), 1980) for
+   * order >= SCTL_CHEB_DCT_MIN_ORDER. The FFT plans are cached for each order (see DCTPlan).
+   */
+  static bool NodesToCoeff1D(Integer order, const Matrix<ValueType>& Mi, Matrix<ValueType>& Mo) {
+    if (order < SCTL_CHEB_DCT_MIN_ORDER) return false;
+    const Long N = Mi.Dim(0);
+    const Long n = order, n_ = order / 2 + 1;
+    SCTL_ASSERT(Mi.Dim(1) == n && Mo.Dim(0) == N && Mo.Dim(1) == n);
+    if (!N) return true;
+
+    const DCTData& dct = DCTPlan(order, false);
+    const FFT<ValueType>& fft = dct.fft;
+    const Vector<ValueType>& wc = dct.wc;
+    const Vector<ValueType>& ws = dct.ws;
+    Vector<ValueType> v(DCT_BATCH * n), V;
+    v.SetZero();
+    for (Long r0 = 0; r0 < N; r0 += DCT_BATCH) {
+      const Long Nr = std::min<Long>(N - r0, (Long)DCT_BATCH);  // (the rest of the last batch is padding)
+      for (Long r = 0; r < Nr; r++) {  // even entries in increasing order followed by odd entries in decreasing order
+        for (Long k = 0; 2 * k < n; k++) v[r * n + k] = Mi[r0 + r][2 * k];
+        for (Long k = 0; 2 * k + 1 < n; k++) v[r * n + n - 1 - k] = Mi[r0 + r][2 * k + 1];
+      }
+      fft.Execute(v, V);
+
+      for (Long r = 0; r < Nr; r++) {
+        ConstIterator<ValueType> V_ = V.begin() + r * n_ * 2;
+        for (Long k = 0; k < n_; k++) Mo[r0 + r][k] = wc[k] * V_[k * 2 + 0] + ws[k] * V_[k * 2 + 1];
+        for (Long k = n_; k < n; k++) Mo[r0 + r][k] = wc[k] * V_[(n - k) * 2 + 0] - ws[k] * V_[(n - k) * 2 + 1];
+      }
+    }
+    return true;
+  }
+
+  static bool CoeffToNodes1D(Integer order, const Vector<ValueType>& x, const Matrix<ValueType>& Mi, Matrix<ValueType>& Mo) {
+    if (order < SCTL_CHEB_DCT_MIN_ORDER || x.Dim() != order) return false;
+    {  // check that x are the Chebyshev nodes
+      Vector<ValueType> nds;
+      Nodes1D(order, nds);
+      for (Long i = 0; i < order; i++) {
+        if (x[i] != nds[i]) return false;
+      }
+    }
+    const Long N = Mi.Dim(0);
+    const Long n = order, n_ = order / 2 + 1;
+    SCTL_ASSERT(Mi.Dim(1) == n && Mo.Dim(0) == N && Mo.Dim(1) == n);
+    if (!N) return true;
+
+    const DCTData& dct = DCTPlan(order, true);
+    const FFT<ValueType>& fft = dct.fft;
+    const Vector<ValueType>& wc = dct.wc;
+    const Vector<ValueType>& ws = dct.ws;
+    Vector<ValueType> V(DCT_BATCH * n_ * 2), v;
+    V.SetZero();
+    for (Long r0 = 0; r0 < N; r0 += DCT_BATCH) {
+      const Long Nr = std::min<Long>(N - r0, (Long)DCT_BATCH);  // (the rest of the last batch is padding)
+      for (Long r = 0; r < Nr; r++) {
+        const auto X = [&Mi, r0, r, n](Long k) {  // DCT-II coefficients (scaled by 1/n)
+          if (k == n) return (ValueType)0;
+          return (k ? (k % 2 ? -(ValueType)0.5 : (ValueType)0.5) : (ValueType)1) * Mi[r0 + r][k];
+        };
+        Iterator<ValueType> V_ = V.begin() + r * n_ * 2;
+        for (Long k = 0; k < n_; k++) {  // V_k = exp(i pi k / (2n)) (X_k - i X_{n-k})
+          const ValueType Xk = X(k), Xnk = (k ? X(n - k) : 0);
+          V_[k * 2 + 0] = wc[k] * Xk + ws[k] * Xnk;
+          V_[k * 2 + 1] = ws[k] * Xk - wc[k] * Xnk;
+        }
+      }
+      fft.Execute(V, v);
+
+      for (Long r = 0; r < Nr; r++) {
+        for (Long k = 0; 2 * k < n; k++) Mo[r0 + r][2 * k] = v[r * n + k];
+        for (Long k = 0; 2 * k + 1 < n; k++) Mo[r0 + r][2 * k + 1] = v[r * n + n - 1 - k];
+      }
+    }
+    return true;
+  }
+
+  static constexpr Integer DCT_BATCH = 16;  // number of rows transformed by each execution of the cached FFT plans
+
+  struct DCTData {
+    FFT<ValueType> fft;  // FFT of length order for a batch of DCT_BATCH rows
+    Vector<ValueType> wc, ws;  // twiddle factors
+  };
+
+  /**
+   * Returns the FFT plan (R2C, or C2R if inverse) and the twiddle factors used by the fast transforms. They are set up
+   * once for each order; the cache is safe to use from multiple threads.
+   */
+  static const DCTData& DCTPlan(Integer order, bool inverse) {
+    static std::unique_ptr<DCTData> precomp[2 * 1000];
+    static std::atomic<bool> ready[2 * 1000];
+    SCTL_ASSERT(order < 1000);
+    const Long idx = (inverse ? 1000 : 0) + order;
+    if (!ready[idx].load(std::memory_order_acquire)) {
+      #pragma omp critical(SCTL_CHEB_DCT_PLAN)
+      if (!ready[idx].load(std::memory_order_relaxed)) {
+        const Long n = order;
+        std::unique_ptr<DCTData> dct(new DCTData());
+        dct->fft.Setup(inverse ? FFT_Type::C2R : FFT_Type::R2C, (Long)DCT_BATCH, Vector<Long>(1, Ptr2Itr<Long>((Long*)&n, 1), false));
+        dct->wc.ReInit(n);
+        dct->ws.ReInit(n);
+        for (Long k = 0; k < n; k++) {
+          // NodesToCoeff1D: wc + i ws = (-1)^k exp(i pi k / (2n)) * (k ? 2 : 1) / sqrt(n) (the FFT is normalized)
+          // CoeffToNodes1D: wc + i ws = exp(i pi k / (2n)) * sqrt(n)
+          const ValueType s = (inverse ? sqrt<ValueType>(n) : (k ? 2 : 1) * (k % 2 ? -1 : 1) / sqrt<ValueType>(n));
+          dct->wc[k] = cos<ValueType>(const_pi<ValueType>() * k / (2 * n)) * s;
+          dct->ws[k] = sin<ValueType>(const_pi<ValueType>() * k / (2 * n)) * s;
+        }
+        precomp[idx] = std::move(dct);
+        ready[idx].store(true, std::memory_order_release);
+      }
+    }
+    return *precomp[idx];
+  }
+
   friend BasisInterface<ValueType, ChebBasis<ValueType>>;
 };
 
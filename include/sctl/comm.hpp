@@ -3,10 +3,12 @@
 
 #include <functional>         // for less
 #include <map>                // for multimap
+#include <memory>             // for shared_ptr
 #include <vector>             // for vector
 
 #include "sctl/common.hpp"    // for Long, Integer, sctl
 #include "sctl/iterator.hpp"  // for ConstIterator, Iterator
+#include "sctl/ompUtils.hpp"  // for RadixKey
 
 #ifdef SCTL_HAVE_MPI
 #include <mpi.h>
@@ -98,6 +100,25 @@ class Comm {
    */
   Comm Split(Integer clr) const;
 
+  /**
+   * Enable or disable node-aware hierarchical collectives. When enabled, ranks are grouped by shared-memory node;
+   * Alltoallv and Allgatherv (and PartitionW, PartitionN, PartitionS, SortScatterIndex, ScatterForward and
+   * ScatterReverse which are built on them) then combine the messages of each node at a node leader so that only one
+   * rank per node communicates across the network. This is a collective operation. Copies of the communicator
+   * share the node and leader communicators, so copying does not repeat this setup.
+   *
+   * @param[in] state true to enable, false to disable.
+   *
+   * @param[in] node_size number of consecutive ranks to treat as one node. The default value (0) detects
+   * shared-memory nodes using `MPI_Comm_split_type`.
+   */
+  void SetHierarchical(bool state, Integer node_size = 0);
+
+  /**
+   * @return true if hierarchical collectives are enabled.
+   */
+  bool IsHierarchical() const;
+
   /**
    * @return rank of the current process.
    */
@@ -276,6 +297,24 @@ class Comm {
    */
   template <class Type> void Allreduce(ConstIterator<Type> sbuf, Iterator<Type> rbuf, Long count, CommOp op) const;
 
+  /**
+   * Start a non-blocking all-reduce operation. The buffers must not be accessed until the operation is completed by
+   * calling Wait.
+   *
+   * @tparam Type type of the data.
+   *
+   * @param[in] sbuf iterator to the send buffer.
+   *
+   * @param[out] rbuf iterator to the receive buffer.
+   *
+   * @param[in] count number of elements.
+   *
+   * @param[in] op reduction operation.
+   *
+   * @return pointer to the request object (to be passed to Wait).
+   */
+  template <class Type> void* Iallreduce(ConstIterator<Type> sbuf, Iterator<Type> rbuf, Long count, CommOp op) const;
+
   /**
    * Perform a scan operation.
    *
@@ -367,6 +406,39 @@ class Comm {
     HyperQuickSort(arr, SortedElem, std::less<Type>());
   }
 
+  /**
+   * Sorts the elements of an array using a parallel sample sort with a single all-to-all exchange. The local data is
+   * sorted with `omp_par::merge_sort` and the splitters are chosen by regular sampling. If the input is already
+   * nearly sorted across processes (for example, when re-sorting data that has moved slightly since the previous
+   * sort), the current partition boundaries are used as splitters so that only the out-of-place elements are
+   * exchanged. The output is load-balanced as in HyperQuickSort.
+   *
+   * @tparam Type type of the elements in the array.
+   * @tparam Compare comparison function type.
+   *
+   * @param[in] arr input array to be sorted.
+   *
+   * @param[out] SortedElem sorted array.
+   *
+   * @param[in] comp comparison function for elements.
+   *
+   * @param[in] oversample number of samples taken from each process to choose the splitters.
+   */
+  template <class Type, class Compare> void SampleSort(const Vector<Type>& arr, Vector<Type>& SortedElem, Compare comp, Integer oversample = 32) const;
+
+  /**
+   * Sorts the elements of an array using a parallel sample sort with the default comparison function.
+   *
+   * @tparam Type type of the elements in the array.
+   *
+   * @param[in] arr input array to be sorted.
+   *
+   * @param[out] SortedElem sorted array.
+   */
+  template <class Type> void SampleSort(const Vector<Type>& arr, Vector<Type>& SortedElem) const {
+    SampleSort(arr, SortedElem, std::less<Type>());
+  }
+
   /**
    * Generates scatter indices corresponding to a sorted array.
    *
@@ -415,6 +487,33 @@ class Comm {
     B data;
   };
 
+  template <class T, class Enable> friend struct omp_par::RadixKey;
+
+  /**
+   * Release the node and leader communicators of the hierarchical mode.
+   */
+  void FreeHierarchy();
+
+  /**
+   * Share the hierarchical mode (and its node and leader communicators) of c.
+   */
+  void CopyHierarchy(const Comm& c);
+
+  /**
+   * Hierarchical implementation of Alltoallv.
+   *
+   * @return false if the hierarchical mode is not active and the caller must use the flat algorithm.
+   */
+  template <class Type> bool HierarchicalAlltoallv(ConstIterator<Type> sbuf, ConstIterator<Long> scounts, ConstIterator<Long> sdispls, Iterator<Type> rbuf, ConstIterator<Long> rcounts, ConstIterator<Long> rdispls) const;
+
+  /**
+   * Hierarchical implementation of Allgatherv (only used when the send and receive types are the same).
+   *
+   * @return false if the hierarchical mode is not active and the caller must use the flat algorithm.
+   */
+  template <class Type> bool HierarchicalAllgatherv(ConstIterator<Type> sbuf, Long scount, Iterator<Type> rbuf, ConstIterator<Long> rcounts, ConstIterator<Long> rdispls) const;
+  template <class SType, class RType> bool HierarchicalAllgatherv(ConstIterator<SType> sbuf, Long scount, Iterator<RType> rbuf, ConstIterator<Long> rcounts, ConstIterator<Long> rdispls) const { return false; }
+
 #ifdef SCTL_HAVE_MPI
   /**
    * Initialize the communicator.
@@ -441,6 +540,13 @@ class Comm {
   int mpi_tag_ub_;
   MPI_Comm mpi_comm_;
 
+  Integer hier_node_size_;              // node_size argument of SetHierarchical, -1 when disabled
+  std::shared_ptr<Comm> node_comm_;     // ranks on the same node as this rank (shared by copies)
+  std::shared_ptr<Comm> leader_comm_;   // first rank of each node (nullptr on other ranks, shared by copies)
+  Integer node_id_;                     // index of the node of this rank
+  std::vector<Integer> node_dsp_;       // ranks of node i are node_rank_lst_[node_dsp_[i]], ..., node_rank_lst_[node_dsp_[i+1]-1]
+  std::vector<Integer> node_rank_lst_;
+
   template <class Type> class CommDatatype;
 
 #else
@@ -449,6 +555,17 @@ class Comm {
 #endif
 };
 
+/**
+ * Radix sort key of Comm::SortPair (which is ordered by the key only), so that the local sorts in Comm use radix_sort
+ * for pairs with Morton or Hilbert keys.
+ */
+template <class A, class B> struct omp_par::RadixKey<Comm::SortPair<A, B>, typename std::enable_if<omp_par::RadixKey<A>::Enabled>::type> {
+  static constexpr bool Enabled = true;
+  static constexpr bool MergeSort = omp_par::RadixKey<A>::MergeSort;
+  typedef typename omp_par::RadixKey<A>::KeyType KeyType;
+  static KeyType Key(const Comm::SortPair<A, B>& a) { return omp_par::RadixKey<A>::Key(a.key); }
+};
+
 }  // end namespace
 
 #endif // _SCTL_COMM_HPP_
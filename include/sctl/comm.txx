@@ -6,6 +6,7 @@
 #include <functional>             // for less
 #include <limits>                 // for numeric_limits
 #include <map>                    // for multimap, __map_iterator, operator==
+#include <memory>                 // for make_shared, shared_ptr
 #include <type_traits>            // for is_trivially_copyable
 #include <utility>                // for pair
 #include <vector>                 // for vector
@@ -14,6 +15,8 @@
 #include "sctl/comm.hpp"          // for Comm, CommOp
 #include "sctl/iterator.hpp"      // for Iterator, ConstIterator
 #include "sctl/iterator.txx"      // for Iterator::Iterator<ValueType>, Iter...
+#include "sctl/metrics.hpp"       // for Metrics, Metric
+#include "sctl/metrics.txx"       // for Metrics::Record, Metrics::ReduceData
 #include "sctl/ompUtils.txx"      // for scan, merge_sort
 #include "sctl/static-array.hpp"  // for StaticArray
 #include "sctl/static-array.txx"  // for StaticArray::operator[], StaticArra...
@@ -133,11 +136,13 @@ constexpr Long MPIChunkTagUnchecked(Long user_tag, Long chunk_idx) {
 inline void TrackPointToPoint(Long request_count, Long total_bytes) {
   Profile::IncrementCounter(ProfileCounter::PROF_MPI_COUNT, request_count);
   Profile::IncrementCounter(ProfileCounter::PROF_MPI_BYTES, total_bytes);
+  Metrics::Record(Metric::COMM_P2P_BYTES, (double)total_bytes);
 }
 
-inline void TrackCollective(Long collective_count, Long total_bytes) {
+inline void TrackCollective(Long collective_count, Long total_bytes, Metric metric) {
   Profile::IncrementCounter(ProfileCounter::PROF_MPI_COLLECTIVE_COUNT, collective_count);
   Profile::IncrementCounter(ProfileCounter::PROF_MPI_COLLECTIVE_BYTES, total_bytes);
+  if (total_bytes) Metrics::Record(metric, (double)total_bytes); // skip count-only updates (extra windows in Allgatherv)
 }
 
 inline Long MPIChunkTagBase(Long user_tag) {
@@ -281,6 +286,7 @@ inline Comm::Comm() {
 inline Comm::Comm(const Comm& c) {
 #ifdef SCTL_HAVE_MPI
   Init(c.mpi_comm_);
+  CopyHierarchy(c);
 #endif
 }
 
@@ -303,10 +309,12 @@ inline Comm Comm::World() {
 inline Comm& Comm::operator=(const Comm& c) {
 #ifdef SCTL_HAVE_MPI
   if (this == &c) return *this;
+  FreeHierarchy();
   if (comm_detail::MPIIsActive()) {
     #pragma omp critical(SCTL_COMM_DUP)
     if (mpi_comm_ != MPI_COMM_NULL) MPI_Comm_free(&mpi_comm_);
     Init(c.mpi_comm_);
+    CopyHierarchy(c);
   } else {
     SCTL_WARN("Comm::operator= called while MPI is inactive; resetting to MPI_COMM_NULL.");
     mpi_rank_ = 0;
@@ -325,6 +333,7 @@ inline Comm::~Comm() {
     delete (Vector<MPI_Request>*)req.top();
     req.pop();
   }
+  FreeHierarchy();
   if (comm_detail::MPIIsActive()) {
     #pragma omp critical(SCTL_COMM_DUP)
     if (mpi_comm_ != MPI_COMM_NULL) MPI_Comm_free(&mpi_comm_);
@@ -347,6 +356,93 @@ inline Comm Comm::Split(Integer clr) const {
 #endif
 }
 
+inline void Comm::SetHierarchical(bool state, Integer node_size) {
+#ifdef SCTL_HAVE_MPI
+  comm_detail::WarnIfMPIInactive("Comm::SetHierarchical");
+  FreeHierarchy();
+  if (!state) return;
+  SCTL_ASSERT(node_size >= 0);
+
+  MPI_Comm new_comm;
+  #pragma omp critical(SCTL_COMM_DUP)
+  {
+    if (node_size) MPI_Comm_split(mpi_comm_, mpi_rank_ / node_size, mpi_rank_, &new_comm);
+    else MPI_Comm_split_type(mpi_comm_, MPI_COMM_TYPE_SHARED, mpi_rank_, MPI_INFO_NULL, &new_comm);
+  }
+  node_comm_ = std::make_shared<Comm>(new_comm);
+  #pragma omp critical(SCTL_COMM_DUP)
+  {
+    MPI_Comm_free(&new_comm);
+    MPI_Comm_split(mpi_comm_, (node_comm_->Rank() == 0 ? 0 : MPI_UNDEFINED), mpi_rank_, &new_comm);
+  }
+  if (new_comm != MPI_COMM_NULL) {
+    leader_comm_ = std::make_shared<Comm>(new_comm);
+    #pragma omp critical(SCTL_COMM_DUP)
+    MPI_Comm_free(&new_comm);
+  }
+
+  { // Set node_id_, node_dsp_, node_rank_lst_
+    // Nodes are numbered by the rank of their leader, which is also the order of ranks in leader_comm_.
+    Integer leader = mpi_rank_;
+    node_comm_->Bcast(Ptr2Itr<Integer>(&leader, 1), 1, 0);
+    std::vector<Integer> leader_lst(mpi_size_);
+    Allgather(Ptr2ConstItr<Integer>(&leader, 1), 1, Ptr2Itr<Integer>(leader_lst.data(), mpi_size_), 1);
+
+    std::vector<Integer> node_of_rank(mpi_size_, -1);
+    Integer node_cnt = 0;
+    for (Integer p = 0; p < mpi_size_; p++) {
+      if (leader_lst[p] == p) node_of_rank[p] = node_cnt++;
+    }
+    node_dsp_.assign(node_cnt + 1, 0);
+    for (Integer p = 0; p < mpi_size_; p++) {
+      node_of_rank[p] = node_of_rank[leader_lst[p]];
+      node_dsp_[node_of_rank[p] + 1]++;
+    }
+    for (Integer i = 0; i < node_cnt; i++) node_dsp_[i + 1] += node_dsp_[i];
+    node_rank_lst_.resize(mpi_size_);
+    std::vector<Integer> node_cnt_(node_cnt, 0);
+    for (Integer p = 0; p < mpi_size_; p++) {
+      const Integer n = node_of_rank[p];
+      node_rank_lst_[node_dsp_[n] + node_cnt_[n]++] = p;
+    }
+    node_id_ = node_of_rank[mpi_rank_];
+  }
+  hier_node_size_ = node_size;
+#endif
+}
+
+inline bool Comm::IsHierarchical() const {
+#ifdef SCTL_HAVE_MPI
+  return hier_node_size_ >= 0;
+#else
+  return false;
+#endif
+}
+
+inline void Comm::FreeHierarchy() {
+#ifdef SCTL_HAVE_MPI
+  hier_node_size_ = -1;
+  node_comm_.reset();
+  leader_comm_.reset();
+  node_id_ = 0;
+  node_dsp_.clear();
+  node_rank_lst_.clear();
+#endif
+}
+
+inline void Comm::CopyHierarchy(const Comm& c) {
+#ifdef SCTL_HAVE_MPI
+  hier_node_size_ = c.hier_node_size_;
+  node_comm_ = c.node_comm_;
+  leader_comm_ = c.leader_comm_;
+  node_id_ = c.node_id_;
+  node_dsp_ = c.node_dsp_;
+  node_rank_lst_ = c.node_rank_lst_;
+#else
+  SCTL_UNUSED(c);
+#endif
+}
+
 inline Integer Comm::Rank() const {
 #ifdef SCTL_HAVE_MPI
   return mpi_rank_;
@@ -463,10 +559,10 @@ template <class Type> void Comm::Bcast(Iterator<Type> buf, Long count, Long root
   comm_detail::WarnIfMPIInactive("Comm::Bcast");
   comm_detail::TouchBuffer(buf, count);
 #if MPI_VERSION >= 4
-  comm_detail::TrackCollective(1, count * sizeof(Type));
+  comm_detail::TrackCollective(1, count * sizeof(Type), Metric::COMM_BCAST_BYTES);
   MPI_Bcast_c(&buf[0], comm_detail::MPIAsCountLarge(count), CommDatatype<Type>::value(), root, mpi_comm_);
 #else
-  comm_detail::TrackCollective(comm_detail::MPINumChunks(count), count * sizeof(Type));
+  comm_detail::TrackCollective(comm_detail::MPINumChunks(count), count * sizeof(Type), Metric::COMM_BCAST_BYTES);
   for (Long offset = 0; offset < count; offset += comm_detail::MPIIntLimit()) {
     const Long chunk = std::min<Long>(count - offset, comm_detail::MPIIntLimit());
     MPI_Bcast(&buf[offset], comm_detail::MPIAsCount(chunk), CommDatatype<Type>::value(), root, mpi_comm_);
@@ -482,7 +578,7 @@ template <class SType, class RType> void Comm::Allgather(ConstIterator<SType> sb
   comm_detail::TouchBuffer(rbuf, rcount * Size());
 #ifdef SCTL_HAVE_MPI
   comm_detail::WarnIfMPIInactive("Comm::Allgather");
-  comm_detail::TrackCollective(1, scount * sizeof(SType) + rcount * sizeof(RType));
+  comm_detail::TrackCollective(1, scount * sizeof(SType) + rcount * sizeof(RType), Metric::COMM_ALLGATHER_BYTES);
 #if MPI_VERSION >= 4
   MPI_Allgather_c((scount ? &sbuf[0] : nullptr), comm_detail::MPIAsCountLarge(scount), CommDatatype<SType>::value(), (rcount ? &rbuf[0] : nullptr), comm_detail::MPIAsCountLarge(rcount), CommDatatype<RType>::value(), mpi_comm_);
 #else
@@ -523,8 +619,9 @@ template <class SType, class RType> void Comm::Allgatherv(ConstIterator<SType> s
   }
   comm_detail::TouchBuffer(sbuf, scount);
   if (!rcount_sum) return;
+  if (HierarchicalAllgatherv(sbuf, scount, rbuf, rcounts, rdispls)) return;
 
-  comm_detail::TrackCollective(1, scount * sizeof(SType) + rcount_sum * sizeof(RType));
+  comm_detail::TrackCollective(1, scount * sizeof(SType) + rcount_sum * sizeof(RType), Metric::COMM_ALLGATHER_BYTES);
 #if MPI_VERSION >= 4
   Vector<MPI_Count> rcounts_(mpi_size_);
   Vector<MPI_Aint> rdispls_(mpi_size_);
@@ -638,7 +735,7 @@ template <class SType, class RType> void Comm::Allgatherv(ConstIterator<SType> s
         }
       }
     }
-    comm_detail::TrackCollective(num_windows - 1, 0);
+    comm_detail::TrackCollective(num_windows - 1, 0, Metric::COMM_ALLGATHER_BYTES);
   }
 
   if (free_unit_type) MPI_Type_free(&unit_type);
@@ -661,7 +758,7 @@ template <class SType, class RType> void Comm::Alltoall(ConstIterator<SType> sbu
     SCTL_UNUSED(rbuf[0]                  );
     SCTL_UNUSED(rbuf[rcount * Size() - 1]);
   }
-  comm_detail::TrackCollective(1, scount * sizeof(SType) + rcount * sizeof(RType));
+  comm_detail::TrackCollective(1, scount * sizeof(SType) + rcount * sizeof(RType), Metric::COMM_ALLTOALL_BYTES);
 #if MPI_VERSION >= 4
   MPI_Alltoall_c((scount ? &sbuf[0] : nullptr), comm_detail::MPIAsCountLarge(scount), CommDatatype<SType>::value(), (rcount ? &rbuf[0] : nullptr), comm_detail::MPIAsCountLarge(rcount), CommDatatype<RType>::value(), mpi_comm_);
 #else
@@ -792,6 +889,7 @@ template <class Type> void Comm::Alltoallv(ConstIterator<Type> sbuf, ConstIterat
   static_assert(std::is_trivially_copyable<Type>::value, "Data is not trivially copyable!");
 #ifdef SCTL_HAVE_MPI
   comm_detail::WarnIfMPIInactive("Comm::Alltoallv");
+  if (HierarchicalAlltoallv(sbuf, scounts, sdispls, rbuf, rcounts, rdispls)) return;
 #if MPI_VERSION >= 4
   {
     // MPI-4 handles large counts and displacements directly through the _c binding.
@@ -807,29 +905,26 @@ template <class Type> void Comm::Alltoallv(ConstIterator<Type> sbuf, ConstIterat
       stotal += scounts[i];
       rtotal += rcounts[i];
     }
-    comm_detail::TrackCollective(1, stotal * sizeof(Type) + rtotal * sizeof(Type));
+    comm_detail::TrackCollective(1, stotal * sizeof(Type) + rtotal * sizeof(Type), Metric::COMM_ALLTOALL_BYTES);
     MPI_Alltoallv_c((stotal ? &sbuf[0] : nullptr), &scnt[0], &sdsp[0], CommDatatype<Type>::value(), (rtotal ? &rbuf[0] : nullptr), &rcnt[0], &rdsp[0], CommDatatype<Type>::value(), mpi_comm_);
     return;
   }
 #else
-  bool fits_int = true;
-  for (Integer i = 0; i < mpi_size_; i++) {
-    fits_int = fits_int && comm_detail::MPIFitsCount(scounts[i]) && comm_detail::MPIFitsCount(sdispls[i]) && comm_detail::MPIFitsCount(rcounts[i]) && comm_detail::MPIFitsCount(rdispls[i]);
-  }
-  if (!fits_int) {  // Fall back to sparse point-to-point exchange once any count or displacement exceeds int.
-    void* mpi_req = Ialltoallv_sparse(sbuf, scounts, sdispls, rbuf, rcounts, rdispls, 0);
-    Wait(mpi_req);
-    return;
-  }
-
   {  // Use Alltoallv_sparse of average connectivity<64
-    Long connectivity = 0, glb_connectivity = 0;
-    #pragma omp parallel for schedule(static) reduction(+ : connectivity)
+    // The second entry counts the processes with a count or displacement that exceeds int, these must also
+    // fall back to the sparse point-to-point exchange and the decision has to be the same on all processes.
+    Long connectivity[2] = {0, 0}, glb_connectivity[2] = {0, 0};
     for (Integer i = 0; i < mpi_size_; i++) {
-      if (rcounts[i]) connectivity++;
+      if (rcounts[i]) connectivity[0]++;
+      if (!(comm_detail::MPIFitsCount(scounts[i]) && comm_detail::MPIFitsCount(sdispls[i]) && comm_detail::MPIFitsCount(rcounts[i]) && comm_detail::MPIFitsCount(rdispls[i]))) connectivity[1] = 1;
     }
-    Allreduce(Ptr2ConstItr<Long>(&connectivity, 1), Ptr2Itr<Long>(&glb_connectivity, 1), 1, CommOp::SUM);
-    if (glb_connectivity < 64 * Size()) {
+    Allreduce(Ptr2ConstItr<Long>(connectivity, 2), Ptr2Itr<Long>(glb_connectivity, 2), 2, CommOp::SUM);
+    if (glb_connectivity[1]) {  // Fall back to sparse point-to-point exchange once any count or displacement exceeds int.
+      void* mpi_req = Ialltoallv_sparse(sbuf, scounts, sdispls, rbuf, rcounts, rdispls, 0);
+      Wait(mpi_req);
+      return;
+    }
+    if (glb_connectivity[0] < 64 * Size()) {
       void* mpi_req = Ialltoallv_sparse(sbuf, scounts, sdispls, rbuf, rcounts, rdispls, 0);
       Wait(mpi_req);
       { // Verify
@@ -880,7 +975,7 @@ template <class Type> void Comm::Alltoallv(ConstIterator<Type> sbuf, ConstIterat
       rtotal += rcounts[i];
     }
 
-    comm_detail::TrackCollective(1, stotal * sizeof(Type) + rtotal * sizeof(Type));
+    comm_detail::TrackCollective(1, stotal * sizeof(Type) + rtotal * sizeof(Type), Metric::COMM_ALLTOALL_BYTES);
     MPI_Alltoallv((stotal ? &sbuf[0] : nullptr), &scnt[0], &sdsp[0], CommDatatype<Type>::value(), (rtotal ? &rbuf[0] : nullptr), &rcnt[0], &rdsp[0], CommDatatype<Type>::value(), mpi_comm_);
     return;
     //#endif
@@ -893,6 +988,205 @@ template <class Type> void Comm::Alltoallv(ConstIterator<Type> sbuf, ConstIterat
 #endif
 }
 
+template <class Type> bool Comm::HierarchicalAlltoallv(ConstIterator<Type> sbuf, ConstIterator<Long> scounts, ConstIterator<Long> sdispls, Iterator<Type> rbuf, ConstIterator<Long> rcounts, ConstIterator<Long> rdispls) const {
+#ifdef SCTL_HAVE_MPI
+  const Integer node_cnt = (Integer)node_dsp_.size() - 1;
+  if (hier_node_size_ < 0 || node_cnt <= 1 || node_cnt == mpi_size_) return false;
+  const Integer np = mpi_size_;
+  const Integer node_np = node_comm_->Size();
+
+  // Ranks are visited in node order (node_rank_lst_) so that the data for each node is contiguous.
+  Vector<Long> cnt(2 * np);  // send counts followed by receive counts
+  Long stotal = 0, rtotal = 0;
+  for (Integer i = 0; i < np; i++) {
+    const Integer p = node_rank_lst_[i];
+    cnt[i] = scounts[p];
+    cnt[np + i] = rcounts[p];
+    stotal += scounts[p];
+    rtotal += rcounts[p];
+  }
+  Vector<Type> sbuf_(stotal);
+  Long offset = 0;
+  for (Integer i = 0; i < np; i++) {
+    const Integer p = node_rank_lst_[i];
+    if (scounts[p]) memcopy(sbuf_.begin() + offset, sbuf + sdispls[p], scounts[p]);
+    offset += scounts[p];
+  }
+
+  Vector<Long> node_total(2 * node_np);
+  { // Gather counts and send data at the node leader
+    Long total[2] = {stotal, rtotal};
+    node_comm_->Allgather(Ptr2ConstItr<Long>(total, 2), 2, node_total.begin(), 2);
+  }
+  const bool is_leader = (leader_comm_ != nullptr);
+  Vector<Long> node_scnt(node_np), node_sdsp(node_np), node_rcnt(node_np), node_rdsp(node_np);
+  Vector<Long> node_cnt_buf(is_leader ? 2 * np * node_np : 0);
+  Vector<Type> node_sbuf;
+  {
+    node_scnt.SetZero();
+    node_sdsp.SetZero();
+    node_rcnt.SetZero();
+    node_rdsp.SetZero();
+    node_scnt[0] = 2 * np;
+    if (is_leader) {
+      for (Integer j = 0; j < node_np; j++) {
+        node_rcnt[j] = 2 * np;
+        node_rdsp[j] = 2 * np * j;
+      }
+    }
+    void* mpi_req = node_comm_->Ialltoallv_sparse(cnt.begin(), node_scnt.begin(), node_sdsp.begin(), node_cnt_buf.begin(), node_rcnt.begin(), node_rdsp.begin(), 0);
+    node_comm_->Wait(mpi_req);
+
+    node_scnt[0] = stotal;
+    Long node_stotal = 0;
+    if (is_leader) {
+      for (Integer j = 0; j < node_np; j++) {
+        node_rcnt[j] = node_total[2 * j];
+        node_rdsp[j] = node_stotal;
+        node_stotal += node_rcnt[j];
+      }
+    }
+    node_sbuf.ReInit(node_stotal);
+    mpi_req = node_comm_->Ialltoallv_sparse(sbuf_.begin(), node_scnt.begin(), node_sdsp.begin(), node_sbuf.begin(), node_rcnt.begin(), node_rdsp.begin(), 1);
+    node_comm_->Wait(mpi_req);
+  }
+
+  Vector<Type> node_rbuf;
+  Vector<Long> node_rtotal_dsp(node_np);
+  if (is_leader) { // Exchange between node leaders
+    // Message from node n to node m holds, for each rank q of m and then for each rank p of n, the data from p to q.
+    Vector<Long> src_dsp(np * node_np);  // offset in node_sbuf of the data from local rank j to rank i
+    for (Integer j = 0; j < node_np; j++) {
+      Long offset = node_rdsp[j];
+      for (Integer i = 0; i < np; i++) {
+        src_dsp[j * np + i] = offset;
+        offset += node_cnt_buf[2 * np * j + i];
+      }
+    }
+
+    Vector<Long> lscnt(node_cnt), lsdsp(node_cnt), lrcnt(node_cnt), lrdsp(node_cnt);
+    Vector<Type> lsbuf(node_sbuf.Dim());
+    Long soffset = 0, roffset = 0;
+    for (Integer m = 0; m < node_cnt; m++) {
+      lsdsp[m] = soffset;
+      for (Integer i = node_dsp_[m]; i < node_dsp_[m + 1]; i++) {
+        for (Integer j = 0; j < node_np; j++) {
+          const Long n = node_cnt_buf[2 * np * j + i];
+          if (n) memcopy(lsbuf.begin() + soffset, node_sbuf.begin() + src_dsp[j * np + i], n);
+          soffset += n;
+        }
+      }
+      lscnt[m] = soffset - lsdsp[m];
+
+      lrdsp[m] = roffset;
+      for (Integer j = 0; j < node_np; j++) {
+        for (Integer k = node_dsp_[m]; k < node_dsp_[m + 1]; k++) {
+          roffset += node_cnt_buf[2 * np * j + np + k];
+        }
+      }
+      lrcnt[m] = roffset - lrdsp[m];
+    }
+    Vector<Type> lrbuf(roffset);
+    leader_comm_->Alltoallv(lsbuf.begin(), lscnt.begin(), lsdsp.begin(), lrbuf.begin(), lrcnt.begin(), lrdsp.begin());
+
+    // Reorder so that the data for each local rank is contiguous.
+    Vector<Long> dst_offset(node_np);
+    for (Integer j = 0; j < node_np; j++) {
+      node_rtotal_dsp[j] = (j ? node_rtotal_dsp[j - 1] + node_total[2 * j - 1] : 0);
+      dst_offset[j] = node_rtotal_dsp[j];
+    }
+    node_rbuf.ReInit(roffset);
+    roffset = 0;
+    for (Integer m = 0; m < node_cnt; m++) {
+      for (Integer j = 0; j < node_np; j++) {
+        for (Integer k = node_dsp_[m]; k < node_dsp_[m + 1]; k++) {
+          const Long n = node_cnt_buf[2 * np * j + np + k];
+          if (n) memcopy(node_rbuf.begin() + dst_offset[j], lrbuf.begin() + roffset, n);
+          dst_offset[j] += n;
+          roffset += n;
+        }
+      }
+    }
+  }
+
+  Vector<Type> rbuf_(rtotal);
+  { // Scatter from the node leader
+    node_scnt.SetZero();
+    node_sdsp.SetZero();
+    node_rcnt.SetZero();
+    node_rdsp.SetZero();
+    node_rcnt[0] = rtotal;
+    if (is_leader) {
+      for (Integer j = 0; j < node_np; j++) {
+        node_scnt[j] = node_total[2 * j + 1];
+        node_sdsp[j] = node_rtotal_dsp[j];
+      }
+    }
+    void* mpi_req = node_comm_->Ialltoallv_sparse(node_rbuf.begin(), node_scnt.begin(), node_sdsp.begin(), rbuf_.begin(), node_rcnt.begin(), node_rdsp.begin(), 2);
+    node_comm_->Wait(mpi_req);
+  }
+  offset = 0;
+  for (Integer i = 0; i < np; i++) {
+    const Integer p = node_rank_lst_[i];
+    if (rcounts[p]) memcopy(rbuf + rdispls[p], rbuf_.begin() + offset, rcounts[p]);
+    offset += rcounts[p];
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+template <class Type> bool Comm::HierarchicalAllgatherv(ConstIterator<Type> sbuf, Long scount, Iterator<Type> rbuf, ConstIterator<Long> rcounts, ConstIterator<Long> rdispls) const {
+#ifdef SCTL_HAVE_MPI
+  const Integer node_cnt = (Integer)node_dsp_.size() - 1;
+  if (hier_node_size_ < 0 || node_cnt <= 1 || node_cnt == mpi_size_) return false;
+  const Integer np = mpi_size_;
+  const Integer node_np = node_comm_->Size();
+  const bool is_leader = (leader_comm_ != nullptr);
+  SCTL_ASSERT(scount == rcounts[mpi_rank_]);
+
+  // The gathered data is stored in node order (node_rank_lst_).
+  Vector<Long> rank_dsp(np + 1), node_rcnt_(node_cnt), node_rdsp_(node_cnt);
+  rank_dsp[0] = 0;
+  for (Integer i = 0; i < np; i++) rank_dsp[i + 1] = rank_dsp[i] + rcounts[node_rank_lst_[i]];
+  for (Integer m = 0; m < node_cnt; m++) {
+    node_rdsp_[m] = rank_dsp[node_dsp_[m]];
+    node_rcnt_[m] = rank_dsp[node_dsp_[m + 1]] - node_rdsp_[m];
+  }
+  const Long total = rank_dsp[np];
+  Vector<Type> buff(total);
+
+  { // Gather at the node leader and exchange between node leaders
+    Vector<Long> scnt(node_np), sdsp(node_np), rcnt(node_np), rdsp(node_np);
+    scnt.SetZero();
+    sdsp.SetZero();
+    rcnt.SetZero();
+    rdsp.SetZero();
+    scnt[0] = scount;
+    if (is_leader) {
+      for (Integer j = 0; j < node_np; j++) {
+        rcnt[j] = rcounts[node_rank_lst_[node_dsp_[node_id_] + j]];
+        rdsp[j] = rank_dsp[node_dsp_[node_id_] + j] - node_rdsp_[node_id_];
+      }
+    }
+    Vector<Type> node_buff(is_leader ? node_rcnt_[node_id_] : 0);
+    void* mpi_req = node_comm_->Ialltoallv_sparse(sbuf, scnt.begin(), sdsp.begin(), node_buff.begin(), rcnt.begin(), rdsp.begin(), 0);
+    node_comm_->Wait(mpi_req);
+    if (is_leader) leader_comm_->Allgatherv(node_buff.begin(), node_buff.Dim(), buff.begin(), node_rcnt_.begin(), node_rdsp_.begin());
+  }
+  node_comm_->Bcast(buff.begin(), total, 0);
+
+  for (Integer i = 0; i < np; i++) {
+    const Integer p = node_rank_lst_[i];
+    if (rcounts[p]) memcopy(rbuf + rdispls[p], buff.begin() + rank_dsp[i], rcounts[p]);
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
 template <class Type> void Comm::Allreduce(ConstIterator<Type> sbuf, Iterator<Type> rbuf, Long count, CommOp op) const {
   static_assert(std::is_trivially_copyable<Type>::value, "Data is not trivially copyable!");
 #ifdef SCTL_HAVE_MPI
@@ -902,10 +1196,10 @@ template <class Type> void Comm::Allreduce(ConstIterator<Type> sbuf, Iterator<Ty
   comm_detail::TouchBuffer(sbuf, count);
   comm_detail::TouchBuffer(rbuf, count);
 #if MPI_VERSION >= 4
-  comm_detail::TrackCollective(1, count * sizeof(Type));
+  comm_detail::TrackCollective(1, count * sizeof(Type), Metric::COMM_ALLREDUCE_BYTES);
   MPI_Allreduce_c(&sbuf[0], &rbuf[0], comm_detail::MPIAsCountLarge(count), CommDatatype<Type>::value(), mpi_op, mpi_comm_);
 #else
-  comm_detail::TrackCollective(comm_detail::MPINumChunks(count), count * sizeof(Type));
+  comm_detail::TrackCollective(comm_detail::MPINumChunks(count), count * sizeof(Type), Metric::COMM_ALLREDUCE_BYTES);
   for (Long offset = 0; offset < count; offset += comm_detail::MPIIntLimit()) {
     const Long chunk = std::min<Long>(count - offset, comm_detail::MPIIntLimit());
     MPI_Allreduce(&sbuf[offset], &rbuf[offset], comm_detail::MPIAsCount(chunk), CommDatatype<Type>::value(), mpi_op, mpi_comm_);
@@ -916,6 +1210,37 @@ template <class Type> void Comm::Allreduce(ConstIterator<Type> sbuf, Iterator<Ty
 #endif
 }
 
+template <class Type> void* Comm::Iallreduce(ConstIterator<Type> sbuf, Iterator<Type> rbuf, Long count, CommOp op) const {
+  static_assert(std::is_trivially_copyable<Type>::value, "Data is not trivially copyable!");
+#ifdef SCTL_HAVE_MPI
+  if (!count) return nullptr;
+  comm_detail::WarnIfMPIInactive("Comm::Iallreduce");
+  const MPI_Op mpi_op = GetMPIOp<Type>(op);
+  comm_detail::TouchBuffer(sbuf, count);
+  comm_detail::TouchBuffer(rbuf, count);
+#if MPI_VERSION >= 4
+  Vector<MPI_Request>& request = NewReq(1);
+  comm_detail::TrackCollective(1, count * sizeof(Type), Metric::COMM_ALLREDUCE_BYTES);
+  MPI_Iallreduce_c(&sbuf[0], &rbuf[0], comm_detail::MPIAsCountLarge(count), CommDatatype<Type>::value(), mpi_op, mpi_comm_, &request[0]);
+  return &request;
+#else
+  const Long request_count = comm_detail::MPINumChunks(count);
+  Vector<MPI_Request>& request = NewReq(request_count);
+  comm_detail::TrackCollective(request_count, count * sizeof(Type), Metric::COMM_ALLREDUCE_BYTES);
+  Long offset = 0;
+  for (Long i = 0; i < request_count; i++) {
+    const Long chunk = std::min<Long>(count - offset, comm_detail::MPIIntLimit());
+    MPI_Iallreduce(&sbuf[offset], &rbuf[offset], comm_detail::MPIAsCount(chunk), CommDatatype<Type>::value(), mpi_op, mpi_comm_, &request[i]);
+    offset += chunk;
+  }
+  return &request;
+#endif
+#else
+  memcopy((Iterator<char>)rbuf, (ConstIterator<char>)sbuf, count * sizeof(Type));
+  return nullptr;
+#endif
+}
+
 template <class Type> void Comm::Scan(ConstIterator<Type> sbuf, Iterator<Type> rbuf, Long count, CommOp op) const {
   static_assert(std::is_trivially_copyable<Type>::value, "Data is not trivially copyable!");
 #ifdef SCTL_HAVE_MPI
@@ -925,10 +1250,10 @@ template <class Type> void Comm::Scan(ConstIterator<Type> sbuf, Iterator<Type> r
   comm_detail::TouchBuffer(sbuf, count);
   comm_detail::TouchBuffer(rbuf, count);
 #if MPI_VERSION >= 4
-  comm_detail::TrackCollective(1, count * sizeof(Type));
+  comm_detail::TrackCollective(1, count * sizeof(Type), Metric::COMM_SCAN_BYTES);
   MPI_Scan_c(&sbuf[0], &rbuf[0], comm_detail::MPIAsCountLarge(count), CommDatatype<Type>::value(), mpi_op, mpi_comm_);
 #else
-  comm_detail::TrackCollective(comm_detail::MPINumChunks(count), count * sizeof(Type));
+  comm_detail::TrackCollective(comm_detail::MPINumChunks(count), count * sizeof(Type), Metric::COMM_SCAN_BYTES);
   for (Long offset = 0; offset < count; offset += comm_detail::MPIIntLimit()) {
     const Long chunk = std::min<Long>(count - offset, comm_detail::MPIIntLimit());
     MPI_Scan(&sbuf[offset], &rbuf[offset], comm_detail::MPIAsCount(chunk), CommDatatype<Type>::value(), mpi_op, mpi_comm_);
@@ -1017,8 +1342,10 @@ template <class Type> void Comm::PartitionW(Vector<Type>& nodeList, const Vector
   // perform All2All  ...
   Vector<Type> newNodes;
   newNodes.ReInit(recvSz[npes - 1] + recvOff[npes - 1]);
-  void* mpi_req = Ialltoallv_sparse<Type>(nodeList.begin(), sendSz.begin(), sendOff.begin(), newNodes.begin(), recvSz.begin(), recvOff.begin());
-  Wait(mpi_req);
+  if (!HierarchicalAlltoallv<Type>(nodeList.begin(), sendSz.begin(), sendOff.begin(), newNodes.begin(), recvSz.begin(), recvOff.begin())) {
+    void* mpi_req = Ialltoallv_sparse<Type>(nodeList.begin(), sendSz.begin(), sendOff.begin(), newNodes.begin(), recvSz.begin(), recvOff.begin());
+    Wait(mpi_req);
+  }
 
   // reset the pointer ...
   nodeList.Swap(newNodes);
@@ -1089,8 +1416,10 @@ template <class Type> void Comm::PartitionN(Vector<Type>& v, Long N) const {
     rdsp[0] = 0;
     omp_par::scan(rcnt.begin(), rdsp.begin(), np);
 
-    void* mpi_request = Ialltoallv_sparse(v.begin(), scnt.begin(), sdsp.begin(), v_.begin(), rcnt.begin(), rdsp.begin());
-    Wait(mpi_request);
+    if (!HierarchicalAlltoallv<Type>(v.begin(), scnt.begin(), sdsp.begin(), v_.begin(), rcnt.begin(), rdsp.begin())) {
+      void* mpi_request = Ialltoallv_sparse(v.begin(), scnt.begin(), sdsp.begin(), v_.begin(), rcnt.begin(), rdsp.begin());
+      Wait(mpi_request);
+    }
   }
   v.Swap(v_);
 }
@@ -1123,8 +1452,10 @@ template <class Type, class Compare> void Comm::PartitionS(Vector<Type>& nodeLis
   }
   {  // Redistribute nodeList
     Vector<Type> nodeList_(rdsp[npes - 1] + rcnt[npes - 1]);
-    void* mpi_request = Ialltoallv_sparse(nodeList.begin(), scnt.begin(), sdsp.begin(), nodeList_.begin(), rcnt.begin(), rdsp.begin());
-    Wait(mpi_request);
+    if (!HierarchicalAlltoallv<Type>(nodeList.begin(), scnt.begin(), sdsp.begin(), nodeList_.begin(), rcnt.begin(), rdsp.begin())) {
+      void* mpi_request = Ialltoallv_sparse(nodeList.begin(), scnt.begin(), sdsp.begin(), nodeList_.begin(), rcnt.begin(), rdsp.begin());
+      Wait(mpi_request);
+    }
     nodeList.Swap(nodeList_);
   }
 }
@@ -1592,6 +1923,10 @@ inline Vector<MPI_Request>& Comm::NewReq(Long request_count) const {
 
 inline void Comm::Init(const MPI_Comm mpi_comm) {
   comm_detail::WarnIfMPIInactive("Comm::Init");
+  hier_node_size_ = -1;
+  node_comm_.reset();
+  leader_comm_.reset();
+  node_id_ = 0;
   #pragma omp critical(SCTL_COMM_DUP)
   MPI_Comm_dup(mpi_comm, &mpi_comm_);
   MPI_Comm_rank(mpi_comm_, &mpi_rank_);
@@ -1840,6 +2175,182 @@ template <class Type, class Compare> void Comm::HyperQuickSort(const Vector<Type
 #endif
 }
 
+template <class Type, class Compare> void Comm::SampleSort(const Vector<Type>& arr_, Vector<Type>& SortedElem, Compare comp, Integer oversample) const {
+  static_assert(std::is_trivially_copyable<Type>::value, "Data is not trivially copyable!");
+  SCTL_ASSERT(oversample > 0);
+  SortedElem = arr_;
+  omp_par::merge_sort(SortedElem.begin(), SortedElem.end(), comp);
+#ifdef SCTL_HAVE_MPI
+  const Integer npes = Size();
+  const Integer omp_p = omp_get_max_threads();
+  if (npes == 1) return;
+
+  const Long nelem = SortedElem.Dim();
+  Vector<Long> glb_nelem(npes);
+  Allgather(Ptr2ConstItr<Long>(&nelem, 1), 1, glb_nelem.begin(), 1);
+  const Long totSize = omp_par::reduce(glb_nelem.begin(), npes);
+  if (!totSize) return;
+
+  Vector<Type> arr;
+  arr.Swap(SortedElem);
+
+  // Send arr[sdsp[p]], ..., arr[sdsp[p+1]-1] to process p, then merge the received sorted runs and load-balance.
+  const auto exchange = [this, &arr, &SortedElem, &comp, npes, omp_p](const Vector<Long>& sdsp) {
+    Vector<Long> scnt(npes), rcnt(npes), rdsp(npes + 1);
+    for (Integer p = 0; p < npes; p++) scnt[p] = sdsp[p + 1] - sdsp[p];
+    Alltoall(scnt.begin(), 1, rcnt.begin(), 1);
+    rdsp[0] = 0;
+    omp_par::scan(rcnt.begin(), rdsp.begin(), npes + 1);
+
+    Vector<Type> buff(rdsp[npes]), buff_;
+    Alltoallv(arr.begin(), scnt.begin(), sdsp.begin(), buff.begin(), rcnt.begin(), rdsp.begin());
+    arr.ReInit(0);
+
+    std::vector<Long> run_dsp;  // boundaries of the non-empty runs
+    for (Integer p = 0; p < npes; p++) {
+      if (rcnt[p]) run_dsp.push_back(rdsp[p]);
+    }
+    run_dsp.push_back(rdsp[npes]);
+    if (run_dsp.size() > 2) buff_.ReInit(buff.Dim());
+    while (run_dsp.size() > 2) {  // Pairwise merge of sorted runs
+      const Long Nruns = (Long)run_dsp.size() - 1;
+      for (Long i = 0; i + 1 < Nruns; i += 2) {
+        omp_par::merge<ConstIterator<Type>>(buff.begin() + run_dsp[i], buff.begin() + run_dsp[i + 1], buff.begin() + run_dsp[i + 1], buff.begin() + run_dsp[i + 2], buff_.begin() + run_dsp[i], omp_p, comp);
+      }
+      if (Nruns % 2) memcopy(buff_.begin() + run_dsp[Nruns - 1], buff.begin() + run_dsp[Nruns - 1], run_dsp[Nruns] - run_dsp[Nruns - 1]);
+      const Long Nruns_ = (Nruns + 1) / 2;
+      for (Long i = 0; i < Nruns_; i++) run_dsp[i] = run_dsp[2 * i];
+      run_dsp[Nruns_] = run_dsp[Nruns];
+      run_dsp.resize(Nruns_ + 1);
+      buff.Swap(buff_);
+    }
+
+    SortedElem.Swap(buff);
+    PartitionW<Type>(SortedElem);
+  };
+
+  Vector<Long> sdsp(npes + 1);
+  {  // Gradual rebalancing: use the current partition boundaries as splitters when the input is nearly sorted
+    Vector<Type> glb_min(npes);
+    {
+      Type lmin = (nelem ? arr[0] : Type());
+      Allgather(Ptr2ConstItr<Type>(&lmin, 1), 1, glb_min.begin(), 1);
+    }
+
+    // Process p accepts elements not less than the largest local minimum of the non-empty processes up to p.
+    Integer first = 0;
+    while (!glb_nelem[first]) first++;
+    Type splitter = glb_min[first];
+    for (Integer p = 0; p < npes; p++) {
+      sdsp[p] = 0;
+      if (p > first && glb_nelem[p]) {
+        if (comp(splitter, glb_min[p])) splitter = glb_min[p];
+        sdsp[p] = std::lower_bound(arr.begin(), arr.end(), splitter, comp) - arr.begin();
+      }
+    }
+    sdsp[npes] = nelem;
+    for (Integer p = npes - 1; p > first; p--) {  // empty processes receive nothing
+      if (!glb_nelem[p]) sdsp[p] = sdsp[p + 1];
+    }
+    const Integer rank = Rank();
+    const Long moved = nelem - (sdsp[rank + 1] - sdsp[rank]);
+
+    Long glb_moved = 0;
+    Allreduce(Ptr2ConstItr<Long>(&moved, 1), Ptr2Itr<Long>(&glb_moved, 1), 1, CommOp::SUM);
+    if (glb_moved * 8 <= totSize) {
+      exchange(sdsp);
+      return;
+    }
+  }
+
+  {  // Sample sort: choose splitters by regular sampling
+    Vector<Long> smpl_cnt(npes), smpl_dsp(npes + 1);
+    for (Integer p = 0; p < npes; p++) smpl_cnt[p] = std::min<Long>(oversample, glb_nelem[p]);
+    smpl_dsp[0] = 0;
+    omp_par::scan(smpl_cnt.begin(), smpl_dsp.begin(), npes + 1);
+
+    const Integer rank = Rank();
+    Vector<Type> smpl(smpl_cnt[rank]), glb_smpl(smpl_dsp[npes]);
+    for (Long i = 0; i < smpl.Dim(); i++) {  // sample i represents arr[i*nelem/s], ..., arr[(i+1)*nelem/s-1]
+      smpl[i] = arr[(i * nelem) / smpl.Dim()];
+    }
+    Allgatherv(smpl.begin(), smpl.Dim(), glb_smpl.begin(), smpl_cnt.begin(), smpl_dsp.begin());
+
+    const Long Nsmpl = glb_smpl.Dim();
+    Vector<Long> smpl_wt(Nsmpl), smpl_idx(Nsmpl);
+    for (Integer p = 0; p < npes; p++) {
+      for (Long i = 0; i < smpl_cnt[p]; i++) {
+        smpl_wt[smpl_dsp[p] + i] = ((i + 1) * glb_nelem[p]) / smpl_cnt[p] - (i * glb_nelem[p]) / smpl_cnt[p];
+      }
+    }
+    for (Long i = 0; i < Nsmpl; i++) smpl_idx[i] = i;
+    omp_par::merge_sort(smpl_idx.begin(), smpl_idx.end(), [&glb_smpl, &comp](const Long a, const Long b) { return comp(glb_smpl[a], glb_smpl[b]); });
+
+    // Splitter for process p is the sample at which the cumulative weight reaches p*totSize/npes.
+    sdsp[0] = 0;
+    Long wt = 0, j = 0;
+    for (Integer p = 1; p < npes; p++) {
+      const Long target = (totSize * p) / npes;
+      while (j < Nsmpl - 1 && wt + smpl_wt[smpl_idx[j]] <= target) wt += smpl_wt[smpl_idx[j++]];
+      sdsp[p] = std::lower_bound(arr.begin(), arr.end(), glb_smpl[smpl_idx[j]], comp) - arr.begin();
+    }
+    sdsp[npes] = nelem;
+  }
+  exchange(sdsp);
+#endif
+}
+
+// Metrics reduction (defined here rather than in metrics.txx, which comm.txx includes for Metrics::Record)
+
+inline void Metrics::StartReduce(const Comm& comm) {
+  FinishReduce();
+  ReduceData& r = GetReduceData();
+  const std::vector<double> slots = Collect();
+
+  r.sbuf_sum = slots;
+  r.sbuf_min.resize(2 * Nmetric);
+  r.sbuf_max.resize(2 * Nmetric);
+  for (Long i = 0; i < Nmetric; i++) {
+    r.sbuf_min[i] = slots[i * SLOT_SIZE + 2];
+    r.sbuf_max[i] = slots[i * SLOT_SIZE + 3];
+    r.sbuf_min[Nmetric + i] = slots[i * SLOT_SIZE + 1];
+    r.sbuf_max[Nmetric + i] = slots[i * SLOT_SIZE + 1];
+  }
+  r.rbuf_sum.resize(r.sbuf_sum.size());
+  r.rbuf_min.resize(r.sbuf_min.size());
+  r.rbuf_max.resize(r.sbuf_max.size());
+
+  r.comm = &comm;
+  r.rank = comm.Rank();
+  r.comm_size = comm.Size();
+  r.req[0] = comm.Iallreduce(Ptr2ConstItr<double>(r.sbuf_sum.data(), (Long)r.sbuf_sum.size()), Ptr2Itr<double>(r.rbuf_sum.data(), (Long)r.rbuf_sum.size()), (Long)r.sbuf_sum.size(), CommOp::SUM);
+  r.req[1] = comm.Iallreduce(Ptr2ConstItr<double>(r.sbuf_min.data(), (Long)r.sbuf_min.size()), Ptr2Itr<double>(r.rbuf_min.data(), (Long)r.rbuf_min.size()), (Long)r.sbuf_min.size(), CommOp::MIN);
+  r.req[2] = comm.Iallreduce(Ptr2ConstItr<double>(r.sbuf_max.data(), (Long)r.sbuf_max.size()), Ptr2Itr<double>(r.rbuf_max.data(), (Long)r.rbuf_max.size()), (Long)r.sbuf_max.size(), CommOp::MAX);
+  r.pending = true;
+}
+
+inline void Metrics::FinishReduce() {
+  ReduceData& r = GetReduceData();
+  if (!r.pending) return;
+  for (Integer k = 0; k < 3; k++) {
+    r.comm->Wait(r.req[k]);
+    r.req[k] = nullptr;
+  }
+
+  r.result = r.rbuf_sum;
+  r.rank_sum.resize(3 * Nmetric);
+  for (Long i = 0; i < Nmetric; i++) {
+    r.result[i * SLOT_SIZE + 2] = r.rbuf_min[i];
+    r.result[i * SLOT_SIZE + 3] = r.rbuf_max[i];
+    r.rank_sum[i * 3 + 0] = r.rbuf_min[Nmetric + i];
+    r.rank_sum[i * 3 + 1] = r.result[i * SLOT_SIZE + 1] / r.comm_size;
+    r.rank_sum[i * 3 + 2] = r.rbuf_max[Nmetric + i];
+  }
+  r.comm = nullptr;
+  r.pending = false;
+  r.ready = true;
+}
+
 }  // end namespace
 
 #endif // _SCTL_COMM_TXX_
@@ -22,7 +22,19 @@
 #define SCTL_PROFILE -1 // Granularity level
 #endif
 
-#if defined(__AVX512__) || defined(__AVX512F__)
+// Fixed-length scalable vectors (compile with -msve-vector-bits=<bits> or -mrvv-vector-bits=zvl)
+#if defined(__ARM_FEATURE_SVE) && defined(__ARM_FEATURE_SVE_BITS) && __ARM_FEATURE_SVE_BITS >= 256
+  #define SCTL_SVE_BITS __ARM_FEATURE_SVE_BITS
+#endif
+#if defined(__riscv_v) && defined(__riscv_v_fixed_vlen) && __riscv_v_fixed_vlen >= 128
+  #define SCTL_RVV_BITS __riscv_v_fixed_vlen
+#endif
+
+#if defined(SCTL_SVE_BITS)
+  #define SCTL_ALIGN_BYTES (SCTL_SVE_BITS/8)
+#elif defined(SCTL_RVV_BITS)
+  #define SCTL_ALIGN_BYTES (SCTL_RVV_BITS/8)
+#elif defined(__AVX512__) || defined(__AVX512F__)
   #define SCTL_ALIGN_BYTES 64
 #elif defined(__AVX__)
   #define SCTL_ALIGN_BYTES 32
@@ -39,6 +51,30 @@
 #ifndef SCTL_GLOBAL_MEM_BUFF
 #define SCTL_GLOBAL_MEM_BUFF 1024LL * 0LL  // in MB
 #endif
+#ifndef SCTL_MEM_THREAD_CACHE
+#define SCTL_MEM_THREAD_CACHE 1024LL  // largest block cached per-thread, in KB (0 to disable)
+#endif
+#ifndef SCTL_FIRST_TOUCH
+#define SCTL_FIRST_TOUCH 0LL  // smallest Vector/Matrix initialized with parallel first-touch, in KB (0 to disable)
+#endif
+#ifndef SCTL_GEMM_NATIVE_MAX
+#define SCTL_GEMM_NATIVE_MAX 262144LL  // largest M*N*K for which mat::gemm uses the native kernel instead of BLAS (with SCTL_HAVE_BLAS)
+#endif
+#ifndef SCTL_GEMM_PARALLEL_MIN
+#define SCTL_GEMM_PARALLEL_MIN 2097152LL  // smallest M*N*K for which the native mat::gemm is parallelized with OpenMP
+#endif
+#ifndef SCTL_RADIX_SORT_MIN
+#define SCTL_RADIX_SORT_MIN 2048LL  // smallest array sorted with omp_par::radix_sort instead of a comparison sort
+#endif
+#ifndef SCTL_CHEB_DCT_MIN_ORDER
+#define SCTL_CHEB_DCT_MIN_ORDER 16  // smallest order for which ChebBasis uses DCTs (through FFT) instead of dense matrices
+#endif
+#ifndef SCTL_KERNEL_FLOAT_MAX_DIGITS
+#define SCTL_KERNEL_FLOAT_MAX_DIGITS 6  // largest digits for which double-precision kernels are evaluated in single precision (-1 to disable)
+#endif
+#ifndef SCTL_OMP_TARGET_MIN_INTERAC
+#define SCTL_OMP_TARGET_MIN_INTERAC 1048576LL  // smallest number of source-target pairs evaluated on the device (with SCTL_HAVE_OMP_TARGET)
+#endif
 
 namespace sctl {
 typedef long Integer;  // bounded numbers < 32k
@@ -0,0 +1,141 @@
+#ifndef _SCTL_CPU_DISPATCH_HPP_
+#define _SCTL_CPU_DISPATCH_HPP_
+
+#include "sctl/common.hpp"  // for Integer, Long, sctl
+
+namespace sctl {
+
+/**
+ * Instruction set architectures for which kernels can be compiled separately and selected at
+ * runtime. Within each processor family, a larger value implies support for all smaller values.
+ */
+enum class CPUArch {
+  DEFAULT = 0,  ///< no SIMD extensions assumed
+  SSE4_2 = 1,   ///< x86-64 with SSE4.2
+  AVX2 = 2,     ///< x86-64 with AVX2 and FMA
+  AVX512 = 3,   ///< x86-64 with AVX512-F, DQ, BW and VL
+  NEON = 16     ///< AArch64 with NEON
+};
+
+/**
+ * Runtime detection of the host CPU architecture. This is used to select, when the program
+ * starts, the fastest variant of the kernels compiled for multiple instruction sets (see
+ * `SCTL_CPU_DISPATCH_KERNEL`).
+ *
+ * The detected architecture can be capped by setting the environment variable `SCTL_CPU_ARCH` to
+ * one of the names returned by `Name()` (e.g. `SCTL_CPU_ARCH=avx2`).
+ */
+class CPUDispatch {
+  public:
+
+    /**
+     * Returns the architecture targeted by the compiler flags of the current translation unit.
+     */
+    static constexpr CPUArch CompiledArch();
+
+    /**
+     * Returns the architecture of the host CPU, detected once at runtime.
+     */
+    static CPUArch HostArch();
+
+    /**
+     * Returns true if code compiled for `arch` can be run on the host CPU.
+     */
+    static bool Supported(CPUArch arch);
+
+    /**
+     * Returns a short name for the architecture (e.g. "avx512").
+     */
+    static const char* Name(CPUArch arch);
+
+    /**
+     * Returns `CompiledArch()` of the translation unit whose copy of this (non-inlined) function was kept by the
+     * linker. When the symbols of the objects compiled for other architectures were not made local, the linker
+     * merges them with the baseline code and this differs from `CompiledArch()` in some of them; dispatch is then
+     * disabled since the baseline code could end up running instructions that the host does not support.
+     */
+    static CPUArch LinkedArch();
+
+  private:
+
+    static CPUArch DetectArch();
+};
+
+/**
+ * Table of raw entry points of a kernel object compiled for a specific architecture. These are
+ * used by `GenericKernel` to forward evaluations to the selected variant. Only plain pointers
+ * cross the boundary, so that each variant uses its own instantiations (and memory manager)
+ * internally.
+ *
+ * @tparam Real The type of the real numbers used.
+ */
+template <class Real> struct KernelDispatch {
+  using EvalFn = void (*)(Real* v_trg, const Real* r_trg, Long Nt, const Real* r_src, const Real* n_src, Long Ns, const Real* v_src, Long Nd, Integer digits, const void* ctx_ptr);
+  using KernelMatrixFn = void (*)(Real* M, const Real* Xt, Long Nt, const Real* Xs, const Real* Xn, Long Ns, Integer digits, const void* ctx_ptr);
+
+  CPUArch arch = CPUArch::DEFAULT;
+  EvalFn eval[2] = {nullptr, nullptr};  // indexed by enable_openmp
+  KernelMatrixFn kernel_matrix[2] = {nullptr, nullptr};  // indexed by enable_openmp
+};
+
+}  // end namespace
+
+#define SCTL_CPU_DISPATCH_ARCH_sse4_2 sctl::CPUArch::SSE4_2
+#define SCTL_CPU_DISPATCH_ARCH_avx2 sctl::CPUArch::AVX2
+#define SCTL_CPU_DISPATCH_ARCH_avx512 sctl::CPUArch::AVX512
+
+#define SCTL_CPU_DISPATCH_CAT_(a, b) a##b
+#define SCTL_CPU_DISPATCH_CAT(a, b) SCTL_CPU_DISPATCH_CAT_(a, b)
+#define SCTL_CPU_DISPATCH_ENTRY(name, arch) SCTL_CPU_DISPATCH_CAT(sctl_cpu_dispatch_##name##_, arch)
+
+/**
+ * Register a kernel object (a `GenericKernel` type) for runtime CPU dispatch. The macro must be
+ * used at global scope in a translation unit which is compiled once with the baseline flags and
+ * once for each target architecture with `-DSCTL_CPU_DISPATCH_TARGET=<arch>` (one of `sse4_2`,
+ * `avx2`, `avx512`) and the corresponding instruction set flags.
+ *
+ * In the target builds, it defines the global entry point `sctl_cpu_dispatch_<name>_<arch>`; all
+ * other symbols of these objects must be made local (see `src/kernel-dispatch.cpp` and the
+ * `CPU_DISPATCH` option in the Makefile, which uses `objcopy --keep-global-symbol`). This is a
+ * link-time requirement: otherwise the template instantiations (including those of the standard
+ * library) compiled for the target architecture are shared with the baseline code. Other build
+ * systems must apply the same step, e.g. with `objcopy` or `ld -r` and a linker version script.
+ * In the baseline build, it registers the fastest variant supported by the host CPU when the
+ * program starts. Variants that are not linked are ignored, and if the symbols were not made
+ * local, a warning is printed and the baseline code is used.
+ *
+ * @param name An identifier used to name the entry points.
+ * @param KerType The kernel type (e.g. `sctl::Laplace3D_FxU`).
+ */
+#ifdef SCTL_CPU_DISPATCH_TARGET
+#define SCTL_CPU_DISPATCH_KERNEL(name, KerType) \
+  static_assert(sctl::CPUDispatch::CompiledArch() == SCTL_CPU_DISPATCH_CAT(SCTL_CPU_DISPATCH_ARCH_, SCTL_CPU_DISPATCH_TARGET), "compiler flags do not match SCTL_CPU_DISPATCH_TARGET"); \
+  extern "C" bool SCTL_CPU_DISPATCH_ENTRY(name, SCTL_CPU_DISPATCH_TARGET)(sctl::KernelDispatch<float>* f, sctl::KernelDispatch<double>* d) { \
+    if (sctl::CPUDispatch::LinkedArch() != sctl::CPUDispatch::CompiledArch()) return false; \
+    KerType::DispatchInit(*f); \
+    KerType::DispatchInit(*d); \
+    return true; \
+  }
+#elif defined(__GNUC__) && defined(__ELF__)
+#define SCTL_CPU_DISPATCH_KERNEL(name, KerType) \
+  extern "C" bool sctl_cpu_dispatch_##name##_sse4_2(sctl::KernelDispatch<float>*, sctl::KernelDispatch<double>*) __attribute__((weak)); \
+  extern "C" bool sctl_cpu_dispatch_##name##_avx2(sctl::KernelDispatch<float>*, sctl::KernelDispatch<double>*) __attribute__((weak)); \
+  extern "C" bool sctl_cpu_dispatch_##name##_avx512(sctl::KernelDispatch<float>*, sctl::KernelDispatch<double>*) __attribute__((weak)); \
+  static const bool sctl_cpu_dispatch_##name##_init = [](){ \
+    using EntryFn = bool (*)(sctl::KernelDispatch<float>*, sctl::KernelDispatch<double>*); \
+    const EntryFn entry[3] = {sctl_cpu_dispatch_##name##_avx512, sctl_cpu_dispatch_##name##_avx2, sctl_cpu_dispatch_##name##_sse4_2}; \
+    const sctl::CPUArch arch[3] = {sctl::CPUArch::AVX512, sctl::CPUArch::AVX2, sctl::CPUArch::SSE4_2}; \
+    for (sctl::Integer i = 0; i < 3; i++) { \
+      if (entry[i] && sctl::CPUDispatch::Supported(arch[i]) && arch[i] > sctl::CPUDispatch::CompiledArch()) { \
+        if (sctl::CPUDispatch::LinkedArch() == sctl::CPUDispatch::CompiledArch() && entry[i](&KerType::DispatchTable<float>(), &KerType::DispatchTable<double>())) return true; \
+        SCTL_WARN("CPU dispatch disabled for " #name ": the symbols of the dispatch objects must be made local (see SCTL_CPU_DISPATCH_KERNEL)."); \
+        return false; \
+      } \
+    } \
+    return false; \
+  }();
+#else
+#define SCTL_CPU_DISPATCH_KERNEL(name, KerType)
+#endif
+
+#endif // _SCTL_CPU_DISPATCH_HPP_
@@ -0,0 +1,86 @@
+#ifndef _SCTL_CPU_DISPATCH_TXX_
+#define _SCTL_CPU_DISPATCH_TXX_
+
+#include <cstdlib>                // for getenv
+#include <cstring>                // for strcmp
+
+#include "sctl/common.hpp"        // for Integer, SCTL_WARN, sctl
+#include "sctl/cpu-dispatch.hpp"  // for CPUDispatch, CPUArch
+
+namespace sctl {
+
+  constexpr CPUArch CPUDispatch::CompiledArch() {
+    #if defined(__AVX512F__) && defined(__AVX512DQ__) && defined(__AVX512BW__) && defined(__AVX512VL__)
+    return CPUArch::AVX512;
+    #elif defined(__AVX2__) && defined(__FMA__)
+    return CPUArch::AVX2;
+    #elif defined(__SSE4_2__)
+    return CPUArch::SSE4_2;
+    #elif defined(__ARM_NEON)
+    return CPUArch::NEON;
+    #else
+    return CPUArch::DEFAULT;
+    #endif
+  }
+
+  inline CPUArch CPUDispatch::HostArch() {
+    static const CPUArch arch = DetectArch();
+    return arch;
+  }
+
+  inline bool CPUDispatch::Supported(CPUArch arch) {
+    const CPUArch host = HostArch();
+    if (arch == CPUArch::DEFAULT) return true;
+    if ((arch >= CPUArch::NEON) != (host >= CPUArch::NEON)) return false; // different processor family
+    return arch <= host;
+  }
+
+  inline const char* CPUDispatch::Name(CPUArch arch) {
+    switch (arch) {
+      case CPUArch::DEFAULT: return "default";
+      case CPUArch::SSE4_2: return "sse4_2";
+      case CPUArch::AVX2: return "avx2";
+      case CPUArch::AVX512: return "avx512";
+      case CPUArch::NEON: return "neon";
+    }
+    return "unknown";
+  }
+
+  #if defined(__GNUC__)
+  __attribute__((noinline))
+  #endif
+  inline CPUArch CPUDispatch::LinkedArch() {
+    return CompiledArch();
+  }
+
+  inline CPUArch CPUDispatch::DetectArch() {
+    CPUArch arch = CPUArch::DEFAULT;
+    #if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) arch = CPUArch::SSE4_2;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) arch = CPUArch::AVX2;
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl")) arch = CPUArch::AVX512;
+    #elif defined(__aarch64__)
+    arch = CPUArch::NEON;
+    #else
+    arch = CompiledArch();
+    #endif
+
+    const char* env = getenv("SCTL_CPU_ARCH");
+    if (env) { // cap the architecture
+      const CPUArch arch_list[] = {CPUArch::DEFAULT, CPUArch::SSE4_2, CPUArch::AVX2, CPUArch::AVX512, CPUArch::NEON};
+      bool found = false;
+      for (const auto a : arch_list) {
+        if (!strcmp(env, Name(a))) {
+          if (a == CPUArch::DEFAULT || ((a >= CPUArch::NEON) == (arch >= CPUArch::NEON) && a < arch)) arch = a;
+          found = true;
+        }
+      }
+      if (!found) SCTL_WARN("unknown value for SCTL_CPU_ARCH; ignoring.");
+    }
+    return arch;
+  }
+
+}  // end namespace
+
+#endif // _SCTL_CPU_DISPATCH_TXX_
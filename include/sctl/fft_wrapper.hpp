@@ -1,6 +1,9 @@
 #ifndef _SCTL_FFT_WRAPPER_HPP_
 #define _SCTL_FFT_WRAPPER_HPP_
 
+#include <memory>                 // for unique_ptr
+#include <string>                 // for string
+
 #include "sctl/common.hpp"        // for Long, Integer, sctl
 #include "sctl/complex.hpp"       // for Complex
 #include "sctl/static-array.hpp"  // for StaticArray
@@ -14,21 +17,38 @@
 
 namespace sctl {
 
+  class Comm;
   template <class ValueType> class Vector;
 
   template <class ValueType> struct FFTPlan;
+  template <class ValueType> struct FFTDistPlan;
 
   /**
    * Enum class representing different types of FFT transformations.
    */
   enum class FFT_Type {R2C, C2C, C2C_INV, C2R};
 
+  /**
+   * Enum class representing the planning rigor for FFTW plans (FFTW_ESTIMATE, FFTW_MEASURE, FFTW_PATIENT and
+   * FFTW_EXHAUSTIVE). Higher rigor gives faster plans but takes longer to plan.
+   */
+  enum class FFT_Rigor {ESTIMATE, MEASURE, PATIENT, EXHAUSTIVE};
+
   /**
    * Wrapper class for the FFTW library.  It uses FFTW for double precision calculation when linked
    * with `libfftw3` and the macro `SCTL_HAVE_FFTW` is defined. Similarly, for single precision and
    * long double precision computations, the macros `SCTL_HAVE_FFTWF` and `SCTL_HAVE_FFTWL` must be
-   * defined and the code must be linked with `libfftw3f` and `libfftw3l`. If setup in this way, it
-   * computes Fourier transform directly and will have lower performance.
+   * defined and the code must be linked with `libfftw3f` and `libfftw3l`. Otherwise, it uses a native
+   * mixed-radix (2, 3, 4, 5 and generic small prime) Stockham FFT, with Bluestein's algorithm for lengths having
+   * large prime factors, vectorized across the transforms using Vec. This is slower than FFTW but still requires
+   * O(N log N) work and also supports quad-precision.
+   *
+   * The transforms can also be distributed over the processes of a communicator (see the second form of Setup) using
+   * a slab decomposition. The input and the output arrays are partitioned along the first dimension and the data is
+   * transposed with sparse non-blocking all-to-all exchanges, which are pipelined with the local 1D transforms.
+   *
+   * FFTW plans are kept in a process-wide cache and are shared by all FFT objects with the same type, dimensions,
+   * howmany, number of threads and planning rigor; so that repeated calls to Setup for the same sizes do not plan again.
    *
    * @tparam ValueType The value type of the FFT data.
    */
@@ -65,6 +85,67 @@ namespace sctl {
      */
     void Setup(FFT_Type fft_type, Long howmany, const Vector<Long>& dim_vec, Integer Nthreads = 1);
 
+    /**
+     * Setup a distributed FFT operator. The first dimension (of length dim_vec[0]) of each of the howmany input and
+     * output arrays is partitioned between the processes in contiguous blocks; each process owns the indices in
+     * [LocalStart(), LocalStart() + LocalSize()) and the data on each process is stored in the same order as for the
+     * non-distributed transform restricted to these indices. Therefore, Dim(0) and Dim(1) are the local dimensions.
+     * The result is the same as for the non-distributed transform. Requires at least two dimensions.
+     *
+     * @param[in] fft_type The type of transform.
+     *
+     * @param[in] howmany Number of transforms to compute.
+     *
+     * @param[in] dim_vec Dimensions of the (global) input data.
+     *
+     * @param[in] comm Communicator for the distributed transform.
+     *
+     * @param[in] Nthreads Number of threads for the local transforms (default is 1).
+     */
+    void Setup(FFT_Type fft_type, Long howmany, const Vector<Long>& dim_vec, const Comm& comm, Integer Nthreads = 1);
+
+    /**
+     * @return Offset of the local part of the first dimension of the data (zero if not distributed).
+     */
+    Long LocalStart() const;
+
+    /**
+     * @return Length of the local part of the first dimension of the data (dim_vec[0] if not distributed).
+     */
+    Long LocalSize() const;
+
+    /**
+     * Set the planning rigor for the FFTW plans created by subsequent calls to Setup (default FFT_Rigor::ESTIMATE).
+     * This is a process-wide setting for each ValueType, and it has no effect without FFTW.
+     *
+     * @param[in] rigor The planning rigor.
+     */
+    static void SetPlanRigor(FFT_Rigor rigor);
+
+    /**
+     * @return The planning rigor for FFTW plans.
+     */
+    static FFT_Rigor GetPlanRigor();
+
+    /**
+     * Import FFTW wisdom (accumulated from planning with higher rigor in a previous run) from a file, so that the
+     * plans with the same parameters are created without measuring again.
+     *
+     * @param[in] fname The file name.
+     *
+     * @return true on success (false on failure or without FFTW).
+     */
+    static bool ImportWisdom(const std::string& fname);
+
+    /**
+     * Export the accumulated FFTW wisdom to a file (usually from only one process).
+     *
+     * @param[in] fname The file name.
+     *
+     * @return true on success (false on failure or without FFTW).
+     */
+    static bool ExportWisdom(const std::string& fname);
+
     /**
      * Execute the FFT transform.
      *
@@ -83,12 +164,18 @@ namespace sctl {
 
     //static void check_align(const Vector<ValueType>& in, const Vector<ValueType>& out);
 
+    static FFT_Rigor& plan_rigor();
+
+    void ExecuteDist(const Vector<ValueType>& in, Vector<ValueType>& out) const;
+
     FFTPlan<ValueType> plan;
     bool copy_input;
+    std::unique_ptr<FFTDistPlan<ValueType>> dist_plan; // null if not distributed
 
     StaticArray<Long,2> dim; // operator dimensions
     FFT_Type fft_type; // type of FFT transform
     Long howmany_; // number of transforms
+    StaticArray<Long,2> local_range; // offset and length of the local part of the first dimension
   };
 
 }  // end namespace
@@ -2,9 +2,16 @@
 #define _SCTL_FFT_WRAPPER_TXX_
 
 #include <algorithm>              // for max
+#include <functional>             // for function
 #include <iostream>               // for basic_ostream, operator<<, cout
+#include <map>                    // for map
+#include <string>                 // for string
+#include <type_traits>            // for integral_constant
+#include <utility>                // for make_pair
 #include <vector>                 // for vector
 
+#include "sctl/comm.hpp"          // for Comm
+#include "sctl/comm.txx"          // for Comm::Ialltoallv_sparse, Comm::Wait
 #include "sctl/common.hpp"        // for Long, Integer, SCTL_ASSERT, SCTL_AS...
 #include "sctl/fft_wrapper.hpp"   // for FFT, FFT_Type
 #include "sctl/iterator.hpp"      // for Iterator, ConstIterator
@@ -14,6 +21,8 @@
 #include "sctl/matrix.hpp"        // for Matrix
 #include "sctl/static-array.hpp"  // for StaticArray
 #include "sctl/static-array.txx"  // for StaticArray::operator[], StaticArra...
+#include "sctl/vec.hpp"           // for Vec, DefaultVecLen
+#include "sctl/vec.txx"           // for Vec::LoadAligned, Vec::StoreAligned
 #include "sctl/vector.hpp"        // for Vector
 #include "sctl/vector.txx"        // for Vector::operator[], Vector::PushBack
 
@@ -26,38 +35,67 @@ namespace sctl {
       return max_val;
     };
 
-    Vector<Long> fft_dim;
-    fft_dim.PushBack(2);
-    fft_dim.PushBack(5);
-    fft_dim.PushBack(3);
+    Vector<Long> fft_dim0, fft_dim1; // the second one has a large prime factor (Bluestein's algorithm without FFTW)
+    fft_dim0.PushBack(2);
+    fft_dim0.PushBack(5);
+    fft_dim0.PushBack(3);
+    fft_dim1.PushBack(4);
+    fft_dim1.PushBack(37);
     Long howmany = 3;
 
-    { // R2C, C2R
-      FFT myfft0, myfft1;
-      myfft0.Setup(FFT_Type::R2C, howmany, fft_dim);
-      myfft1.Setup(FFT_Type::C2R, howmany, fft_dim);
-      Vector<ValueType> v0(myfft0.Dim(0)), v1, v2;
-      for (int i = 0; i < v0.Dim(); i++) v0[i] = (1 + i) / (ValueType)v0.Dim();
-      myfft0.Execute(v0, v1);
-      myfft1.Execute(v1, v2);
+    for (const auto& fft_dim : {fft_dim0, fft_dim1}) {
+      { // R2C, C2R
+        FFT myfft0, myfft1;
+        myfft0.Setup(FFT_Type::R2C, howmany, fft_dim);
+        myfft1.Setup(FFT_Type::C2R, howmany, fft_dim);
+        Vector<ValueType> v0(myfft0.Dim(0)), v1, v2;
+        for (int i = 0; i < v0.Dim(); i++) v0[i] = (1 + i) / (ValueType)v0.Dim();
+        myfft0.Execute(v0, v1);
+        myfft1.Execute(v1, v2);
 
-      const auto err = inf_norm(v2-v0);
-      std::cout<<"Error : "<<err<<'\n';
-      SCTL_ASSERT(err < machine_eps<ValueType>() * 64);
+        const auto err = inf_norm(v2-v0);
+        std::cout<<"Error : "<<err<<'\n';
+        SCTL_ASSERT(err < machine_eps<ValueType>() * 64);
+      }
+
+      { // C2C, C2C_INV
+        FFT myfft0, myfft1;
+        myfft0.Setup(FFT_Type::C2C, howmany, fft_dim);
+        myfft1.Setup(FFT_Type::C2C_INV, howmany, fft_dim);
+        Vector<ValueType> v0(myfft0.Dim(0)), v1, v2;
+        for (int i = 0; i < v0.Dim(); i++) v0[i] = (1 + i) / (ValueType)v0.Dim();
+        myfft0.Execute(v0, v1);
+        myfft1.Execute(v1, v2);
+
+        const auto err = inf_norm(v2-v0);
+        std::cout<<"Error : "<<inf_norm(v2-v0)<<'\n';
+        SCTL_ASSERT(err < machine_eps<ValueType>() * 64);
+      }
     }
 
-    { // C2C, C2C_INV
+    { // distributed R2C (compare the local part with the non-distributed transform)
+      const Comm comm = Comm::World();
       FFT myfft0, myfft1;
-      myfft0.Setup(FFT_Type::C2C, howmany, fft_dim);
-      myfft1.Setup(FFT_Type::C2C_INV, howmany, fft_dim);
-      Vector<ValueType> v0(myfft0.Dim(0)), v1, v2;
+      myfft0.Setup(FFT_Type::R2C, howmany, fft_dim0);
+      myfft1.Setup(FFT_Type::R2C, howmany, fft_dim0, comm);
+      Vector<ValueType> v0(myfft0.Dim(0)), v1, v2(myfft1.Dim(0)), v3;
       for (int i = 0; i < v0.Dim(); i++) v0[i] = (1 + i) / (ValueType)v0.Dim();
       myfft0.Execute(v0, v1);
-      myfft1.Execute(v1, v2);
 
-      const auto err = inf_norm(v2-v0);
-      std::cout<<"Error : "<<inf_norm(v2-v0)<<'\n';
-      SCTL_ASSERT(err < machine_eps<ValueType>() * 64);
+      const Long N0 = fft_dim0[0], offset = myfft1.LocalStart(), size = myfft1.LocalSize();
+      const Long dof0 = v0.Dim() / (howmany * N0), dof1 = v1.Dim() / (howmany * N0);
+      for (Long j = 0; j < howmany; j++) {
+        for (Long i = 0; i < size * dof0; i++) v2[j * size * dof0 + i] = v0[(j * N0 + offset) * dof0 + i];
+      }
+      myfft1.Execute(v2, v3);
+
+      ValueType err = 0, glb_err = 0;
+      for (Long j = 0; j < howmany; j++) {
+        for (Long i = 0; i < size * dof1; i++) err = std::max<ValueType>(err, fabs(v3[j * size * dof1 + i] - v1[(j * N0 + offset) * dof1 + i]));
+      }
+      comm.Allreduce(Ptr2ConstItr<ValueType>(&err, 1), Ptr2Itr<ValueType>(&glb_err, 1), 1, CommOp::MAX);
+      if (!comm.Rank()) std::cout<<"Error : "<<glb_err<<'\n';
+      SCTL_ASSERT(glb_err < machine_eps<ValueType>() * 64);
     }
   }
 
@@ -67,87 +105,497 @@ namespace sctl {
   //  // TODO: copy to auxiliary array if unaligned
   //}
 
-  template <class ValueType> struct FFTPlan { std::vector<Matrix<ValueType>> M; };
+  namespace fft_detail {
 
-  template <class ValueType> FFT<ValueType>::~FFT() {}
+    /**
+     * Unnormalized 1D complex DFT of length N (sign = -1 for forward and +1 for inverse) using a mixed-radix Stockham
+     * (self-sorting) algorithm with radix 2, 3, 4, 5 butterflies and a generic butterfly for the other small prime
+     * factors. The data is in split (real, imaginary) format and the scalar type T may be ValueType or a SIMD vector
+     * Vec<ValueType> to transform several sequences at once.
+     */
+    template <class ValueType> class FFTRadix {
+      public:
 
-  template <class ValueType> FFT<ValueType>::FFT() : dim{0,0}, fft_type(FFT_Type::R2C), howmany_(0) {}
+      static constexpr Integer MaxRadix = 32;
 
-  template <class ValueType> Long FFT<ValueType>::Dim(Integer i) const { return dim[i]; }
+      FFTRadix() : N(0), sign(-1) {}
 
-  template <class ValueType> void FFT<ValueType>::Setup(FFT_Type fft_type_, Long howmany_, const Vector<Long>& dim_vec, Integer Nthreads) {
-    const auto fft_r2c = [](Long N0) {
-      ValueType s = 1 / sqrt<ValueType>(N0);
-      Long N1 = (N0 / 2 + 1);
-      Matrix<ValueType> M(N0, 2 * N1);
-      for (Long j = 0; j < N0; j++)
-        for (Long i = 0; i < N1; i++) {
-          M[j][2 * i + 0] =  cos<ValueType>(2 * const_pi<ValueType>() * j * i / N0)*s;
-          M[j][2 * i + 1] = -sin<ValueType>(2 * const_pi<ValueType>() * j * i / N0)*s;
+      /**
+       * @return true if all prime factors of N are at most MaxRadix.
+       */
+      static bool IsSmooth(Long N) {
+        for (Long p = 2; p <= MaxRadix && N > 1; p++) {
+          while (N % p == 0) N /= p;
         }
-      return M;
-    };
-    const auto fft_c2c = [](Long N0) {
-      ValueType s = 1 / sqrt<ValueType>(N0);
-      Matrix<ValueType> M(2 * N0, 2 * N0);
-      for (Long i = 0; i < N0; i++)
-        for (Long j = 0; j < N0; j++) {
-          M[2 * i + 0][2 * j + 0] =  cos<ValueType>(2 * const_pi<ValueType>() * j * i / N0)*s;
-          M[2 * i + 1][2 * j + 0] =  sin<ValueType>(2 * const_pi<ValueType>() * j * i / N0)*s;
-          M[2 * i + 0][2 * j + 1] = -sin<ValueType>(2 * const_pi<ValueType>() * j * i / N0)*s;
-          M[2 * i + 1][2 * j + 1] =  cos<ValueType>(2 * const_pi<ValueType>() * j * i / N0)*s;
+        return N == 1;
+      }
+
+      void Setup(Long N_, Integer sign_) {
+        SCTL_ASSERT(N_ > 0 && IsSmooth(N_));
+        N = N_;
+        sign = sign_;
+
+        radix.resize(0);
+        Long n = N;
+        while (n % 4 == 0) { radix.push_back(4); n /= 4; }
+        while (n % 2 == 0) { radix.push_back(2); n /= 2; }
+        for (Long p = 3; n > 1; p += 2) {
+          while (n % p == 0) { radix.push_back((Integer)p); n /= p; }
+        }
+
+        const auto exp_re = [](Long k, Long n) { return cos<ValueType>(2 * const_pi<ValueType>() * k / n); };
+        const auto exp_im = [this](Long k, Long n) { return sign * sin<ValueType>(2 * const_pi<ValueType>() * k / n); };
+        tw_re.resize(radix.size());
+        tw_im.resize(radix.size());
+        root_re.resize(radix.size());
+        root_im.resize(radix.size());
+        n = N;
+        for (Long k = 0; k < (Long)radix.size(); k++) {
+          const Integer p = radix[k];
+          const Long m = n / p;
+          tw_re[k].ReInit(m * (p - 1));
+          tw_im[k].ReInit(m * (p - 1));
+          for (Long j = 0; j < m; j++) {
+            for (Integer t = 1; t < p; t++) {
+              tw_re[k][j * (p - 1) + t - 1] = exp_re((j * t) % n, n);
+              tw_im[k][j * (p - 1) + t - 1] = exp_im((j * t) % n, n);
+            }
+          }
+          root_re[k].ReInit(p);
+          root_im[k].ReInit(p);
+          for (Integer t = 0; t < p; t++) {
+            root_re[k][t] = exp_re(t, p);
+            root_im[k][t] = exp_im(t, p);
+          }
+          n = m;
+        }
+      }
+
+      Long Dim() const { return N; }
+
+      /**
+       * @return The size of the work array required by Execute (in units of T).
+       */
+      Long WorkSize() const { return 2 * N; }
+
+      /**
+       * Compute the DFT of (re, im) in-place.
+       */
+      template <class T> void Execute(T* re, T* im, T* work) const {
+        T* x_re = re;
+        T* x_im = im;
+        T* y_re = work;
+        T* y_im = work + N;
+        Long n = N, s = 1;
+        for (Long k = 0; k < (Long)radix.size(); k++) {
+          const Integer p = radix[k];
+          if      (p == 2) Stage<2>(y_re, y_im, x_re, x_im, n, s, k);
+          else if (p == 3) Stage<3>(y_re, y_im, x_re, x_im, n, s, k);
+          else if (p == 4) Stage<4>(y_re, y_im, x_re, x_im, n, s, k);
+          else if (p == 5) Stage<5>(y_re, y_im, x_re, x_im, n, s, k);
+          else             Stage<0>(y_re, y_im, x_re, x_im, n, s, k);
+          std::swap(x_re, y_re);
+          std::swap(x_im, y_im);
+          n /= p;
+          s *= p;
+        }
+        if (x_re != re) {
+          for (Long i = 0; i < N; i++) re[i] = x_re[i];
+          for (Long i = 0; i < N; i++) im[i] = x_im[i];
         }
-      return M;
+      }
+
+      private:
+
+      template <class T> static void Butterfly(std::integral_constant<Integer,2>, T* b_re, T* b_im, const T* a_re, const T* a_im, Integer p, const ValueType* w_re, const ValueType* w_im) {
+        b_re[0] = a_re[0] + a_re[1]; b_im[0] = a_im[0] + a_im[1];
+        b_re[1] = a_re[0] - a_re[1]; b_im[1] = a_im[0] - a_im[1];
+      }
+      template <class T> static void Butterfly(std::integral_constant<Integer,3>, T* b_re, T* b_im, const T* a_re, const T* a_im, Integer p, const ValueType* w_re, const ValueType* w_im) {
+        const T t_re = a_re[1] + a_re[2], t_im = a_im[1] + a_im[2];
+        const T d_re = (a_re[1] - a_re[2]) * T(w_im[1]), d_im = (a_im[1] - a_im[2]) * T(w_im[1]);
+        const T c_re = a_re[0] - t_re * T((ValueType)0.5), c_im = a_im[0] - t_im * T((ValueType)0.5);
+        b_re[0] = a_re[0] + t_re; b_im[0] = a_im[0] + t_im;
+        b_re[1] = c_re - d_im; b_im[1] = c_im + d_re;
+        b_re[2] = c_re + d_im; b_im[2] = c_im - d_re;
+      }
+      template <class T> static void Butterfly(std::integral_constant<Integer,4>, T* b_re, T* b_im, const T* a_re, const T* a_im, Integer p, const ValueType* w_re, const ValueType* w_im) {
+        const T s0_re = a_re[0] + a_re[2], s0_im = a_im[0] + a_im[2];
+        const T d0_re = a_re[0] - a_re[2], d0_im = a_im[0] - a_im[2];
+        const T s1_re = a_re[1] + a_re[3], s1_im = a_im[1] + a_im[3];
+        const T d1_re = (a_re[1] - a_re[3]) * T(w_im[1]), d1_im = (a_im[1] - a_im[3]) * T(w_im[1]); // multiply by w = sign*i
+        b_re[0] = s0_re + s1_re; b_im[0] = s0_im + s1_im;
+        b_re[1] = d0_re - d1_im; b_im[1] = d0_im + d1_re;
+        b_re[2] = s0_re - s1_re; b_im[2] = s0_im - s1_im;
+        b_re[3] = d0_re + d1_im; b_im[3] = d0_im - d1_re;
+      }
+      template <class T> static void Butterfly(std::integral_constant<Integer,5>, T* b_re, T* b_im, const T* a_re, const T* a_im, Integer p, const ValueType* w_re, const ValueType* w_im) {
+        const T t1_re = a_re[1] + a_re[4], t1_im = a_im[1] + a_im[4];
+        const T t2_re = a_re[2] + a_re[3], t2_im = a_im[2] + a_im[3];
+        const T d1_re = a_re[1] - a_re[4], d1_im = a_im[1] - a_im[4];
+        const T d2_re = a_re[2] - a_re[3], d2_im = a_im[2] - a_im[3];
+        const T c1_re = a_re[0] + t1_re * T(w_re[1]) + t2_re * T(w_re[2]);
+        const T c1_im = a_im[0] + t1_im * T(w_re[1]) + t2_im * T(w_re[2]);
+        const T c2_re = a_re[0] + t1_re * T(w_re[2]) + t2_re * T(w_re[1]);
+        const T c2_im = a_im[0] + t1_im * T(w_re[2]) + t2_im * T(w_re[1]);
+        const T e1_re = d1_re * T(w_im[1]) + d2_re * T(w_im[2]), e1_im = d1_im * T(w_im[1]) + d2_im * T(w_im[2]);
+        const T e2_re = d1_re * T(w_im[2]) - d2_re * T(w_im[1]), e2_im = d1_im * T(w_im[2]) - d2_im * T(w_im[1]);
+        b_re[0] = a_re[0] + t1_re + t2_re; b_im[0] = a_im[0] + t1_im + t2_im;
+        b_re[1] = c1_re - e1_im; b_im[1] = c1_im + e1_re;
+        b_re[4] = c1_re + e1_im; b_im[4] = c1_im - e1_re;
+        b_re[2] = c2_re - e2_im; b_im[2] = c2_im + e2_re;
+        b_re[3] = c2_re + e2_im; b_im[3] = c2_im - e2_re;
+      }
+      template <class T> static void Butterfly(std::integral_constant<Integer,0>, T* b_re, T* b_im, const T* a_re, const T* a_im, Integer p, const ValueType* w_re, const ValueType* w_im) {
+        for (Integer t = 0; t < p; t++) {
+          T sum_re = a_re[0], sum_im = a_im[0];
+          for (Integer r = 1; r < p; r++) {
+            const Integer rt = (r * t) % p;
+            sum_re += a_re[r] * T(w_re[rt]) - a_im[r] * T(w_im[rt]);
+            sum_im += a_re[r] * T(w_im[rt]) + a_im[r] * T(w_re[rt]);
+          }
+          b_re[t] = sum_re;
+          b_im[t] = sum_im;
+        }
+      }
+
+      /**
+       * One decimation-in-frequency stage of radix p = radix[k] (P = 0 for a generic radix) on sub-sequences of length
+       * n with stride s.
+       */
+      template <Integer P, class T> void Stage(T* y_re, T* y_im, const T* x_re, const T* x_im, Long n, Long s, Long k) const {
+        static constexpr Integer BuffSize = (P ? P : MaxRadix);
+        const Integer p = radix[k];
+        const Long m = n / p;
+        const ValueType* tw_re_ = &tw_re[k][0];
+        const ValueType* tw_im_ = &tw_im[k][0];
+        T a_re[BuffSize], a_im[BuffSize], b_re[BuffSize], b_im[BuffSize];
+        for (Long j = 0; j < m; j++) {
+          for (Long q = 0; q < s; q++) {
+            for (Integer r = 0; r < p; r++) {
+              a_re[r] = x_re[q + s * (j + r * m)];
+              a_im[r] = x_im[q + s * (j + r * m)];
+            }
+            Butterfly(std::integral_constant<Integer,P>(), b_re, b_im, a_re, a_im, p, &root_re[k][0], &root_im[k][0]);
+            y_re[q + s * (p * j)] = b_re[0];
+            y_im[q + s * (p * j)] = b_im[0];
+            for (Integer t = 1; t < p; t++) {
+              const T w_re(tw_re_[j * (p - 1) + t - 1]);
+              const T w_im(tw_im_[j * (p - 1) + t - 1]);
+              y_re[q + s * (p * j + t)] = b_re[t] * w_re - b_im[t] * w_im;
+              y_im[q + s * (p * j + t)] = b_re[t] * w_im + b_im[t] * w_re;
+            }
+          }
+        }
+      }
+
+      Long N;
+      Integer sign;
+      std::vector<Integer> radix;
+      std::vector<Vector<ValueType>> tw_re, tw_im; // twiddle factors for each stage
+      std::vector<Vector<ValueType>> root_re, root_im; // roots of unity for the butterfly of each stage
     };
-    const auto fft_c2r = [](Long N0) {
-      ValueType s = 1 / sqrt<ValueType>(N0);
-      Long N1 = (N0 / 2 + 1);
-      Matrix<ValueType> M(2 * N1, N0);
-      for (Long i = 0; i < N1; i++) {
-        for (Long j = 0; j < N0; j++) {
-          M[2 * i + 0][j] =  2 * cos<ValueType>(2 * const_pi<ValueType>() * j * i / N0)*s;
-          M[2 * i + 1][j] = -2 * sin<ValueType>(2 * const_pi<ValueType>() * j * i / N0)*s;
+
+    /**
+     * Unnormalized 1D complex DFT of arbitrary length N. Uses FFTRadix when N has only small prime factors and
+     * Bluestein's algorithm (a chirp convolution computed with a 2-3-5 smooth FFT) otherwise.
+     */
+    template <class ValueType> class FFTComplex1D {
+      public:
+
+      FFTComplex1D() : N(0), M(0) {}
+
+      void Setup(Long N_, Integer sign) {
+        N = N_;
+        if (FFTRadix<ValueType>::IsSmooth(N)) {
+          M = 0;
+          fft.Setup(N, sign);
+          return;
+        }
+
+        M = 2 * N - 1;
+        while (true) { // smallest 2-3-5 smooth integer >= 2N-1
+          Long m = M;
+          for (const Long p : {2, 3, 5}) while (m % p == 0) m /= p;
+          if (m == 1) break;
+          M++;
+        }
+        fft.Setup(M, -1);
+
+        chirp_re.ReInit(N);
+        chirp_im.ReInit(N);
+        for (Long k = 0; k < N; k++) { // w_k = exp(sign*pi*i*k^2/N)
+          const ValueType theta = const_pi<ValueType>() * ((k * k) % (2 * N)) / N;
+          chirp_re[k] = cos<ValueType>(theta);
+          chirp_im[k] = sign * sin<ValueType>(theta);
+        }
+
+        Vector<ValueType> b_re(M), b_im(M), work(fft.WorkSize());
+        b_re = 0;
+        b_im = 0;
+        for (Long k = 0; k < N; k++) { // b_k = conj(w_k) / M
+          b_re[k] =  chirp_re[k] / M;
+          b_im[k] = -chirp_im[k] / M;
+          if (k) {
+            b_re[M - k] = b_re[k];
+            b_im[M - k] = b_im[k];
+          }
+        }
+        fft.Execute(&b_re[0], &b_im[0], &work[0]);
+        kernel_re.Swap(b_re);
+        kernel_im.Swap(b_im);
+      }
+
+      Long Dim() const { return N; }
+
+      Long WorkSize() const { return M ? 2 * M + fft.WorkSize() : fft.WorkSize(); }
+
+      template <class T> void Execute(T* re, T* im, T* work) const {
+        if (!M) {
+          fft.Execute(re, im, work);
+          return;
+        }
+
+        T* a_re = work;
+        T* a_im = work + M;
+        for (Long k = 0; k < N; k++) {
+          const T w_re(chirp_re[k]), w_im(chirp_im[k]);
+          a_re[k] = re[k] * w_re - im[k] * w_im;
+          a_im[k] = re[k] * w_im + im[k] * w_re;
+        }
+        for (Long k = N; k < M; k++) {
+          a_re[k] = T((ValueType)0);
+          a_im[k] = T((ValueType)0);
+        }
+        fft.Execute(a_re, a_im, work + 2 * M);
+        for (Long k = 0; k < M; k++) { // conj(a * kernel), so that the next forward FFT computes the inverse
+          const T w_re(kernel_re[k]), w_im(kernel_im[k]);
+          const T t_re = a_re[k] * w_re - a_im[k] * w_im;
+          const T t_im = a_re[k] * w_im + a_im[k] * w_re;
+          a_re[k] = t_re;
+          a_im[k] = -t_im;
+        }
+        fft.Execute(a_re, a_im, work + 2 * M);
+        for (Long k = 0; k < N; k++) {
+          const T w_re(chirp_re[k]), w_im(chirp_im[k]);
+          re[k] = a_re[k] * w_re + a_im[k] * w_im;
+          im[k] = a_re[k] * w_im - a_im[k] * w_re;
         }
       }
-      if (N1 > 0) {
-        for (Long j = 0; j < N0; j++) {
-          M[0][j] = M[0][j] * (ValueType)0.5;
-          M[1][j] = M[1][j] * (ValueType)0.5;
+
+      private:
+
+      Long N, M;
+      FFTRadix<ValueType> fft;
+      Vector<ValueType> chirp_re, chirp_im;
+      Vector<ValueType> kernel_re, kernel_im;
+    };
+
+    /**
+     * Normalized (by 1/sqrt(N)) 1D transform of type R2C, C2C, C2C_INV or C2R, applied to each row of a contiguous
+     * array. The rows are transformed in groups of DefaultVecLen<ValueType>() using SIMD vectors. Real transforms of
+     * even length are computed with a complex FFT of half the length.
+     */
+    template <class ValueType> class FFTPlan1D {
+      static constexpr Integer VecLen = DefaultVecLen<ValueType>();
+      using VecType = Vec<ValueType,VecLen>;
+
+      public:
+
+      FFTPlan1D(FFT_Type type_, Long N_) : type(type_), N(N_) {
+        SCTL_ASSERT(N > 0);
+        const Integer sign = (type == FFT_Type::R2C || type == FFT_Type::C2C ? -1 : 1);
+        half = ((type == FFT_Type::R2C || type == FFT_Type::C2R) && N % 2 == 0);
+        fft.Setup(half ? N / 2 : N, sign);
+        scal = 1 / sqrt<ValueType>(N);
+        if (half) {
+          const Long h = N / 2;
+          rtw_re.ReInit(h + 1);
+          rtw_im.ReInit(h + 1);
+          for (Long k = 0; k <= h; k++) { // exp(sign*2*pi*i*k/N)
+            rtw_re[k] = cos<ValueType>(2 * const_pi<ValueType>() * k / N);
+            rtw_im[k] = sign * sin<ValueType>(2 * const_pi<ValueType>() * k / N);
+          }
         }
       }
-      if (N0 % 2 == 0) {
-        for (Long j = 0; j < N0; j++) {
-          M[2 * N1 - 2][j] = M[2 * N1 - 2][j] * (ValueType)0.5;
-          M[2 * N1 - 1][j] = M[2 * N1 - 1][j] * (ValueType)0.5;
+
+      /**
+       * @return Length of each row (number of real values) of the input (i = 0) and the output (i = 1).
+       */
+      Long Dim(Integer i) const {
+        const Long Nc = 2 * (N / 2 + 1);
+        if (type == FFT_Type::R2C) return (i == 0 ? N : Nc);
+        if (type == FFT_Type::C2R) return (i == 0 ? Nc : N);
+        return 2 * N;
+      }
+
+      void Execute(Iterator<ValueType> out, ConstIterator<ValueType> in, Long rows) const {
+        const Long L = fft.Dim();
+        const Long Nc = N / 2 + 1;
+        const Long dim0 = Dim(0), dim1 = Dim(1);
+        Vector<VecType> re(L), im(L), work(fft.WorkSize()), Xre, Xim;
+        if (type == FFT_Type::C2R) {
+          Xre.ReInit(Nc);
+          Xim.ReInit(Nc);
+        }
+
+        alignas(sizeof(VecType)) ValueType tmp[VecLen];
+        const auto load = [&tmp,&in,rows](Long r0, Long dim, Long offset) {
+          for (Integer l = 0; l < VecLen; l++) tmp[l] = (r0 + l < rows ? in[(r0 + l) * dim + offset] : (ValueType)0);
+          return VecType::LoadAligned(tmp);
+        };
+        const auto store = [&tmp,&out,rows](const VecType& v, Long r0, Long dim, Long offset) {
+          v.StoreAligned(tmp);
+          for (Integer l = 0; l < VecLen && r0 + l < rows; l++) out[(r0 + l) * dim + offset] = tmp[l];
+        };
+
+        const VecType zero((ValueType)0);
+        const VecType s(scal), s_half(scal / 2);
+        for (Long r0 = 0; r0 < rows; r0 += VecLen) {
+          if (type == FFT_Type::C2C || type == FFT_Type::C2C_INV) {
+            for (Long k = 0; k < N; k++) {
+              re[k] = load(r0, dim0, 2 * k + 0);
+              im[k] = load(r0, dim0, 2 * k + 1);
+            }
+          } else if (type == FFT_Type::R2C) {
+            if (half) { // z_k = x_{2k} + i x_{2k+1}
+              for (Long k = 0; k < L; k++) {
+                re[k] = load(r0, dim0, 2 * k + 0);
+                im[k] = load(r0, dim0, 2 * k + 1);
+              }
+            } else {
+              for (Long k = 0; k < N; k++) {
+                re[k] = load(r0, dim0, k);
+                im[k] = zero;
+              }
+            }
+          } else { // C2R (the imaginary parts of the zero and the Nyquist frequencies are ignored)
+            for (Long k = 0; k < Nc; k++) {
+              Xre[k] = load(r0, dim0, 2 * k + 0);
+              Xim[k] = load(r0, dim0, 2 * k + 1);
+            }
+            Xim[0] = zero;
+            if (half) {
+              Xim[L] = zero;
+              for (Long k = 0; k < L; k++) { // Z_k = (X_k + conj(X_{h-k})) + i (X_k - conj(X_{h-k})) exp(2*pi*i*k/N)
+                const VecType e_re = Xre[k] + Xre[L - k], e_im = Xim[k] - Xim[L - k];
+                const VecType d_re = Xre[k] - Xre[L - k], d_im = Xim[k] + Xim[L - k];
+                const VecType w_re(rtw_re[k]), w_im(rtw_im[k]);
+                const VecType o_re = d_re * w_re - d_im * w_im;
+                const VecType o_im = d_re * w_im + d_im * w_re;
+                re[k] = e_re - o_im;
+                im[k] = e_im + o_re;
+              }
+            } else {
+              for (Long k = 0; k < Nc; k++) {
+                re[k] = Xre[k];
+                im[k] = Xim[k];
+              }
+              for (Long k = Nc; k < N; k++) {
+                re[k] = Xre[N - k];
+                im[k] = -Xim[N - k];
+              }
+            }
+          }
+
+          fft.Execute(&re[0], &im[0], &work[0]);
+
+          if (type == FFT_Type::C2C || type == FFT_Type::C2C_INV) {
+            for (Long k = 0; k < N; k++) {
+              store(re[k] * s, r0, dim1, 2 * k + 0);
+              store(im[k] * s, r0, dim1, 2 * k + 1);
+            }
+          } else if (type == FFT_Type::R2C) {
+            if (half) { // X_k = E_k + exp(-2*pi*i*k/N) O_k, where E_k = (Z_k + conj(Z_{h-k}))/2 and O_k = (Z_k - conj(Z_{h-k}))/(2i)
+              for (Long k = 0; k <= L; k++) {
+                const Long k0 = k % L, k1 = (L - k) % L;
+                const VecType e_re = re[k0] + re[k1], e_im = im[k0] - im[k1];
+                const VecType o_re = im[k0] + im[k1], o_im = re[k1] - re[k0];
+                const VecType w_re(rtw_re[k]), w_im(rtw_im[k]);
+                store((e_re + o_re * w_re - o_im * w_im) * s_half, r0, dim1, 2 * k + 0);
+                store((e_im + o_re * w_im + o_im * w_re) * s_half, r0, dim1, 2 * k + 1);
+              }
+            } else {
+              for (Long k = 0; k < Nc; k++) {
+                store(re[k] * s, r0, dim1, 2 * k + 0);
+                store(im[k] * s, r0, dim1, 2 * k + 1);
+              }
+            }
+          } else { // C2R
+            if (half) {
+              for (Long k = 0; k < L; k++) {
+                store(re[k] * s, r0, dim1, 2 * k + 0);
+                store(im[k] * s, r0, dim1, 2 * k + 1);
+              }
+            } else {
+              for (Long k = 0; k < N; k++) store(re[k] * s, r0, dim1, k);
+            }
+          }
         }
       }
-      return M;
+
+      private:
+
+      FFT_Type type;
+      Long N;
+      bool half; // real transform computed from a complex FFT of length N/2
+      ValueType scal;
+      FFTComplex1D<ValueType> fft;
+      Vector<ValueType> rtw_re, rtw_im;
     };
 
+  }  // namespace fft_detail
+
+  template <class ValueType> struct FFTPlan { std::vector<fft_detail::FFTPlan1D<ValueType>> fft1d; };
+
+  template <class ValueType> FFT<ValueType>::~FFT() {}
+
+  template <class ValueType> FFT<ValueType>::FFT() : dim{0,0}, fft_type(FFT_Type::R2C), howmany_(0), local_range{0,0} {}
+
+  template <class ValueType> Long FFT<ValueType>::Dim(Integer i) const { return dim[i]; }
+
+  template <class ValueType> void FFT<ValueType>::SetPlanRigor(const FFT_Rigor rigor) { plan_rigor() = rigor; }
+
+  template <class ValueType> FFT_Rigor FFT<ValueType>::GetPlanRigor() { return plan_rigor(); }
+
+  template <class ValueType> bool FFT<ValueType>::ImportWisdom(const std::string& fname) { return false; }
+
+  template <class ValueType> bool FFT<ValueType>::ExportWisdom(const std::string& fname) { return false; }
+
+  template <class ValueType> FFT_Rigor& FFT<ValueType>::plan_rigor() {
+    static FFT_Rigor rigor = FFT_Rigor::ESTIMATE;
+    return rigor;
+  }
+
+  template <class ValueType> void FFT<ValueType>::Setup(FFT_Type fft_type_, Long howmany_, const Vector<Long>& dim_vec, Integer Nthreads) {
+    dist_plan.reset();
+    local_range[0] = 0;
+    local_range[1] = (dim_vec.Dim() ? dim_vec[0] : 0);
+
     Long rank = dim_vec.Dim();
     this->fft_type = fft_type_;
     this->howmany_ = howmany_;
-    plan.M.resize(0);
+    plan.fft1d.clear();
 
     Long N0 = 0, N1 = 0;
     if (rank) {
       if (this->fft_type == FFT_Type::R2C) {
-        plan.M.push_back(fft_r2c(dim_vec[rank - 1]));
-        for (Long i = rank - 2; i >= 0; i--) plan.M.push_back(fft_c2c(dim_vec[i]));
+        plan.fft1d.push_back(fft_detail::FFTPlan1D<ValueType>(FFT_Type::R2C, dim_vec[rank - 1]));
+        for (Long i = rank - 2; i >= 0; i--) plan.fft1d.push_back(fft_detail::FFTPlan1D<ValueType>(FFT_Type::C2C, dim_vec[i]));
       } else if (this->fft_type == FFT_Type::C2C) {
-        for (Long i = rank - 1; i >= 0; i--) plan.M.push_back(fft_c2c(dim_vec[i]));
+        for (Long i = rank - 1; i >= 0; i--) plan.fft1d.push_back(fft_detail::FFTPlan1D<ValueType>(FFT_Type::C2C, dim_vec[i]));
       } else if (this->fft_type == FFT_Type::C2C_INV) {
-        for (Long i = rank - 1; i >= 0; i--) plan.M.push_back(fft_c2c(dim_vec[i]).Transpose());
+        for (Long i = rank - 1; i >= 0; i--) plan.fft1d.push_back(fft_detail::FFTPlan1D<ValueType>(FFT_Type::C2C_INV, dim_vec[i]));
       } else if (this->fft_type == FFT_Type::C2R) {
-        for (Long i = rank - 2; i >= 0; i--) plan.M.push_back(fft_c2c(dim_vec[i]).Transpose());
-        plan.M.push_back(fft_c2r(dim_vec[rank - 1]));
+        for (Long i = rank - 2; i >= 0; i--) plan.fft1d.push_back(fft_detail::FFTPlan1D<ValueType>(FFT_Type::C2C_INV, dim_vec[i]));
+        plan.fft1d.push_back(fft_detail::FFTPlan1D<ValueType>(FFT_Type::C2R, dim_vec[rank - 1]));
       }
 
       N0 = this->howmany_ * 2;
       N1 = this->howmany_ * 2;
-      for (const auto& M : plan.M) {
-        N0 = N0 * M.Dim(0) / 2;
-        N1 = N1 * M.Dim(1) / 2;
+      for (const auto& F : plan.fft1d) {
+        N0 = N0 * F.Dim(0) / 2;
+        N1 = N1 * F.Dim(1) / 2;
       }
     }
     this->dim[0] = N0;
@@ -155,6 +603,11 @@ namespace sctl {
   }
 
   template <class ValueType> void FFT<ValueType>::Execute(const Vector<ValueType>& in, Vector<ValueType>& out) const {
+    if (dist_plan) {
+      ExecuteDist(in, out);
+      return;
+    }
+
     const auto transpose = [](Iterator<ValueType> out, ConstIterator<ValueType> in, Long N0, Long N1) {
       const Matrix<ComplexType> M0(N0, N1, (Iterator<ComplexType>)in, false);
       Matrix<ComplexType> M1(N1, N0, (Iterator<ComplexType>)out, false);
@@ -169,41 +622,232 @@ namespace sctl {
 
     Vector<ValueType> buff0(N0 + N1);
     Vector<ValueType> buff1(N0 + N1);
-    Long rank = plan.M.size();
+    Long rank = plan.fft1d.size();
     if (rank <= 0) return;
     Long N = N0;
 
     if (this->fft_type == FFT_Type::C2R) {
-      const Matrix<ValueType>& M = plan.M[rank - 1];
-      transpose(buff0.begin(), in.begin(), N / M.Dim(0), M.Dim(0) / 2);
+      const auto& F = plan.fft1d[rank - 1];
+      transpose(buff0.begin(), in.begin(), N / F.Dim(0), F.Dim(0) / 2);
 
       for (Long i = 0; i < rank - 1; i++) {
-        const Matrix<ValueType>& M = plan.M[i];
-        Matrix<ValueType> vi(N / M.Dim(0), M.Dim(0), buff0.begin(), false);
-        Matrix<ValueType> vo(N / M.Dim(0), M.Dim(1), buff1.begin(), false);
-        Matrix<ValueType>::GEMM(vo, vi, M);
-        N = N * M.Dim(1) / M.Dim(0);
-        transpose(buff0.begin(), buff1.begin(), N / M.Dim(1), M.Dim(1) / 2);
+        const auto& F = plan.fft1d[i];
+        F.Execute(buff1.begin(), buff0.begin(), N / F.Dim(0));
+        N = N * F.Dim(1) / F.Dim(0);
+        transpose(buff0.begin(), buff1.begin(), N / F.Dim(1), F.Dim(1) / 2);
       }
       transpose(buff1.begin(), buff0.begin(), N / this->howmany_ / 2, this->howmany_);
 
-      Matrix<ValueType> vi(N / M.Dim(0), M.Dim(0), buff1.begin(), false);
-      Matrix<ValueType> vo(N / M.Dim(0), M.Dim(1), out.begin(), false);
-      Matrix<ValueType>::GEMM(vo, vi, M);
+      F.Execute(out.begin(), buff1.begin(), N / F.Dim(0));
     } else {
       memcopy(buff0.begin(), in.begin(), in.Dim());
       for (Long i = 0; i < rank; i++) {
-        const Matrix<ValueType>& M = plan.M[i];
-        Matrix<ValueType> vi(N / M.Dim(0), M.Dim(0), buff0.begin(), false);
-        Matrix<ValueType> vo(N / M.Dim(0), M.Dim(1), buff1.begin(), false);
-        Matrix<ValueType>::GEMM(vo, vi, M);
-        N = N * M.Dim(1) / M.Dim(0);
-        transpose(buff0.begin(), buff1.begin(), N / M.Dim(1), M.Dim(1) / 2);
+        const auto& F = plan.fft1d[i];
+        F.Execute(buff1.begin(), buff0.begin(), N / F.Dim(0));
+        N = N * F.Dim(1) / F.Dim(0);
+        transpose(buff0.begin(), buff1.begin(), N / F.Dim(1), F.Dim(1) / 2);
       }
       transpose(out.begin(), buff0.begin(), N / this->howmany_ / 2, this->howmany_);
     }
   }
 
+  template <class ValueType> struct FFTDistPlan {
+    static constexpr Integer Nchunk = 4; // chunks (along the first dimension) of each transform for pipelining
+
+    Comm comm;
+    Long n0, n1, R; // intermediate complex array for each transform is n0 x n1 x R
+    Long row_in, row_out; // number of real values in the input and output for each index of the first dimension
+    Vector<Long> start0, start1; // partition of n0 and n1 between the processes
+    StaticArray<FFT<ValueType>,2> fft_rows; // transforms along the dimensions 1,...,rank-1 for chunk sizes a and a+1
+    FFT<ValueType> fft_col; // 1D transforms along the first dimension (in the transposed layout)
+
+    /**
+     * Start of the chunk k of the local part of the first dimension on process p.
+     */
+    Long ChunkStart(Integer p, Integer k) const {
+      return (start0[p + 1] - start0[p]) * k / Nchunk;
+    }
+  };
+
+  template <class ValueType> void FFT<ValueType>::Setup(FFT_Type fft_type_, Long howmany_, const Vector<Long>& dim_vec, const Comm& comm, Integer Nthreads) {
+    if (comm.Size() == 1) {
+      Setup(fft_type_, howmany_, dim_vec, Nthreads);
+      return;
+    }
+
+    const Long rank = dim_vec.Dim();
+    SCTL_ASSERT_MSG(rank >= 2, "FFT: the distributed transform requires at least two dimensions.");
+    this->fft_type = fft_type_;
+    this->howmany_ = howmany_;
+
+    dist_plan.reset(new FFTDistPlan<ValueType>());
+    auto& P = *dist_plan;
+    P.comm = comm;
+    const Integer np = comm.Size();
+    const Integer pid = comm.Rank();
+
+    Vector<Long> dim_rows(rank - 1);
+    for (Long i = 1; i < rank; i++) dim_rows[i - 1] = dim_vec[i];
+    const bool real_data = (fft_type_ == FFT_Type::R2C || fft_type_ == FFT_Type::C2R);
+    const Long N_row = [&dim_rows]() { Long N = 1; for (const auto n : dim_rows) N *= n; return N; }();
+    const Long Nc_row = (real_data ? N_row / dim_vec[rank - 1] * (dim_vec[rank - 1] / 2 + 1) : N_row);
+    P.row_in  = (fft_type_ == FFT_Type::R2C ? N_row : 2 * Nc_row);
+    P.row_out = (fft_type_ == FFT_Type::C2R ? N_row : 2 * Nc_row);
+    P.n0 = dim_vec[0];
+    P.n1 = (rank == 2 ? Nc_row : dim_vec[1]);
+    P.R = Nc_row / P.n1;
+
+    P.start0.ReInit(np + 1);
+    P.start1.ReInit(np + 1);
+    for (Integer p = 0; p <= np; p++) {
+      P.start0[p] = P.n0 * p / np;
+      P.start1[p] = P.n1 * p / np;
+    }
+    const Long ln0 = P.start0[pid + 1] - P.start0[pid];
+    const Long ln1 = P.start1[pid + 1] - P.start1[pid];
+
+    const Long a = ln0 / P.Nchunk;
+    for (Integer j = 0; j < 2; j++) {
+      if (a + j > 0) P.fft_rows[j].Setup(fft_type_, a + j, dim_rows, Nthreads);
+    }
+    if (ln1 * P.R > 0) {
+      const bool inv = (fft_type_ == FFT_Type::C2C_INV || fft_type_ == FFT_Type::C2R);
+      Vector<Long> dim_col(1);
+      dim_col[0] = P.n0;
+      P.fft_col.Setup(inv ? FFT_Type::C2C_INV : FFT_Type::C2C, ln1 * P.R, dim_col, Nthreads);
+    }
+
+    local_range[0] = P.start0[pid];
+    local_range[1] = ln0;
+    this->dim[0] = howmany_ * ln0 * P.row_in;
+    this->dim[1] = howmany_ * ln0 * P.row_out;
+  }
+
+  template <class ValueType> Long FFT<ValueType>::LocalStart() const { return local_range[0]; }
+
+  template <class ValueType> Long FFT<ValueType>::LocalSize() const { return local_range[1]; }
+
+  template <class ValueType> void FFT<ValueType>::ExecuteDist(const Vector<ValueType>& in, Vector<ValueType>& out) const {
+    const auto& P = *dist_plan;
+    const Comm& comm = P.comm;
+    const Integer np = comm.Size();
+    const Integer pid = comm.Rank();
+    constexpr Integer K = FFTDistPlan<ValueType>::Nchunk;
+    const Long howmany = this->howmany_, n0 = P.n0, R = P.R;
+    const Long Mrow = P.n1 * R; // complex values for each index of the first dimension
+    const Long ln0 = P.start0[pid + 1] - P.start0[pid];
+    const Long ln1 = P.start1[pid + 1] - P.start1[pid];
+    const Long a = ln0 / K;
+    const bool fwd = (this->fft_type != FFT_Type::C2R);
+
+    SCTL_ASSERT_MSG(in.Dim() == Dim(0), "FFT: Wrong input size.");
+    if (out.Dim() != Dim(1)) out.ReInit(Dim(1));
+
+    // Each transform is exchanged in K chunks along the first dimension. Chunk k of process p is sent to process q as
+    // a block of size rows x ln1_q x R; the counts and displacements are in units of ValueType.
+    Vector<Long> scnt(K * np), sdsp(K * np), rcnt(K * np), rdsp(K * np), col_offset(K + 1);
+    col_offset[0] = 0;
+    for (Integer k = 0; k < K; k++) {
+      const Long rows = P.ChunkStart(pid, k + 1) - P.ChunkStart(pid, k);
+      Long soffset = 0, roffset = 0;
+      for (Integer q = 0; q < np; q++) {
+        scnt[k * np + q] = rows * (P.start1[q + 1] - P.start1[q]) * R * 2;
+        rcnt[k * np + q] = (P.ChunkStart(q, k + 1) - P.ChunkStart(q, k)) * ln1 * R * 2;
+        sdsp[k * np + q] = soffset;
+        rdsp[k * np + q] = roffset;
+        soffset += scnt[k * np + q];
+        roffset += rcnt[k * np + q];
+      }
+      col_offset[k + 1] = col_offset[k] + roffset;
+    }
+    const Long row_size = ln0 * Mrow * 2; // for each transform
+    const Long col_size = n0 * ln1 * R * 2;
+
+    // Copy between the row layout [ln0 x n1 x R] and the send/recv buffer for chunk k (and each destination q).
+    const auto row_blocks = [&](Long h, Integer k, Iterator<ValueType> buf, Iterator<ValueType> X, bool to_buf) {
+      const Long r0 = P.ChunkStart(pid, k), rows = P.ChunkStart(pid, k + 1) - r0;
+      for (Integer q = 0; q < np; q++) {
+        const Long ln1_q = P.start1[q + 1] - P.start1[q];
+        for (Long i = 0; i < rows; i++) {
+          for (Long j = 0; j < ln1_q; j++) {
+            Iterator<ValueType> x = X + h * row_size + ((r0 + i) * Mrow + (P.start1[q] + j) * R) * 2;
+            Iterator<ValueType> b = buf + h * row_size + r0 * Mrow * 2 + sdsp[k * np + q] + (i * ln1_q + j) * R * 2;
+            if (to_buf) memcopy(b, x, R * 2);
+            else memcopy(x, b, R * 2);
+          }
+        }
+      }
+    };
+    // Copy between the transposed layout [ln1 x R x n0] and the send/recv buffer for chunk k (and each source p).
+    const auto col_blocks = [&](Long h, Integer k, Iterator<ValueType> buf, Iterator<ValueType> T, bool to_buf) {
+      for (Integer p = 0; p < np; p++) {
+        const Long i0 = P.start0[p] + P.ChunkStart(p, k), rows = P.ChunkStart(p, k + 1) - P.ChunkStart(p, k);
+        Iterator<ValueType> b = buf + h * col_size + col_offset[k] + rdsp[k * np + p];
+        for (Long i = 0; i < rows; i++) {
+          for (Long jr = 0; jr < ln1 * R; jr++) {
+            Iterator<ValueType> t = T + h * col_size + (jr * n0 + i0 + i) * 2;
+            Iterator<ValueType> b_ = b + (i * ln1 * R + jr) * 2;
+            if (to_buf) { b_[0] = t[0]; b_[1] = t[1]; }
+            else { t[0] = b_[0]; t[1] = b_[1]; }
+          }
+        }
+      }
+    };
+    const auto fft_rows = [&](Long h, Integer k, Iterator<ValueType> out_, ConstIterator<ValueType> in_) { // transforms along dimensions 1,...,rank-1
+      const Long r0 = P.ChunkStart(pid, k), rows = P.ChunkStart(pid, k + 1) - r0;
+      if (!rows) return;
+      const Vector<ValueType> vi(rows * P.row_in, (Iterator<ValueType>)in_ + (h * ln0 + r0) * P.row_in, false);
+      Vector<ValueType> vo(rows * P.row_out, out_ + (h * ln0 + r0) * P.row_out, false);
+      P.fft_rows[rows - a].Execute(vi, vo);
+    };
+
+    Vector<ValueType> X(howmany * row_size), S_row(howmany * row_size);
+    Vector<ValueType> R_col(howmany * col_size), T0(howmany * col_size), T1(howmany * col_size), S_col(howmany * col_size);
+    std::vector<void*> req(howmany * K);
+
+    for (Long h = 0; h < howmany; h++) { // transform the rows and send the chunks as soon as they are ready
+      for (Integer k = 0; k < K; k++) {
+        if (fwd) {
+          fft_rows(h, k, X.begin(), in.begin());
+          row_blocks(h, k, S_row.begin(), X.begin(), true);
+        } else {
+          row_blocks(h, k, S_row.begin(), (Iterator<ValueType>)in.begin(), true);
+        }
+        const Long soffset = h * row_size + P.ChunkStart(pid, k) * Mrow * 2;
+        const Long roffset = h * col_size + col_offset[k];
+        req[h * K + k] = comm.Ialltoallv_sparse(S_row.begin() + soffset, scnt.begin() + k * np, sdsp.begin() + k * np, R_col.begin() + roffset, rcnt.begin() + k * np, rdsp.begin() + k * np, 0);
+      }
+    }
+    for (Long h = 0; h < howmany; h++) { // transform along the first dimension and send back
+      for (Integer k = 0; k < K; k++) {
+        comm.Wait(req[h * K + k]);
+        col_blocks(h, k, R_col.begin(), T0.begin(), false);
+      }
+      if (ln1 * R > 0) {
+        const Vector<ValueType> vi(col_size, T0.begin() + h * col_size, false);
+        Vector<ValueType> vo(col_size, T1.begin() + h * col_size, false);
+        P.fft_col.Execute(vi, vo);
+      }
+      for (Integer k = 0; k < K; k++) {
+        col_blocks(h, k, S_col.begin(), T1.begin(), true);
+        const Long soffset = h * col_size + col_offset[k];
+        const Long roffset = h * row_size + P.ChunkStart(pid, k) * Mrow * 2;
+        req[h * K + k] = comm.Ialltoallv_sparse(S_col.begin() + soffset, rcnt.begin() + k * np, rdsp.begin() + k * np, X.begin() + roffset, scnt.begin() + k * np, sdsp.begin() + k * np, 1);
+      }
+    }
+    for (Long h = 0; h < howmany; h++) { // receive the chunks and transform the rows
+      for (Integer k = 0; k < K; k++) {
+        comm.Wait(req[h * K + k]);
+        if (fwd) {
+          row_blocks(h, k, X.begin(), out.begin(), false);
+        } else {
+          row_blocks(h, k, X.begin(), S_row.begin(), false);
+          fft_rows(h, k, out.begin(), S_row.begin());
+        }
+      }
+    }
+  }
+
 
   static inline void FFTWInitThreads(Integer Nthreads) {
 #ifdef SCTL_FFTW_THREADS
@@ -216,6 +860,71 @@ namespace sctl {
 #endif
   }
 
+#if defined(SCTL_HAVE_FFTW) || defined(SCTL_HAVE_FFTWF) || defined(SCTL_HAVE_FFTWL)
+  static inline unsigned FFTWPlannerFlags(const FFT_Rigor rigor) {
+    if (rigor == FFT_Rigor::MEASURE) return FFTW_MEASURE;
+    if (rigor == FFT_Rigor::PATIENT) return FFTW_PATIENT;
+    if (rigor == FFT_Rigor::EXHAUSTIVE) return FFTW_EXHAUSTIVE;
+    return FFTW_ESTIMATE;
+  }
+
+  static inline std::vector<Long> FFTWPlanKey(const FFT_Type fft_type, const Long howmany, const Vector<Long>& dim_vec, const Integer Nthreads, const FFT_Rigor rigor) {
+    std::vector<Long> key;
+    key.push_back((Long)fft_type);
+    key.push_back((Long)rigor);
+    key.push_back(Nthreads);
+    key.push_back(howmany);
+    for (const auto n : dim_vec) key.push_back(n);
+    return key;
+  }
+
+  template <class PlanType> struct FFTWPlanEntry {
+    FFTWPlanEntry() : plan(nullptr), copy_input(false) {}
+    PlanType plan;
+    bool copy_input; // the plan does not preserve its input
+  };
+
+  /**
+   * Process-wide cache of FFTW plans, shared by all FFT objects. A plan is created (in the critical section of the
+   * FFTW planner) the first time it is requested, and is destroyed at program exit. Each thread also keeps an index of
+   * the plans that it has looked up, so that cache hits do not synchronize.
+   */
+  template <class PlanType> class FFTWPlanCache {
+    public:
+
+    static const FFTWPlanEntry<PlanType>& Lookup(const std::vector<Long>& key, const std::function<FFTWPlanEntry<PlanType>()>& create_plan, void (*destroy_plan)(PlanType)) {
+      static thread_local std::map<std::vector<Long>, const FFTWPlanEntry<PlanType>*> local_index;
+      const auto local_it = local_index.find(key);
+      if (local_it != local_index.end()) return *local_it->second;
+
+      const FFTWPlanEntry<PlanType>* entry = nullptr;
+      #pragma omp critical(SCTL_FFTW_PLAN)
+      {
+        static FFTWPlanCache cache;
+        cache.destroy_plan = destroy_plan;
+        auto it = cache.plans.find(key);
+        if (it == cache.plans.end()) it = cache.plans.insert(std::make_pair(key, create_plan())).first;
+        entry = &it->second;
+      }
+      local_index[key] = entry;
+      return *entry;
+    }
+
+    private:
+
+    FFTWPlanCache() : destroy_plan(nullptr) {}
+
+    ~FFTWPlanCache() {
+      for (auto& x : plans) {
+        if (x.second.plan) destroy_plan(x.second.plan);
+      }
+    }
+
+    std::map<std::vector<Long>, FFTWPlanEntry<PlanType>> plans;
+    void (*destroy_plan)(PlanType);
+  };
+#endif
+
 #ifdef SCTL_HAVE_FFTW
   template <> struct FFTPlan<double> {
     FFTPlan() : fftwplan(nullptr) {}
@@ -223,11 +932,14 @@ namespace sctl {
   };
 
   template <> inline FFT<double>::~FFT() {
-    if (plan.fftwplan) fftw_destroy_plan(plan.fftwplan);
-    plan.fftwplan = nullptr;
+    plan.fftwplan = nullptr; // owned by FFTWPlanCache
   }
 
   template <> inline void FFT<double>::Setup(FFT_Type fft_type_, Long howmany_, const Vector<Long>& dim_vec, Integer Nthreads) {
+    dist_plan.reset();
+    local_range[0] = 0;
+    local_range[1] = (dim_vec.Dim() ? dim_vec[0] : 0);
+
     fft_type = fft_type_;
     this->howmany_ = howmany_;
     copy_input = false;
@@ -262,39 +974,60 @@ namespace sctl {
     dim[0] = N0;
     dim[1] = N1;
     if (!N0 || !N1) return;
-    Vector<double> in(N0), out(N1);
-
-    #pragma omp critical(SCTL_FFTW_PLAN)
-    {
-    FFTWInitThreads(Nthreads);
-    if (plan.fftwplan) fftw_destroy_plan(plan.fftwplan);
-    plan.fftwplan = nullptr;
-    if (fft_type == FFT_Type::R2C) {
-      plan.fftwplan = fftw_plan_many_dft_r2c(rank, &dim_vec_[0], this->howmany_, &in[0], nullptr, 1, N0 / this->howmany_, (fftw_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_ESTIMATE | FFTW_PRESERVE_INPUT);
-    } else if (fft_type == FFT_Type::C2C) {
-      plan.fftwplan = fftw_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftw_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftw_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_FORWARD, FFTW_ESTIMATE | FFTW_PRESERVE_INPUT);
-    } else if (fft_type == FFT_Type::C2C_INV) {
-      plan.fftwplan = fftw_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftw_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftw_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_BACKWARD, FFTW_ESTIMATE | FFTW_PRESERVE_INPUT);
-    } else if (fft_type == FFT_Type::C2R) {
-      plan.fftwplan = fftw_plan_many_dft_c2r(rank, &dim_vec_[0], this->howmany_, (fftw_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, &out[0], nullptr, 1, N1 / this->howmany_, FFTW_ESTIMATE | FFTW_PRESERVE_INPUT);
-    }
-    if (!plan.fftwplan) { // Build plan without FFTW_PRESERVE_INPUT
+    const unsigned planner_flags = FFTWPlannerFlags(GetPlanRigor());
+    const auto create_plan = [&]() {
+      FFTWPlanEntry<fftw_plan> entry;
+      Vector<double> in(N0), out(N1);
+      FFTWInitThreads(Nthreads);
       if (fft_type == FFT_Type::R2C) {
-        plan.fftwplan = fftw_plan_many_dft_r2c(rank, &dim_vec_[0], this->howmany_, &in[0], nullptr, 1, N0 / this->howmany_, (fftw_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_ESTIMATE);
+        entry.plan = fftw_plan_many_dft_r2c(rank, &dim_vec_[0], this->howmany_, &in[0], nullptr, 1, N0 / this->howmany_, (fftw_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, planner_flags | FFTW_PRESERVE_INPUT);
       } else if (fft_type == FFT_Type::C2C) {
-        plan.fftwplan = fftw_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftw_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftw_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_FORWARD, FFTW_ESTIMATE);
+        entry.plan = fftw_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftw_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftw_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_FORWARD, planner_flags | FFTW_PRESERVE_INPUT);
       } else if (fft_type == FFT_Type::C2C_INV) {
-        plan.fftwplan = fftw_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftw_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftw_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_BACKWARD, FFTW_ESTIMATE);
+        entry.plan = fftw_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftw_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftw_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_BACKWARD, planner_flags | FFTW_PRESERVE_INPUT);
       } else if (fft_type == FFT_Type::C2R) {
-        plan.fftwplan = fftw_plan_many_dft_c2r(rank, &dim_vec_[0], this->howmany_, (fftw_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, &out[0], nullptr, 1, N1 / this->howmany_, FFTW_ESTIMATE);
+        entry.plan = fftw_plan_many_dft_c2r(rank, &dim_vec_[0], this->howmany_, (fftw_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, &out[0], nullptr, 1, N1 / this->howmany_, planner_flags | FFTW_PRESERVE_INPUT);
       }
-      copy_input = true;
-    }
-    }
+      if (!entry.plan) { // Build plan without FFTW_PRESERVE_INPUT
+        if (fft_type == FFT_Type::R2C) {
+          entry.plan = fftw_plan_many_dft_r2c(rank, &dim_vec_[0], this->howmany_, &in[0], nullptr, 1, N0 / this->howmany_, (fftw_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, planner_flags);
+        } else if (fft_type == FFT_Type::C2C) {
+          entry.plan = fftw_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftw_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftw_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_FORWARD, planner_flags);
+        } else if (fft_type == FFT_Type::C2C_INV) {
+          entry.plan = fftw_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftw_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftw_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_BACKWARD, planner_flags);
+        } else if (fft_type == FFT_Type::C2R) {
+          entry.plan = fftw_plan_many_dft_c2r(rank, &dim_vec_[0], this->howmany_, (fftw_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, &out[0], nullptr, 1, N1 / this->howmany_, planner_flags);
+        }
+        entry.copy_input = true;
+      }
+      return entry;
+    };
+    const auto& entry = FFTWPlanCache<fftw_plan>::Lookup(FFTWPlanKey(fft_type, this->howmany_, dim_vec, Nthreads, GetPlanRigor()), create_plan, fftw_destroy_plan);
+    plan.fftwplan = entry.plan;
+    copy_input = entry.copy_input;
     SCTL_ASSERT(plan.fftwplan);
   }
 
+  template <> inline bool FFT<double>::ImportWisdom(const std::string& fname) {
+    int ret = 0;
+    #pragma omp critical(SCTL_FFTW_PLAN)
+    ret = fftw_import_wisdom_from_filename(fname.c_str());
+    return ret != 0;
+  }
+
+  template <> inline bool FFT<double>::ExportWisdom(const std::string& fname) {
+    int ret = 0;
+    #pragma omp critical(SCTL_FFTW_PLAN)
+    ret = fftw_export_wisdom_to_filename(fname.c_str());
+    return ret != 0;
+  }
+
   template <> inline void FFT<double>::Execute(const Vector<double>& in, Vector<double>& out) const {
+    if (dist_plan) {
+      ExecuteDist(in, out);
+      return;
+    }
+
     using ValueType = double;
     Long N0 = Dim(0);
     Long N1 = Dim(1);
@@ -335,11 +1068,14 @@ namespace sctl {
   };
 
   template <> inline FFT<float>::~FFT() {
-    if (plan.fftwplan) fftwf_destroy_plan(plan.fftwplan);
-    plan.fftwplan = nullptr;
+    plan.fftwplan = nullptr; // owned by FFTWPlanCache
   }
 
   template <> inline void FFT<float>::Setup(FFT_Type fft_type_, Long howmany_, const Vector<Long>& dim_vec, Integer Nthreads) {
+    dist_plan.reset();
+    local_range[0] = 0;
+    local_range[1] = (dim_vec.Dim() ? dim_vec[0] : 0);
+
     fft_type = fft_type_;
     this->howmany_ = howmany_;
     copy_input = false;
@@ -374,39 +1110,60 @@ namespace sctl {
     dim[0] = N0;
     dim[1] = N1;
     if (!N0 || !N1) return;
-    Vector<float> in (N0), out(N1);
-
-    #pragma omp critical(SCTL_FFTW_PLAN)
-    {
-    FFTWInitThreads(Nthreads);
-    if (plan.fftwplan) fftwf_destroy_plan(plan.fftwplan);
-    plan.fftwplan = nullptr;
-    if (fft_type == FFT_Type::R2C) {
-      plan.fftwplan = fftwf_plan_many_dft_r2c(rank, &dim_vec_[0], this->howmany_, &in[0], nullptr, 1, N0 / this->howmany_, (fftwf_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_ESTIMATE | FFTW_PRESERVE_INPUT);
-    } else if (fft_type == FFT_Type::C2C) {
-      plan.fftwplan = fftwf_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftwf_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftwf_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_FORWARD, FFTW_ESTIMATE | FFTW_PRESERVE_INPUT);
-    } else if (fft_type == FFT_Type::C2C_INV) {
-      plan.fftwplan = fftwf_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftwf_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftwf_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_BACKWARD, FFTW_ESTIMATE | FFTW_PRESERVE_INPUT);
-    } else if (fft_type == FFT_Type::C2R) {
-      plan.fftwplan = fftwf_plan_many_dft_c2r(rank, &dim_vec_[0], this->howmany_, (fftwf_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, &out[0], nullptr, 1, N1 / this->howmany_, FFTW_ESTIMATE | FFTW_PRESERVE_INPUT);
-    }
-    if (!plan.fftwplan) { // Build plan without FFTW_PRESERVE_INPUT
+    const unsigned planner_flags = FFTWPlannerFlags(GetPlanRigor());
+    const auto create_plan = [&]() {
+      FFTWPlanEntry<fftwf_plan> entry;
+      Vector<float> in(N0), out(N1);
+      FFTWInitThreads(Nthreads);
       if (fft_type == FFT_Type::R2C) {
-        plan.fftwplan = fftwf_plan_many_dft_r2c(rank, &dim_vec_[0], this->howmany_, &in[0], nullptr, 1, N0 / this->howmany_, (fftwf_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_ESTIMATE);
+        entry.plan = fftwf_plan_many_dft_r2c(rank, &dim_vec_[0], this->howmany_, &in[0], nullptr, 1, N0 / this->howmany_, (fftwf_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, planner_flags | FFTW_PRESERVE_INPUT);
       } else if (fft_type == FFT_Type::C2C) {
-        plan.fftwplan = fftwf_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftwf_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftwf_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_FORWARD, FFTW_ESTIMATE);
+        entry.plan = fftwf_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftwf_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftwf_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_FORWARD, planner_flags | FFTW_PRESERVE_INPUT);
       } else if (fft_type == FFT_Type::C2C_INV) {
-        plan.fftwplan = fftwf_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftwf_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftwf_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_BACKWARD, FFTW_ESTIMATE);
+        entry.plan = fftwf_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftwf_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftwf_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_BACKWARD, planner_flags | FFTW_PRESERVE_INPUT);
       } else if (fft_type == FFT_Type::C2R) {
-        plan.fftwplan = fftwf_plan_many_dft_c2r(rank, &dim_vec_[0], this->howmany_, (fftwf_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, &out[0], nullptr, 1, N1 / this->howmany_, FFTW_ESTIMATE);
+        entry.plan = fftwf_plan_many_dft_c2r(rank, &dim_vec_[0], this->howmany_, (fftwf_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, &out[0], nullptr, 1, N1 / this->howmany_, planner_flags | FFTW_PRESERVE_INPUT);
       }
-      copy_input = true;
-    }
-    }
+      if (!entry.plan) { // Build plan without FFTW_PRESERVE_INPUT
+        if (fft_type == FFT_Type::R2C) {
+          entry.plan = fftwf_plan_many_dft_r2c(rank, &dim_vec_[0], this->howmany_, &in[0], nullptr, 1, N0 / this->howmany_, (fftwf_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, planner_flags);
+        } else if (fft_type == FFT_Type::C2C) {
+          entry.plan = fftwf_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftwf_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftwf_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_FORWARD, planner_flags);
+        } else if (fft_type == FFT_Type::C2C_INV) {
+          entry.plan = fftwf_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftwf_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftwf_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_BACKWARD, planner_flags);
+        } else if (fft_type == FFT_Type::C2R) {
+          entry.plan = fftwf_plan_many_dft_c2r(rank, &dim_vec_[0], this->howmany_, (fftwf_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, &out[0], nullptr, 1, N1 / this->howmany_, planner_flags);
+        }
+        entry.copy_input = true;
+      }
+      return entry;
+    };
+    const auto& entry = FFTWPlanCache<fftwf_plan>::Lookup(FFTWPlanKey(fft_type, this->howmany_, dim_vec, Nthreads, GetPlanRigor()), create_plan, fftwf_destroy_plan);
+    plan.fftwplan = entry.plan;
+    copy_input = entry.copy_input;
     SCTL_ASSERT(plan.fftwplan);
   }
 
+  template <> inline bool FFT<float>::ImportWisdom(const std::string& fname) {
+    int ret = 0;
+    #pragma omp critical(SCTL_FFTW_PLAN)
+    ret = fftwf_import_wisdom_from_filename(fname.c_str());
+    return ret != 0;
+  }
+
+  template <> inline bool FFT<float>::ExportWisdom(const std::string& fname) {
+    int ret = 0;
+    #pragma omp critical(SCTL_FFTW_PLAN)
+    ret = fftwf_export_wisdom_to_filename(fname.c_str());
+    return ret != 0;
+  }
+
   template <> inline void FFT<float>::Execute(const Vector<float>& in, Vector<float>& out) const {
+    if (dist_plan) {
+      ExecuteDist(in, out);
+      return;
+    }
+
     using ValueType = float;
     Long N0 = Dim(0);
     Long N1 = Dim(1);
@@ -448,11 +1205,14 @@ namespace sctl {
   };
 
   template <> inline FFT<long double>::~FFT() {
-    if (plan.fftwplan) fftwl_destroy_plan(plan.fftwplan);
-    plan.fftwplan = nullptr;
+    plan.fftwplan = nullptr; // owned by FFTWPlanCache
   }
 
   template <> inline void FFT<long double>::Setup(FFT_Type fft_type_, Long howmany_, const Vector<Long>& dim_vec, Integer Nthreads) {
+    dist_plan.reset();
+    local_range[0] = 0;
+    local_range[1] = (dim_vec.Dim() ? dim_vec[0] : 0);
+
     fft_type = fft_type_;
     this->howmany_ = howmany_;
     copy_input = false;
@@ -485,39 +1245,60 @@ namespace sctl {
     dim[0] = N0;
     dim[1] = N1;
     if (!N0 || !N1) return;
-    Vector<long double> in (N0), out(N1);
-
-    #pragma omp critical(SCTL_FFTW_PLAN)
-    {
-    FFTWInitThreads(Nthreads);
-    if (plan.fftwplan) fftwl_destroy_plan(plan.fftwplan);
-    plan.fftwplan = nullptr;
-    if (fft_type == FFT_Type::R2C) {
-      plan.fftwplan = fftwl_plan_many_dft_r2c(rank, &dim_vec_[0], this->howmany_, &in[0], nullptr, 1, N0 / this->howmany_, (fftwl_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_ESTIMATE | FFTW_PRESERVE_INPUT);
-    } else if (fft_type == FFT_Type::C2C) {
-      plan.fftwplan = fftwl_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftwl_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftwl_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_FORWARD, FFTW_ESTIMATE | FFTW_PRESERVE_INPUT);
-    } else if (fft_type == FFT_Type::C2C_INV) {
-      plan.fftwplan = fftwl_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftwl_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftwl_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_BACKWARD, FFTW_ESTIMATE | FFTW_PRESERVE_INPUT);
-    } else if (fft_type == FFT_Type::C2R) {
-      plan.fftwplan = fftwl_plan_many_dft_c2r(rank, &dim_vec_[0], this->howmany_, (fftwl_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, &out[0], nullptr, 1, N1 / this->howmany_, FFTW_ESTIMATE | FFTW_PRESERVE_INPUT);
-    }
-    if (!plan.fftwplan) { // Build plan without FFTW_PRESERVE_INPUT
+    const unsigned planner_flags = FFTWPlannerFlags(GetPlanRigor());
+    const auto create_plan = [&]() {
+      FFTWPlanEntry<fftwl_plan> entry;
+      Vector<long double> in(N0), out(N1);
+      FFTWInitThreads(Nthreads);
       if (fft_type == FFT_Type::R2C) {
-        plan.fftwplan = fftwl_plan_many_dft_r2c(rank, &dim_vec_[0], this->howmany_, &in[0], nullptr, 1, N0 / this->howmany_, (fftwl_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_ESTIMATE);
+        entry.plan = fftwl_plan_many_dft_r2c(rank, &dim_vec_[0], this->howmany_, &in[0], nullptr, 1, N0 / this->howmany_, (fftwl_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, planner_flags | FFTW_PRESERVE_INPUT);
       } else if (fft_type == FFT_Type::C2C) {
-        plan.fftwplan = fftwl_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftwl_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftwl_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_FORWARD, FFTW_ESTIMATE);
+        entry.plan = fftwl_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftwl_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftwl_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_FORWARD, planner_flags | FFTW_PRESERVE_INPUT);
       } else if (fft_type == FFT_Type::C2C_INV) {
-        plan.fftwplan = fftwl_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftwl_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftwl_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_BACKWARD, FFTW_ESTIMATE);
+        entry.plan = fftwl_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftwl_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftwl_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_BACKWARD, planner_flags | FFTW_PRESERVE_INPUT);
       } else if (fft_type == FFT_Type::C2R) {
-        plan.fftwplan = fftwl_plan_many_dft_c2r(rank, &dim_vec_[0], this->howmany_, (fftwl_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, &out[0], nullptr, 1, N1 / this->howmany_, FFTW_ESTIMATE);
+        entry.plan = fftwl_plan_many_dft_c2r(rank, &dim_vec_[0], this->howmany_, (fftwl_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, &out[0], nullptr, 1, N1 / this->howmany_, planner_flags | FFTW_PRESERVE_INPUT);
       }
-      copy_input = true;
-    }
-    }
+      if (!entry.plan) { // Build plan without FFTW_PRESERVE_INPUT
+        if (fft_type == FFT_Type::R2C) {
+          entry.plan = fftwl_plan_many_dft_r2c(rank, &dim_vec_[0], this->howmany_, &in[0], nullptr, 1, N0 / this->howmany_, (fftwl_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, planner_flags);
+        } else if (fft_type == FFT_Type::C2C) {
+          entry.plan = fftwl_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftwl_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftwl_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_FORWARD, planner_flags);
+        } else if (fft_type == FFT_Type::C2C_INV) {
+          entry.plan = fftwl_plan_many_dft(rank, &dim_vec_[0], this->howmany_, (fftwl_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, (fftwl_complex*)&out[0], nullptr, 1, N1 / 2 / this->howmany_, FFTW_BACKWARD, planner_flags);
+        } else if (fft_type == FFT_Type::C2R) {
+          entry.plan = fftwl_plan_many_dft_c2r(rank, &dim_vec_[0], this->howmany_, (fftwl_complex*)&in[0], nullptr, 1, N0 / 2 / this->howmany_, &out[0], nullptr, 1, N1 / this->howmany_, planner_flags);
+        }
+        entry.copy_input = true;
+      }
+      return entry;
+    };
+    const auto& entry = FFTWPlanCache<fftwl_plan>::Lookup(FFTWPlanKey(fft_type, this->howmany_, dim_vec, Nthreads, GetPlanRigor()), create_plan, fftwl_destroy_plan);
+    plan.fftwplan = entry.plan;
+    copy_input = entry.copy_input;
     SCTL_ASSERT(plan.fftwplan);
   }
 
+  template <> inline bool FFT<long double>::ImportWisdom(const std::string& fname) {
+    int ret = 0;
+    #pragma omp critical(SCTL_FFTW_PLAN)
+    ret = fftwl_import_wisdom_from_filename(fname.c_str());
+    return ret != 0;
+  }
+
+  template <> inline bool FFT<long double>::ExportWisdom(const std::string& fname) {
+    int ret = 0;
+    #pragma omp critical(SCTL_FFTW_PLAN)
+    ret = fftwl_export_wisdom_to_filename(fname.c_str());
+    return ret != 0;
+  }
+
   template <> inline void FFT<long double>::Execute(const Vector<long double>& in, Vector<long double>& out) const {
+    if (dist_plan) {
+      ExecuteDist(in, out);
+      return;
+    }
+
     using ValueType = long double;
     Long N0 = Dim(0);
     Long N1 = Dim(1);
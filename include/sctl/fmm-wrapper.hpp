@@ -40,9 +40,16 @@ enum class Periodicity : uint8_t {
 };
 
 /**
- * Evaluate potentials from particle sources using PVFMM when available, otherwise, use direct
- * computation.  To enable PVFMM, the macro `SCTL_HAVE_PVFMM` must be defined, the code must be
- * compiled with MPI and linked to PVFMM.
+ * Evaluate potentials from particle sources using PVFMM when available, otherwise, use the built-in
+ * kernel-independent FMM (3D only). To enable PVFMM, the macro `SCTL_HAVE_PVFMM` must be defined,
+ * the code must be compiled with MPI and linked to PVFMM. Small problems (fewer than 40000 targets)
+ * are evaluated directly.
+ *
+ * The built-in FMM uses a PtTree octree (with the halo of ghost nodes for the distributed
+ * interaction lists), equivalent and check surfaces of order p (p^2 points per face, from p = 4
+ * for 3 digits to p = 12 for 8 digits), and FFT based M2L translations. The accuracy is limited to
+ * about 8 digits. Translation operators are precomputed once for
+ * scale-invariant kernels (e.g. Laplace, Stokes) and for each level of the tree otherwise.
  */
 template <class Real, Integer DIM> class ParticleFMM {
   public:
@@ -116,6 +123,21 @@ template <class Real, Integer DIM> class ParticleFMM {
      */
     Integer GetAccuracy() const;
 
+    /**
+     * Enable incremental updates of the FMM setup for moving particles (built-in FMM only). When
+     * the coordinates are changed with SetSrcCoord or SetTrgCoord, the particles are sorted into
+     * the leaves of the existing tree and the translation operators and interaction lists are
+     * reused. The tree is rebuilt only when particles leave the root box, when a leaf has more than
+     * twice the number of points used for refinement, or when a non-leaf box has fewer than half
+     * (in the latter cases, the tree is refined again in its current partition, see
+     * Tree::UpdateRefinement). Otherwise, with more than one process, the leaves of the tree are
+     * repartitioned with the local compute time measured in the previous evaluation (see
+     * Tree::Repartition), so that the partition follows the actual cost of the moving particles.
+     *
+     * @param[in] enable enable incremental updates (disabled by default).
+     */
+    void SetIncrementalUpdate(bool enable);
+
     /**
      * Set kernel objects for KIFMM.
      *
@@ -185,6 +207,15 @@ template <class Real, Integer DIM> class ParticleFMM {
      */
     void SetSrcDensity(const std::string& name, const Vector<Real>& src_density);
 
+    /**
+     * Set a batch of densities for a source type. The potentials for all densities in the batch
+     * are computed together by Eval(Matrix<Real>&, const std::string&).
+     *
+     * @param[in] name name for the source type.
+     * @param[in] src_density densities for the source particles, one density per row in AoS order.
+     */
+    void SetSrcDensity(const std::string& name, const Matrix<Real>& src_density);
+
     /**
      * Set coordinates for a target type.
      *
@@ -209,6 +240,27 @@ template <class Real, Integer DIM> class ParticleFMM {
      */
     void EvalDirect(Vector<Real>& U, const std::string& trg_name) const;
 
+    /**
+     * Evaluate the potentials for a batch of source densities (set using
+     * SetSrcDensity(const std::string&, const Matrix<Real>&)). All source types must have the same
+     * number of densities. Defaults to direct evaluation when FMM not available. With the built-in
+     * FMM, the tree traversal, communication and translation operators are shared by all densities
+     * (the translations are applied as GEMMs with one row per density and node).
+     *
+     * @param[out] U the computed potentials, one row for each density.
+     * @param[in] trg_name name for the target type.
+     */
+    void Eval(Matrix<Real>& U, const std::string& trg_name) const;
+
+    /**
+     * Evaluate the potentials for a batch of source densities using direct evaluation. The kernel
+     * is evaluated once for each source-target pair and applied to all densities.
+     *
+     * @param[out] U the computed potentials, one row for each density.
+     * @param[in] trg_name name for the target type.
+     */
+    void EvalDirect(Matrix<Real>& U, const std::string& trg_name) const;
+
     /**
      * Example code showing usage of class ParticleFMM.
      */
@@ -225,14 +277,28 @@ template <class Real, Integer DIM> class ParticleFMM {
 
     template <class Ker> static void DeleteKer(Iterator<char> ker);
 
+    template <class Ker> static void KerMatrix(Matrix<Real>& M, const Vector<Real>& Xt, const Vector<Real>& Xs, const Vector<Real>& Xn, Iterator<char> ker);
+
     void CheckKernelDims() const;
 
+    Long DensityCount(const std::string& trg_name) const;
+
     void DeleteS2T(const std::string& src_name, const std::string& trg_name);
 
     #ifdef SCTL_HAVE_PVFMM
     template <class SCTLKernel, bool use_dummy_normal=false> struct PVFMMKernelFn; // construct PVFMMKernel from SCTLKernel
 
-    void EvalPVFMM(Vector<Real>& U, const std::string& trg_name) const;
+    void EvalPVFMM(Vector<Real>& U, const std::string& trg_name, Long dens_idx = 0) const;
+    #else
+    struct KIFMMData; // tree, interaction lists and translation operators of the built-in FMM
+
+    static bool KIFMMScaling(Vector<Real>& src_exp, Vector<Real>& trg_exp, const Matrix<Real>& M1, const Matrix<Real>& M2, Integer kdim0, Integer kdim1);
+
+    void SetupKIFMM(KIFMMData& data, const SrcData& src_data, const TrgData& trg_data, bool setup_ker, bool setup_tree) const;
+
+    void SetupKIFMMOperators(KIFMMData& data, Integer max_depth) const;
+
+    void EvalKIFMM(Matrix<Real>& U, const std::string& trg_name) const;
     #endif
 
     FMMKernels fmm_ker;
@@ -244,6 +310,7 @@ template <class Real, Integer DIM> class ParticleFMM {
     Integer digits_;
     Periodicity periodicity_ = Periodicity::NONE;
     Real period_length_ = 0;
+    bool incremental_ = false;
 };
 
 }  // end namespace
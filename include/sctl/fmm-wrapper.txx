@@ -1,28 +1,39 @@
 #ifndef _SCTL_FMM_WRAPPER_TXX_
 #define _SCTL_FMM_WRAPPER_TXX_
 
+#include <omp.h>                      // for omp_get_wtime
 #include <stdlib.h>                   // for drand48, srand48
 #include <algorithm>                  // for max, min
 #include <iostream>                   // for basic_ostream, operator<<, cout
 #include <map>                        // for map
 #include <string>                     // for basic_string, string
 #include <utility>                    // for pair, make_pair
+#include <vector>                     // for vector
 
 #include "sctl/common.hpp"            // for Integer, SCTL_ASSERT, Long, SCT...
 #include "sctl/fmm-wrapper.hpp"       // for ParticleFMM
 #include "sctl/comm.hpp"              // for Comm, CommOp
 #include "sctl/comm.txx"              // for Comm::Allreduce, Comm::Rank
+#include "sctl/fft_wrapper.hpp"       // for FFT, FFT_Type
+#include "sctl/fft_wrapper.txx"       // for FFT::Setup, FFT::Execute
 #include "sctl/iterator.hpp"          // for Iterator, ConstIterator
 #include "sctl/iterator.txx"          // for NullIterator, Iterator::operator*
 #include "sctl/kernel_functions.hpp"  // for Stokes3D_DxU, Stokes3D_FSxU
 #include "sctl/math_utils.hpp"        // for fabs, log, sqrt
 #include "sctl/math_utils.txx"        // for pow, machine_eps
 #include "sctl/matrix.hpp"            // for Matrix
+#include "sctl/matrix.txx"            // for Matrix::pinv, Matrix::GEMM
 #include "sctl/mem_mgr.txx"           // for aligned_new, aligned_delete
+#include "sctl/metrics.hpp"           // for Metrics, Metric
+#include "sctl/metrics.txx"           // for Metrics::Scoped
+#include "sctl/morton.hpp"            // for Morton
+#include "sctl/morton.txx"            // for Morton::Coord, Morton::Depth
 #include "sctl/profile.hpp"           // for Profile
 #include "sctl/profile.txx"           // for Profile::Tic, Profile::Toc, Pro...
 #include "sctl/static-array.hpp"      // for StaticArray
 #include "sctl/static-array.txx"      // for StaticArray::operator[], Static...
+#include "sctl/tree.hpp"              // for PtTree
+#include "sctl/tree.txx"              // for PtTree::AddParticles, PtTree::U...
 #include "sctl/vector.hpp"            // for Vector
 #include "sctl/vector.txx"            // for Vector::PushBack, Vector::Vecto...
 
@@ -90,6 +101,26 @@ template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::test(const Comm&
     comm.Allreduce<Real>(loc_err, glb_err, 2, CommOp::MAX);
     if (!comm.Rank()) std::cout<<"Maximum relative error: "<<glb_err[0]/glb_err[1]<<'\n';
   }
+
+  { // Batch of densities
+    const Long Nd = 3;
+    Matrix<Real> dl_den_batch(Nd, dl_den.Dim()), Ubatch;
+    for (auto& a : dl_den_batch) a = (Real)(drand48() - 0.5);
+    fmm.SetSrcDensity("DoubleLayer", dl_den_batch);
+    fmm.Eval(Ubatch, "Velocity");
+
+    StaticArray<Real,2> loc_err{0,0}, glb_err{0,0};
+    for (Long d = 0; d < Nd; d++) {
+      fmm.SetSrcDensity("DoubleLayer", Vector<Real>(dl_den.Dim(), dl_den_batch[d], false));
+      fmm.EvalDirect(Uref, "Velocity");
+      for (Long i = 0; i < Uref.Dim(); i++) {
+        loc_err[0] = std::max<Real>(loc_err[0], fabs(Ubatch[d][i] - Uref[i]));
+        loc_err[1] = std::max<Real>(loc_err[1], fabs(Uref[i]));
+      }
+    }
+    comm.Allreduce<Real>(loc_err, glb_err, 2, CommOp::MAX);
+    if (!comm.Rank()) std::cout<<"Maximum relative error (batch of "<<Nd<<" densities): "<<glb_err[0]/glb_err[1]<<'\n';
+  }
 }
 
 template <class Real, Integer DIM> struct ParticleFMM<Real,DIM>::FMMKernels {
@@ -101,6 +132,10 @@ template <class Real, Integer DIM> struct ParticleFMM<Real,DIM>::FMMKernels {
   void (*ker_m2l_eval)(Vector<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src, Integer digits, ConstIterator<char> self);
   void (*ker_l2l_eval)(Vector<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src, Integer digits, ConstIterator<char> self);
 
+  void (*ker_m2m_matrix)(Matrix<Real>& M, const Vector<Real>& Xt, const Vector<Real>& Xs, const Vector<Real>& Xn, Iterator<char> ker);
+  void (*ker_m2l_matrix)(Matrix<Real>& M, const Vector<Real>& Xt, const Vector<Real>& Xs, const Vector<Real>& Xn, Iterator<char> ker);
+  void (*ker_l2l_matrix)(Matrix<Real>& M, const Vector<Real>& Xt, const Vector<Real>& Xs, const Vector<Real>& Xn, Iterator<char> ker);
+
   void (*delete_ker_m2m)(Iterator<char> ker);
   void (*delete_ker_m2l)(Iterator<char> ker);
   void (*delete_ker_l2l)(Iterator<char> ker);
@@ -112,12 +147,15 @@ template <class Real, Integer DIM> struct ParticleFMM<Real,DIM>::FMMKernels {
   #endif
 };
 template <class Real, Integer DIM> struct ParticleFMM<Real,DIM>::SrcData {
-  Vector<Real> X, Xn, F;
+  Vector<Real> X, Xn, F; // for a batch of densities, F = {F[0][0..SrcDim), F[1][0..SrcDim), ...} for each source
+  Long dens_cnt; // number of densities in F
   Iterator<char> ker_s2m, ker_s2l;
   Integer dim_src, dim_mul_ch, dim_loc_ch, dim_normal;
 
   void (*ker_s2m_eval)(Vector<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src, Integer digits, ConstIterator<char> self);
   void (*ker_s2l_eval)(Vector<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src, Integer digits, ConstIterator<char> self);
+  void (*ker_s2m_eval_batch)(Matrix<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Matrix<Real>& v_src, Integer digits, ConstIterator<char> self);
+  void (*ker_s2l_eval_batch)(Matrix<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Matrix<Real>& v_src, Integer digits, ConstIterator<char> self);
 
   void (*delete_ker_s2m)(Iterator<char> ker);
   void (*delete_ker_s2l)(Iterator<char> ker);
@@ -135,6 +173,8 @@ template <class Real, Integer DIM> struct ParticleFMM<Real,DIM>::TrgData {
 
   void (*ker_m2t_eval)(Vector<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src, Integer digits, ConstIterator<char> self);
   void (*ker_l2t_eval)(Vector<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src, Integer digits, ConstIterator<char> self);
+  void (*ker_m2t_eval_batch)(Matrix<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Matrix<Real>& v_src, Integer digits, ConstIterator<char> self);
+  void (*ker_l2t_eval_batch)(Matrix<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Matrix<Real>& v_src, Integer digits, ConstIterator<char> self);
 
   void (*delete_ker_m2t)(Iterator<char> ker);
   void (*delete_ker_l2t)(Iterator<char> ker);
@@ -151,9 +191,14 @@ template <class Real, Integer DIM> struct ParticleFMM<Real,DIM>::S2TData {
 
   void (*ker_s2t_eval)(Vector<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src, Integer digits, ConstIterator<char> self);
   void (*ker_s2t_eval_omp)(Vector<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src, Integer digits, ConstIterator<char> self);
+  void (*ker_s2t_eval_batch)(Matrix<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Matrix<Real>& v_src, Integer digits, ConstIterator<char> self);
+  void (*ker_s2t_eval_batch_omp)(Matrix<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Matrix<Real>& v_src, Integer digits, ConstIterator<char> self);
 
   void (*delete_ker_s2t)(Iterator<char> ker);
 
+  mutable bool setup_tree;
+  mutable bool setup_ker;
+
   #ifdef SCTL_HAVE_PVFMM
   mutable Real bbox_scale;
   mutable StaticArray<Real,DIM> bbox_offset;
@@ -162,8 +207,8 @@ template <class Real, Integer DIM> struct ParticleFMM<Real,DIM>::S2TData {
   mutable pvfmm::Kernel<Real> pvfmm_ker_s2t;
   mutable pvfmm::PtFMM_Tree<Real>* tree_ptr;
   mutable pvfmm::PtFMM<Real> fmm_ctx;
-  mutable bool setup_tree;
-  mutable bool setup_ker;
+  #else
+  KIFMMData* kifmm;
   #endif
 };
 
@@ -225,14 +270,16 @@ template <class Real, Integer DIM> ParticleFMM<Real,DIM>::~ParticleFMM() {
 
 template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::SetComm(const Comm& comm) {
   comm_ = comm;
-  #ifdef SCTL_HAVE_PVFMM
-  if (DIM == 3) {
-    for (auto& it : s2t_map) {
-      it.second.setup_ker = true;
-      it.second.setup_tree = true;
+  for (auto& it : s2t_map) {
+    it.second.setup_ker = true;
+    it.second.setup_tree = true;
+    #ifndef SCTL_HAVE_PVFMM
+    if (it.second.kifmm->tree) { // the tree cannot be reused with a different communicator
+      delete it.second.kifmm->tree;
+      it.second.kifmm->tree = nullptr;
     }
+    #endif
   }
-  #endif
 }
 
 template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::SetPeriodicity(Periodicity p, Real period_length) {
@@ -265,20 +312,19 @@ template <class Real, Integer DIM> Real ParticleFMM<Real,DIM>::GetPeriodLength()
 template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::SetAccuracy(Integer digits) {
   if (digits_ == digits) return;
   digits_ = digits;
-
-  #ifdef SCTL_HAVE_PVFMM
-  if (DIM == 3) {
-    for (auto& it : s2t_map) {
-      it.second.setup_ker = true;
-    }
+  for (auto& it : s2t_map) {
+    it.second.setup_ker = true;
   }
-  #endif
 }
 
 template <class Real, Integer DIM> Integer ParticleFMM<Real,DIM>::GetAccuracy() const {
   return digits_;
 }
 
+template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::SetIncrementalUpdate(bool enable) {
+  incremental_ = enable;
+}
+
 template <class Real, Integer DIM> template <class KerM2M, class KerM2L, class KerL2L> void ParticleFMM<Real,DIM>::SetKernels(const KerM2M& ker_m2m, const KerM2L& ker_m2l, const KerL2L& ker_l2l, const VolPotenT m2l_vol_poten) {
   if (fmm_ker.ker_m2m != NullIterator<char>()) fmm_ker.delete_ker_m2m(fmm_ker.ker_m2m);
   if (fmm_ker.ker_m2l != NullIterator<char>()) fmm_ker.delete_ker_m2l(fmm_ker.ker_m2l);
@@ -305,6 +351,10 @@ template <class Real, Integer DIM> template <class KerM2M, class KerM2L, class K
   fmm_ker.ker_m2l_eval = KerM2L::template Eval<Real,false>;
   fmm_ker.ker_l2l_eval = KerL2L::template Eval<Real,false>;
 
+  fmm_ker.ker_m2m_matrix = KerMatrix<KerM2M>;
+  fmm_ker.ker_m2l_matrix = KerMatrix<KerM2L>;
+  fmm_ker.ker_l2l_matrix = KerMatrix<KerL2L>;
+
   fmm_ker.delete_ker_m2m = DeleteKer<KerM2M>;
   fmm_ker.delete_ker_m2l = DeleteKer<KerM2L>;
   fmm_ker.delete_ker_l2l = DeleteKer<KerL2L>;
@@ -327,16 +377,17 @@ template <class Real, Integer DIM> template <class KerM2M, class KerM2L, class K
       fmm_ker.pvfmm_ker_m2l = pvfmm::BuildKernel<Real, PVFMMKernelFn<KerM2L>::template Eval<Real>>(ker_m2l.Name().c_str(), DIM, std::pair<int,int>(ker_m2l.SrcDim(), ker_m2l.TrgDim()));
     }
     fmm_ker.pvfmm_ker_l2l = pvfmm::BuildKernel<Real, PVFMMKernelFn<KerL2L>::template Eval<Real>>(ker_l2l.Name().c_str(), DIM, std::pair<int,int>(ker_l2l.SrcDim(), ker_l2l.TrgDim()));
-    for (auto& it : s2t_map) {
-      it.second.setup_ker = true;
-    }
   }
   #endif
+  for (auto& it : s2t_map) {
+    it.second.setup_ker = true;
+  }
 }
 template <class Real, Integer DIM> template <class KerS2M, class KerS2L> void ParticleFMM<Real,DIM>::AddSrc(const std::string& name, const KerS2M& ker_s2m, const KerS2L& ker_s2l) {
   SCTL_ASSERT_MSG(src_map.find(name) == src_map.end(), "Source name already exists.");
   src_map[name] = SrcData();
   auto& data = src_map[name];
+  data.dens_cnt = 1;
 
   data.ker_s2m = (Iterator<char>)aligned_new<KerS2M>(1);
   data.ker_s2l = (Iterator<char>)aligned_new<KerS2L>(1);
@@ -355,6 +406,8 @@ template <class Real, Integer DIM> template <class KerS2M, class KerS2L> void Pa
 
   data.ker_s2m_eval = KerS2M::template Eval<Real,false>;
   data.ker_s2l_eval = KerS2L::template Eval<Real,false>;
+  data.ker_s2m_eval_batch = KerS2M::template Eval<Real,false>;
+  data.ker_s2l_eval_batch = KerS2L::template Eval<Real,false>;
 
   data.delete_ker_s2m = DeleteKer<KerS2M>;
   data.delete_ker_s2l = DeleteKer<KerS2L>;
@@ -396,6 +449,8 @@ template <class Real, Integer DIM> template <class KerM2T, class KerL2T> void Pa
 
   data.ker_m2t_eval = KerM2T::template Eval<Real,false>;
   data.ker_l2t_eval = KerL2T::template Eval<Real,false>;
+  data.ker_m2t_eval_batch = KerM2T::template Eval<Real,false>;
+  data.ker_l2t_eval_batch = KerL2T::template Eval<Real,false>;
 
   data.delete_ker_m2t = DeleteKer<KerM2T>;
   data.delete_ker_l2t = DeleteKer<KerL2T>;
@@ -444,6 +499,8 @@ template <class Real, Integer DIM> template <class KerS2T> void ParticleFMM<Real
 
   data.ker_s2t_eval = KerS2T::template Eval<Real,false>;
   data.ker_s2t_eval_omp = KerS2T::template Eval<Real,true>;
+  data.ker_s2t_eval_batch = KerS2T::template Eval<Real,false>;
+  data.ker_s2t_eval_batch_omp = KerS2T::template Eval<Real,true>;
   data.delete_ker_s2t = DeleteKer<KerS2T>;
 
   #ifdef SCTL_HAVE_PVFMM
@@ -456,8 +513,11 @@ template <class Real, Integer DIM> template <class KerS2T> void ParticleFMM<Real
     }
   }
   data.tree_ptr = nullptr;
-  data.setup_ker = true;
+  #else
+  data.kifmm = new KIFMMData();
   #endif
+  data.setup_ker = true;
+  data.setup_tree = true;
 }
 
 template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::DeleteSrc(const std::string& name) {
@@ -491,6 +551,8 @@ template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::DeleteS2T(const s
 
   #ifdef SCTL_HAVE_PVFMM
   if (data.tree_ptr) delete data.tree_ptr;
+  #else
+  delete data.kifmm;
   #endif
 
   data.delete_ker_s2t(data.ker_s2t);
@@ -502,48 +564,108 @@ template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::SetSrcCoord(const
   auto& data = src_map[name];
   data.X = src_coord;
   data.Xn = src_normal;
+  for (auto& it : s2t_map) {
+    if (it.first.first != name) continue;
+    it.second.setup_tree = true;
+  }
 
   #ifdef SCTL_HAVE_PVFMM
-  if (DIM == 3) {
-    BoundingBox<DIM>(data.bbox, src_coord, comm_);
-    for (auto& it : s2t_map) {
-      if (it.first.first != name) continue;
-      it.second.setup_tree = true;
-    }
-  }
+  if (DIM == 3) BoundingBox<DIM>(data.bbox, src_coord, comm_);
   #endif
 }
 template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::SetSrcDensity(const std::string& name, const Vector<Real>& src_density) {
   SCTL_ASSERT_MSG(src_map.find(name) != src_map.end(), "Source name does not exist.");
   auto& data = src_map[name];
   data.F = src_density;
+  data.dens_cnt = 1;
+}
+template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::SetSrcDensity(const std::string& name, const Matrix<Real>& src_density) {
+  SCTL_ASSERT_MSG(src_map.find(name) != src_map.end(), "Source name does not exist.");
+  auto& data = src_map[name];
+  const Long Nd = src_density.Dim(0);
+  const Long N = src_density.Dim(1) / data.dim_src;
+  SCTL_ASSERT(src_density.Dim(1) == N * data.dim_src);
+  SCTL_ASSERT_MSG(Nd > 0, "Density batch must not be empty.");
+
+  const Long SrcDim = data.dim_src;
+  if (data.F.Dim() != N * Nd * SrcDim) data.F.ReInit(N * Nd * SrcDim);
+  for (Long i = 0; i < N; i++) { // F[i][d][k] <-- src_density[d][i][k]
+    for (Long d = 0; d < Nd; d++) {
+      for (Long k = 0; k < SrcDim; k++) {
+        data.F[(i*Nd+d)*SrcDim+k] = src_density[d][i*SrcDim+k];
+      }
+    }
+  }
+  data.dens_cnt = Nd;
 }
 template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::SetTrgCoord(const std::string& name, const Vector<Real>& trg_coord) {
   SCTL_ASSERT_MSG(trg_map.find(name) != trg_map.end(), "Target name does not exist.");
   auto& data = trg_map[name];
   data.X = trg_coord;
+  for (auto& it : s2t_map) {
+    if (it.first.second != name) continue;
+    it.second.setup_tree = true;
+  }
 
   #ifdef SCTL_HAVE_PVFMM
-  if (DIM == 3) {
-    BoundingBox<DIM>(data.bbox, trg_coord, comm_);
-    for (auto& it : s2t_map) {
-      if (it.first.second != name) continue;
-      it.second.setup_tree = true;
-    }
-  }
+  if (DIM == 3) BoundingBox<DIM>(data.bbox, trg_coord, comm_);
   #endif
 }
 
 template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::Eval(Vector<Real>& U, const std::string& trg_name) const {
   CheckKernelDims();
+  SCTL_ASSERT_MSG(DensityCount(trg_name) == 1, "Source densities were set as a batch, use Eval(Matrix<Real>&, ...).");
 
   #ifdef SCTL_HAVE_PVFMM
+  Metrics::Scoped metrics_scope(Metric::FMM_EVAL_TIME);
   EvalPVFMM(U, trg_name);
   #else
-  EvalDirect(U, trg_name);
+  Matrix<Real> U_;
+  Eval(U_, trg_name);
+
+  const Long N = U_.Dim(0) * U_.Dim(1);
+  if (U.Dim() != N) U.ReInit(N);
+  if (N) memcopy(U.begin(), U_.begin(), N);
   #endif
 }
 template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::EvalDirect(Vector<Real>& U_, const std::string& trg_name) const {
+  SCTL_ASSERT_MSG(DensityCount(trg_name) == 1, "Source densities were set as a batch, use EvalDirect(Matrix<Real>&, ...).");
+  Matrix<Real> U;
+  EvalDirect(U, trg_name);
+
+  const Long N = U.Dim(0) * U.Dim(1);
+  if (U_.Dim() != N) U_.ReInit(N);
+  if (N) memcopy(U_.begin(), U.begin(), N);
+}
+template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::Eval(Matrix<Real>& U, const std::string& trg_name) const {
+  CheckKernelDims();
+  Metrics::Scoped metrics_scope(Metric::FMM_EVAL_TIME);
+
+  SCTL_ASSERT_MSG(trg_map.find(trg_name) != trg_map.end(), "Target name does not exist.");
+  const auto& trg_data = trg_map.at(trg_name);
+  const Long Nt = trg_data.X.Dim() / DIM;
+  StaticArray<Long,2> cnt{Nt,0};
+  comm_.Allreduce<Long>(cnt+0, cnt+1, 1, CommOp::SUM);
+  if (DIM != 3 || (periodicity_ == Periodicity::NONE && cnt[1] < 40000)) { // batched direct evaluation (same criteria as in EvalPVFMM)
+    EvalDirect(U, trg_name);
+  } else {
+    #ifdef SCTL_HAVE_PVFMM
+    // FMM for each density, the tree is reused
+    const Long Nd = DensityCount(trg_name);
+    const Long dof = Nt * trg_data.dim_trg;
+    if (U.Dim(0) != Nd || U.Dim(1) != dof) U.ReInit(Nd, dof);
+    Vector<Real> U_;
+    for (Long d = 0; d < Nd; d++) {
+      EvalPVFMM(U_, trg_name, d);
+      SCTL_ASSERT(U_.Dim() == dof);
+      if (dof) memcopy(U[d], U_.begin(), dof);
+    }
+    #else
+    EvalKIFMM(U, trg_name);
+    #endif
+  }
+}
+template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::EvalDirect(Matrix<Real>& U_, const std::string& trg_name) const {
   const Integer rank = comm_.Rank();
   const Integer np = comm_.Size();
 
@@ -551,11 +673,11 @@ template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::EvalDirect(Vector
   const auto& trg_data = trg_map.at(trg_name);
   const Integer TrgDim = trg_data.dim_trg;
   const auto& Xt_ = trg_data.X;
+  const Long Nd = DensityCount(trg_name);
 
   const Long Nt = Xt_.Dim() / DIM;
   SCTL_ASSERT(Xt_.Dim() == Nt * DIM);
-  if (U_.Dim() != Nt * TrgDim) U_.ReInit(Nt * TrgDim);
-  U_.SetZero();
+  if (U_.Dim(0) != Nd || U_.Dim(1) != Nt * TrgDim) U_.ReInit(Nd, Nt * TrgDim);
 
   auto partition = [this](Vector<Real>& X, const Long dof) {
     StaticArray<Long,2> cnt{X.Dim()/dof, 0};
@@ -565,7 +687,7 @@ template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::EvalDirect(Vector
   Vector<Real> Xt = Xt_;
   partition(Xt, DIM);
 
-  Vector<Real> U(Xt.Dim()/DIM * TrgDim);
+  Matrix<Real> U(Nd, Xt.Dim()/DIM * TrgDim);
   U.SetZero();
   for (auto& it : s2t_map) {
     if (it.first.second != trg_name) continue;
@@ -581,46 +703,107 @@ template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::EvalDirect(Vector
     auto Xn = (NorDim ? src_data.Xn : Vector<Real>());
 
     partition(Xs, DIM);
-    partition(F, SrcDim);
+    partition(F, Nd*SrcDim);
     partition(Xn, (NorDim?NorDim:1));
 
     const Long Ns = Xs.Dim() / DIM;
     SCTL_ASSERT(Xs.Dim() == Ns * DIM);
-    SCTL_ASSERT(F.Dim() == Ns * SrcDim);
+    SCTL_ASSERT(F.Dim() == Ns * Nd * SrcDim);
     SCTL_ASSERT(Xn.Dim() == Ns * NorDim);
 
-    Vector<Real> Xs_, Xn_, F_;
-    for (Long i = 0; i < np; i++) {
-      auto send_recv_vec = [this,rank,np](Vector<Real>& X_, const Vector<Real>& X, Integer offset){
-        Integer send_partner = (rank + offset) % np;
-        Integer recv_partner = (rank + np - offset) % np;
-
-        Long send_cnt = X.Dim(), recv_cnt = 0;
-        void* recv_req = comm_.Irecv(     Ptr2Itr<Long>(&recv_cnt,1), 1, recv_partner, offset);
-        void* send_req = comm_.Isend(Ptr2ConstItr<Long>(&send_cnt,1), 1, send_partner, offset);
-        comm_.Wait(recv_req);
-        comm_.Wait(send_req);
-
-        X_.ReInit(recv_cnt);
-        recv_req = comm_.Irecv(X_.begin(), recv_cnt, recv_partner, offset);
-        send_req = comm_.Isend(X .begin(), send_cnt, send_partner, offset);
-        comm_.Wait(recv_req);
-        comm_.Wait(send_req);
+    Vector<Long> Ns_glb(np);  // exchange the counts once up front
+    comm_.Allgather(Ptr2ConstItr<Long>(&Ns,1), 1, Ns_glb.begin(), 1);
+
+    // Pack [Xs, Xn, F] into a single message, the block from rank-i is received while the block from rank-(i-1) is evaluated
+    const Long dof = DIM + NorDim + Nd * SrcDim;
+    Vector<Real> sbuff(Ns * dof);
+    if (Ns          ) memcopy(sbuff.begin()                    , Xs.begin(), Ns * DIM   );
+    if (Ns && NorDim) memcopy(sbuff.begin() + Ns * DIM         , Xn.begin(), Ns * NorDim);
+    for (Long d = 0; d < Nd; d++) { // one density per row
+      Iterator<Real> F_ = sbuff.begin() + Ns * (DIM+NorDim+d*SrcDim);
+      for (Long i = 0; i < Ns; i++) {
+        for (Long k = 0; k < SrcDim; k++) {
+          F_[i*SrcDim+k] = F[(i*Nd+d)*SrcDim+k];
+        }
+      }
+    }
+
+    StaticArray<Vector<Real>,2> rbuff;
+    void* recv_req = nullptr;
+    void* send_req = nullptr;
+    auto post_send_recv = [this,rank,np,dof,&Ns_glb,&sbuff,&rbuff,&recv_req,&send_req](Integer offset){
+      const Integer send_partner = (rank + offset) % np;
+      const Integer recv_partner = (rank + np - offset) % np;
+      Vector<Real>& buff = rbuff[offset % 2];
+      buff.ReInit(Ns_glb[recv_partner] * dof);
+      recv_req = comm_.Irecv(buff.begin(), buff.Dim(), recv_partner, offset);
+      send_req = comm_.Isend(sbuff.begin(), sbuff.Dim(), send_partner, offset);
+    };
+
+    Vector<Real> Xs_, Xn_;
+    Matrix<Real> F_;
+    for (Integer i = 0; i < np; i++) {
+      void* recv_req_ = recv_req; // requests for block i, posted in the previous iteration
+      void* send_req_ = send_req;
+      if (i) comm_.Wait(recv_req_);
+      if (i + 1 < np) post_send_recv(i + 1);
+
+      const Vector<Real>& buff = (i ? rbuff[i % 2] : sbuff);
+      const Long Ns_ = Ns_glb[(rank + np - i) % np];
+      auto view = [&buff](Vector<Real>& V, Long offset, Long N) {
+        if (N) V.ReInit(N, (Iterator<Real>)buff.begin() + offset, false);
+        else V.ReInit(0);
       };
-      send_recv_vec(Xs_, Xs, i);
-      send_recv_vec(Xn_, Xn, i);
-      send_recv_vec(F_ , F , i);
-      it.second.ker_s2t_eval_omp(U, Xt, Xs_, Xn_, F_, digits_, it.second.ker_s2t);
+      view(Xs_, 0                  , Ns_ * DIM   );
+      view(Xn_, Ns_ * DIM          , Ns_ * NorDim);
+      if (Ns_ && SrcDim) F_.ReInit(Nd, Ns_ * SrcDim, (Iterator<Real>)buff.begin() + Ns_ * (DIM+NorDim), false);
+      else F_.ReInit(Nd, 0);
+      it.second.ker_s2t_eval_batch_omp(U, Xt, Xs_, Xn_, F_, digits_, it.second.ker_s2t);
+      if (i) comm_.Wait(send_req_);
+    }
+  }
+
+  { // repartition the potentials to match the target distribution
+    const Long Nt_loc = Xt.Dim() / DIM;
+    Vector<Real> U0(Nt_loc * Nd * TrgDim);
+    for (Long i = 0; i < Nt_loc; i++) {
+      for (Long d = 0; d < Nd; d++) {
+        for (Long k = 0; k < TrgDim; k++) {
+          U0[(i*Nd+d)*TrgDim+k] = U[d][i*TrgDim+k];
+        }
+      }
+    }
+    comm_.PartitionN(U0, Nt * Nd * TrgDim);
+    for (Long i = 0; i < Nt; i++) {
+      for (Long d = 0; d < Nd; d++) {
+        for (Long k = 0; k < TrgDim; k++) {
+          U_[d][i*TrgDim+k] = U0[(i*Nd+d)*TrgDim+k];
+        }
+      }
     }
   }
-  comm_.PartitionN(U, U_.Dim());
-  U_ += U;
 }
 
 template <class Real, Integer DIM> template <class Ker> void ParticleFMM<Real,DIM>::DeleteKer(Iterator<char> ker) {
   aligned_delete((Iterator<Ker>)ker);
 }
 
+template <class Real, Integer DIM> template <class Ker> void ParticleFMM<Real,DIM>::KerMatrix(Matrix<Real>& M, const Vector<Real>& Xt, const Vector<Real>& Xs, const Vector<Real>& Xn, Iterator<char> ker) {
+  (*(Iterator<Ker>)ker).template KernelMatrix<Real,true>(M, Xt, Xs, Xn);
+}
+
+template <class Real, Integer DIM> Long ParticleFMM<Real,DIM>::DensityCount(const std::string& trg_name) const {
+  Long dens_cnt = -1;
+  for (auto& it : s2t_map) {
+    if (it.first.second != trg_name) continue;
+    SCTL_ASSERT_MSG(src_map.find(it.first.first) != src_map.end(), "Source name does not exist.");
+    const Long dens_cnt_ = src_map.at(it.first.first).dens_cnt;
+    SCTL_ASSERT_MSG(dens_cnt == -1 || dens_cnt == dens_cnt_, "All source types must have the same number of densities.");
+    dens_cnt = dens_cnt_;
+  }
+  return (dens_cnt == -1 ? 1 : dens_cnt);
+}
+
 template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::CheckKernelDims() const {
   SCTL_ASSERT(fmm_ker.ker_m2m != NullIterator<char>());
   SCTL_ASSERT(fmm_ker.ker_m2l != NullIterator<char>());
@@ -841,7 +1024,7 @@ template <class SCTLKernel, bool use_dummy_normal> template <class VecType, int
   }
 }
 
-template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::EvalPVFMM(Vector<Real>& U, const std::string& trg_name) const {
+template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::EvalPVFMM(Vector<Real>& U, const std::string& trg_name, Long dens_idx) const {
   if (DIM != 3) return EvalDirect(U, trg_name); // PVFMM only supports 3D
 
   SCTL_ASSERT_MSG(trg_map.find(trg_name) != trg_map.end(), "Target name does not exist.");
@@ -870,7 +1053,20 @@ template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::EvalPVFMM(Vector<
     const Integer SrcDim = src_data.dim_src;
     const Integer NorDim = src_data.dim_normal;
     const auto& Xs = src_data.X;
-    const auto& F = src_data.F;
+    Vector<Real> F; // density dens_idx of the batch
+    if (src_data.dens_cnt == 1) {
+      F.ReInit(src_data.F.Dim(), (Iterator<Real>)src_data.F.begin(), false);
+    } else {
+      const Long Nd = src_data.dens_cnt;
+      const Long Ns = src_data.F.Dim() / (Nd * SrcDim);
+      SCTL_ASSERT(0 <= dens_idx && dens_idx < Nd);
+      F.ReInit(Ns * SrcDim);
+      for (Long i = 0; i < Ns; i++) {
+        for (Long k = 0; k < SrcDim; k++) {
+          F[i*SrcDim+k] = src_data.F[(i*Nd+dens_idx)*SrcDim+k];
+        }
+      }
+    }
 
     const Vector<Real> Xn_dummy;
     const auto& Xn = (NorDim ? src_data.Xn : Xn_dummy);
@@ -1021,6 +1217,1018 @@ template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::EvalPVFMM(Vector<
     }
   }
 }
+#else
+template <class Real, Integer DIM> struct ParticleFMM<Real,DIM>::KIFMMData {
+  ~KIFMMData() { if (tree) delete tree; }
+
+  Integer OpLevel(Integer f, Integer depth) const { return (scale_invar[f] ? 0 : depth); }
+  Real OpRatio(Integer f, Integer depth) const { return (scale_invar[f] ? bbox_len * level_size[depth] : 1); }
+
+  Real NodeLen(Long i) const { return bbox_len * level_size[node_depth[i]]; }
+  void NodeCenter(StaticArray<Real,DIM>& c, Long i) const {
+    const Real s = level_size[node_depth[i]];
+    for (Integer k = 0; k < DIM; k++) c[k] = bbox_offset[k] + (node_coord[i*DIM+k] + s/2) * bbox_len;
+  }
+  void Surface(Vector<Real>& X, Real radius, const StaticArray<Real,DIM>& c) const { // surface of the cube [c-radius,c+radius]^DIM
+    const Long N = surf.Dim() / DIM;
+    if (X.Dim() != N*DIM) X.ReInit(N*DIM);
+    for (Long i = 0; i < N; i++) {
+      for (Integer k = 0; k < DIM; k++) X[i*DIM+k] = c[k] + radius * surf[i*DIM+k];
+    }
+  }
+
+  PtTree<Real,DIM>* tree = nullptr;
+  Real bbox_len;                      // size of the root box
+  StaticArray<Real,DIM> bbox_offset;  // origin of the root box
+  Vector<Real> level_size;            // size of the boxes at each level (relative to the root box)
+
+  Integer max_depth;
+  Vector<Real> node_coord;            // origin of each node in [0,1)^DIM
+  Vector<Integer> node_depth;
+  Vector<Long> src_cnt;               // number of sources in the subtree of each node (on all processes)
+  Vector<char> has_trg;               // whether the subtree of a node contains local targets
+  Vector<Vector<Long>> U_lst, V_lst, W_lst, X_lst; // interaction lists of the nodes with local targets
+  Vector<char> lst_ready;             // whether the interaction lists of a node have been built
+  double eval_time = 0;               // local compute time of the last evaluation (used to repartition the tree)
+
+  Integer order = 0;                  // number of points along each edge of the equivalent and check surfaces
+  Vector<Real> surf;                  // surface points on the boundary of [-1,1]^DIM
+  Vector<Long> surf_grid;             // index of each surface point in the (2*order)^DIM grid used for M2L
+
+  // Operators built from the m2m (UC2UE, M2M), l2l (DC2DE, L2L) and m2l (M2L) kernels. For scale-invariant
+  // kernels, K(s*x) = s^(src_exp[k0]+trg_exp[k1]) K(x) and the operators are built once for a box of unit
+  // size, otherwise they are built for each level of a root box of size op_len.
+  StaticArray<bool,3> scale_invar;
+  StaticArray<Vector<Real>,3> src_exp, trg_exp;
+  StaticArray<Real,3> op_len;
+  Vector<Matrix<Real>> UC2UE, M2M, DC2DE, L2L; // for each level (M2M, L2L: for each child of a box)
+  Vector<Vector<Real>> M2L; // Fourier transform of the M2L kernels for each level and each offset in [-3,3]^DIM
+
+  static constexpr Integer M2L_BLOCK = 32; // number of frequencies processed together in M2L
+};
+
+template <class Real, Integer DIM> bool ParticleFMM<Real,DIM>::KIFMMScaling(Vector<Real>& src_exp, Vector<Real>& trg_exp, const Matrix<Real>& M1, const Matrix<Real>& M2, Integer kdim0, Integer kdim1) {
+  const Real eps = machine_eps<Real>();
+  const Long N0 = M1.Dim(0) / kdim0;
+  const Long N1 = M1.Dim(1) / kdim1;
+  SCTL_ASSERT(M1.Dim(0) == N0 * kdim0 && M1.Dim(1) == N1 * kdim1);
+  SCTL_ASSERT(M2.Dim(0) == M1.Dim(0) && M2.Dim(1) == M1.Dim(1));
+  src_exp.ReInit(kdim0); src_exp.SetZero();
+  trg_exp.ReInit(kdim1); trg_exp.SetZero();
+
+  Matrix<Real> dot11(kdim0, kdim1), dot12(kdim0, kdim1), dot22(kdim0, kdim1);
+  dot11.SetZero(); dot12.SetZero(); dot22.SetZero();
+  for (Long i = 0; i < N0; i++) {
+    for (Integer k0 = 0; k0 < kdim0; k0++) {
+      for (Long j = 0; j < N1; j++) {
+        for (Integer k1 = 0; k1 < kdim1; k1++) {
+          const Real a = M1[i*kdim0+k0][j*kdim1+k1];
+          const Real b = M2[i*kdim0+k0][j*kdim1+k1];
+          dot11[k0][k1] += a * a;
+          dot12[k0][k1] += a * b;
+          dot22[k0][k1] += b * b;
+        }
+      }
+    }
+  }
+  Real max_val = 0;
+  for (const auto& a : dot11) max_val = std::max<Real>(max_val, a);
+  for (const auto& a : dot22) max_val = std::max<Real>(max_val, a);
+
+  Vector<Integer> blk_idx; // non-zero blocks of the kernel and their exponents
+  Vector<Real> blk_exp;
+  for (Integer k0 = 0; k0 < kdim0; k0++) {
+    for (Integer k1 = 0; k1 < kdim1; k1++) {
+      const bool nz1 = (dot11[k0][k1] > max_val * eps);
+      const bool nz2 = (dot22[k0][k1] > max_val * eps);
+      if (nz1 != nz2) return false;
+      if (!nz1) continue;
+      const Real err = fabs<Real>(1 - dot12[k0][k1] * dot12[k0][k1] / (dot11[k0][k1] * dot22[k0][k1]));
+      if (dot12[k0][k1] <= 0 || err > 1024 * eps) return false;
+      blk_idx.PushBack(k0*kdim1+k1);
+      blk_exp.PushBack(log<Real>(dot12[k0][k1] / dot11[k0][k1]) / log<Real>(2));
+    }
+  }
+  const Long Nblk = blk_idx.Dim();
+  if (!Nblk) return true;
+
+  Matrix<Real> M(Nblk+1, kdim0+kdim1), b(Nblk+1, 1); // src_exp[k0] + trg_exp[k1] = blk_exp, src_exp[0] = 0
+  M.SetZero(); b.SetZero();
+  for (Long i = 0; i < Nblk; i++) {
+    M[i][blk_idx[i] / kdim1] = 1;
+    M[i][kdim0 + blk_idx[i] % kdim1] = 1;
+    b[i][0] = blk_exp[i];
+  }
+  M[Nblk][0] = 1;
+  const Matrix<Real> x = M.pinv() * b;
+  for (Integer k = 0; k < kdim0; k++) src_exp[k] = x[k][0];
+  for (Integer k = 0; k < kdim1; k++) trg_exp[k] = x[kdim0+k][0];
+  for (Long i = 0; i < Nblk; i++) { // Verify
+    if (fabs<Real>(src_exp[blk_idx[i] / kdim1] + trg_exp[blk_idx[i] % kdim1] - blk_exp[i]) > sqrt<Real>(eps)) {
+      src_exp.SetZero();
+      trg_exp.SetZero();
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::SetupKIFMM(KIFMMData& data, const SrcData& src_data, const TrgData& trg_data, bool setup_ker, bool setup_tree) const {
+  static constexpr Integer MAX_CHILD = (1u << DIM);
+  static constexpr Integer MAX_NBRS = sctl::pow<DIM,Integer>(3);
+
+  if (setup_ker) { // Set order, surf, surf_grid, scaling of the kernels and clear the operators
+    // Order of the equivalent/check surfaces for each digits_, measured so that the maximum relative error for
+    // Laplace and Stokes (the harder of the two) is below 10^-digits_. Odd orders are less accurate for Stokes. The
+    // accuracy saturates at about 1e-8 (pseudo-inverse truncation), so larger orders only add cost.
+    static constexpr Integer order_lst[] = {4, 4, 4, 6, 8, 8, 8, 10, 12};
+    const Integer p = order_lst[std::min<Integer>(std::max<Integer>(digits_, 0), 8)];
+    const Long n = 2*p;
+    data.order = p;
+    data.surf.ReInit(0);
+    data.surf_grid.ReInit(0);
+    for (Long i = 0; i < sctl::pow<DIM,Long>(p); i++) {
+      StaticArray<Long,DIM> g;
+      bool on_surf = false;
+      for (Integer k = DIM-1, i_ = i; k >= 0; k--, i_ /= p) {
+        g[k] = i_ % p;
+        on_surf = on_surf || g[k] == 0 || g[k] == p-1;
+      }
+      if (!on_surf) continue;
+      Long grid_idx = 0;
+      for (Integer k = 0; k < DIM; k++) {
+        data.surf.PushBack(-1 + 2 * g[k] / (Real)(p-1));
+        grid_idx = grid_idx * n + g[k];
+      }
+      data.surf_grid.PushBack(grid_idx);
+    }
+
+    const Integer kdim0[3] = {fmm_ker.dim_mul_eq, fmm_ker.dim_loc_eq, fmm_ker.dim_mul_eq};
+    const Integer kdim1[3] = {fmm_ker.dim_mul_ch, fmm_ker.dim_loc_ch, fmm_ker.dim_loc_ch};
+    const decltype(fmm_ker.ker_m2m_matrix) ker_matrix[3] = {fmm_ker.ker_m2m_matrix, fmm_ker.ker_l2l_matrix, fmm_ker.ker_m2l_matrix};
+    const Iterator<char> ker[3] = {fmm_ker.ker_m2m, fmm_ker.ker_l2l, fmm_ker.ker_m2l};
+    const Vector<Real> Xs = data.surf * (Real)(1.05/2), Xt = data.surf * (Real)(2.95/2), Xn;
+    for (Integer f = 0; f < 3; f++) {
+      Matrix<Real> M1, M2;
+      ker_matrix[f](M1, Xt, Xs, Xn, ker[f]);
+      ker_matrix[f](M2, Xt*(Real)2, Xs*(Real)2, Xn, ker[f]);
+      data.scale_invar[f] = KIFMMScaling(data.src_exp[f], data.trg_exp[f], M1, M2, kdim0[f], kdim1[f]);
+      data.op_len[f] = 0; // the operators are rebuilt in SetupKIFMMOperators
+    }
+  }
+
+  if (setup_tree) { // Build (or update) the tree and the interaction lists
+    const Integer NorDim = src_data.dim_normal;
+    const auto& Xs = src_data.X;
+    const auto& Xt = trg_data.X;
+    const Long Ns = Xs.Dim() / DIM;
+    const Long Nt = Xt.Dim() / DIM;
+    SCTL_ASSERT(Xs.Dim() == Ns * DIM);
+    SCTL_ASSERT(Xt.Dim() == Nt * DIM);
+    SCTL_ASSERT(src_data.Xn.Dim() == Ns * NorDim);
+    const Long max_pts = 6 * (data.surf.Dim() / DIM); // direct evaluation is cheaper than M2L for small boxes
+
+    const auto tree_coord = [&data](Vector<Real>& X_, const Vector<Real>& X) { // returns false if X is not in the root box
+      const Long N = X.Dim() / DIM;
+      const Real scal = 1 / data.bbox_len;
+      bool inside = true;
+      if (X_.Dim() != N*DIM) X_.ReInit(N*DIM);
+      for (Long i = 0; i < N; i++) {
+        for (Integer k = 0; k < DIM; k++) {
+          X_[i*DIM+k] = (X[i*DIM+k] - data.bbox_offset[k]) * scal;
+          inside = inside && (X_[i*DIM+k] >= 0) && (X_[i*DIM+k] < 1);
+        }
+      }
+      return inside;
+    };
+    const auto add_particles = [&](const Vector<Real>& Xs_, const Vector<Real>& Xt_) {
+      auto& tree = *data.tree;
+      tree.AddParticles("src", Xs_);
+      tree.AddParticles("trg", Xt_);
+      tree.AddParticleData("src_x", "src", Xs);
+      if (NorDim) tree.AddParticleData("src_n", "src", src_data.Xn);
+      tree.AddParticleData("trg_x", "trg", Xt);
+    };
+
+    Vector<Real> Xs_, Xt_;
+    bool reuse_tree = false;
+    if (incremental_ && data.tree) { // Re-sort the particles into the leaves of the existing tree
+      StaticArray<Long,2> outside{0,0};
+      outside[0] = (tree_coord(Xs_, Xs) && tree_coord(Xt_, Xt) ? 0 : 1);
+      comm_.Allreduce<Long>(outside+0, outside+1, 1, CommOp::SUM);
+      if (!outside[1]) {
+        auto& tree = *data.tree;
+        tree.DeleteParticleData("src");
+        tree.DeleteParticleData("trg");
+        add_particles(Xs_, Xt_);
+        reuse_tree = true;
+      }
+    }
+
+    if (!reuse_tree) { // Set bbox_len, bbox_offset, level_size
+      StaticArray<Real,DIM*2> bbox_src, bbox_trg;
+      BoundingBox<DIM>(bbox_src, Xs, comm_);
+      BoundingBox<DIM>(bbox_trg, Xt, comm_);
+
+      Real bbox_len = 0;
+      for (Integer k = 0; k < DIM; k++) {
+        const Real x0 = std::min<Real>(bbox_src[k*2+0], bbox_trg[k*2+0]);
+        const Real x1 = std::max<Real>(bbox_src[k*2+1], bbox_trg[k*2+1]);
+        data.bbox_offset[k] = (x0 + x1) / 2;
+        bbox_len = std::max<Real>(bbox_len, x1 - x0);
+      }
+      if (bbox_len <= 0) bbox_len = 1;
+      bbox_len *= (Real)1.1; // extra 5% padding so that points are not on boundary
+
+      data.bbox_len = bbox_len;
+      for (Integer k = 0; k < DIM; k++) data.bbox_offset[k] -= bbox_len / 2;
+
+      data.level_size.ReInit(Morton<DIM>::MaxDepth() + 1);
+      data.level_size[0] = 1;
+      for (Long i = 1; i < data.level_size.Dim(); i++) data.level_size[i] = data.level_size[i-1] * (Real)0.5;
+    }
+
+    const auto count_points = [&data](Vector<Long>& pt_cnt) { // set src_cnt, has_trg and the number of points in each subtree (reduced over all processes)
+      const auto& tree = *data.tree;
+      const auto& node_lst = tree.GetNodeLists();
+      const Long Nnodes = tree.GetNodeMID().Dim();
+
+      Vector<Real> X;
+      Vector<Long> src_cnt_, trg_cnt_;
+      tree.GetData(X, src_cnt_, "src");
+      tree.GetData(X, trg_cnt_, "trg");
+      Vector<Long> cnt(Nnodes*2), node_cnt(Nnodes);
+      for (Long i = 0; i < Nnodes; i++) {
+        cnt[i*2+0] = src_cnt_[i];
+        cnt[i*2+1] = src_cnt_[i] + trg_cnt_[i];
+        node_cnt[i] = 1;
+      }
+      data.has_trg.ReInit(Nnodes);
+      for (Long i = 0; i < Nnodes; i++) data.has_trg[i] = (trg_cnt_[i] > 0);
+      for (Long i = Nnodes-1; i > 0; i--) {
+        const Long p = node_lst[i].parent;
+        if (p < 0) continue;
+        cnt[p*2+0] += cnt[i*2+0];
+        cnt[p*2+1] += cnt[i*2+1];
+        if (data.has_trg[i]) data.has_trg[p] = 1;
+      }
+      data.tree->AddData("fmm_pt_cnt", cnt, node_cnt);
+      data.tree->template ReduceBroadcast<Long>("fmm_pt_cnt");
+      tree.GetData(cnt, node_cnt, "fmm_pt_cnt"); // (a view of the tree data)
+      SCTL_ASSERT(cnt.Dim() == Nnodes*2);
+
+      data.src_cnt.ReInit(Nnodes);
+      pt_cnt.ReInit(Nnodes);
+      for (Long i = 0; i < Nnodes; i++) {
+        data.src_cnt[i] = cnt[i*2+0];
+        pt_cnt[i] = cnt[i*2+1];
+      }
+      data.tree->DeleteData("fmm_pt_cnt");
+    };
+
+    Vector<Long> pt_cnt;
+    bool rebuild_tree = !reuse_tree;
+    if (reuse_tree) { // Rebuild the tree (in the same root box) if a leaf has too many points or a non-leaf too few
+      count_points(pt_cnt);
+      const auto& node_attr = data.tree->GetNodeAttr();
+      StaticArray<Long,2> rebuild{0,0};
+      for (Long i = 0; i < pt_cnt.Dim(); i++) {
+        if (node_attr[i].Leaf ? (pt_cnt[i] > 2 * max_pts) : (pt_cnt[i] * 2 < max_pts)) rebuild[0] = 1;
+      }
+      comm_.Allreduce<Long>(rebuild+0, rebuild+1, 1, CommOp::SUM);
+      rebuild_tree = (rebuild[1] > 0);
+    }
+
+    bool repartition_tree = false;
+    if (reuse_tree && !rebuild_tree && comm_.Size() > 1) { // Balance the measured cost of the previous evaluation
+      Vector<Long> wts; // near-field pairs and far-field work (of about max_pts pairs) for each target, rescaled by the measured time
+      data.tree->LeafWeights(wts, "trg", 1, max_pts);
+      repartition_tree = data.tree->Repartition(wts, false, 1, 1.1, data.eval_time);
+      if (repartition_tree) count_points(pt_cnt);
+    }
+    data.eval_time = 0;
+
+    if (rebuild_tree) { // Build the tree (with a halo of ghost nodes for the interaction lists)
+      tree_coord(Xs_, Xs);
+      tree_coord(Xt_, Xt);
+      Vector<Real> X_((Ns + Nt) * DIM);
+      for (Long i = 0; i < Ns*DIM; i++) X_[i] = Xs_[i];
+      for (Long i = 0; i < Nt*DIM; i++) X_[Ns*DIM+i] = Xt_[i];
+
+      if (reuse_tree) { // refine the existing tree, keeping its partition when it is still balanced
+        data.tree->UpdateRefinement(X_, max_pts, false, false, 1, true);
+      } else {
+        if (data.tree) delete data.tree;
+        data.tree = new PtTree<Real,DIM>(comm_);
+        add_particles(Xs_, Xt_);
+        data.tree->UpdateRefinement(X_, max_pts, false, false, 1);
+      }
+      count_points(pt_cnt);
+    }
+    if (rebuild_tree || repartition_tree) { // Set the node coordinates and reset the interaction lists
+      const auto& node_mid = data.tree->GetNodeMID();
+      const Long Nnodes = node_mid.Dim();
+      data.max_depth = 0;
+      data.node_coord.ReInit(Nnodes * DIM);
+      data.node_depth.ReInit(Nnodes);
+      for (Long i = 0; i < Nnodes; i++) {
+        node_mid[i].Coord(data.node_coord.begin() + i*DIM);
+        data.node_depth[i] = node_mid[i].Depth();
+        data.max_depth = std::max<Integer>(data.max_depth, data.node_depth[i]);
+      }
+
+      data.lst_ready.ReInit(Nnodes);
+      data.lst_ready = 0;
+      data.U_lst.ReInit(Nnodes);
+      data.V_lst.ReInit(Nnodes);
+      data.W_lst.ReInit(Nnodes);
+      data.X_lst.ReInit(Nnodes);
+    }
+    data.tree->template Broadcast<Real>("src_x");
+    if (NorDim) data.tree->template Broadcast<Real>("src_n");
+
+    const auto& tree = *data.tree;
+    const auto& node_attr = tree.GetNodeAttr();
+    const auto& node_lst = tree.GetNodeLists();
+    const Long Nnodes = node_attr.Dim();
+    const auto adjacent = [&data](Long a, Long b) { // whether the boxes a and b touch (or overlap)
+      const Real sa = data.level_size[data.node_depth[a]];
+      const Real sb = data.level_size[data.node_depth[b]];
+      for (Integer k = 0; k < DIM; k++) {
+        const Real xa = data.node_coord[a*DIM+k];
+        const Real xb = data.node_coord[b*DIM+k];
+        if (xa > xb + sb || xb > xa + sa) return false;
+      }
+      return true;
+    };
+
+    // The lists depend only on the tree structure (nodes without sources are skipped during
+    // evaluation), so they are kept when the tree is reused and built only for the nodes which
+    // contain targets.
+    #pragma omp parallel for schedule(dynamic,64)
+    for (Long i = 0; i < Nnodes; i++) { // Set U_lst, V_lst, W_lst, X_lst
+      if (!data.has_trg[i] || data.lst_ready[i]) continue;
+      data.lst_ready[i] = 1;
+      auto& U_lst = data.U_lst[i];
+      auto& V_lst = data.V_lst[i];
+      auto& W_lst = data.W_lst[i];
+      auto& X_lst = data.X_lst[i];
+      U_lst.ReInit(0);
+      V_lst.ReInit(0);
+      W_lst.ReInit(0);
+      X_lst.ReInit(0);
+
+      const Long p = node_lst[i].parent;
+      if (p >= 0) {
+        for (Integer j = 0; j < MAX_NBRS; j++) { // children of the colleagues of the parent which are well separated from i
+          const Long nn = node_lst[p].nbr[j];
+          if (nn < 0) continue;
+          for (Integer c = 0; c < MAX_CHILD; c++) {
+            const Long cc = node_lst[nn].child[c];
+            if (cc >= 0 && !adjacent(cc, i)) V_lst.PushBack(cc);
+          }
+        }
+        for (Long a = p; a >= 0; a = node_lst[a].parent) { // coarser leaves adjacent to the parent but not to i
+          for (Integer j = 0; j < MAX_NBRS; j++) {
+            const Long nn = node_lst[a].nbr[j];
+            if (nn < 0 || nn == a || !node_attr[nn].Leaf) continue;
+            if (adjacent(nn, p) && !adjacent(nn, i)) X_lst.PushBack(nn);
+          }
+        }
+      }
+
+      if (node_attr[i].Leaf) {
+        for (Long a = p; a >= 0; a = node_lst[a].parent) { // coarser leaves adjacent to i
+          for (Integer j = 0; j < MAX_NBRS; j++) {
+            const Long nn = node_lst[a].nbr[j];
+            if (nn < 0 || nn == a || !node_attr[nn].Leaf) continue;
+            if (adjacent(nn, i)) U_lst.PushBack(nn);
+          }
+        }
+        std::vector<Long> stack; // descendants of the colleagues of i
+        for (Integer j = 0; j < MAX_NBRS; j++) {
+          if (node_lst[i].nbr[j] >= 0) stack.push_back(node_lst[i].nbr[j]);
+        }
+        while (stack.size()) {
+          const Long nn = stack.back();
+          stack.pop_back();
+          if (!adjacent(nn, i)) {
+            W_lst.PushBack(nn);
+          } else if (node_attr[nn].Leaf) {
+            U_lst.PushBack(nn);
+          } else {
+            for (Integer c = 0; c < MAX_CHILD; c++) {
+              if (node_lst[nn].child[c] >= 0) stack.push_back(node_lst[nn].child[c]);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::SetupKIFMMOperators(KIFMMData& data, Integer max_depth) const {
+  static constexpr Integer MAX_CHILD = (1u << DIM);
+  const Integer p = data.order;
+  const Long Nlevels = Morton<DIM>::MaxDepth() + 1;
+  const Vector<Real> Xn;
+
+  const auto child_center = [](StaticArray<Real,DIM>& c, Integer child, Real len) {
+    for (Integer k = 0; k < DIM; k++) c[k] = ((child >> k) & 1 ? len/4 : -len/4);
+  };
+  StaticArray<Real,DIM> c0;
+  for (Integer k = 0; k < DIM; k++) c0[k] = 0;
+
+  if (data.UC2UE.Dim() != Nlevels) {
+    data.UC2UE.ReInit(Nlevels);
+    data.M2M.ReInit(Nlevels * MAX_CHILD);
+    data.DC2DE.ReInit(Nlevels);
+    data.L2L.ReInit(Nlevels * MAX_CHILD);
+    data.M2L.ReInit(Nlevels);
+  }
+  for (Integer f = 0; f < 3; f++) { // clear the operators built for a different kernel or root box
+    const Real op_len = (data.scale_invar[f] ? 1 : data.bbox_len);
+    if (data.op_len[f] == op_len) continue;
+    data.op_len[f] = op_len;
+    if (f == 0) {
+      for (auto& M : data.UC2UE) M.ReInit(0, 0);
+      for (auto& M : data.M2M) M.ReInit(0, 0);
+    } else if (f == 1) {
+      for (auto& M : data.DC2DE) M.ReInit(0, 0);
+      for (auto& M : data.L2L) M.ReInit(0, 0);
+    } else {
+      for (auto& V : data.M2L) V.ReInit(0);
+    }
+  }
+
+  for (Integer depth = 2; depth <= max_depth; depth++) { // multipole and local expansions are not needed at lower levels
+    Vector<Real> Xe, Xc, Xc_;
+    { // Set UC2UE, M2M
+      const Integer L = data.OpLevel(0, depth);
+      const Real len = (data.scale_invar[0] ? 1 : data.bbox_len * data.level_size[depth]);
+      if (!data.UC2UE[L].Dim(0)) {
+        data.Surface(Xe, (Real)1.05 * len/2, c0);
+        data.Surface(Xc, (Real)2.95 * len/2, c0);
+        Matrix<Real> M;
+        fmm_ker.ker_m2m_matrix(M, Xc, Xe, Xn, fmm_ker.ker_m2m);
+        data.UC2UE[L] = M.pinv();
+        for (Integer c = 0; c < MAX_CHILD; c++) {
+          StaticArray<Real,DIM> cc;
+          child_center(cc, c, len);
+          data.Surface(Xe, (Real)1.05 * len/4, cc);
+          fmm_ker.ker_m2m_matrix(data.M2M[L*MAX_CHILD+c], Xc, Xe, Xn, fmm_ker.ker_m2m);
+        }
+      }
+    }
+    { // Set DC2DE, L2L
+      const Integer L = data.OpLevel(1, depth);
+      const Real len = (data.scale_invar[1] ? 1 : data.bbox_len * data.level_size[depth]);
+      if (!data.DC2DE[L].Dim(0)) {
+        data.Surface(Xe, (Real)2.95 * len/2, c0);
+        data.Surface(Xc, (Real)1.05 * len/2, c0);
+        Matrix<Real> M;
+        fmm_ker.ker_l2l_matrix(M, Xc, Xe, Xn, fmm_ker.ker_l2l);
+        data.DC2DE[L] = M.pinv();
+        for (Integer c = 0; c < MAX_CHILD; c++) {
+          StaticArray<Real,DIM> cc;
+          child_center(cc, c, len);
+          data.Surface(Xc_, (Real)1.05 * len/4, cc);
+          fmm_ker.ker_l2l_matrix(data.L2L[L*MAX_CHILD+c], Xc_, Xe, Xn, fmm_ker.ker_l2l);
+        }
+      }
+    }
+    { // Set M2L
+      const Integer L = data.OpLevel(2, depth);
+      const Real len = (data.scale_invar[2] ? 1 : data.bbox_len * data.level_size[depth]);
+      if (!data.M2L[L].Dim()) {
+        const Integer DimMulEq = fmm_ker.dim_mul_eq;
+        const Integer DimLocCh = fmm_ker.dim_loc_ch;
+        const Long n = 2*p, Ngrid = sctl::pow<DIM,Long>(n);
+        const Long Nm = sctl::pow<DIM,Long>(2*p-1); // relative positions of the surface points
+        const Long Noffset = sctl::pow<DIM,Long>(7);
+        const Real h = (Real)1.05 * len / (p-1);
+
+        Vector<Long> fft_dim(DIM);
+        for (auto& a : fft_dim) a = n;
+        FFT<Real> fft;
+        fft.Setup(FFT_Type::R2C, DimMulEq*DimLocCh, fft_dim);
+
+        Real fft_scal; // fft(delta)[0], so that IFFT(FFT(a) * FFT(b)) = fft_scal * (a conv b)
+        { // Set fft_scal
+          FFT<Real> fft_;
+          fft_.Setup(FFT_Type::R2C, 1, fft_dim);
+          Vector<Real> delta(Ngrid), delta_hat;
+          delta.SetZero();
+          delta[0] = 1;
+          fft_.Execute(delta, delta_hat);
+          fft_scal = delta_hat[0];
+        }
+
+        Vector<Long> grid_idx(Nm);
+        Vector<Real> Xs(DIM), Xt(Nm*DIM), T(DimMulEq*DimLocCh*Ngrid), T_hat;
+        Xs.SetZero();
+        constexpr Integer FB = KIFMMData::M2L_BLOCK;
+        const Long Nf = fft.Dim(1) / (DimMulEq*DimLocCh*2);
+        const Long Nfb = (Nf + FB - 1) / FB;
+        data.M2L[L].ReInit(Nfb * Noffset * DimMulEq*DimLocCh * FB*2);
+        data.M2L[L].SetZero();
+        for (Long o = 0; o < Noffset; o++) {
+          StaticArray<Long,DIM> offset;
+          bool well_separated = false;
+          for (Integer k = 0, o_ = o; k < DIM; k++, o_ /= 7) {
+            offset[k] = o_ % 7 - 3;
+            well_separated = well_separated || offset[k] < -1 || offset[k] > 1;
+          }
+          if (!well_separated) continue;
+
+          for (Long i = 0; i < Nm; i++) { // Set Xt, grid_idx
+            grid_idx[i] = 0;
+            for (Integer k = DIM-1, i_ = i, s = 1; k >= 0; k--, i_ /= 2*p-1, s *= n) {
+              const Long m = i_ % (2*p-1) - (p-1);
+              Xt[i*DIM+k] = offset[k] * len + h * m;
+              grid_idx[i] += ((m + n) % n) * s;
+            }
+          }
+          Matrix<Real> M;
+          fmm_ker.ker_m2l_matrix(M, Xt, Xs, Xn, fmm_ker.ker_m2l);
+          T.SetZero();
+          for (Long i = 0; i < Nm; i++) {
+            for (Integer k0 = 0; k0 < DimMulEq; k0++) {
+              for (Integer k1 = 0; k1 < DimLocCh; k1++) {
+                T[(k0*DimLocCh+k1)*Ngrid + grid_idx[i]] = M[k0][i*DimLocCh+k1] / fft_scal;
+              }
+            }
+          }
+          fft.Execute(T, T_hat);
+          for (Long k = 0; k < DimMulEq*DimLocCh; k++) { // store in blocks of FB frequencies (real parts followed by imaginary parts)
+            for (Long f = 0; f < Nf; f++) {
+              const Iterator<Real> M2L = data.M2L[L].begin() + (((f/FB)*Noffset + o)*DimMulEq*DimLocCh + k)*FB*2 + f%FB;
+              M2L[0] = T_hat[(k*Nf+f)*2+0];
+              M2L[FB] = T_hat[(k*Nf+f)*2+1];
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+template <class Real, Integer DIM> void ParticleFMM<Real,DIM>::EvalKIFMM(Matrix<Real>& U, const std::string& trg_name) const {
+  static constexpr Integer MAX_CHILD = (1u << DIM);
+
+  SCTL_ASSERT_MSG(trg_map.find(trg_name) != trg_map.end(), "Target name does not exist.");
+  const auto& trg_data = trg_map.at(trg_name);
+  const Integer TrgDim = trg_data.dim_trg;
+  const Long Nd = DensityCount(trg_name);
+  const Long Nt = trg_data.X.Dim() / DIM;
+  SCTL_ASSERT(trg_data.X.Dim() == Nt * DIM);
+  if (U.Dim(0) != Nd || U.Dim(1) != Nt * TrgDim) U.ReInit(Nd, Nt * TrgDim);
+  U.SetZero();
+
+  if (digits_ <= 0) return;
+  const Integer DimMulEq = fmm_ker.dim_mul_eq;
+  const Integer DimMulCh = fmm_ker.dim_mul_ch;
+  const Integer DimLocEq = fmm_ker.dim_loc_eq;
+  const Integer DimLocCh = fmm_ker.dim_loc_ch;
+  const Vector<Real> Xn_dummy;
+
+  const auto scale_cols = [](Matrix<Real>& M, const Vector<Real>& exp, Real r) { // M[i][j] *= r^exp[j % exp.Dim()]
+    if (r == 1 || !exp.Dim()) return;
+    const Integer K = exp.Dim();
+    StaticArray<Real,64> s;
+    SCTL_ASSERT(K <= 64);
+    for (Integer k = 0; k < K; k++) s[k] = pow<Real>(r, exp[k]);
+    for (Long i = 0; i < M.Dim(0); i++) {
+      for (Long j = 0; j < M.Dim(1); j++) M[i][j] *= s[j % K];
+    }
+  };
+  const auto child_idx = [](const KIFMMData& data, Long child, Long parent) { // position of the child in the parent box
+    Integer c = 0;
+    for (Integer k = 0; k < DIM; k++) {
+      if (data.node_coord[child*DIM+k] > data.node_coord[parent*DIM+k]) c |= (1 << k);
+    }
+    return c;
+  };
+
+  for (auto& it : s2t_map) {
+    if (it.first.second != trg_name) continue;
+    SCTL_ASSERT_MSG(src_map.find(it.first.first) != src_map.end(), "Source name does not exist.");
+    const auto& src_data = src_map.at(it.first.first);
+    const auto& s2t_data = it.second;
+    const Integer SrcDim = src_data.dim_src;
+    const Integer NorDim = src_data.dim_normal;
+    SCTL_ASSERT(src_data.F.Dim() == (src_data.X.Dim() / DIM) * Nd * SrcDim);
+
+    KIFMMData& data = *s2t_data.kifmm;
+    Profile::Tic("KIFMM-Setup", &comm_);
+    {
+      Metrics::Scoped metrics_scope(Metric::FMM_SETUP_TIME);
+      if (s2t_data.setup_ker || s2t_data.setup_tree) {
+        SetupKIFMM(data, src_data, trg_data, s2t_data.setup_ker, s2t_data.setup_tree);
+        s2t_data.setup_ker = false;
+        s2t_data.setup_tree = false;
+      }
+      SetupKIFMMOperators(data, data.max_depth);
+    }
+    Profile::Toc();
+
+    auto& tree = *data.tree;
+    const auto& node_attr = tree.GetNodeAttr();
+    const auto& node_lst = tree.GetNodeLists();
+    const Long Nnodes = node_attr.Dim();
+    const Long Nsurf = data.surf.Dim() / DIM;
+
+    Vector<Real> Xs, Xn, Fs, Xt, Ut;
+    Vector<Long> src_cnt, src_dsp, trg_cnt, trg_dsp, cnt;
+    Matrix<Real> F; // the source densities, one density per row
+    { // Set Xs, Xn, Fs, Xt, Ut, src_cnt, src_dsp, trg_cnt, trg_dsp, F
+      tree.AddParticleData("src_f", "src", src_data.F);
+      tree.template Broadcast<Real>("src_f");
+      tree.AddParticleData("trg_u", "trg", Vector<Real>(Nt * Nd * TrgDim));
+
+      tree.GetData(Xs, src_cnt, "src_x");
+      if (NorDim) tree.GetData(Xn, cnt, "src_n");
+      tree.GetData(Fs, cnt, "src_f");
+      tree.GetData(Xt, trg_cnt, "trg_x");
+      tree.GetData(Ut, cnt, "trg_u");
+      Ut.SetZero();
+
+      src_dsp.ReInit(Nnodes);
+      trg_dsp.ReInit(Nnodes);
+      for (Long i = 0; i < Nnodes; i++) {
+        src_dsp[i] = (i ? src_dsp[i-1] + src_cnt[i-1] : 0);
+        trg_dsp[i] = (i ? trg_dsp[i-1] + trg_cnt[i-1] : 0);
+      }
+
+      const Long Ns_ = Xs.Dim() / DIM;
+      SCTL_ASSERT(Fs.Dim() == Ns_ * Nd * SrcDim);
+      F.ReInit(Nd, Ns_ * SrcDim);
+      for (Long i = 0; i < Ns_; i++) {
+        for (Long d = 0; d < Nd; d++) {
+          for (Long k = 0; k < SrcDim; k++) F[d][i*SrcDim+k] = Fs[(i*Nd+d)*SrcDim+k];
+        }
+      }
+    }
+    const auto src_view = [&](Vector<Real>& X, Vector<Real>& N, Long i) { // coordinates and normals of the sources in node i
+      X.ReInit(src_cnt[i]*DIM, Xs.begin() + src_dsp[i]*DIM, false);
+      if (NorDim) N.ReInit(src_cnt[i]*NorDim, Xn.begin() + src_dsp[i]*NorDim, false);
+    };
+    const auto src_dens = [&](Matrix<Real>& F_, Long i) { // all the densities of the sources in node i
+      const Long N = src_cnt[i]*SrcDim;
+      if (Nd == 1) {
+        F_.ReInit(1, N, F[0] + src_dsp[i]*SrcDim, false);
+        return;
+      }
+      F_.ReInit(Nd, N);
+      for (Long d = 0; d < Nd; d++) memcopy(F_[d], F[d] + src_dsp[i]*SrcDim, N);
+    };
+
+    Vector<Vector<Long>> level_nodes(data.max_depth+1);
+    for (Long i = 0; i < Nnodes; i++) level_nodes[data.node_depth[i]].PushBack(i);
+
+    // The multipole (and local) expansions of the nodes at each level are stored in the rows
+    // mul_row[i]*Nd ... mul_row[i]*Nd+Nd-1 of mul_lvl[depth] (and loc_lvl[depth]) so that the
+    // translations can be applied to all the nodes in a level with a single GEMM.
+    Vector<Matrix<Real>> mul_lvl(data.max_depth+1), loc_lvl(data.max_depth+1);
+    Vector<Long> mul_row(Nnodes), loc_row(Nnodes);
+    mul_row = -1;
+    loc_row = -1;
+    const auto translate = [&](Matrix<Real>& V_trg, const Vector<Long>& trg_nodes, const Vector<Long>& trg_row, const Matrix<Real>& V_src, const Vector<Long>& src_row, bool to_child, const Vector<Real>& src_exp, const Vector<Real>& trg_exp, Real r, ConstIterator<Matrix<Real>> Op) { // V_trg += translation between each node and its parent
+      for (Integer c = 0; c < MAX_CHILD; c++) {
+        Vector<Long> trg_lst, src_lst;
+        for (const Long i : trg_nodes) {
+          if (to_child) { // from the parent to i
+            const Long p = node_lst[i].parent;
+            if (p < 0 || src_row[p] < 0 || child_idx(data, i, p) != c) continue;
+            trg_lst.PushBack(trg_row[i]);
+            src_lst.PushBack(src_row[p]);
+          } else { // from the children to i
+            for (Integer j = 0; j < MAX_CHILD; j++) {
+              const Long cc = node_lst[i].child[j];
+              if (cc < 0 || src_row[cc] < 0 || child_idx(data, cc, i) != c) continue;
+              trg_lst.PushBack(trg_row[i]);
+              src_lst.PushBack(src_row[cc]);
+            }
+          }
+        }
+        const Long N = trg_lst.Dim();
+        if (!N) continue;
+
+        Matrix<Real> A(N*Nd, V_src.Dim(1)), B(N*Nd, V_trg.Dim(1));
+        for (Long j = 0; j < N; j++) memcopy(A[j*Nd], V_src[src_lst[j]*Nd], Nd*V_src.Dim(1));
+        scale_cols(A, src_exp, r);
+        Matrix<Real>::GEMM(B, A, Op[c]);
+        scale_cols(B, trg_exp, r);
+        for (Long j = 0; j < N; j++) { // the same node may appear more than once
+          for (Long k = 0; k < Nd*V_trg.Dim(1); k++) V_trg[trg_lst[j]*Nd][k] += B[j*Nd][k];
+        }
+      }
+    };
+
+    Profile::Tic("KIFMM-Upward", &comm_);
+    double t0 = omp_get_wtime(); // the local compute time (without communication) is used to repartition the tree
+    for (Integer depth = data.max_depth; depth >= 2; depth--) { // S2M, M2M
+      const Integer L = data.OpLevel(0, depth);
+      const Real r = data.OpRatio(0, depth);
+      Vector<Long> nodes;
+      for (const Long i : level_nodes[depth]) {
+        if (!data.src_cnt[i]) continue;
+        mul_row[i] = nodes.Dim();
+        nodes.PushBack(i);
+      }
+      const Long N = nodes.Dim();
+      if (!N) continue;
+
+      Matrix<Real> u_check(N*Nd, Nsurf*DimMulCh);
+      u_check.SetZero();
+      #pragma omp parallel for schedule(dynamic)
+      for (Long ii = 0; ii < N; ii++) {
+        const Long i = nodes[ii];
+        if (!node_attr[i].Leaf || node_attr[i].Ghost || !src_cnt[i]) continue;
+        StaticArray<Real,DIM> c;
+        Vector<Real> Xc, Xs_, Xn_;
+        Matrix<Real> F_;
+        data.NodeCenter(c, i);
+        data.Surface(Xc, (Real)2.95 * data.NodeLen(i)/2, c);
+        src_view(Xs_, Xn_, i);
+        src_dens(F_, i);
+        Matrix<Real> U_(Nd, Nsurf*DimMulCh, u_check[ii*Nd], false);
+        src_data.ker_s2m_eval_batch(U_, Xc, Xs_, Xn_, F_, digits_, src_data.ker_s2m);
+        scale_cols(U_, data.trg_exp[0] * (Real)-1, r);
+      }
+      if (depth < data.max_depth) translate(u_check, nodes, mul_row, mul_lvl[depth+1], mul_row, false, data.src_exp[0], Vector<Real>(), r, data.M2M.begin() + L*MAX_CHILD);
+
+      mul_lvl[depth].ReInit(N*Nd, Nsurf*DimMulEq);
+      Matrix<Real>::GEMM(mul_lvl[depth], u_check, data.UC2UE[L]);
+      scale_cols(mul_lvl[depth], data.src_exp[0] * (Real)-1, r);
+    }
+    data.eval_time += omp_get_wtime() - t0;
+    { // Reduce and broadcast the multipole expansions
+      const Long dof = Nd * Nsurf * DimMulEq;
+      Vector<Long> mul_cnt(Nnodes);
+      Long N = 0;
+      for (Long i = 0; i < Nnodes; i++) {
+        mul_cnt[i] = (mul_row[i] >= 0 ? 1 : 0);
+        N += mul_cnt[i];
+      }
+      Vector<Real> mul_data(N * dof);
+      for (Long i = 0, offset = 0; i < Nnodes; i++) {
+        if (!mul_cnt[i]) continue;
+        memcopy(mul_data.begin() + offset, mul_lvl[data.node_depth[i]][mul_row[i]*Nd], dof);
+        offset += dof;
+      }
+      tree.AddData("fmm_mul", mul_data, mul_cnt);
+      tree.template ReduceBroadcast<Real>("fmm_mul");
+      tree.GetData(mul_data, mul_cnt, "fmm_mul");
+      for (Long i = 0, offset = 0; i < Nnodes; i++) {
+        if (!mul_cnt[i]) continue;
+        SCTL_ASSERT(mul_row[i] >= 0);
+        memcopy(mul_lvl[data.node_depth[i]][mul_row[i]*Nd], mul_data.begin() + offset, dof);
+        offset += dof;
+      }
+      tree.DeleteData("fmm_mul");
+    }
+    Profile::Toc();
+
+    Profile::Tic("KIFMM-Downward", &comm_);
+    t0 = omp_get_wtime();
+    for (Integer depth = 2; depth <= data.max_depth; depth++) {
+      Vector<Long> nodes;
+      for (const Long i : level_nodes[depth]) {
+        if (!data.has_trg[i]) continue;
+        loc_row[i] = nodes.Dim();
+        nodes.PushBack(i);
+      }
+      const Long N = nodes.Dim();
+      if (!N) continue;
+
+      Matrix<Real> u_check(N*Nd, Nsurf*DimLocCh);
+      u_check.SetZero();
+      { // M2L
+        Vector<Long> trg_nodes, src_nodes, src_slot(Nnodes), pair_dsp, pair_src, pair_offset;
+        src_slot = -1;
+        pair_dsp.PushBack(0);
+        for (const Long i : nodes) {
+          for (const Long j : data.V_lst[i]) {
+            if (mul_row[j] < 0) continue;
+            if (src_slot[j] < 0) {
+              src_slot[j] = src_nodes.Dim();
+              src_nodes.PushBack(j);
+            }
+            Long offset = 0;
+            for (Integer k = DIM-1; k >= 0; k--) {
+              offset = offset * 7 + (Long)round<Real>((data.node_coord[i*DIM+k] - data.node_coord[j*DIM+k]) / data.level_size[depth]) + 3;
+            }
+            pair_src.PushBack(src_slot[j]);
+            pair_offset.PushBack(offset);
+          }
+          if (pair_src.Dim() == pair_dsp[pair_dsp.Dim()-1]) continue;
+          trg_nodes.PushBack(i);
+          pair_dsp.PushBack(pair_src.Dim());
+        }
+        const Long Nsrc = src_nodes.Dim(), Ntrg = trg_nodes.Dim();
+        if (Nsrc && Ntrg) {
+          constexpr Integer FB = KIFMMData::M2L_BLOCK;
+          const Integer L = data.OpLevel(2, depth);
+          const Real r = data.OpRatio(2, depth);
+          const Integer p = data.order;
+          const Long n = 2*p, Ngrid = sctl::pow<DIM,Long>(n);
+          const Long Noffset = sctl::pow<DIM,Long>(7);
+          Vector<Long> fft_dim(DIM);
+          for (auto& a : fft_dim) a = n;
+          Vector<Real> src_scal(DimMulEq), trg_scal(DimLocCh);
+          for (Integer k = 0; k < DimMulEq; k++) src_scal[k] = pow<Real>(r, data.src_exp[2][k]);
+          for (Integer k = 0; k < DimLocCh; k++) trg_scal[k] = pow<Real>(r, data.trg_exp[2][k]);
+
+          // The Fourier transforms are computed in chunks of nodes and stored in blocks of FB
+          // frequencies (real parts followed by imaginary parts), matching the layout of M2L, so
+          // that the interactions can be accumulated one block of frequencies at a time.
+          constexpr Long CHUNK = 64;
+          const Long Nf = Ngrid / n * (n/2+1);
+          const Long Nfb = (Nf + FB - 1) / FB;
+          const auto setup_fft = [&](StaticArray<FFT<Real>,2>& fft, FFT_Type type, Long N, Long dof) { // for full chunks and for the last chunk
+            fft[0].Setup(type, std::min(N, CHUNK) * dof, fft_dim);
+            fft[1].Setup(type, std::max<Long>(N % CHUNK, 1) * dof, fft_dim);
+          };
+
+          Vector<Real> G_blk(Nfb * Nsrc * Nd * DimMulEq * FB*2), U_blk(Nfb * Ntrg * Nd * DimLocCh * FB*2);
+          G_blk.SetZero();
+          U_blk.SetZero();
+          { // Set G_blk
+            StaticArray<FFT<Real>,2> fft;
+            setup_fft(fft, FFT_Type::R2C, Nsrc, Nd*DimMulEq);
+            const Matrix<Real>& M = mul_lvl[depth];
+            #pragma omp parallel for schedule(dynamic)
+            for (Long s0 = 0; s0 < Nsrc; s0 += CHUNK) {
+              const Long Ns_ = std::min(CHUNK, Nsrc - s0);
+              Vector<Real> G(Ns_ * Nd * DimMulEq * Ngrid), G_hat;
+              G.SetZero();
+              for (Long s = 0; s < Ns_; s++) {
+                const Long row = mul_row[src_nodes[s0+s]] * Nd;
+                for (Long d = 0; d < Nd; d++) {
+                  for (Long j = 0; j < Nsurf; j++) {
+                    for (Integer k0 = 0; k0 < DimMulEq; k0++) {
+                      G[((s*Nd+d)*DimMulEq+k0)*Ngrid + data.surf_grid[j]] = M[row+d][j*DimMulEq+k0] * src_scal[k0];
+                    }
+                  }
+                }
+              }
+              fft[Ns_ == CHUNK ? 0 : 1].Execute(G, G_hat);
+              for (Long s = 0; s < Ns_; s++) {
+                for (Long q = 0; q < Nd*DimMulEq; q++) {
+                  for (Long f = 0; f < Nf; f++) {
+                    const Iterator<Real> G_ = G_blk.begin() + (((f/FB)*Nsrc + s0+s)*Nd*DimMulEq + q)*FB*2 + f%FB;
+                    G_[0] = G_hat[((s*Nd*DimMulEq+q)*Nf+f)*2+0];
+                    G_[FB] = G_hat[((s*Nd*DimMulEq+q)*Nf+f)*2+1];
+                  }
+                }
+              }
+            }
+          }
+
+          #pragma omp parallel for schedule(static)
+          for (Long fb = 0; fb < Nfb; fb++) {
+            for (Long t = 0; t < Ntrg; t++) {
+              const Iterator<Real> U_ = U_blk.begin() + (fb*Ntrg + t)*Nd*DimLocCh*FB*2;
+              for (Long j = pair_dsp[t]; j < pair_dsp[t+1]; j++) {
+                const ConstIterator<Real> K_ = data.M2L[L].begin() + (fb*Noffset + pair_offset[j])*DimMulEq*DimLocCh*FB*2;
+                const ConstIterator<Real> G_ = G_blk.begin() + (fb*Nsrc + pair_src[j])*Nd*DimMulEq*FB*2;
+                for (Long d = 0; d < Nd; d++) {
+                  for (Integer k0 = 0; k0 < DimMulEq; k0++) {
+                    const ConstIterator<Real> g = G_ + (d*DimMulEq+k0)*FB*2;
+                    for (Integer k1 = 0; k1 < DimLocCh; k1++) {
+                      const ConstIterator<Real> k = K_ + (k0*DimLocCh+k1)*FB*2;
+                      const Iterator<Real> u = U_ + (d*DimLocCh+k1)*FB*2;
+                      for (Integer f = 0; f < FB; f++) {
+                        u[f] += k[f] * g[f] - k[FB+f] * g[FB+f];
+                        u[FB+f] += k[f] * g[FB+f] + k[FB+f] * g[f];
+                      }
+                    }
+                  }
+                }
+              }
+            }
+          }
+          G_blk.ReInit(0);
+
+          { // Inverse Fourier transform of U_blk and add to u_check
+            StaticArray<FFT<Real>,2> ifft;
+            setup_fft(ifft, FFT_Type::C2R, Ntrg, Nd*DimLocCh);
+            #pragma omp parallel for schedule(dynamic)
+            for (Long t0 = 0; t0 < Ntrg; t0 += CHUNK) {
+              const Long Nt_ = std::min(CHUNK, Ntrg - t0);
+              Vector<Real> U_hat(Nt_ * Nd * DimLocCh * Nf * 2), U_grid;
+              for (Long t = 0; t < Nt_; t++) {
+                for (Long q = 0; q < Nd*DimLocCh; q++) {
+                  for (Long f = 0; f < Nf; f++) {
+                    const ConstIterator<Real> U_ = U_blk.begin() + (((f/FB)*Ntrg + t0+t)*Nd*DimLocCh + q)*FB*2 + f%FB;
+                    U_hat[((t*Nd*DimLocCh+q)*Nf+f)*2+0] = U_[0];
+                    U_hat[((t*Nd*DimLocCh+q)*Nf+f)*2+1] = U_[FB];
+                  }
+                }
+              }
+              ifft[Nt_ == CHUNK ? 0 : 1].Execute(U_hat, U_grid);
+              for (Long t = 0; t < Nt_; t++) {
+                const Long row = loc_row[trg_nodes[t0+t]] * Nd;
+                for (Long d = 0; d < Nd; d++) {
+                  for (Long j = 0; j < Nsurf; j++) {
+                    for (Integer k1 = 0; k1 < DimLocCh; k1++) {
+                      u_check[row+d][j*DimLocCh+k1] = U_grid[((t*Nd+d)*DimLocCh+k1)*Ngrid + data.surf_grid[j]] * trg_scal[k1];
+                    }
+                  }
+                }
+              }
+            }
+          }
+        }
+      }
+
+      #pragma omp parallel for schedule(dynamic)
+      for (Long ii = 0; ii < N; ii++) { // S2L
+        const Long i = nodes[ii];
+        if (!data.X_lst[i].Dim()) continue;
+        StaticArray<Real,DIM> c;
+        Vector<Real> Xc, Xs_, Xn_;
+        Matrix<Real> F_, U_(Nd, Nsurf*DimLocCh, u_check[ii*Nd], false);
+        data.NodeCenter(c, i);
+        data.Surface(Xc, (Real)1.05 * data.NodeLen(i)/2, c);
+        for (const Long j : data.X_lst[i]) {
+          if (!src_cnt[j]) continue;
+          src_view(Xs_, Xn_, j);
+          src_dens(F_, j);
+          src_data.ker_s2l_eval_batch(U_, Xc, Xs_, Xn_, F_, digits_, src_data.ker_s2l);
+        }
+      }
+      if (depth > 2) { // L2L
+        const Integer L_ = data.OpLevel(1, depth-1);
+        const Real r_ = data.OpRatio(1, depth-1);
+        translate(u_check, nodes, loc_row, loc_lvl[depth-1], loc_row, true, data.src_exp[1], data.trg_exp[1], r_, data.L2L.begin() + L_*MAX_CHILD);
+      }
+
+      const Integer L = data.OpLevel(1, depth);
+      const Real r = data.OpRatio(1, depth);
+      scale_cols(u_check, data.trg_exp[1] * (Real)-1, r);
+      loc_lvl[depth].ReInit(N*Nd, Nsurf*DimLocEq);
+      Matrix<Real>::GEMM(loc_lvl[depth], u_check, data.DC2DE[L]);
+      scale_cols(loc_lvl[depth], data.src_exp[1] * (Real)-1, r);
+    }
+    Profile::Toc();
+
+    Profile::Tic("KIFMM-Targets", &comm_);
+    #pragma omp parallel for schedule(dynamic)
+    for (Long i = 0; i < Nnodes; i++) { // L2T, M2T, S2T
+      const Long Nt_ = trg_cnt[i];
+      if (!Nt_) continue;
+      const Vector<Real> Xt_(Nt_*DIM, Xt.begin() + trg_dsp[i]*DIM, false);
+      Matrix<Real> U_(Nd, Nt_*TrgDim);
+      U_.SetZero();
+
+      StaticArray<Real,DIM> c;
+      Vector<Real> Xe, Xs_, Xn_;
+      Matrix<Real> F_;
+      if (loc_row[i] >= 0) {
+        data.NodeCenter(c, i);
+        data.Surface(Xe, (Real)2.95 * data.NodeLen(i)/2, c);
+        F_.ReInit(Nd, Nsurf*DimLocEq, loc_lvl[data.node_depth[i]][loc_row[i]*Nd], false);
+        trg_data.ker_l2t_eval_batch(U_, Xt_, Xe, Xn_dummy, F_, digits_, trg_data.ker_l2t);
+      }
+      for (const Long j : data.W_lst[i]) {
+        if (mul_row[j] < 0) continue;
+        data.NodeCenter(c, j);
+        data.Surface(Xe, (Real)1.05 * data.NodeLen(j)/2, c);
+        F_.ReInit(Nd, Nsurf*DimMulEq, mul_lvl[data.node_depth[j]][mul_row[j]*Nd], false);
+        trg_data.ker_m2t_eval_batch(U_, Xt_, Xe, Xn_dummy, F_, digits_, trg_data.ker_m2t);
+      }
+      for (const Long j : data.U_lst[i]) {
+        if (!src_cnt[j]) continue;
+        src_view(Xs_, Xn_, j);
+        src_dens(F_, j);
+        s2t_data.ker_s2t_eval_batch(U_, Xt_, Xs_, Xn_, F_, digits_, s2t_data.ker_s2t);
+      }
+
+      for (Long j = 0; j < Nt_; j++) {
+        for (Long d = 0; d < Nd; d++) {
+          for (Integer k = 0; k < TrgDim; k++) Ut[((trg_dsp[i]+j)*Nd+d)*TrgDim+k] = U_[d][j*TrgDim+k];
+        }
+      }
+    }
+    data.eval_time += omp_get_wtime() - t0;
+    Profile::Toc();
+
+    { // Scatter the potentials back to the original ordering of the targets
+      Vector<Real> U_;
+      tree.GetParticleData(U_, "trg_u");
+      SCTL_ASSERT(U_.Dim() == Nt * Nd * TrgDim);
+      for (Long i = 0; i < Nt; i++) {
+        for (Long d = 0; d < Nd; d++) {
+          for (Integer k = 0; k < TrgDim; k++) U[d][i*TrgDim+k] += U_[(i*Nd+d)*TrgDim+k];
+        }
+      }
+      tree.DeleteParticleData("trg_u");
+      tree.DeleteParticleData("src_f");
+    }
+  }
+}
 #endif
 
 }  // end namespace
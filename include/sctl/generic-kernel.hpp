@@ -1,14 +1,75 @@
 #ifndef _SCTL_GENERIC_KERNEL_HPP_
 #define _SCTL_GENERIC_KERNEL_HPP_
 
-#include "sctl/common.hpp"  // for Integer, sctl
-#include "sctl/vec.hpp"     // for Vec
+#include <vector>                 // for vector
+
+#include "sctl/common.hpp"        // for Integer, sctl
+#include "sctl/cpu-dispatch.hpp"  // for KernelDispatch
+#include "sctl/vec.hpp"           // for Vec
 
 namespace sctl {
 
 template <class ValueType> class Vector;
 template <class ValueType> class Matrix;
 
+#ifdef SCTL_HAVE_OMP_TARGET
+/**
+ * Keeps coordinate arrays mapped to the OpenMP target device across calls to `GenericKernel::Eval`,
+ * so that repeated evaluations with the same points do not transfer them again. Arrays are
+ * identified by their host address and length; a host copy of each array is kept so that changes
+ * to the contents are detected (with memcmp) and sent to the device. The least recently used
+ * arrays are released when the cache is full.
+ */
+class DeviceCoordCache {
+  public:
+
+    /**
+     * Ensure that the array is present and up-to-date on the default device.
+     * @param ptr Pointer to the host array.
+     * @param len Length of the array.
+     */
+    template <class Real> static void Map(const Real* ptr, Long len);
+
+    /**
+     * Release all arrays from the device.
+     */
+    static void Clear();
+
+    /**
+     * Enable or disable the host fallback. When enabled, the device code path is used even if no
+     * device is present, and the target regions run on the host. This is meant for testing.
+     * @return the previous state.
+     */
+    static bool HostFallback(bool state);
+
+    /**
+     * @return true if a device is present or the host fallback is enabled.
+     */
+    static bool Available();
+
+  private:
+
+    static constexpr Long MaxEntries = 16;
+
+    struct Entry {
+      const char* ptr;
+      Long bytes;
+      std::vector<char> data;  // copy of the contents on the device
+      Long last_use;
+    };
+
+    struct State {
+      std::vector<Entry> entries;
+      Long clock = 0;
+      bool host_fallback = false;
+    };
+
+    static State& GetState();
+
+    static void Release(const char* p, Long bytes);
+};
+#endif
+
 template <class uKernel, Integer KDIM0, Integer KDIM1, Integer DIM, Integer N_DIM> struct uKerHelper {
   template <Integer digits, class VecType> static void MatEval(VecType (&u)[KDIM0][KDIM1], const VecType (&r)[DIM], const VecType (&n)[N_DIM], const void* ctx_ptr) {
     uKernel::template uKerMatrix<digits>(u, r, n, ctx_ptr);
@@ -51,6 +112,9 @@ template <class uKernel> class GenericKernel : public uKernel {
     static constexpr Integer N_DIM = (ARGCNT > 3 ? argsize<2>(uKernel::template uKerMatrix<0,Vec<double,1>>)/sizeof(Vec<double,1>) : 0);
     static constexpr Integer N_DIM_ = (N_DIM?N_DIM:1); // non-zero
 
+    template <class T> static constexpr auto symmetric_helper(int) -> decltype(T::SYMMETRIC()) { return T::SYMMETRIC(); }
+    template <class T> static constexpr bool symmetric_helper(...) { return false; }
+
   public:
 
     /**
@@ -84,6 +148,13 @@ template <class uKernel> class GenericKernel : public uKernel {
      */
     static constexpr Integer TrgDim();
 
+    /**
+     * Returns true if the micro-kernel declares `SYMMETRIC()` (i.e. K(-r) = K(r)), the source and
+     * target dimensions are equal, and no normal vector is required. For such kernels, `EvalSelf`
+     * and `KernelMatrixSelf` compute each pair of particles only once.
+     */
+    static constexpr bool IsSymmetric();
+
     /**
      * Set the pointer to the context data.
      */
@@ -110,7 +181,16 @@ template <class uKernel> class GenericKernel : public uKernel {
     template <class Real, bool enable_openmp> static void Eval(Vector<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src, Integer digits, ConstIterator<char> self);
 
     /**
-     * Evaluates the kernel and stores the result in `v_trg`.
+     * Evaluates the kernel and stores the result in `v_trg`. With `SCTL_HAVE_OMP_TARGET` and
+     * `enable_openmp`, large evaluations (at least `SCTL_OMP_TARGET_MIN_INTERAC` source-target
+     * pairs) are offloaded to the default OpenMP target device, when one is available and the
+     * kernel does not use a context pointer.
+     *
+     * For `Real=double`, `0 <= digits <= SCTL_KERNEL_FLOAT_MAX_DIGITS` (default 6) and no context
+     * pointer, the kernel is evaluated in single precision (with twice as many SIMD lanes) and the
+     * potentials are accumulated in double precision. Coordinates relative to the center of the bounding box of
+     * all sources and targets are stored as float high and low parts, so that the distance between
+     * nearby points is computed to single precision.
      * @tparam Real The type of the real numbers used.
      * @tparam enable_openmp A boolean flag to enable OpenMP. Default is false.
      * @tparam digits The number of significant digits for evaluation. Default is -1 for machine-precision.
@@ -122,6 +202,35 @@ template <class uKernel> class GenericKernel : public uKernel {
      */
     template <class Real, bool enable_openmp=false, Integer digits=-1> void Eval(Vector<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src) const;
 
+    /**
+     * Evaluates the kernel for a batch of source densities and stores the result in `v_trg`. The
+     * kernel matrix for each source-target pair is computed once and applied to all densities.
+     * @tparam Real The type of the real numbers used.
+     * @tparam enable_openmp A boolean flag to enable OpenMP.
+     * @param v_trg The matrix to store the potential result (one potential per row).
+     * @param r_trg The vector of target point coordinates.
+     * @param r_src The vector of source point coordinates.
+     * @param n_src The vector of source normals.
+     * @param v_src The matrix of source densities (one density per row).
+     * @param digits The number of significant digits for evaluation.
+     * @param self A constant iterator pointing to the self interaction flag.
+     */
+    template <class Real, bool enable_openmp> static void Eval(Matrix<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Matrix<Real>& v_src, Integer digits, ConstIterator<char> self);
+
+    /**
+     * Evaluates the kernel for a batch of source densities and stores the result in `v_trg`. The
+     * kernel matrix for each source-target pair is computed once and applied to all densities.
+     * @tparam Real The type of the real numbers used.
+     * @tparam enable_openmp A boolean flag to enable OpenMP. Default is false.
+     * @tparam digits The number of significant digits for evaluation. Default is -1 for machine-precision.
+     * @param v_trg The matrix to store the potential result (one potential per row, in AoS order).
+     * @param r_trg The vector of target point coordinates.
+     * @param r_src The vector of source point coordinates.
+     * @param n_src The vector of source normals.
+     * @param v_src The matrix of source densities (one density per row, in AoS order).
+     */
+    template <class Real, bool enable_openmp=false, Integer digits=-1> void Eval(Matrix<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Matrix<Real>& v_src) const;
+
     /**
      * Computes the kernel matrix and stores it in `M`.
      * @tparam Real The type of the real numbers used.
@@ -134,6 +243,36 @@ template <class uKernel> class GenericKernel : public uKernel {
      */
     template <class Real, bool enable_openmp=false, Integer digits=-1> void KernelMatrix(Matrix<Real>& M, const Vector<Real>& Xt, const Vector<Real>& Xs, const Vector<Real>& Xn) const;
 
+    /**
+     * Evaluates the potential at the source points due to all the sources (including the
+     * self-interaction of each point with itself) and adds it to `v_trg`; equivalent to
+     * `Eval(v_trg, r_src, r_src, n_src, v_src)`. For symmetric kernels (see `IsSymmetric()`), each
+     * unordered pair is evaluated once and its contribution is accumulated on both sides.
+     * @tparam Real The type of the real numbers used.
+     * @tparam enable_openmp A boolean flag to enable OpenMP. Default is false.
+     * @tparam digits The number of significant digits for evaluation. Default is -1 for machine-precision.
+     * @param v_trg The vector to store the potential result.
+     * @param r_src The vector of source point coordinates.
+     * @param n_src The vector of source normals.
+     * @param v_src The vector of source densities.
+     */
+    template <class Real, bool enable_openmp=false, Integer digits=-1> void EvalSelf(Vector<Real>& v_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src) const;
+
+    /**
+     * Computes the kernel matrix between the points `Xs` and themselves and stores it in `M`;
+     * equivalent to `KernelMatrix(M, Xs, Xs, Xn)`. For symmetric kernels (see `IsSymmetric()`),
+     * only the blocks on and above the diagonal are evaluated and the rest are mirrored (for
+     * matrices up to 1 MB; larger matrices are limited by memory bandwidth and are evaluated in
+     * full).
+     * @tparam Real The type of the real numbers used.
+     * @tparam enable_openmp A boolean flag to enable OpenMP. Default is false.
+     * @tparam digits The number of significant digits for evaluation. Default is -1.
+     * @param M The matrix to store the kernel matrix.
+     * @param Xs The vector of point coordinates.
+     * @param Xn The vector of source normals.
+     */
+    template <class Real, bool enable_openmp=false, Integer digits=-1> void KernelMatrixSelf(Matrix<Real>& M, const Vector<Real>& Xs, const Vector<Real>& Xn) const;
+
     /**
      * Static method for kernel matrix computation.
      * @tparam digits The number of significant digits for evaluation.
@@ -146,7 +285,46 @@ template <class uKernel> class GenericKernel : public uKernel {
      */
     template <Integer digits, class VecType, class NormalType> static void uKerMatrix(VecType (&u)[KDIM0][KDIM1], const VecType (&r)[DIM], const NormalType& n, const void* ctx_ptr);
 
+    /**
+     * Returns the table of entry points of the variant of this kernel selected for the host CPU at
+     * startup (see `SCTL_CPU_DISPATCH_KERNEL`). When the table is empty, `Eval` and `KernelMatrix`
+     * use the code compiled in the calling translation unit.
+     * @tparam Real The type of the real numbers used.
+     * @return A reference to the dispatch table.
+     */
+    template <class Real> static KernelDispatch<Real>& DispatchTable();
+
+    /**
+     * Sets the entry points in `table` to the code compiled in the current translation unit.
+     * @tparam Real The type of the real numbers used.
+     * @param table The dispatch table to initialize.
+     */
+    template <class Real> static void DispatchInit(KernelDispatch<Real>& table);
+
   private:
+    template <class Real, bool enable_openmp> struct EvalOp; // calls Eval<Real,enable_openmp,digits>
+    template <class Real, bool enable_openmp> struct KernelMatrixOp; // calls KernelMatrix<Real,enable_openmp,digits>
+
+    /**
+     * Calls Op::apply<digits>(args...) with the compile-time digits matching the runtime value: 0 to 15, or -1
+     * (machine precision) for any other value.
+     */
+    template <class Op, Integer d = 15> struct DigitsSwitch;
+
+    template <class Real, bool enable_openmp, class VType> static void EvalDigits(VType& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const VType& v_src, Integer digits, ConstIterator<char> self);
+
+    template <class Real, bool enable_openmp> void KernelMatrixDigits(Matrix<Real>& M, const Vector<Real>& Xt, const Vector<Real>& Xs, const Vector<Real>& Xn, Integer digits) const;
+
+    template <class Real, bool enable_openmp> static void DispatchEval(Real* v_trg, const Real* r_trg, Long Nt, const Real* r_src, const Real* n_src, Long Ns, const Real* v_src, Long Nd, Integer digits, const void* ctx_ptr);
+
+    template <class Real, bool enable_openmp> static void DispatchKernelMatrix(Real* M, const Real* Xt, Long Nt, const Real* Xs, const Real* Xn, Long Ns, Integer digits, const void* ctx_ptr);
+
+    template <class Real, bool enable_openmp, Integer digits> void EvalMixed(Vector<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src) const;
+
+#ifdef SCTL_HAVE_OMP_TARGET
+    template <class Real, Integer digits> bool EvalDevice(Vector<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src) const;
+#endif
+
     void* ctx_ptr;
 };
 
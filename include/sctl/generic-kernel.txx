@@ -1,12 +1,20 @@
 #ifndef _SCTL_GENERIC_KERNEL_TXX_
 #define _SCTL_GENERIC_KERNEL_TXX_
 
-#include <algorithm>                // for min
+#include <omp.h>                    // for omp_get_max_threads, omp_in_parallel
+#include <algorithm>                // for min, max
+#include <cstring>                  // for memcmp, memcpy
+#include <type_traits>              // for is_same
+#include <utility>                  // for forward
+#include <vector>                   // for vector
 
 #include "sctl/common.hpp"          // for Integer, Long, SCTL_ASSERT, SCTL_...
+#include "sctl/cpu-dispatch.hpp"    // for KernelDispatch, CPUDispatch
+#include "sctl/cpu-dispatch.txx"    // for CPUDispatch::CompiledArch
 #include "sctl/generic-kernel.hpp"  // for GenericKernel, uKerHelper
 #include "sctl/intrin-wrapper.hpp"  // for TypeTraits
 #include "sctl/iterator.hpp"        // for ConstIterator, Iterator
+#include "sctl/iterator.txx"        // for Ptr2Itr, Ptr2ConstItr
 #include "sctl/matrix.hpp"          // for Matrix
 #include "sctl/profile.hpp"         // for Profile, ProfileCounter
 #include "sctl/profile.txx"         // for Profile::IncrementCounter
@@ -35,6 +43,10 @@ namespace sctl {
     return KDIM1;
   }
 
+  template <class uKernel> constexpr bool GenericKernel<uKernel>::IsSymmetric() {
+    return symmetric_helper<uKernel>(0) && KDIM0 == KDIM1 && N_DIM == 0;
+  }
+
   template <class uKernel> void GenericKernel<uKernel>::SetCtxPtr(void* ctx) {
     ctx_ptr = ctx;
   }
@@ -43,34 +55,41 @@ namespace sctl {
     return ctx_ptr;
   }
 
-  template <class uKernel> template <class Real, bool enable_openmp> void GenericKernel<uKernel>::Eval(Vector<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src, Integer digits, ConstIterator<char> self) {
-    if (digits < 8) {
-      if (digits < 4) {
-        if (digits == -1) ((ConstIterator<GenericKernel<uKernel>>)self)->template Eval<Real, enable_openmp,-1>(v_trg, r_trg, r_src, n_src, v_src);
-        if (digits ==  0) ((ConstIterator<GenericKernel<uKernel>>)self)->template Eval<Real, enable_openmp, 0>(v_trg, r_trg, r_src, n_src, v_src);
-        if (digits ==  1) ((ConstIterator<GenericKernel<uKernel>>)self)->template Eval<Real, enable_openmp, 1>(v_trg, r_trg, r_src, n_src, v_src);
-        if (digits ==  2) ((ConstIterator<GenericKernel<uKernel>>)self)->template Eval<Real, enable_openmp, 2>(v_trg, r_trg, r_src, n_src, v_src);
-        if (digits ==  3) ((ConstIterator<GenericKernel<uKernel>>)self)->template Eval<Real, enable_openmp, 3>(v_trg, r_trg, r_src, n_src, v_src);
-      } else {
-        if (digits ==  7) ((ConstIterator<GenericKernel<uKernel>>)self)->template Eval<Real, enable_openmp, 7>(v_trg, r_trg, r_src, n_src, v_src);
-        if (digits ==  6) ((ConstIterator<GenericKernel<uKernel>>)self)->template Eval<Real, enable_openmp, 6>(v_trg, r_trg, r_src, n_src, v_src);
-        if (digits ==  5) ((ConstIterator<GenericKernel<uKernel>>)self)->template Eval<Real, enable_openmp, 5>(v_trg, r_trg, r_src, n_src, v_src);
-        if (digits ==  4) ((ConstIterator<GenericKernel<uKernel>>)self)->template Eval<Real, enable_openmp, 4>(v_trg, r_trg, r_src, n_src, v_src);
-      }
-    } else {
-      if (digits < 12) {
-        if (digits ==  8) ((ConstIterator<GenericKernel<uKernel>>)self)->template Eval<Real, enable_openmp, 8>(v_trg, r_trg, r_src, n_src, v_src);
-        if (digits ==  9) ((ConstIterator<GenericKernel<uKernel>>)self)->template Eval<Real, enable_openmp, 9>(v_trg, r_trg, r_src, n_src, v_src);
-        if (digits == 10) ((ConstIterator<GenericKernel<uKernel>>)self)->template Eval<Real, enable_openmp,10>(v_trg, r_trg, r_src, n_src, v_src);
-        if (digits == 11) ((ConstIterator<GenericKernel<uKernel>>)self)->template Eval<Real, enable_openmp,11>(v_trg, r_trg, r_src, n_src, v_src);
-      } else {
-        if (digits == 12) ((ConstIterator<GenericKernel<uKernel>>)self)->template Eval<Real, enable_openmp,12>(v_trg, r_trg, r_src, n_src, v_src);
-        if (digits == 13) ((ConstIterator<GenericKernel<uKernel>>)self)->template Eval<Real, enable_openmp,13>(v_trg, r_trg, r_src, n_src, v_src);
-        if (digits == 14) ((ConstIterator<GenericKernel<uKernel>>)self)->template Eval<Real, enable_openmp,14>(v_trg, r_trg, r_src, n_src, v_src);
-        if (digits == 15) ((ConstIterator<GenericKernel<uKernel>>)self)->template Eval<Real, enable_openmp,15>(v_trg, r_trg, r_src, n_src, v_src);
-        if (digits >= 16) ((ConstIterator<GenericKernel<uKernel>>)self)->template Eval<Real, enable_openmp,-1>(v_trg, r_trg, r_src, n_src, v_src);
-      }
+  template <class uKernel> template <class Real, bool enable_openmp> struct GenericKernel<uKernel>::EvalOp {
+    template <Integer digits, class VType> static void apply(const GenericKernel<uKernel>& ker, VType& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const VType& v_src) {
+      ker.template Eval<Real, enable_openmp, digits>(v_trg, r_trg, r_src, n_src, v_src);
+    }
+  };
+
+  template <class uKernel> template <class Real, bool enable_openmp> struct GenericKernel<uKernel>::KernelMatrixOp {
+    template <Integer digits> static void apply(const GenericKernel<uKernel>& ker, Matrix<Real>& M, const Vector<Real>& Xt, const Vector<Real>& Xs, const Vector<Real>& Xn) {
+      ker.template KernelMatrix<Real, enable_openmp, digits>(M, Xt, Xs, Xn);
+    }
+  };
+
+  template <class uKernel> template <class Op, Integer d> struct GenericKernel<uKernel>::DigitsSwitch {
+    template <class... Args> static void call(Integer digits, Args&&... args) {
+      if (digits == d) Op::template apply<d>(std::forward<Args>(args)...);
+      else DigitsSwitch<Op, d-1>::call(digits, std::forward<Args>(args)...);
     }
+  };
+  template <class uKernel> template <class Op> struct GenericKernel<uKernel>::DigitsSwitch<Op, -1> {
+    template <class... Args> static void call(Integer digits, Args&&... args) {
+      Op::template apply<-1>(std::forward<Args>(args)...);
+    }
+  };
+
+  template <class uKernel> template <class Real, bool enable_openmp, class VType> void GenericKernel<uKernel>::EvalDigits(VType& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const VType& v_src, Integer digits, ConstIterator<char> self) {
+    const GenericKernel<uKernel>& ker = *(ConstIterator<GenericKernel<uKernel>>)self;
+    DigitsSwitch<EvalOp<Real,enable_openmp>>::call(digits, ker, v_trg, r_trg, r_src, n_src, v_src);
+  }
+
+  template <class uKernel> template <class Real, bool enable_openmp> void GenericKernel<uKernel>::Eval(Vector<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src, Integer digits, ConstIterator<char> self) {
+    EvalDigits<Real,enable_openmp>(v_trg, r_trg, r_src, n_src, v_src, digits, self);
+  }
+
+  template <class uKernel> template <class Real, bool enable_openmp> void GenericKernel<uKernel>::Eval(Matrix<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Matrix<Real>& v_src, Integer digits, ConstIterator<char> self) {
+    EvalDigits<Real,enable_openmp>(v_trg, r_trg, r_src, n_src, v_src, digits, self);
   }
 
   template <class uKernel> template <class Real, bool enable_openmp, Integer digits> void GenericKernel<uKernel>::Eval(Vector<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src) const {
@@ -99,9 +118,28 @@ namespace sctl {
       v_trg.ReInit(Nt*KDIM1);
       v_trg.SetZero();
     }
+#ifdef SCTL_HAVE_OMP_TARGET
+    if (enable_openmp && EvalDevice<Real,digits>(v_trg, r_trg, r_src, n_src, v_src)) {
+      Profile::IncrementCounter(ProfileCounter::FLOP, Ns*Nt*uKernel::FLOPS());
+      return;
+    }
+#endif
+    const auto& dispatch = DispatchTable<Real>();
+    if (dispatch.eval[enable_openmp]) { // use the variant selected for the host CPU
+      if (Ns && Nt) dispatch.eval[enable_openmp](&v_trg[0], &r_trg[0], Nt, &r_src[0], (N_DIM ? &n_src[0] : nullptr), Ns, &v_src[0], 1, digits, ctx_ptr);
+      Profile::IncrementCounter(ProfileCounter::FLOP, Ns*Nt*uKernel::FLOPS());
+      return;
+    }
+    static constexpr bool MixedPrec = std::is_same<Real,double>::value && digits >= 0 && digits <= SCTL_KERNEL_FLOAT_MAX_DIGITS;
+    if (MixedPrec && !ctx_ptr) { // float kernel evaluation is accurate enough (the context data has type Real)
+      EvalMixed<Real,enable_openmp,(MixedPrec?digits:0)>(v_trg, r_trg, r_src, n_src, v_src);
+      Profile::IncrementCounter(ProfileCounter::FLOP, Ns*Nt*uKernel::FLOPS());
+      return;
+    }
 
     const Long NNt = ((Nt + VecLen - 1) / VecLen) * VecLen;
-    if (NNt == VecLen) {
+    const Integer omp_p = (enable_openmp && !omp_in_parallel() ? omp_get_max_threads() : 1);
+    if (NNt == VecLen && omp_p == 1) {
       RealVec xt[DIM], vt[KDIM1], xs[DIM], ns[N_DIM_], vs[KDIM0];
       for (Integer k = 0; k < KDIM1; k++) vt[k] = RealVec::Zero();
       for (Integer k = 0; k < DIM; k++) {
@@ -124,11 +162,19 @@ namespace sctl {
         }
       }
     } else {
-      const Matrix<Real> Xs_(Ns, DIM, (Iterator<Real>)r_src.begin(), false);
-      const Matrix<Real> Ns_(Ns, N_DIM, (Iterator<Real>)n_src.begin(), false);
-      const Matrix<Real> Vs_(Ns, KDIM0, (Iterator<Real>)v_src.begin(), false);
+      // Sources are packed in SoA order and processed in tiles that fit in
+      // the L1 cache. Each thread evaluates a range of target blocks for a
+      // range of source tiles (a 2D decomposition); threads sharing the same
+      // targets accumulate to separate buffers which are summed at the end.
+      static constexpr Integer SrcDof = DIM + N_DIM + KDIM0;
+      static constexpr Long L1TileSize = (16*1024) / (SrcDof*(Long)sizeof(Real)); // sources in 16KB
+      static constexpr Long TileSize = (L1TileSize > VecLen ? L1TileSize : VecLen);
+      const Long Nblk = NNt / VecLen;
+      const Long Ntile = (Ns + TileSize - 1) / TileSize;
+      const Integer omp_pt = (Integer)std::max<Long>(1, std::min<Long>(omp_p, Nblk)); // threads over target blocks
+      const Integer omp_ps = (Integer)std::max<Long>(1, std::min<Long>(omp_p / omp_pt, Ntile)); // threads over source tiles
 
-      Matrix<Real> Xt_, Vt_;
+      Matrix<Real> Xt_, Vt_, Vt_priv;
       constexpr Integer Nbuff = 16*1024;
       alignas(sizeof(RealVec)) StaticArray<Real,Nbuff> buff;
       if (DIM*NNt < Nbuff) {
@@ -141,6 +187,11 @@ namespace sctl {
       } else {
         Vt_.ReInit(KDIM1, NNt);
       }
+      if (omp_ps > 1) { // accumulators for the source ranges 1 ... omp_ps-1
+        Vt_priv.ReInit((omp_ps-1)*KDIM1, NNt);
+        Vt_priv.SetZero();
+      }
+      Vt_.SetZero();
 
       for (Long k = 0; k < DIM; k++) { // Set Xt_
         for (Long i = 0; i < Nt; i++) {
@@ -150,32 +201,48 @@ namespace sctl {
           Xt_[k][i] = 0;
         }
       }
-      if (enable_openmp) { // Compute Vt_
-        #pragma omp parallel for schedule(static)
-        for (Long t = 0; t < NNt; t += VecLen) {
+
+      Matrix<Real> Src_(SrcDof, Ns); // Set Src_ = {Xs[0][0..Ns), ..., Xn[0][0..Ns), ..., Vs[0][0..Ns), ...}
+      for (Long s = 0; s < Ns; s++) {
+        for (Integer k = 0; k < DIM; k++) Src_[k][s] = r_src[s*DIM+k];
+        for (Integer k = 0; k < N_DIM; k++) Src_[DIM+k][s] = n_src[s*N_DIM+k];
+        for (Integer k = 0; k < KDIM0; k++) Src_[DIM+N_DIM+k][s] = v_src[s*KDIM0+k];
+      }
+
+      auto eval_tile = [&Xt_,&Src_,&uKerEval](Matrix<Real>& Vt, const Long t0, const Long t1, const Long s0, const Long s1) {
+        for (Long t = t0; t < t1; t += VecLen) {
           RealVec xt[DIM], vt[KDIM1], xs[DIM], ns[N_DIM_], vs[KDIM0];
-          for (Integer k = 0; k < KDIM1; k++) vt[k] = RealVec::Zero();
+          for (Integer k = 0; k < KDIM1; k++) vt[k] = RealVec::LoadAligned(&Vt[k][t]);
           for (Integer k = 0; k < DIM; k++) xt[k] = RealVec::LoadAligned(&Xt_[k][t]);
-          for (Long s = 0; s < Ns; s++) {
-            for (Integer k = 0; k < DIM; k++) xs[k] = RealVec::Load1(&Xs_[s][k]);
-            for (Integer k = 0; k < N_DIM; k++) ns[k] = RealVec::Load1(&Ns_[s][k]);
-            for (Integer k = 0; k < KDIM0; k++) vs[k] = RealVec::Load1(&Vs_[s][k]);
+          for (Long s = s0; s < s1; s++) {
+            for (Integer k = 0; k < DIM; k++) xs[k] = RealVec::Load1(&Src_[k][s]);
+            for (Integer k = 0; k < N_DIM; k++) ns[k] = RealVec::Load1(&Src_[DIM+k][s]);
+            for (Integer k = 0; k < KDIM0; k++) vs[k] = RealVec::Load1(&Src_[DIM+N_DIM+k][s]);
             uKerEval(vt, xt, xs, ns, vs);
           }
-          for (Integer k = 0; k < KDIM1; k++) vt[k].StoreAligned(&Vt_[k][t]);
+          for (Integer k = 0; k < KDIM1; k++) vt[k].StoreAligned(&Vt[k][t]);
         }
-      } else {
-        for (Long t = 0; t < NNt; t += VecLen) {
-          RealVec xt[DIM], vt[KDIM1], xs[DIM], ns[N_DIM_], vs[KDIM0];
-          for (Integer k = 0; k < KDIM1; k++) vt[k] = RealVec::Zero();
-          for (Integer k = 0; k < DIM; k++) xt[k] = RealVec::LoadAligned(&Xt_[k][t]);
-          for (Long s = 0; s < Ns; s++) {
-            for (Integer k = 0; k < DIM; k++) xs[k] = RealVec::Load1(&Xs_[s][k]);
-            for (Integer k = 0; k < N_DIM; k++) ns[k] = RealVec::Load1(&Ns_[s][k]);
-            for (Integer k = 0; k < KDIM0; k++) vs[k] = RealVec::Load1(&Vs_[s][k]);
-            uKerEval(vt, xt, xs, ns, vs);
+      };
+      // The (target range, tile range) pairs are handed out as work items
+      // rather than by thread id, since the runtime may start a smaller team
+      // than requested (e.g. with OMP_DYNAMIC or OMP_THREAD_LIMIT).
+      #pragma omp parallel for schedule(static) num_threads(omp_pt*omp_ps) if(omp_pt*omp_ps > 1)
+      for (Integer w = 0; w < omp_pt*omp_ps; w++) { // Compute Vt_
+        const Integer tid_t = w % omp_pt, tid_s = w / omp_pt;
+        const Long t0 = (Nblk * (tid_t+0) / omp_pt) * VecLen;
+        const Long t1 = (Nblk * (tid_t+1) / omp_pt) * VecLen;
+        const Long tile0 = Ntile * (tid_s+0) / omp_ps;
+        const Long tile1 = Ntile * (tid_s+1) / omp_ps;
+        Matrix<Real> Vt(KDIM1, NNt, (tid_s ? Vt_priv.begin() + (tid_s-1)*KDIM1*NNt : Vt_.begin()), false);
+        for (Long tile = tile0; tile < tile1; tile++) {
+          eval_tile(Vt, t0, t1, tile*TileSize, std::min<Long>(Ns, (tile+1)*TileSize));
+        }
+      }
+      for (Integer p = 1; p < omp_ps; p++) { // Vt_ += Vt_priv
+        for (Long k = 0; k < KDIM1; k++) {
+          for (Long i = 0; i < NNt; i++) {
+            Vt_[k][i] += Vt_priv[(p-1)*KDIM1+k][i];
           }
-          for (Integer k = 0; k < KDIM1; k++) vt[k].StoreAligned(&Vt_[k][t]);
         }
       }
 
@@ -188,6 +255,193 @@ namespace sctl {
     Profile::IncrementCounter(ProfileCounter::FLOP, Ns*Nt*uKernel::FLOPS());
   }
 
+  template <class uKernel> template <class Real, bool enable_openmp, Integer digits> void GenericKernel<uKernel>::EvalMixed(Vector<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src) const {
+    static constexpr Integer VecLen = DefaultVecLen<float>();
+    using FloatVec = Vec<float, VecLen>;
+    static constexpr Integer SrcDof = 2*DIM + N_DIM + KDIM0;
+    static constexpr Long TileSize = 256; // sources accumulated in float before adding to the double accumulators
+
+    const Long Ns = r_src.Dim() / DIM;
+    const Long Nt = r_trg.Dim() / DIM;
+    const Long Nblk = (Nt + VecLen - 1) / VecLen;
+
+    // Coordinates relative to the center of the bounding box are split into
+    // float high and low parts: x = x_hi + x_lo. The difference of the high
+    // parts is exact for nearby points, so that dX = (xt_hi - xs_hi) +
+    // (xt_lo - xs_lo) is accurate relative to the distance between points.
+    Real c[DIM];
+    for (Integer k = 0; k < DIM; k++) {
+      Real x0 = r_trg[k], x1 = r_trg[k];
+      for (Long t = 0; t < Nt; t++) {
+        x0 = std::min<Real>(x0, r_trg[t*DIM+k]);
+        x1 = std::max<Real>(x1, r_trg[t*DIM+k]);
+      }
+      for (Long s = 0; s < Ns; s++) {
+        x0 = std::min<Real>(x0, r_src[s*DIM+k]);
+        x1 = std::max<Real>(x1, r_src[s*DIM+k]);
+      }
+      c[k] = (x0 + x1) / 2;
+    }
+    const auto split = [](float& x_hi, float& x_lo, const Real x) {
+      x_hi = (float)x;
+      x_lo = (float)(x - (Real)x_hi);
+    };
+
+    Matrix<float> Src_(SrcDof, Ns); // Set Src_ = {Xs_hi[0][0..Ns), ..., Xs_lo[0][0..Ns), ..., Xn[0][0..Ns), ..., Vs[0][0..Ns), ...}
+    for (Long s = 0; s < Ns; s++) {
+      for (Integer k = 0; k < DIM; k++) split(Src_[k][s], Src_[DIM+k][s], r_src[s*DIM+k] - c[k]);
+      for (Integer k = 0; k < N_DIM; k++) Src_[2*DIM+k][s] = (float)n_src[s*N_DIM+k];
+      for (Integer k = 0; k < KDIM0; k++) Src_[2*DIM+N_DIM+k][s] = (float)v_src[s*KDIM0+k];
+    }
+
+    const Real scal = uKernel::template uKerScaleFactor<Real>();
+    #pragma omp parallel for schedule(static) if(enable_openmp && !omp_in_parallel() && Nblk > 1)
+    for (Long b = 0; b < Nblk; b++) {
+      const Long t0 = b * VecLen;
+      const Long t1 = std::min<Long>(Nt, t0 + VecLen);
+
+      FloatVec xt_hi[DIM], xt_lo[DIM];
+      for (Integer k = 0; k < DIM; k++) {
+        alignas(sizeof(FloatVec)) StaticArray<float,VecLen> Xhi, Xlo;
+        FloatVec::Zero().StoreAligned(&Xhi[0]);
+        FloatVec::Zero().StoreAligned(&Xlo[0]);
+        for (Long t = t0; t < t1; t++) split(Xhi[t-t0], Xlo[t-t0], r_trg[t*DIM+k] - c[k]);
+        xt_hi[k] = FloatVec::LoadAligned(&Xhi[0]);
+        xt_lo[k] = FloatVec::LoadAligned(&Xlo[0]);
+      }
+
+      StaticArray<Real,VecLen> Vt[KDIM1];
+      for (Integer k = 0; k < KDIM1; k++) {
+        for (Integer i = 0; i < VecLen; i++) Vt[k][i] = 0;
+      }
+      for (Long s0 = 0; s0 < Ns; s0 += TileSize) {
+        const Long s1 = std::min<Long>(Ns, s0 + TileSize);
+        FloatVec vt[KDIM1], dX[DIM], ns[N_DIM_], U[KDIM0][KDIM1];
+        for (Integer k = 0; k < KDIM1; k++) vt[k] = FloatVec::Zero();
+        for (Long s = s0; s < s1; s++) {
+          for (Integer k = 0; k < DIM; k++) dX[k] = (xt_hi[k] - FloatVec::Load1(&Src_[k][s])) + (xt_lo[k] - FloatVec::Load1(&Src_[DIM+k][s]));
+          for (Integer k = 0; k < N_DIM; k++) ns[k] = FloatVec::Load1(&Src_[2*DIM+k][s]);
+          uKerMatrix<digits>(U, dX, ns, ctx_ptr);
+          for (Integer k0 = 0; k0 < KDIM0; k0++) {
+            const FloatVec vs = FloatVec::Load1(&Src_[2*DIM+N_DIM+k0][s]);
+            for (Integer k1 = 0; k1 < KDIM1; k1++) {
+              vt[k1] = FMA(U[k0][k1], vs, vt[k1]);
+            }
+          }
+        }
+        for (Integer k = 0; k < KDIM1; k++) {
+          alignas(sizeof(FloatVec)) StaticArray<float,VecLen> out;
+          vt[k].StoreAligned(&out[0]);
+          for (Integer i = 0; i < VecLen; i++) Vt[k][i] += (Real)out[i];
+        }
+      }
+      for (Long t = t0; t < t1; t++) {
+        for (Integer k = 0; k < KDIM1; k++) {
+          v_trg[t*KDIM1+k] += Vt[k][t-t0] * scal;
+        }
+      }
+    }
+  }
+
+  template <class uKernel> template <class Real, bool enable_openmp, Integer digits> void GenericKernel<uKernel>::Eval(Matrix<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Matrix<Real>& v_src) const {
+    static constexpr Integer digits_ = (digits==-1 ? (Integer)(TypeTraits<Real>::SigBits*0.3010299957) : digits);
+    static constexpr Integer VecLen = DefaultVecLen<Real>();
+    using RealVec = Vec<Real, VecLen>;
+
+    const Long Nd = v_src.Dim(0);
+    const Long Ns = r_src.Dim() / DIM;
+    const Long Nt = r_trg.Dim() / DIM;
+    SCTL_ASSERT(r_trg.Dim() == Nt*DIM);
+    SCTL_ASSERT(r_src.Dim() == Ns*DIM);
+    SCTL_ASSERT(v_src.Dim(1) == Ns*KDIM0);
+    SCTL_ASSERT(n_src.Dim() == Ns*N_DIM || !N_DIM);
+    if (v_trg.Dim(0) != Nd || v_trg.Dim(1) != Nt*KDIM1) {
+      v_trg.ReInit(Nd, Nt*KDIM1);
+      v_trg.SetZero();
+    }
+    if (!Nd || !Ns || !Nt) return;
+    if (Nd == 1) { // single density
+      Vector<Real> v_trg_(Nt*KDIM1, v_trg.begin(), false);
+      const Vector<Real> v_src_(Ns*KDIM0, (Iterator<Real>)v_src.begin(), false);
+      Eval<Real,enable_openmp,digits>(v_trg_, r_trg, r_src, n_src, v_src_);
+      return;
+    }
+#ifdef SCTL_HAVE_OMP_TARGET
+    if (enable_openmp && !ctx_ptr && !omp_in_parallel() && omp_get_num_devices() > 0 && Ns*Nt >= SCTL_OMP_TARGET_MIN_INTERAC) {
+      for (Long d = 0; d < Nd; d++) { // coordinates stay on the device across densities
+        Vector<Real> v_trg_(Nt*KDIM1, v_trg[d], false);
+        const Vector<Real> v_src_(Ns*KDIM0, (Iterator<Real>)v_src[d], false);
+        Eval<Real,enable_openmp,digits>(v_trg_, r_trg, r_src, n_src, v_src_);
+      }
+      return;
+    }
+#endif
+    const auto& dispatch = DispatchTable<Real>();
+    if (dispatch.eval[enable_openmp]) { // use the variant selected for the host CPU
+      dispatch.eval[enable_openmp](&v_trg[0][0], &r_trg[0], Nt, &r_src[0], (N_DIM ? &n_src[0] : nullptr), Ns, &v_src[0][0], Nd, digits, ctx_ptr);
+      Profile::IncrementCounter(ProfileCounter::FLOP, Ns*Nt*(uKernel::FLOPS() + (Nd-1)*KDIM0*KDIM1*2));
+      return;
+    }
+
+    const Long NNt = ((Nt + VecLen - 1) / VecLen) * VecLen;
+    Matrix<Real> Xt_(DIM, NNt);
+    for (Long k = 0; k < DIM; k++) { // Set Xt_
+      for (Long i = 0; i < Nt; i++) {
+        Xt_[k][i] = r_trg[i*DIM+k];
+      }
+      for (Long i = Nt; i < NNt; i++) {
+        Xt_[k][i] = 0;
+      }
+    }
+    Vector<Real> Vs_(Ns*Nd*KDIM0); // densities for each source stored contiguously: {v_src[0][s], v_src[1][s], ...}
+    for (Long s = 0; s < Ns; s++) {
+      for (Long d = 0; d < Nd; d++) {
+        for (Long k = 0; k < KDIM0; k++) {
+          Vs_[(s*Nd+d)*KDIM0+k] = v_src[d][s*KDIM0+k];
+        }
+      }
+    }
+
+    #pragma omp parallel if(enable_openmp)
+    {
+      alignas(sizeof(RealVec)) StaticArray<Real,VecLen> out;
+      Vector<RealVec> vt(Nd*KDIM1); // accumulators for all densities
+      #pragma omp for schedule(static)
+      for (Long t = 0; t < NNt; t += VecLen) {
+        RealVec xt[DIM], xs[DIM], ns[N_DIM_], dX[DIM], U[KDIM0][KDIM1];
+        for (Long k = 0; k < Nd*KDIM1; k++) vt[k] = RealVec::Zero();
+        for (Integer k = 0; k < DIM; k++) xt[k] = RealVec::LoadAligned(&Xt_[k][t]);
+        for (Long s = 0; s < Ns; s++) {
+          for (Integer k = 0; k < DIM; k++) xs[k] = RealVec::Load1(&r_src[s*DIM+k]);
+          for (Integer k = 0; k < N_DIM; k++) ns[k] = RealVec::Load1(&n_src[s*N_DIM+k]);
+          for (Integer k = 0; k < DIM; k++) dX[k] = xt[k] - xs[k];
+          uKerMatrix<digits_>(U, dX, ns, ctx_ptr);
+
+          ConstIterator<Real> vs_ = Vs_.begin() + s*Nd*KDIM0;
+          for (Long d = 0; d < Nd; d++) {
+            for (Integer k0 = 0; k0 < KDIM0; k0++) {
+              const RealVec vs = RealVec::Load1(&vs_[d*KDIM0+k0]);
+              for (Integer k1 = 0; k1 < KDIM1; k1++) {
+                vt[d*KDIM1+k1] = FMA(U[k0][k1], vs, vt[d*KDIM1+k1]);
+              }
+            }
+          }
+        }
+
+        const Long Nt_ = std::min<Long>(VecLen, Nt-t);
+        for (Long d = 0; d < Nd; d++) {
+          for (Integer k = 0; k < KDIM1; k++) {
+            vt[d*KDIM1+k].StoreAligned(&out[0]);
+            for (Long i = 0; i < Nt_; i++) {
+              v_trg[d][(t+i)*KDIM1+k] += out[i] * uKernel::template uKerScaleFactor<Real>();
+            }
+          }
+        }
+      }
+    }
+    Profile::IncrementCounter(ProfileCounter::FLOP, Ns*Nt*(uKernel::FLOPS() + (Nd-1)*KDIM0*KDIM1*2));
+  }
+
   template <class uKernel> template <class Real, bool enable_openmp, Integer digits> void GenericKernel<uKernel>::KernelMatrix(Matrix<Real>& M, const Vector<Real>& Xt, const Vector<Real>& Xs, const Vector<Real>& Xn) const {
     static constexpr Integer digits_ = (digits==-1 ? (Integer)(TypeTraits<Real>::SigBits*0.3010299957) : digits);
     static constexpr Integer VecLen = DefaultVecLen<Real>();
@@ -200,6 +454,11 @@ namespace sctl {
       M.SetZero();
     }
     Profile::IncrementCounter(ProfileCounter::FLOP, Ns*Nt*uKernel::FLOPS());
+    const auto& dispatch = DispatchTable<Real>();
+    if (dispatch.kernel_matrix[enable_openmp]) { // use the variant selected for the host CPU
+      if (Ns && Nt) dispatch.kernel_matrix[enable_openmp](&M[0][0], &Xt[0], Nt, &Xs[0], (N_DIM ? &Xn[0] : nullptr), Ns, digits, ctx_ptr);
+      return;
+    }
 
     if (Xt.Dim() == DIM) {
       alignas(sizeof(VecType)) StaticArray<Real,VecLen> Xs_[DIM];
@@ -306,10 +565,355 @@ namespace sctl {
     }
   }
 
+  template <class uKernel> template <class Real, bool enable_openmp, Integer digits> void GenericKernel<uKernel>::EvalSelf(Vector<Real>& v_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src) const {
+    if (!IsSymmetric()) {
+      Eval<Real,enable_openmp,digits>(v_trg, r_src, r_src, n_src, v_src);
+      return;
+    }
+    static constexpr Integer digits_ = (digits==-1 ? (Integer)(TypeTraits<Real>::SigBits*0.3010299957) : digits);
+    static constexpr Integer VecLen = DefaultVecLen<Real>();
+    using RealVec = Vec<Real, VecLen>;
+
+    const Long N = r_src.Dim() / DIM;
+    SCTL_ASSERT(r_src.Dim() == N*DIM);
+    SCTL_ASSERT(v_src.Dim() == N*KDIM0);
+    if (v_trg.Dim() != N*KDIM1) {
+      v_trg.ReInit(N*KDIM1);
+      v_trg.SetZero();
+    }
+    if (!N) return;
+
+    // The points are split into blocks of size B. The interactions within
+    // each diagonal block are evaluated directly. For each pair of blocks
+    // (I,J) with I < J, the kernel matrix is computed once and applied to the
+    // densities of both blocks (using K(-r) = K(r)). The pairs are scheduled
+    // in rounds (a round-robin tournament) so that the pairs in a round have
+    // no blocks in common and can be processed by different threads without
+    // synchronization.
+    const Integer omp_p = (enable_openmp && !omp_in_parallel() ? omp_get_max_threads() : 1);
+    const Long B = std::max<Long>(VecLen, std::min<Long>(256, ((N + 2*omp_p - 1) / (2*omp_p) + VecLen - 1) / VecLen * VecLen));
+    const Long Nb = (N + B - 1) / B;
+    const Long NN = Nb * B;
+    const Long Nr = Nb + (Nb % 2); // number of blocks, including a dummy block when Nb is odd
+
+    Matrix<Real> X_(DIM+KDIM0, NN), V_(KDIM1, NN); // zero padded coordinates and densities (in SoA order), and potentials
+    for (Long i = 0; i < N; i++) {
+      for (Integer k = 0; k < DIM; k++) X_[k][i] = r_src[i*DIM+k];
+      for (Integer k = 0; k < KDIM0; k++) X_[DIM+k][i] = v_src[i*KDIM0+k];
+    }
+    for (Long k = 0; k < DIM+KDIM0; k++) {
+      for (Long i = N; i < NN; i++) X_[k][i] = 0;
+    }
+    V_.SetZero();
+
+    const auto eval_blocks = [this,&X_,&V_,N,B](const Long I, const Long J) { // sources in block I, targets in block J
+      const Long t0 = J * B, t1 = t0 + B;
+      for (Long s = I*B; s < std::min<Long>(N, (I+1)*B); s++) {
+        RealVec xs[DIM], fs[KDIM0], vs[KDIM1], ns[N_DIM_];
+        for (Integer k = 0; k < DIM; k++) xs[k] = RealVec::Load1(&X_[k][s]);
+        for (Integer k = 0; k < KDIM0; k++) fs[k] = RealVec::Load1(&X_[DIM+k][s]);
+        for (Integer k = 0; k < KDIM1; k++) vs[k] = RealVec::Zero();
+        for (Long t = t0; t < t1; t += VecLen) {
+          RealVec dX[DIM], U[KDIM0][KDIM1], vt[KDIM1];
+          for (Integer k = 0; k < DIM; k++) dX[k] = RealVec::LoadAligned(&X_[k][t]) - xs[k];
+          for (Integer k = 0; k < KDIM1; k++) vt[k] = RealVec::LoadAligned(&V_[k][t]);
+          uKerMatrix<digits_>(U, dX, ns, ctx_ptr);
+          for (Integer k0 = 0; k0 < KDIM0; k0++) {
+            for (Integer k1 = 0; k1 < KDIM1; k1++) {
+              vt[k1] = FMA(U[k0][k1], fs[k0], vt[k1]);
+            }
+          }
+          if (I != J) {
+            for (Integer k0 = 0; k0 < KDIM0; k0++) {
+              const RealVec ft = RealVec::LoadAligned(&X_[DIM+k0][t]);
+              for (Integer k1 = 0; k1 < KDIM1; k1++) {
+                vs[k1] = FMA(U[k0][k1], ft, vs[k1]);
+              }
+            }
+          }
+          for (Integer k = 0; k < KDIM1; k++) vt[k].StoreAligned(&V_[k][t]);
+        }
+        if (I != J) {
+          for (Integer k = 0; k < KDIM1; k++) {
+            alignas(sizeof(RealVec)) StaticArray<Real,VecLen> out;
+            vs[k].StoreAligned(&out[0]);
+            Real sum = 0;
+            for (Integer i = 0; i < VecLen; i++) sum += out[i];
+            V_[k][s] += sum;
+          }
+        }
+      }
+    };
+    #pragma omp parallel num_threads(omp_p) if(omp_p > 1)
+    {
+      #pragma omp for schedule(static)
+      for (Long I = 0; I < Nb; I++) eval_blocks(I, I);
+      for (Long r = 0; r < Nr-1; r++) { // the implicit barrier after each round avoids write conflicts
+        #pragma omp for schedule(dynamic)
+        for (Long I = 0; I < Nr-1; I++) {
+          Long J = (2*r - I + 2*(Nr-1)) % (Nr-1);
+          if (J == I) J = Nr-1;
+          if (I < J && J < Nb) eval_blocks(I, J);
+        }
+      }
+    }
+
+    for (Long k = 0; k < KDIM1; k++) { // v_trg += V_
+      for (Long i = 0; i < N; i++) {
+        v_trg[i*KDIM1+k] += V_[k][i] * uKernel::template uKerScaleFactor<Real>();
+      }
+    }
+    Profile::IncrementCounter(ProfileCounter::FLOP, ((N*N + N*B) / 2) * uKernel::FLOPS());
+  }
+
+  template <class uKernel> template <class Real, bool enable_openmp, Integer digits> void GenericKernel<uKernel>::KernelMatrixSelf(Matrix<Real>& M, const Vector<Real>& Xs, const Vector<Real>& Xn) const {
+    // For larger matrices, the assembly is limited by memory bandwidth and
+    // copying the mirrored blocks costs more than evaluating them.
+    static constexpr Long MaxBytes = 1024*1024;
+    const Long N = Xs.Dim()/DIM;
+    if (!IsSymmetric() || N*KDIM0*N*KDIM1*(Long)sizeof(Real) > MaxBytes) {
+      KernelMatrix<Real,enable_openmp,digits>(M, Xs, Xs, Xn);
+      return;
+    }
+    if (M.Dim(0) != N*KDIM0 || M.Dim(1) != N*KDIM1) {
+      M.ReInit(N*KDIM0, N*KDIM1);
+      M.SetZero();
+    }
+
+    static constexpr Integer digits_ = (digits==-1 ? (Integer)(TypeTraits<Real>::SigBits*0.3010299957) : digits);
+    static constexpr Integer VecLen = DefaultVecLen<Real>();
+    using RealVec = Vec<Real, VecLen>;
+
+    // The points are split into blocks of size B. First, the kernel matrix is
+    // computed for the blocks (I,J) with I <= J (row by row, as in
+    // KernelMatrix). Then, the blocks (J,I) are copied from the blocks (I,J)
+    // using M[t*KDIM0+k0][s*KDIM1+k1] = M[s*KDIM0+k0][t*KDIM1+k1] (since
+    // K(-r) = K(r)).
+    static constexpr Long B = 4*VecLen;
+    const Long Nb = (N + B - 1) / B;
+    const Long NN = ((N + VecLen - 1) / VecLen) * VecLen;
+    const Real scal = uKernel::template uKerScaleFactor<Real>();
+
+    Matrix<Real> Xt_(DIM, NN); // zero padded coordinates (in SoA order)
+    for (Long k = 0; k < DIM; k++) {
+      for (Long i = 0; i < NN; i++) Xt_[k][i] = (i < N ? Xs[i*DIM+k] : 0);
+    }
+    #pragma omp parallel if(enable_openmp && !omp_in_parallel() && Nb > 1)
+    {
+      #pragma omp for schedule(dynamic)
+      for (Long s = 0; s < N; s++) { // Set blocks (I,J) for I <= J
+        const Long t0 = (s / B) * B;
+        alignas(sizeof(RealVec)) StaticArray<Real,VecLen> U_[KDIM0*KDIM1];
+        RealVec xs[DIM], ns[N_DIM_];
+        for (Integer k = 0; k < DIM; k++) xs[k] = RealVec::Load1(&Xt_[k][s]);
+        for (Long t = t0; t < N; t += VecLen) {
+          const Long Nt_ = std::min<Long>(VecLen, N-t);
+          RealVec dX[DIM], U[KDIM0][KDIM1];
+          for (Integer k = 0; k < DIM; k++) dX[k] = RealVec::LoadAligned(&Xt_[k][t]) - xs[k];
+          uKerMatrix<digits_>(U, dX, ns, ctx_ptr);
+          for (Integer k0 = 0; k0 < KDIM0; k0++) {
+            for (Integer k1 = 0; k1 < KDIM1; k1++) {
+              U[k0][k1].StoreAligned(&U_[k0*KDIM1+k1][0]);
+            }
+          }
+          for (Integer k0 = 0; k0 < KDIM0; k0++) {
+            for (Long i = 0; i < Nt_; i++) {
+              for (Integer k1 = 0; k1 < KDIM1; k1++) {
+                M[s*KDIM0+k0][(t+i)*KDIM1+k1] = U_[k0*KDIM1+k1][i] * scal;
+              }
+            }
+          }
+        }
+      }
+      #pragma omp for schedule(dynamic)
+      for (Long IJ = 0; IJ < Nb*Nb; IJ++) { // Set blocks (J,I) for I < J
+        const Long I = IJ / Nb, J = IJ % Nb;
+        if (I >= J) continue;
+        const Long s0 = I*B, s1 = std::min<Long>(N, s0+B);
+        const Long t0 = J*B, t1 = std::min<Long>(N, t0+B);
+        for (Long t = t0; t < t1; t++) {
+          for (Integer k0 = 0; k0 < KDIM0; k0++) {
+            for (Long s = s0; s < s1; s++) {
+              for (Integer k1 = 0; k1 < KDIM1; k1++) {
+                M[t*KDIM0+k0][s*KDIM1+k1] = M[s*KDIM0+k0][t*KDIM1+k1];
+              }
+            }
+          }
+        }
+      }
+    }
+    Profile::IncrementCounter(ProfileCounter::FLOP, ((N*N + N*B) / 2) * uKernel::FLOPS());
+  }
+
   template <class uKernel> template <Integer digits, class VecType, class NormalType> void GenericKernel<uKernel>::uKerMatrix(VecType (&u)[KDIM0][KDIM1], const VecType (&r)[DIM], const NormalType& n, const void* ctx_ptr) {
     uKerHelper<uKernel,KDIM0,KDIM1,DIM,N_DIM>::template MatEval<digits>(u, r, n, ctx_ptr);
   };
 
+#ifdef SCTL_HAVE_OMP_TARGET
+  template <class uKernel> template <class Real, Integer digits> bool GenericKernel<uKernel>::EvalDevice(Vector<Real>& v_trg, const Vector<Real>& r_trg, const Vector<Real>& r_src, const Vector<Real>& n_src, const Vector<Real>& v_src) const {
+    static constexpr Integer digits_ = (digits==-1 ? (Integer)(TypeTraits<Real>::SigBits*0.3010299957) : digits);
+    using RealVec = Vec<Real,1>; // scalar code on the device
+
+    const Long Ns = r_src.Dim() / DIM;
+    const Long Nt = r_trg.Dim() / DIM;
+    if (ctx_ptr || omp_in_parallel() || !DeviceCoordCache::Available()) return false; // context data is not accessible on the device
+    if (Ns*Nt < SCTL_OMP_TARGET_MIN_INTERAC) return false;
+
+    const Real* Xt = &r_trg[0];
+    const Real* Xs = &r_src[0];
+    const Real* Xn = (N_DIM ? &n_src[0] : nullptr);
+    const Real* Vs = &v_src[0];
+    Real* Vt = &v_trg[0];
+    const Long Nn = Ns*N_DIM;
+    DeviceCoordCache::Map(Xt, Nt*DIM);
+    DeviceCoordCache::Map(Xs, Ns*DIM);
+    if (N_DIM) DeviceCoordCache::Map(Xn, Nn);
+
+    // Densities and potentials are transferred asynchronously; the targets
+    // are split into chunks so that copying back the potentials for one
+    // chunk overlaps with the evaluation of the next.
+    const Real scal = uKernel::template uKerScaleFactor<Real>();
+    const Long Nchunk = std::min<Long>(4, (Nt + 1023) / 1024);
+    #pragma omp target enter data map(to: Vs[0:Ns*KDIM0]) nowait depend(out: Vs[0])
+    for (Long c = 0; c < Nchunk; c++) {
+      const Long t0 = Nt * (c+0) / Nchunk;
+      const Long t1 = Nt * (c+1) / Nchunk;
+      #pragma omp target teams distribute parallel for map(to: Xt[0:Nt*DIM], Xs[0:Ns*DIM], Xn[0:Nn], Vs[0:Ns*KDIM0]) map(tofrom: Vt[t0*KDIM1:(t1-t0)*KDIM1]) nowait depend(in: Vs[0]) depend(out: Vt[t0*KDIM1])
+      for (Long t = t0; t < t1; t++) {
+        RealVec vt[KDIM1], dX[DIM], ns[N_DIM_], U[KDIM0][KDIM1];
+        for (Integer k = 0; k < KDIM1; k++) vt[k] = RealVec::Zero();
+        for (Long s = 0; s < Ns; s++) {
+          for (Integer k = 0; k < DIM; k++) dX[k] = RealVec(Xt[t*DIM+k] - Xs[s*DIM+k]);
+          for (Integer k = 0; k < N_DIM; k++) ns[k] = RealVec(Xn[s*N_DIM+k]);
+          uKerMatrix<digits_>(U, dX, ns, nullptr);
+          for (Integer k0 = 0; k0 < KDIM0; k0++) {
+            const RealVec vs(Vs[s*KDIM0+k0]);
+            for (Integer k1 = 0; k1 < KDIM1; k1++) {
+              vt[k1] = FMA(U[k0][k1], vs, vt[k1]);
+            }
+          }
+        }
+        for (Integer k = 0; k < KDIM1; k++) Vt[t*KDIM1+k] += vt[k].get().v[0] * scal;
+      }
+    }
+    #pragma omp taskwait
+    #pragma omp target exit data map(release: Vs[0:Ns*KDIM0])
+    return true;
+  }
+
+  template <class Real> void DeviceCoordCache::Map(const Real* ptr, Long len) {
+    if (!len) return;
+    const char* p = (const char*)ptr;
+    const Long bytes = len * (Long)sizeof(Real);
+
+    #pragma omp critical(SCTL_DEVICE_COORD_CACHE)
+    {
+      auto& entries = GetState().entries;
+      Long& clock = GetState().clock;
+      bool found = false;
+      for (auto& e : entries) {
+        if (e.ptr == p && e.bytes == bytes) {
+          if (memcmp(e.data.data(), p, bytes)) {
+            #pragma omp target update to(p[0:bytes])
+            memcpy(e.data.data(), p, bytes);
+          }
+          e.last_use = clock++;
+          found = true;
+        }
+      }
+      if (!found) {
+        for (Long i = (Long)entries.size()-1; i >= 0; i--) { // the host memory may have been reused
+          const auto& e = entries[i];
+          if (e.ptr < p + bytes && p < e.ptr + e.bytes) {
+            Release(e.ptr, e.bytes);
+            entries.erase(entries.begin() + i);
+          }
+        }
+        if ((Long)entries.size() >= MaxEntries) {
+          Long i0 = 0;
+          for (Long i = 1; i < (Long)entries.size(); i++) {
+            if (entries[i].last_use < entries[i0].last_use) i0 = i;
+          }
+          Release(entries[i0].ptr, entries[i0].bytes);
+          entries.erase(entries.begin() + i0);
+        }
+        #pragma omp target enter data map(to: p[0:bytes])
+        entries.push_back(Entry{p, bytes, std::vector<char>(p, p + bytes), clock++});
+      }
+    }
+  }
+
+  inline void DeviceCoordCache::Clear() {
+    #pragma omp critical(SCTL_DEVICE_COORD_CACHE)
+    {
+      auto& entries = GetState().entries;
+      for (const auto& e : entries) Release(e.ptr, e.bytes);
+      entries.clear();
+    }
+  }
+
+  inline bool DeviceCoordCache::HostFallback(bool state) {
+    bool prev;
+    #pragma omp critical(SCTL_DEVICE_COORD_CACHE)
+    {
+      prev = GetState().host_fallback;
+      GetState().host_fallback = state;
+    }
+    return prev;
+  }
+
+  inline bool DeviceCoordCache::Available() {
+    return GetState().host_fallback || omp_get_num_devices() > 0;
+  }
+
+  inline DeviceCoordCache::State& DeviceCoordCache::GetState() {
+    static State state;
+    return state;
+  }
+
+  inline void DeviceCoordCache::Release(const char* p, Long bytes) {
+    #pragma omp target exit data map(release: p[0:bytes])
+  }
+#endif
+
+  template <class uKernel> template <class Real> KernelDispatch<Real>& GenericKernel<uKernel>::DispatchTable() {
+    static KernelDispatch<Real> table;
+    return table;
+  }
+
+  template <class uKernel> template <class Real> void GenericKernel<uKernel>::DispatchInit(KernelDispatch<Real>& table) {
+    table.arch = CPUDispatch::CompiledArch();
+    table.eval[0] = DispatchEval<Real,false>;
+    table.eval[1] = DispatchEval<Real,true>;
+    table.kernel_matrix[0] = DispatchKernelMatrix<Real,false>;
+    table.kernel_matrix[1] = DispatchKernelMatrix<Real,true>;
+  }
+
+  template <class uKernel> template <class Real, bool enable_openmp> void GenericKernel<uKernel>::KernelMatrixDigits(Matrix<Real>& M, const Vector<Real>& Xt, const Vector<Real>& Xs, const Vector<Real>& Xn, Integer digits) const {
+    DigitsSwitch<KernelMatrixOp<Real,enable_openmp>>::call(digits, *this, M, Xt, Xs, Xn);
+  }
+
+  template <class uKernel> template <class Real, bool enable_openmp> void GenericKernel<uKernel>::DispatchEval(Real* v_trg, const Real* r_trg, Long Nt, const Real* r_src, const Real* n_src, Long Ns, const Real* v_src, Long Nd, Integer digits, const void* ctx_ptr) {
+    GenericKernel<uKernel> ker;
+    ker.SetCtxPtr((void*)ctx_ptr);
+    Matrix<Real> v_trg_(Nd, Nt*KDIM1, Ptr2Itr<Real>(v_trg, Nd*Nt*KDIM1), false);
+    const Matrix<Real> v_src_(Nd, Ns*KDIM0, (Iterator<Real>)Ptr2ConstItr<Real>(v_src, Nd*Ns*KDIM0), false);
+    const Vector<Real> r_trg_(Nt*DIM, (Iterator<Real>)Ptr2ConstItr<Real>(r_trg, Nt*DIM), false);
+    const Vector<Real> r_src_(Ns*DIM, (Iterator<Real>)Ptr2ConstItr<Real>(r_src, Ns*DIM), false);
+    const Vector<Real> n_src_(Ns*N_DIM, (Iterator<Real>)Ptr2ConstItr<Real>(n_src, Ns*N_DIM), false);
+    Eval<Real,enable_openmp>(v_trg_, r_trg_, r_src_, n_src_, v_src_, digits, Ptr2ConstItr<char>(&ker, sizeof(ker)));
+  }
+
+  template <class uKernel> template <class Real, bool enable_openmp> void GenericKernel<uKernel>::DispatchKernelMatrix(Real* M, const Real* Xt, Long Nt, const Real* Xs, const Real* Xn, Long Ns, Integer digits, const void* ctx_ptr) {
+    GenericKernel<uKernel> ker;
+    ker.SetCtxPtr((void*)ctx_ptr);
+    Matrix<Real> M_(Ns*KDIM0, Nt*KDIM1, Ptr2Itr<Real>(M, Ns*KDIM0*Nt*KDIM1), false);
+    const Vector<Real> Xt_(Nt*DIM, (Iterator<Real>)Ptr2ConstItr<Real>(Xt, Nt*DIM), false);
+    const Vector<Real> Xs_(Ns*DIM, (Iterator<Real>)Ptr2ConstItr<Real>(Xs, Ns*DIM), false);
+    const Vector<Real> Xn_(Ns*N_DIM, (Iterator<Real>)Ptr2ConstItr<Real>(Xn, Ns*N_DIM), false);
+    ker.template KernelMatrixDigits<Real,enable_openmp>(M_, Xt_, Xs_, Xn_, digits);
+  }
+
 }  // end namespace
 
 #endif // _SCTL_GENERIC_KERNEL_TXX_
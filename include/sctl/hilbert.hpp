@@ -0,0 +1,261 @@
+#ifndef _SCTL_HILBERT_HPP_
+#define _SCTL_HILBERT_HPP_
+
+#include <ostream>          // for ostream
+#include <array>            // for array
+#include <cstdint>          // for uint8_t, int8_t, uint64_t
+
+#include "sctl/common.hpp"  // for Integer, Long, sctl
+#include "sctl/morton.hpp"  // for SCTL_MAX_DEPTH
+#include "sctl/ompUtils.hpp"  // for RadixKey
+
+namespace sctl {
+
+template <class ValueType> class Vector;
+
+/**
+ * Hilbert class template representing a Hilbert index in a space-filling curve. It has the same interface as Morton
+ * and can be used in its place as the key type of Tree (e.g. `Tree<DIM, Hilbert<DIM>>`). The boxes are the same as
+ * for Morton; only the ordering differs. Consecutive boxes along the Hilbert curve are always face-adjacent, which
+ * gives more compact processor partitions and fewer ghost nodes.
+ *
+ * The Hilbert index of a box is computed using the algorithm of J. Skilling (Programming the Hilbert curve, AIP Conf.
+ * Proc. 707, 2004) and is stored along with the box coordinates.
+ *
+ * @tparam DIM Dimensionality of the Hilbert index. Defaults to 3.
+ */
+template <Integer DIM = 3> class Hilbert {
+
+ public:
+  /**
+   * Unsigned integer type for the coordinates of a box (same as Morton).
+   */
+  typedef typename Morton<DIM>::UINT_T UINT_T;
+
+  /**
+   * Unsigned integer type for the Hilbert index.
+   */
+  typedef uint64_t HINT_T;
+
+  /**
+   * Maximum depth of the Hilbert index.
+   */
+  static constexpr Integer MAX_DEPTH = SCTL_MAX_DEPTH;
+
+  /**
+   * Get the maximum depth of the Hilbert index.
+   *
+   * @return The maximum depth of the Hilbert index.
+   */
+  static constexpr Integer MaxDepth();
+
+  /**
+   * Default constructor for Hilbert.
+   */
+  Hilbert();
+
+  /**
+   * Constructor for Hilbert using coordinate iterators.
+   *
+   * @param coord ConstIterator to the coordinates.
+   * @param depth_ Depth of the Hilbert index. Defaults to maximum depth.
+   */
+  template <class T> explicit Hilbert(ConstIterator<T> coord, uint8_t depth_ = MAX_DEPTH);
+
+  /**
+   * Get the depth of the Hilbert index.
+   *
+   * @return The depth of the Hilbert index.
+   */
+  int8_t Depth() const;
+
+  /**
+   * Get the coordinates of the origin of a Hilbert box.
+   *
+   * @tparam ArrayType Type of the array to store coordinates.
+   * @param coord Array to store coordinates.
+   */
+  template <class ArrayType> void Coord(ArrayType&& coord) const;
+
+  /**
+   * Get the coordinates of the origin of a Hilbert box.
+   *
+   * @tparam Real Floating point type of the coordinates.
+   * @return Array containing coordinates.
+   */
+  template <class Real> std::array<Real,DIM> Coord() const;
+
+  /**
+   * Get the Hilbert index of the next box along the curve.
+   *
+   * @return Hilbert index of the next box.
+   */
+  Hilbert Next() const;
+
+  /**
+   * Get the Hilbert index of the ancestor box at a given level. If the level is deeper than the depth of this box,
+   * then the first descendant (along the curve) at that level is returned.
+   *
+   * @param ancestor_level Level of the ancestor box.
+   * @return Hilbert index of the ancestor box.
+   */
+  Hilbert Ancestor(uint8_t ancestor_level) const;
+
+  /**
+   * Get the Hilbert index of the deepest first descendant box.
+   *
+   * @param level Depth level.
+   * @return Hilbert index of the deepest first descendant.
+   */
+  Hilbert DFD(uint8_t level = MAX_DEPTH) const;
+
+  /**
+   * Get a list of the 3^DIM neighbor Hilbert IDs (in the same order as Morton::NbrList). If a neighbor doesn't
+   * exist then the corresponding vector element has negative depth.
+   *
+   * @param nbrs Vector to store neighboring Hilbert indices.
+   * @param level Depth level.
+   * @param periodic Flag indicating periodic boundary conditions.
+   */
+  void NbrList(Vector<Hilbert>& nbrs, uint8_t level, bool periodic) const;
+
+  /**
+   * Get the Hilbert indices of the children boxes, in the order along the curve.
+   *
+   * @param nlst Vector to store Hilbert indices of children boxes.
+   */
+  void Children(Vector<Hilbert> &nlst) const;
+
+  /**
+   * Less than comparison operator.
+   *
+   * @param m Hilbert index to compare with.
+   * @return True if this Hilbert index is less than the given Hilbert index, false otherwise.
+   */
+  bool operator<(const Hilbert &m) const;
+
+  /**
+   * Greater than comparison operator.
+   *
+   * @param m Hilbert index to compare with.
+   * @return True if this Hilbert index is greater than the given Hilbert index, false otherwise.
+   */
+  bool operator>(const Hilbert &m) const;
+
+  /**
+   * Inequality comparison operator.
+   *
+   * @param m Hilbert index to compare with.
+   * @return True if this Hilbert index is not equal to the given Hilbert index, false otherwise.
+   */
+  bool operator!=(const Hilbert &m) const;
+
+  /**
+   * Equality comparison operator.
+   *
+   * @param m Hilbert index to compare with.
+   * @return True if this Hilbert index is equal to the given Hilbert index, false otherwise.
+   */
+  bool operator==(const Hilbert &m) const;
+
+  /**
+   * Less than or equal to comparison operator.
+   *
+   * @param m Hilbert index to compare with.
+   * @return True if this Hilbert index is less than or equal to the given Hilbert index, false otherwise.
+   */
+  bool operator<=(const Hilbert &m) const;
+
+  /**
+   * Greater than or equal to comparison operator.
+   *
+   * @param m Hilbert index to compare with.
+   * @return True if this Hilbert index is greater than or equal to the given Hilbert index, false otherwise.
+   */
+  bool operator>=(const Hilbert &m) const;
+
+  /**
+   * Check if this Hilbert index is an ancestor of another Hilbert index.
+   *
+   * @param descendant Hilbert index to check against.
+   * @return True if this Hilbert index is an ancestor of the given Hilbert index, false otherwise.
+   */
+  bool isAncestor(Hilbert const &descendant) const;
+
+  /**
+   * Compute the distance between two boxes (same as for Morton).
+   *
+   * @param I Hilbert index to subtract.
+   * @return Difference in Hilbert indices.
+   */
+  Long operator-(const Hilbert<DIM> &I) const;
+
+  /**
+   * Overloaded stream insertion operator.
+   *
+   * @param out Output stream.
+   * @param hid Hilbert index to output.
+   * @return Reference to the output stream.
+   */
+  template <Integer D> friend std::ostream& operator<<(std::ostream &out, const Hilbert<D> &hid);
+
+  friend struct omp_par::RadixKey<Hilbert>;
+
+ private:
+
+  static_assert(DIM * MAX_DEPTH < 64, "SCTL_MAX_DEPTH too large for Hilbert index.");
+
+  /**
+   * Maximum coordinate value.
+   */
+  static constexpr UINT_T maxCoord = ((UINT_T)1) << (MAX_DEPTH);
+
+  /**
+   * Hilbert index of the point with coordinates x (at maximum depth).
+   */
+  static HINT_T Encode(const UINT_T* x);
+
+  /**
+   * Coordinates x of the point with Hilbert index h (at maximum depth).
+   */
+  static void Decode(UINT_T* x, HINT_T h);
+
+  /**
+   * Mask for the leading digits of the Hilbert index of a box at the given level.
+   */
+  static HINT_T Mask(Integer level);
+
+  /**
+   * Set the coordinates of the box from the Hilbert index and the depth.
+   */
+  void SetCoord();
+
+  /**
+   * Array storing coordinates.
+   */
+  UINT_T x[DIM];
+
+  /**
+   * Hilbert index (DIM bits per level, truncated to the depth of the box).
+   */
+  HINT_T h;
+
+  /**
+   * Depth of the Hilbert index.
+   */
+  int8_t depth;
+};
+
+/**
+ * Radix sort key of a Hilbert index: the Hilbert index followed by the depth. Enabled when this fits in 64 bits.
+ */
+template <Integer DIM> struct omp_par::RadixKey<Hilbert<DIM>> {
+  static constexpr bool Enabled = (DIM * SCTL_MAX_DEPTH + 1 + 8 <= 64);
+  static constexpr bool MergeSort = Enabled;
+  typedef uint64_t KeyType;
+  static KeyType Key(const Hilbert<DIM>& m);
+};
+
+}
+
+#endif // _SCTL_HILBERT_HPP_
@@ -0,0 +1,263 @@
+#ifndef _SCTL_HILBERT_TXX_
+#define _SCTL_HILBERT_TXX_
+
+#include <ostream>              // for ostream
+#include <algorithm>            // for max
+#include <array>                // for array
+#include <cstdint>              // for uint8_t, int8_t
+#include <type_traits>          // for remove_reference
+
+#include "sctl/common.hpp"      // for Integer, Long, SCTL_ASSERT, SCTL_NAME...
+#include "sctl/hilbert.hpp"     // for Hilbert
+#include "sctl/iterator.hpp"    // for ConstIterator
+#include "sctl/math_utils.hpp"  // for floor
+#include "sctl/math_utils.txx"  // for pow
+#include "sctl/vector.hpp"      // for Vector
+
+namespace sctl {
+
+  template <Integer DIM> constexpr Integer Hilbert<DIM>::MaxDepth() {
+    return MAX_DEPTH;
+  }
+
+  template <Integer DIM> Hilbert<DIM>::Hilbert() {
+    depth = 0;
+    h = 0;
+    for (Integer i = 0; i < DIM; i++) x[i] = 0;
+  }
+
+  template <Integer DIM> template <class T> Hilbert<DIM>::Hilbert(ConstIterator<T> coord, uint8_t depth_) {
+    depth = depth_;
+    SCTL_ASSERT(depth <= MAX_DEPTH);
+    UINT_T mask = ~((((UINT_T)1) << (MAX_DEPTH - depth)) - 1);
+    for (Integer i = 0; i < DIM; i++) x[i] = mask & (UINT_T)floor((double)coord[i] * maxCoord);
+    h = Encode(x) & Mask(depth);
+  }
+
+  template <Integer DIM> int8_t Hilbert<DIM>::Depth() const {
+    return depth;
+  }
+
+  template <Integer DIM> template <class ArrayType> void Hilbert<DIM>::Coord(ArrayType&& coord) const {
+    using Real = typename std::remove_reference<decltype(coord[0])>::type;
+    static const Real factor = 1.0 / (Real)maxCoord;
+    for (Integer i = 0; i < DIM; i++) coord[i] = (Real)x[i] * factor;
+  }
+  template <Integer DIM> template <class Real> std::array<Real,DIM> Hilbert<DIM>::Coord() const {
+    std::array<Real,DIM> x_real;
+    Coord(x_real);
+    return x_real;
+  }
+
+  template <Integer DIM> Hilbert<DIM> Hilbert<DIM>::Next() const {
+    static constexpr HINT_T digit_mask = (((HINT_T)1) << DIM) - 1;
+
+    Hilbert m;
+    m.h = h + (((HINT_T)1) << (DIM * (MAX_DEPTH - depth)));
+    m.depth = depth;
+    while (m.depth > 0 && !((m.h >> (DIM * (MAX_DEPTH - m.depth))) & digit_mask)) m.depth--; // carry to the parent
+    m.SetCoord();
+    return m;
+  }
+
+  template <Integer DIM> Hilbert<DIM> Hilbert<DIM>::Ancestor(uint8_t ancestor_level) const {
+    Hilbert m;
+    m.h = h & Mask(ancestor_level);
+    m.depth = ancestor_level;
+    if (ancestor_level <= depth) {
+      UINT_T mask = ~((((UINT_T)1) << (MAX_DEPTH - ancestor_level)) - 1);
+      for (Integer i = 0; i < DIM; i++) m.x[i] = x[i] & mask;
+    } else { // first descendant along the curve
+      m.SetCoord();
+    }
+    return m;
+  }
+
+  template <Integer DIM> Hilbert<DIM> Hilbert<DIM>::DFD(uint8_t level) const {
+    return Ancestor(level);
+  }
+
+  template <Integer DIM> void Hilbert<DIM>::NbrList(Vector<Hilbert>& nbrs, uint8_t level, bool periodic) const {
+    static constexpr Integer MAX_NBRS = sctl::pow<DIM,Integer>(3);
+    if (nbrs.Dim() != MAX_NBRS) nbrs.ReInit(MAX_NBRS);
+
+    const UINT_T box_size = (((UINT_T)1) << (MAX_DEPTH - level));
+    const UINT_T mask = ~(box_size - 1);
+
+    for (Integer i = 0; i < DIM; i++) nbrs[0].x[i] = x[i] & mask;
+    nbrs[0].depth = level;
+    Integer Nnbrs = 1;
+
+    constexpr UINT_T mask0 = (maxCoord - 1);
+    for (Integer i = 0; i < DIM; i++) {
+      for (Integer j = 0; j < Nnbrs; j++) {
+        const auto m0 = nbrs[j];
+        auto& m1 = nbrs[0*Nnbrs+j];
+        auto& m2 = nbrs[1*Nnbrs+j];
+        auto& m3 = nbrs[2*Nnbrs+j];
+        m1 = m0;
+        m2 = m0;
+        m3 = m0;
+        m1.x[i] = (m0.x[i] - box_size) & mask0;
+        m2.x[i] = (m0.x[i]           ) & mask0;
+        m3.x[i] = (m0.x[i] + box_size) & mask0;
+        if (!periodic && m0.x[i] < box_size) m1.depth = -1;
+        if (!periodic && m0.x[i] + box_size >= maxCoord) m3.depth = -1;
+      }
+      Nnbrs *= 3;
+    }
+
+    const HINT_T hmask = Mask(level);
+    for (Integer j = 0; j < MAX_NBRS; j++) {
+      nbrs[j].h = (nbrs[j].depth >= 0 ? Encode(nbrs[j].x) & hmask : 0);
+    }
+  }
+
+  template <Integer DIM> void Hilbert<DIM>::Children(Vector<Hilbert> &nlst) const {
+    SCTL_ASSERT(depth < MAX_DEPTH);
+    static const Integer cnt = (1UL << DIM);
+    if (nlst.Dim() != cnt) nlst.ReInit(cnt);
+
+    const Integer shift = DIM * (MAX_DEPTH - (depth + 1));
+    for (Integer j = 0; j < cnt; j++) {
+      nlst[j].h = h + (((HINT_T)j) << shift);
+      nlst[j].depth = (uint8_t)(depth + 1);
+      nlst[j].SetCoord();
+    }
+  }
+
+  template <Integer DIM> bool Hilbert<DIM>::operator<(const Hilbert &m) const {
+    return (h < m.h) || (h == m.h && depth < m.depth);
+  }
+
+  template <Integer DIM> bool Hilbert<DIM>::operator>(const Hilbert &m) const {
+    return m < (*this);
+  }
+
+  template <Integer DIM> bool Hilbert<DIM>::operator!=(const Hilbert &m) const {
+    return (h != m.h) || (depth != m.depth);
+  }
+
+  template <Integer DIM> bool Hilbert<DIM>::operator==(const Hilbert &m) const {
+    return !(*this != m);
+  }
+
+  template <Integer DIM> bool Hilbert<DIM>::operator<=(const Hilbert &m) const {
+    return !(*this > m);
+  }
+
+  template <Integer DIM> bool Hilbert<DIM>::operator>=(const Hilbert &m) const {
+    return !(*this < m);
+  }
+
+  template <Integer DIM> bool Hilbert<DIM>::isAncestor(Hilbert const &descendant) const {
+    return descendant.depth > depth && (descendant.h & Mask(depth)) == h;
+  }
+
+  template <Integer DIM> Long Hilbert<DIM>::operator-(const Hilbert<DIM> &I) const {
+    // Intersecting -1
+    // Touching 0
+
+    const UINT_T offset0 = ((UINT_T)1) << (MAX_DEPTH - depth);
+    const UINT_T offset1 = ((UINT_T)1) << (MAX_DEPTH - I.depth);
+
+    UINT_T diff = 0;
+    for (Integer i = 0; i < DIM; i++) {
+      const UINT_T Xc0 = ((UINT_T)x[i]*2 + offset0);
+      const UINT_T Xc1 = ((UINT_T)I.x[i]*2 + offset1);
+      diff = std::max<UINT_T>(diff, (Xc0 > Xc1) ? (Xc0 - Xc1) : (Xc1 - Xc0));
+    }
+    if (diff < offset0 + offset1) return -1;
+    Integer max_depth = std::max(depth, I.depth);
+    diff = (diff - offset0 - offset1) >> (MAX_DEPTH+1 - max_depth);
+    return diff;
+  }
+
+  template <Integer DIM> typename Hilbert<DIM>::HINT_T Hilbert<DIM>::Encode(const UINT_T* x) {
+    UINT_T X[DIM];
+    for (Integer i = 0; i < DIM; i++) X[i] = x[i];
+
+    const UINT_T M = ((UINT_T)1) << (MAX_DEPTH - 1);
+    for (UINT_T Q = M; Q > 1; Q >>= 1) { // inverse undo
+      const UINT_T P = Q - 1;
+      for (Integer i = 0; i < DIM; i++) {
+        if (X[i] & Q) {
+          X[0] ^= P;
+        } else {
+          const UINT_T t = (X[0] ^ X[i]) & P;
+          X[0] ^= t;
+          X[i] ^= t;
+        }
+      }
+    }
+    for (Integer i = 1; i < DIM; i++) X[i] ^= X[i-1]; // Gray encode
+    UINT_T t = 0;
+    for (UINT_T Q = M; Q > 1; Q >>= 1) {
+      if (X[DIM-1] & Q) t ^= Q - 1;
+    }
+    for (Integer i = 0; i < DIM; i++) X[i] ^= t;
+
+    HINT_T h = 0; // interleave the transposed bits
+    for (Integer b = MAX_DEPTH - 1; b >= 0; b--) {
+      for (Integer i = 0; i < DIM; i++) h = (h << 1) | ((X[i] >> b) & 1);
+    }
+    return h;
+  }
+
+  template <Integer DIM> void Hilbert<DIM>::Decode(UINT_T* x, HINT_T h) {
+    UINT_T X[DIM];
+    for (Integer i = 0; i < DIM; i++) X[i] = 0;
+    for (Integer b = MAX_DEPTH - 1; b >= 0; b--) { // transpose the bits
+      for (Integer i = 0; i < DIM; i++) X[i] |= (UINT_T)((h >> (b * DIM + DIM - 1 - i)) & 1) << b;
+    }
+
+    UINT_T t = X[DIM-1] >> 1; // Gray decode
+    for (Integer i = DIM - 1; i > 0; i--) X[i] ^= X[i-1];
+    X[0] ^= t;
+    for (UINT_T Q = 2; Q != maxCoord; Q <<= 1) { // undo excess work
+      const UINT_T P = Q - 1;
+      for (Integer i = DIM - 1; i >= 0; i--) {
+        if (X[i] & Q) {
+          X[0] ^= P;
+        } else {
+          t = (X[0] ^ X[i]) & P;
+          X[0] ^= t;
+          X[i] ^= t;
+        }
+      }
+    }
+    for (Integer i = 0; i < DIM; i++) x[i] = X[i];
+  }
+
+  template <Integer DIM> typename Hilbert<DIM>::HINT_T Hilbert<DIM>::Mask(Integer level) {
+    return ~((((HINT_T)1) << (DIM * (MAX_DEPTH - level))) - 1);
+  }
+
+  template <Integer DIM> void Hilbert<DIM>::SetCoord() {
+    if (h >> (DIM * MAX_DEPTH)) { // past the end of the curve (e.g. Hilbert().Next())
+      x[0] = maxCoord;
+      for (Integer i = 1; i < DIM; i++) x[i] = 0;
+      return;
+    }
+    Decode(x, h);
+    const UINT_T mask = ~((((UINT_T)1) << (MAX_DEPTH - depth)) - 1);
+    for (Integer i = 0; i < DIM; i++) x[i] &= mask;
+  }
+
+  template <Integer DIM> uint64_t omp_par::RadixKey<Hilbert<DIM>>::Key(const Hilbert<DIM>& m) {
+    return (m.h << 8) | (uint8_t)((int)m.depth + 128);
+  }
+
+  template <Integer DIM> std::ostream& operator<<(std::ostream &out, const Hilbert<DIM> &hid) {
+    const double a = (double)hid.h / (double)(((typename Hilbert<DIM>::HINT_T)1) << (DIM * Hilbert<DIM>::MAX_DEPTH));
+    out << "(";
+    for (Integer i = 0; i < DIM; i++) {
+      out << hid.x[i] * 1.0 / Hilbert<DIM>::maxCoord << ",";
+    }
+    out << (int)hid.depth << "," << a << ")";
+    return out;
+  }
+
+}
+
+#endif // _SCTL_HILBERT_TXX_
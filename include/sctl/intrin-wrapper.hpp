@@ -25,6 +25,12 @@
 #    include <x86intrin.h>
 #  endif
 #endif
+#if defined(SCTL_SVE_BITS)
+#  include <arm_sve.h>
+#endif
+#if defined(SCTL_RVV_BITS)
+#  include <riscv_vector.h>
+#endif
 #if defined(SCTL_HAVE_LIBMVEC)
   #if defined(SCTL_HAVE_SVML)
     #error "SCTL_HAVE_LIBMVEC defined with mutually exclusive SCTL_HAVE_SVML"
@@ -3281,4 +3287,581 @@ namespace sctl { // AVX512
 #endif
 }
 
+namespace sctl { // SVE
+#if defined(SCTL_SVE_BITS)
+  // Vector length agnostic SVE types are sizeless; the fixed-length types below require compiling
+  // with -msve-vector-bits=<bits> matching the hardware (e.g. -msve-vector-bits=512 on A64FX).
+  typedef svint32_t sve_int32_t __attribute__((arm_sve_vector_bits(SCTL_SVE_BITS)));
+  typedef svint64_t sve_int64_t __attribute__((arm_sve_vector_bits(SCTL_SVE_BITS)));
+  typedef svfloat32_t sve_float32_t __attribute__((arm_sve_vector_bits(SCTL_SVE_BITS)));
+  typedef svfloat64_t sve_float64_t __attribute__((arm_sve_vector_bits(SCTL_SVE_BITS)));
+  typedef svbool_t sve_bool_t __attribute__((arm_sve_vector_bits(SCTL_SVE_BITS)));
+
+  template <> struct alignas(SCTL_SVE_BITS/8) VecData<int32_t,SCTL_SVE_BITS/32> {
+    using ScalarType = int32_t;
+    static constexpr Integer Size = SCTL_SVE_BITS/32;
+    VecData() = default;
+    inline VecData(sve_int32_t v_) : v(v_) {}
+    sve_int32_t v;
+  };
+  template <> struct alignas(SCTL_SVE_BITS/8) VecData<int64_t,SCTL_SVE_BITS/64> {
+    using ScalarType = int64_t;
+    static constexpr Integer Size = SCTL_SVE_BITS/64;
+    VecData() = default;
+    inline VecData(sve_int64_t v_) : v(v_) {}
+    sve_int64_t v;
+  };
+  template <> struct alignas(SCTL_SVE_BITS/8) VecData<float,SCTL_SVE_BITS/32> {
+    using ScalarType = float;
+    static constexpr Integer Size = SCTL_SVE_BITS/32;
+    VecData() = default;
+    inline VecData(sve_float32_t v_) : v(v_) {}
+    sve_float32_t v;
+  };
+  template <> struct alignas(SCTL_SVE_BITS/8) VecData<double,SCTL_SVE_BITS/64> {
+    using ScalarType = double;
+    static constexpr Integer Size = SCTL_SVE_BITS/64;
+    VecData() = default;
+    inline VecData(sve_float64_t v_) : v(v_) {}
+    sve_float64_t v;
+  };
+
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> zero_intrin<VecData<int32_t,SCTL_SVE_BITS/32>>() { return svdup_n_s32(0); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> zero_intrin<VecData<int64_t,SCTL_SVE_BITS/64>>() { return svdup_n_s64(0); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> zero_intrin<VecData<float,SCTL_SVE_BITS/32>>() { return svdup_n_f32(0); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> zero_intrin<VecData<double,SCTL_SVE_BITS/64>>() { return svdup_n_f64(0); }
+
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> set1_intrin<VecData<int32_t,SCTL_SVE_BITS/32>>(int32_t a) { return svdup_n_s32(a); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> set1_intrin<VecData<int64_t,SCTL_SVE_BITS/64>>(int64_t a) { return svdup_n_s64(a); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> set1_intrin<VecData<float,SCTL_SVE_BITS/32>>(float a) { return svdup_n_f32(a); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> set1_intrin<VecData<double,SCTL_SVE_BITS/64>>(double a) { return svdup_n_f64(a); }
+
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> load1_intrin<VecData<int32_t,SCTL_SVE_BITS/32>>(int32_t const* p) { return svdup_n_s32(p[0]); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> load1_intrin<VecData<int64_t,SCTL_SVE_BITS/64>>(int64_t const* p) { return svdup_n_s64(p[0]); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> load1_intrin<VecData<float,SCTL_SVE_BITS/32>>(float const* p) { return svdup_n_f32(p[0]); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> load1_intrin<VecData<double,SCTL_SVE_BITS/64>>(double const* p) { return svdup_n_f64(p[0]); }
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> loadu_intrin<VecData<int32_t,SCTL_SVE_BITS/32>>(int32_t const* p) { return svld1_s32(svptrue_b32(), p); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> loadu_intrin<VecData<int64_t,SCTL_SVE_BITS/64>>(int64_t const* p) { return svld1_s64(svptrue_b64(), p); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> loadu_intrin<VecData<float,SCTL_SVE_BITS/32>>(float const* p) { return svld1_f32(svptrue_b32(), p); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> loadu_intrin<VecData<double,SCTL_SVE_BITS/64>>(double const* p) { return svld1_f64(svptrue_b64(), p); }
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> load_intrin<VecData<int32_t,SCTL_SVE_BITS/32>>(int32_t const* p) { return svld1_s32(svptrue_b32(), p); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> load_intrin<VecData<int64_t,SCTL_SVE_BITS/64>>(int64_t const* p) { return svld1_s64(svptrue_b64(), p); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> load_intrin<VecData<float,SCTL_SVE_BITS/32>>(float const* p) { return svld1_f32(svptrue_b32(), p); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> load_intrin<VecData<double,SCTL_SVE_BITS/64>>(double const* p) { return svld1_f64(svptrue_b64(), p); }
+
+  template <> inline void storeu_intrin<VecData<int32_t,SCTL_SVE_BITS/32>>(int32_t* p, VecData<int32_t,SCTL_SVE_BITS/32> vec) { svst1_s32(svptrue_b32(), p, vec.v); }
+  template <> inline void storeu_intrin<VecData<int64_t,SCTL_SVE_BITS/64>>(int64_t* p, VecData<int64_t,SCTL_SVE_BITS/64> vec) { svst1_s64(svptrue_b64(), p, vec.v); }
+  template <> inline void storeu_intrin<VecData<float,SCTL_SVE_BITS/32>>(float* p, VecData<float,SCTL_SVE_BITS/32> vec) { svst1_f32(svptrue_b32(), p, vec.v); }
+  template <> inline void storeu_intrin<VecData<double,SCTL_SVE_BITS/64>>(double* p, VecData<double,SCTL_SVE_BITS/64> vec) { svst1_f64(svptrue_b64(), p, vec.v); }
+  template <> inline void store_intrin<VecData<int32_t,SCTL_SVE_BITS/32>>(int32_t* p, VecData<int32_t,SCTL_SVE_BITS/32> vec) { svst1_s32(svptrue_b32(), p, vec.v); }
+  template <> inline void store_intrin<VecData<int64_t,SCTL_SVE_BITS/64>>(int64_t* p, VecData<int64_t,SCTL_SVE_BITS/64> vec) { svst1_s64(svptrue_b64(), p, vec.v); }
+  template <> inline void store_intrin<VecData<float,SCTL_SVE_BITS/32>>(float* p, VecData<float,SCTL_SVE_BITS/32> vec) { svst1_f32(svptrue_b32(), p, vec.v); }
+  template <> inline void store_intrin<VecData<double,SCTL_SVE_BITS/64>>(double* p, VecData<double,SCTL_SVE_BITS/64> vec) { svst1_f64(svptrue_b64(), p, vec.v); }
+
+  // Arithmetic operators
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> unary_minus_intrin<VecData<int32_t,SCTL_SVE_BITS/32>>(const VecData<int32_t,SCTL_SVE_BITS/32>& a) { return svneg_s32_x(svptrue_b32(), a.v); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> unary_minus_intrin<VecData<int64_t,SCTL_SVE_BITS/64>>(const VecData<int64_t,SCTL_SVE_BITS/64>& a) { return svneg_s64_x(svptrue_b64(), a.v); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> unary_minus_intrin<VecData<float,SCTL_SVE_BITS/32>>(const VecData<float,SCTL_SVE_BITS/32>& a) { return svneg_f32_x(svptrue_b32(), a.v); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> unary_minus_intrin<VecData<double,SCTL_SVE_BITS/64>>(const VecData<double,SCTL_SVE_BITS/64>& a) { return svneg_f64_x(svptrue_b64(), a.v); }
+
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> mul_intrin(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const VecData<int32_t,SCTL_SVE_BITS/32>& b) { return svmul_s32_x(svptrue_b32(), a.v, b.v); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> mul_intrin(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const VecData<int64_t,SCTL_SVE_BITS/64>& b) { return svmul_s64_x(svptrue_b64(), a.v, b.v); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> mul_intrin(const VecData<float,SCTL_SVE_BITS/32>& a, const VecData<float,SCTL_SVE_BITS/32>& b) { return svmul_f32_x(svptrue_b32(), a.v, b.v); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> mul_intrin(const VecData<double,SCTL_SVE_BITS/64>& a, const VecData<double,SCTL_SVE_BITS/64>& b) { return svmul_f64_x(svptrue_b64(), a.v, b.v); }
+
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> div_intrin(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const VecData<int32_t,SCTL_SVE_BITS/32>& b) { return svdiv_s32_x(svptrue_b32(), a.v, b.v); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> div_intrin(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const VecData<int64_t,SCTL_SVE_BITS/64>& b) { return svdiv_s64_x(svptrue_b64(), a.v, b.v); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> div_intrin(const VecData<float,SCTL_SVE_BITS/32>& a, const VecData<float,SCTL_SVE_BITS/32>& b) { return svdiv_f32_x(svptrue_b32(), a.v, b.v); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> div_intrin(const VecData<double,SCTL_SVE_BITS/64>& a, const VecData<double,SCTL_SVE_BITS/64>& b) { return svdiv_f64_x(svptrue_b64(), a.v, b.v); }
+
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> add_intrin(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const VecData<int32_t,SCTL_SVE_BITS/32>& b) { return svadd_s32_x(svptrue_b32(), a.v, b.v); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> add_intrin(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const VecData<int64_t,SCTL_SVE_BITS/64>& b) { return svadd_s64_x(svptrue_b64(), a.v, b.v); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> add_intrin(const VecData<float,SCTL_SVE_BITS/32>& a, const VecData<float,SCTL_SVE_BITS/32>& b) { return svadd_f32_x(svptrue_b32(), a.v, b.v); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> add_intrin(const VecData<double,SCTL_SVE_BITS/64>& a, const VecData<double,SCTL_SVE_BITS/64>& b) { return svadd_f64_x(svptrue_b64(), a.v, b.v); }
+
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> sub_intrin(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const VecData<int32_t,SCTL_SVE_BITS/32>& b) { return svsub_s32_x(svptrue_b32(), a.v, b.v); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> sub_intrin(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const VecData<int64_t,SCTL_SVE_BITS/64>& b) { return svsub_s64_x(svptrue_b64(), a.v, b.v); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> sub_intrin(const VecData<float,SCTL_SVE_BITS/32>& a, const VecData<float,SCTL_SVE_BITS/32>& b) { return svsub_f32_x(svptrue_b32(), a.v, b.v); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> sub_intrin(const VecData<double,SCTL_SVE_BITS/64>& a, const VecData<double,SCTL_SVE_BITS/64>& b) { return svsub_f64_x(svptrue_b64(), a.v, b.v); }
+
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> fma_intrin(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const VecData<int32_t,SCTL_SVE_BITS/32>& b, const VecData<int32_t,SCTL_SVE_BITS/32>& c) { return svmla_s32_x(svptrue_b32(), c.v, a.v, b.v); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> fma_intrin(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const VecData<int64_t,SCTL_SVE_BITS/64>& b, const VecData<int64_t,SCTL_SVE_BITS/64>& c) { return svmla_s64_x(svptrue_b64(), c.v, a.v, b.v); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> fma_intrin(const VecData<float,SCTL_SVE_BITS/32>& a, const VecData<float,SCTL_SVE_BITS/32>& b, const VecData<float,SCTL_SVE_BITS/32>& c) { return svmla_f32_x(svptrue_b32(), c.v, a.v, b.v); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> fma_intrin(const VecData<double,SCTL_SVE_BITS/64>& a, const VecData<double,SCTL_SVE_BITS/64>& b, const VecData<double,SCTL_SVE_BITS/64>& c) { return svmla_f64_x(svptrue_b64(), c.v, a.v, b.v); }
+
+  // Bitwise operators
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> not_intrin<VecData<int32_t,SCTL_SVE_BITS/32>>(const VecData<int32_t,SCTL_SVE_BITS/32>& a) { return svnot_s32_x(svptrue_b32(), a.v); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> not_intrin<VecData<int64_t,SCTL_SVE_BITS/64>>(const VecData<int64_t,SCTL_SVE_BITS/64>& a) { return svnot_s64_x(svptrue_b64(), a.v); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> not_intrin<VecData<float,SCTL_SVE_BITS/32>>(const VecData<float,SCTL_SVE_BITS/32>& a) { return svreinterpret_f32_s32(svnot_s32_x(svptrue_b32(), svreinterpret_s32_f32(a.v))); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> not_intrin<VecData<double,SCTL_SVE_BITS/64>>(const VecData<double,SCTL_SVE_BITS/64>& a) { return svreinterpret_f64_s64(svnot_s64_x(svptrue_b64(), svreinterpret_s64_f64(a.v))); }
+
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> and_intrin(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const VecData<int32_t,SCTL_SVE_BITS/32>& b) { return svand_s32_x(svptrue_b32(), a.v, b.v); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> and_intrin(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const VecData<int64_t,SCTL_SVE_BITS/64>& b) { return svand_s64_x(svptrue_b64(), a.v, b.v); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> and_intrin(const VecData<float,SCTL_SVE_BITS/32>& a, const VecData<float,SCTL_SVE_BITS/32>& b) { return svreinterpret_f32_s32(svand_s32_x(svptrue_b32(), svreinterpret_s32_f32(a.v), svreinterpret_s32_f32(b.v))); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> and_intrin(const VecData<double,SCTL_SVE_BITS/64>& a, const VecData<double,SCTL_SVE_BITS/64>& b) { return svreinterpret_f64_s64(svand_s64_x(svptrue_b64(), svreinterpret_s64_f64(a.v), svreinterpret_s64_f64(b.v))); }
+
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> xor_intrin(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const VecData<int32_t,SCTL_SVE_BITS/32>& b) { return sveor_s32_x(svptrue_b32(), a.v, b.v); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> xor_intrin(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const VecData<int64_t,SCTL_SVE_BITS/64>& b) { return sveor_s64_x(svptrue_b64(), a.v, b.v); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> xor_intrin(const VecData<float,SCTL_SVE_BITS/32>& a, const VecData<float,SCTL_SVE_BITS/32>& b) { return svreinterpret_f32_s32(sveor_s32_x(svptrue_b32(), svreinterpret_s32_f32(a.v), svreinterpret_s32_f32(b.v))); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> xor_intrin(const VecData<double,SCTL_SVE_BITS/64>& a, const VecData<double,SCTL_SVE_BITS/64>& b) { return svreinterpret_f64_s64(sveor_s64_x(svptrue_b64(), svreinterpret_s64_f64(a.v), svreinterpret_s64_f64(b.v))); }
+
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> or_intrin(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const VecData<int32_t,SCTL_SVE_BITS/32>& b) { return svorr_s32_x(svptrue_b32(), a.v, b.v); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> or_intrin(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const VecData<int64_t,SCTL_SVE_BITS/64>& b) { return svorr_s64_x(svptrue_b64(), a.v, b.v); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> or_intrin(const VecData<float,SCTL_SVE_BITS/32>& a, const VecData<float,SCTL_SVE_BITS/32>& b) { return svreinterpret_f32_s32(svorr_s32_x(svptrue_b32(), svreinterpret_s32_f32(a.v), svreinterpret_s32_f32(b.v))); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> or_intrin(const VecData<double,SCTL_SVE_BITS/64>& a, const VecData<double,SCTL_SVE_BITS/64>& b) { return svreinterpret_f64_s64(svorr_s64_x(svptrue_b64(), svreinterpret_s64_f64(a.v), svreinterpret_s64_f64(b.v))); }
+
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> andnot_intrin(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const VecData<int32_t,SCTL_SVE_BITS/32>& b) { return svbic_s32_x(svptrue_b32(), a.v, b.v); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> andnot_intrin(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const VecData<int64_t,SCTL_SVE_BITS/64>& b) { return svbic_s64_x(svptrue_b64(), a.v, b.v); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> andnot_intrin(const VecData<float,SCTL_SVE_BITS/32>& a, const VecData<float,SCTL_SVE_BITS/32>& b) { return svreinterpret_f32_s32(svbic_s32_x(svptrue_b32(), svreinterpret_s32_f32(a.v), svreinterpret_s32_f32(b.v))); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> andnot_intrin(const VecData<double,SCTL_SVE_BITS/64>& a, const VecData<double,SCTL_SVE_BITS/64>& b) { return svreinterpret_f64_s64(svbic_s64_x(svptrue_b64(), svreinterpret_s64_f64(a.v), svreinterpret_s64_f64(b.v))); }
+
+  // Bitshift
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> bitshiftleft_intrin<VecData<int32_t,SCTL_SVE_BITS/32>>(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const Integer& rhs) { return svlsl_n_s32_x(svptrue_b32(), a.v, (uint32_t)rhs); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> bitshiftleft_intrin<VecData<int64_t,SCTL_SVE_BITS/64>>(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const Integer& rhs) { return svlsl_n_s64_x(svptrue_b64(), a.v, (uint64_t)rhs); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> bitshiftleft_intrin<VecData<float,SCTL_SVE_BITS/32>>(const VecData<float,SCTL_SVE_BITS/32>& a, const Integer& rhs) { return svreinterpret_f32_s32(svlsl_n_s32_x(svptrue_b32(), svreinterpret_s32_f32(a.v), (uint32_t)rhs)); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> bitshiftleft_intrin<VecData<double,SCTL_SVE_BITS/64>>(const VecData<double,SCTL_SVE_BITS/64>& a, const Integer& rhs) { return svreinterpret_f64_s64(svlsl_n_s64_x(svptrue_b64(), svreinterpret_s64_f64(a.v), (uint64_t)rhs)); }
+
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> bitshiftright_intrin<VecData<int32_t,SCTL_SVE_BITS/32>>(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const Integer& rhs) { return svreinterpret_s32_u32(svlsr_n_u32_x(svptrue_b32(), svreinterpret_u32_s32(a.v), (uint32_t)rhs)); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> bitshiftright_intrin<VecData<int64_t,SCTL_SVE_BITS/64>>(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const Integer& rhs) { return svreinterpret_s64_u64(svlsr_n_u64_x(svptrue_b64(), svreinterpret_u64_s64(a.v), (uint64_t)rhs)); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> bitshiftright_intrin<VecData<float,SCTL_SVE_BITS/32>>(const VecData<float,SCTL_SVE_BITS/32>& a, const Integer& rhs) { return svreinterpret_f32_u32(svlsr_n_u32_x(svptrue_b32(), svreinterpret_u32_f32(a.v), (uint32_t)rhs)); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> bitshiftright_intrin<VecData<double,SCTL_SVE_BITS/64>>(const VecData<double,SCTL_SVE_BITS/64>& a, const Integer& rhs) { return svreinterpret_f64_u64(svlsr_n_u64_x(svptrue_b64(), svreinterpret_u64_f64(a.v), (uint64_t)rhs)); }
+
+  // Other functions
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> max_intrin(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const VecData<int32_t,SCTL_SVE_BITS/32>& b) { return svmax_s32_x(svptrue_b32(), a.v, b.v); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> max_intrin(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const VecData<int64_t,SCTL_SVE_BITS/64>& b) { return svmax_s64_x(svptrue_b64(), a.v, b.v); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> max_intrin(const VecData<float,SCTL_SVE_BITS/32>& a, const VecData<float,SCTL_SVE_BITS/32>& b) { return svmax_f32_x(svptrue_b32(), a.v, b.v); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> max_intrin(const VecData<double,SCTL_SVE_BITS/64>& a, const VecData<double,SCTL_SVE_BITS/64>& b) { return svmax_f64_x(svptrue_b64(), a.v, b.v); }
+
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> min_intrin(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const VecData<int32_t,SCTL_SVE_BITS/32>& b) { return svmin_s32_x(svptrue_b32(), a.v, b.v); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> min_intrin(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const VecData<int64_t,SCTL_SVE_BITS/64>& b) { return svmin_s64_x(svptrue_b64(), a.v, b.v); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> min_intrin(const VecData<float,SCTL_SVE_BITS/32>& a, const VecData<float,SCTL_SVE_BITS/32>& b) { return svmin_f32_x(svptrue_b32(), a.v, b.v); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> min_intrin(const VecData<double,SCTL_SVE_BITS/64>& a, const VecData<double,SCTL_SVE_BITS/64>& b) { return svmin_f64_x(svptrue_b64(), a.v, b.v); }
+
+  template <> inline VecData<float,SCTL_SVE_BITS/32> convert_int2real_intrin<VecData<float,SCTL_SVE_BITS/32>,VecData<int32_t,SCTL_SVE_BITS/32>>(const VecData<int32_t,SCTL_SVE_BITS/32>& x) { return svcvt_f32_s32_x(svptrue_b32(), x.v); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> convert_int2real_intrin<VecData<double,SCTL_SVE_BITS/64>,VecData<int64_t,SCTL_SVE_BITS/64>>(const VecData<int64_t,SCTL_SVE_BITS/64>& x) { return svcvt_f64_s64_x(svptrue_b64(), x.v); }
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> round_real2int_intrin<VecData<int32_t,SCTL_SVE_BITS/32>,VecData<float,SCTL_SVE_BITS/32>>(const VecData<float,SCTL_SVE_BITS/32>& x) { return svcvt_s32_f32_x(svptrue_b32(), svrintn_f32_x(svptrue_b32(), x.v)); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> round_real2int_intrin<VecData<int64_t,SCTL_SVE_BITS/64>,VecData<double,SCTL_SVE_BITS/64>>(const VecData<double,SCTL_SVE_BITS/64>& x) { return svcvt_s64_f64_x(svptrue_b64(), svrintn_f64_x(svptrue_b64(), x.v)); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> round_real2real_intrin<VecData<float,SCTL_SVE_BITS/32>>(const VecData<float,SCTL_SVE_BITS/32>& x) { return svrintn_f32_x(svptrue_b32(), x.v); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> round_real2real_intrin<VecData<double,SCTL_SVE_BITS/64>>(const VecData<double,SCTL_SVE_BITS/64>& x) { return svrintn_f64_x(svptrue_b64(), x.v); }
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  /////////////////////////////////////////////////////////////////////////////
+
+
+  // Mask operators
+  template <> struct Mask<VecData<int32_t,SCTL_SVE_BITS/32>> {
+    using ScalarType = int32_t;
+    static constexpr Integer Size = SCTL_SVE_BITS/32;
+
+    static inline Mask Zero() {
+      return Mask(svpfalse_b());
+    }
+
+    Mask() = default;
+    Mask(const Mask&) = default;
+    Mask& operator=(const Mask&) = default;
+    ~Mask() = default;
+
+    inline explicit Mask(const sve_bool_t& v_) : v(v_) {}
+
+    sve_bool_t v;
+  };
+  template <> struct Mask<VecData<int64_t,SCTL_SVE_BITS/64>> {
+    using ScalarType = int64_t;
+    static constexpr Integer Size = SCTL_SVE_BITS/64;
+
+    static inline Mask Zero() {
+      return Mask(svpfalse_b());
+    }
+
+    Mask() = default;
+    Mask(const Mask&) = default;
+    Mask& operator=(const Mask&) = default;
+    ~Mask() = default;
+
+    inline explicit Mask(const sve_bool_t& v_) : v(v_) {}
+
+    sve_bool_t v;
+  };
+  template <> struct Mask<VecData<float,SCTL_SVE_BITS/32>> {
+    using ScalarType = float;
+    static constexpr Integer Size = SCTL_SVE_BITS/32;
+
+    static inline Mask Zero() {
+      return Mask(svpfalse_b());
+    }
+
+    Mask() = default;
+    Mask(const Mask&) = default;
+    Mask& operator=(const Mask&) = default;
+    ~Mask() = default;
+
+    inline explicit Mask(const sve_bool_t& v_) : v(v_) {}
+
+    sve_bool_t v;
+  };
+  template <> struct Mask<VecData<double,SCTL_SVE_BITS/64>> {
+    using ScalarType = double;
+    static constexpr Integer Size = SCTL_SVE_BITS/64;
+
+    static inline Mask Zero() {
+      return Mask(svpfalse_b());
+    }
+
+    Mask() = default;
+    Mask(const Mask&) = default;
+    Mask& operator=(const Mask&) = default;
+    ~Mask() = default;
+
+    inline explicit Mask(const sve_bool_t& v_) : v(v_) {}
+
+    sve_bool_t v;
+  };
+
+  // Bitwise operators (applied to all predicate bits, so that the unused bits are preserved)
+  template <> inline Mask<VecData<int32_t,SCTL_SVE_BITS/32>> operator~<VecData<int32_t,SCTL_SVE_BITS/32>>(const Mask<VecData<int32_t,SCTL_SVE_BITS/32>>& vec) { return Mask<VecData<int32_t,SCTL_SVE_BITS/32>>(svnot_b_z(svptrue_b8(), vec.v)); }
+  template <> inline Mask<VecData<int64_t,SCTL_SVE_BITS/64>> operator~<VecData<int64_t,SCTL_SVE_BITS/64>>(const Mask<VecData<int64_t,SCTL_SVE_BITS/64>>& vec) { return Mask<VecData<int64_t,SCTL_SVE_BITS/64>>(svnot_b_z(svptrue_b8(), vec.v)); }
+  template <> inline Mask<VecData<float,SCTL_SVE_BITS/32>> operator~<VecData<float,SCTL_SVE_BITS/32>>(const Mask<VecData<float,SCTL_SVE_BITS/32>>& vec) { return Mask<VecData<float,SCTL_SVE_BITS/32>>(svnot_b_z(svptrue_b8(), vec.v)); }
+  template <> inline Mask<VecData<double,SCTL_SVE_BITS/64>> operator~<VecData<double,SCTL_SVE_BITS/64>>(const Mask<VecData<double,SCTL_SVE_BITS/64>>& vec) { return Mask<VecData<double,SCTL_SVE_BITS/64>>(svnot_b_z(svptrue_b8(), vec.v)); }
+
+  template <> inline Mask<VecData<int32_t,SCTL_SVE_BITS/32>> operator&<VecData<int32_t,SCTL_SVE_BITS/32>>(const Mask<VecData<int32_t,SCTL_SVE_BITS/32>>& a, const Mask<VecData<int32_t,SCTL_SVE_BITS/32>>& b) { return Mask<VecData<int32_t,SCTL_SVE_BITS/32>>(svand_b_z(svptrue_b8(), a.v, b.v)); }
+  template <> inline Mask<VecData<int64_t,SCTL_SVE_BITS/64>> operator&<VecData<int64_t,SCTL_SVE_BITS/64>>(const Mask<VecData<int64_t,SCTL_SVE_BITS/64>>& a, const Mask<VecData<int64_t,SCTL_SVE_BITS/64>>& b) { return Mask<VecData<int64_t,SCTL_SVE_BITS/64>>(svand_b_z(svptrue_b8(), a.v, b.v)); }
+  template <> inline Mask<VecData<float,SCTL_SVE_BITS/32>> operator&<VecData<float,SCTL_SVE_BITS/32>>(const Mask<VecData<float,SCTL_SVE_BITS/32>>& a, const Mask<VecData<float,SCTL_SVE_BITS/32>>& b) { return Mask<VecData<float,SCTL_SVE_BITS/32>>(svand_b_z(svptrue_b8(), a.v, b.v)); }
+  template <> inline Mask<VecData<double,SCTL_SVE_BITS/64>> operator&<VecData<double,SCTL_SVE_BITS/64>>(const Mask<VecData<double,SCTL_SVE_BITS/64>>& a, const Mask<VecData<double,SCTL_SVE_BITS/64>>& b) { return Mask<VecData<double,SCTL_SVE_BITS/64>>(svand_b_z(svptrue_b8(), a.v, b.v)); }
+
+  template <> inline Mask<VecData<int32_t,SCTL_SVE_BITS/32>> operator^<VecData<int32_t,SCTL_SVE_BITS/32>>(const Mask<VecData<int32_t,SCTL_SVE_BITS/32>>& a, const Mask<VecData<int32_t,SCTL_SVE_BITS/32>>& b) { return Mask<VecData<int32_t,SCTL_SVE_BITS/32>>(sveor_b_z(svptrue_b8(), a.v, b.v)); }
+  template <> inline Mask<VecData<int64_t,SCTL_SVE_BITS/64>> operator^<VecData<int64_t,SCTL_SVE_BITS/64>>(const Mask<VecData<int64_t,SCTL_SVE_BITS/64>>& a, const Mask<VecData<int64_t,SCTL_SVE_BITS/64>>& b) { return Mask<VecData<int64_t,SCTL_SVE_BITS/64>>(sveor_b_z(svptrue_b8(), a.v, b.v)); }
+  template <> inline Mask<VecData<float,SCTL_SVE_BITS/32>> operator^<VecData<float,SCTL_SVE_BITS/32>>(const Mask<VecData<float,SCTL_SVE_BITS/32>>& a, const Mask<VecData<float,SCTL_SVE_BITS/32>>& b) { return Mask<VecData<float,SCTL_SVE_BITS/32>>(sveor_b_z(svptrue_b8(), a.v, b.v)); }
+  template <> inline Mask<VecData<double,SCTL_SVE_BITS/64>> operator^<VecData<double,SCTL_SVE_BITS/64>>(const Mask<VecData<double,SCTL_SVE_BITS/64>>& a, const Mask<VecData<double,SCTL_SVE_BITS/64>>& b) { return Mask<VecData<double,SCTL_SVE_BITS/64>>(sveor_b_z(svptrue_b8(), a.v, b.v)); }
+
+  template <> inline Mask<VecData<int32_t,SCTL_SVE_BITS/32>> operator|<VecData<int32_t,SCTL_SVE_BITS/32>>(const Mask<VecData<int32_t,SCTL_SVE_BITS/32>>& a, const Mask<VecData<int32_t,SCTL_SVE_BITS/32>>& b) { return Mask<VecData<int32_t,SCTL_SVE_BITS/32>>(svorr_b_z(svptrue_b8(), a.v, b.v)); }
+  template <> inline Mask<VecData<int64_t,SCTL_SVE_BITS/64>> operator|<VecData<int64_t,SCTL_SVE_BITS/64>>(const Mask<VecData<int64_t,SCTL_SVE_BITS/64>>& a, const Mask<VecData<int64_t,SCTL_SVE_BITS/64>>& b) { return Mask<VecData<int64_t,SCTL_SVE_BITS/64>>(svorr_b_z(svptrue_b8(), a.v, b.v)); }
+  template <> inline Mask<VecData<float,SCTL_SVE_BITS/32>> operator|<VecData<float,SCTL_SVE_BITS/32>>(const Mask<VecData<float,SCTL_SVE_BITS/32>>& a, const Mask<VecData<float,SCTL_SVE_BITS/32>>& b) { return Mask<VecData<float,SCTL_SVE_BITS/32>>(svorr_b_z(svptrue_b8(), a.v, b.v)); }
+  template <> inline Mask<VecData<double,SCTL_SVE_BITS/64>> operator|<VecData<double,SCTL_SVE_BITS/64>>(const Mask<VecData<double,SCTL_SVE_BITS/64>>& a, const Mask<VecData<double,SCTL_SVE_BITS/64>>& b) { return Mask<VecData<double,SCTL_SVE_BITS/64>>(svorr_b_z(svptrue_b8(), a.v, b.v)); }
+
+  template <> inline Mask<VecData<int32_t,SCTL_SVE_BITS/32>> AndNot<VecData<int32_t,SCTL_SVE_BITS/32>>(const Mask<VecData<int32_t,SCTL_SVE_BITS/32>>& a, const Mask<VecData<int32_t,SCTL_SVE_BITS/32>>& b) { return Mask<VecData<int32_t,SCTL_SVE_BITS/32>>(svbic_b_z(svptrue_b8(), a.v, b.v)); }
+  template <> inline Mask<VecData<int64_t,SCTL_SVE_BITS/64>> AndNot<VecData<int64_t,SCTL_SVE_BITS/64>>(const Mask<VecData<int64_t,SCTL_SVE_BITS/64>>& a, const Mask<VecData<int64_t,SCTL_SVE_BITS/64>>& b) { return Mask<VecData<int64_t,SCTL_SVE_BITS/64>>(svbic_b_z(svptrue_b8(), a.v, b.v)); }
+  template <> inline Mask<VecData<float,SCTL_SVE_BITS/32>> AndNot<VecData<float,SCTL_SVE_BITS/32>>(const Mask<VecData<float,SCTL_SVE_BITS/32>>& a, const Mask<VecData<float,SCTL_SVE_BITS/32>>& b) { return Mask<VecData<float,SCTL_SVE_BITS/32>>(svbic_b_z(svptrue_b8(), a.v, b.v)); }
+  template <> inline Mask<VecData<double,SCTL_SVE_BITS/64>> AndNot<VecData<double,SCTL_SVE_BITS/64>>(const Mask<VecData<double,SCTL_SVE_BITS/64>>& a, const Mask<VecData<double,SCTL_SVE_BITS/64>>& b) { return Mask<VecData<double,SCTL_SVE_BITS/64>>(svbic_b_z(svptrue_b8(), a.v, b.v)); }
+
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> convert_mask2vec_intrin<VecData<int32_t,SCTL_SVE_BITS/32>>(const Mask<VecData<int32_t,SCTL_SVE_BITS/32>>& a) { return svdup_n_s32_z(a.v, -1); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> convert_mask2vec_intrin<VecData<int64_t,SCTL_SVE_BITS/64>>(const Mask<VecData<int64_t,SCTL_SVE_BITS/64>>& a) { return svdup_n_s64_z(a.v, -1); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> convert_mask2vec_intrin<VecData<float,SCTL_SVE_BITS/32>>(const Mask<VecData<float,SCTL_SVE_BITS/32>>& a) { return svreinterpret_f32_s32(svdup_n_s32_z(a.v, -1)); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> convert_mask2vec_intrin<VecData<double,SCTL_SVE_BITS/64>>(const Mask<VecData<double,SCTL_SVE_BITS/64>>& a) { return svreinterpret_f64_s64(svdup_n_s64_z(a.v, -1)); }
+
+  template <> inline Mask<VecData<int32_t,SCTL_SVE_BITS/32>> convert_vec2mask_intrin<VecData<int32_t,SCTL_SVE_BITS/32>>(const VecData<int32_t,SCTL_SVE_BITS/32>& a) { return Mask<VecData<int32_t,SCTL_SVE_BITS/32>>(svcmpne_n_s32(svptrue_b32(), a.v, 0)); }
+  template <> inline Mask<VecData<int64_t,SCTL_SVE_BITS/64>> convert_vec2mask_intrin<VecData<int64_t,SCTL_SVE_BITS/64>>(const VecData<int64_t,SCTL_SVE_BITS/64>& a) { return Mask<VecData<int64_t,SCTL_SVE_BITS/64>>(svcmpne_n_s64(svptrue_b64(), a.v, 0)); }
+  template <> inline Mask<VecData<float,SCTL_SVE_BITS/32>> convert_vec2mask_intrin<VecData<float,SCTL_SVE_BITS/32>>(const VecData<float,SCTL_SVE_BITS/32>& a) { return Mask<VecData<float,SCTL_SVE_BITS/32>>(svcmpne_n_s32(svptrue_b32(), svreinterpret_s32_f32(a.v), 0)); }
+  template <> inline Mask<VecData<double,SCTL_SVE_BITS/64>> convert_vec2mask_intrin<VecData<double,SCTL_SVE_BITS/64>>(const VecData<double,SCTL_SVE_BITS/64>& a) { return Mask<VecData<double,SCTL_SVE_BITS/64>>(svcmpne_n_s64(svptrue_b64(), svreinterpret_s64_f64(a.v), 0)); }
+
+  template <> inline unsigned mask_popcnt_intrin<VecData<int32_t,SCTL_SVE_BITS/32>>(const Mask<VecData<int32_t,SCTL_SVE_BITS/32>>& v) { return (unsigned)svcntp_b32(svptrue_b32(), v.v); }
+  template <> inline unsigned mask_popcnt_intrin<VecData<int64_t,SCTL_SVE_BITS/64>>(const Mask<VecData<int64_t,SCTL_SVE_BITS/64>>& v) { return (unsigned)svcntp_b64(svptrue_b64(), v.v); }
+  template <> inline unsigned mask_popcnt_intrin<VecData<float,SCTL_SVE_BITS/32>>(const Mask<VecData<float,SCTL_SVE_BITS/32>>& v) { return (unsigned)svcntp_b32(svptrue_b32(), v.v); }
+  template <> inline unsigned mask_popcnt_intrin<VecData<double,SCTL_SVE_BITS/64>>(const Mask<VecData<double,SCTL_SVE_BITS/64>>& v) { return (unsigned)svcntp_b64(svptrue_b64(), v.v); }
+  template <> inline bool mask_any<VecData<int32_t,SCTL_SVE_BITS/32>>(const Mask<VecData<int32_t,SCTL_SVE_BITS/32>>& v) { return svptest_any(svptrue_b32(), v.v); }
+  template <> inline bool mask_any<VecData<int64_t,SCTL_SVE_BITS/64>>(const Mask<VecData<int64_t,SCTL_SVE_BITS/64>>& v) { return svptest_any(svptrue_b64(), v.v); }
+  template <> inline bool mask_any<VecData<float,SCTL_SVE_BITS/32>>(const Mask<VecData<float,SCTL_SVE_BITS/32>>& v) { return svptest_any(svptrue_b32(), v.v); }
+  template <> inline bool mask_any<VecData<double,SCTL_SVE_BITS/64>>(const Mask<VecData<double,SCTL_SVE_BITS/64>>& v) { return svptest_any(svptrue_b64(), v.v); }
+  template <> inline void mask_compress_store<VecData<int32_t,SCTL_SVE_BITS/32>>(const Mask<VecData<int32_t,SCTL_SVE_BITS/32>>& mask, const VecData<int32_t,SCTL_SVE_BITS/32>& v, int32_t* ptr) { svst1_s32(svwhilelt_b32_u64(0, svcntp_b32(svptrue_b32(), mask.v)), ptr, svcompact_s32(mask.v, v.v)); }
+  template <> inline void mask_compress_store<VecData<int64_t,SCTL_SVE_BITS/64>>(const Mask<VecData<int64_t,SCTL_SVE_BITS/64>>& mask, const VecData<int64_t,SCTL_SVE_BITS/64>& v, int64_t* ptr) { svst1_s64(svwhilelt_b64_u64(0, svcntp_b64(svptrue_b64(), mask.v)), ptr, svcompact_s64(mask.v, v.v)); }
+  template <> inline void mask_compress_store<VecData<float,SCTL_SVE_BITS/32>>(const Mask<VecData<float,SCTL_SVE_BITS/32>>& mask, const VecData<float,SCTL_SVE_BITS/32>& v, float* ptr) { svst1_f32(svwhilelt_b32_u64(0, svcntp_b32(svptrue_b32(), mask.v)), ptr, svcompact_f32(mask.v, v.v)); }
+  template <> inline void mask_compress_store<VecData<double,SCTL_SVE_BITS/64>>(const Mask<VecData<double,SCTL_SVE_BITS/64>>& mask, const VecData<double,SCTL_SVE_BITS/64>& v, double* ptr) { svst1_f64(svwhilelt_b64_u64(0, svcntp_b64(svptrue_b64(), mask.v)), ptr, svcompact_f64(mask.v, v.v)); }
+
+  // Comparison operators
+  template <> inline Mask<VecData<int32_t,SCTL_SVE_BITS/32>> comp_intrin<ComparisonType::lt>(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const VecData<int32_t,SCTL_SVE_BITS/32>& b) { return Mask<VecData<int32_t,SCTL_SVE_BITS/32>>(svcmplt_s32(svptrue_b32(), a.v, b.v)); }
+  template <> inline Mask<VecData<int32_t,SCTL_SVE_BITS/32>> comp_intrin<ComparisonType::le>(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const VecData<int32_t,SCTL_SVE_BITS/32>& b) { return Mask<VecData<int32_t,SCTL_SVE_BITS/32>>(svcmple_s32(svptrue_b32(), a.v, b.v)); }
+  template <> inline Mask<VecData<int32_t,SCTL_SVE_BITS/32>> comp_intrin<ComparisonType::gt>(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const VecData<int32_t,SCTL_SVE_BITS/32>& b) { return Mask<VecData<int32_t,SCTL_SVE_BITS/32>>(svcmpgt_s32(svptrue_b32(), a.v, b.v)); }
+  template <> inline Mask<VecData<int32_t,SCTL_SVE_BITS/32>> comp_intrin<ComparisonType::ge>(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const VecData<int32_t,SCTL_SVE_BITS/32>& b) { return Mask<VecData<int32_t,SCTL_SVE_BITS/32>>(svcmpge_s32(svptrue_b32(), a.v, b.v)); }
+  template <> inline Mask<VecData<int32_t,SCTL_SVE_BITS/32>> comp_intrin<ComparisonType::eq>(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const VecData<int32_t,SCTL_SVE_BITS/32>& b) { return Mask<VecData<int32_t,SCTL_SVE_BITS/32>>(svcmpeq_s32(svptrue_b32(), a.v, b.v)); }
+  template <> inline Mask<VecData<int32_t,SCTL_SVE_BITS/32>> comp_intrin<ComparisonType::ne>(const VecData<int32_t,SCTL_SVE_BITS/32>& a, const VecData<int32_t,SCTL_SVE_BITS/32>& b) { return Mask<VecData<int32_t,SCTL_SVE_BITS/32>>(svcmpne_s32(svptrue_b32(), a.v, b.v)); }
+
+  template <> inline Mask<VecData<int64_t,SCTL_SVE_BITS/64>> comp_intrin<ComparisonType::lt>(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const VecData<int64_t,SCTL_SVE_BITS/64>& b) { return Mask<VecData<int64_t,SCTL_SVE_BITS/64>>(svcmplt_s64(svptrue_b64(), a.v, b.v)); }
+  template <> inline Mask<VecData<int64_t,SCTL_SVE_BITS/64>> comp_intrin<ComparisonType::le>(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const VecData<int64_t,SCTL_SVE_BITS/64>& b) { return Mask<VecData<int64_t,SCTL_SVE_BITS/64>>(svcmple_s64(svptrue_b64(), a.v, b.v)); }
+  template <> inline Mask<VecData<int64_t,SCTL_SVE_BITS/64>> comp_intrin<ComparisonType::gt>(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const VecData<int64_t,SCTL_SVE_BITS/64>& b) { return Mask<VecData<int64_t,SCTL_SVE_BITS/64>>(svcmpgt_s64(svptrue_b64(), a.v, b.v)); }
+  template <> inline Mask<VecData<int64_t,SCTL_SVE_BITS/64>> comp_intrin<ComparisonType::ge>(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const VecData<int64_t,SCTL_SVE_BITS/64>& b) { return Mask<VecData<int64_t,SCTL_SVE_BITS/64>>(svcmpge_s64(svptrue_b64(), a.v, b.v)); }
+  template <> inline Mask<VecData<int64_t,SCTL_SVE_BITS/64>> comp_intrin<ComparisonType::eq>(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const VecData<int64_t,SCTL_SVE_BITS/64>& b) { return Mask<VecData<int64_t,SCTL_SVE_BITS/64>>(svcmpeq_s64(svptrue_b64(), a.v, b.v)); }
+  template <> inline Mask<VecData<int64_t,SCTL_SVE_BITS/64>> comp_intrin<ComparisonType::ne>(const VecData<int64_t,SCTL_SVE_BITS/64>& a, const VecData<int64_t,SCTL_SVE_BITS/64>& b) { return Mask<VecData<int64_t,SCTL_SVE_BITS/64>>(svcmpne_s64(svptrue_b64(), a.v, b.v)); }
+
+  template <> inline Mask<VecData<float,SCTL_SVE_BITS/32>> comp_intrin<ComparisonType::lt>(const VecData<float,SCTL_SVE_BITS/32>& a, const VecData<float,SCTL_SVE_BITS/32>& b) { return Mask<VecData<float,SCTL_SVE_BITS/32>>(svcmplt_f32(svptrue_b32(), a.v, b.v)); }
+  template <> inline Mask<VecData<float,SCTL_SVE_BITS/32>> comp_intrin<ComparisonType::le>(const VecData<float,SCTL_SVE_BITS/32>& a, const VecData<float,SCTL_SVE_BITS/32>& b) { return Mask<VecData<float,SCTL_SVE_BITS/32>>(svcmple_f32(svptrue_b32(), a.v, b.v)); }
+  template <> inline Mask<VecData<float,SCTL_SVE_BITS/32>> comp_intrin<ComparisonType::gt>(const VecData<float,SCTL_SVE_BITS/32>& a, const VecData<float,SCTL_SVE_BITS/32>& b) { return Mask<VecData<float,SCTL_SVE_BITS/32>>(svcmpgt_f32(svptrue_b32(), a.v, b.v)); }
+  template <> inline Mask<VecData<float,SCTL_SVE_BITS/32>> comp_intrin<ComparisonType::ge>(const VecData<float,SCTL_SVE_BITS/32>& a, const VecData<float,SCTL_SVE_BITS/32>& b) { return Mask<VecData<float,SCTL_SVE_BITS/32>>(svcmpge_f32(svptrue_b32(), a.v, b.v)); }
+  template <> inline Mask<VecData<float,SCTL_SVE_BITS/32>> comp_intrin<ComparisonType::eq>(const VecData<float,SCTL_SVE_BITS/32>& a, const VecData<float,SCTL_SVE_BITS/32>& b) { return Mask<VecData<float,SCTL_SVE_BITS/32>>(svcmpeq_f32(svptrue_b32(), a.v, b.v)); }
+  template <> inline Mask<VecData<float,SCTL_SVE_BITS/32>> comp_intrin<ComparisonType::ne>(const VecData<float,SCTL_SVE_BITS/32>& a, const VecData<float,SCTL_SVE_BITS/32>& b) { return Mask<VecData<float,SCTL_SVE_BITS/32>>(svcmpne_f32(svptrue_b32(), a.v, b.v)); }
+
+  template <> inline Mask<VecData<double,SCTL_SVE_BITS/64>> comp_intrin<ComparisonType::lt>(const VecData<double,SCTL_SVE_BITS/64>& a, const VecData<double,SCTL_SVE_BITS/64>& b) { return Mask<VecData<double,SCTL_SVE_BITS/64>>(svcmplt_f64(svptrue_b64(), a.v, b.v)); }
+  template <> inline Mask<VecData<double,SCTL_SVE_BITS/64>> comp_intrin<ComparisonType::le>(const VecData<double,SCTL_SVE_BITS/64>& a, const VecData<double,SCTL_SVE_BITS/64>& b) { return Mask<VecData<double,SCTL_SVE_BITS/64>>(svcmple_f64(svptrue_b64(), a.v, b.v)); }
+  template <> inline Mask<VecData<double,SCTL_SVE_BITS/64>> comp_intrin<ComparisonType::gt>(const VecData<double,SCTL_SVE_BITS/64>& a, const VecData<double,SCTL_SVE_BITS/64>& b) { return Mask<VecData<double,SCTL_SVE_BITS/64>>(svcmpgt_f64(svptrue_b64(), a.v, b.v)); }
+  template <> inline Mask<VecData<double,SCTL_SVE_BITS/64>> comp_intrin<ComparisonType::ge>(const VecData<double,SCTL_SVE_BITS/64>& a, const VecData<double,SCTL_SVE_BITS/64>& b) { return Mask<VecData<double,SCTL_SVE_BITS/64>>(svcmpge_f64(svptrue_b64(), a.v, b.v)); }
+  template <> inline Mask<VecData<double,SCTL_SVE_BITS/64>> comp_intrin<ComparisonType::eq>(const VecData<double,SCTL_SVE_BITS/64>& a, const VecData<double,SCTL_SVE_BITS/64>& b) { return Mask<VecData<double,SCTL_SVE_BITS/64>>(svcmpeq_f64(svptrue_b64(), a.v, b.v)); }
+  template <> inline Mask<VecData<double,SCTL_SVE_BITS/64>> comp_intrin<ComparisonType::ne>(const VecData<double,SCTL_SVE_BITS/64>& a, const VecData<double,SCTL_SVE_BITS/64>& b) { return Mask<VecData<double,SCTL_SVE_BITS/64>>(svcmpne_f64(svptrue_b64(), a.v, b.v)); }
+
+  template <> inline VecData<int32_t,SCTL_SVE_BITS/32> select_intrin(const Mask<VecData<int32_t,SCTL_SVE_BITS/32>>& s, const VecData<int32_t,SCTL_SVE_BITS/32>& a, const VecData<int32_t,SCTL_SVE_BITS/32>& b) { return svsel_s32(s.v, a.v, b.v); }
+  template <> inline VecData<int64_t,SCTL_SVE_BITS/64> select_intrin(const Mask<VecData<int64_t,SCTL_SVE_BITS/64>>& s, const VecData<int64_t,SCTL_SVE_BITS/64>& a, const VecData<int64_t,SCTL_SVE_BITS/64>& b) { return svsel_s64(s.v, a.v, b.v); }
+  template <> inline VecData<float,SCTL_SVE_BITS/32> select_intrin(const Mask<VecData<float,SCTL_SVE_BITS/32>>& s, const VecData<float,SCTL_SVE_BITS/32>& a, const VecData<float,SCTL_SVE_BITS/32>& b) { return svsel_f32(s.v, a.v, b.v); }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> select_intrin(const Mask<VecData<double,SCTL_SVE_BITS/64>>& s, const VecData<double,SCTL_SVE_BITS/64>& a, const VecData<double,SCTL_SVE_BITS/64>& b) { return svsel_f64(s.v, a.v, b.v); }
+
+
+  // Special functions
+  template <Integer digits> struct rsqrt_approx_intrin<digits, VecData<float,SCTL_SVE_BITS/32>> {
+    static constexpr Integer newton_iter = mylog2((Integer)(digits/2.4082399653)); // svrsqrte is accurate to 8-bits
+    static inline VecData<float,SCTL_SVE_BITS/32> eval(const VecData<float,SCTL_SVE_BITS/32>& a) {
+      return rsqrt_newton_iter<newton_iter,newton_iter,VecData<float,SCTL_SVE_BITS/32>>::eval(svrsqrte_f32(a.v), a.v);
+    }
+    static inline VecData<float,SCTL_SVE_BITS/32> eval(const VecData<float,SCTL_SVE_BITS/32>& a, const Mask<VecData<float,SCTL_SVE_BITS/32>>& m) {
+      return rsqrt_newton_iter<newton_iter,newton_iter,VecData<float,SCTL_SVE_BITS/32>>::eval(svsel_f32(m.v, svrsqrte_f32(a.v), svdup_n_f32(0)), a.v);
+    }
+  };
+  template <Integer digits> struct rsqrt_approx_intrin<digits, VecData<double,SCTL_SVE_BITS/64>> {
+    static constexpr Integer newton_iter = mylog2((Integer)(digits/2.4082399653)); // svrsqrte is accurate to 8-bits
+    static inline VecData<double,SCTL_SVE_BITS/64> eval(const VecData<double,SCTL_SVE_BITS/64>& a) {
+      return rsqrt_newton_iter<newton_iter,newton_iter,VecData<double,SCTL_SVE_BITS/64>>::eval(svrsqrte_f64(a.v), a.v);
+    }
+    static inline VecData<double,SCTL_SVE_BITS/64> eval(const VecData<double,SCTL_SVE_BITS/64>& a, const Mask<VecData<double,SCTL_SVE_BITS/64>>& m) {
+      return rsqrt_newton_iter<newton_iter,newton_iter,VecData<double,SCTL_SVE_BITS/64>>::eval(svsel_f64(m.v, svrsqrte_f64(a.v), svdup_n_f64(0)), a.v);
+    }
+  };
+
+  template <> inline void sincos_intrin<VecData<float,SCTL_SVE_BITS/32>>(VecData<float,SCTL_SVE_BITS/32>& sinx, VecData<float,SCTL_SVE_BITS/32>& cosx, const VecData<float,SCTL_SVE_BITS/32>& x) {
+    approx_sincos_intrin<(Integer)(TypeTraits<float>::SigBits/3.2)>(sinx, cosx, x); // TODO: determine constants more precisely
+  }
+  template <> inline void sincos_intrin<VecData<double,SCTL_SVE_BITS/64>>(VecData<double,SCTL_SVE_BITS/64>& sinx, VecData<double,SCTL_SVE_BITS/64>& cosx, const VecData<double,SCTL_SVE_BITS/64>& x) {
+    approx_sincos_intrin<(Integer)(TypeTraits<double>::SigBits/3.2)>(sinx, cosx, x); // TODO: determine constants more precisely
+  }
+
+  template <> inline VecData<float,SCTL_SVE_BITS/32> exp_intrin<VecData<float,SCTL_SVE_BITS/32>>(const VecData<float,SCTL_SVE_BITS/32>& x) {
+    return approx_exp_intrin<(Integer)(TypeTraits<float>::SigBits/3.8)>(x); // TODO: determine constants more precisely
+  }
+  template <> inline VecData<double,SCTL_SVE_BITS/64> exp_intrin<VecData<double,SCTL_SVE_BITS/64>>(const VecData<double,SCTL_SVE_BITS/64>& x) {
+    return approx_exp_intrin<(Integer)(TypeTraits<double>::SigBits/3.8)>(x); // TODO: determine constants more precisely
+  }
+
+#endif
+}
+
+namespace sctl { // RVV
+#if defined(SCTL_RVV_BITS)
+  // Fixed-length RVV types (LMUL=1); these require compiling with -mrvv-vector-bits=zvl and a
+  // minimum vector length (e.g. -march=rv64gcv_zvl256b). Masks use the generic (vector) representation.
+  typedef vint32m1_t rvv_int32_t __attribute__((riscv_rvv_vector_bits(SCTL_RVV_BITS)));
+  typedef vint64m1_t rvv_int64_t __attribute__((riscv_rvv_vector_bits(SCTL_RVV_BITS)));
+  typedef vfloat32m1_t rvv_float32_t __attribute__((riscv_rvv_vector_bits(SCTL_RVV_BITS)));
+  typedef vfloat64m1_t rvv_float64_t __attribute__((riscv_rvv_vector_bits(SCTL_RVV_BITS)));
+
+  template <> struct alignas(SCTL_RVV_BITS/8) VecData<int32_t,SCTL_RVV_BITS/32> {
+    using ScalarType = int32_t;
+    static constexpr Integer Size = SCTL_RVV_BITS/32;
+    VecData() = default;
+    inline VecData(rvv_int32_t v_) : v(v_) {}
+    rvv_int32_t v;
+  };
+  template <> struct alignas(SCTL_RVV_BITS/8) VecData<int64_t,SCTL_RVV_BITS/64> {
+    using ScalarType = int64_t;
+    static constexpr Integer Size = SCTL_RVV_BITS/64;
+    VecData() = default;
+    inline VecData(rvv_int64_t v_) : v(v_) {}
+    rvv_int64_t v;
+  };
+  template <> struct alignas(SCTL_RVV_BITS/8) VecData<float,SCTL_RVV_BITS/32> {
+    using ScalarType = float;
+    static constexpr Integer Size = SCTL_RVV_BITS/32;
+    VecData() = default;
+    inline VecData(rvv_float32_t v_) : v(v_) {}
+    rvv_float32_t v;
+  };
+  template <> struct alignas(SCTL_RVV_BITS/8) VecData<double,SCTL_RVV_BITS/64> {
+    using ScalarType = double;
+    static constexpr Integer Size = SCTL_RVV_BITS/64;
+    VecData() = default;
+    inline VecData(rvv_float64_t v_) : v(v_) {}
+    rvv_float64_t v;
+  };
+
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> zero_intrin<VecData<int32_t,SCTL_RVV_BITS/32>>() { return __riscv_vmv_v_x_i32m1(0, SCTL_RVV_BITS/32); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> zero_intrin<VecData<int64_t,SCTL_RVV_BITS/64>>() { return __riscv_vmv_v_x_i64m1(0, SCTL_RVV_BITS/64); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> zero_intrin<VecData<float,SCTL_RVV_BITS/32>>() { return __riscv_vfmv_v_f_f32m1(0, SCTL_RVV_BITS/32); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> zero_intrin<VecData<double,SCTL_RVV_BITS/64>>() { return __riscv_vfmv_v_f_f64m1(0, SCTL_RVV_BITS/64); }
+
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> set1_intrin<VecData<int32_t,SCTL_RVV_BITS/32>>(int32_t a) { return __riscv_vmv_v_x_i32m1(a, SCTL_RVV_BITS/32); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> set1_intrin<VecData<int64_t,SCTL_RVV_BITS/64>>(int64_t a) { return __riscv_vmv_v_x_i64m1(a, SCTL_RVV_BITS/64); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> set1_intrin<VecData<float,SCTL_RVV_BITS/32>>(float a) { return __riscv_vfmv_v_f_f32m1(a, SCTL_RVV_BITS/32); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> set1_intrin<VecData<double,SCTL_RVV_BITS/64>>(double a) { return __riscv_vfmv_v_f_f64m1(a, SCTL_RVV_BITS/64); }
+
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> load1_intrin<VecData<int32_t,SCTL_RVV_BITS/32>>(int32_t const* p) { return __riscv_vmv_v_x_i32m1(p[0], SCTL_RVV_BITS/32); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> load1_intrin<VecData<int64_t,SCTL_RVV_BITS/64>>(int64_t const* p) { return __riscv_vmv_v_x_i64m1(p[0], SCTL_RVV_BITS/64); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> load1_intrin<VecData<float,SCTL_RVV_BITS/32>>(float const* p) { return __riscv_vfmv_v_f_f32m1(p[0], SCTL_RVV_BITS/32); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> load1_intrin<VecData<double,SCTL_RVV_BITS/64>>(double const* p) { return __riscv_vfmv_v_f_f64m1(p[0], SCTL_RVV_BITS/64); }
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> loadu_intrin<VecData<int32_t,SCTL_RVV_BITS/32>>(int32_t const* p) { return __riscv_vle32_v_i32m1(p, SCTL_RVV_BITS/32); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> loadu_intrin<VecData<int64_t,SCTL_RVV_BITS/64>>(int64_t const* p) { return __riscv_vle64_v_i64m1(p, SCTL_RVV_BITS/64); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> loadu_intrin<VecData<float,SCTL_RVV_BITS/32>>(float const* p) { return __riscv_vle32_v_f32m1(p, SCTL_RVV_BITS/32); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> loadu_intrin<VecData<double,SCTL_RVV_BITS/64>>(double const* p) { return __riscv_vle64_v_f64m1(p, SCTL_RVV_BITS/64); }
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> load_intrin<VecData<int32_t,SCTL_RVV_BITS/32>>(int32_t const* p) { return __riscv_vle32_v_i32m1(p, SCTL_RVV_BITS/32); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> load_intrin<VecData<int64_t,SCTL_RVV_BITS/64>>(int64_t const* p) { return __riscv_vle64_v_i64m1(p, SCTL_RVV_BITS/64); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> load_intrin<VecData<float,SCTL_RVV_BITS/32>>(float const* p) { return __riscv_vle32_v_f32m1(p, SCTL_RVV_BITS/32); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> load_intrin<VecData<double,SCTL_RVV_BITS/64>>(double const* p) { return __riscv_vle64_v_f64m1(p, SCTL_RVV_BITS/64); }
+
+  template <> inline void storeu_intrin<VecData<int32_t,SCTL_RVV_BITS/32>>(int32_t* p, VecData<int32_t,SCTL_RVV_BITS/32> vec) { __riscv_vse32_v_i32m1(p, vec.v, SCTL_RVV_BITS/32); }
+  template <> inline void storeu_intrin<VecData<int64_t,SCTL_RVV_BITS/64>>(int64_t* p, VecData<int64_t,SCTL_RVV_BITS/64> vec) { __riscv_vse64_v_i64m1(p, vec.v, SCTL_RVV_BITS/64); }
+  template <> inline void storeu_intrin<VecData<float,SCTL_RVV_BITS/32>>(float* p, VecData<float,SCTL_RVV_BITS/32> vec) { __riscv_vse32_v_f32m1(p, vec.v, SCTL_RVV_BITS/32); }
+  template <> inline void storeu_intrin<VecData<double,SCTL_RVV_BITS/64>>(double* p, VecData<double,SCTL_RVV_BITS/64> vec) { __riscv_vse64_v_f64m1(p, vec.v, SCTL_RVV_BITS/64); }
+  template <> inline void store_intrin<VecData<int32_t,SCTL_RVV_BITS/32>>(int32_t* p, VecData<int32_t,SCTL_RVV_BITS/32> vec) { __riscv_vse32_v_i32m1(p, vec.v, SCTL_RVV_BITS/32); }
+  template <> inline void store_intrin<VecData<int64_t,SCTL_RVV_BITS/64>>(int64_t* p, VecData<int64_t,SCTL_RVV_BITS/64> vec) { __riscv_vse64_v_i64m1(p, vec.v, SCTL_RVV_BITS/64); }
+  template <> inline void store_intrin<VecData<float,SCTL_RVV_BITS/32>>(float* p, VecData<float,SCTL_RVV_BITS/32> vec) { __riscv_vse32_v_f32m1(p, vec.v, SCTL_RVV_BITS/32); }
+  template <> inline void store_intrin<VecData<double,SCTL_RVV_BITS/64>>(double* p, VecData<double,SCTL_RVV_BITS/64> vec) { __riscv_vse64_v_f64m1(p, vec.v, SCTL_RVV_BITS/64); }
+
+  // Arithmetic operators
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> unary_minus_intrin<VecData<int32_t,SCTL_RVV_BITS/32>>(const VecData<int32_t,SCTL_RVV_BITS/32>& a) { return __riscv_vneg_v_i32m1(a.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> unary_minus_intrin<VecData<int64_t,SCTL_RVV_BITS/64>>(const VecData<int64_t,SCTL_RVV_BITS/64>& a) { return __riscv_vneg_v_i64m1(a.v, SCTL_RVV_BITS/64); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> unary_minus_intrin<VecData<float,SCTL_RVV_BITS/32>>(const VecData<float,SCTL_RVV_BITS/32>& a) { return __riscv_vfneg_v_f32m1(a.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> unary_minus_intrin<VecData<double,SCTL_RVV_BITS/64>>(const VecData<double,SCTL_RVV_BITS/64>& a) { return __riscv_vfneg_v_f64m1(a.v, SCTL_RVV_BITS/64); }
+
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> mul_intrin(const VecData<int32_t,SCTL_RVV_BITS/32>& a, const VecData<int32_t,SCTL_RVV_BITS/32>& b) { return __riscv_vmul_vv_i32m1(a.v, b.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> mul_intrin(const VecData<int64_t,SCTL_RVV_BITS/64>& a, const VecData<int64_t,SCTL_RVV_BITS/64>& b) { return __riscv_vmul_vv_i64m1(a.v, b.v, SCTL_RVV_BITS/64); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> mul_intrin(const VecData<float,SCTL_RVV_BITS/32>& a, const VecData<float,SCTL_RVV_BITS/32>& b) { return __riscv_vfmul_vv_f32m1(a.v, b.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> mul_intrin(const VecData<double,SCTL_RVV_BITS/64>& a, const VecData<double,SCTL_RVV_BITS/64>& b) { return __riscv_vfmul_vv_f64m1(a.v, b.v, SCTL_RVV_BITS/64); }
+
+  template <> inline VecData<float,SCTL_RVV_BITS/32> div_intrin(const VecData<float,SCTL_RVV_BITS/32>& a, const VecData<float,SCTL_RVV_BITS/32>& b) { return __riscv_vfdiv_vv_f32m1(a.v, b.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> div_intrin(const VecData<double,SCTL_RVV_BITS/64>& a, const VecData<double,SCTL_RVV_BITS/64>& b) { return __riscv_vfdiv_vv_f64m1(a.v, b.v, SCTL_RVV_BITS/64); }
+
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> add_intrin(const VecData<int32_t,SCTL_RVV_BITS/32>& a, const VecData<int32_t,SCTL_RVV_BITS/32>& b) { return __riscv_vadd_vv_i32m1(a.v, b.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> add_intrin(const VecData<int64_t,SCTL_RVV_BITS/64>& a, const VecData<int64_t,SCTL_RVV_BITS/64>& b) { return __riscv_vadd_vv_i64m1(a.v, b.v, SCTL_RVV_BITS/64); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> add_intrin(const VecData<float,SCTL_RVV_BITS/32>& a, const VecData<float,SCTL_RVV_BITS/32>& b) { return __riscv_vfadd_vv_f32m1(a.v, b.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> add_intrin(const VecData<double,SCTL_RVV_BITS/64>& a, const VecData<double,SCTL_RVV_BITS/64>& b) { return __riscv_vfadd_vv_f64m1(a.v, b.v, SCTL_RVV_BITS/64); }
+
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> sub_intrin(const VecData<int32_t,SCTL_RVV_BITS/32>& a, const VecData<int32_t,SCTL_RVV_BITS/32>& b) { return __riscv_vsub_vv_i32m1(a.v, b.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> sub_intrin(const VecData<int64_t,SCTL_RVV_BITS/64>& a, const VecData<int64_t,SCTL_RVV_BITS/64>& b) { return __riscv_vsub_vv_i64m1(a.v, b.v, SCTL_RVV_BITS/64); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> sub_intrin(const VecData<float,SCTL_RVV_BITS/32>& a, const VecData<float,SCTL_RVV_BITS/32>& b) { return __riscv_vfsub_vv_f32m1(a.v, b.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> sub_intrin(const VecData<double,SCTL_RVV_BITS/64>& a, const VecData<double,SCTL_RVV_BITS/64>& b) { return __riscv_vfsub_vv_f64m1(a.v, b.v, SCTL_RVV_BITS/64); }
+
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> fma_intrin(const VecData<int32_t,SCTL_RVV_BITS/32>& a, const VecData<int32_t,SCTL_RVV_BITS/32>& b, const VecData<int32_t,SCTL_RVV_BITS/32>& c) { return __riscv_vmacc_vv_i32m1(c.v, a.v, b.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> fma_intrin(const VecData<int64_t,SCTL_RVV_BITS/64>& a, const VecData<int64_t,SCTL_RVV_BITS/64>& b, const VecData<int64_t,SCTL_RVV_BITS/64>& c) { return __riscv_vmacc_vv_i64m1(c.v, a.v, b.v, SCTL_RVV_BITS/64); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> fma_intrin(const VecData<float,SCTL_RVV_BITS/32>& a, const VecData<float,SCTL_RVV_BITS/32>& b, const VecData<float,SCTL_RVV_BITS/32>& c) { return __riscv_vfmacc_vv_f32m1(c.v, a.v, b.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> fma_intrin(const VecData<double,SCTL_RVV_BITS/64>& a, const VecData<double,SCTL_RVV_BITS/64>& b, const VecData<double,SCTL_RVV_BITS/64>& c) { return __riscv_vfmacc_vv_f64m1(c.v, a.v, b.v, SCTL_RVV_BITS/64); }
+
+  // Bitwise operators
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> not_intrin<VecData<int32_t,SCTL_RVV_BITS/32>>(const VecData<int32_t,SCTL_RVV_BITS/32>& a) { return __riscv_vnot_v_i32m1(a.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> not_intrin<VecData<int64_t,SCTL_RVV_BITS/64>>(const VecData<int64_t,SCTL_RVV_BITS/64>& a) { return __riscv_vnot_v_i64m1(a.v, SCTL_RVV_BITS/64); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> not_intrin<VecData<float,SCTL_RVV_BITS/32>>(const VecData<float,SCTL_RVV_BITS/32>& a) { return __riscv_vreinterpret_v_i32m1_f32m1(__riscv_vnot_v_i32m1(__riscv_vreinterpret_v_f32m1_i32m1(a.v), SCTL_RVV_BITS/32)); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> not_intrin<VecData<double,SCTL_RVV_BITS/64>>(const VecData<double,SCTL_RVV_BITS/64>& a) { return __riscv_vreinterpret_v_i64m1_f64m1(__riscv_vnot_v_i64m1(__riscv_vreinterpret_v_f64m1_i64m1(a.v), SCTL_RVV_BITS/64)); }
+
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> and_intrin(const VecData<int32_t,SCTL_RVV_BITS/32>& a, const VecData<int32_t,SCTL_RVV_BITS/32>& b) { return __riscv_vand_vv_i32m1(a.v, b.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> and_intrin(const VecData<int64_t,SCTL_RVV_BITS/64>& a, const VecData<int64_t,SCTL_RVV_BITS/64>& b) { return __riscv_vand_vv_i64m1(a.v, b.v, SCTL_RVV_BITS/64); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> and_intrin(const VecData<float,SCTL_RVV_BITS/32>& a, const VecData<float,SCTL_RVV_BITS/32>& b) { return __riscv_vreinterpret_v_i32m1_f32m1(__riscv_vand_vv_i32m1(__riscv_vreinterpret_v_f32m1_i32m1(a.v), __riscv_vreinterpret_v_f32m1_i32m1(b.v), SCTL_RVV_BITS/32)); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> and_intrin(const VecData<double,SCTL_RVV_BITS/64>& a, const VecData<double,SCTL_RVV_BITS/64>& b) { return __riscv_vreinterpret_v_i64m1_f64m1(__riscv_vand_vv_i64m1(__riscv_vreinterpret_v_f64m1_i64m1(a.v), __riscv_vreinterpret_v_f64m1_i64m1(b.v), SCTL_RVV_BITS/64)); }
+
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> xor_intrin(const VecData<int32_t,SCTL_RVV_BITS/32>& a, const VecData<int32_t,SCTL_RVV_BITS/32>& b) { return __riscv_vxor_vv_i32m1(a.v, b.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> xor_intrin(const VecData<int64_t,SCTL_RVV_BITS/64>& a, const VecData<int64_t,SCTL_RVV_BITS/64>& b) { return __riscv_vxor_vv_i64m1(a.v, b.v, SCTL_RVV_BITS/64); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> xor_intrin(const VecData<float,SCTL_RVV_BITS/32>& a, const VecData<float,SCTL_RVV_BITS/32>& b) { return __riscv_vreinterpret_v_i32m1_f32m1(__riscv_vxor_vv_i32m1(__riscv_vreinterpret_v_f32m1_i32m1(a.v), __riscv_vreinterpret_v_f32m1_i32m1(b.v), SCTL_RVV_BITS/32)); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> xor_intrin(const VecData<double,SCTL_RVV_BITS/64>& a, const VecData<double,SCTL_RVV_BITS/64>& b) { return __riscv_vreinterpret_v_i64m1_f64m1(__riscv_vxor_vv_i64m1(__riscv_vreinterpret_v_f64m1_i64m1(a.v), __riscv_vreinterpret_v_f64m1_i64m1(b.v), SCTL_RVV_BITS/64)); }
+
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> or_intrin(const VecData<int32_t,SCTL_RVV_BITS/32>& a, const VecData<int32_t,SCTL_RVV_BITS/32>& b) { return __riscv_vor_vv_i32m1(a.v, b.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> or_intrin(const VecData<int64_t,SCTL_RVV_BITS/64>& a, const VecData<int64_t,SCTL_RVV_BITS/64>& b) { return __riscv_vor_vv_i64m1(a.v, b.v, SCTL_RVV_BITS/64); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> or_intrin(const VecData<float,SCTL_RVV_BITS/32>& a, const VecData<float,SCTL_RVV_BITS/32>& b) { return __riscv_vreinterpret_v_i32m1_f32m1(__riscv_vor_vv_i32m1(__riscv_vreinterpret_v_f32m1_i32m1(a.v), __riscv_vreinterpret_v_f32m1_i32m1(b.v), SCTL_RVV_BITS/32)); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> or_intrin(const VecData<double,SCTL_RVV_BITS/64>& a, const VecData<double,SCTL_RVV_BITS/64>& b) { return __riscv_vreinterpret_v_i64m1_f64m1(__riscv_vor_vv_i64m1(__riscv_vreinterpret_v_f64m1_i64m1(a.v), __riscv_vreinterpret_v_f64m1_i64m1(b.v), SCTL_RVV_BITS/64)); }
+
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> andnot_intrin(const VecData<int32_t,SCTL_RVV_BITS/32>& a, const VecData<int32_t,SCTL_RVV_BITS/32>& b) { return __riscv_vand_vv_i32m1(a.v, __riscv_vnot_v_i32m1(b.v, SCTL_RVV_BITS/32), SCTL_RVV_BITS/32); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> andnot_intrin(const VecData<int64_t,SCTL_RVV_BITS/64>& a, const VecData<int64_t,SCTL_RVV_BITS/64>& b) { return __riscv_vand_vv_i64m1(a.v, __riscv_vnot_v_i64m1(b.v, SCTL_RVV_BITS/64), SCTL_RVV_BITS/64); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> andnot_intrin(const VecData<float,SCTL_RVV_BITS/32>& a, const VecData<float,SCTL_RVV_BITS/32>& b) { return __riscv_vreinterpret_v_i32m1_f32m1(__riscv_vand_vv_i32m1(__riscv_vreinterpret_v_f32m1_i32m1(a.v), __riscv_vnot_v_i32m1(__riscv_vreinterpret_v_f32m1_i32m1(b.v), SCTL_RVV_BITS/32), SCTL_RVV_BITS/32)); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> andnot_intrin(const VecData<double,SCTL_RVV_BITS/64>& a, const VecData<double,SCTL_RVV_BITS/64>& b) { return __riscv_vreinterpret_v_i64m1_f64m1(__riscv_vand_vv_i64m1(__riscv_vreinterpret_v_f64m1_i64m1(a.v), __riscv_vnot_v_i64m1(__riscv_vreinterpret_v_f64m1_i64m1(b.v), SCTL_RVV_BITS/64), SCTL_RVV_BITS/64)); }
+
+  // Bitshift
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> bitshiftleft_intrin<VecData<int32_t,SCTL_RVV_BITS/32>>(const VecData<int32_t,SCTL_RVV_BITS/32>& a, const Integer& rhs) { return __riscv_vsll_vx_i32m1(a.v, (size_t)rhs, SCTL_RVV_BITS/32); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> bitshiftleft_intrin<VecData<int64_t,SCTL_RVV_BITS/64>>(const VecData<int64_t,SCTL_RVV_BITS/64>& a, const Integer& rhs) { return __riscv_vsll_vx_i64m1(a.v, (size_t)rhs, SCTL_RVV_BITS/64); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> bitshiftleft_intrin<VecData<float,SCTL_RVV_BITS/32>>(const VecData<float,SCTL_RVV_BITS/32>& a, const Integer& rhs) { return __riscv_vreinterpret_v_i32m1_f32m1(__riscv_vsll_vx_i32m1(__riscv_vreinterpret_v_f32m1_i32m1(a.v), (size_t)rhs, SCTL_RVV_BITS/32)); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> bitshiftleft_intrin<VecData<double,SCTL_RVV_BITS/64>>(const VecData<double,SCTL_RVV_BITS/64>& a, const Integer& rhs) { return __riscv_vreinterpret_v_i64m1_f64m1(__riscv_vsll_vx_i64m1(__riscv_vreinterpret_v_f64m1_i64m1(a.v), (size_t)rhs, SCTL_RVV_BITS/64)); }
+
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> bitshiftright_intrin<VecData<int32_t,SCTL_RVV_BITS/32>>(const VecData<int32_t,SCTL_RVV_BITS/32>& a, const Integer& rhs) { return __riscv_vreinterpret_v_u32m1_i32m1(__riscv_vsrl_vx_u32m1(__riscv_vreinterpret_v_i32m1_u32m1(a.v), (size_t)rhs, SCTL_RVV_BITS/32)); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> bitshiftright_intrin<VecData<int64_t,SCTL_RVV_BITS/64>>(const VecData<int64_t,SCTL_RVV_BITS/64>& a, const Integer& rhs) { return __riscv_vreinterpret_v_u64m1_i64m1(__riscv_vsrl_vx_u64m1(__riscv_vreinterpret_v_i64m1_u64m1(a.v), (size_t)rhs, SCTL_RVV_BITS/64)); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> bitshiftright_intrin<VecData<float,SCTL_RVV_BITS/32>>(const VecData<float,SCTL_RVV_BITS/32>& a, const Integer& rhs) { return __riscv_vreinterpret_v_i32m1_f32m1(__riscv_vreinterpret_v_u32m1_i32m1(__riscv_vsrl_vx_u32m1(__riscv_vreinterpret_v_i32m1_u32m1(__riscv_vreinterpret_v_f32m1_i32m1(a.v)), (size_t)rhs, SCTL_RVV_BITS/32))); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> bitshiftright_intrin<VecData<double,SCTL_RVV_BITS/64>>(const VecData<double,SCTL_RVV_BITS/64>& a, const Integer& rhs) { return __riscv_vreinterpret_v_i64m1_f64m1(__riscv_vreinterpret_v_u64m1_i64m1(__riscv_vsrl_vx_u64m1(__riscv_vreinterpret_v_i64m1_u64m1(__riscv_vreinterpret_v_f64m1_i64m1(a.v)), (size_t)rhs, SCTL_RVV_BITS/64))); }
+
+  // Other functions
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> max_intrin(const VecData<int32_t,SCTL_RVV_BITS/32>& a, const VecData<int32_t,SCTL_RVV_BITS/32>& b) { return __riscv_vmax_vv_i32m1(a.v, b.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> max_intrin(const VecData<int64_t,SCTL_RVV_BITS/64>& a, const VecData<int64_t,SCTL_RVV_BITS/64>& b) { return __riscv_vmax_vv_i64m1(a.v, b.v, SCTL_RVV_BITS/64); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> max_intrin(const VecData<float,SCTL_RVV_BITS/32>& a, const VecData<float,SCTL_RVV_BITS/32>& b) { return __riscv_vfmax_vv_f32m1(a.v, b.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> max_intrin(const VecData<double,SCTL_RVV_BITS/64>& a, const VecData<double,SCTL_RVV_BITS/64>& b) { return __riscv_vfmax_vv_f64m1(a.v, b.v, SCTL_RVV_BITS/64); }
+
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> min_intrin(const VecData<int32_t,SCTL_RVV_BITS/32>& a, const VecData<int32_t,SCTL_RVV_BITS/32>& b) { return __riscv_vmin_vv_i32m1(a.v, b.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> min_intrin(const VecData<int64_t,SCTL_RVV_BITS/64>& a, const VecData<int64_t,SCTL_RVV_BITS/64>& b) { return __riscv_vmin_vv_i64m1(a.v, b.v, SCTL_RVV_BITS/64); }
+  template <> inline VecData<float,SCTL_RVV_BITS/32> min_intrin(const VecData<float,SCTL_RVV_BITS/32>& a, const VecData<float,SCTL_RVV_BITS/32>& b) { return __riscv_vfmin_vv_f32m1(a.v, b.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> min_intrin(const VecData<double,SCTL_RVV_BITS/64>& a, const VecData<double,SCTL_RVV_BITS/64>& b) { return __riscv_vfmin_vv_f64m1(a.v, b.v, SCTL_RVV_BITS/64); }
+
+  template <> inline VecData<float,SCTL_RVV_BITS/32> convert_int2real_intrin<VecData<float,SCTL_RVV_BITS/32>,VecData<int32_t,SCTL_RVV_BITS/32>>(const VecData<int32_t,SCTL_RVV_BITS/32>& x) { return __riscv_vfcvt_f_x_v_f32m1(x.v, SCTL_RVV_BITS/32); }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> convert_int2real_intrin<VecData<double,SCTL_RVV_BITS/64>,VecData<int64_t,SCTL_RVV_BITS/64>>(const VecData<int64_t,SCTL_RVV_BITS/64>& x) { return __riscv_vfcvt_f_x_v_f64m1(x.v, SCTL_RVV_BITS/64); }
+  template <> inline VecData<int32_t,SCTL_RVV_BITS/32> round_real2int_intrin<VecData<int32_t,SCTL_RVV_BITS/32>,VecData<float,SCTL_RVV_BITS/32>>(const VecData<float,SCTL_RVV_BITS/32>& x) { return __riscv_vfcvt_x_f_v_i32m1(x.v, SCTL_RVV_BITS/32); } // default rounding mode (RNE)
+  template <> inline VecData<int64_t,SCTL_RVV_BITS/64> round_real2int_intrin<VecData<int64_t,SCTL_RVV_BITS/64>,VecData<double,SCTL_RVV_BITS/64>>(const VecData<double,SCTL_RVV_BITS/64>& x) { return __riscv_vfcvt_x_f_v_i64m1(x.v, SCTL_RVV_BITS/64); } // default rounding mode (RNE)
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  /////////////////////////////////////////////////////////////////////////////
+
+
+  // Comparison operators
+  template <> inline Mask<VecData<int32_t,SCTL_RVV_BITS/32>> comp_intrin<ComparisonType::lt>(const VecData<int32_t,SCTL_RVV_BITS/32>& a, const VecData<int32_t,SCTL_RVV_BITS/32>& b) { return Mask<VecData<int32_t,SCTL_RVV_BITS/32>>(VecData<int32_t,SCTL_RVV_BITS/32>(__riscv_vmerge_vxm_i32m1(__riscv_vmv_v_x_i32m1(0, SCTL_RVV_BITS/32), -1, __riscv_vmslt_vv_i32m1_b32(a.v, b.v, SCTL_RVV_BITS/32), SCTL_RVV_BITS/32))); }
+  template <> inline Mask<VecData<int32_t,SCTL_RVV_BITS/32>> comp_intrin<ComparisonType::le>(const VecData<int32_t,SCTL_RVV_BITS/32>& a, const VecData<int32_t,SCTL_RVV_BITS/32>& b) { return Mask<VecData<int32_t,SCTL_RVV_BITS/32>>(VecData<int32_t,SCTL_RVV_BITS/32>(__riscv_vmerge_vxm_i32m1(__riscv_vmv_v_x_i32m1(0, SCTL_RVV_BITS/32), -1, __riscv_vmsle_vv_i32m1_b32(a.v, b.v, SCTL_RVV_BITS/32), SCTL_RVV_BITS/32))); }
+  template <> inline Mask<VecData<int32_t,SCTL_RVV_BITS/32>> comp_intrin<ComparisonType::gt>(const VecData<int32_t,SCTL_RVV_BITS/32>& a, const VecData<int32_t,SCTL_RVV_BITS/32>& b) { return Mask<VecData<int32_t,SCTL_RVV_BITS/32>>(VecData<int32_t,SCTL_RVV_BITS/32>(__riscv_vmerge_vxm_i32m1(__riscv_vmv_v_x_i32m1(0, SCTL_RVV_BITS/32), -1, __riscv_vmsgt_vv_i32m1_b32(a.v, b.v, SCTL_RVV_BITS/32), SCTL_RVV_BITS/32))); }
+  template <> inline Mask<VecData<int32_t,SCTL_RVV_BITS/32>> comp_intrin<ComparisonType::ge>(const VecData<int32_t,SCTL_RVV_BITS/32>& a, const VecData<int32_t,SCTL_RVV_BITS/32>& b) { return Mask<VecData<int32_t,SCTL_RVV_BITS/32>>(VecData<int32_t,SCTL_RVV_BITS/32>(__riscv_vmerge_vxm_i32m1(__riscv_vmv_v_x_i32m1(0, SCTL_RVV_BITS/32), -1, __riscv_vmsge_vv_i32m1_b32(a.v, b.v, SCTL_RVV_BITS/32), SCTL_RVV_BITS/32))); }
+  template <> inline Mask<VecData<int32_t,SCTL_RVV_BITS/32>> comp_intrin<ComparisonType::eq>(const VecData<int32_t,SCTL_RVV_BITS/32>& a, const VecData<int32_t,SCTL_RVV_BITS/32>& b) { return Mask<VecData<int32_t,SCTL_RVV_BITS/32>>(VecData<int32_t,SCTL_RVV_BITS/32>(__riscv_vmerge_vxm_i32m1(__riscv_vmv_v_x_i32m1(0, SCTL_RVV_BITS/32), -1, __riscv_vmseq_vv_i32m1_b32(a.v, b.v, SCTL_RVV_BITS/32), SCTL_RVV_BITS/32))); }
+  template <> inline Mask<VecData<int32_t,SCTL_RVV_BITS/32>> comp_intrin<ComparisonType::ne>(const VecData<int32_t,SCTL_RVV_BITS/32>& a, const VecData<int32_t,SCTL_RVV_BITS/32>& b) { return Mask<VecData<int32_t,SCTL_RVV_BITS/32>>(VecData<int32_t,SCTL_RVV_BITS/32>(__riscv_vmerge_vxm_i32m1(__riscv_vmv_v_x_i32m1(0, SCTL_RVV_BITS/32), -1, __riscv_vmsne_vv_i32m1_b32(a.v, b.v, SCTL_RVV_BITS/32), SCTL_RVV_BITS/32))); }
+
+  template <> inline Mask<VecData<int64_t,SCTL_RVV_BITS/64>> comp_intrin<ComparisonType::lt>(const VecData<int64_t,SCTL_RVV_BITS/64>& a, const VecData<int64_t,SCTL_RVV_BITS/64>& b) { return Mask<VecData<int64_t,SCTL_RVV_BITS/64>>(VecData<int64_t,SCTL_RVV_BITS/64>(__riscv_vmerge_vxm_i64m1(__riscv_vmv_v_x_i64m1(0, SCTL_RVV_BITS/64), -1, __riscv_vmslt_vv_i64m1_b64(a.v, b.v, SCTL_RVV_BITS/64), SCTL_RVV_BITS/64))); }
+  template <> inline Mask<VecData<int64_t,SCTL_RVV_BITS/64>> comp_intrin<ComparisonType::le>(const VecData<int64_t,SCTL_RVV_BITS/64>& a, const VecData<int64_t,SCTL_RVV_BITS/64>& b) { return Mask<VecData<int64_t,SCTL_RVV_BITS/64>>(VecData<int64_t,SCTL_RVV_BITS/64>(__riscv_vmerge_vxm_i64m1(__riscv_vmv_v_x_i64m1(0, SCTL_RVV_BITS/64), -1, __riscv_vmsle_vv_i64m1_b64(a.v, b.v, SCTL_RVV_BITS/64), SCTL_RVV_BITS/64))); }
+  template <> inline Mask<VecData<int64_t,SCTL_RVV_BITS/64>> comp_intrin<ComparisonType::gt>(const VecData<int64_t,SCTL_RVV_BITS/64>& a, const VecData<int64_t,SCTL_RVV_BITS/64>& b) { return Mask<VecData<int64_t,SCTL_RVV_BITS/64>>(VecData<int64_t,SCTL_RVV_BITS/64>(__riscv_vmerge_vxm_i64m1(__riscv_vmv_v_x_i64m1(0, SCTL_RVV_BITS/64), -1, __riscv_vmsgt_vv_i64m1_b64(a.v, b.v, SCTL_RVV_BITS/64), SCTL_RVV_BITS/64))); }
+  template <> inline Mask<VecData<int64_t,SCTL_RVV_BITS/64>> comp_intrin<ComparisonType::ge>(const VecData<int64_t,SCTL_RVV_BITS/64>& a, const VecData<int64_t,SCTL_RVV_BITS/64>& b) { return Mask<VecData<int64_t,SCTL_RVV_BITS/64>>(VecData<int64_t,SCTL_RVV_BITS/64>(__riscv_vmerge_vxm_i64m1(__riscv_vmv_v_x_i64m1(0, SCTL_RVV_BITS/64), -1, __riscv_vmsge_vv_i64m1_b64(a.v, b.v, SCTL_RVV_BITS/64), SCTL_RVV_BITS/64))); }
+  template <> inline Mask<VecData<int64_t,SCTL_RVV_BITS/64>> comp_intrin<ComparisonType::eq>(const VecData<int64_t,SCTL_RVV_BITS/64>& a, const VecData<int64_t,SCTL_RVV_BITS/64>& b) { return Mask<VecData<int64_t,SCTL_RVV_BITS/64>>(VecData<int64_t,SCTL_RVV_BITS/64>(__riscv_vmerge_vxm_i64m1(__riscv_vmv_v_x_i64m1(0, SCTL_RVV_BITS/64), -1, __riscv_vmseq_vv_i64m1_b64(a.v, b.v, SCTL_RVV_BITS/64), SCTL_RVV_BITS/64))); }
+  template <> inline Mask<VecData<int64_t,SCTL_RVV_BITS/64>> comp_intrin<ComparisonType::ne>(const VecData<int64_t,SCTL_RVV_BITS/64>& a, const VecData<int64_t,SCTL_RVV_BITS/64>& b) { return Mask<VecData<int64_t,SCTL_RVV_BITS/64>>(VecData<int64_t,SCTL_RVV_BITS/64>(__riscv_vmerge_vxm_i64m1(__riscv_vmv_v_x_i64m1(0, SCTL_RVV_BITS/64), -1, __riscv_vmsne_vv_i64m1_b64(a.v, b.v, SCTL_RVV_BITS/64), SCTL_RVV_BITS/64))); }
+
+  template <> inline Mask<VecData<float,SCTL_RVV_BITS/32>> comp_intrin<ComparisonType::lt>(const VecData<float,SCTL_RVV_BITS/32>& a, const VecData<float,SCTL_RVV_BITS/32>& b) { return Mask<VecData<float,SCTL_RVV_BITS/32>>(VecData<float,SCTL_RVV_BITS/32>(__riscv_vreinterpret_v_i32m1_f32m1(__riscv_vmerge_vxm_i32m1(__riscv_vmv_v_x_i32m1(0, SCTL_RVV_BITS/32), -1, __riscv_vmflt_vv_f32m1_b32(a.v, b.v, SCTL_RVV_BITS/32), SCTL_RVV_BITS/32)))); }
+  template <> inline Mask<VecData<float,SCTL_RVV_BITS/32>> comp_intrin<ComparisonType::le>(const VecData<float,SCTL_RVV_BITS/32>& a, const VecData<float,SCTL_RVV_BITS/32>& b) { return Mask<VecData<float,SCTL_RVV_BITS/32>>(VecData<float,SCTL_RVV_BITS/32>(__riscv_vreinterpret_v_i32m1_f32m1(__riscv_vmerge_vxm_i32m1(__riscv_vmv_v_x_i32m1(0, SCTL_RVV_BITS/32), -1, __riscv_vmfle_vv_f32m1_b32(a.v, b.v, SCTL_RVV_BITS/32), SCTL_RVV_BITS/32)))); }
+  template <> inline Mask<VecData<float,SCTL_RVV_BITS/32>> comp_intrin<ComparisonType::gt>(const VecData<float,SCTL_RVV_BITS/32>& a, const VecData<float,SCTL_RVV_BITS/32>& b) { return Mask<VecData<float,SCTL_RVV_BITS/32>>(VecData<float,SCTL_RVV_BITS/32>(__riscv_vreinterpret_v_i32m1_f32m1(__riscv_vmerge_vxm_i32m1(__riscv_vmv_v_x_i32m1(0, SCTL_RVV_BITS/32), -1, __riscv_vmfgt_vv_f32m1_b32(a.v, b.v, SCTL_RVV_BITS/32), SCTL_RVV_BITS/32)))); }
+  template <> inline Mask<VecData<float,SCTL_RVV_BITS/32>> comp_intrin<ComparisonType::ge>(const VecData<float,SCTL_RVV_BITS/32>& a, const VecData<float,SCTL_RVV_BITS/32>& b) { return Mask<VecData<float,SCTL_RVV_BITS/32>>(VecData<float,SCTL_RVV_BITS/32>(__riscv_vreinterpret_v_i32m1_f32m1(__riscv_vmerge_vxm_i32m1(__riscv_vmv_v_x_i32m1(0, SCTL_RVV_BITS/32), -1, __riscv_vmfge_vv_f32m1_b32(a.v, b.v, SCTL_RVV_BITS/32), SCTL_RVV_BITS/32)))); }
+  template <> inline Mask<VecData<float,SCTL_RVV_BITS/32>> comp_intrin<ComparisonType::eq>(const VecData<float,SCTL_RVV_BITS/32>& a, const VecData<float,SCTL_RVV_BITS/32>& b) { return Mask<VecData<float,SCTL_RVV_BITS/32>>(VecData<float,SCTL_RVV_BITS/32>(__riscv_vreinterpret_v_i32m1_f32m1(__riscv_vmerge_vxm_i32m1(__riscv_vmv_v_x_i32m1(0, SCTL_RVV_BITS/32), -1, __riscv_vmfeq_vv_f32m1_b32(a.v, b.v, SCTL_RVV_BITS/32), SCTL_RVV_BITS/32)))); }
+  template <> inline Mask<VecData<float,SCTL_RVV_BITS/32>> comp_intrin<ComparisonType::ne>(const VecData<float,SCTL_RVV_BITS/32>& a, const VecData<float,SCTL_RVV_BITS/32>& b) { return Mask<VecData<float,SCTL_RVV_BITS/32>>(VecData<float,SCTL_RVV_BITS/32>(__riscv_vreinterpret_v_i32m1_f32m1(__riscv_vmerge_vxm_i32m1(__riscv_vmv_v_x_i32m1(0, SCTL_RVV_BITS/32), -1, __riscv_vmfne_vv_f32m1_b32(a.v, b.v, SCTL_RVV_BITS/32), SCTL_RVV_BITS/32)))); }
+
+  template <> inline Mask<VecData<double,SCTL_RVV_BITS/64>> comp_intrin<ComparisonType::lt>(const VecData<double,SCTL_RVV_BITS/64>& a, const VecData<double,SCTL_RVV_BITS/64>& b) { return Mask<VecData<double,SCTL_RVV_BITS/64>>(VecData<double,SCTL_RVV_BITS/64>(__riscv_vreinterpret_v_i64m1_f64m1(__riscv_vmerge_vxm_i64m1(__riscv_vmv_v_x_i64m1(0, SCTL_RVV_BITS/64), -1, __riscv_vmflt_vv_f64m1_b64(a.v, b.v, SCTL_RVV_BITS/64), SCTL_RVV_BITS/64)))); }
+  template <> inline Mask<VecData<double,SCTL_RVV_BITS/64>> comp_intrin<ComparisonType::le>(const VecData<double,SCTL_RVV_BITS/64>& a, const VecData<double,SCTL_RVV_BITS/64>& b) { return Mask<VecData<double,SCTL_RVV_BITS/64>>(VecData<double,SCTL_RVV_BITS/64>(__riscv_vreinterpret_v_i64m1_f64m1(__riscv_vmerge_vxm_i64m1(__riscv_vmv_v_x_i64m1(0, SCTL_RVV_BITS/64), -1, __riscv_vmfle_vv_f64m1_b64(a.v, b.v, SCTL_RVV_BITS/64), SCTL_RVV_BITS/64)))); }
+  template <> inline Mask<VecData<double,SCTL_RVV_BITS/64>> comp_intrin<ComparisonType::gt>(const VecData<double,SCTL_RVV_BITS/64>& a, const VecData<double,SCTL_RVV_BITS/64>& b) { return Mask<VecData<double,SCTL_RVV_BITS/64>>(VecData<double,SCTL_RVV_BITS/64>(__riscv_vreinterpret_v_i64m1_f64m1(__riscv_vmerge_vxm_i64m1(__riscv_vmv_v_x_i64m1(0, SCTL_RVV_BITS/64), -1, __riscv_vmfgt_vv_f64m1_b64(a.v, b.v, SCTL_RVV_BITS/64), SCTL_RVV_BITS/64)))); }
+  template <> inline Mask<VecData<double,SCTL_RVV_BITS/64>> comp_intrin<ComparisonType::ge>(const VecData<double,SCTL_RVV_BITS/64>& a, const VecData<double,SCTL_RVV_BITS/64>& b) { return Mask<VecData<double,SCTL_RVV_BITS/64>>(VecData<double,SCTL_RVV_BITS/64>(__riscv_vreinterpret_v_i64m1_f64m1(__riscv_vmerge_vxm_i64m1(__riscv_vmv_v_x_i64m1(0, SCTL_RVV_BITS/64), -1, __riscv_vmfge_vv_f64m1_b64(a.v, b.v, SCTL_RVV_BITS/64), SCTL_RVV_BITS/64)))); }
+  template <> inline Mask<VecData<double,SCTL_RVV_BITS/64>> comp_intrin<ComparisonType::eq>(const VecData<double,SCTL_RVV_BITS/64>& a, const VecData<double,SCTL_RVV_BITS/64>& b) { return Mask<VecData<double,SCTL_RVV_BITS/64>>(VecData<double,SCTL_RVV_BITS/64>(__riscv_vreinterpret_v_i64m1_f64m1(__riscv_vmerge_vxm_i64m1(__riscv_vmv_v_x_i64m1(0, SCTL_RVV_BITS/64), -1, __riscv_vmfeq_vv_f64m1_b64(a.v, b.v, SCTL_RVV_BITS/64), SCTL_RVV_BITS/64)))); }
+  template <> inline Mask<VecData<double,SCTL_RVV_BITS/64>> comp_intrin<ComparisonType::ne>(const VecData<double,SCTL_RVV_BITS/64>& a, const VecData<double,SCTL_RVV_BITS/64>& b) { return Mask<VecData<double,SCTL_RVV_BITS/64>>(VecData<double,SCTL_RVV_BITS/64>(__riscv_vreinterpret_v_i64m1_f64m1(__riscv_vmerge_vxm_i64m1(__riscv_vmv_v_x_i64m1(0, SCTL_RVV_BITS/64), -1, __riscv_vmfne_vv_f64m1_b64(a.v, b.v, SCTL_RVV_BITS/64), SCTL_RVV_BITS/64)))); }
+
+
+  // Special functions
+  template <Integer digits> struct rsqrt_approx_intrin<digits, VecData<float,SCTL_RVV_BITS/32>> {
+    static constexpr Integer newton_iter = mylog2((Integer)(digits/2.1072099696)); // vfrsqrt7 is accurate to 7-bits
+    static inline VecData<float,SCTL_RVV_BITS/32> eval(const VecData<float,SCTL_RVV_BITS/32>& a) {
+      return rsqrt_newton_iter<newton_iter,newton_iter,VecData<float,SCTL_RVV_BITS/32>>::eval(__riscv_vfrsqrt7_v_f32m1(a.v, SCTL_RVV_BITS/32), a.v);
+    }
+    static inline VecData<float,SCTL_RVV_BITS/32> eval(const VecData<float,SCTL_RVV_BITS/32>& a, const Mask<VecData<float,SCTL_RVV_BITS/32>>& m) {
+      return rsqrt_newton_iter<newton_iter,newton_iter,VecData<float,SCTL_RVV_BITS/32>>::eval(and_intrin(VecData<float,SCTL_RVV_BITS/32>(__riscv_vfrsqrt7_v_f32m1(a.v, SCTL_RVV_BITS/32)), convert_mask2vec_intrin(m)), a.v);
+    }
+  };
+  template <Integer digits> struct rsqrt_approx_intrin<digits, VecData<double,SCTL_RVV_BITS/64>> {
+    static constexpr Integer newton_iter = mylog2((Integer)(digits/2.1072099696)); // vfrsqrt7 is accurate to 7-bits
+    static inline VecData<double,SCTL_RVV_BITS/64> eval(const VecData<double,SCTL_RVV_BITS/64>& a) {
+      return rsqrt_newton_iter<newton_iter,newton_iter,VecData<double,SCTL_RVV_BITS/64>>::eval(__riscv_vfrsqrt7_v_f64m1(a.v, SCTL_RVV_BITS/64), a.v);
+    }
+    static inline VecData<double,SCTL_RVV_BITS/64> eval(const VecData<double,SCTL_RVV_BITS/64>& a, const Mask<VecData<double,SCTL_RVV_BITS/64>>& m) {
+      return rsqrt_newton_iter<newton_iter,newton_iter,VecData<double,SCTL_RVV_BITS/64>>::eval(and_intrin(VecData<double,SCTL_RVV_BITS/64>(__riscv_vfrsqrt7_v_f64m1(a.v, SCTL_RVV_BITS/64)), convert_mask2vec_intrin(m)), a.v);
+    }
+  };
+
+  template <> inline void sincos_intrin<VecData<float,SCTL_RVV_BITS/32>>(VecData<float,SCTL_RVV_BITS/32>& sinx, VecData<float,SCTL_RVV_BITS/32>& cosx, const VecData<float,SCTL_RVV_BITS/32>& x) {
+    approx_sincos_intrin<(Integer)(TypeTraits<float>::SigBits/3.2)>(sinx, cosx, x); // TODO: determine constants more precisely
+  }
+  template <> inline void sincos_intrin<VecData<double,SCTL_RVV_BITS/64>>(VecData<double,SCTL_RVV_BITS/64>& sinx, VecData<double,SCTL_RVV_BITS/64>& cosx, const VecData<double,SCTL_RVV_BITS/64>& x) {
+    approx_sincos_intrin<(Integer)(TypeTraits<double>::SigBits/3.2)>(sinx, cosx, x); // TODO: determine constants more precisely
+  }
+
+  template <> inline VecData<float,SCTL_RVV_BITS/32> exp_intrin<VecData<float,SCTL_RVV_BITS/32>>(const VecData<float,SCTL_RVV_BITS/32>& x) {
+    return approx_exp_intrin<(Integer)(TypeTraits<float>::SigBits/3.8)>(x); // TODO: determine constants more precisely
+  }
+  template <> inline VecData<double,SCTL_RVV_BITS/64> exp_intrin<VecData<double,SCTL_RVV_BITS/64>>(const VecData<double,SCTL_RVV_BITS/64>& x) {
+    return approx_exp_intrin<(Integer)(TypeTraits<double>::SigBits/3.8)>(x); // TODO: determine constants more precisely
+  }
+
+#endif
+}
+
 #endif // _SCTL_INTRIN_WRAPPER_HPP_
@@ -20,6 +20,9 @@ namespace sctl {
       static constexpr Integer FLOPS() {
         return 6;
       }
+      static constexpr bool SYMMETRIC() { // K(-r) = K(r), with equal source and target dimensions
+        return true;
+      }
       template <class Real> static constexpr Real uKerScaleFactor() {
         return 1 / (4 * const_pi<Real>());
       }
@@ -79,6 +82,9 @@ namespace sctl {
       static constexpr Integer FLOPS() {
         return 23;
       }
+      static constexpr bool SYMMETRIC() { // K(-r) = K(r), with equal source and target dimensions
+        return true;
+      }
       template <class Real> static constexpr Real uKerScaleFactor() {
         return 1 / (8 * const_pi<Real>());
       }
@@ -197,6 +203,172 @@ namespace sctl {
       }
     };
 
+    // The context pointer (see GenericKernel::SetCtxPtr) for the Helmholtz and modified Helmholtz
+    // kernels must point to the wavenumber, of the same type as the evaluation precision Real.
+    // Complex quantities are stored as consecutive (real, imaginary) pairs.
+
+    struct Helmholtz3D_FxU {
+      static const std::string& Name() {
+        static const std::string name = "Helmholtz3D-FxU";
+        return name;
+      }
+      static constexpr Integer FLOPS() {
+        return 24;
+      }
+      static constexpr bool SYMMETRIC() { // K(-r) = K(r), with equal source and target dimensions
+        return true;
+      }
+      template <class Real> static constexpr Real uKerScaleFactor() {
+        return 1 / (4 * const_pi<Real>());
+      }
+      template <Integer digits, class VecType> static void uKerMatrix(VecType (&u)[2][2], const VecType (&r)[3], const void* ctx_ptr) {
+        using Real = typename VecType::ScalarType;
+        const VecType k(*(const Real*)ctx_ptr);
+        VecType r2 = r[0]*r[0]+r[1]*r[1]+r[2]*r[2];
+        VecType rinv = approx_rsqrt<digits>(r2, r2 > VecType::Zero());
+        VecType sin_kr, cos_kr;
+        approx_sincos<digits>(sin_kr, cos_kr, k*r2*rinv);
+        VecType G_re = cos_kr * rinv;
+        VecType G_im = sin_kr * rinv;
+        u[0][0] = G_re; u[0][1] = G_im;
+        u[1][0] =-G_im; u[1][1] = G_re;
+      }
+    };
+
+    struct Helmholtz3D_DxU {
+      static const std::string& Name() {
+        static const std::string name = "Helmholtz3D-DxU";
+        return name;
+      }
+      static constexpr Integer FLOPS() {
+        return 36;
+      }
+      template <class Real> static constexpr Real uKerScaleFactor() {
+        return 1 / (4 * const_pi<Real>());
+      }
+      template <Integer digits, class VecType> static void uKerMatrix(VecType (&u)[2][2], const VecType (&r)[3], const VecType (&n)[3], const void* ctx_ptr) {
+        using Real = typename VecType::ScalarType;
+        const VecType k(*(const Real*)ctx_ptr);
+        VecType r2 = r[0]*r[0]+r[1]*r[1]+r[2]*r[2];
+        VecType rinv = approx_rsqrt<digits>(r2, r2 > VecType::Zero());
+        VecType kr = k*r2*rinv;
+        VecType sin_kr, cos_kr;
+        approx_sincos<digits>(sin_kr, cos_kr, kr);
+        VecType rdotn_rinv3 = (r[0]*n[0] + r[1]*n[1] + r[2]*n[2]) * rinv*rinv*rinv;
+        VecType G_re = (cos_kr + sin_kr*kr) * rdotn_rinv3; // exp(ikr) (1 - ikr) (r.n) / r^3
+        VecType G_im = (sin_kr - cos_kr*kr) * rdotn_rinv3;
+        u[0][0] = G_re; u[0][1] = G_im;
+        u[1][0] =-G_im; u[1][1] = G_re;
+      }
+    };
+
+    struct Helmholtz3D_FxdU {
+      static const std::string& Name() {
+        static const std::string name = "Helmholtz3D-FxdU";
+        return name;
+      }
+      static constexpr Integer FLOPS() {
+        return 38;
+      }
+      template <class Real> static constexpr Real uKerScaleFactor() {
+        return -1 / (4 * const_pi<Real>());
+      }
+      template <Integer digits, class VecType> static void uKerMatrix(VecType (&u)[2][6], const VecType (&r)[3], const void* ctx_ptr) {
+        using Real = typename VecType::ScalarType;
+        const VecType k(*(const Real*)ctx_ptr);
+        VecType r2 = r[0]*r[0]+r[1]*r[1]+r[2]*r[2];
+        VecType rinv = approx_rsqrt<digits>(r2, r2 > VecType::Zero());
+        VecType kr = k*r2*rinv;
+        VecType sin_kr, cos_kr;
+        approx_sincos<digits>(sin_kr, cos_kr, kr);
+        VecType rinv3 = rinv*rinv*rinv;
+        VecType G_re = (cos_kr + sin_kr*kr) * rinv3; // exp(ikr) (1 - ikr) / r^3
+        VecType G_im = (sin_kr - cos_kr*kr) * rinv3;
+        for (Integer i = 0; i < 3; i++) {
+          u[0][i*2+0] = G_re*r[i]; u[0][i*2+1] = G_im*r[i];
+          u[1][i*2+0] =-G_im*r[i]; u[1][i*2+1] = G_re*r[i];
+        }
+      }
+    };
+
+    // GCC 12 reports the _mm512_undefined_*() arguments of the AVX-512 intrinsics in exp() as uninitialized.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+    struct ModHelmholtz3D_FxU {
+      static const std::string& Name() {
+        static const std::string name = "ModHelmholtz3D-FxU";
+        return name;
+      }
+      static constexpr Integer FLOPS() {
+        return 20;
+      }
+      static constexpr bool SYMMETRIC() { // K(-r) = K(r), with equal source and target dimensions
+        return true;
+      }
+      template <class Real> static constexpr Real uKerScaleFactor() {
+        return 1 / (4 * const_pi<Real>());
+      }
+      template <Integer digits, class VecType> static void uKerMatrix(VecType (&u)[1][1], const VecType (&r)[3], const void* ctx_ptr) {
+        using Real = typename VecType::ScalarType;
+        const VecType k(*(const Real*)ctx_ptr);
+        VecType r2 = r[0]*r[0]+r[1]*r[1]+r[2]*r[2];
+        VecType rinv = approx_rsqrt<digits>(r2, r2 > VecType::Zero());
+        u[0][0] = approx_exp<digits>(-k*r2*rinv) * rinv;
+      }
+    };
+
+    struct ModHelmholtz3D_DxU {
+      static const std::string& Name() {
+        static const std::string name = "ModHelmholtz3D-DxU";
+        return name;
+      }
+      static constexpr Integer FLOPS() {
+        return 28;
+      }
+      template <class Real> static constexpr Real uKerScaleFactor() {
+        return 1 / (4 * const_pi<Real>());
+      }
+      template <Integer digits, class VecType> static void uKerMatrix(VecType (&u)[1][1], const VecType (&r)[3], const VecType (&n)[3], const void* ctx_ptr) {
+        using Real = typename VecType::ScalarType;
+        const VecType k(*(const Real*)ctx_ptr);
+        VecType r2 = r[0]*r[0]+r[1]*r[1]+r[2]*r[2];
+        VecType rinv = approx_rsqrt<digits>(r2, r2 > VecType::Zero());
+        VecType kr = k*r2*rinv;
+        VecType rdotn = r[0]*n[0] + r[1]*n[1] + r[2]*n[2];
+        u[0][0] = approx_exp<digits>(-kr) * (kr + (Real)1) * rdotn * rinv*rinv*rinv; // exp(-kr) (1 + kr) (r.n) / r^3
+      }
+    };
+
+    struct ModHelmholtz3D_FxdU {
+      static const std::string& Name() {
+        static const std::string name = "ModHelmholtz3D-FxdU";
+        return name;
+      }
+      static constexpr Integer FLOPS() {
+        return 26;
+      }
+      template <class Real> static constexpr Real uKerScaleFactor() {
+        return -1 / (4 * const_pi<Real>());
+      }
+      template <Integer digits, class VecType> static void uKerMatrix(VecType (&u)[1][3], const VecType (&r)[3], const void* ctx_ptr) {
+        using Real = typename VecType::ScalarType;
+        const VecType k(*(const Real*)ctx_ptr);
+        VecType r2 = r[0]*r[0]+r[1]*r[1]+r[2]*r[2];
+        VecType rinv = approx_rsqrt<digits>(r2, r2 > VecType::Zero());
+        VecType kr = k*r2*rinv;
+        VecType G = approx_exp<digits>(-kr) * (kr + (Real)1) * rinv*rinv*rinv; // exp(-kr) (1 + kr) / r^3
+        u[0][0] = G * r[0];
+        u[0][1] = G * r[1];
+        u[0][2] = G * r[2];
+      }
+    };
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
   }  // namespace kernel_impl
 
   // Notation:
@@ -212,6 +384,12 @@ namespace sctl {
   using Stokes3D_FxT = GenericKernel<kernel_impl::Stokes3D_FxT>; // single-layer source ---> traction-tensor
   using Stokes3D_FSxU = GenericKernel<kernel_impl::Stokes3D_FSxU>; // single-layer + source/sink ---> velocity (required for FMM translations involving double-layer - M2M, M2L, M2T)
   using Stokes3D_FxUP = GenericKernel<kernel_impl::Stokes3D_FxUP>; // single-layer source ---> velocity + pressure
+  using Helmholtz3D_FxU = GenericKernel<kernel_impl::Helmholtz3D_FxU>; // exp(ikr)/r, wavenumber k from the context pointer
+  using Helmholtz3D_DxU = GenericKernel<kernel_impl::Helmholtz3D_DxU>;
+  using Helmholtz3D_FxdU = GenericKernel<kernel_impl::Helmholtz3D_FxdU>;
+  using ModHelmholtz3D_FxU = GenericKernel<kernel_impl::ModHelmholtz3D_FxU>; // exp(-kr)/r (Yukawa), k from the context pointer
+  using ModHelmholtz3D_DxU = GenericKernel<kernel_impl::ModHelmholtz3D_DxU>;
+  using ModHelmholtz3D_FxdU = GenericKernel<kernel_impl::ModHelmholtz3D_FxdU>;
 
 }  // end namespace
 
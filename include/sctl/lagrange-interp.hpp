@@ -1,7 +1,8 @@
 #ifndef _SCTL_LAGRANGE_INTERP_HPP_
 #define _SCTL_LAGRANGE_INTERP_HPP_
 
-#include "sctl/common.hpp"  // for sctl
+#include "sctl/common.hpp"  // for Long, sctl
+#include "sctl/matrix.hpp"  // for Matrix
 
 namespace sctl {
 
@@ -27,6 +28,17 @@ namespace sctl {
        */
       static void Interpolate(Vector<Real>& wts, const Vector<Real>& src_nds, const Vector<Real>& trg_nds);
 
+      /**
+       * This function computes the differentiation weights for the
+       * derivative of the interpolant at the interpolation nodes.
+       *
+       * @param[out] wts The differentiation weights stored in row-major
+       *                 order. The dimensions are N x N, where N is the
+       *                 number of nodes, such that df[i] = sum_j f[j] * wts[j*N+i].
+       * @param[in] nds The vector of node positions.
+       */
+      static void DerivativeMatrix(Vector<Real>& wts, const Vector<Real>& nds);
+
       /**
        * This function computes the derivative of interpolated values
        * at given nodes.
@@ -43,6 +55,80 @@ namespace sctl {
        */
       static void test();
 
+    private:
+
+      /**
+       * Compute the (scaled) barycentric weights w[j] = c / prod_{k!=j} (nds[j] - nds[k]).
+       */
+      static void BarycentricWeights(Vector<Real>& w, const Vector<Real>& nds);
+
+  };
+
+  /**
+   * Precomputed interpolation (or differentiation) operator for a fixed set
+   * of source and target nodes. The weights are computed once in Setup and
+   * then applied to any number of functions with a single GEMM, so that
+   * repeated use with the same nodes avoids the setup cost.
+   *
+   * @code
+   * LagrangeInterpPlan<double> plan;
+   * plan.SetupInterpolate(src_nds, trg_nds);
+   * for (...) plan.Apply(f_trg, f_src); // f_src: dof x Nsrc, f_trg: dof x Ntrg
+   * @endcode
+   *
+   * @tparam Real The type of the interpolation nodes and values.
+   */
+  template <class Real> class LagrangeInterpPlan {
+    public:
+      /**
+       * Set up interpolation from the source nodes to the target nodes.
+       *
+       * @param[in] src_nds The vector of source node positions.
+       * @param[in] trg_nds The vector of target node positions.
+       */
+      void SetupInterpolate(const Vector<Real>& src_nds, const Vector<Real>& trg_nds);
+
+      /**
+       * Set up differentiation of the interpolant at the interpolation nodes.
+       *
+       * @param[in] nds The vector of node positions.
+       */
+      void SetupDerivative(const Vector<Real>& nds);
+
+      /**
+       * @return The number of source nodes.
+       */
+      Long SrcDim() const;
+
+      /**
+       * @return The number of target nodes.
+       */
+      Long TrgDim() const;
+
+      /**
+       * @return The weights matrix (of dimensions SrcDim x TrgDim).
+       */
+      const Matrix<Real>& GetMatrix() const;
+
+      /**
+       * Apply the operator to a batch of functions.
+       *
+       * @param[out] f_trg The values at the target nodes (dof x TrgDim, in row-major order).
+       * @param[in] f_src The values at the source nodes (dof x SrcDim, in row-major order).
+       */
+      void Apply(Vector<Real>& f_trg, const Vector<Real>& f_src) const;
+
+      /**
+       * Apply the operator to a batch of functions.
+       *
+       * @param[out] f_trg The values at the target nodes (dof x TrgDim).
+       * @param[in] f_src The values at the source nodes (dof x SrcDim).
+       */
+      void Apply(Matrix<Real>& f_trg, const Matrix<Real>& f_src) const;
+
+    private:
+
+      Matrix<Real> M;
   };
 
 }
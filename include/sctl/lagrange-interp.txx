@@ -1,12 +1,16 @@
 #ifndef _SCTL_LAGRANGE_INTERP_TXX_
 #define _SCTL_LAGRANGE_INTERP_TXX_
 
+#include <algorithm>                 // for max, min
 #include <iostream>                  // for cout
 
 #include "sctl/common.hpp"           // for Long, Integer, SCTL_ASSERT, SCTL...
 #include "sctl/lagrange-interp.hpp"  // for LagrangeInterp
 #include "sctl/iterator.txx"         // for NullIterator
+#include "sctl/math_utils.hpp"       // for fabs, cos, const_pi
+#include "sctl/math_utils.txx"       // for machine_eps
 #include "sctl/matrix.hpp"           // for Matrix
+#include "sctl/matrix.txx"           // for Matrix::GEMM
 #include "sctl/static-array.hpp"     // for StaticArray
 #include "sctl/vec.hpp"              // for Vec
 #include "sctl/vec.txx"              // for DefaultVecLen
@@ -33,12 +37,63 @@ namespace sctl {
     Vector<Real> df;
     Derivative(df, Vector<Real>(f.Dim(0)*f.Dim(1),f.begin()), src);
     std::cout<<df<<'\n';
+
+    { // Batched interpolation and differentiation of polynomials with a plan
+      const Long N = 12, dof = 5;
+      Vector<Real> nds(N), trg_nds(2*N+1);
+      for (Long i = 0; i < N; i++) nds[i] = (Real)(0.5 - 0.5 * cos(const_pi<Real>() * (2*i+1) / (2*N)));
+      for (Long i = 0; i < trg_nds.Dim(); i++) trg_nds[i] = i / (Real)(trg_nds.Dim() - 1);
+      trg_nds[3] = nds[5]; // target coinciding with a source node
+
+      const auto poly = [](Long k, Real x) { Real p = 1; for (Long i = 0; i < k; i++) p *= (x - (Real)0.3); return p; };
+      Matrix<Real> F(dof, N), dF_ref(dof, N), F_trg_ref(dof, trg_nds.Dim());
+      for (Long k = 0; k < dof; k++) {
+        for (Long i = 0; i < N; i++) {
+          F[k][i] = poly(2*k+1, nds[i]);
+          dF_ref[k][i] = (2*k+1) * poly(2*k, nds[i]);
+        }
+        for (Long i = 0; i < trg_nds.Dim(); i++) F_trg_ref[k][i] = poly(2*k+1, trg_nds[i]);
+      }
+
+      LagrangeInterpPlan<Real> interp_plan, diff_plan;
+      interp_plan.SetupInterpolate(nds, trg_nds);
+      diff_plan.SetupDerivative(nds);
+      Matrix<Real> F_trg, dF;
+      interp_plan.Apply(F_trg, F);
+      diff_plan.Apply(dF, F);
+
+      Real err_interp = 0, err_diff = 0;
+      for (Long i = 0; i < F_trg.Dim(0)*F_trg.Dim(1); i++) err_interp = std::max<Real>(err_interp, fabs(F_trg[0][i] - F_trg_ref[0][i]));
+      for (Long i = 0; i < dF.Dim(0)*dF.Dim(1); i++) err_diff = std::max<Real>(err_diff, fabs(dF[0][i] - dF_ref[0][i]));
+      std::cout<<"Interpolation error: "<<err_interp<<"  Derivative error: "<<err_diff<<'\n';
+      SCTL_ASSERT(err_interp < 1e3 * machine_eps<Real>() && err_diff < 1e4 * machine_eps<Real>());
+    }
+  }
+
+  template <class Real> void LagrangeInterp<Real>::BarycentricWeights(Vector<Real>& w, const Vector<Real>& nds) {
+    const Long N = nds.Dim();
+    SCTL_ASSERT(w.Dim() == N);
+    const Real normal_factor = [&nds]() { // normalize
+      if (nds.Dim() < 2) return (Real)1;
+      Real max_src = nds[0], min_src = nds[0];
+      for (const auto x : nds) {
+        max_src = std::max<Real>(max_src, x);
+        min_src = std::min<Real>(min_src, x);
+      }
+      return 4/(max_src - min_src);
+    }();
+    for (Long j = 0; j < N; j++) {
+      Real w_inv = 1;
+      Real nds_j(nds[j]);
+      for (Long k =   0; k <    j; k++) w_inv *= (nds[k] - nds_j)*normal_factor;
+      for (Long k = j+1; k <    N; k++) w_inv *= (nds[k] - nds_j)*normal_factor;
+      w[j] = 1/w_inv;
+    }
   }
 
   template <class Real> void LagrangeInterp<Real>::Interpolate(Vector<Real>& wts, const Vector<Real>& src_nds, const Vector<Real>& trg_nds) {
     static constexpr Integer VecLen = DefaultVecLen<Real>();
     using VecType = Vec<Real, VecLen>;
-    VecType vec_one((Real)1);
 
     const Long Nsrc = src_nds.Dim();
     const Long Ntrg = trg_nds.Dim();
@@ -48,65 +103,68 @@ namespace sctl {
 
     StaticArray<Real,200> w_buff;
     Vector<Real> w(Nsrc, (Nsrc>=200?NullIterator<Real>():w_buff), (Nsrc>=200));
-    const Real normal_factor = [src_nds]() { // normalize
-      if (src_nds.Dim() < 2) return (Real)1;
-      Real max_src = src_nds[0], min_src = src_nds[0];
-      for (const auto x : src_nds) {
-        max_src = std::max<Real>(max_src, x);
-        min_src = std::min<Real>(min_src, x);
+    BarycentricWeights(w, src_nds);
+
+    const auto interp_scalar = [&M,&w,&src_nds,&trg_nds,Nsrc](Long t) {
+      Long s_ = -1;
+      Real scal = 0;
+      for (Long s = 0; s < Nsrc; s++) {
+        if (trg_nds[t] == src_nds[s]) {
+          s_ = s;
+          break;
+        }
+        M[s][t] = w[s] / (trg_nds[t] - src_nds[s]);
+        scal += M[s][t];
       }
-      return 4/(max_src - min_src);
-    }();
-    for (Integer j = 0; j < Nsrc; j++) {
-      Real w_inv = 1;
-      Real src_nds_j(src_nds[j]);
-      for (Integer k =   0; k <    j; k++) w_inv *= (src_nds[k] - src_nds_j)*normal_factor;
-      for (Integer k = j+1; k < Nsrc; k++) w_inv *= (src_nds[k] - src_nds_j)*normal_factor;
-      w[j] = 1/w_inv;
-    }
+      if (s_ == -1) {
+        scal = 1/scal;
+        for (Long s = 0; s < Nsrc; s++) M[s][t] *= scal;
+      } else {
+        for (Long s = 0; s < Nsrc; s++) M[s][t] = 0;
+        M[s_][t] = 1;
+      }
+    };
 
-    if (0) {
-      for (Long i1 = 0; i1 < Ntrg_; i1+=VecLen) {
-        VecType x = VecType::Load(&trg_nds[i1]);
-        for (Integer j = 0; j < Nsrc; j++) {
-          VecType y0(vec_one);
-          for (Integer k =   0; k <    j; k++) y0 *= VecType(src_nds[k]) - x;
-          for (Integer k = j+1; k < Nsrc; k++) y0 *= VecType(src_nds[k]) - x;
-          VecType y = y0 * w[j];
-          y.Store(&M[j][i1]);
-        }
+    // Barycentric formula, VecLen targets at a time. A target which coincides
+    // with a source node gives a non-finite sum and is redone with interp_scalar.
+    for (Long t = 0; t < Ntrg_; t += VecLen) {
+      const VecType x = VecType::Load(&trg_nds[t]);
+      VecType scal = VecType::Zero();
+      for (Long s = 0; s < Nsrc; s++) {
+        const VecType y = VecType(w[s]) / (x - VecType(src_nds[s]));
+        y.Store(&M[s][t]);
+        scal += y;
       }
-      for (Long i1 = Ntrg_; i1 < Ntrg; i1++) {
-        Real x = trg_nds[i1];
-        for (Integer j = 0; j < Nsrc; j++) {
-          Real y0 = 1;
-          for (Integer k =   0; k <    j; k++) y0 *= src_nds[k] - x;
-          for (Integer k = j+1; k < Nsrc; k++) y0 *= src_nds[k] - x;
-          M[j][i1] = y0 * w[j];
-        }
+      alignas(sizeof(VecType)) Real scal_[VecLen];
+      scal.StoreAligned(scal_);
+
+      scal = VecType((Real)1) / scal;
+      for (Long s = 0; s < Nsrc; s++) {
+        (VecType::Load(&M[s][t]) * scal).Store(&M[s][t]);
+      }
+      for (Integer k = 0; k < VecLen; k++) {
+        if (!(scal_[k] - scal_[k] == 0)) interp_scalar(t + k);
       }
     }
-    if (1) { // Barycentric // TODO: vectorize
-      //static constexpr Integer digits = (Integer)(TypeTraits<Real>::SigBits*0.3010299957);
-      for (Long t = 0; t< Ntrg; t++) {
-        Long s_ = -1;
-        Real scal = 0;
-        for (Long s = 0; s < Nsrc; s++) {
-          if (trg_nds[t] == src_nds[s]) {
-            s_ = s;
-            break;
-          }
-          M[s][t] = w[s] / (trg_nds[t] - src_nds[s]);
-          scal += M[s][t];
-        }
-        if (s_ == -1) {
-          scal = 1/scal;
-          for (Long s = 0; s < Nsrc; s++) M[s][t] *= scal;
-        } else {
-          for (Long s = 0; s < Nsrc; s++) M[s][t] = 0;
-          M[s_][t] = 1;
-        }
+    for (Long t = Ntrg_; t < Ntrg; t++) interp_scalar(t);
+  }
+
+  template <class Real> void LagrangeInterp<Real>::DerivativeMatrix(Vector<Real>& wts, const Vector<Real>& nds) {
+    const Long N = nds.Dim();
+    if (wts.Dim() != N*N) wts.ReInit(N*N);
+    Matrix<Real> M(N, N, wts.begin(), false);
+
+    Vector<Real> w(N);
+    BarycentricWeights(w, nds);
+    for (Long i = 0; i < N; i++) { // D[i][j] = (w[j]/w[i]) / (nds[i]-nds[j]), D[i][i] = -sum_{j!=i} D[i][j]
+      Real sum = 0;
+      const Real w_inv = 1/w[i];
+      for (Long j = 0; j < N; j++) {
+        if (j == i) continue;
+        M[j][i] = w[j] * w_inv / (nds[i] - nds[j]);
+        sum += M[j][i];
       }
+      M[i][i] = -sum;
     }
   }
 
@@ -117,45 +175,46 @@ namespace sctl {
     if (df.Dim() != N * dof) df.ReInit(N * dof);
     if (N*dof == 0) return;
 
-    const Real normal_factor = [nds]() { // normalize
-      if (!nds.Dim()) return (Real)1;
-      Real max_src = nds[0], min_src = nds[0];
-      for (const auto x : nds) {
-        max_src = std::max<Real>(max_src, x);
-        min_src = std::min<Real>(min_src, x);
-      }
-      return 4/(max_src - min_src);
-    }();
+    LagrangeInterpPlan<Real> plan;
+    plan.SetupDerivative(nds);
+    plan.Apply(df, f);
+  }
 
-    auto dp = [&nds,&N,&normal_factor](Real x, Long i) {
-      Real scal = 1;
-      for (Long j = 0; j < N; j++) {
-        if (i!=j) scal *= (nds[i] - nds[j]);
-        scal *= normal_factor;
-      }
-      scal = 1/scal;
-      Real wt = 0;
-      for (Long k = 0; k < N; k++) {
-        Real wt_ = 1;
-        if (k!=i) {
-          for (Long j = 0; j < N; j++) {
-            if (j!=k && j!=i) wt_ *= (x - nds[j]);
-            wt_ *= normal_factor;
-          }
-          wt += wt_;
-        }
-      }
-      return wt * scal;
-    };
-    for (Long k = 0; k < dof; k++) {
-      for (Long i = 0; i < N; i++) {
-        Real df_ = 0;
-        for (Long j = 0; j < N; j++) {
-          df_ += (f[k*N+j]-f[k*N+i]) * dp(nds[i],j);
-        }
-        df[k*N+i] = df_;
-      }
-    }
+
+  template <class Real> void LagrangeInterpPlan<Real>::SetupInterpolate(const Vector<Real>& src_nds, const Vector<Real>& trg_nds) {
+    M.ReInit(src_nds.Dim(), trg_nds.Dim());
+    Vector<Real> wts(M.Dim(0)*M.Dim(1), M.begin(), false);
+    LagrangeInterp<Real>::Interpolate(wts, src_nds, trg_nds);
+  }
+
+  template <class Real> void LagrangeInterpPlan<Real>::SetupDerivative(const Vector<Real>& nds) {
+    M.ReInit(nds.Dim(), nds.Dim());
+    Vector<Real> wts(M.Dim(0)*M.Dim(1), M.begin(), false);
+    LagrangeInterp<Real>::DerivativeMatrix(wts, nds);
+  }
+
+  template <class Real> Long LagrangeInterpPlan<Real>::SrcDim() const { return M.Dim(0); }
+
+  template <class Real> Long LagrangeInterpPlan<Real>::TrgDim() const { return M.Dim(1); }
+
+  template <class Real> const Matrix<Real>& LagrangeInterpPlan<Real>::GetMatrix() const { return M; }
+
+  template <class Real> void LagrangeInterpPlan<Real>::Apply(Vector<Real>& f_trg, const Vector<Real>& f_src) const {
+    const Long Nsrc = M.Dim(0), Ntrg = M.Dim(1);
+    const Long dof = (Nsrc ? f_src.Dim() / Nsrc : 0);
+    SCTL_ASSERT(f_src.Dim() == dof * Nsrc);
+    if (f_trg.Dim() != dof * Ntrg) f_trg.ReInit(dof * Ntrg);
+    if (!dof || !Ntrg) return;
+
+    const Matrix<Real> F_src(dof, Nsrc, (Iterator<Real>)f_src.begin(), false);
+    Matrix<Real> F_trg(dof, Ntrg, f_trg.begin(), false);
+    Matrix<Real>::GEMM(F_trg, F_src, M);
+  }
+
+  template <class Real> void LagrangeInterpPlan<Real>::Apply(Matrix<Real>& f_trg, const Matrix<Real>& f_src) const {
+    SCTL_ASSERT(f_src.Dim(1) == M.Dim(0));
+    if (f_trg.Dim(0) != f_src.Dim(0) || f_trg.Dim(1) != M.Dim(1)) f_trg.ReInit(f_src.Dim(0), M.Dim(1));
+    Matrix<Real>::GEMM(f_trg, f_src, M);
   }
 
 }
@@ -12,15 +12,21 @@
 namespace sctl {
 
 template <class ValueType> class Matrix;
+template <class Real> class GMRES;
 
 /**
  * This class implements a preconditioner built from the Krylov-subspace constructed during GMRES solves.
  *
+ * Alternatively, with SetRecycleRank(), it stores a deflation subspace that GMRES recycles across successive solves
+ * (GCRO-DR), for sequences of linear systems with slowly changing operators and right-hand-sides.
+ *
  * @tparam Real The data type of the values.
  */
 template <class Real> class KrylovPrecond {
   public:
 
+    using ParallelOp = std::function<void(Vector<Real>*, const Vector<Real>&)>; ///< Function type for linear operator.
+
     /**
      * Constructor.
      */
@@ -50,6 +56,34 @@ template <class Real> class KrylovPrecond {
      */
     void Append(const Matrix<Real>& Qt, const Matrix<Real>& U);
 
+    /**
+     * Set a fixed (right) preconditioner M, e.g. the block-Jacobi preconditioner
+     * BoundaryIntegralOp::SelfPrecond(). The Krylov-subspaces are built on top
+     * of it, so that the operator is P = M * (I + U1 * Qt1) * (I + U2 * Qt2) ...
+     * Any previously appended Krylov-subspaces are cleared.
+     *
+     * @param[in] M The preconditioner (an empty function clears it).
+     */
+    void SetPrecond(const ParallelOp& M);
+
+    /**
+     * Enable Krylov-subspace recycling (GCRO-DR) in GMRES solves that use this object, with a deflation subspace of
+     * dimension k (default 0, disabled). Instead of appending the Krylov-subspace of each solve to the operator, GMRES
+     * then keeps the k vectors of the search space with the smallest singular values of the projected operator, and
+     * starts the next solve by projecting out their image under the (new) operator. This costs k extra operator
+     * applications in each solve (so that the subspace stays valid when the operator changes), in exchange for fewer
+     * iterations. Any previously appended Krylov-subspaces and the recycled subspace are cleared; the preconditioner
+     * set by SetPrecond() is kept.
+     *
+     * @param[in] k Dimension of the recycled subspace.
+     */
+    void SetRecycleRank(Long k);
+
+    /**
+     * Get the maximum dimension of the recycled subspace.
+     */
+    Long RecycleRank() const;
+
     /**
      * Apply the preconditioner.
      *
@@ -61,6 +95,20 @@ template <class Real> class KrylovPrecond {
 
     Long N_; ///< Length of the input vector.
     std::list<Matrix<Real>> mat_lst; ///< List of matrices storing Krylov-subspaces.
+    ParallelOp M_; ///< Fixed preconditioner applied after the Krylov-subspace corrections.
+
+    Long recycle_rank_; ///< Maximum dimension of the recycled subspace.
+    Vector<Real> Y_; ///< Recycled subspace (row-major, each row is a vector of length N_).
+
+    friend class GMRES<Real>;
+};
+
+/**
+ * Orthogonalization scheme for the Arnoldi iterations in GMRES.
+ */
+enum class GMRESOrthogonalization {
+  MGS, ///< modified Gram-Schmidt (one global reduction for each inner product, k+2 in iteration k)
+  CGS2 ///< classical Gram-Schmidt with re-orthogonalization, using GEMM on the Krylov basis (two global reductions in each iteration)
 };
 
 /**
@@ -74,13 +122,33 @@ template <class Real> class GMRES {
 
   using ParallelOp = std::function<void(Vector<Real>*, const Vector<Real>&)>; ///< Function type for linear operator.
 
+  using BlockParallelOp = std::function<void(Matrix<Real>*, const Matrix<Real>&)>; ///< Function type for linear operator applied to a block of vectors (one vector in each row).
+
   /**
    * Constructor.
    *
    * @param[in] comm The communicator.
    * @param[in] verbose Verbosity flag.
    */
-  GMRES(const Comm& comm = Comm::Self(), bool verbose = true) : comm_(comm), verbose_(verbose) {}
+  GMRES(const Comm& comm = Comm::Self(), bool verbose = true) : comm_(comm), verbose_(verbose), ortho_(GMRESOrthogonalization::MGS) {}
+
+  /**
+   * Set the orthogonalization scheme (default GMRESOrthogonalization::MGS). With CGS2, the number of global reductions
+   * in each iteration is independent of the size of the Krylov-subspace, which reduces the communication latency on
+   * large numbers of processes. The scheme is used for the Arnoldi iterations with and without Krylov-subspace
+   * recycling.
+   *
+   * @note With PETSc, CGS2 maps to KSPGMRESClassicalGramSchmidtOrthogonalization with KSP_GMRES_CGS_REFINE_ALWAYS;
+   * Krylov-subspace recycling is not available with PETSc.
+   *
+   * @param[in] ortho The orthogonalization scheme.
+   */
+  void SetOrthogonalization(GMRESOrthogonalization ortho) { ortho_ = ortho; }
+
+  /**
+   * Get the orthogonalization scheme.
+   */
+  GMRESOrthogonalization GetOrthogonalization() const { return ortho_; }
 
   /**
    * Solve the linear system: A x = b.
@@ -92,10 +160,34 @@ template <class Real> class GMRES {
    * @param[in] max_iter Maximum number of iterations (default -1 corresponds to no limit).
    * @param[in] use_abs_tol Whether to use absolute tolerance (default false).
    * @param[out] solve_iter Number of iterations.
-   * @param[in,out] krylov_precond Krylov-subspace preconditioner. The preconditioner is updated.
+   * @param[in,out] krylov_precond Krylov-subspace preconditioner. The preconditioner is updated (or, if recycling is enabled with KrylovPrecond::SetRecycleRank(), the recycled subspace).
+   *
+   * @note With PETSc (SCTL_HAVE_PETSC, for float and double), krylov_precond is applied as a right preconditioner but
+   * it is not updated, and recycling is not supported (this fails with an assertion).
    */
   void operator()(Vector<Real>* x, const ParallelOp& A, const Vector<Real>& b, const Real tol, const Integer max_iter = -1, const bool use_abs_tol = false, Long* solve_iter=nullptr, KrylovPrecond<Real>* krylov_precond=nullptr) const;
 
+  /**
+   * Solve the linear system: A X = B for multiple right-hand-sides (the rows of B) using block GMRES. The right-hand-sides
+   * share one Krylov-subspace, and in each iteration the operator is applied to a block of vectors together (with a
+   * single call to A), and the block is orthogonalized using GEMM. Columns that have converged are deflated: the next
+   * block only spans the directions that are needed by the residuals of the unconverged right-hand-sides (above their
+   * tolerance), so the block size shrinks as the right-hand-sides converge.
+   *
+   * The batched evaluators BoundaryIntegralOp::ComputePotential(Matrix<Real>&, const Matrix<Real>&) and
+   * ParticleFMM::Eval(Matrix<Real>&, const std::string&) use the same row-wise layout, so A can evaluate the whole
+   * block with one call to them (sharing the far-field and near-interaction work among the rows).
+   *
+   * @param[out] X The solution vectors (k x N matrix, one solution in each row).
+   * @param[in] A The linear operator, applied to a block of vectors.
+   * @param[in] B The right-hand-side vectors (k x N matrix).
+   * @param[in] tol The accuracy tolerance (for each right-hand-side).
+   * @param[in] max_iter Maximum number of iterations, i.e. number of calls to A (default -1 corresponds to no limit).
+   * @param[in] use_abs_tol Whether to use absolute tolerance (default false).
+   * @param[out] solve_iter Number of iterations.
+   */
+  void operator()(Matrix<Real>* X, const BlockParallelOp& A, const Matrix<Real>& B, const Real tol, const Integer max_iter = -1, const bool use_abs_tol = false, Long* solve_iter=nullptr) const;
+
   /**
    * A test function for GMRES solver.
    *
@@ -107,8 +199,11 @@ template <class Real> class GMRES {
 
   void GenericGMRES(Vector<Real>* x, const ParallelOp& A, const Vector<Real>& b, const Real tol, Integer max_iter, const bool use_abs_tol, Long* solve_iter, KrylovPrecond<Real>* krylov_precond) const;
 
+  void RecycleGMRES(Vector<Real>* x, const ParallelOp& A, const Vector<Real>& b, const Real tol, Integer max_iter, const bool use_abs_tol, Long* solve_iter, KrylovPrecond<Real>& krylov_precond) const; // GCRO-DR
+
   Comm comm_; ///< Communicator.
   bool verbose_; ///< Verbosity flag.
+  GMRESOrthogonalization ortho_; ///< Orthogonalization scheme.
 };
 
 }  // end namespace
@@ -14,14 +14,17 @@
 #include "sctl/iterator.hpp"      // for Iterator, ConstIterator
 #include "sctl/iterator.txx"      // for Iterator::Iterator<ValueType>, Iter...
 #include "sctl/math_utils.hpp"    // for sqrt, fabs
+#include "sctl/math_utils.txx"    // for machine_eps
 #include "sctl/matrix.hpp"        // for Matrix
+#include "sctl/metrics.hpp"       // for Metrics, Metric
+#include "sctl/metrics.txx"       // for Metrics::Record
 #include "sctl/static-array.hpp"  // for StaticArray
 #include "sctl/static-array.txx"  // for StaticArray::operator+, StaticArray...
 #include "sctl/vector.hpp"        // for Vector
 
 namespace sctl {
 
-  template <class Real> KrylovPrecond<Real>::KrylovPrecond() : N_(0) {}
+  template <class Real> KrylovPrecond<Real>::KrylovPrecond() : N_(0), recycle_rank_(0) {}
 
   template <class Real> Long KrylovPrecond<Real>::Size() const {
     return N_;
@@ -40,6 +43,7 @@ namespace sctl {
     SCTL_ASSERT(Qt.Dim(1) == U.Dim(0));
     if (Qt.Dim(0) != N_) { // clear
       mat_lst.clear();
+      Y_.ReInit(0);
       N_ = Qt.Dim(0);
     }
 
@@ -47,27 +51,50 @@ namespace sctl {
     mat_lst.push_front(Qt);
   }
 
+  template <class Real> void KrylovPrecond<Real>::SetPrecond(const ParallelOp& M) {
+    mat_lst.clear();
+    N_ = 0;
+    M_ = M;
+  }
+
+  template <class Real> void KrylovPrecond<Real>::SetRecycleRank(const Long k) {
+    SCTL_ASSERT(k >= 0);
+    mat_lst.clear();
+    Y_.ReInit(0);
+    N_ = 0;
+    recycle_rank_ = k;
+  }
+
+  template <class Real> Long KrylovPrecond<Real>::RecycleRank() const {
+    return recycle_rank_;
+  }
+
   template <class Real> void KrylovPrecond<Real>::Apply(Vector<Real>& y, const Comm& comm) const {
-    if (N_ != y.Dim()) return;
-
-    Matrix<Real> y_Qt, y_Qt_glb, y_(1, N_, y.begin(), false);
-    for (auto it = mat_lst.begin(); it != mat_lst.end(); it++) {
-      const auto& Qt = *it;
-      it++;
-      const auto& U = *it;
-
-      //y_ += (y_ * Qt) * U;
-      y_Qt.ReInit(1, Qt.Dim(1));
-      Matrix<Real>::GEMM(y_Qt, y_, Qt);
-
-      if (comm.Size() > 1) {
-        if (y_Qt_glb.Dim(0) != y_Qt.Dim(0) || y_Qt_glb.Dim(1) != y_Qt.Dim(1)) y_Qt_glb.ReInit(y_Qt.Dim(0), y_Qt.Dim(1));
-        comm.Allreduce(y_Qt.begin(), y_Qt_glb.begin(), y_Qt.Dim(1), CommOp::SUM);
-        Matrix<Real>::GEMM(y_, y_Qt_glb, U, (Real)1);
-      } else {
-        Matrix<Real>::GEMM(y_, y_Qt, U, (Real)1);
+    if (N_ == y.Dim()) {
+      Matrix<Real> y_Qt, y_Qt_glb, y_(1, N_, y.begin(), false);
+      for (auto it = mat_lst.begin(); it != mat_lst.end(); it++) {
+        const auto& Qt = *it;
+        it++;
+        const auto& U = *it;
+
+        //y_ += (y_ * Qt) * U;
+        y_Qt.ReInit(1, Qt.Dim(1));
+        Matrix<Real>::GEMM(y_Qt, y_, Qt);
+
+        if (comm.Size() > 1) {
+          if (y_Qt_glb.Dim(0) != y_Qt.Dim(0) || y_Qt_glb.Dim(1) != y_Qt.Dim(1)) y_Qt_glb.ReInit(y_Qt.Dim(0), y_Qt.Dim(1));
+          comm.Allreduce(y_Qt.begin(), y_Qt_glb.begin(), y_Qt.Dim(1), CommOp::SUM);
+          Matrix<Real>::GEMM(y_, y_Qt_glb, U, (Real)1);
+        } else {
+          Matrix<Real>::GEMM(y_, y_Qt, U, (Real)1);
+        }
       }
     }
+
+    if (M_) { // y <-- M * y
+      const Vector<Real> y0 = y;
+      M_(&y, y0);
+    }
   }
 
 
@@ -138,11 +165,49 @@ namespace sctl {
       h[k] = cs_k * h[k] + sn_k * h[k+1];
       h[k+1] = 0.0;
     };
-    auto arnoldi = [this,N,&Q_row,&Q,&krylov_precond](Vector<Real>& h, Vector<Real>& q, const ParallelOp& A, const Long k) {
+    Vector<Real> h_buff, h_buff_glb; // buffers for the fused reductions in CGS2
+    auto cgs_pass = [this,N,&Q_mat,&h_buff,&h_buff_glb](Vector<Real>& h, Vector<Real>& q, const Long k, const bool compute_norm) { // q <-- q - Q^t (Q q), h += Q q
+      const Matrix<Real> Q_(k+1, N, Q_mat.begin(), false);
+      const Long Nh = k+1 + (compute_norm ? 1 : 0);
+      if (h_buff.Dim() < Nh) h_buff.ReInit(Nh);
+      if (h_buff_glb.Dim() < Nh) h_buff_glb.ReInit(Nh);
+
+      Matrix<Real> h_(k+1, 1, h_buff.begin(), false);
+      Matrix<Real>::GEMM(h_, Q_, Matrix<Real>(N, 1, q.begin(), false));
+      if (compute_norm) { // fuse the reduction for the norm of q
+        h_buff[k+1] = 0;
+        for (Long j = 0; j < N; j++) h_buff[k+1] += q[j] * q[j];
+      }
+      comm_.Allreduce(h_buff.begin(), h_buff_glb.begin(), Nh, CommOp::SUM);
+
+      Matrix<Real> h_neg(1, k+1);
+      for (Long i = 0; i < k+1; i++) {
+        h[i] += h_buff_glb[i];
+        h_neg[0][i] = -h_buff_glb[i];
+      }
+      Matrix<Real> q_(1, N, q.begin(), false);
+      Matrix<Real>::GEMM(q_, h_neg, Q_, (Real)1);
+      return (compute_norm ? h_buff_glb[k+1] : (Real)0);
+    };
+    auto arnoldi = [this,N,&Q_row,&Q,&krylov_precond,&cgs_pass,&h_buff_glb](Vector<Real>& h, Vector<Real>& q, const ParallelOp& A, const Long k) {
       Vector<Real> q_k(N, Q_row(k), krylov_precond?true:false);
       if (krylov_precond) krylov_precond->Apply(q_k, comm_);
       A(&q, q_k);
 
+      if (ortho_ == GMRESOrthogonalization::CGS2) { // Classical Gram-Schmidt with re-orthogonalization
+        for (Long i = 0; i < k+1; i++) h[i] = 0;
+        cgs_pass(h, q, k, false);
+        const Real q_norm2 = cgs_pass(h, q, k, true); // norm of q before the second pass
+
+        Real h_norm2 = 0; // norm of the second projection
+        for (Long i = 0; i < k+1; i++) h_norm2 += h_buff_glb[i] * h_buff_glb[i];
+        Real q_norm2_ = q_norm2 - h_norm2; // norm of q after the second pass (Pythagoras)
+        if (q_norm2_ <= q_norm2 * sqrt<Real>(machine_eps<Real>())) q_norm2_ = inner_prod(q, q, comm_); // cancellation, compute explicitly
+        h[k+1] = sqrt<Real>(q_norm2_);
+        q *= 1/h[k+1];
+        return;
+      }
+
       for (Long i = 0; i < k+1; i++) { // Modified Gram-Schmidt, keeping the Hessenberg matrix
         h[i] = inner_prod(q, Vector<Real>(N, Q_row(i), false), comm_);
         for (Long j = 0; j < N; j++) {
@@ -197,6 +262,7 @@ namespace sctl {
       beta[k+1] = -sn[k] * beta[k];
       beta[k]   = cs[k] * beta[k];
       error     = fabs(beta[k+1]);
+      Metrics::Record(Metric::GMRES_RESIDUAL, (double)(b_norm > 0 ? error / b_norm : error));
     }
     if (verbose_ && !comm_.Rank()) printf("%3lld KSP Residual norm %.12e\n", (long long)k, (double)error);
 
@@ -215,6 +281,7 @@ namespace sctl {
     if (krylov_precond) krylov_precond->Apply(x_, comm_);
     (*x) += x_;
 
+    Metrics::Record(Metric::GMRES_ITERATIONS, (double)k);
     if (solve_iter) (*solve_iter) = k;
 
     if (krylov_precond) {
@@ -253,8 +320,482 @@ namespace sctl {
     }
   }
 
+  template <class Real> inline void GMRES<Real>::RecycleGMRES(Vector<Real>* x, const ParallelOp& A, const Vector<Real>& b, const Real tol, Integer max_iter, const bool use_abs_tol, Long* solve_iter, KrylovPrecond<Real>& krylov_precond) const {
+    const Long N = b.Dim();
+    if (max_iter < 0) { // set max_iter
+      StaticArray<Long,2> NN{N,0};
+      comm_.Allreduce(NN+0, NN+1, 1, CommOp::SUM);
+      max_iter = NN[1];
+    }
+
+    auto B = [&A,&krylov_precond,this](Vector<Real>* Bv, const Vector<Real>& v) { // B = A * M
+      Vector<Real> Mv = v;
+      krylov_precond.Apply(Mv, comm_);
+      A(Bv, Mv);
+    };
+    auto proj = [this,N](Vector<Real>& c, Vector<Real>& v, const Matrix<Real>& C) { // c <-- C v, v <-- v - C^t c
+      const Long k = C.Dim(0);
+      c.ReInit(k);
+      if (!k) return;
+      Vector<Real> c_loc(k);
+      Matrix<Real> c_(k, 1, c_loc.begin(), false);
+      Matrix<Real>::GEMM(c_, C, Matrix<Real>(N, 1, v.begin(), false));
+      comm_.Allreduce(c_loc.begin(), c.begin(), k, CommOp::SUM);
+
+      Matrix<Real> c_neg(1, k);
+      for (Long i = 0; i < k; i++) c_neg[0][i] = -c[i];
+      Matrix<Real> v_(1, N, v.begin(), false);
+      Matrix<Real>::GEMM(v_, c_neg, C, (Real)1);
+    };
+
+    Vector<Real> r;
+    if (x->Dim() == N) { // r = b - A * x;
+      Vector<Real> Ax;
+      A(&Ax, *x);
+      r = b - Ax;
+    } else {
+      r = b;
+      x->ReInit(N);
+      x->SetZero();
+    }
+
+    const Real b_norm = sqrt<Real>(inner_prod(b, b, comm_));
+    const Real abs_tol = tol * (use_abs_tol ? 1 : b_norm);
+
+    // Orthonormalize C = B * U (with the same operations on U) for the recycled subspace U
+    Matrix<Real> U, C;
+    Vector<Real> u_norm; // norms of the columns of U after orthonormalization
+    if (krylov_precond.N_ == N && krylov_precond.Y_.Dim()) {
+      const Long k0 = krylov_precond.Y_.Dim() / N;
+      U.ReInit(k0, N);
+      C.ReInit(k0, N);
+      Long k = 0;
+      for (Long i = 0; i < k0; i++) {
+        Vector<Real> u(N, U[k], false), c;
+        for (Long j = 0; j < N; j++) u[j] = krylov_precond.Y_[i*N+j];
+        B(&c, u);
+        for (Long j = 0; j < N; j++) C[k][j] = c[j];
+
+        const Real c_norm0 = sqrt<Real>(inner_prod(c, c, comm_));
+        for (Long l = 0; l < k; l++) { // modified Gram-Schmidt
+          const Real h = inner_prod(Vector<Real>(N, C[k], false), Vector<Real>(N, C[l], false), comm_);
+          for (Long j = 0; j < N; j++) {
+            C[k][j] -= h * C[l][j];
+            U[k][j] -= h * U[l][j];
+          }
+        }
+        const Real c_norm = sqrt<Real>(inner_prod(Vector<Real>(N, C[k], false), Vector<Real>(N, C[k], false), comm_));
+        if (c_norm > c_norm0 * sqrt<Real>(machine_eps<Real>())) { // drop linearly dependent vectors
+          for (Long j = 0; j < N; j++) {
+            C[k][j] /= c_norm;
+            U[k][j] /= c_norm;
+          }
+          k++;
+        }
+      }
+      if (k < k0) { // resize
+        const Matrix<Real> U_(k, N, U.begin(), false), C_(k, N, C.begin(), false);
+        U = Matrix<Real>(U_);
+        C = Matrix<Real>(C_);
+      }
+
+      u_norm.ReInit(k);
+      for (Long i = 0; i < k; i++) u_norm[i] = sqrt<Real>(inner_prod(Vector<Real>(N, U[i], false), Vector<Real>(N, U[i], false), comm_));
+    }
+    const Long kc = C.Dim(0);
+
+    Vector<Real> y_U; // coefficients of U in the solution
+    proj(y_U, r, C); // r <-- (I - C^t C) r
+
+    Vector<Vector<Real>> V, H, Hbar, Bk; // Arnoldi vectors, Hessenberg columns (Givens rotated and original), and C * B * V
+    Vector<Real> beta(1), sn, cs;
+    const Real r_norm = sqrt<Real>(inner_prod(r, r, comm_));
+    beta[0] = r_norm;
+    V.PushBack(r * (r_norm > 0 ? 1/r_norm : 0));
+
+    Long k = 0;
+    Real error = r_norm;
+    for (; k < max_iter && error > abs_tol; k++) { // Arnoldi for (I - C^t C) * B
+      if (verbose_ && !comm_.Rank()) printf("%3lld KSP Residual norm %.12e\n", (long long)k, (double)error);
+      Vector<Real> q, c_k;
+      B(&q, V[k]);
+      proj(c_k, q, C);
+
+      Vector<Real> h(k+2);
+      if (ortho_ == GMRESOrthogonalization::CGS2) { // Classical Gram-Schmidt with re-orthogonalization
+        h = 0;
+        Real q_norm2 = 0, h_norm2 = 0;
+        for (Integer pass = 0; pass < 2; pass++) {
+          const Long Nh = k+1 + (pass ? 1 : 0); // fuse the reduction for the norm of q in the second pass
+          Vector<Real> h_loc(Nh), h_glb(Nh);
+          for (Long i = 0; i < k+1; i++) {
+            h_loc[i] = 0;
+            for (Long j = 0; j < N; j++) h_loc[i] += q[j] * V[i][j];
+          }
+          if (pass) {
+            h_loc[k+1] = 0;
+            for (Long j = 0; j < N; j++) h_loc[k+1] += q[j] * q[j];
+          }
+          comm_.Allreduce(h_loc.begin(), h_glb.begin(), Nh, CommOp::SUM);
+          for (Long i = 0; i < k+1; i++) {
+            for (Long j = 0; j < N; j++) q[j] -= h_glb[i] * V[i][j];
+            h[i] += h_glb[i];
+          }
+          if (pass) {
+            q_norm2 = h_glb[k+1];
+            for (Long i = 0; i < k+1; i++) h_norm2 += h_glb[i] * h_glb[i];
+          }
+        }
+        Real q_norm2_ = q_norm2 - h_norm2; // norm of q after the second pass (Pythagoras)
+        if (q_norm2_ <= q_norm2 * sqrt<Real>(machine_eps<Real>())) q_norm2_ = inner_prod(q, q, comm_); // cancellation, compute explicitly
+        h[k+1] = sqrt<Real>(q_norm2_);
+      } else {
+        for (Long i = 0; i < k+1; i++) { // Modified Gram-Schmidt
+          h[i] = inner_prod(q, V[i], comm_);
+          for (Long j = 0; j < N; j++) q[j] -= h[i] * V[i][j];
+        }
+        h[k+1] = sqrt<Real>(inner_prod(q, q, comm_));
+      }
+      q *= 1/h[k+1];
+      Hbar.PushBack(h);
+      Bk.PushBack(c_k);
+      V.PushBack(q);
+
+      for (Long i = 0; i < k; i++) { // apply the previous Givens rotations
+        const Real temp = cs[i] * h[i] + sn[i] * h[i+1];
+        h[i+1] = -sn[i] * h[i] + cs[i] * h[i+1];
+        h[i]   = temp;
+      }
+      const Real t = sqrt<Real>(h[k]*h[k] + h[k+1]*h[k+1]);
+      cs.PushBack(h[k] / t);
+      sn.PushBack(h[k+1] / t);
+      h[k] = cs[k] * h[k] + sn[k] * h[k+1];
+      H.PushBack(h);
+
+      beta.PushBack(-sn[k] * beta[k]);
+      beta[k] = cs[k] * beta[k];
+      error = fabs(beta[k+1]);
+      Metrics::Record(Metric::GMRES_RESIDUAL, (double)(b_norm > 0 ? error / b_norm : error));
+    }
+    if (verbose_ && !comm_.Rank()) printf("%3lld KSP Residual norm %.12e\n", (long long)k, (double)error);
+
+    for (Long i = k-1; i >= 0; i--) { // beta <-- beta * inv(H); (through back substitution)
+      beta[i] /= H[i][i];
+      for (Long j = 0; j < i; j++) beta[j] -= beta[i] * H[i][j];
+    }
+    for (Long j = 0; j < k; j++) { // y_U <-- y_U - Bk * beta
+      for (Long i = 0; i < kc; i++) y_U[i] -= Bk[j][i] * beta[j];
+    }
+    Vector<Real> y(N); y = 0;
+    for (Long j = 0; j < k; j++) y += V[j] * beta[j];
+    for (Long i = 0; i < kc; i++) {
+      for (Long j = 0; j < N; j++) y[j] += y_U[i] * U[i][j];
+    }
+    krylov_precond.Apply(y, comm_);
+    (*x) += y;
+
+    Metrics::Record(Metric::GMRES_ITERATIONS, (double)k);
+    if (solve_iter) (*solve_iter) = k;
+
+    // Update the recycled subspace: the vectors in W = [U/|U|; V_k] with the smallest singular values of B
+    // restricted to span(W). Since B * W = [C; V_{k+1}] * G, with orthonormal [C; V_{k+1}] and
+    //   G = [diag(1/|U|), Bk; 0, Hbar],
+    // these are the smallest right singular vectors of G * R^{-1}, where W^t W = R^t R.
+    const Long kw = kc + k;
+    if (!kw) return;
+    Matrix<Real> W(kw, N), G(kw+1, kw);
+    G.SetZero();
+    for (Long i = 0; i < kc; i++) {
+      for (Long j = 0; j < N; j++) W[i][j] = U[i][j] / u_norm[i];
+      G[i][i] = 1 / u_norm[i];
+    }
+    for (Long l = 0; l < k; l++) {
+      for (Long j = 0; j < N; j++) W[kc+l][j] = V[l][j];
+      for (Long i = 0; i < kc; i++) G[i][kc+l] = Bk[l][i];
+      for (Long i = 0; i < l+2; i++) G[kc+i][kc+l] = Hbar[l][i];
+    }
+
+    Matrix<Real> WWt(kw, kw), WWt_glb(kw, kw);
+    Matrix<Real>::GEMM(WWt, W, W.Transpose());
+    comm_.Allreduce(WWt.begin(), WWt_glb.begin(), kw*kw, CommOp::SUM);
+
+    Matrix<Real> Rinv; // R^{-1} = Q * S^{-1/2} where W^t W = Q * S * Q^t, truncated to the numerical rank
+    { // Set Rinv
+      Matrix<Real> tU, tS, tVT;
+      WWt_glb.SVD(tU, tS, tVT);
+      Long rank = 0;
+      while (rank < kw && tS[rank][rank] > tS[0][0] * machine_eps<Real>() * kw) rank++;
+      Rinv.ReInit(kw, rank);
+      for (Long i = 0; i < kw; i++) {
+        for (Long j = 0; j < rank; j++) Rinv[i][j] = tVT[j][i] / sqrt<Real>(tS[j][j]);
+      }
+    }
+    const Long rank = Rinv.Dim(1);
+
+    Matrix<Real> Z; // coefficients of the new recycled subspace in W
+    { // Set Z
+      Matrix<Real> GRinv = G * Rinv, tU, tS, tVT;
+      GRinv.SVD(tU, tS, tVT);
+      const Long k_new = std::min(krylov_precond.recycle_rank_, rank);
+      Matrix<Real> S(k_new, rank);
+      for (Long i = 0; i < k_new; i++) {
+        for (Long j = 0; j < rank; j++) S[i][j] = tVT[rank-1-i][j];
+      }
+      Z = S * Rinv.Transpose();
+    }
+
+    krylov_precond.Y_.ReInit(Z.Dim(0) * N);
+    Matrix<Real> Y(Z.Dim(0), N, krylov_precond.Y_.begin(), false);
+    Matrix<Real>::GEMM(Y, Z, W);
+    krylov_precond.N_ = N;
+  }
+
   template <class Real> inline void GMRES<Real>::operator()(Vector<Real>* x, const ParallelOp& A, const Vector<Real>& b, const Real tol, const Integer max_iter, const bool use_abs_tol, Long* solve_iter, KrylovPrecond<Real>* krylov_precond) const {
-    GenericGMRES(x, A, b, tol, max_iter, use_abs_tol, solve_iter, krylov_precond);
+    if (krylov_precond && krylov_precond->RecycleRank() > 0) {
+      RecycleGMRES(x, A, b, tol, max_iter, use_abs_tol, solve_iter, *krylov_precond);
+    } else {
+      GenericGMRES(x, A, b, tol, max_iter, use_abs_tol, solve_iter, krylov_precond);
+    }
+  }
+
+  template <class Real> inline void GMRES<Real>::operator()(Matrix<Real>* X, const BlockParallelOp& A, const Matrix<Real>& B, const Real tol, const Integer max_iter, const bool use_abs_tol, Long* solve_iter) const {
+    const Long k = B.Dim(0), N = B.Dim(1);
+    Long max_iter_ = max_iter;
+    if (max_iter_ < 0) { // set max_iter
+      StaticArray<Long,2> NN{N,0};
+      comm_.Allreduce(NN+0, NN+1, 1, CommOp::SUM);
+      max_iter_ = NN[1];
+    }
+    static constexpr Real ARRAY_RESIZE_FACTOR = 1.618;
+    static const Real eps_rank = 1000 * machine_eps<Real>(); // relative tolerance for dropping linearly dependent vectors
+
+    auto row_norms = [this](const Matrix<Real>& M) { // 2-norm of each row
+      const Long Nrows = M.Dim(0);
+      Vector<Real> norm2(Nrows), norm2_glb(Nrows);
+      for (Long i = 0; i < Nrows; i++) {
+        norm2[i] = 0;
+        for (Long j = 0; j < M.Dim(1); j++) norm2[i] += M[i][j] * M[i][j];
+      }
+      comm_.Allreduce(norm2.begin(), norm2_glb.begin(), Nrows, CommOp::SUM);
+      for (auto& a : norm2_glb) a = sqrt<Real>(a);
+      return norm2_glb;
+    };
+
+    Matrix<Real> R; // residual block
+    if (X->Dim(0) == k && X->Dim(1) == N) { // R = B - A * X;
+      Matrix<Real> AX;
+      A(&AX, *X);
+      R = B - AX;
+    } else {
+      R = B;
+      X->ReInit(k, N);
+      X->SetZero();
+    }
+    if (!k) return;
+
+    Vector<Real> abs_tol = row_norms(B);
+    for (auto& a : abs_tol) a = tol * (use_abs_tol ? 1 : a);
+
+    Long nv = 0; // size of the Krylov basis
+    Vector<Real> V_mat, rhs; // Krylov basis (nv x N) and the right-hand-side of the least-squares problem (nv x k)
+    auto append_basis = [N,k,&nv,&V_mat,&rhs](const Vector<Real>& v, const Real scal) {
+      if (V_mat.Dim() < (nv+1)*N) {
+        Vector<Real> V_mat_((Long)((nv+1)*ARRAY_RESIZE_FACTOR)*N);
+        for (Long i = 0; i < nv*N; i++) V_mat_[i] = V_mat[i];
+        V_mat.Swap(V_mat_);
+      }
+      for (Long j = 0; j < N; j++) V_mat[nv*N+j] = v[j] * scal;
+      for (Long j = 0; j < k; j++) rhs.PushBack(0);
+      nv++;
+    };
+    auto append_block = [this,N,&nv,&V_mat,&append_basis](Matrix<Real>& T, Matrix<Real>& W, const Vector<Real>& w_norm0) { // rank-revealing QR: W = T * V[nv0:nv], appending the new vectors to V
+      const Long r = W.Dim(0), nv0 = nv;
+      T.ReInit(r, r);
+      T.SetZero();
+      for (Long l = 0; l < r; l++) { // modified Gram-Schmidt
+        Vector<Real> w(N, W[l], false);
+        for (Long q = 0; q < nv-nv0; q++) {
+          const Vector<Real> v(N, V_mat.begin() + (nv0+q)*N, false);
+          T[l][q] = inner_prod(w, v, comm_);
+          for (Long j = 0; j < N; j++) w[j] -= T[l][q] * v[j];
+        }
+        const Real w_norm = sqrt<Real>(inner_prod(w, w, comm_));
+        if (w_norm > w_norm0[l] * eps_rank) {
+          T[l][nv-nv0] = w_norm;
+          append_basis(w, 1/w_norm);
+        }
+      }
+      return nv - nv0;
+    };
+    auto block_orthogonalize = [this,N,&nv,&V_mat](Matrix<Real>& H, Matrix<Real>& W) { // classical Gram-Schmidt with re-orthogonalization: H = V * W^t, W <-- W - H^t * V
+      const Long r = W.Dim(0);
+      H.ReInit(nv, r);
+      H.SetZero();
+      if (!nv) return;
+      const Matrix<Real> V(nv, N, V_mat.begin(), false);
+      Matrix<Real> H_loc(nv, r), H_glb(nv, r), Ht_neg(r, nv);
+      for (Integer pass = 0; pass < 2; pass++) {
+        Matrix<Real>::GEMM(H_loc, V, W.Transpose());
+        comm_.Allreduce(H_loc.begin(), H_glb.begin(), nv*r, CommOp::SUM);
+        for (Long i = 0; i < nv; i++) {
+          for (Long j = 0; j < r; j++) {
+            H[i][j] += H_glb[i][j];
+            Ht_neg[j][i] = -H_glb[i][j];
+          }
+        }
+        Matrix<Real>::GEMM(W, Ht_neg, V, (Real)1);
+      }
+    };
+
+    Vector<Vector<Real>> S, cand; // expanded directions and candidate directions (coefficients in the Krylov basis)
+    Vector<Vector<Real>> R_col; // columns of the triangular factor of the Hessenberg matrix
+    Vector<Long> rot_idx; // Givens rotations: rows (rot_idx[2*l], rot_idx[2*l+1]), cosine rot_c[l], sine rot_s[l]
+    Vector<Real> rot_c, rot_s;
+    auto add_column = [k,&nv,&R_col,&rot_idx,&rot_c,&rot_s,&rhs](Vector<Real> h) { // QR update with the Hessenberg column h (length nv)
+      const Long j = R_col.Dim();
+      for (Long l = 0; l < rot_c.Dim(); l++) { // apply the previous Givens rotations
+        const Long a = rot_idx[2*l+0], b = rot_idx[2*l+1];
+        const Real temp = rot_c[l] * h[a] + rot_s[l] * h[b];
+        h[b] = -rot_s[l] * h[a] + rot_c[l] * h[b];
+        h[a] = temp;
+      }
+      for (Long i = j+1; i < nv; i++) { // eliminate h[i]
+        if (h[i] == 0) continue;
+        const Real t = sqrt<Real>(h[j]*h[j] + h[i]*h[i]);
+        const Real c = h[j] / t, s = h[i] / t;
+        h[j] = t;
+        h[i] = 0;
+        for (Long l = 0; l < k; l++) {
+          const Real temp = c * rhs[j*k+l] + s * rhs[i*k+l];
+          rhs[i*k+l] = -s * rhs[j*k+l] + c * rhs[i*k+l];
+          rhs[j*k+l] = temp;
+        }
+        rot_idx.PushBack(j);
+        rot_idx.PushBack(i);
+        rot_c.PushBack(c);
+        rot_s.PushBack(s);
+      }
+      R_col.PushBack(Vector<Real>(j+1, h.begin(), false));
+    };
+
+    { // initial block from the QR of the residual
+      Matrix<Real> T;
+      const Vector<Real> r_norm = row_norms(R);
+      const Long nv0 = nv, p = append_block(T, R, r_norm);
+      for (Long q = 0; q < p; q++) {
+        for (Long l = 0; l < k; l++) rhs[(nv0+q)*k+l] = T[l][q];
+        Vector<Real> e(nv); e = 0;
+        e[nv0+q] = 1;
+        cand.PushBack(e);
+      }
+    }
+
+    Long iter = 0;
+    Vector<Real> res(k);
+    while (true) {
+      const Long m = R_col.Dim();
+      Vector<Long> active;
+      Real max_res = 0;
+      for (Long l = 0; l < k; l++) { // residual norm for each right-hand-side
+        Real res2 = 0;
+        for (Long i = m; i < nv; i++) res2 += rhs[i*k+l] * rhs[i*k+l];
+        res[l] = sqrt<Real>(res2);
+        max_res = std::max(max_res, res[l]);
+        if (res[l] > abs_tol[l]) active.PushBack(l);
+      }
+      if (verbose_ && !comm_.Rank()) printf("%3lld KSP Residual norm %.12e (block size %lld)\n", (long long)iter, (double)max_res, (long long)active.Dim());
+      if (!active.Dim() || iter >= max_iter_ || !cand.Dim()) break;
+
+      // Select the next block: the directions in span(cand) needed by the residuals of the active right-hand-sides
+      const Long ka = active.Dim(), pc = cand.Dim();
+      Matrix<Real> Z(nv, ka); // coefficients of the residuals in the Krylov basis
+      for (Long i = 0; i < nv; i++) {
+        for (Long l = 0; l < ka; l++) Z[i][l] = (i < m ? 0 : rhs[i*k+active[l]]);
+      }
+      for (Long l = rot_c.Dim()-1; l >= 0; l--) { // apply the inverse Givens rotations
+        const Long a = rot_idx[2*l+0], b = rot_idx[2*l+1];
+        for (Long i = 0; i < ka; i++) {
+          const Real temp = rot_c[l] * Z[a][i] - rot_s[l] * Z[b][i];
+          Z[b][i] = rot_s[l] * Z[a][i] + rot_c[l] * Z[b][i];
+          Z[a][i] = temp;
+        }
+      }
+      Matrix<Real> Zc(pc, std::max(pc, ka)); // projection onto the candidates, scaled by the tolerance (padded to get all left singular vectors)
+      Zc.SetZero();
+      for (Long q = 0; q < pc; q++) {
+        for (Long l = 0; l < ka; l++) {
+          Real sum = 0;
+          for (Long i = 0; i < cand[q].Dim(); i++) sum += cand[q][i] * Z[i][l];
+          Zc[q][l] = sum / std::max(abs_tol[active[l]], res[active[l]] * machine_eps<Real>());
+        }
+      }
+      Matrix<Real> tU, tS, tVT;
+      Zc.SVD(tU, tS, tVT);
+      if (tS[0][0] <= 0) break; // breakdown
+      Long r = 1;
+      while (r < pc && tS[r][r] > 1) r++;
+
+      Matrix<Real> D_coeff(r, nv); // the new directions
+      Vector<Vector<Real>> cand_(pc-r);
+      for (Long q = 0; q < pc-r; q++) {
+        cand_[q].ReInit(nv);
+        cand_[q] = 0;
+      }
+      D_coeff.SetZero();
+      for (Long q = 0; q < pc; q++) {
+        for (Long i = 0; i < cand[q].Dim(); i++) {
+          for (Long l = 0; l < r; l++) D_coeff[l][i] += tU[q][l] * cand[q][i];
+          for (Long l = r; l < pc; l++) cand_[l-r][i] += tU[q][l] * cand[q][i];
+        }
+      }
+      cand.Swap(cand_);
+
+      Matrix<Real> D(r, N), W;
+      Matrix<Real>::GEMM(D, D_coeff, Matrix<Real>(nv, N, V_mat.begin(), false));
+      A(&W, D);
+      iter++;
+      SCTL_ASSERT(W.Dim(0) == r && W.Dim(1) == N);
+
+      Matrix<Real> H, T;
+      const Vector<Real> w_norm0 = row_norms(W);
+      block_orthogonalize(H, W);
+      const Long nv0 = nv, p = append_block(T, W, w_norm0);
+      for (Long q = 0; q < p; q++) {
+        Vector<Real> e(nv); e = 0;
+        e[nv0+q] = 1;
+        cand.PushBack(e);
+      }
+      for (Long l = 0; l < r; l++) {
+        Vector<Real> h(nv);
+        for (Long i = 0; i < nv0; i++) h[i] = H[i][l];
+        for (Long q = 0; q < p; q++) h[nv0+q] = T[l][q];
+        add_column(h);
+        S.PushBack(Vector<Real>(nv0, D_coeff[l], false));
+      }
+    }
+
+    const Long m = R_col.Dim();
+    Matrix<Real> y(m, k); // y <-- inv(R) * rhs; (through back substitution)
+    for (Long i = 0; i < m; i++) {
+      for (Long l = 0; l < k; l++) y[i][l] = rhs[i*k+l];
+    }
+    for (Long i = m-1; i >= 0; i--) {
+      for (Long l = 0; l < k; l++) y[i][l] /= R_col[i][i];
+      for (Long j = 0; j < i; j++) {
+        for (Long l = 0; l < k; l++) y[j][l] -= y[i][l] * R_col[i][j];
+      }
+    }
+    Matrix<Real> Y_coeff(k, nv); // X <-- X + (y^t * S) * V
+    Y_coeff.SetZero();
+    for (Long i = 0; i < m; i++) {
+      for (Long l = 0; l < k; l++) {
+        for (Long j = 0; j < S[i].Dim(); j++) Y_coeff[l][j] += y[i][l] * S[i][j];
+      }
+    }
+    if (nv) Matrix<Real>::GEMM(*X, Y_coeff, Matrix<Real>(nv, N, V_mat.begin(), false), (Real)1);
+
+    Metrics::Record(Metric::GMRES_ITERATIONS, (double)iter);
+    if (solve_iter) (*solve_iter) = iter;
   }
 
   template <class Real> void GMRES<Real>::test(Long N) {
@@ -287,6 +828,40 @@ namespace sctl {
     };
     print_error(x);
     std::cout<<"GMRES iterations = "<<solve_iter<<'\n';
+
+    x.ReInit(0); // solve again with classical Gram-Schmidt (CGS2)
+    solver.SetOrthogonalization(GMRESOrthogonalization::CGS2);
+    solver(&x, LinOp, b, 1e-10, -1, false, &solve_iter);
+    print_error(x);
+    std::cout<<"GMRES (CGS2) iterations = "<<solve_iter<<'\n';
+
+    for (const auto ortho : {GMRESOrthogonalization::MGS, GMRESOrthogonalization::CGS2}) {
+      KrylovPrecond<Real> krylov_precond; // solve a sequence of perturbed systems with Krylov-subspace recycling
+      krylov_precond.SetRecycleRank(10);
+      solver.SetOrthogonalization(ortho);
+      for (Long k = 0; k < 3; k++) {
+        for (Long i = 0; i < N; i++) A[i][i] += (Real)0.01;
+        x.ReInit(0);
+        solver(&x, LinOp, b, 1e-10, -1, false, &solve_iter, &krylov_precond);
+        print_error(x);
+        std::cout<<"GMRES (recycled"<<(ortho == GMRESOrthogonalization::CGS2 ? ", CGS2" : "")<<") iterations = "<<solve_iter<<'\n';
+      }
+    }
+    solver.SetOrthogonalization(GMRESOrthogonalization::MGS);
+
+    Matrix<Real> B(3, N), X; // block GMRES with three right-hand-sides
+    for (auto& a : B) a = drand48();
+    auto BlockLinOp = [&A](Matrix<Real>* AX, const Matrix<Real>& X) {
+      AX->ReInit(X.Dim(0), X.Dim(1));
+      Matrix<Real>::GEMM(*AX, X, A.Transpose());
+    };
+    solver(&X, BlockLinOp, B, 1e-10, -1, false, &solve_iter);
+    Matrix<Real> AX;
+    BlockLinOp(&AX, X);
+    Real max_err = 0;
+    for (const auto& a : AX - B) max_err = std::max(max_err, fabs(a));
+    std::cout<<"Maximum error = "<<max_err<<'\n';
+    std::cout<<"Block GMRES iterations = "<<solve_iter<<'\n';
   }
 
 }  // end namespace
@@ -329,6 +904,39 @@ namespace sctl {
     return 0;
   }
 
+  template <class Real> struct PETScPrecondCtx {
+    const KrylovPrecond<Real>* krylov_precond;
+    const Comm* comm;
+  };
+
+  template <class Real> PetscErrorCode GMRESPrecond(PC pc, ::Vec x_, ::Vec Mx_) {
+    PetscErrorCode ierr;
+
+    PetscInt N;
+    VecGetLocalSize(x_, &N);
+
+    void* data = nullptr;
+    PCShellGetContext(pc, &data);
+    const auto& ctx = *(const PETScPrecondCtx<Real>*)data;
+
+    const PetscScalar* x_ptr;
+    ierr = VecGetArrayRead(x_, &x_ptr);
+    CHKERRQ(ierr);
+    Vector<Real> x(N);
+    for (Long i = 0; i < N; i++) x[i] = (Real)x_ptr[i];
+    ierr = VecRestoreArrayRead(x_, &x_ptr);
+    CHKERRQ(ierr);
+
+    ctx.krylov_precond->Apply(x, *ctx.comm);
+
+    PetscScalar* Mx_ptr;
+    ierr = VecGetArray(Mx_, &Mx_ptr);
+    CHKERRQ(ierr);
+    for (Long i = 0; i < N; i++) Mx_ptr[i] = x[i];
+    ierr = VecRestoreArray(Mx_, &Mx_ptr);
+    return ierr;
+  }
+
   inline PetscErrorCode MyKSPMonitor(KSP ksp, PetscInt n, PetscReal rnorm, void *dummy) {
     Comm* comm = (Comm*)dummy;
     if (!comm->Rank()) printf("%3lld KSP Residual norm %.12e\n", (long long)n, (double)rnorm);
@@ -341,7 +949,7 @@ namespace sctl {
     return 0;
   }
 
-  template <class Real> inline void PETScGMRES(Vector<Real>* x, const typename GMRES<Real>::ParallelOp& A, const Vector<Real>& b, const Real tol, Integer max_iter, const bool use_abs_tol, const bool verbose_, const Comm& comm_, Long* solve_iter) {
+  template <class Real> inline void PETScGMRES(Vector<Real>* x, const typename GMRES<Real>::ParallelOp& A, const Vector<Real>& b, const Real tol, Integer max_iter, const bool use_abs_tol, const bool verbose_, const Comm& comm_, Long* solve_iter, const GMRESOrthogonalization ortho, const KrylovPrecond<Real>* krylov_precond) {
     PetscInt N = b.Dim();
     if (max_iter < 0) { // set max_iter
       StaticArray<Long,2> NN{N,0};
@@ -393,12 +1001,28 @@ namespace sctl {
     ierr = KSPSetOperators(ksp, PetscA, PetscA);
     CHKERRABORT(comm, ierr);
 
+    PETScPrecondCtx<Real> precond_ctx{krylov_precond, &comm_};
+    if (krylov_precond) { // right preconditioner (as in GMRES::GenericGMRES)
+      PC pc;
+      ierr = KSPGetPC(ksp, &pc);
+      CHKERRABORT(comm, ierr);
+      PCSetType(pc, PCSHELL);
+      PCShellSetContext(pc, (void*)&precond_ctx);
+      PCShellSetApply(pc, GMRESPrecond<Real>);
+      KSPSetPCSide(ksp, PC_RIGHT);
+    }
+
     // Set runtime options
     KSPSetType(ksp, KSPGMRES);
     KSPSetNormType(ksp, KSP_NORM_UNPRECONDITIONED);
     if (use_abs_tol) KSPSetTolerances(ksp, PETSC_DEFAULT, tol, PETSC_DEFAULT, max_iter);
     else KSPSetTolerances(ksp, tol, PETSC_DEFAULT, PETSC_DEFAULT, max_iter);
-    KSPGMRESSetOrthogonalization(ksp, KSPGMRESModifiedGramSchmidtOrthogonalization);
+    if (ortho == GMRESOrthogonalization::CGS2) {
+      KSPGMRESSetOrthogonalization(ksp, KSPGMRESClassicalGramSchmidtOrthogonalization);
+      KSPGMRESSetCGSRefinementType(ksp, KSP_GMRES_CGS_REFINE_ALWAYS);
+    } else {
+      KSPGMRESSetOrthogonalization(ksp, KSPGMRESModifiedGramSchmidtOrthogonalization);
+    }
     if (verbose_) KSPMonitorSet(ksp, MyKSPMonitor, comm, nullptr);
     KSPGMRESSetRestart(ksp, max_iter);
     ierr = KSPSetFromOptions(ksp);
@@ -438,12 +1062,14 @@ namespace sctl {
     if (solve_iter) (*solve_iter) = its;
   }
 
-  template <> inline void GMRES<double>::operator()(Vector<double>* x, const ParallelOp& A, const Vector<double>& b, const double tol, const Integer max_iter, const bool use_abs_tol, Long* solve_iter, KrylovPrecond<Real>* krylov_precond) const {
-    PETScGMRES(x, A, b, tol, max_iter, use_abs_tol, verbose_, comm_, solve_iter);
+  template <> inline void GMRES<double>::operator()(Vector<double>* x, const ParallelOp& A, const Vector<double>& b, const double tol, const Integer max_iter, const bool use_abs_tol, Long* solve_iter, KrylovPrecond<double>* krylov_precond) const {
+    SCTL_ASSERT_MSG(!krylov_precond || krylov_precond->RecycleRank() <= 0, "GMRES: Krylov-subspace recycling is not supported with PETSc.");
+    PETScGMRES(x, A, b, tol, max_iter, use_abs_tol, verbose_, comm_, solve_iter, ortho_, krylov_precond);
   }
 
-  template <> inline void GMRES<float>::operator()(Vector<float>* x, const ParallelOp& A, const Vector<float>& b, const float tol, const Integer max_iter, const bool use_abs_tol, Long* solve_iter, KrylovPrecond<Real>* krylov_precond) const {
-    PETScGMRES(x, A, b, tol, max_iter, use_abs_tol, verbose_, comm_, solve_iter);
+  template <> inline void GMRES<float>::operator()(Vector<float>* x, const ParallelOp& A, const Vector<float>& b, const float tol, const Integer max_iter, const bool use_abs_tol, Long* solve_iter, KrylovPrecond<float>* krylov_precond) const {
+    SCTL_ASSERT_MSG(!krylov_precond || krylov_precond->RecycleRank() <= 0, "GMRES: Krylov-subspace recycling is not supported with PETSc.");
+    PETScGMRES(x, A, b, tol, max_iter, use_abs_tol, verbose_, comm_, solve_iter, ortho_, krylov_precond);
   }
 
 }  // end namespace
@@ -0,0 +1,151 @@
+#ifndef _SCTL_MAPPED_FILE_HPP_
+#define _SCTL_MAPPED_FILE_HPP_
+
+#include <stdio.h>                // for FILE
+#include <cstdint>                // for uint32_t, uint64_t
+#include <string>                 // for string
+#include <type_traits>            // for is_floating_point, is_integral
+
+#include "sctl/common.hpp"        // for Long, Integer, sctl
+#include "sctl/static-array.hpp"  // for StaticArray
+
+namespace sctl {
+
+template <class ValueType> class Vector;
+template <class ValueType> class Matrix;
+
+namespace mapped_file_detail {
+
+  /**
+   * Header of the binary file format used by Vector::Write and Matrix::Write. It is followed by the data (starting at
+   * byte offset `data_offset`) in row-major order. The header size is a multiple of 64 bytes so that the data is
+   * aligned when the file is memory mapped.
+   *
+   * Files in the legacy format (`uint64 dim0, dim1` followed by the data) are still accepted by Read and MappedFile. As
+   * before, any bytes after the data are ignored.
+   */
+  struct FileHeader {
+    char magic[8];          ///< "SCTL-BIN"
+    uint32_t version;       ///< Format version.
+    uint32_t endian;        ///< 0x01020304 in the byte order of the machine that wrote the file.
+    uint32_t type_kind;     ///< 1: signed integer, 2: unsigned integer, 3: floating point, 0: other.
+    uint32_t type_size;     ///< sizeof the element type.
+    uint64_t dim[2];        ///< Dimensions (dim[1] = 1 for Vector).
+    uint64_t data_offset;   ///< Byte offset of the data.
+    char reserved[16];
+  };
+  static_assert(sizeof(FileHeader) == 64, "Unexpected FileHeader size.");
+
+  static constexpr uint32_t VERSION = 1;
+  static constexpr uint32_t ENDIAN_TAG = 0x01020304;
+
+  template <class ValueType> constexpr uint32_t TypeKind() {
+    return std::is_floating_point<ValueType>::value ? 3 : (std::is_integral<ValueType>::value ? (std::is_signed<ValueType>::value ? 1 : 2) : 0);
+  }
+
+  /**
+   * Write the file header for an array of ValueType with the given dimensions.
+   */
+  template <class ValueType> bool WriteHeader(FILE* f, Long dim0, Long dim1);
+
+  /**
+   * Read the file header (new or legacy format) and check that it matches ValueType. On success, the file position is
+   * at the start of the data and the dimensions and data offset are returned. Otherwise, an error message is printed.
+   */
+  template <class ValueType> bool ReadHeader(FILE* f, StaticArray<Long,2>& dim, Long& data_offset, const char* fname);
+
+}
+
+/**
+ * Read-only memory mapping of a file written by Vector::Write or Matrix::Write. The file is mapped with
+ * `mmap(PROT_READ, MAP_SHARED)`, therefore pages are loaded lazily on first access and all processes on a node that
+ * map the same file share the same physical pages (from the page cache). This is useful for large precomputed tables
+ * which would otherwise be read and duplicated in memory by every MPI rank.
+ *
+ * The mapped data can be accessed through constant, non-owning Vector and Matrix objects (as constructed with
+ * `own_data=false`). These must not be used after the MappedFile is closed or destroyed.
+ *
+ * @code
+ * MappedFile file("K_self.mat");
+ * const Matrix<double> M = file.MatrixView<double>(); // M.Dim(0) x M.Dim(1), data read from disk on demand
+ * @endcode
+ */
+class MappedFile {
+ public:
+  /**
+   * Default constructor.
+   */
+  MappedFile();
+
+  /**
+   * Construct and map the file (see Open).
+   *
+   * @param fname File name.
+   */
+  explicit MappedFile(const std::string& fname);
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /**
+   * Destructor (unmaps the file).
+   */
+  ~MappedFile();
+
+  /**
+   * Map a file written by Vector::Write or Matrix::Write. Any previously mapped file is closed.
+   *
+   * @param fname File name.
+   * @return True on success, false otherwise (an error message is printed).
+   */
+  bool Open(const std::string& fname);
+
+  /**
+   * Unmap the file.
+   */
+  void Close();
+
+  /**
+   * @return True if a file is currently mapped.
+   */
+  bool IsOpen() const;
+
+  /**
+   * Get the dimensions of the array stored in the file.
+   *
+   * @param i Dimension index (0 or 1).
+   * @return The i-th dimension.
+   */
+  Long Dim(Integer i) const;
+
+  /**
+   * Get a read-only, non-owning view of the mapped data as a vector of size Dim(0)*Dim(1). The element type must match
+   * the type that the file was written with.
+   *
+   * @return Constant vector referencing the mapped data (copying it makes an owned copy of the data).
+   */
+  template <class ValueType> const Vector<ValueType> VectorView() const;
+
+  /**
+   * Get a read-only, non-owning view of the mapped data as a Dim(0) x Dim(1) matrix. The element type must match the
+   * type that the file was written with.
+   *
+   * @return Constant matrix referencing the mapped data (copying it makes an owned copy of the data).
+   */
+  template <class ValueType> const Matrix<ValueType> MatrixView() const;
+
+ private:
+
+  template <class ValueType> const ValueType* Data() const;
+
+  std::string fname_;
+  void* addr_;
+  Long len_;
+  StaticArray<Long,2> dim_;
+  Long data_offset_;
+  uint32_t type_kind_, type_size_;
+};
+
+}
+
+#endif // _SCTL_MAPPED_FILE_HPP_
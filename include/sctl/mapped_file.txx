@@ -0,0 +1,199 @@
+#ifndef _SCTL_MAPPED_FILE_TXX_
+#define _SCTL_MAPPED_FILE_TXX_
+
+#include <fcntl.h>                // for open, O_RDONLY
+#include <stdio.h>                // for fwrite, fread, fseek, ftell, FILE
+#include <sys/mman.h>             // for mmap, munmap, PROT_READ, MAP_SHARED
+#include <sys/stat.h>             // for fstat, stat
+#include <unistd.h>               // for close
+#include <algorithm>              // for min
+#include <cstdint>                // for uint32_t, uint64_t
+#include <cstring>                // for memcpy, memset
+#include <iostream>               // for basic_ostream, operator<<, cout
+#include <string>                 // for string
+
+#include "sctl/common.hpp"        // for Long, Integer, SCTL_ASSERT_MSG, sctl
+#include "sctl/mapped_file.hpp"   // for MappedFile, FileHeader
+#include "sctl/iterator.hpp"      // for Iterator
+#include "sctl/iterator.txx"      // for Ptr2Itr
+#include "sctl/matrix.hpp"        // for Matrix
+#include "sctl/static-array.hpp"  // for StaticArray
+#include "sctl/static-array.txx"  // for StaticArray::operator[]
+#include "sctl/vector.hpp"        // for Vector
+
+namespace sctl {
+
+namespace mapped_file_detail {
+
+  template <class ValueType> bool WriteHeader(FILE* f, Long dim0, Long dim1) {
+    FileHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, "SCTL-BIN", 8);
+    h.version = VERSION;
+    h.endian = ENDIAN_TAG;
+    h.type_kind = TypeKind<ValueType>();
+    h.type_size = (uint32_t)sizeof(ValueType);
+    h.dim[0] = (uint64_t)dim0;
+    h.dim[1] = (uint64_t)dim1;
+    h.data_offset = sizeof(FileHeader);
+    return fwrite(&h, sizeof(FileHeader), 1, f) == 1;
+  }
+
+  /**
+   * Parse the header from the first buf_len bytes of a file of size file_len. For the legacy format, type_size is set
+   * to zero (the element type is unknown).
+   */
+  inline bool ParseHeader(const char* buf, Long buf_len, Long file_len, StaticArray<Long,2>& dim, Long& data_offset, uint32_t& type_kind, uint32_t& type_size, const char* fname) {
+    if (buf_len >= (Long)sizeof(FileHeader) && !std::memcmp(buf, "SCTL-BIN", 8)) {
+      FileHeader h;
+      std::memcpy(&h, buf, sizeof(FileHeader));
+      if (h.endian != ENDIAN_TAG) {
+        std::cout << "File written with a different byte order: " << fname << '\n';
+        return false;
+      }
+      if (h.version > VERSION) {
+        std::cout << "Unsupported file format version " << h.version << ": " << fname << '\n';
+        return false;
+      }
+      dim[0] = (Long)h.dim[0];
+      dim[1] = (Long)h.dim[1];
+      data_offset = (Long)h.data_offset;
+      type_kind = h.type_kind;
+      type_size = h.type_size;
+    } else if (buf_len >= 2 * (Long)sizeof(uint64_t)) { // legacy format
+      uint64_t dim_[2];
+      std::memcpy(dim_, buf, sizeof(dim_));
+      dim[0] = (Long)dim_[0];
+      dim[1] = (Long)dim_[1];
+      data_offset = sizeof(dim_);
+      type_kind = 0;
+      type_size = 0;
+    } else {
+      std::cout << "Reading file failed: " << fname << '\n';
+      return false;
+    }
+    if (dim[0] < 0 || dim[1] < 0 || data_offset > file_len) {
+      std::cout << "Reading file failed: " << fname << '\n';
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Check that the data in the file (as described by the header) can be read as an array of ValueType.
+   */
+  template <class ValueType> bool CheckType(const StaticArray<Long,2>& dim, Long data_offset, uint32_t type_kind, uint32_t type_size, Long file_len, const char* fname) {
+    const Long N = dim[0] * dim[1];
+    if (type_size && (type_kind != TypeKind<ValueType>() || type_size != sizeof(ValueType))) { // (unknown for the legacy format)
+      std::cout << "Reading file failed (type mismatch): " << fname << '\n';
+      return false;
+    }
+    if (file_len < data_offset + N * (Long)sizeof(ValueType)) { // trailing bytes are ignored (as in the legacy reader)
+      std::cout << "Reading file failed (truncated): " << fname << '\n';
+      return false;
+    }
+    return true;
+  }
+
+  template <class ValueType> bool ReadHeader(FILE* f, StaticArray<Long,2>& dim, Long& data_offset, const char* fname) {
+    if (fseek(f, 0, SEEK_END)) return false;
+    const Long file_len = (Long)ftell(f);
+    if (fseek(f, 0, SEEK_SET)) return false;
+
+    char buf[sizeof(FileHeader)];
+    const Long buf_len = (Long)fread(buf, 1, sizeof(FileHeader), f);
+    uint32_t type_kind, type_size;
+    if (!ParseHeader(buf, buf_len, file_len, dim, data_offset, type_kind, type_size, fname)) return false;
+    if (!CheckType<ValueType>(dim, data_offset, type_kind, type_size, file_len, fname)) return false;
+    return !fseek(f, (long)data_offset, SEEK_SET);
+  }
+
+}
+
+inline MappedFile::MappedFile() : addr_(nullptr), len_(0), data_offset_(0), type_kind_(0), type_size_(0) {
+  dim_[0] = 0;
+  dim_[1] = 0;
+}
+
+inline MappedFile::MappedFile(const std::string& fname) : MappedFile() {
+  Open(fname);
+}
+
+inline MappedFile::~MappedFile() {
+  Close();
+}
+
+inline bool MappedFile::Open(const std::string& fname) {
+  Close();
+  const int fd = open(fname.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::cout << "Unable to open file for reading: " << fname << '\n';
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) || st.st_size <= 0) {
+    std::cout << "Reading file failed: " << fname << '\n';
+    close(fd);
+    return false;
+  }
+  void* addr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd); // the mapping remains valid
+  if (addr == MAP_FAILED) {
+    std::cout << "Unable to map file: " << fname << '\n';
+    return false;
+  }
+
+  const Long len = (Long)st.st_size;
+  if (!mapped_file_detail::ParseHeader((const char*)addr, std::min<Long>(len, sizeof(mapped_file_detail::FileHeader)), len, dim_, data_offset_, type_kind_, type_size_, fname.c_str())) {
+    munmap(addr, (size_t)len);
+    dim_[0] = 0;
+    dim_[1] = 0;
+    return false;
+  }
+  fname_ = fname;
+  addr_ = addr;
+  len_ = len;
+  return true;
+}
+
+inline void MappedFile::Close() {
+  if (addr_) munmap(addr_, (size_t)len_);
+  fname_.clear();
+  addr_ = nullptr;
+  len_ = 0;
+  dim_[0] = 0;
+  dim_[1] = 0;
+  data_offset_ = 0;
+  type_kind_ = 0;
+  type_size_ = 0;
+}
+
+inline bool MappedFile::IsOpen() const {
+  return addr_ != nullptr;
+}
+
+inline Long MappedFile::Dim(Integer i) const {
+  return dim_[i];
+}
+
+template <class ValueType> const ValueType* MappedFile::Data() const {
+  SCTL_ASSERT_MSG(IsOpen(), "No file is mapped.");
+  SCTL_ASSERT_MSG((mapped_file_detail::CheckType<ValueType>(dim_, data_offset_, type_kind_, type_size_, len_, fname_.c_str())), "Element type does not match the mapped file.");
+  return (const ValueType*)((const char*)addr_ + data_offset_);
+}
+
+template <class ValueType> const Vector<ValueType> MappedFile::VectorView() const {
+  const Long N = dim_[0] * dim_[1];
+  const ValueType* ptr = Data<ValueType>();
+  return Vector<ValueType>(N, (N ? Ptr2Itr<ValueType>((ValueType*)ptr, N) : NullIterator<ValueType>()), false);
+}
+
+template <class ValueType> const Matrix<ValueType> MappedFile::MatrixView() const {
+  const Long N = dim_[0] * dim_[1];
+  const ValueType* ptr = Data<ValueType>();
+  return Matrix<ValueType>(dim_[0], dim_[1], (N ? Ptr2Itr<ValueType>((ValueType*)ptr, N) : NullIterator<ValueType>()), false);
+}
+
+}
+
+#endif // _SCTL_MAPPED_FILE_TXX_
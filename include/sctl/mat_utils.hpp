@@ -6,8 +6,25 @@
 namespace sctl {
 namespace mat {
 
+/**
+ * General matrix-matrix product C = alpha * op(A) * op(B) + beta * C with the BLAS interface (column-major). Uses
+ * BLAS (when SCTL_HAVE_BLAS is defined) for float and double, except for small products (M*N*K up to
+ * SCTL_GEMM_NATIVE_MAX) where the call overhead dominates; otherwise uses gemm_native.
+ */
 template <class ValueType> void gemm(char TransA, char TransB, int M, int N, int K, ValueType alpha, Iterator<ValueType> A, int lda, Iterator<ValueType> B, int ldb, ValueType beta, Iterator<ValueType> C, int ldc);
 
+/**
+ * Native GEMM (same interface as gemm) with packed operands and a register-blocked SIMD micro-kernel built on Vec.
+ * Large products (M*N*K above SCTL_GEMM_PARALLEL_MIN) are split between OpenMP threads.
+ */
+template <class ValueType> void gemm_native(char TransA, char TransB, int M, int N, int K, ValueType alpha, Iterator<ValueType> A, int lda, Iterator<ValueType> B, int ldb, ValueType beta, Iterator<ValueType> C, int ldc);
+
+/**
+ * Product of small matrices with compile-time dimensions C = A * B, where A is M x K, B is K x N and C is M x N, all
+ * in row-major order (e.g. the data of StaticArray or Tensor objects).
+ */
+template <Long M, Long N, Long K, class ValueType> void gemm_small(ConstIterator<ValueType> A, ConstIterator<ValueType> B, Iterator<ValueType> C);
+
 template <class ValueType> void svd(char *JOBU, char *JOBVT, int *M, int *N, Iterator<ValueType> A, int *LDA, Iterator<ValueType> S, Iterator<ValueType> U, int *LDU, Iterator<ValueType> VT, int *LDVT, Iterator<ValueType> WORK, int *LWORK, int *INFO);
 
 /**
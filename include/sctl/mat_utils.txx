@@ -3,6 +3,7 @@
 
 #include <algorithm>              // for max, min
 #include <cassert>                // for assert
+#include <omp.h>                  // for omp_get_max_threads
 #include <iostream>               // for basic_ostream, cout, operator<<
 #include <vector>                 // for vector
 
@@ -16,6 +17,8 @@
 #include "sctl/mem_mgr.txx"       // for aligned_delete, aligned_new
 #include "sctl/static-array.hpp"  // for StaticArray
 #include "sctl/static-array.txx"  // for StaticArray::operator[]
+#include "sctl/vec.hpp"           // for Vec, DefaultVecLen, FMA
+#include "sctl/vec.txx"           // for Vec::Load, Vec::Store
 
 #if defined(SCTL_HAVE_BLAS)
 #include "sctl/blas.h"
@@ -27,60 +30,224 @@
 namespace sctl {
 namespace mat {
 
-template <class ValueType> inline void gemm(char TransA, char TransB, int M, int N, int K, ValueType alpha, Iterator<ValueType> A, int lda, Iterator<ValueType> B, int ldb, ValueType beta, Iterator<ValueType> C, int ldc) {
-  if ((TransA == 'N' || TransA == 'n') && (TransB == 'N' || TransB == 'n')) {
-    #pragma omp parallel for schedule(static)
-    for (Long n = 0; n < N; n++) {    // Columns of C
-      for (Long m = 0; m < M; m++) {  // Rows of C
-        ValueType AxB = 0;
-        for (Long k = 0; k < K; k++) {
-          AxB += A[m + lda * k] * B[k + ldb * n];
+namespace gemm_detail {
+
+  /**
+   * Register block sizes (MR x NR) and cache block sizes for the native GEMM. The micro-kernel keeps an MR x NR block
+   * of C in NR*MR/VecLen vector registers; blocks of op(A) (MC x KC) and op(B) (KC x NC) are packed into contiguous
+   * micro-panels of MR rows and NR columns respectively.
+   */
+  template <class ValueType> struct Params {
+    static constexpr Integer VecLen = DefaultVecLen<ValueType>();
+    static constexpr Integer MR = 2 * VecLen;
+    static constexpr Integer NR = 4;
+    static constexpr Long KC = 256;
+    static constexpr Long MC = MR * (64 / MR + 1);
+    static constexpr Long NC = NR * 256;
+  };
+
+  template <class ValueType> inline ValueType GetElem(bool trans, ConstIterator<ValueType> A, Long lda, Long i, Long j) { // element (i,j) of op(A)
+    return trans ? A[j + lda * i] : A[i + lda * j];
+  }
+
+  /**
+   * Pack the block op(A)[m0:m0+mc, k0:k0+kc] into micro-panels of MR rows (zero padded).
+   */
+  template <class ValueType> void PackA(Iterator<ValueType> Apack, bool trans, ConstIterator<ValueType> A, Long lda, Long m0, Long mc, Long k0, Long kc) {
+    constexpr Integer MR = Params<ValueType>::MR;
+    for (Long i = 0; i < mc; i += MR) {
+      const Long m = std::min<Long>(MR, mc - i);
+      Iterator<ValueType> P = Apack + i * kc;
+      if (!trans && m == MR) {
+        for (Long k = 0; k < kc; k++) {
+          ConstIterator<ValueType> A_ = A + (m0 + i) + lda * (k0 + k);
+          for (Integer r = 0; r < MR; r++) P[k * MR + r] = A_[r];
+        }
+      } else {
+        for (Long k = 0; k < kc; k++) {
+          for (Integer r = 0; r < MR; r++) P[k * MR + r] = (r < m ? GetElem(trans, A, lda, m0 + i + r, k0 + k) : (ValueType)0);
         }
-        C[m + ldc * n] = alpha * AxB + (beta == 0 ? 0 : beta * C[m + ldc * n]);
       }
     }
-  } else if (TransA == 'N' || TransA == 'n') {
-    #pragma omp parallel for schedule(static)
-    for (Long n = 0; n < N; n++) {    // Columns of C
-      for (Long m = 0; m < M; m++) {  // Rows of C
-        ValueType AxB = 0;
-        for (Long k = 0; k < K; k++) {
-          AxB += A[m + lda * k] * B[n + ldb * k];
-        }
-        C[m + ldc * n] = alpha * AxB + (beta == 0 ? 0 : beta * C[m + ldc * n]);
+  }
+
+  /**
+   * Pack the block op(B)[k0:k0+kc, n0:n0+nc] into micro-panels of NR columns (zero padded).
+   */
+  template <class ValueType> void PackB(Iterator<ValueType> Bpack, bool trans, ConstIterator<ValueType> B, Long ldb, Long k0, Long kc, Long n0, Long nc) {
+    constexpr Integer NR = Params<ValueType>::NR;
+    for (Long j = 0; j < nc; j += NR) {
+      const Long n = std::min<Long>(NR, nc - j);
+      Iterator<ValueType> P = Bpack + j * kc;
+      for (Long k = 0; k < kc; k++) {
+        for (Integer c = 0; c < NR; c++) P[k * NR + c] = (c < n ? GetElem(trans, B, ldb, k0 + k, n0 + j + c) : (ValueType)0);
+      }
+    }
+  }
+
+  /**
+   * C[0:m, 0:n] = alpha * Apanel * Bpanel + beta * C[0:m, 0:n], where Apanel is MR x kc and Bpanel is kc x NR.
+   */
+  template <class ValueType> inline void MicroKernel(Long kc, ConstIterator<ValueType> Apack, ConstIterator<ValueType> Bpack, ValueType alpha, ValueType beta, Iterator<ValueType> C, Long ldc, Long m, Long n) {
+    constexpr Integer VecLen = Params<ValueType>::VecLen;
+    constexpr Integer MR = Params<ValueType>::MR;
+    constexpr Integer NR = Params<ValueType>::NR;
+    constexpr Integer MV = MR / VecLen;
+    using VecType = Vec<ValueType, VecLen>;
+
+    const ValueType* A = &Apack[0];
+    const ValueType* B = &Bpack[0];
+    VecType acc[NR][MV];
+    for (Integer c = 0; c < NR; c++) {
+      for (Integer i = 0; i < MV; i++) acc[c][i] = VecType::Zero();
+    }
+    for (Long k = 0; k < kc; k++) {
+      VecType a[MV];
+      for (Integer i = 0; i < MV; i++) a[i] = VecType::LoadAligned(A + k * MR + i * VecLen);
+      for (Integer c = 0; c < NR; c++) {
+        const VecType b = VecType::Load1(B + k * NR + c);
+        for (Integer i = 0; i < MV; i++) acc[c][i] = FMA(a[i], b, acc[c][i]);
       }
     }
-  } else if (TransB == 'N' || TransB == 'n') {
-    #pragma omp parallel for schedule(static)
-    for (Long n = 0; n < N; n++) {    // Columns of C
-      for (Long m = 0; m < M; m++) {  // Rows of C
-        ValueType AxB = 0;
-        for (Long k = 0; k < K; k++) {
-          AxB += A[k + lda * m] * B[k + ldb * n];
+
+    const VecType alpha_(alpha), beta_(beta);
+    if (m == MR && n == NR) {
+      for (Integer c = 0; c < NR; c++) {
+        ValueType* C_ = &C[ldc * c];
+        for (Integer i = 0; i < MV; i++) {
+          if (beta == 0) (acc[c][i] * alpha_).Store(C_ + i * VecLen);
+          else FMA(acc[c][i], alpha_, VecType::Load(C_ + i * VecLen) * beta_).Store(C_ + i * VecLen);
+        }
+      }
+    } else { // edge block
+      alignas(sizeof(VecType)) ValueType tmp[NR * MR];
+      for (Integer c = 0; c < NR; c++) {
+        for (Integer i = 0; i < MV; i++) acc[c][i].StoreAligned(tmp + c * MR + i * VecLen);
+      }
+      for (Long c = 0; c < n; c++) {
+        for (Long r = 0; r < m; r++) {
+          ValueType& Crc = C[r + ldc * c];
+          Crc = alpha * tmp[c * MR + r] + (beta == 0 ? (ValueType)0 : beta * Crc);
         }
-        C[m + ldc * n] = alpha * AxB + (beta == 0 ? 0 : beta * C[m + ldc * n]);
       }
     }
-  } else {
-    #pragma omp parallel for schedule(static)
-    for (Long n = 0; n < N; n++) {    // Columns of C
-      for (Long m = 0; m < M; m++) {  // Rows of C
-        ValueType AxB = 0;
-        for (Long k = 0; k < K; k++) {
-          AxB += A[k + lda * m] * B[n + ldb * k];
+  }
+
+  template <class ValueType> void GemmSerial(bool transA, bool transB, Long M, Long N, Long K, ValueType alpha, ConstIterator<ValueType> A, Long lda, ConstIterator<ValueType> B, Long ldb, ValueType beta, Iterator<ValueType> C, Long ldc) {
+    using P = Params<ValueType>;
+    const Long MR = P::MR, NR = P::NR, KC = P::KC, MC = P::MC, NC = P::NC;
+    const Long kc_max = std::min<Long>(KC, K);
+    const Long mc_max = std::min<Long>(MC, ((M + MR - 1) / MR) * MR);
+    const Long nc_max = std::min<Long>(NC, ((N + NR - 1) / NR) * NR);
+    constexpr Long STACK_BUFF = 16384 / sizeof(ValueType); // use stack buffers for small products
+    alignas(SCTL_MEM_ALIGN) ValueType buff[2 * STACK_BUFF];
+    const bool use_stack = (mc_max * kc_max <= STACK_BUFF && nc_max * kc_max <= STACK_BUFF);
+    Iterator<ValueType> Apack = (use_stack ? Ptr2Itr<ValueType>(buff, STACK_BUFF) : aligned_new<ValueType>(mc_max * kc_max));
+    Iterator<ValueType> Bpack = (use_stack ? Ptr2Itr<ValueType>(buff + STACK_BUFF, STACK_BUFF) : aligned_new<ValueType>(nc_max * kc_max));
+
+    for (Long n0 = 0; n0 < N; n0 += NC) {
+      const Long nc = std::min<Long>(NC, N - n0);
+      for (Long k0 = 0; k0 < K; k0 += KC) {
+        const Long kc = std::min<Long>(KC, K - k0);
+        const ValueType beta_ = (k0 == 0 ? beta : (ValueType)1);
+        PackB(Bpack, transB, B, ldb, k0, kc, n0, nc);
+        for (Long m0 = 0; m0 < M; m0 += MC) {
+          const Long mc = std::min<Long>(MC, M - m0);
+          PackA(Apack, transA, A, lda, m0, mc, k0, kc);
+          for (Long j = 0; j < nc; j += NR) {
+            for (Long i = 0; i < mc; i += MR) {
+              MicroKernel<ValueType>(kc, Apack + i * kc, Bpack + j * kc, alpha, beta_, C + (m0 + i) + ldc * (n0 + j), ldc, std::min<Long>(MR, mc - i), std::min<Long>(NR, nc - j));
+            }
+          }
         }
-        C[m + ldc * n] = alpha * AxB + (beta == 0 ? 0 : beta * C[m + ldc * n]);
       }
     }
+
+    if (!use_stack) {
+      aligned_delete<ValueType>(Bpack);
+      aligned_delete<ValueType>(Apack);
+    }
+  }
+
+}  // end namespace gemm_detail
+
+template <class ValueType> inline void gemm_native(char TransA, char TransB, int M, int N, int K, ValueType alpha, Iterator<ValueType> A, int lda, Iterator<ValueType> B, int ldb, ValueType beta, Iterator<ValueType> C, int ldc) {
+  using P = gemm_detail::Params<ValueType>;
+  const bool transA = !(TransA == 'N' || TransA == 'n');
+  const bool transB = !(TransB == 'N' || TransB == 'n');
+  if (M <= 0 || N <= 0) return;
+  if (K <= 0 || alpha == 0) { // C = beta * C
+    for (Long n = 0; n < N; n++) {
+      for (Long m = 0; m < M; m++) C[m + ldc * (Long)n] = (beta == 0 ? (ValueType)0 : beta * C[m + ldc * (Long)n]);
+    }
+    return;
+  }
+
+  // Split the larger of the M and N dimensions between threads (for large products)
+  const Long work = (Long)M * (Long)N * (Long)K;
+  const Integer omp_p = (work > SCTL_GEMM_PARALLEL_MIN ? omp_get_max_threads() : 1);
+  if (omp_p == 1) {
+    gemm_detail::GemmSerial<ValueType>(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+    return;
+  }
+  const bool split_n = (N >= M);
+  const Long chunk = (split_n ? (Long)P::NR : (Long)P::MR);
+  const Long Nchunks = ((split_n ? N : M) + chunk - 1) / chunk;
+  #pragma omp parallel for schedule(static)
+  for (Integer tid = 0; tid < omp_p; tid++) {
+    const Long a = std::min<Long>((tid + 0) * Nchunks / omp_p * chunk, split_n ? N : M);
+    const Long b = std::min<Long>((tid + 1) * Nchunks / omp_p * chunk, split_n ? N : M);
+    if (a >= b) continue;
+    if (split_n) {
+      const Iterator<ValueType> B_ = B + (transB ? a : a * (Long)ldb);
+      gemm_detail::GemmSerial<ValueType>(transA, transB, M, b - a, K, alpha, A, lda, B_, ldb, beta, C + a * (Long)ldc, ldc);
+    } else {
+      const Iterator<ValueType> A_ = A + (transA ? a * (Long)lda : a);
+      gemm_detail::GemmSerial<ValueType>(transA, transB, b - a, N, K, alpha, A_, lda, B, ldb, beta, C + a, ldc);
+    }
   }
 }
 
+template <class ValueType> inline void gemm(char TransA, char TransB, int M, int N, int K, ValueType alpha, Iterator<ValueType> A, int lda, Iterator<ValueType> B, int ldb, ValueType beta, Iterator<ValueType> C, int ldc) {
+  gemm_native<ValueType>(TransA, TransB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
 #if defined(SCTL_HAVE_BLAS)
-template <> inline void gemm<float>(char TransA, char TransB, int M, int N, int K, float alpha, Iterator<float> A, int lda, Iterator<float> B, int ldb, float beta, Iterator<float> C, int ldc) { sgemm_(&TransA, &TransB, &M, &N, &K, &alpha, &A[0], &lda, &B[0], &ldb, &beta, &C[0], &ldc); }
+template <> inline void gemm<float>(char TransA, char TransB, int M, int N, int K, float alpha, Iterator<float> A, int lda, Iterator<float> B, int ldb, float beta, Iterator<float> C, int ldc) {
+  if ((Long)M * (Long)N * (Long)K <= SCTL_GEMM_NATIVE_MAX) gemm_native<float>(TransA, TransB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+  else sgemm_(&TransA, &TransB, &M, &N, &K, &alpha, &A[0], &lda, &B[0], &ldb, &beta, &C[0], &ldc);
+}
 
-template <> inline void gemm<double>(char TransA, char TransB, int M, int N, int K, double alpha, Iterator<double> A, int lda, Iterator<double> B, int ldb, double beta, Iterator<double> C, int ldc) { dgemm_(&TransA, &TransB, &M, &N, &K, &alpha, &A[0], &lda, &B[0], &ldb, &beta, &C[0], &ldc); }
+template <> inline void gemm<double>(char TransA, char TransB, int M, int N, int K, double alpha, Iterator<double> A, int lda, Iterator<double> B, int ldb, double beta, Iterator<double> C, int ldc) {
+  if ((Long)M * (Long)N * (Long)K <= SCTL_GEMM_NATIVE_MAX) gemm_native<double>(TransA, TransB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+  else dgemm_(&TransA, &TransB, &M, &N, &K, &alpha, &A[0], &lda, &B[0], &ldb, &beta, &C[0], &ldc);
+}
 #endif
 
+template <Long M, Long N, Long K, class ValueType> inline void gemm_small(ConstIterator<ValueType> A_, ConstIterator<ValueType> B_, Iterator<ValueType> C_) {
+  constexpr Integer VecLen = DefaultVecLen<ValueType>();
+  constexpr Long NV = N / VecLen; // full vectors in each row of C
+  constexpr Long N0 = NV * VecLen;
+  using VecType = Vec<ValueType, VecLen>;
+
+  const ValueType* A = &A_[0];
+  const ValueType* B = &B_[0];
+  ValueType* C = &C_[0];
+  for (Long i = 0; i < M; i++) {
+    VecType c[NV > 0 ? NV : 1];
+    ValueType c_[N - N0 > 0 ? N - N0 : 1];
+    for (Long j = 0; j < NV; j++) c[j] = VecType::Zero();
+    for (Long j = 0; j < N - N0; j++) c_[j] = 0;
+    for (Long k = 0; k < K; k++) {
+      const VecType a(A[i * K + k]);
+      for (Long j = 0; j < NV; j++) c[j] = FMA(a, VecType::Load(B + k * N + j * VecLen), c[j]);
+      for (Long j = 0; j < N - N0; j++) c_[j] += A[i * K + k] * B[k * N + N0 + j];
+    }
+    for (Long j = 0; j < NV; j++) c[j].Store(C + i * N + j * VecLen);
+    for (Long j = 0; j < N - N0; j++) C[i * N + N0 + j] = c_[j];
+  }
+}
+
 //#define SCTL_SVD_DEBUG
 
 template <class ValueType> static inline void GivensL(Iterator<ValueType> S_, const StaticArray<Long, 2> &dim, Long m, ValueType a, ValueType b) {
@@ -11,6 +11,7 @@
 namespace sctl {
 
 template <class ValueType> class Permutation;
+class MemoryArena;
 
 /**
  * Class representing a matrix. The data is stored in row-major order.  It can optionally make use
@@ -44,6 +45,16 @@ template <class ValueType> class Matrix {
    */
   Matrix(Long dim1, Long dim2, Iterator<ValueType> data_ = NullIterator<ValueType>(), bool own_data_ = true);
 
+  /**
+   * Constructor to create a matrix with memory allocated from a MemoryArena. Subsequent reallocations (ReInit)
+   * also use the arena, therefore the matrix must not be used after the enclosing MemoryArena::Scope ends.
+   *
+   * @param dim1 Number of rows in the matrix.
+   * @param dim2 Number of columns in the matrix.
+   * @param arena MemoryArena to allocate from.
+   */
+  Matrix(Long dim1, Long dim2, MemoryArena& arena);
+
   /**
    * Copy constructor.
    *
@@ -385,11 +396,12 @@ template <class ValueType> class Matrix {
   Matrix<ValueType> pinv(ValueType eps = -1);
 
  private:
-  void Init(Long dim1, Long dim2, Iterator<ValueType> data_ = NullIterator<ValueType>(), bool own_data_ = true);
+  void Init(Long dim1, Long dim2, Iterator<ValueType> data_ = NullIterator<ValueType>(), bool own_data_ = true, MemoryArena* arena_ = nullptr);
 
   StaticArray<Long, 2> dim; ///< Dimensions of the matrix.
   Iterator<ValueType> data_ptr; ///< Pointer to the data of the matrix.
   bool own_data; ///< Flag indicating ownership of the data.
+  MemoryArena* arena; ///< MemoryArena used for allocations (or nullptr).
 };
 
 /**
@@ -14,6 +14,7 @@
 #include "sctl/matrix.hpp"        // for Matrix, operator<<
 #include "sctl/iterator.hpp"      // for Iterator, ConstIterator
 #include "sctl/iterator.txx"      // for Iterator::Iterator<ValueType>, Iter...
+#include "sctl/mapped_file.txx"   // for mapped_file_detail::WriteHeader, ReadHeader
 #include "sctl/mat_utils.txx"     // for gemm, svd, pinv
 #include "sctl/math_utils.hpp"    // for fabs, sqrt
 #include "sctl/math_utils.txx"    // for machine_eps
@@ -41,15 +42,18 @@ template <class ValueType> std::ostream& operator<<(std::ostream& output, const
   return output;
 }
 
-template <class ValueType> void Matrix<ValueType>::Init(Long dim1, Long dim2, Iterator<ValueType> data_, bool own_data_) {
+template <class ValueType> void Matrix<ValueType>::Init(Long dim1, Long dim2, Iterator<ValueType> data_, bool own_data_, MemoryArena* arena_) {
   dim[0] = dim1;
   dim[1] = dim2;
   own_data = own_data_;
+  arena = arena_;
   if (own_data) {
     if (dim[0] * dim[1] > 0) {
-      data_ptr = aligned_new<ValueType>(dim[0] * dim[1]);
+      data_ptr = (arena ? aligned_new<ValueType>(dim[0] * dim[1], *arena) : aligned_new<ValueType>(dim[0] * dim[1]));
       if (data_ != NullIterator<ValueType>()) {
         memcopy(data_ptr, data_, dim[0] * dim[1]);
+      } else if (!arena) {
+        first_touch(data_ptr, dim[0] * dim[1]);
       }
     } else
       data_ptr = NullIterator<ValueType>();
@@ -65,6 +69,10 @@ template <class ValueType> Matrix<ValueType>::Matrix(Long dim1, Long dim2, Itera
   Init(dim1, dim2, data_, own_data_);
 }
 
+template <class ValueType> Matrix<ValueType>::Matrix(Long dim1, Long dim2, MemoryArena& arena_) {
+  Init(dim1, dim2, NullIterator<ValueType>(), true, &arena_);
+}
+
 template <class ValueType> Matrix<ValueType>::Matrix(const Matrix<ValueType>& M) {
   Init(M.Dim(0), M.Dim(1), (Iterator<ValueType>)M.begin());
 }
@@ -86,16 +94,19 @@ template <class ValueType> void Matrix<ValueType>::Swap(Matrix<ValueType>& M) {
   dim_[1] = dim[1];
   Iterator<ValueType> data_ptr_ = data_ptr;
   bool own_data_ = own_data;
+  MemoryArena* arena_ = arena;
 
   dim[0] = M.dim[0];
   dim[1] = M.dim[1];
   data_ptr = M.data_ptr;
   own_data = M.own_data;
+  arena = M.arena;
 
   M.dim[0] = dim_[0];
   M.dim[1] = dim_[1];
   M.data_ptr = data_ptr_;
   M.own_data = own_data_;
+  M.arena = arena_;
 }
 
 template <class ValueType> void Matrix<ValueType>::ReInit(Long dim1, Long dim2, Iterator<ValueType> data_, bool own_data_) {
@@ -106,7 +117,8 @@ template <class ValueType> void Matrix<ValueType>::ReInit(Long dim1, Long dim2,
       memcopy(data_ptr, data_, dim[0] * dim[1]);
     }
   } else {
-    Matrix<ValueType> tmp(dim1, dim2, data_, own_data_);
+    Matrix<ValueType> tmp;
+    tmp.Init(dim1, dim2, data_, own_data_, arena);
     this->Swap(tmp);
   }
 }
@@ -117,10 +129,7 @@ template <class ValueType> void Matrix<ValueType>::Write(const char* fname) cons
     std::cout << "Unable to open file for writing: " << fname << '\n';
     return;
   }
-  StaticArray<uint64_t, 2> dim_;
-  dim_[0] = (uint64_t)Dim(0);
-  dim_[1] = (uint64_t)Dim(1);
-  fwrite(&dim_[0], sizeof(uint64_t), 2, f1);
+  mapped_file_detail::WriteHeader<ValueType>(f1, Dim(0), Dim(1));
   if (Dim(0) && Dim(1)) fwrite(&data_ptr[0], sizeof(ValueType), Dim(0) * Dim(1), f1);
   fclose(f1);
 }
@@ -134,24 +143,23 @@ template <class ValueType> template <class Type> void Matrix<ValueType>::Write(c
 }
 
 template <class ValueType> void Matrix<ValueType>::Read(const char* fname) {
-  FILE* f1 = fopen(fname, "r");
+  FILE* f1 = fopen(fname, "rb");
   if (f1 == nullptr) {
     std::cout << "Unable to open file for reading: " << fname << '\n';
     return;
   }
-  StaticArray<uint64_t, 2> dim_;
-  Long readlen = fread(&dim_[0], sizeof(uint64_t), 2, f1);
-  if(readlen != 2) {
-    std::cout << "Reading file failed: " << fname << '\n';
+  StaticArray<Long, 2> dim_;
+  Long data_offset;
+  if (!mapped_file_detail::ReadHeader<ValueType>(f1, dim_, data_offset, fname)) {
     ReInit(0,0);
     fclose(f1);
     return;
   }
 
-  if (Dim(0) != (Long)dim_[0] || Dim(1) != (Long)dim_[1]) ReInit(dim_[0], dim_[1]);
+  if (Dim(0) != dim_[0] || Dim(1) != dim_[1]) ReInit(dim_[0], dim_[1]);
   if (dim_[0] && dim_[1]) {
-    readlen = fread(&data_ptr[0], sizeof(ValueType), dim_[0] * dim_[1], f1);
-    if (readlen != (Long)(dim_[0] * dim_[1])) {
+    Long readlen = fread(&data_ptr[0], sizeof(ValueType), dim_[0] * dim_[1], f1);
+    if (readlen != dim_[0] * dim_[1]) {
       std::cout << "Reading file failed: " << fname << '\n';
       ReInit(0,0);
     }
@@ -13,6 +13,8 @@
 
 namespace sctl {
 
+class MemoryArena;
+
 /**
  * MemoryManager class declaration.
  */
@@ -39,6 +41,10 @@ class MemoryManager {
 
   /**
    * Constructor for MemoryManager.
+   *
+   * @param[in] N size of the memory buffer in bytes. With SCTL_HAVE_NUMA, the
+   * buffer is split into one pool per NUMA node and allocations are served
+   * from the pool of the calling thread (falling back to the other pools).
    */
   explicit MemoryManager(Long N);
 
@@ -57,6 +63,12 @@ class MemoryManager {
 
   void print() const;
 
+  /**
+   * Return all blocks held in the per-thread caches (of every thread) back to
+   * the memory manager. Must not be called concurrently with malloc/free.
+   */
+  void FlushThreadCaches() const;
+
   static void test();
 
   // Check all free memory equals init_mem_val
@@ -69,6 +81,8 @@ class MemoryManager {
   }
 
  private:
+  friend class MemoryArena;
+
   // Private constructor
   MemoryManager();
 
@@ -85,9 +99,82 @@ class MemoryManager {
     Long size;
     char* mem_ptr;
     Long prev, next;
+    Integer pool;
     std::multimap<Long, Long>::iterator it;
   };
 
+  /**
+   * Contiguous part of the memory buffer with its own list of MemNodes. With
+   * SCTL_HAVE_NUMA, there is one pool for each NUMA node and its pages are
+   * bound to that node.
+   */
+  struct MemPool {
+    char* buff;          // start of the pool in the memory buffer.
+    Long size;           // pool size in bytes.
+    Long n_dummy_indx;   // index of first (dummy) MemNode in link list.
+    Integer numa_node;   // NUMA node of the pool memory (-1 if not bound).
+    mutable Long used;   // bytes of the pool in use (including blocks held in thread caches).
+  };
+
+  /**
+   * Per-thread cache of freed blocks binned by size class (one magazine per
+   * class). Cached blocks are still marked as allocated in node_buff, so they
+   * can be reused by the owning thread without entering the critical section.
+   */
+  struct ThreadCache;
+
+  /**
+   * Owns the ThreadCache objects of the calling thread (one per
+   * MemoryManager) and returns them to their managers on thread exit.
+   */
+  struct ThreadCacheList;
+
+#ifdef SCTL_MEMDEBUG
+  static constexpr Long cache_max_block = 0;  // disabled to catch all memory errors
+#else
+  static constexpr Long cache_max_block = SCTL_MEM_THREAD_CACHE * 1024LL;
+#endif
+  static constexpr Long cache_max_bytes = 4 * cache_max_block;  // per-thread limit
+  static constexpr Long cache_max_count = 32;  // max blocks in each magazine
+
+  /**
+   * Round up block size (in bytes) to its size class.
+   *
+   * @return index of the size class, or -1 if blocks of this size are not cached.
+   */
+  static Integer SizeClass(Long& size);
+
+  /**
+   * Initialize the header (and its check_sum) of a new memory block.
+   */
+  static void InitMemHead(char* base, Long n_indx, Long n_elem, Long type_size, MemHead::TypeID type_id);
+
+  /**
+   * Return index of the pool for the NUMA node of the calling thread.
+   */
+  Integer CurrentPool() const;
+
+  /**
+   * Return index of the pool containing the address p.
+   */
+  Integer PoolIndex(const char* p) const;
+
+  /**
+   * Return the cache of the calling thread for this MemoryManager.
+   */
+  ThreadCache* GetThreadCache() const;
+
+  /**
+   * Free all blocks in a thread cache (caller must be in SCTL_MEM_MGR_CRIT).
+   */
+  void flush_cache(ThreadCache* cache) const;
+
+  /**
+   * Free block corresponding to a MemNode and merge it with adjacent free
+   * blocks (caller must be in SCTL_MEM_MGR_CRIT).
+   */
+  void free_node(Long n_indx) const;
+
   /**
    * Return index of one of the available MemNodes from node_stack or
    * create new MemNode by resizing node_buff.
@@ -101,14 +188,90 @@ class MemoryManager {
 
   char* buff;         // pointer to memory buffer.
   Long buff_size;     // total buffer size in bytes.
-  Long n_dummy_indx;  // index of first (dummy) MemNode in link list.
+  mutable Long buff_used;  // bytes of buff in use (including blocks held in thread caches).
+  bool numa_buff;     // buff was allocated with numa_alloc.
+  Long mgr_id;        // unique id of this MemoryManager (addresses may be reused).
+
+  std::vector<MemPool> pool_lst;   // partition of buff into pools.
+  std::vector<Integer> cpu_pool;   // pool index for each CPU.
 
   mutable std::vector<MemNode> node_buff;      // storage for MemNode objects, this can only grow.
   mutable std::stack<Long> node_stack;         // stack of available free MemNodes from node_buff.
-  mutable std::multimap<Long, Long> free_map;  // pair (MemNode.size, MemNode_id) for all free MemNodes.
+  mutable std::vector<std::multimap<Long, Long>> free_map;  // pair (MemNode.size, MemNode_id) for all free MemNodes in each pool.
   //mutable omp_lock_t omp_lock;                 // openmp lock to prevent concurrent changes.
   //mutable std::mutex mutex_lock;
   mutable std::set<void*> system_malloc;       // track pointers allocated using system malloc.
+  mutable std::vector<ThreadCache*> thread_cache_lst;  // caches of all threads using this MemoryManager.
+};
+
+/**
+ * Bump-pointer allocator for short-lived scratch memory (e.g. temporaries in
+ * loops over elements). Allocations advance an offset in a single buffer and
+ * are released together at the end of the enclosing MemoryArena::Scope. Memory
+ * from an arena may be passed to aligned_delete (or owned by a Vector/Matrix);
+ * this only calls the destructors. When the buffer is full, allocations fall
+ * back to the global MemoryManager and the buffer is enlarged the next time
+ * the arena is completely released.
+ *
+ * The arena is not thread-safe; use a separate arena for each thread.
+ */
+class MemoryArena {
+ public:
+
+  /**
+   * Marks a point in the arena; all memory allocated from the arena during
+   * the lifetime of the Scope object is released when it is destroyed.
+   * Scopes of the same arena must be nested.
+   */
+  class Scope {
+   public:
+    explicit Scope(MemoryArena& arena);
+    ~Scope();
+
+    Scope() = delete;
+    Scope(const Scope&) = delete;
+    Scope& operator= (const Scope&) = delete;
+
+   private:
+    MemoryArena& arena_;
+    Long offset_;
+  };
+
+  /**
+   * Constructor.
+   *
+   * @param[in] size initial size of the buffer in bytes.
+   */
+  explicit MemoryArena(Long size = 0);
+
+  ~MemoryArena();
+
+  Iterator<char> malloc(const Long n_elem, const Long type_size = sizeof(char), const MemoryManager::MemHead::TypeID type_id = typeid(char).hash_code());
+
+  /**
+   * Release all memory allocated from the arena.
+   */
+  void Reset();
+
+  /**
+   * @return number of bytes currently allocated from the buffer.
+   */
+  Long Size() const;
+
+  /**
+   * @return size of the buffer in bytes.
+   */
+  Long Capacity() const;
+
+ private:
+  MemoryArena(const MemoryArena&);
+  MemoryArena& operator= (const MemoryArena&);
+
+  Iterator<char> buff;  // memory buffer (allocated from glbMemMgr).
+  Long capacity;        // size of buff in bytes.
+  Long offset;          // bytes currently allocated from buff.
+  Long overflow;        // bytes allocated from glbMemMgr since the last Reset.
+  Long max_size;        // largest (offset + overflow) since the last Reset.
 };
 
 /**
@@ -117,6 +280,22 @@ class MemoryManager {
  */
 template <class ValueType> Iterator<ValueType> aligned_new(Long n_elem = 1, const MemoryManager* mem_mgr = &MemoryManager::glbMemMgr());
 
+/**
+ * Aligned allocation from a MemoryArena. Uses placement new to construct
+ * objects. The memory is released by aligned_delete (with any MemoryManager).
+ */
+template <class ValueType> Iterator<ValueType> aligned_new(Long n_elem, MemoryArena& arena);
+
+/**
+ * Parallel first-touch for a newly allocated array of a trivial type: the
+ * array is zero-initialized in an `omp parallel for schedule(static)` loop, so
+ * that its pages are placed on the NUMA nodes of the threads that will use
+ * them in loops with the same schedule. Only arrays of at least
+ * SCTL_FIRST_TOUCH KB are touched and only outside of parallel regions;
+ * disabled by default (SCTL_FIRST_TOUCH=0) and in SCTL_MEMDEBUG builds.
+ */
+template <class ValueType> void first_touch(Iterator<ValueType> A, Long n_elem);
+
 /**
  * Aligned de-allocation as an alternative to delete. Calls the object
  * destructor.
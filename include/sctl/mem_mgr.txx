@@ -1,9 +1,14 @@
 #ifndef _SCTL_MEM_MGR_TXX_
 #define _SCTL_MEM_MGR_TXX_
 
-#include <omp.h>                // for omp_get_wtime
+#include <omp.h>                // for omp_get_wtime, omp_in_parallel
+#ifdef SCTL_HAVE_NUMA
+#include <numa.h>               // for numa_alloc, numa_tonode_memory, numa_...
+#include <sched.h>              // for sched_getcpu
+#endif
 #include <stdlib.h>             // for free, malloc
-#include <algorithm>            // for max
+#include <algorithm>            // for max, find
+#include <atomic>               // for atomic
 #include <cassert>              // for assert
 #include <cstdint>              // for uintptr_t, uint16_t
 #include <iostream>             // for basic_ostream, operator<<, cout, char...
@@ -21,21 +26,122 @@
 #include "sctl/iterator.hpp"    // for Iterator, ConstIterator
 #include "sctl/iterator.txx"    // for Iterator::operator[], NullIterator
 #include "sctl/math_utils.hpp"  // for round
+#include "sctl/metrics.hpp"     // for Metrics, Metric
+#include "sctl/metrics.txx"     // for Metrics::Record
 #include "sctl/profile.hpp"     // for Profile, ProfileCounter
 #include "sctl/profile.txx"     // for Profile::IncrementCounter
 
 namespace sctl {
 
+struct MemoryManager::ThreadCache {
+  const MemoryManager* mem_mgr;  // owner (nullptr after the owner is destroyed)
+  Long cached_bytes;             // total size of blocks in the cache
+  std::vector<std::vector<char*>> magazine;  // cached blocks for each size class
+};
+
+struct MemoryManager::ThreadCacheList {
+  explicit ThreadCacheList(bool* thread_exit_) : thread_exit(thread_exit_) {}
+
+  ~ThreadCacheList() {
+    (*thread_exit) = true;
+    for (auto& c : lst) {
+      ThreadCache* cache = c.second;
+      #pragma omp critical(SCTL_MEM_MGR_CRIT)
+      if (cache->mem_mgr) {  // return blocks to the owner
+        cache->mem_mgr->flush_cache(cache);
+        auto& cache_lst = cache->mem_mgr->thread_cache_lst;
+        cache_lst.erase(std::find(cache_lst.begin(), cache_lst.end(), cache));
+      }
+      delete cache;
+    }
+    lst.clear();
+  }
+
+  std::vector<std::pair<Long, ThreadCache*>> lst;  // pair (mgr_id, cache)
+  bool* thread_exit;
+};
+
 inline MemoryManager::MemoryManager(Long N) {
+  static std::atomic<Long> mgr_id_ctr(0);
+  mgr_id = mgr_id_ctr++;
   buff_size = N;
+  buff_used = 0;
+  numa_buff = false;
+  std::vector<Integer> numa_nodes(1, -1);
+#ifdef SCTL_HAVE_NUMA
+  if (N > 0 && numa_available() >= 0) {  // Get NUMA nodes and map CPUs to pools
+    numa_nodes.clear();
+    for (Integer node = 0; node <= numa_max_node(); node++) {
+      if (numa_bitmask_isbitset(numa_all_nodes_ptr, node)) numa_nodes.push_back(node);
+    }
+    if (numa_nodes.empty()) numa_nodes.push_back(-1);
+
+    cpu_pool.resize(numa_num_configured_cpus(), 0);
+    for (Long cpu = 0; cpu < (Long)cpu_pool.size(); cpu++) {
+      const Integer node = numa_node_of_cpu(cpu);
+      for (Integer i = 0; i < (Integer)numa_nodes.size(); i++) {
+        if (numa_nodes[i] == node) cpu_pool[cpu] = i;
+      }
+    }
+  }
+#endif
+  const Integer n_pools = numa_nodes.size();
+
   {  // Allocate buff
     SCTL_ASSERT(SCTL_MEM_ALIGN <= 0x8000);
-    Long alignment = SCTL_MEM_ALIGN - 1;
-    char* base_ptr = (char*)::malloc(N + 2 + alignment);
-    SCTL_ASSERT_MSG(base_ptr, "memory allocation failed.");
-    buff = (char*)((uintptr_t)(base_ptr + 2 + alignment) & ~(uintptr_t)alignment);
-    ((uint16_t*)buff)[-1] = (uint16_t)(buff - base_ptr);
+#ifdef SCTL_HAVE_NUMA
+    if (numa_nodes[0] >= 0) {  // page aligned, NUMA policy set for each pool below
+      buff = (char*)numa_alloc(N);
+      SCTL_ASSERT_MSG(buff, "memory allocation failed.");
+      numa_buff = true;
+    }
+#endif
+    if (!numa_buff) {
+      Long alignment = SCTL_MEM_ALIGN - 1;
+      char* base_ptr = (char*)::malloc(N + 2 + alignment);
+      SCTL_ASSERT_MSG(base_ptr, "memory allocation failed.");
+      buff = (char*)((uintptr_t)(base_ptr + 2 + alignment) & ~(uintptr_t)alignment);
+      ((uint16_t*)buff)[-1] = (uint16_t)(buff - base_ptr);
+    }
+  }
+
+  pool_lst.resize(n_pools);
+  free_map.resize(n_pools);
+  for (Integer i = 0; i < n_pools; i++) {  // Partition buff into pools
+    static constexpr Long page_size = 4096;
+    const Long a = (i == 0 ? 0 : (N * i / n_pools) & ~(page_size - 1));
+    const Long b = (i == n_pools - 1 ? N : (N * (i + 1) / n_pools) & ~(page_size - 1));
+    MemPool& pool = pool_lst[i];
+    pool.buff = buff + a;
+    pool.size = b - a;
+    pool.numa_node = numa_nodes[i];
+    pool.used = 0;
+#ifdef SCTL_HAVE_NUMA
+    if (numa_buff && pool.size > 0) numa_tonode_memory(pool.buff, pool.size, pool.numa_node);
+#endif
+
+    pool.n_dummy_indx = new_node();
+    Long n_indx = new_node();
+    MemNode& n_dummy = node_buff[pool.n_dummy_indx - 1];
+    MemNode& n = node_buff[n_indx - 1];
+
+    n_dummy.size = 0;
+    n_dummy.free = false;
+    n_dummy.prev = 0;
+    n_dummy.next = n_indx;
+    n_dummy.pool = i;
+    n_dummy.mem_ptr = pool.buff;
+    SCTL_ASSERT(n_indx);
+
+    n.size = pool.size;
+    n.free = true;
+    n.prev = pool.n_dummy_indx;
+    n.next = 0;
+    n.pool = i;
+    n.mem_ptr = pool.buff;
+    n.it = free_map[i].insert(std::make_pair(n.size, n_indx));
   }
+
   {  // Initialize to init_mem_val
 #ifdef SCTL_MEMDEBUG
 #pragma omp parallel for
@@ -44,40 +150,37 @@ inline MemoryManager::MemoryManager(Long N) {
     }
 #endif
   }
-  n_dummy_indx = new_node();
-  Long n_indx = new_node();
-  MemNode& n_dummy = node_buff[n_dummy_indx - 1];
-  MemNode& n = node_buff[n_indx - 1];
-
-  n_dummy.size = 0;
-  n_dummy.free = false;
-  n_dummy.prev = 0;
-  n_dummy.next = n_indx;
-  n_dummy.mem_ptr = &buff[0];
-  SCTL_ASSERT(n_indx);
-
-  n.size = N;
-  n.free = true;
-  n.prev = n_dummy_indx;
-  n.next = 0;
-  n.mem_ptr = &buff[0];
-  n.it = free_map.insert(std::make_pair(N, n_indx));
 
   //omp_init_lock(&omp_lock);
 }
 
 inline MemoryManager::~MemoryManager() {
+  #pragma omp critical(SCTL_MEM_MGR_CRIT)
+  {  // flush and detach all thread caches
+    for (auto cache : thread_cache_lst) {
+      flush_cache(cache);
+      cache->mem_mgr = nullptr;
+    }
+    thread_cache_lst.clear();
+  }
   Check();
-  MemNode* n_dummy = &node_buff[n_dummy_indx - 1];
-  MemNode* n = &node_buff[n_dummy->next - 1];
-  if (!n->free || n->size != buff_size || node_stack.size() != node_buff.size() - 2 || !system_malloc.empty()) {
+  bool leak = (node_stack.size() != node_buff.size() - 2 * pool_lst.size() || !system_malloc.empty());
+  for (const auto& pool : pool_lst) {
+    const MemNode* n_dummy = &node_buff[pool.n_dummy_indx - 1];
+    const MemNode* n = &node_buff[n_dummy->next - 1];
+    if (!n->free || n->size != pool.size) leak = true;
+  }
+  if (leak) {
     SCTL_WARN("memory leak detected.");
   }
   //omp_destroy_lock(&omp_lock);
 
   {  // free buff
     SCTL_ASSERT(buff);
-    ::free(buff - ((uint16_t*)buff)[-1]);
+#ifdef SCTL_HAVE_NUMA
+    if (numa_buff) numa_free(buff, buff_size);
+#endif
+    if (!numa_buff) ::free(buff - ((uint16_t*)buff)[-1]);
     buff = nullptr;
   }
 }
@@ -109,18 +212,35 @@ inline Iterator<char> MemoryManager::malloc(const Long n_elem, const Long type_s
 
   Long size = n_elem * type_size + header_size;
   size = (uintptr_t)(size + alignment) & ~(uintptr_t)alignment;
+  const Integer size_class = SizeClass(size);
   char* base = nullptr;
 
-  static Long alloc_ctr = 0;
-  Long head_alloc_ctr, n_indx;
+  Long n_indx = 0;
+  bool cached = false;
+  if (size_class >= 0) {  // Allocate from thread cache
+    ThreadCache* cache = GetThreadCache();
+    if (cache && size_class < (Integer)cache->magazine.size() && !cache->magazine[size_class].empty()) {
+      base = cache->magazine[size_class].back();
+      cache->magazine[size_class].pop_back();
+      cache->cached_bytes -= size;
+      n_indx = ((MemHead*)base)->n_indx;
+      cached = true;
+      Profile::IncrementCounter(ProfileCounter::HEAP_ALLOC_CACHED_COUNT, 1);
+    }
+  }
+  double buff_used_ = -1, buff_frag = 0;
+  if (!base) {
+  Integer pool = CurrentPool();
   #pragma omp critical(SCTL_MEM_MGR_CRIT)
   {
   //mutex_lock.lock();
   //omp_set_lock(&omp_lock);
-  alloc_ctr++;
-  head_alloc_ctr = alloc_ctr;
-  std::multimap<Long, Long>::iterator it = free_map.lower_bound(size);
-  n_indx = (it != free_map.end() ? it->second : 0);
+  std::multimap<Long, Long>::iterator it = free_map[pool].lower_bound(size);
+  for (Integer k = 1; k < (Integer)pool_lst.size() && it == free_map[pool].end(); k++) {  // Try other pools
+    pool = (pool + 1) % (Integer)pool_lst.size();
+    it = free_map[pool].lower_bound(size);
+  }
+  n_indx = (it != free_map[pool].end() ? it->second : 0);
   if (n_indx) {  // Allocate from buff
     Long n_free_indx = (it->first > size ? new_node() : 0);
     MemNode& n = node_buff[n_indx - 1];
@@ -143,17 +263,25 @@ inline Iterator<char> MemoryManager::malloc(const Long n_elem, const Long type_s
         n.next = n_free_indx;
       }
       assert(n_free.free);  // Insert n_free to free map
-      n_free.it = free_map.insert(std::make_pair(n_free.size, n_free_indx));
+      n_free.it = free_map[pool].insert(std::make_pair(n_free.size, n_free_indx));
       n.size = size;  // Update n
     }
 
     n.free = false;
-    free_map.erase(it);
+    free_map[pool].erase(it);
     base = n.mem_ptr;
+
+    buff_used += size;
+    const MemPool& pool_ = pool_lst[pool];
+    pool_.used += size;
+    const Long max_free = (free_map[pool].empty() ? 0 : free_map[pool].rbegin()->first);  // O(1), for this pool only
+    buff_used_ = (double)buff_used;
+    buff_frag = (pool_.used < pool_.size ? 1 - max_free / (double)(pool_.size - pool_.used) : 0);
   }
   //omp_unset_lock(&omp_lock);
   //mutex_lock.unlock();
   }
+  }
   if (!base) {             // Use system malloc
     char* p = (char*)::malloc(size + 2 + alignment + end_padding);
     SCTL_ASSERT_MSG(p, "memory allocation failed.");
@@ -186,6 +314,23 @@ inline Iterator<char> MemoryManager::malloc(const Long n_elem, const Long type_s
 #endif
   }
 
+  InitMemHead(base, n_indx, n_elem, type_size, type_id);
+  Profile::IncrementCounter(ProfileCounter::HEAP_ALLOC_BYTES, n_elem * type_size);
+  Profile::IncrementCounter(ProfileCounter::HEAP_ALLOC_COUNT, 1);
+  if (!cached) Metrics::Record(Metric::MEM_ALLOC_BYTES, (double)(n_elem * type_size)); // keep the thread-cache path lock-free
+  if (buff_used_ >= 0) {
+    Metrics::Record(Metric::MEM_POOL_USED_BYTES, buff_used_);
+    Metrics::Record(Metric::MEM_POOL_FRAGMENTATION, buff_frag);
+  }
+#ifdef SCTL_MEMDEBUG
+  return Iterator<char>(base + header_size, n_elem * type_size, true);
+#else
+  return base + header_size;
+#endif
+}
+
+inline void MemoryManager::InitMemHead(char* base, Long n_indx, Long n_elem, Long type_size, MemHead::TypeID type_id) {
+  static std::atomic<Long> alloc_ctr(0);
   MemHead& mem_head = *(MemHead*)base;
   {  // Set mem_head
 #ifdef SCTL_MEMDEBUG
@@ -194,7 +339,7 @@ inline Iterator<char> MemoryManager::malloc(const Long n_elem, const Long type_s
     mem_head.n_indx = n_indx;
     mem_head.n_elem = n_elem;
     mem_head.type_size = type_size;
-    mem_head.alloc_ctr = head_alloc_ctr;
+    mem_head.alloc_ctr = ++alloc_ctr;
     mem_head.type_id = type_id;
   }
   {  // Set header check_sum
@@ -207,13 +352,6 @@ inline Iterator<char> MemoryManager::malloc(const Long n_elem, const Long type_s
     mem_head.check_sum = check_sum;
 #endif
   }
-  Profile::IncrementCounter(ProfileCounter::HEAP_ALLOC_BYTES, n_elem * type_size);
-  Profile::IncrementCounter(ProfileCounter::HEAP_ALLOC_COUNT, 1);
-#ifdef SCTL_MEMDEBUG
-  return Iterator<char>(base + header_size, n_elem * type_size, true);
-#else
-  return base + header_size;
-#endif
 }
 
 inline void MemoryManager::free(Iterator<char> p) const {
@@ -228,6 +366,24 @@ inline void MemoryManager::free(Iterator<char> p) const {
   Long type_size = mem_head.type_size;
   char* base = (char*)&mem_head;
 
+  bool cached = false;
+  if (cache_max_block > 0 && n_indx >= 0) {  // Return block to thread cache
+    Long size = n_elem * type_size + header_size;
+    size = (uintptr_t)(size + alignment) & ~(uintptr_t)alignment;
+    const Integer size_class = SizeClass(size);
+    const bool remote = (n_indx > 0 && pool_lst.size() > 1 && PoolIndex(base) != CurrentPool());  // keep remote blocks out of the cache
+    ThreadCache* cache = (size_class >= 0 && !remote ? GetThreadCache() : nullptr);
+    if (cache && cache->cached_bytes + size <= cache_max_bytes) {
+      if ((Integer)cache->magazine.size() <= size_class) cache->magazine.resize(size_class + 1);
+      std::vector<char*>& mag = cache->magazine[size_class];
+      if ((Long)mag.size() < cache_max_count) {
+        mag.push_back(base);
+        cache->cached_bytes += size;
+        cached = true;
+      }
+    }
+  }
+
   {  // Verify header check_sum; set array to init_mem_val
 #ifdef SCTL_MEMDEBUG
     CheckMemHead(mem_head);
@@ -237,8 +393,10 @@ inline void MemoryManager::free(Iterator<char> p) const {
     for (Integer i = 0; i < (Integer)sizeof(MemHead); i++) base[i] = init_mem_val;
 #endif
   }
+  if (n_indx < 0) return;  // MemoryArena block, released with the arena
 
-  if (n_indx == 0) {  // Use system free
+  if (cached) {
+  } else if (n_indx == 0) {  // Use system free
     assert(base < &buff[0] || base >= &buff[buff_size]);
     char* p_;
     {  // p_ <-- unalign(base)
@@ -283,35 +441,8 @@ inline void MemoryManager::free(Iterator<char> p) const {
     {
     //mutex_lock.lock();
     //omp_set_lock(&omp_lock);
-    MemNode& n = node_buff[n_indx - 1];
-    assert(!n.free && n.size > 0 && n.mem_ptr == base);
-    if (n.prev != 0 && node_buff[n.prev - 1].free) {
-      Long n_prev_indx = n.prev;
-      MemNode& n_prev = node_buff[n_prev_indx - 1];
-      n.size += n_prev.size;
-      n.mem_ptr = n_prev.mem_ptr;
-      n.prev = n_prev.prev;
-      free_map.erase(n_prev.it);
-      delete_node(n_prev_indx);
-
-      if (n.prev) {
-        node_buff[n.prev - 1].next = n_indx;
-      }
-    }
-    if (n.next != 0 && node_buff[n.next - 1].free) {
-      Long n_next_indx = n.next;
-      MemNode& n_next = node_buff[n_next_indx - 1];
-      n.size += n_next.size;
-      n.next = n_next.next;
-      free_map.erase(n_next.it);
-      delete_node(n_next_indx);
-
-      if (n.next) {
-        node_buff[n.next - 1].prev = n_indx;
-      }
-    }
-    n.free = true;  // Insert n to free_map
-    n.it = free_map.insert(std::make_pair(n.size, n_indx));
+    assert(node_buff[n_indx - 1].mem_ptr == base);
+    free_node(n_indx);
     //omp_unset_lock(&omp_lock);
     //mutex_lock.unlock();
     }
@@ -320,6 +451,57 @@ inline void MemoryManager::free(Iterator<char> p) const {
   Profile::IncrementCounter(ProfileCounter::HEAP_FREE_COUNT, 1);
 }
 
+inline void MemoryManager::free_node(Long n_indx) const {
+  MemNode& n = node_buff[n_indx - 1];
+  assert(!n.free && n.size > 0);
+  buff_used -= n.size;
+  pool_lst[n.pool].used -= n.size;
+  if (n.prev != 0 && node_buff[n.prev - 1].free) {
+    Long n_prev_indx = n.prev;
+    MemNode& n_prev = node_buff[n_prev_indx - 1];
+    n.size += n_prev.size;
+    n.mem_ptr = n_prev.mem_ptr;
+    n.prev = n_prev.prev;
+    free_map[n.pool].erase(n_prev.it);
+    delete_node(n_prev_indx);
+
+    if (n.prev) {
+      node_buff[n.prev - 1].next = n_indx;
+    }
+  }
+  if (n.next != 0 && node_buff[n.next - 1].free) {
+    Long n_next_indx = n.next;
+    MemNode& n_next = node_buff[n_next_indx - 1];
+    n.size += n_next.size;
+    n.next = n_next.next;
+    free_map[n.pool].erase(n_next.it);
+    delete_node(n_next_indx);
+
+    if (n.next) {
+      node_buff[n.next - 1].prev = n_indx;
+    }
+  }
+  n.free = true;  // Insert n to free_map
+  n.it = free_map[n.pool].insert(std::make_pair(n.size, n_indx));
+}
+
+inline void MemoryManager::flush_cache(ThreadCache* cache) const {
+  for (auto& mag : cache->magazine) {
+    for (char* base : mag) {
+      const Long n_indx = ((MemHead*)base)->n_indx;
+      if (n_indx) free_node(n_indx);
+      else ::free(base - ((uint16_t*)base)[-1]);
+    }
+    mag.clear();
+  }
+  cache->cached_bytes = 0;
+}
+
+inline void MemoryManager::FlushThreadCaches() const {
+  #pragma omp critical(SCTL_MEM_MGR_CRIT)
+  for (auto cache : thread_cache_lst) flush_cache(cache);
+}
+
 inline void MemoryManager::print() const {
   if (!buff_size) return;
   #pragma omp critical(SCTL_MEM_MGR_CRIT)
@@ -327,22 +509,27 @@ inline void MemoryManager::print() const {
   //mutex_lock.lock();
   //omp_set_lock(&omp_lock);
 
-  Long size = 0;
-  Long largest_size = 0;
-  MemNode* n = &node_buff[n_dummy_indx - 1];
-  std::cout << "\n|";
-  while (n->next) {
-    n = &node_buff[n->next - 1];
-    if (n->free) {
-      std::cout << ' ';
-      largest_size = std::max(largest_size, n->size);
-    } else {
-      std::cout << '#';
-      size += n->size;
+  for (const auto& pool : pool_lst) {
+    if (!pool.size) continue;
+    Long size = 0;
+    Long largest_size = 0;
+    MemNode* n = &node_buff[pool.n_dummy_indx - 1];
+    std::cout << "\n|";
+    while (n->next) {
+      n = &node_buff[n->next - 1];
+      if (n->free) {
+        std::cout << ' ';
+        largest_size = std::max(largest_size, n->size);
+      } else {
+        std::cout << '#';
+        size += n->size;
+      }
     }
+    std::cout << "|  allocated=" << round(size * 1000.0 / pool.size) / 10 << "%";
+    std::cout << "  largest_free=" << round(largest_size * 1000.0 / pool.size) / 10 << "%";
+    if (pool.numa_node >= 0) std::cout << "  numa_node=" << pool.numa_node;
+    std::cout << "\n";
   }
-  std::cout << "|  allocated=" << round(size * 1000.0 / buff_size) / 10 << "%";
-  std::cout << "  largest_free=" << round(largest_size * 1000.0 / buff_size) / 10 << "%\n";
 
   //omp_unset_lock(&omp_lock);
   //mutex_lock.unlock();
@@ -397,14 +584,16 @@ inline void MemoryManager::Check() const {
   {
   //mutex_lock.lock();
   //omp_set_lock(&omp_lock);
-  MemNode* curr_node = &node_buff[n_dummy_indx - 1];
-  while (curr_node->next) {
-    curr_node = &node_buff[curr_node->next - 1];
-    if (curr_node->free) {
-      char* base = curr_node->mem_ptr;
+  for (const auto& pool : pool_lst) {
+    MemNode* curr_node = &node_buff[pool.n_dummy_indx - 1];
+    while (curr_node->next) {
+      curr_node = &node_buff[curr_node->next - 1];
+      if (curr_node->free) {
+        char* base = curr_node->mem_ptr;
 #pragma omp parallel for
-      for (Long i = 0; i < curr_node->size; i++) {
-        SCTL_ASSERT_MSG(base[i] == init_mem_val, "memory corruption detected.");
+        for (Long i = 0; i < curr_node->size; i++) {
+          SCTL_ASSERT_MSG(base[i] == init_mem_val, "memory corruption detected.");
+        }
       }
     }
   }
@@ -414,6 +603,64 @@ inline void MemoryManager::Check() const {
 #endif
 }
 
+inline Integer MemoryManager::SizeClass(Long& size) {
+  if (size > cache_max_block) return -1;
+  if (size <= 64) {
+    size = 64;
+    return 0;
+  }
+
+  Integer k = 6;  // 2^k < size <= 2^(k+1)
+  while (((Long)2 << k) < size) k++;
+  const Long step = ((Long)1 << (k - 2));  // four classes for each power of two
+  const Long j = (size + step - 1) / step;  // in [5,8]
+  size = j * step;
+  return 1 + (k - 6) * 4 + (Integer)(j - 5);
+}
+
+inline Integer MemoryManager::CurrentPool() const {
+#ifdef SCTL_HAVE_NUMA
+  if (pool_lst.size() > 1) {
+    const int cpu = sched_getcpu();
+    if (cpu >= 0 && cpu < (int)cpu_pool.size()) return cpu_pool[cpu];
+  }
+#endif
+  return 0;
+}
+
+inline Integer MemoryManager::PoolIndex(const char* p) const {
+  for (Integer i = (Integer)pool_lst.size() - 1; i > 0; i--) {
+    if (p >= pool_lst[i].buff) return i;
+  }
+  return 0;
+}
+
+inline MemoryManager::ThreadCache* MemoryManager::GetThreadCache() const {
+  static thread_local bool thread_exit = false;  // trivially destructible, so it outlives thread_caches
+  static thread_local ThreadCacheList thread_caches(&thread_exit);
+  if (thread_exit) return nullptr;
+
+  for (const auto& c : thread_caches.lst) {
+    if (c.first == mgr_id) return c.second;
+  }
+
+  ThreadCache* cache = new ThreadCache{this, 0, std::vector<std::vector<char*>>()};
+  #pragma omp critical(SCTL_MEM_MGR_CRIT)
+  {
+    thread_cache_lst.push_back(cache);
+    for (auto it = thread_caches.lst.begin(); it != thread_caches.lst.end();) {  // remove caches of destroyed managers
+      if (it->second->mem_mgr == nullptr) {
+        delete it->second;
+        it = thread_caches.lst.erase(it);
+      } else {
+        it++;
+      }
+    }
+  }
+  thread_caches.lst.push_back(std::make_pair(mgr_id, cache));
+  return cache;
+}
+
 inline Long MemoryManager::new_node() const {
   if (node_stack.empty()) {
     node_buff.resize(node_buff.size() + 1);
@@ -438,6 +685,69 @@ inline void MemoryManager::delete_node(Long indx) const {
   node_stack.push(indx);
 }
 
+inline MemoryArena::Scope::Scope(MemoryArena& arena) : arena_(arena), offset_(arena.offset) {}
+
+inline MemoryArena::Scope::~Scope() {
+  SCTL_ASSERT_MSG(arena_.offset >= offset_, "MemoryArena scopes must be nested.");
+  if (offset_ == 0) arena_.Reset();
+  else arena_.offset = offset_;
+}
+
+inline MemoryArena::MemoryArena(Long size) : buff(NullIterator<char>()), capacity(0), offset(0), overflow(0), max_size(0) {
+  if (size > 0) {
+    buff = aligned_new<char>(size);
+    capacity = size;
+  }
+}
+
+inline MemoryArena::~MemoryArena() {
+  aligned_delete<char>(buff);
+}
+
+inline Iterator<char> MemoryArena::malloc(const Long n_elem, const Long type_size, const MemoryManager::MemHead::TypeID type_id) {
+  if (!n_elem) return NullIterator<char>();
+  static uintptr_t alignment = SCTL_MEM_ALIGN - 1;
+  static uintptr_t header_size = (uintptr_t)(sizeof(MemoryManager::MemHead) + alignment) & ~(uintptr_t)alignment;
+
+  Long size = n_elem * type_size + header_size;
+  size = (uintptr_t)(size + alignment) & ~(uintptr_t)alignment;
+  if (offset + size > capacity) {  // Use global memory manager
+    overflow += size;
+    max_size = std::max(max_size, offset + overflow);
+    return MemoryManager::glbMemMgr().malloc(n_elem, type_size, type_id);
+  }
+
+  char* base = &buff[offset];
+  offset += size;
+  max_size = std::max(max_size, offset + overflow);
+
+  MemoryManager::InitMemHead(base, -1, n_elem, type_size, type_id);
+#ifdef SCTL_MEMDEBUG
+  return Iterator<char>(base + header_size, n_elem * type_size, true);
+#else
+  return base + header_size;
+#endif
+}
+
+inline void MemoryArena::Reset() {
+  offset = 0;
+  if (max_size > capacity) {  // Enlarge buff
+    aligned_delete<char>(buff);
+    capacity = max_size;
+    buff = aligned_new<char>(capacity);
+  }
+  overflow = 0;
+  max_size = 0;
+}
+
+inline Long MemoryArena::Size() const {
+  return offset;
+}
+
+inline Long MemoryArena::Capacity() const {
+  return capacity;
+}
+
 template <class ValueType> inline Iterator<ValueType> aligned_new(Long n_elem, const MemoryManager* mem_mgr) {
   if (!n_elem) return NullIterator<ValueType>();
 
@@ -469,6 +779,31 @@ template <class ValueType> inline Iterator<ValueType> aligned_new(Long n_elem, c
   return A;
 }
 
+template <class ValueType> inline Iterator<ValueType> aligned_new(Long n_elem, MemoryArena& arena) {
+  if (!n_elem) return NullIterator<ValueType>();
+
+  Iterator<ValueType> A = (Iterator<ValueType>)arena.malloc(n_elem, sizeof(ValueType), typeid(ValueType).hash_code());
+  SCTL_ASSERT_MSG(A != NullIterator<ValueType>(), "memory allocation failed.");
+
+  if (!std::is_trivial<ValueType>::value) {  // Call constructors
+    for (Long i = 0; i < n_elem; i++) {
+      ValueType* Ai = new (&A[i]) ValueType();
+      assert(Ai == (&A[i]));
+      SCTL_UNUSED(Ai);
+    }
+  }
+  return A;
+}
+
+template <class ValueType> inline void first_touch(Iterator<ValueType> A, Long n_elem) {
+#ifndef SCTL_MEMDEBUG
+  if (SCTL_FIRST_TOUCH <= 0 || !std::is_trivial<ValueType>::value) return;
+  if (n_elem * (Long)sizeof(ValueType) < SCTL_FIRST_TOUCH * 1024LL || omp_in_parallel()) return;
+#pragma omp parallel for schedule(static)
+  for (Long i = 0; i < n_elem; i++) A[i] = ValueType();
+#endif
+}
+
 template <class ValueType> inline void aligned_delete(Iterator<ValueType> A, const MemoryManager* mem_mgr) {
   if (A == NullIterator<ValueType>()) return;
 
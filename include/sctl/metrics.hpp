@@ -0,0 +1,180 @@
+#ifndef _SCTL_METRICS_HPP_
+#define _SCTL_METRICS_HPP_
+
+#include <atomic>            // for atomic
+#include <memory>            // for unique_ptr
+#include <ostream>           // for ostream
+#include <vector>            // for vector
+
+#include "sctl/common.hpp"   // for Long, Integer, sctl
+
+#ifndef SCTL_METRICS
+#define SCTL_METRICS 1
+#endif
+
+namespace sctl {
+
+class Comm;
+
+/**
+ * Metrics recorded by the library (see Metrics). For each metric, the number of samples, their sum, minimum, maximum
+ * and a histogram (with power-of-two bins) are kept.
+ */
+enum class Metric: Long {
+  GMRES_ITERATIONS,        ///< iterations of each GMRES solve
+  GMRES_RESIDUAL,          ///< relative residual norm after each GMRES iteration
+  FMM_SETUP_TIME,          ///< time (s) to set up the tree and the operators in each ParticleFMM::Eval (KIFMM backend)
+  FMM_EVAL_TIME,           ///< time (s) of each ParticleFMM::Eval (including setup)
+  BIOP_NEAR_PAIRS,         ///< number of near (target, element) pairs in each BoundaryIntegralOp setup
+  BIOP_NEAR_BYTES,         ///< bytes of precomputed near-interaction matrices in each BoundaryIntegralOp setup
+  MEM_ALLOC_BYTES,         ///< size of each allocation from a MemoryManager (not recorded for thread-cache hits)
+  MEM_POOL_USED_BYTES,     ///< memory in use in the MemoryManager buffer (at each allocation from the buffer)
+  MEM_POOL_FRAGMENTATION,  ///< 1 - (largest free block) / (free memory) in the pool of each allocation from the buffer
+  COMM_P2P_BYTES,          ///< bytes of each point-to-point operation (Comm::Isend, Comm::Irecv, Comm::Ialltoallv_sparse)
+  COMM_BCAST_BYTES,        ///< bytes of each Comm::Bcast
+  COMM_ALLGATHER_BYTES,    ///< bytes sent and received in each Comm::Allgather and Comm::Allgatherv
+  COMM_ALLTOALL_BYTES,     ///< bytes sent and received in each Comm::Alltoall and Comm::Alltoallv
+  COMM_ALLREDUCE_BYTES,    ///< bytes of each Comm::Allreduce and Comm::Iallreduce
+  COMM_SCAN_BYTES,         ///< bytes of each Comm::Scan
+  CUSTOM1,
+  CUSTOM2,
+  CUSTOM3,
+  FIELD_COUNT
+};
+
+/**
+ * Registry of lightweight metrics which are always recorded (unlike the Profile blocks), so that production runs can
+ * be monitored. Each thread accumulates samples into its own counters; these are combined only when the metrics are
+ * exported. The metrics can also be reduced across the processes of a communicator without blocking, e.g.
+ *
+ * @code
+ * for (Long step = 0; step < Nsteps; step++) {
+ *   ... // solve
+ *   if (step % 100 == 0) {
+ *     Metrics::FinishReduce(); // result of the previous reduction
+ *     Metrics::WriteJSON(std::cout, &comm);
+ *     Metrics::StartReduce(comm);
+ *   }
+ * }
+ * @endcode
+ *
+ * The macro `SCTL_METRICS` can be defined as 0 to disable recording.
+ */
+class Metrics {
+  static constexpr Long Nmetric = (Long)Metric::FIELD_COUNT;
+
+ public:
+
+  /**
+   * Number of histogram bins. Bin b counts the samples x with 2^(b-1-BIN_OFFSET) < x <= 2^(b-BIN_OFFSET); the first
+   * bin also counts all smaller values (including zero and negative values) and the last bin all larger values.
+   */
+  static constexpr Integer NBINS = 96;
+  static constexpr Integer BIN_OFFSET = 56;
+
+  /**
+   * Record a sample of a metric. This is thread-safe and does not lock.
+   *
+   * @param[in] metric the metric.
+   *
+   * @param[in] x the value of the sample.
+   */
+  static void Record(Metric metric, double x);
+
+  /**
+   * Records the wall time (in seconds) of its lifetime/scope as a sample of a metric.
+   */
+  struct Scoped {
+    explicit Scoped(Metric metric_);
+    ~Scoped();
+
+    Scoped() = delete;
+    Scoped(const Scoped&) = delete;
+    Scoped& operator= (const Scoped&) = delete;
+
+   private:
+    Metric metric;
+    double t0;
+  };
+
+  /**
+   * Clear all samples of this process. Must not be called concurrently with Record.
+   */
+  static void Reset();
+
+  /**
+   * Start a non-blocking reduction of the metrics of this process over all processes of comm. The result is available
+   * for export after FinishReduce. The communicator must not be destroyed before FinishReduce is called.
+   *
+   * @param[in] comm the communicator (all processes must call StartReduce).
+   */
+  static void StartReduce(const Comm& comm);
+
+  /**
+   * Wait for the reduction started by StartReduce (if any) to complete.
+   */
+  static void FinishReduce();
+
+  /**
+   * Write the metrics as JSON lines, one object per metric with samples. The metrics of this process have the field
+   * "rank"; the result of the last completed reduction is written by rank 0 with "rank":"all" and also includes the
+   * minimum, average and maximum over processes of the sum of the samples (to show load imbalance).
+   *
+   * @param[in] out the output stream.
+   *
+   * @param[in] comm pointer to Comm object to get the rank (can be nullptr).
+   */
+  static void WriteJSON(std::ostream& out, const Comm* comm = nullptr);
+
+  /**
+   * Write the metrics in the Prometheus text exposition format, as histograms `sctl_<name>` with the label `rank`
+   * (and with rank="all" and the gauges `sctl_<name>_rank_sum_{min,avg,max}` for the last completed reduction).
+   *
+   * @param[in] out the output stream.
+   *
+   * @param[in] comm pointer to Comm object to get the rank (can be nullptr).
+   */
+  static void WritePrometheus(std::ostream& out, const Comm* comm = nullptr);
+
+  /**
+   * @return the name of the metric (as used in the output).
+   */
+  static const char* Name(Metric metric);
+
+ private:
+
+  /**
+   * Per-metric data: count, sum, min, max and the histogram bins.
+   */
+  static constexpr Long SLOT_SIZE = 4 + NBINS;
+
+  struct ThreadData {
+    std::atomic<double> value[Nmetric * SLOT_SIZE];  // written only by the owning thread
+  };
+
+  struct ReduceData;
+
+  static std::vector<std::unique_ptr<ThreadData>>& ThreadDataList();
+
+  static ThreadData& GetThreadData();
+
+  static ReduceData& GetReduceData();
+
+  static void InitSlots(std::atomic<double>* value);
+
+  /**
+   * Combine the samples of all threads (count, sum, min, max and bins for each metric).
+   */
+  static std::vector<double> Collect();
+
+  static Integer BinIndex(double x);
+
+  /**
+   * Upper bound of histogram bin b.
+   */
+  static double BinBound(Integer b);
+};
+
+}  // end namespace
+
+#endif // _SCTL_METRICS_HPP_
@@ -0,0 +1,242 @@
+#ifndef _SCTL_METRICS_TXX_
+#define _SCTL_METRICS_TXX_
+
+#include <omp.h>              // for omp_get_wtime
+#include <atomic>             // for atomic, memory_order_relaxed
+#include <algorithm>          // for min, max
+#include <cmath>              // for frexp, ldexp, isinf
+#include <iomanip>            // for setprecision
+#include <limits>             // for numeric_limits
+#include <memory>             // for unique_ptr
+#include <ostream>            // for ostream
+#include <sstream>            // for ostringstream
+#include <string>             // for string, to_string
+#include <vector>             // for vector
+
+#include "sctl/common.hpp"    // for Long, Integer, sctl
+#include "sctl/metrics.hpp"   // for Metrics, Metric
+#include "sctl/comm.hpp"      // for Comm (StartReduce and FinishReduce are defined in comm.txx)
+
+namespace sctl {
+
+  struct Metrics::ReduceData {
+    const Comm* comm = nullptr;
+    Integer rank = 0, comm_size = 1;
+    bool pending = false, ready = false;
+    void* req[3] = {nullptr, nullptr, nullptr};
+
+    std::vector<double> sbuf_sum, sbuf_min, sbuf_max;
+    std::vector<double> rbuf_sum, rbuf_min, rbuf_max;
+
+    std::vector<double> result;   // combined slots of all processes
+    std::vector<double> rank_sum; // (min, avg, max) over processes of the sum of each metric
+  };
+
+  inline const char* Metrics::Name(Metric metric) {
+    static const char* name[] = {
+      "gmres_iterations",
+      "gmres_residual",
+      "fmm_setup_seconds",
+      "fmm_eval_seconds",
+      "biop_near_pairs",
+      "biop_near_bytes",
+      "mem_alloc_bytes",
+      "mem_pool_used_bytes",
+      "mem_pool_fragmentation",
+      "comm_p2p_bytes",
+      "comm_bcast_bytes",
+      "comm_allgather_bytes",
+      "comm_alltoall_bytes",
+      "comm_allreduce_bytes",
+      "comm_scan_bytes",
+      "custom1",
+      "custom2",
+      "custom3"
+    };
+    static_assert(sizeof(name) / sizeof(name[0]) == Nmetric, "Metric names do not match Metric.");
+    return name[(Long)metric];
+  }
+
+  inline Integer Metrics::BinIndex(double x) {
+    if (!(x > 0)) return 0;
+    int e;
+    const double m = std::frexp(x, &e); // x = m * 2^e, m in [0.5,1)
+    const Long b = (Long)(m == 0.5 ? e - 1 : e) + BIN_OFFSET;
+    return (Integer)(b < 0 ? 0 : (b >= NBINS ? NBINS - 1 : b));
+  }
+
+  inline double Metrics::BinBound(Integer b) {
+    return (b < NBINS - 1 ? std::ldexp(1.0, b - BIN_OFFSET) : std::numeric_limits<double>::infinity());
+  }
+
+  inline void Metrics::InitSlots(std::atomic<double>* value) {
+    for (Long i = 0; i < Nmetric; i++) {
+      std::atomic<double>* v = value + i * SLOT_SIZE;
+      v[0].store(0, std::memory_order_relaxed);
+      v[1].store(0, std::memory_order_relaxed);
+      v[2].store(std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+      v[3].store(-std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+      for (Integer b = 0; b < NBINS; b++) v[4 + b].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  inline std::vector<std::unique_ptr<Metrics::ThreadData>>& Metrics::ThreadDataList() {
+    static auto* list = new std::vector<std::unique_ptr<ThreadData>>(); // never destroyed, since Record may be called from static destructors (e.g. through MemoryManager)
+    return *list;
+  }
+
+  inline Metrics::ThreadData& Metrics::GetThreadData() {
+    static thread_local ThreadData* data = nullptr; // owned by ThreadDataList()
+    if (!data) {
+      #pragma omp critical(SCTL_METRICS_CRIT)
+      {
+        ThreadDataList().push_back(std::unique_ptr<ThreadData>(new ThreadData));
+        data = ThreadDataList().back().get();
+        InitSlots(data->value);
+      }
+    }
+    return *data;
+  }
+
+  inline Metrics::ReduceData& Metrics::GetReduceData() {
+    static ReduceData reduce_data;
+    return reduce_data;
+  }
+
+  inline void Metrics::Record(Metric metric, double x) {
+#if SCTL_METRICS
+    static constexpr auto relaxed = std::memory_order_relaxed;
+    std::atomic<double>* v = GetThreadData().value + (Long)metric * SLOT_SIZE;
+    v[0].store(v[0].load(relaxed) + 1, relaxed);
+    v[1].store(v[1].load(relaxed) + x, relaxed);
+    if (x < v[2].load(relaxed)) v[2].store(x, relaxed);
+    if (x > v[3].load(relaxed)) v[3].store(x, relaxed);
+    std::atomic<double>& bin = v[4 + BinIndex(x)];
+    bin.store(bin.load(relaxed) + 1, relaxed);
+#endif
+  }
+
+  inline Metrics::Scoped::Scoped(Metric metric_) : metric(metric_), t0(omp_get_wtime()) {}
+
+  inline Metrics::Scoped::~Scoped() {
+    Record(metric, omp_get_wtime() - t0);
+  }
+
+  inline void Metrics::Reset() {
+    #pragma omp critical(SCTL_METRICS_CRIT)
+    for (auto& data : ThreadDataList()) InitSlots(data->value);
+  }
+
+  inline std::vector<double> Metrics::Collect() {
+    std::vector<double> slots(Nmetric * SLOT_SIZE);
+    for (Long i = 0; i < Nmetric; i++) {
+      slots[i * SLOT_SIZE + 2] = std::numeric_limits<double>::infinity();
+      slots[i * SLOT_SIZE + 3] = -std::numeric_limits<double>::infinity();
+    }
+    #pragma omp critical(SCTL_METRICS_CRIT)
+    for (const auto& data : ThreadDataList()) {
+      for (Long i = 0; i < Nmetric; i++) {
+        const std::atomic<double>* v = data->value + i * SLOT_SIZE;
+        double* s = &slots[i * SLOT_SIZE];
+        s[0] += v[0].load(std::memory_order_relaxed);
+        s[1] += v[1].load(std::memory_order_relaxed);
+        s[2] = std::min(s[2], v[2].load(std::memory_order_relaxed));
+        s[3] = std::max(s[3], v[3].load(std::memory_order_relaxed));
+        for (Integer b = 0; b < NBINS; b++) s[4 + b] += v[4 + b].load(std::memory_order_relaxed);
+      }
+    }
+    return slots;
+  }
+
+  inline void Metrics::WriteJSON(std::ostream& out, const Comm* comm) {
+    const ReduceData& r = GetReduceData();
+    const std::vector<double> slots = Collect();
+    const Integer rank = (comm ? comm->Rank() : 0);
+
+    const auto num_str = [](double x) {
+      if (std::isinf(x)) return std::string(x > 0 ? "\"+Inf\"" : "\"-Inf\"");
+      std::ostringstream ss;
+      ss << std::setprecision(std::numeric_limits<double>::max_digits10) << x;
+      return ss.str();
+    };
+    const auto write_line = [&num_str,&out](Long i, const double* s, const std::string& rank_str, const double* rank_sum) {
+      std::ostringstream ss;
+      ss << "{\"metric\":\"" << Name((Metric)i) << "\",\"rank\":" << rank_str;
+      ss << ",\"count\":" << num_str(s[0]) << ",\"sum\":" << num_str(s[1]);
+      ss << ",\"min\":" << num_str(s[2]) << ",\"max\":" << num_str(s[3]) << ",\"mean\":" << num_str(s[1] / s[0]);
+      if (rank_sum) ss << ",\"rank_sum_min\":" << num_str(rank_sum[0]) << ",\"rank_sum_avg\":" << num_str(rank_sum[1]) << ",\"rank_sum_max\":" << num_str(rank_sum[2]);
+      ss << ",\"bins\":[";
+      bool first = true;
+      for (Integer b = 0; b < NBINS; b++) {
+        if (!s[4 + b]) continue;
+        ss << (first ? "" : ",") << "{\"le\":" << num_str(BinBound(b)) << ",\"count\":" << num_str(s[4 + b]) << "}";
+        first = false;
+      }
+      ss << "]}\n";
+      out << ss.str();
+    };
+
+    for (Long i = 0; i < Nmetric; i++) {
+      if (slots[i * SLOT_SIZE]) write_line(i, &slots[i * SLOT_SIZE], std::to_string(rank), nullptr);
+    }
+    if (r.ready && r.rank == 0) {
+      for (Long i = 0; i < Nmetric; i++) {
+        if (r.result[i * SLOT_SIZE]) write_line(i, &r.result[i * SLOT_SIZE], "\"all\"", &r.rank_sum[i * 3]);
+      }
+    }
+  }
+
+  inline void Metrics::WritePrometheus(std::ostream& out, const Comm* comm) {
+    const ReduceData& r = GetReduceData();
+    const std::vector<double> slots = Collect();
+    const std::string rank_label = "rank=\"" + std::to_string(comm ? comm->Rank() : 0) + "\"";
+    const bool write_reduced = (r.ready && r.rank == 0);
+
+    const auto num_str = [](double x) {
+      if (std::isinf(x)) return std::string(x > 0 ? "+Inf" : "-Inf");
+      std::ostringstream ss;
+      ss << std::setprecision(std::numeric_limits<double>::max_digits10) << x;
+      return ss.str();
+    };
+    const auto write_histogram = [&num_str](std::ostringstream& ss, const std::string& name, const double* s, const std::string& label) {
+      double cumulative = 0;
+      for (Integer b = 0; b < NBINS - 1; b++) {
+        if (!s[4 + b]) continue;
+        cumulative += s[4 + b];
+        ss << name << "_bucket{" << label << ",le=\"" << num_str(BinBound(b)) << "\"} " << num_str(cumulative) << '\n';
+      }
+      ss << name << "_bucket{" << label << ",le=\"+Inf\"} " << num_str(s[0]) << '\n';
+      ss << name << "_sum{" << label << "} " << num_str(s[1]) << '\n';
+      ss << name << "_count{" << label << "} " << num_str(s[0]) << '\n';
+    };
+
+    std::ostringstream ss;
+    for (Long i = 0; i < Nmetric; i++) {
+      const double* s_local = &slots[i * SLOT_SIZE];
+      const double* s_all = (write_reduced && r.result[i * SLOT_SIZE] ? &r.result[i * SLOT_SIZE] : nullptr);
+      if (!s_local[0] && !s_all) continue;
+      const std::string name = std::string("sctl_") + Name((Metric)i);
+
+      ss << "# TYPE " << name << " histogram\n";
+      if (s_local[0]) write_histogram(ss, name, s_local, rank_label);
+      if (s_all) write_histogram(ss, name, s_all, "rank=\"all\"");
+      for (Integer k = 0; k < 2; k++) {
+        const std::string gauge = name + (k == 0 ? "_min" : "_max");
+        ss << "# TYPE " << gauge << " gauge\n";
+        if (s_local[0]) ss << gauge << '{' << rank_label << "} " << num_str(s_local[2 + k]) << '\n';
+        if (s_all) ss << gauge << "{rank=\"all\"} " << num_str(s_all[2 + k]) << '\n';
+      }
+      if (s_all) {
+        const char* suffix[3] = {"_rank_sum_min", "_rank_sum_avg", "_rank_sum_max"};
+        for (Integer k = 0; k < 3; k++) {
+          ss << "# TYPE " << name << suffix[k] << " gauge\n";
+          ss << name << suffix[k] << ' ' << num_str(r.rank_sum[i * 3 + k]) << '\n';
+        }
+      }
+    }
+    out << ss.str();
+  }
+
+}
+
+#endif // _SCTL_METRICS_TXX_
@@ -6,6 +6,7 @@
 #include <cstdint>          // for uint8_t, int8_t, uint32_t
 
 #include "sctl/common.hpp"  // for Integer, Long, sctl
+#include "sctl/ompUtils.hpp"  // for RadixKey
 
 #ifndef SCTL_MAX_DEPTH
 #define SCTL_MAX_DEPTH 15
@@ -199,6 +200,8 @@ template <Integer DIM = 3> class Morton {
    */
   template <Integer D> friend std::ostream& operator<<(std::ostream &out, const Morton<D> &mid);
 
+  friend struct omp_par::RadixKey<Morton>;
+
  private:
 
   /**
@@ -218,6 +221,17 @@ template <Integer DIM = 3> class Morton {
   int8_t depth;
 };
 
+/**
+ * Radix sort key of a Morton index: the interleaved coordinate bits followed by the depth. Enabled when this fits in
+ * 64 bits.
+ */
+template <Integer DIM> struct omp_par::RadixKey<Morton<DIM>> {
+  static constexpr bool Enabled = (DIM * (SCTL_MAX_DEPTH + 1) + 8 <= 64);
+  static constexpr bool MergeSort = Enabled;
+  typedef uint64_t KeyType;
+  static KeyType Key(const Morton<DIM>& m);
+};
+
 }
 
 #endif // _SCTL_MORTON_HPP_
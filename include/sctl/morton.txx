@@ -216,6 +216,14 @@ namespace sctl {
     return diff;
   }
 
+  template <Integer DIM> uint64_t omp_par::RadixKey<Morton<DIM>>::Key(const Morton<DIM>& m) {
+    uint64_t key = 0;
+    for (Integer b = Morton<DIM>::MAX_DEPTH; b >= 0; b--) { // interleave the bits (as in Morton::operator<)
+      for (Integer i = DIM - 1; i >= 0; i--) key = (key << 1) | ((m.x[i] >> b) & 1);
+    }
+    return (key << 8) | (uint8_t)((int)m.depth + 128);
+  }
+
   template <Integer DIM> std::ostream& operator<<(std::ostream &out, const Morton<DIM> &mid) {
     double a = 0;
     double s = 1u << DIM;
@@ -11,6 +11,14 @@
 
 namespace sctl {
 
+/**
+ * Correction sweep in each Picard iteration of SDC.
+ */
+enum class SDCSweep {
+  GaussSeidel, ///< sequential sweep over the substeps with residual time-stepping (each evaluation of F uses the previous substep)
+  Jacobi ///< Picard sweep: the evaluations of F at all substeps are independent and are computed in parallel (OpenMP)
+};
+
 /**
  * Implements spectral deferred correction (SDC) solver for ordinary differential equations (ODEs).
  */
@@ -39,6 +47,23 @@ template <class Real> class SDC {
      */
     Integer Order() const;
 
+    /**
+     * Set the correction sweep (default SDCSweep::GaussSeidel). With SDCSweep::Jacobi, the order-1 evaluations of F
+     * in each Picard iteration are independent and run concurrently in an OpenMP parallel loop, so F must be
+     * thread-safe (and must not use collective communication) in this mode; the substep_idx argument of Fn0 can be
+     * used to dispatch the evaluations to separate resources. Both sweeps gain one order of accuracy per Picard
+     * iteration, so the default number of Picard iterations (equal to the order) gives the same order of the method,
+     * although the Jacobi sweep usually has a larger error constant.
+     *
+     * @param[in] sweep the correction sweep.
+     */
+    void SetSweep(SDCSweep sweep);
+
+    /**
+     * @return the correction sweep.
+     */
+    SDCSweep GetSweep() const;
+
     /**
      * Apply one step of spectral deferred correction (SDC).
      * Compute: \f$ u = u_0 + \int_0^{dt} F(u) \f$
@@ -109,6 +134,39 @@ template <class Real> class SDC {
      */
     Real AdaptiveSolve(Vector<Real>* u, Real dt, const Real T, const Vector<Real>& u0, const Fn1& F, Real tol, const MonitorFn* monitor_callback = nullptr, bool continue_with_errors = false, Real* error = nullptr) const;
 
+    /**
+     * Solve ODE with parallel-in-time integration (Parareal), using the SDC method of this object as the fine
+     * propagator and a low-order SDC method as the coarse propagator.
+     * Compute: \f$ u = u_0 + \int_0^{T} F(u) \f$
+     *
+     * The interval [0,T] is divided into equal time slices, one for each process in comm_time (in the order of the
+     * ranks). Each slice is integrated independently with the fine propagator, and the slice-end states are corrected
+     * by a sequential sweep of the coarse propagator, passing the states from one rank to the next through comm_time.
+     * The iterations stop when the slice-end states change by less than tol, and are exact (i.e. equal to the
+     * sequential fine solution) after comm_time.Size() iterations. The spatial communicator of this object (passed to
+     * the constructor) is used within each time slice, so that comm_time is typically obtained by splitting a global
+     * communicator with Comm::Split() such that the processes with the same spatial rank are in the same group.
+     *
+     * @param[out] u the final solution (on all processes)
+     * @param[in] T the final time
+     * @param[in] u0 the initial value
+     * @param[in] F the function du/dt
+     * @param[in] comm_time the communicator across time slices
+     * @param[in] N_fine number of fine time-steps in each time slice
+     * @param[in] N_coarse number of coarse time-steps in each time slice
+     * @param[in] coarse_order the order of the coarse SDC method
+     * @param[in] tol the tolerance for stopping the Parareal iterations
+     * @param[in] max_iter the maximum number of Parareal iterations (default -1 corresponds to comm_time.Size())
+     * @param[out] iter_count number of Parareal iterations
+     * @param[out] error the change in the slice-end states in the last iteration
+     */
+    void Parareal(Vector<Real>* u, const Real T, const Vector<Real>& u0, const Fn0& F, const Comm& comm_time, const Integer N_fine, const Integer N_coarse = 1, const Integer coarse_order = 2, const Real tol = 0, Integer max_iter = -1, Integer* iter_count = nullptr, Real* error = nullptr) const;
+
+    /**
+     * Solve ODE with parallel-in-time integration (Parareal), see above.
+     */
+    void Parareal(Vector<Real>* u, const Real T, const Vector<Real>& u0, const Fn1& F, const Comm& comm_time, const Integer N_fine, const Integer N_coarse = 1, const Integer coarse_order = 2, const Real tol = 0, Integer max_iter = -1, Integer* iter_count = nullptr, Real* error = nullptr) const;
+
     /**
      * This is an example for how to use the SDC class.
      */
@@ -119,6 +177,12 @@ template <class Real> class SDC {
      */
     static void test_adaptive_solve(const Integer Order = 5, const Real tol = 1e-5);
 
+    /**
+     * This example shows parallel-in-time integration with the SDC class, with one time slice on each process of
+     * Comm::World().
+     */
+    static void test_parareal(const Integer Order = 5);
+
   private:
 
     template <class Container> Real max_norm(const Container& M) const;
@@ -126,6 +190,7 @@ template <class Real> class SDC {
     Matrix<Real> M_time_step, M_error, M_error_half;
     Vector<Real> nds;
     Integer order;
+    SDCSweep sweep;
     Comm comm;
 };
 
@@ -71,7 +71,32 @@ namespace sctl {
     }
   }
 
-  template <class Real> SDC<Real>::SDC(const Integer Order_, const Comm& comm_) : order(Order_), comm(comm_) {
+  template <class Real> void SDC<Real>::test_parareal(const Integer Order) {
+    auto ref_sol = [](Real t) { return cos(-t); };
+    auto fn = [](Vector<Real>* dudt, const Vector<Real>& u) {
+      (*dudt)[0] = -u[1];
+      (*dudt)[1] = u[0];
+    };
+
+    Vector<Real> u, u0(2);
+    u0[0] = 1.0; u0[1] = 0.0;
+    const Real T = 10.0;
+
+    const Comm comm_time = Comm::World();
+    const Integer N_fine = 100 / comm_time.Size() + 1;
+    const SDC<Real> ode_solver(Order);
+    Integer iter_count;
+    Real error;
+    ode_solver.Parareal(&u, T, u0, fn, comm_time, N_fine, 4, 3, (Real)1e-8, -1, &iter_count, &error);
+
+    if (!comm_time.Rank()) {
+      printf("u = %e;  ", u[0]);
+      printf("error = %e;  ", ref_sol(T) - u[0]);
+      printf("parareal_iter = %d;  \n", (int)iter_count);
+    }
+  }
+
+  template <class Real> SDC<Real>::SDC(const Integer Order_, const Comm& comm_) : order(Order_), sweep(SDCSweep::GaussSeidel), comm(comm_) {
     SCTL_ASSERT(order >= 2); // TODO: use explicit Euler if order == 1
 
     #ifdef SCTL_QUAD_T
@@ -143,6 +168,10 @@ namespace sctl {
 
   template <class Real> Integer SDC<Real>::Order() const { return order; }
 
+  template <class Real> void SDC<Real>::SetSweep(const SDCSweep sweep_) { sweep = sweep_; }
+
+  template <class Real> SDCSweep SDC<Real>::GetSweep() const { return sweep; }
+
   // solve u = u0 + \int_0^{dt} F(u)
   template <class Real> void SDC<Real>::operator()(Vector<Real>* u, const Real dt, const Vector<Real>& u0, const Fn0& F, Integer N_picard, const Real tol_picard, Real* error_interp, Real* error_picard, Integer* iter_count, Matrix<Real>* u_substep) const {
     if (N_picard < 0) N_picard = order;
@@ -207,6 +236,33 @@ namespace sctl {
         break;
       }
 
+      if (sweep == SDCSweep::Jacobi) { // Picard sweep, evaluate F at all substeps concurrently
+        Vector<Integer> abort_flag(order);
+        abort_flag = 0;
+        #pragma omp parallel for schedule(dynamic)
+        for (Long i = 1; i < order; i++) {
+          const Vector<Real> v_1(DOF, Mv[i], false);
+          Vector<Real> u_1(DOF, Mu[i], false);
+          Vector<Real> f1_1(DOF, Mf1[i], false);
+          for (Long j = 0; j < DOF; j++) {
+            u_1[j] = u0[j] + v_1[j] * dt;
+          }
+          F(&f1_1, u_1, picard_iter, i);
+          if (!f1_1.Dim()) abort_flag[i] = 1;
+        }
+        for (Long i = 1; i < order; i++) {
+          if (abort_flag[i]) { // abort
+            u->ReInit(0);
+            if (error_interp) (*error_interp) = -1;
+            if (error_picard) (*error_picard) = -1;
+            if (iter_count) (*iter_count) = -1;
+            return;
+          }
+        }
+        Mf0 = Mf1;
+        continue;
+      }
+
       for (Long i = 1; i < order; i++) {
         const Vector<Real> f0_0(DOF, Mf0[i-1], false);
         const Vector<Real> f1_0(DOF, Mf1[i-1], false);
@@ -316,6 +372,80 @@ namespace sctl {
     return AdaptiveSolve(u, dt, T, u0, fn, tol, monitor_callback, continue_with_errors, error);
   }
 
+  template <class Real> void SDC<Real>::Parareal(Vector<Real>* u, const Real T, const Vector<Real>& u0, const Fn0& F, const Comm& comm_time, const Integer N_fine, const Integer N_coarse, const Integer coarse_order, const Real tol, Integer max_iter, Integer* iter_count, Real* error) const {
+    const Integer Np = comm_time.Size();
+    const Integer rank = comm_time.Rank();
+    const Long DOF = u0.Dim();
+    const Real dT = T / Np;
+    if (max_iter < 0) max_iter = Np;
+
+    const SDC<Real> coarse_solver(coarse_order, comm);
+    const auto propagate = [&F,DOF,dT](Vector<Real>* u, const Vector<Real>& u0, const SDC<Real>& solver, const Integer N) {
+      (*u) = u0;
+      Vector<Real> u_;
+      for (Integer i = 0; i < N; i++) {
+        solver(&u_, dT/N, *u, F);
+        SCTL_ASSERT_MSG(u_.Dim() == DOF, "SDC time-step failed in Parareal.");
+        u->Swap(u_);
+      }
+    };
+
+    Vector<Real> U = u0; // initial state of this time slice
+    Vector<Real> U_end, G_end, F_end; // final state of this time slice, and its coarse and fine approximations
+    Vector<Real> send_buff;
+    void* send_req = nullptr;
+    const auto recv_state = [&comm_time,rank](Vector<Real>& U, const Integer tag) {
+      if (rank == 0) return;
+      comm_time.Wait(comm_time.Irecv(U.begin(), U.Dim(), rank-1, tag));
+    };
+    const auto send_state = [&comm_time,rank,Np,&send_buff,&send_req](const Vector<Real>& U, const Integer tag) {
+      if (rank == Np-1) return;
+      if (send_req) comm_time.Wait(send_req);
+      send_buff = U;
+      send_req = comm_time.Isend(send_buff.begin(), send_buff.Dim(), rank+1, tag);
+    };
+
+    // Initial prediction with the coarse propagator (sequential)
+    recv_state(U, 0);
+    propagate(&G_end, U, coarse_solver, N_coarse);
+    U_end = G_end;
+    send_state(U_end, 0);
+
+    Integer iter = 0;
+    Real error_ = 0;
+    while (iter < max_iter) {
+      propagate(&F_end, U, *this, N_fine); // fine propagator (in parallel)
+      iter++;
+
+      // Parareal correction: U_end = G(U) + F(U_old) - G(U_old) (sequential)
+      Vector<Real> U_end_new = F_end - G_end;
+      recv_state(U, iter);
+      propagate(&G_end, U, coarse_solver, N_coarse);
+      U_end_new += G_end;
+      send_state(U_end_new, iter);
+
+      StaticArray<Real,2> err{max_norm(U_end_new - U_end), 0};
+      comm_time.Allreduce(err+0, err+1, 1, CommOp::MAX);
+      error_ = err[1];
+      U_end.Swap(U_end_new);
+      if (error_ <= tol) break;
+    }
+    if (send_req) comm_time.Wait(send_req);
+
+    if (u->Dim() != DOF) u->ReInit(DOF);
+    (*u) = U_end;
+    comm_time.Bcast(u->begin(), DOF, Np-1);
+    if (iter_count) (*iter_count) = iter;
+    if (error) (*error) = error_;
+  }
+
+  template <class Real> void SDC<Real>::Parareal(Vector<Real>* u, const Real T, const Vector<Real>& u0, const Fn1& F, const Comm& comm_time, const Integer N_fine, const Integer N_coarse, const Integer coarse_order, const Real tol, Integer max_iter, Integer* iter_count, Real* error) const {
+    const auto fn = [&F](Vector<Real>* dudt, const Vector<Real>& u, const Integer correction_idx, const Integer substep_idx) {
+      F(dudt, u);
+    };
+    Parareal(u, T, u0, fn, comm_time, N_fine, N_coarse, coarse_order, tol, max_iter, iter_count, error);
+  }
+
   template <class Real> template <class Container> Real SDC<Real>::max_norm(const Container& M) const {
     StaticArray<Real,2> max_val{0,0};
     for (const auto x : M) max_val[0] = std::max<Real>(max_val[0], fabs((Real)x));
@@ -2,6 +2,7 @@
 #define _SCTL_OMPUTILS_HPP_
 
 #include <iterator>         // for iterator_traits
+#include <type_traits>      // for enable_if, is_integral, make_unsigned
 
 #include "sctl/common.hpp"  // for sctl
 
@@ -27,7 +28,9 @@ namespace omp_par {
 template <class ConstIter, class Iter, class Int, class StrictWeakOrdering> void merge(ConstIter A_, ConstIter A_last, ConstIter B_, ConstIter B_last, Iter C_, Int p, StrictWeakOrdering comp);
 
 /**
- * Performs merge sort on a range using a custom comparison function.
+ * Performs merge sort on a range using a custom comparison function. If comp is std::less and the RadixKey
+ * specialization of the value type enables it (RadixKey::MergeSort, set for the Morton and Hilbert index types), then
+ * radix_sort is used instead (for arrays of at least SCTL_RADIX_SORT_MIN elements).
  *
  * @tparam T Iterator type for the input range.
  * @tparam StrictWeakOrdering Functor type for comparing elements.
@@ -39,7 +42,7 @@ template <class ConstIter, class Iter, class Int, class StrictWeakOrdering> void
 template <class T, class StrictWeakOrdering> void merge_sort(T A, T A_last, StrictWeakOrdering comp);
 
 /**
- * Performs merge sort on a range.
+ * Performs merge sort on a range (or radix_sort for Morton and Hilbert indices, see above).
  *
  * @tparam T Iterator type for the input range.
  *
@@ -48,6 +51,53 @@ template <class T, class StrictWeakOrdering> void merge_sort(T A, T A_last, Stri
  */
 template <class T> void merge_sort(T A, T A_last);
 
+/**
+ * Traits class for radix sorting. A specialization for the type T maps each value to an unsigned integer key (of type
+ * KeyType) such that the keys have the same ordering as the values under operator<. Specializations are provided for
+ * integral types and for the Morton and Hilbert index types. MergeSort selects whether merge_sort dispatches to
+ * radix_sort for the type; this is only set for the Morton and Hilbert indices, whose keys are clustered in the high
+ * digits (radix sort of arbitrary 64-bit integers needs all the passes and can be slower than a comparison sort).
+ *
+ * @tparam T Value type.
+ */
+template <class T, class Enable = void> struct RadixKey {
+  static constexpr bool Enabled = false;
+  static constexpr bool MergeSort = false;
+};
+
+template <class T> struct RadixKey<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T,bool>::value>::type> {
+  static constexpr bool Enabled = true;
+  static constexpr bool MergeSort = false;
+  typedef typename std::make_unsigned<T>::type KeyType;
+  static KeyType Key(const T& a);
+};
+
+/**
+ * Performs a parallel LSD radix sort on a range. The value type must have a RadixKey specialization. The sort is
+ * stable and the passes over key digits that are the same for all elements are skipped. merge_sort uses this
+ * automatically for the Morton and Hilbert indices when called with the default comparison function. Ranges that
+ * are not pointers or sctl::Iterator are copied to a contiguous buffer first.
+ *
+ * @tparam T Iterator type for the input range.
+ *
+ * @param A Beginning iterator of the range.
+ * @param A_last Ending iterator of the range.
+ */
+template <class T> void radix_sort(T A, T A_last);
+
+/**
+ * Performs a parallel LSD radix sort on a range of key-value pairs, ordered by the key `key_fn(a)` of each element.
+ * The key type must have a RadixKey specialization. The sort is stable.
+ *
+ * @tparam T Iterator type for the input range.
+ * @tparam KeyFn Functor type returning the sort key of an element.
+ *
+ * @param A Beginning iterator of the range.
+ * @param A_last Ending iterator of the range.
+ * @param key_fn Functor returning the sort key of an element.
+ */
+template <class T, class KeyFn> void radix_sort(T A, T A_last, KeyFn key_fn);
+
 /**
  * Reduces the elements in a range to a single value.
  *
@@ -5,6 +5,8 @@
 #include <algorithm>          // for lower_bound, sort, merge
 #include <functional>         // for less
 #include <iterator>           // for iterator_traits
+#include <type_traits>        // for decay, integral_constant, is_same, is_signed
+#include <utility>            // for swap
 
 #include "sctl/common.hpp"    // for Integer, SCTL_UNUSED, sctl
 #include "sctl/ompUtils.hpp"  // for merge_sort, merge, reduce, scan
@@ -94,12 +96,33 @@ template <class ConstIter, class Iter, class Int, class StrictWeakOrdering> inli
   }
 }
 
+namespace omp_par_detail {
+  // Use radix_sort in merge_sort when comp is std::less and the RadixKey specialization of the value type enables it.
+  template <class ValType, class StrictWeakOrdering> struct UseRadixSort {
+    static constexpr bool value = false;
+  };
+  template <class ValType> struct UseRadixSort<ValType, std::less<ValType>> {
+    static constexpr bool value = omp_par::RadixKey<ValType>::Enabled && omp_par::RadixKey<ValType>::MergeSort;
+  };
+
+  template <class T> void radix_sort(T A, T A_last, std::false_type) {
+    SCTL_ASSERT(false);
+  }
+  template <class T> void radix_sort(T A, T A_last, std::true_type) {
+    omp_par::radix_sort(A, A_last);
+  }
+}
+
 template <class T, class StrictWeakOrdering> inline void omp_par::merge_sort(T A, T A_last, StrictWeakOrdering comp) {
   typedef typename std::iterator_traits<T>::difference_type _DiffType;
   typedef typename std::iterator_traits<T>::value_type _ValType;
 
   int p = omp_get_max_threads();
   _DiffType N = A_last - A;
+  if (omp_par_detail::UseRadixSort<_ValType, StrictWeakOrdering>::value && N >= SCTL_RADIX_SORT_MIN) {
+    omp_par_detail::radix_sort(A, A_last, std::integral_constant<bool, omp_par_detail::UseRadixSort<_ValType, StrictWeakOrdering>::value>());
+    return;
+  }
   if (N < 2 * p) {
     std::sort(A, A_last, comp);
     return;
@@ -153,6 +176,101 @@ template <class T> inline void omp_par::merge_sort(T A, T A_last) {
   omp_par::merge_sort(A, A_last, std::less<_ValType>());
 }
 
+template <class T> inline typename omp_par::RadixKey<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T,bool>::value>::type>::KeyType omp_par::RadixKey<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T,bool>::value>::type>::Key(const T& a) {
+  constexpr KeyType sign_bit = (std::is_signed<T>::value ? ((KeyType)1) << (8 * sizeof(KeyType) - 1) : 0);
+  return ((KeyType)a) ^ sign_bit; // flip the sign bit so that negative values come first
+}
+
+template <class T> inline void omp_par::radix_sort(T A, T A_last) {
+  typedef typename std::iterator_traits<T>::value_type _ValType;
+  omp_par::radix_sort(A, A_last, [](const _ValType& a) -> const _ValType& { return a; });
+}
+
+template <class T, class KeyFn> inline void omp_par::radix_sort(T A, T A_last, KeyFn key_fn) {
+  typedef typename std::iterator_traits<T>::value_type _ValType;
+  typedef typename std::decay<decltype(key_fn(*A))>::type _KeyValType;
+  typedef RadixKey<_KeyValType> _KeyTraits;
+  typedef typename _KeyTraits::KeyType _KeyType;
+  static_assert(_KeyTraits::Enabled, "Key type cannot be radix sorted.");
+  static constexpr Integer RADIX_BITS = 8;
+  static constexpr Long RADIX = ((Long)1) << RADIX_BITS;
+
+  const Long N = A_last - A;
+  if (N < SCTL_RADIX_SORT_MIN) {
+    omp_par::merge_sort(A, A_last, [&key_fn](const _ValType& a, const _ValType& b) { return _KeyTraits::Key(key_fn(a)) < _KeyTraits::Key(key_fn(b)); });
+    return;
+  }
+
+  const Integer p = omp_get_max_threads();
+  Vector<Long> split(p + 1);
+  for (Integer i = 0; i <= p; i++) split[i] = (i * N) / p;
+
+  // Compute the keys and find the digits in which they differ.
+  Vector<_KeyType> key0(N), key1(N);
+  Vector<_KeyType> diff_(p);
+#pragma omp parallel for schedule(static)
+  for (Integer tid = 0; tid < p; tid++) {
+    _KeyType diff = 0;
+    const _KeyType k0 = _KeyTraits::Key(key_fn(A[0]));
+    for (Long i = split[tid]; i < split[tid + 1]; i++) {
+      key0[i] = _KeyTraits::Key(key_fn(A[i]));
+      diff |= (key0[i] ^ k0);
+    }
+    diff_[tid] = diff;
+  }
+  _KeyType diff = 0;
+  for (Integer tid = 0; tid < p; tid++) diff |= diff_[tid];
+
+  // One counting sort pass for each digit; the counts of each thread are offset so that the scatter is stable.
+  if (!diff) return;
+  constexpr bool contiguous = std::is_pointer<T>::value || std::is_same<T, Iterator<_ValType>>::value;
+  Vector<_ValType> val0, val1(N);
+  if (!contiguous) { // copy to a contiguous buffer
+    val0.ReInit(N);
+#pragma omp parallel for schedule(static)
+    for (Long i = 0; i < N; i++) val0[i] = A[i];
+  }
+  const Iterator<_ValType> A_ = (contiguous ? Ptr2Itr<_ValType>(&A[0], N) : val0.begin());
+  Iterator<_ValType> V0 = A_, V1 = val1.begin();
+  Iterator<_KeyType> K0 = key0.begin(), K1 = key1.begin();
+  Vector<Long> offset(p * RADIX);
+  for (Integer shift = 0; shift < (Integer)(8 * sizeof(_KeyType)); shift += RADIX_BITS) {
+    if (!((diff >> shift) & (RADIX - 1))) continue;
+
+#pragma omp parallel for schedule(static)
+    for (Integer tid = 0; tid < p; tid++) {
+      Iterator<Long> cnt = offset.begin() + tid * RADIX;
+      for (Long j = 0; j < RADIX; j++) cnt[j] = 0;
+      for (Long i = split[tid]; i < split[tid + 1]; i++) cnt[(K0[i] >> shift) & (RADIX - 1)]++;
+    }
+    Long dsp = 0;
+    for (Long j = 0; j < RADIX; j++) {
+      for (Integer tid = 0; tid < p; tid++) {
+        const Long cnt = offset[tid * RADIX + j];
+        offset[tid * RADIX + j] = dsp;
+        dsp += cnt;
+      }
+    }
+#pragma omp parallel for schedule(static)
+    for (Integer tid = 0; tid < p; tid++) {
+      Iterator<Long> dsp_ = offset.begin() + tid * RADIX;
+      for (Long i = split[tid]; i < split[tid + 1]; i++) {
+        const Long j = dsp_[(K0[i] >> shift) & (RADIX - 1)]++;
+        K1[j] = K0[i];
+        V1[j] = V0[i];
+      }
+    }
+    std::swap(K0, K1);
+    std::swap(V0, V1);
+  }
+
+  // The final result should be in A.
+  if (!contiguous || V0 != A_) {
+#pragma omp parallel for schedule(static)
+    for (Long i = 0; i < N; i++) A[i] = V0[i];
+  }
+}
+
 template <class ConstIter, class Int> typename std::iterator_traits<ConstIter>::value_type omp_par::reduce(ConstIter A, Int cnt) {
   typedef typename std::iterator_traits<ConstIter>::value_type ValueType;
   ValueType sum = 0;
@@ -17,19 +17,28 @@ class Comm;
 enum class CommOp;
 
 /**
- * Counters available to use with the Profile class.
+ * Counters available to use with the Profile class. The HW_* counters are
+ * hardware performance counters (summed over all threads of the process);
+ * these are only available when compiled with SCTL_HAVE_PERF_EVENT (Linux)
+ * and enabled with Profile::EnableHWCounters, and are zero otherwise.
  */
 enum class ProfileCounter: Long {
   TIME,
   FLOP,
   HEAP_ALLOC_COUNT,
   HEAP_ALLOC_BYTES,
+  HEAP_ALLOC_CACHED_COUNT,
   HEAP_FREE_COUNT,
   HEAP_FREE_BYTES,
   PROF_MPI_BYTES,
   PROF_MPI_COUNT,
   PROF_MPI_COLLECTIVE_BYTES,
   PROF_MPI_COLLECTIVE_COUNT,
+  HW_CYCLES,
+  HW_INSTRUCTIONS,
+  HW_L1D_MISSES,
+  HW_LLC_MISSES,
+  HW_VECTOR_INSTRUCTIONS,
   CUSTOM1,
   CUSTOM2,
   CUSTOM3,
@@ -59,6 +68,16 @@ class Profile {
    */
   static bool Enable(bool state);
 
+  /**
+   * Enable or disable the hardware performance counters (HW_*). They are
+   * disabled by default; when enabled, each Tic/Toc outside of parallel
+   * regions reads the counters of every OpenMP thread (one read() system call
+   * per thread). Requires SCTL_HAVE_PERF_EVENT, otherwise this has no effect.
+   *
+   * @return the last state of the hardware counters.
+   */
+  static bool EnableHWCounters(bool state);
+
   /**
    * Marks the start of a profiling block.
    *
@@ -70,11 +89,16 @@ class Profile {
    * profiling block.
    *
    * @param[in] verbose whether to display profiling block on stdout.
+   *
+   * @note Inside an OpenMP parallel region the block is not added to the
+   * profiling table (see print()); it is only recorded in the trace when
+   * EnableTrace() is on.
    */
   static void Tic(const char* name, const Comm* comm_ptr = nullptr, bool sync = false, Integer verbose = 1);
 
   /**
-   * Marks the end of a profiling block.
+   * Marks the end of a profiling block. As for Tic(), inside an OpenMP
+   * parallel region the block is only recorded in the trace.
    */
   static void Toc();
 
@@ -120,12 +144,18 @@ class Profile {
    * f : FLOP (in GFLOPs)
    * alloc_count : number of heap allocations
    * alloc_m     : amount of heap memory allocated (in GB)
+   * alloc_cached_count : number of heap allocations served from per-thread caches
    * free_count  : number of times heap freed
    * free_m      : amount of heap memory freed (in GB)
    * comm_count      : number of Comm point-to-point communications
    * comm_m          : amount of memory transferred in p-to-p comm (in GB)
    * comm_coll_count : number of collective communications
    * comm_coll_m     : amount of memory transferred in collective comm (in GB)
+   * cycles    : CPU cycles
+   * instr     : instructions retired
+   * l1_miss   : L1 data cache read misses
+   * llc_miss  : last level cache misses
+   * vec_instr : vector instructions (raw event from the environment variable SCTL_PERF_VECTOR_EVENT)
    * custom1, custom2, custom3, custom4, custom5 : custom counters
    *
    * The following additional and derived quantities are also predefined:
@@ -133,6 +163,10 @@ class Profile {
    * f/s : FLOP/TIME (in GFLOP/s)
    * m   : change in heap memory (in GB)
    * comm_size : constant value Comm::Size()
+   * ipc       : instr/cycles
+   * llc_m     : memory traffic estimated from LLC misses (in GB)
+   * llc_m/s   : llc_m/TIME, estimated memory bandwidth (in GB/s)
+   * ai        : FLOP/llc_m, arithmetic intensity (in FLOP/byte)
    *
    * Also defined are *_min (minimum), *_max (maximum), and *_avg (average) across processes,
    * where * can be one of {t, f, f/s, m}.
@@ -187,12 +221,68 @@ class Profile {
    */
   static void reset();
 
+  /**
+   * Enable or disable recording of a timeline trace. When enabled, each
+   * profiling block (subject to the same verbosity filter as the profiling
+   * table) is logged with its begin and end time stamps and the counter
+   * values into a ring buffer of the calling thread, keeping only the most
+   * recent events. Unlike the profiling table, Tic/Toc may also be called
+   * from inside OpenMP parallel regions; these blocks are recorded only in
+   * the trace.
+   *
+   * @param[in] state enable or disable trace recording.
+   *
+   * @param[in] capacity maximum number of events kept for each thread.
+   *
+   * @param[in] comm_ptr pointer to Comm object (can be nullptr). If given, all
+   * processes synchronize (Comm::Barrier()) to set a common reference time.
+   */
+  static void EnableTrace(bool state, Long capacity = 100000, const Comm* comm_ptr = nullptr);
+
+  /**
+   * Write the recorded trace in the Chrome Trace Event JSON format (which can
+   * be viewed with chrome://tracing or https://ui.perfetto.dev). Each process
+   * is shown as a separate pid and each thread as a separate tid; the change
+   * in counter values (which are per-process totals) over each block is
+   * included in the event args.
+   *
+   * @param[in] fname output file name.
+   *
+   * @param[in] comm_ptr pointer to Comm object (can be nullptr). If given,
+   * events from all processes are gathered and written by rank 0.
+   */
+  static void WriteTrace(const std::string& fname, const Comm* comm_ptr = nullptr);
+
  private:
 
   struct ProfileData;
 
+  struct TraceEvent;
+
+  struct TraceBuffer;
+
   static ProfileData& GetProfData();
 
+  /**
+   * Open hardware counters for each OpenMP thread (if not already open).
+   */
+  static void OpenHWCounters();
+
+  /**
+   * Set HW_* counters to the current totals over all threads.
+   */
+  static void UpdateHWCounters();
+
+  /**
+   * Return the trace buffer of the calling thread (nullptr if trace recording is disabled).
+   */
+  static TraceBuffer* GetTraceBuffer();
+
+  /**
+   * Append a begin (with name) or end event to the trace buffer of the calling thread.
+   */
+  static void RecordTraceEvent(TraceBuffer* buffer, const char* name, bool begin);
+
 
   class ExprScalar;
 
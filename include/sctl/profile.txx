@@ -6,6 +6,8 @@
 #include <stdio.h>            // for size_t, sprintf
 #include <algorithm>          // for max
 #include <array>              // for array
+#include <cstring>            // for strncpy
+#include <fstream>            // for ofstream
 #include <atomic>             // for atomic, memory_order
 #include <iomanip>            // for operator<<, setw
 #include <iostream>           // for basic_ostream, operator<<, cout, left
@@ -14,6 +16,12 @@
 #include <stack>              // for stack
 #include <string>             // for basic_string, allocator, char_traits
 #include <vector>             // for vector
+#ifdef SCTL_HAVE_PERF_EVENT
+#include <cstdlib>            // for getenv, strtoull
+#include <linux/perf_event.h> // for perf_event_attr, PERF_TYPE_HARDWARE, ...
+#include <sys/syscall.h>      // for __NR_perf_event_open
+#include <unistd.h>           // for syscall, read
+#endif
 
 #include "sctl/common.hpp"    // for Long, SCTL_ASSERT, Integer, SCTL_ASSERT...
 #include "sctl/profile.hpp"   // for Profile, ProfileCounter, operator*, ope...
@@ -236,9 +244,31 @@ namespace sctl {
 
 
 
+  struct Profile::TraceEvent {
+    std::array<char, 48> name;        // block name (begin events only)
+    bool begin;                        // begin or end of block
+    std::array<Long, Nfield> counters; // counter values (TIME is ns since the reference time)
+  };
+
+  struct Profile::TraceBuffer {
+    Long trace_id;                 // trace for which this buffer was created
+    Integer tid;                   // index in ProfileData::trace_buffers
+    Integer omp_tid;               // OpenMP thread number at creation
+    Long count;                    // number of events recorded (including overwritten ones)
+    std::vector<TraceEvent> events;  // ring buffer of events
+    std::vector<Integer> verb;     // verbosity stack for blocks inside parallel regions
+  };
+
   struct Profile::ProfileData {
     const double t0;
     bool enable_state;
+    bool hw_state;
+
+    bool trace_state;
+    Long trace_id;
+    Long trace_capacity;
+    double trace_t0;
+    std::vector<TraceBuffer*> trace_buffers;
 
     std::stack<int> verb;
     std::stack<bool> sync;
@@ -252,7 +282,10 @@ namespace sctl {
     std::array<std::atomic<Long>, Nfield> counters;
     std::map<std::string, ProfExpr> prof_fields;
 
-    inline ProfileData() : t0(omp_get_wtime()), enable_state(false) {
+    static constexpr Integer Nhw = (Integer)ProfileCounter::HW_VECTOR_INSTRUCTIONS - (Integer)ProfileCounter::HW_CYCLES + 1;
+    std::vector<std::array<int, Nhw>> hw_fd;  // perf_event file descriptors of each thread (-1 if unavailable)
+
+    inline ProfileData() : t0(omp_get_wtime()), enable_state(false), hw_state(false), trace_state(false), trace_id(0), trace_capacity(0), trace_t0(t0) {
       constexpr double gb_scale = (1./1024/1024/1024);
       for (auto& x : counters) x = 0;
 
@@ -268,6 +301,7 @@ namespace sctl {
 
       prof_fields["alloc_count"] = ExprScalar(ProfileCounter::HEAP_ALLOC_COUNT);
       prof_fields["alloc_m"]     = ExprScalar(ProfileCounter::HEAP_ALLOC_BYTES) * gb_scale;
+      prof_fields["alloc_cached_count"] = ExprScalar(ProfileCounter::HEAP_ALLOC_CACHED_COUNT);
       prof_fields["free_count"]  = ExprScalar(ProfileCounter::HEAP_FREE_COUNT);
       prof_fields["free_m" ]     = ExprScalar(ProfileCounter::HEAP_FREE_BYTES) * gb_scale;
       prof_fields["m"]           = prof_fields["alloc_m"] - prof_fields["free_m"];
@@ -277,6 +311,16 @@ namespace sctl {
       prof_fields["comm_coll_m"]     = ExprScalar(ProfileCounter::PROF_MPI_COLLECTIVE_BYTES) * gb_scale;
       prof_fields["comm_coll_count"] = ExprScalar(ProfileCounter::PROF_MPI_COLLECTIVE_COUNT);
 
+      prof_fields["cycles"]    = ExprScalar(ProfileCounter::HW_CYCLES);
+      prof_fields["instr"]     = ExprScalar(ProfileCounter::HW_INSTRUCTIONS);
+      prof_fields["l1_miss"]   = ExprScalar(ProfileCounter::HW_L1D_MISSES);
+      prof_fields["llc_miss"]  = ExprScalar(ProfileCounter::HW_LLC_MISSES);
+      prof_fields["vec_instr"] = ExprScalar(ProfileCounter::HW_VECTOR_INSTRUCTIONS);
+      prof_fields["ipc"]       = prof_fields["instr"] / prof_fields["cycles"];
+      prof_fields["llc_m"]     = prof_fields["llc_miss"] * (64 * gb_scale);
+      prof_fields["llc_m/s"]   = prof_fields["llc_m"] / prof_fields["t"];
+      prof_fields["ai"]        = prof_fields["f"] / prof_fields["llc_m"];
+
       prof_fields["custom1"] = ExprScalar(ProfileCounter::CUSTOM1);
       prof_fields["custom2"] = ExprScalar(ProfileCounter::CUSTOM2);
       prof_fields["custom3"] = ExprScalar(ProfileCounter::CUSTOM3);
@@ -308,6 +352,17 @@ namespace sctl {
       prof_fields["m_max"] = Profile::CommReduceExpr(prof_fields["m"], CommOp::MAX);
       prof_fields["m_avg"] = Profile::CommReduceExpr(prof_fields["m"], CommOp::SUM) / prof_fields["comm_size"];
     }
+
+    inline ~ProfileData() {
+      for (auto buffer : trace_buffers) delete buffer;
+      trace_buffers.clear();
+  #ifdef SCTL_HAVE_PERF_EVENT
+      for (const auto& fd : hw_fd) {
+        for (const auto x : fd) if (x >= 0) close(x);
+      }
+  #endif
+      hw_fd.clear();
+    }
   };
 
   inline Profile::ProfileData& Profile::GetProfData() {
@@ -357,6 +412,85 @@ namespace sctl {
     return orig_val;
   }
 
+  inline bool Profile::EnableHWCounters(bool state) {
+    ProfileData& prof = GetProfData();
+    const bool orig_val = prof.hw_state;
+  #ifdef SCTL_HAVE_PERF_EVENT
+    prof.hw_state = state;
+    if (state) OpenHWCounters();
+  #else
+    SCTL_UNUSED(state);
+  #endif
+    return orig_val;
+  }
+
+  inline void Profile::OpenHWCounters() {
+  #ifdef SCTL_HAVE_PERF_EVENT
+    ProfileData& prof = GetProfData();
+    constexpr Integer Nhw = ProfileData::Nhw;
+    const auto open_counter = [](uint32_t type, uint64_t config, int group_fd) {
+      perf_event_attr attr;
+      attr = perf_event_attr();
+      attr.size = sizeof(attr);
+      attr.type = type;
+      attr.config = config;
+      attr.read_format = PERF_FORMAT_GROUP;  // read all counters of the thread at once (from the group leader)
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      return (int)syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);  // calling thread, any CPU
+    };
+    const char* vec_event = getenv("SCTL_PERF_VECTOR_EVENT");
+    const uint64_t vec_config = (vec_event ? strtoull(vec_event, nullptr, 0) : 0);
+
+    std::atomic<bool> available(true);
+    #pragma omp parallel
+    {
+      static thread_local bool opened = false;
+      if (!opened) {
+        std::array<int, Nhw> fd;
+        fd.fill(-1);
+        fd[0] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);  // group leader
+        if (fd[0] >= 0) {
+          fd[1] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, fd[0]);
+          fd[2] = open_counter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), fd[0]);
+          fd[3] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, fd[0]);
+          fd[4] = (vec_config ? open_counter(PERF_TYPE_RAW, vec_config, fd[0]) : -1);
+        } else {
+          available = false;
+        }
+        #pragma omp critical(SCTL_PROFILE_HW)
+        prof.hw_fd.push_back(fd);
+        opened = true;
+      }
+    }
+    static bool warned = false;
+    if (!available && !warned) {
+      SCTL_WARN("hardware performance counters are not available (check /proc/sys/kernel/perf_event_paranoid).");
+      warned = true;
+    }
+  #endif
+  }
+
+  inline void Profile::UpdateHWCounters() {
+  #ifdef SCTL_HAVE_PERF_EVENT
+    ProfileData& prof = GetProfData();
+    if (!prof.hw_state) return;
+    constexpr Integer Nhw = ProfileData::Nhw;
+    std::array<Long, Nhw> sum;
+    sum.fill(0);
+    #pragma omp critical(SCTL_PROFILE_HW)
+    for (const auto& fd : prof.hw_fd) {
+      if (fd[0] < 0) continue;
+      uint64_t value[Nhw+1];  // number of counters in the group, followed by their values in the order they were opened
+      if (read(fd[0], value, sizeof(value)) < (ssize_t)sizeof(uint64_t)) continue;
+      for (Integer i = 0, j = 1; i < Nhw && j <= (Integer)value[0]; i++) {
+        if (fd[i] >= 0) sum[i] += (Long)value[j++];
+      }
+    }
+    for (Integer i = 0; i < Nhw; i++) prof.counters[(Long)ProfileCounter::HW_CYCLES + i].store(sum[i], std::memory_order_relaxed);
+  #endif
+  }
+
   inline Profile::ProfileTable Profile::get_table(const std::vector<std::string>& field_names_in, const Comm* comm_) {
     ProfileTable result;
     const std::vector<std::string> field_names_default = [&comm_]() -> std::vector<std::string> {
@@ -521,6 +655,133 @@ namespace sctl {
     prof.e_log.clear();
     prof.n_log.clear();
     prof.counter_log.clear();
+
+    for (auto buffer : prof.trace_buffers) {
+      buffer->count = 0;
+      buffer->events.clear();
+    }
+  }
+
+  inline void Profile::EnableTrace(bool state, Long capacity, const Comm* comm_) {
+    ProfileData& prof = GetProfData();
+    if (state) {
+      SCTL_ASSERT(capacity > 0);
+      for (auto buffer : prof.trace_buffers) delete buffer;
+      prof.trace_buffers.clear();
+      prof.trace_id++;
+      prof.trace_capacity = capacity;
+      if (comm_) comm_->Barrier();
+      prof.trace_t0 = omp_get_wtime();
+    }
+    prof.trace_state = state;
+  }
+
+  inline void Profile::WriteTrace(const std::string& fname, const Comm* comm_) {
+    static const char* counter_name[] = {"t", "flop", "alloc_count", "alloc_bytes", "alloc_cached_count", "free_count", "free_bytes",
+      "comm_bytes", "comm_count", "comm_coll_bytes", "comm_coll_count", "cycles", "instr", "l1_miss", "llc_miss", "vec_instr", "custom1", "custom2", "custom3", "custom4", "custom5"};
+    static_assert(sizeof(counter_name) / sizeof(counter_name[0]) == Nfield, "missing name for a ProfileCounter.");
+    const auto json_str = [](const char* str) {
+      std::string s;
+      for (const char* c = str; *c; c++) {
+        if (*c == '"' || *c == '\\') s.push_back('\\');
+        if ((unsigned char)*c >= 0x20) s.push_back(*c);
+      }
+      return s;
+    };
+
+    ProfileData& prof = GetProfData();
+    const Integer rank = (comm_ ? comm_->Rank() : 0);
+    std::stringstream ss;
+    ss << std::setprecision(12);
+    ss << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank << ",\"args\":{\"name\":\"rank " << rank << "\"}}";
+    for (const auto buffer : prof.trace_buffers) {
+      ss << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << rank << ",\"tid\":" << buffer->tid;
+      ss << ",\"args\":{\"name\":\"thread " << buffer->tid << " (omp " << buffer->omp_tid << ")\"}}";
+
+      const Long capacity = (Long)prof.trace_capacity;
+      std::stack<Long> idx_stack;  // open blocks (matching begin events)
+      for (Long k = std::max<Long>(0, buffer->count - capacity); k < buffer->count; k++) {
+        const TraceEvent& e = buffer->events[k % capacity];
+        if (e.begin) {
+          idx_stack.push(k);
+        } else if (!idx_stack.empty()) {  // skip end events of blocks that were overwritten
+          const TraceEvent& b = buffer->events[idx_stack.top() % capacity];
+          idx_stack.pop();
+
+          const Long t_idx = (Long)ProfileCounter::TIME;
+          ss << ",\n{\"name\":\"" << json_str(&b.name[0]) << "\",\"ph\":\"X\",\"pid\":" << rank << ",\"tid\":" << buffer->tid;
+          ss << ",\"ts\":" << b.counters[t_idx] * 1e-3 << ",\"dur\":" << (e.counters[t_idx] - b.counters[t_idx]) * 1e-3 << ",\"args\":{";
+          bool first = true;
+          for (Long i = 0; i < Nfield; i++) {
+            if (i == t_idx || e.counters[i] == b.counters[i]) continue;
+            ss << (first ? "" : ",") << "\"" << counter_name[i] << "\":" << e.counters[i] - b.counters[i];
+            first = false;
+          }
+          ss << "}}";
+        }
+      }
+    }
+    std::string str = ss.str();
+
+    if (comm_ && comm_->Size() > 1) {  // Gather events from all processes
+      const Long np = comm_->Size();
+      const Long len = (Long)str.size();
+      std::vector<Long> rcounts(np), rdispls(np + 1, 0);
+      comm_->Allgather(Ptr2ConstItr<Long>(&len, 1), 1, Ptr2Itr<Long>(&rcounts[0], np), 1);
+      for (Long i = 0; i < np; i++) rdispls[i + 1] = rdispls[i] + rcounts[i];
+      std::string rbuf(rdispls[np], ' ');
+      comm_->Allgatherv(Ptr2ConstItr<char>(&str[0], len), len, Ptr2Itr<char>(&rbuf[0], rdispls[np]), Ptr2ConstItr<Long>(&rcounts[0], np), Ptr2ConstItr<Long>(&rdispls[0], np));
+      str.clear();
+      for (Long i = 0; i < np; i++) {
+        if (i) str += ",\n";
+        str += rbuf.substr(rdispls[i], rcounts[i]);
+      }
+    }
+
+    if (rank == 0) {
+      std::ofstream file(fname, std::ofstream::out | std::ofstream::trunc);
+      if (!file.good()) {
+        SCTL_WARN("Unable to open trace file: " << fname);
+        return;
+      }
+      file << "{\"traceEvents\":[\n" << str << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+  }
+
+  inline Profile::TraceBuffer* Profile::GetTraceBuffer() {
+    ProfileData& prof = GetProfData();
+    if (!prof.trace_state) return nullptr;
+
+    static thread_local TraceBuffer* buffer = nullptr;  // owned by ProfileData::trace_buffers
+    static thread_local Long trace_id = 0;
+    if (trace_id != prof.trace_id) {  // new trace buffer for this thread
+      buffer = new TraceBuffer{prof.trace_id, 0, omp_get_thread_num(), 0, std::vector<TraceEvent>(), std::vector<Integer>()};
+      #pragma omp critical(SCTL_PROFILE_TRACE)
+      {
+        buffer->tid = (Integer)prof.trace_buffers.size();
+        prof.trace_buffers.push_back(buffer);
+      }
+      trace_id = prof.trace_id;
+    }
+    return buffer;
+  }
+
+  inline void Profile::RecordTraceEvent(TraceBuffer* buffer, const char* name, bool begin) {
+    ProfileData& prof = GetProfData();
+    const Long idx = buffer->count % prof.trace_capacity;
+    if (idx == (Long)buffer->events.size()) buffer->events.push_back(TraceEvent());
+    TraceEvent& e = buffer->events[idx];
+
+    if (name) {
+      strncpy(&e.name[0], name, e.name.size() - 1);
+      e.name[e.name.size() - 1] = '\0';
+    } else {
+      e.name[0] = '\0';
+    }
+    e.begin = begin;
+    for (Long i = 0; i < Nfield; i++) e.counters[i] = prof.counters[i].load(std::memory_order_relaxed);
+    e.counters[(Long)ProfileCounter::TIME] = (Long)((omp_get_wtime() - prof.trace_t0) * 1e9);
+    buffer->count++;
   }
 
 
@@ -535,6 +796,14 @@ namespace sctl {
     if (!prof.enable_state) return;
     // sync_=true;
 
+    if (omp_in_parallel()) {  // record only in the trace
+      TraceBuffer* buffer = GetTraceBuffer();
+      if (!buffer) return;
+      buffer->verb.push_back((buffer->verb.size() ? buffer->verb.back() : (prof.verb.size() ? prof.verb.top() : 0)) + verbose);
+      if (buffer->verb.back() <= SCTL_PROFILE) RecordTraceEvent(buffer, name_, true);
+      return;
+    }
+
     prof.verb.push((prof.verb.size()?prof.verb.top():0) + verbose);
     if (prof.verb.top() <= SCTL_PROFILE) {
       if (comm_ != nullptr && sync_) comm_->Barrier();
@@ -550,14 +819,26 @@ namespace sctl {
 
       prof.e_log.push_back(true);
       prof.n_log.push_back(prof.name.top());
+      UpdateHWCounters();
       prof.counters[(Long)ProfileCounter::TIME].store((Long)((omp_get_wtime()-prof.t0)*1e9),std::memory_order_relaxed);
       for (Long i = 0; i < Nfield; i++) prof.counter_log.push_back(prof.counters[i]);
+
+      TraceBuffer* buffer = GetTraceBuffer();
+      if (buffer) RecordTraceEvent(buffer, name_, true);
     }
   }
 
   inline void Profile::Toc() {
     ProfileData& prof = GetProfData();
     if (!prof.enable_state) return;
+    if (omp_in_parallel()) {  // record only in the trace
+      TraceBuffer* buffer = GetTraceBuffer();
+      if (!buffer) return;
+      SCTL_ASSERT_MSG(!buffer->verb.empty(), "Unbalanced extra Toc()");
+      if (buffer->verb.back() <= SCTL_PROFILE) RecordTraceEvent(buffer, nullptr, false);
+      buffer->verb.pop_back();
+      return;
+    }
     SCTL_ASSERT_MSG(!prof.verb.empty(), "Unbalanced extra Toc()");
 
     if (prof.verb.top() <= SCTL_PROFILE) {
@@ -570,9 +851,13 @@ namespace sctl {
 
       prof.e_log.push_back(false);
       prof.n_log.push_back(name_);
+      UpdateHWCounters();
       prof.counters[(Long)ProfileCounter::TIME].store((Long)((omp_get_wtime()-prof.t0)*1e9),std::memory_order_relaxed);
       for (Long i = 0; i < Nfield; i++) prof.counter_log.push_back(prof.counters[i]);
 
+      TraceBuffer* buffer = GetTraceBuffer();
+      if (buffer) RecordTraceEvent(buffer, nullptr, false);
+
   #ifndef NDEBUG
       if (comm_ != nullptr && sync_) comm_->Barrier();
   #endif
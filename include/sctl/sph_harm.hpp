@@ -1,6 +1,12 @@
 #ifndef _SCTL_SPH_HARM_HPP_
 #define _SCTL_SPH_HARM_HPP_
 
+#include <functional>         // for function
+#include <future>             // for shared_future
+#include <map>                // for map
+#include <memory>             // for shared_ptr
+#include <string>             // for string
+#include <tuple>              // for tuple
 #include <vector>             // for vector
 
 #include "sctl/common.hpp"    // for Long, Integer, sctl
@@ -8,7 +14,6 @@
 #include "sctl/comm.txx"      // for Comm::World
 #include "sctl/iterator.hpp"  // for Iterator
 #include "sctl/iterator.txx"  // for NullIterator
-#include "sctl/mem_mgr.txx"   // for aligned_delete, aligned_new
 
 #define SCTL_SHMAXDEG 1024
 
@@ -37,6 +42,7 @@ enum class SHCArrange {
 
 template <class Real> class SphericalHarmonics{
   static constexpr Integer COORD_DIM = 3;
+  static constexpr Long FFT_BATCH = 32; // number of grid rows in each batched FFT
 
   public:
 
@@ -66,6 +72,35 @@ template <class Real> class SphericalHarmonics{
      */
     static void SHC2Grid(const Vector<Real>& S, SHCArrange arrange, Long p, Long Nt, Long Np, Vector<Real>* X, Vector<Real>* X_theta=nullptr, Vector<Real>* X_phi=nullptr);
 
+    /**
+     * Compute spherical harmonic coefficients from grid values for a batch of independent surfaces. The surfaces are
+     * split into contiguous groups (one for each OpenMP thread, balanced by the number of components) and each group is
+     * transformed together: the Fourier stage is done with batched FFTs and the Legendre stage for each order m is a
+     * single GEMM over the surfaces in the group (stored block-interleaved by m). With fewer surfaces than threads, the
+     * batch is a single group and the threads split its rows instead. This is much faster than separate calls to
+     * Grid2SHC for many surfaces at low order.
+     * \param[in] X Grid values for each surface (in the same format as for Grid2SHC, with one or more components).
+     * \param[in] Nt Number of grid points \theta \in (0,pi).
+     * \param[in] Np Number of grid points \phi \in (0,2*pi).
+     * \param[in] p Order of spherical harmonic expansion.
+     * \param[in] arrange Arrangement of the coefficients.
+     * \param[out] S Spherical harmonic coefficients for each surface.
+     */
+    static void Grid2SHCBatch(const Vector<Vector<Real>>& X, Long Nt, Long Np, Long p, Vector<Vector<Real>>& S, SHCArrange arrange);
+
+    /**
+     * Evaluate grid values from spherical harmonic coefficients for a batch of independent surfaces (see Grid2SHCBatch).
+     * \param[in] S Spherical harmonic coefficients for each surface (in the same format as for SHC2Grid).
+     * \param[in] arrange Arrangement of the coefficients.
+     * \param[in] p Order of spherical harmonic expansion.
+     * \param[in] Nt Number of grid points \theta \in (0,pi).
+     * \param[in] Np Number of grid points \phi \in (0,2*pi).
+     * \param[out] X Grid values for each surface.
+     * \param[out] X_theta \theta derivative of X evaluated at grid points.
+     * \param[out] X_phi \phi derivative of X evaluated at grid points.
+     */
+    static void SHC2GridBatch(const Vector<Vector<Real>>& S, SHCArrange arrange, Long p, Long Nt, Long Np, Vector<Vector<Real>>* X, Vector<Vector<Real>>* X_theta=nullptr, Vector<Vector<Real>>* X_phi=nullptr);
+
     /**
      * Evaluate point values from spherical harmonic coefficients.
      * \param[in] S Spherical harmonic coefficients.
@@ -153,9 +188,42 @@ template <class Real> class SphericalHarmonics{
     static void test();
 
     /**
-     * Clear all precomputed data. This must be done before the program exits to avoid memory leaks.
+     * Clear all precomputed data.
      */
-    static void Clear() { MatrixStore().Resize(0); }
+    static void Clear() { MatrixStore().Clear(); }
+
+    /**
+     * Set the memory limit for the precomputed data (unlimited by default). The least recently used precomputed
+     * matrices are discarded (and recomputed when needed again) to stay within this limit. This is a process-wide
+     * setting for each Real type.
+     *
+     * @param[in] max_bytes The memory limit in bytes.
+     */
+    static void SetMemoryLimit(Long max_bytes) { MatrixStore().SetMemoryLimit(max_bytes); }
+
+    /**
+     * @return The memory (in bytes) used by the precomputed data.
+     */
+    static Long MemoryUsage() { return MatrixStore().MemoryUsage(); }
+
+    /**
+     * Save the precomputed data (currently in memory) to a file, so that it can be loaded in later runs instead of
+     * computing it again.
+     *
+     * @param[in] fname The file name.
+     *
+     * @return true on success.
+     */
+    static bool SavePrecomp(const std::string& fname) { return MatrixStore().Save(fname); }
+
+    /**
+     * Load precomputed data from a file written by SavePrecomp (with the same Real type).
+     *
+     * @param[in] fname The file name.
+     *
+     * @return true on success.
+     */
+    static bool LoadPrecomp(const std::string& fname) { return MatrixStore().Load(fname); }
 
   private:
 
@@ -186,77 +254,85 @@ template <class Real> class SphericalHarmonics{
     static void LegPolyDeriv(Vector<Real>& poly_val, const Vector<Real>& X, Long degree);
     static void LegPolyDeriv_(Vector<Real>& poly_val, const Vector<Real>& X, Long degree);
 
-    static const Vector<Real>& SingularWeights(Long p1);
+    static std::shared_ptr<const Vector<Real>> SingularWeights(Long p1);
 
-    static const Matrix<Real>& MatFourier(Long p0, Long p1);
-    static const Matrix<Real>& MatFourierInv(Long p0, Long p1);
-    static const Matrix<Real>& MatFourierGrad(Long p0, Long p1);
+    static std::shared_ptr<const Matrix<Real>> MatFourier(Long p0, Long p1);
+    static std::shared_ptr<const Matrix<Real>> MatFourierInv(Long p0, Long p1);
+    static std::shared_ptr<const Matrix<Real>> MatFourierGrad(Long p0, Long p1);
 
-    static const FFT<Real>& OpFourier(Long Np);
-    static const FFT<Real>& OpFourierInv(Long Np);
+    static std::shared_ptr<const FFT<Real>> OpFourier(Long Np, Long howmany = 1);
+    static std::shared_ptr<const FFT<Real>> OpFourierInv(Long Np, Long howmany = 1);
 
-    static const std::vector<Matrix<Real>>& MatLegendre(Long p0, Long p1);
-    static const std::vector<Matrix<Real>>& MatLegendreInv(Long p0, Long p1);
-    static const std::vector<Matrix<Real>>& MatLegendreGrad(Long p0, Long p1);
+    static std::shared_ptr<const std::vector<Matrix<Real>>> MatLegendre(Long p0, Long p1);
+    static std::shared_ptr<const std::vector<Matrix<Real>>> MatLegendreInv(Long p0, Long p1);
+    static std::shared_ptr<const std::vector<Matrix<Real>>> MatLegendreGrad(Long p0, Long p1);
 
     // Evaluate all Spherical Harmonic basis functions up to order p at (theta, phi) coordinates.
     static void SHBasisEval(Long p, const Vector<Real>& theta_phi, Matrix<Real>& M);
     static void VecSHBasisEval(Long p, const Vector<Real>& theta_phi, Matrix<Real>& M);
 
-    static const std::vector<Matrix<Real>>& MatRotate(Long p0);
+    static std::shared_ptr<const std::vector<Matrix<Real>>> MatRotate(Long p0);
 
     template <bool SLayer, bool DLayer> static void StokesSingularInteg_(const Vector<Real>& X0, Long p0, Long p1, Vector<Real>& SL, Vector<Real>& DL);
 
-    struct MatrixStorage{
-      MatrixStorage() : Mfft_(NullIterator<FFT<Real>>()), Mfftinv_(NullIterator<FFT<Real>>()) {
-        Resize(SCTL_SHMAXDEG);
-      }
-      ~MatrixStorage() {
-        Resize(0);
-      }
+    /**
+     * Thread-safe store for the precomputed data. Each entry is identified by its kind and the orders (p0, p1) and it
+     * is built only once; other threads requesting the same entry at the same time wait for it to be ready, while
+     * the lookups of other entries are not blocked. Entries are returned as shared pointers so that they remain
+     * valid while in use even if they are evicted from the store. When the total size of the stored data exceeds
+     * the memory limit, the least recently used entries are evicted (except pinned entries).
+     */
+    class MatrixStorage {
+      public:
+
+      enum class Kind : Integer {LegNodes, LegWeights, SingWeights, Fourier, FourierInv, FourierGrad, FFT, FFTInv, Legendre, LegendreInv, LegendreGrad, Rotate};
+
+      MatrixStorage();
+
       MatrixStorage(const MatrixStorage&) = delete;
       MatrixStorage& operator=(const MatrixStorage&) = delete;
 
-      void Resize(Long size){
-        Qx_ .resize(size);
-        Qw_ .resize(size);
-        Sw_ .resize(size);
-        Mf_ .resize(size*size);
-        Mdf_.resize(size*size);
-        Ml_ .resize(size*size);
-        Mdl_.resize(size*size);
-        Mr_ .resize(size);
-        Mfinv_ .resize(size*size);
-        Mlinv_ .resize(size*size);
-
-        aligned_delete(Mfft_);
-        aligned_delete(Mfftinv_);
-        if (size) {
-          Mfft_ = aligned_new<FFT<Real>>(size);
-          Mfftinv_ = aligned_new<FFT<Real>>(size);
-        } else {
-          Mfft_ = NullIterator<FFT<Real>>();
-          Mfftinv_ = NullIterator<FFT<Real>>();
-        }
-      }
-
-      std::vector<Vector<Real>> Qx_;
-      std::vector<Vector<Real>> Qw_;
-      std::vector<Vector<Real>> Sw_;
-      std::vector<Matrix<Real>> Mf_ ;
-      std::vector<Matrix<Real>> Mdf_;
-      std::vector<std::vector<Matrix<Real>>> Ml_ ;
-      std::vector<std::vector<Matrix<Real>>> Mdl_;
-      std::vector<std::vector<Matrix<Real>>> Mr_;
-      std::vector<Matrix<Real>> Mfinv_ ;
-      std::vector<std::vector<Matrix<Real>>> Mlinv_ ;
-
-      Iterator<FFT<Real>> Mfft_;
-      Iterator<FFT<Real>> Mfftinv_;
+      /**
+       * Get an entry from the store, building it with build_fn if it does not exist.
+       */
+      template <class T> std::shared_ptr<const T> Get(Kind kind, Long p0, Long p1, const std::function<std::shared_ptr<const T>()>& build_fn, bool pinned = false);
+
+      void Clear();
+
+      void SetMemoryLimit(Long max_bytes);
+
+      Long MemoryUsage() const;
+
+      bool Save(const std::string& fname) const;
+
+      bool Load(const std::string& fname);
+
+      private:
+
+      using Key = std::tuple<Integer,Long,Long>;
+
+      struct Entry {
+        std::shared_future<std::shared_ptr<const void>> data;
+        Long bytes; // size of the data (zero while it is being built)
+        Long last_use;
+        bool pinned;
+        bool ready;
+      };
+
+      static Long Bytes(const Vector<Real>& v);
+      static Long Bytes(const Matrix<Real>& M);
+      static Long Bytes(const std::vector<Matrix<Real>>& M);
+      static Long Bytes(const FFT<Real>& F);
+
+      void Insert(const Key& key, const std::shared_ptr<const void>& data, Long bytes, bool pinned); // must be called in critical section SCTL_SH_STORE
+      void Evict(const Key& keep); // must be called in critical section SCTL_SH_STORE
+
+      std::map<Key, Entry> entries;
+      Long mem_limit, mem_usage, use_count;
     };
+
     static MatrixStorage& MatrixStore(){
       static MatrixStorage storage;
-      if (!storage.Qx_.size()) storage.Resize(SCTL_SHMAXDEG);
       return storage;
     }
 };
@@ -9,9 +9,14 @@
 #include <cassert>                // for assert
 #include <cmath>                  // for M_PI
 #include <cstdint>                // for int32_t, uint32_t, uint8_t, uint16_t
+#include <cstdio>                 // for fopen, fread, fwrite
+#include <exception>              // for current_exception
 #include <fstream>                // for basic_ostream, operator<<, basic_of...
 #include <iomanip>                // for operator<<, setfill, setw
 #include <iostream>               // for cout
+#include <future>                 // for promise, shared_future
+#include <limits>                 // for numeric_limits
+#include <memory>                 // for shared_ptr, make_shared
 #include <sstream>                // for basic_stringstream
 #include <string>                 // for char_traits, allocator, basic_string
 #include <vector>                 // for vector
@@ -294,6 +299,61 @@ template <class Real> void SphericalHarmonics<Real>::test() {
   print_coeff(Xcoeff);
 
   //SphericalHarmonics<Real>::WriteVTK("test", nullptr, &Xcoeff, sctl::SHCArrange::ROW_MAJOR, p, 32);
+
+  { // Batched transforms for several surfaces, compared with the per-surface transforms
+    Vector<Vector<Real>> Xbatch(9);
+    for (Long k = 0; k < Xbatch.Dim(); k++) { // surface k has k%3 components
+      Xbatch[k].ReInit((k%3) * Xgrid.Dim());
+      for (Long i = 0; i < Xbatch[k].Dim(); i++) Xbatch[k][i] = Xgrid[i % Xgrid.Dim()] * (i / Xgrid.Dim() + k + 1);
+    }
+    const Integer omp_p = omp_get_max_threads();
+    for (const Integer nthreads : {1, 4}) { // a single group, and surfaces split between threads
+      omp_set_num_threads(nthreads);
+      Vector<Vector<Real>> Sbatch, Ybatch, Ybatch_theta, Ybatch_phi;
+      Grid2SHCBatch(Xbatch, Nt, Np, p, Sbatch, sctl::SHCArrange::ROW_MAJOR);
+      SHC2GridBatch(Sbatch, sctl::SHCArrange::ROW_MAJOR, p, Nt, Np, &Ybatch, &Ybatch_theta, &Ybatch_phi);
+
+      Real err = 0;
+      SCTL_ASSERT(Sbatch.Dim() == Xbatch.Dim() && Ybatch.Dim() == Xbatch.Dim());
+      for (Long k = 0; k < Xbatch.Dim(); k++) {
+        Vector<Real> Sk, Yk, Yk_theta, Yk_phi;
+        Grid2SHC(Xbatch[k], Nt, Np, p, Sk, sctl::SHCArrange::ROW_MAJOR);
+        SHC2Grid(Sk, sctl::SHCArrange::ROW_MAJOR, p, Nt, Np, &Yk, &Yk_theta, &Yk_phi);
+        SCTL_ASSERT(Sbatch[k].Dim() == Sk.Dim() && Ybatch[k].Dim() == Yk.Dim());
+        SCTL_ASSERT(Ybatch_theta[k].Dim() == Yk_theta.Dim() && Ybatch_phi[k].Dim() == Yk_phi.Dim());
+        for (Long i = 0; i < Sk.Dim(); i++) err = std::max<Real>(err, fabs(Sbatch[k][i] - Sk[i]));
+        for (Long i = 0; i < Yk.Dim(); i++) {
+          err = std::max<Real>(err, fabs(Ybatch[k][i] - Yk[i]));
+          err = std::max<Real>(err, fabs(Ybatch_theta[k][i] - Yk_theta[i]));
+          err = std::max<Real>(err, fabs(Ybatch_phi[k][i] - Yk_phi[i]));
+        }
+      }
+      std::cout<<"Batched transform error ("<<nthreads<<" threads): "<<err<<'\n';
+      SCTL_ASSERT(err < 100*machine_eps<Real>());
+    }
+    omp_set_num_threads(omp_p);
+  }
+
+  { // Precomputation store: save/load and memory limit
+    const std::string fname = "sph_harm_precomp.bin";
+    Vector<Real> Xcoeff0, Xcoeff1;
+    Grid2SHC(Xgrid, Nt, Np, p, Xcoeff0, sctl::SHCArrange::ROW_MAJOR);
+    const bool saved = SavePrecomp(fname);
+    Clear();
+    const bool loaded = LoadPrecomp(fname);
+    std::remove(fname.c_str());
+    const Long mem_loaded = MemoryUsage();
+
+    SetMemoryLimit(0); // keep only the pinned Legendre nodes and weights
+    Grid2SHC(Xgrid, Nt, Np, p, Xcoeff1, sctl::SHCArrange::ROW_MAJOR);
+    const Long mem_limited = MemoryUsage();
+    SetMemoryLimit(std::numeric_limits<Long>::max());
+
+    Real err = 0;
+    for (Long i = 0; i < Xcoeff0.Dim(); i++) err = std::max<Real>(err, fabs(Xcoeff0[i] - Xcoeff1[i]));
+    std::cout<<"Precomp save/load: "<<saved<<'/'<<loaded<<", memory (loaded/limited): "<<mem_loaded<<'/'<<mem_limited<<", error: "<<err<<'\n';
+    SCTL_ASSERT(saved && loaded && mem_limited < mem_loaded && err < 100*machine_eps<Real>());
+  }
   Clear();
 }
 
@@ -312,6 +372,98 @@ template <class Real> void SphericalHarmonics<Real>::SHC2Grid(const Vector<Real>
   SHC2Grid_(B0, p0, Nt, Np, X, X_phi, X_theta);
 }
 
+template <class Real> void SphericalHarmonics<Real>::Grid2SHCBatch(const Vector<Vector<Real>>& X, Long Nt, Long Np, Long p1, Vector<Vector<Real>>& S, SHCArrange arrange){
+  const Long Nsurf = X.Dim();
+  Vector<Long> cnt(Nsurf), dsp(Nsurf+1); // number of grid functions for each surface
+  dsp[0] = 0;
+  for (Long k = 0; k < Nsurf; k++) {
+    cnt[k] = X[k].Dim() / (Np*Nt);
+    dsp[k+1] = dsp[k] + cnt[k];
+    assert(X[k].Dim() == cnt[k]*Np*Nt);
+  }
+
+  const Integer Ngrp = (Nsurf >= omp_get_max_threads() ? omp_get_max_threads() : 1); // split the surfaces between threads when there are enough of them
+  Vector<Long> grp_dsp(Ngrp+1); // contiguous groups of surfaces, balanced by the number of grid functions
+  for (Integer g = 0, k = 0; g <= Ngrp; g++) {
+    while (k < Nsurf && dsp[k] < dsp[Nsurf] * g / Ngrp) k++;
+    grp_dsp[g] = (g == Ngrp ? Nsurf : k);
+  }
+
+  if (S.Dim() != Nsurf) S.ReInit(Nsurf);
+  #pragma omp parallel for schedule(static) if (Ngrp > 1)
+  for (Integer g = 0; g < Ngrp; g++) { // transform each group together (the inner parallel regions are serial when the groups run in parallel)
+    const Long k0 = grp_dsp[g], k1 = grp_dsp[g+1];
+    const Long N = dsp[k1] - dsp[k0];
+
+    Vector<Real> X_(N*Np*Nt);
+    for (Long k = k0; k < k1; k++) { // X_ <-- concat(X)
+      for (Long i = 0; i < X[k].Dim(); i++) X_[(dsp[k]-dsp[k0])*Np*Nt + i] = X[k][i];
+    }
+
+    Vector<Real> B1(N*(p1+1)*(p1+1)), S_;
+    Grid2SHC_(X_, Nt, Np, p1, B1);
+    SHCArrange0(B1, p1, S_, arrange);
+    const Long M = (N ? S_.Dim() / N : 0);
+
+    for (Long k = k0; k < k1; k++) { // S <-- split(S_)
+      if (S[k].Dim() != cnt[k]*M) S[k].ReInit(cnt[k]*M);
+      for (Long i = 0; i < S[k].Dim(); i++) S[k][i] = S_[(dsp[k]-dsp[k0])*M + i];
+    }
+  }
+}
+
+template <class Real> void SphericalHarmonics<Real>::SHC2GridBatch(const Vector<Vector<Real>>& S, SHCArrange arrange, Long p0, Long Nt, Long Np, Vector<Vector<Real>>* X, Vector<Vector<Real>>* X_theta, Vector<Vector<Real>>* X_phi){
+  Long M = 0;
+  if (arrange == SHCArrange::ALL) M = 2*(p0+1)*(p0+1);
+  if (arrange == SHCArrange::ROW_MAJOR) M = (p0+1)*(p0+2);
+  if (arrange == SHCArrange::COL_MAJOR_NONZERO) M = (p0+1)*(p0+1);
+  if (M == 0) return;
+
+  const Long Nsurf = S.Dim();
+  Vector<Long> cnt(Nsurf), dsp(Nsurf+1); // number of functions for each surface
+  dsp[0] = 0;
+  for (Long k = 0; k < Nsurf; k++) {
+    cnt[k] = S[k].Dim() / M;
+    dsp[k+1] = dsp[k] + cnt[k];
+    assert(S[k].Dim() == cnt[k]*M);
+  }
+
+  const Integer Ngrp = (Nsurf >= omp_get_max_threads() ? omp_get_max_threads() : 1); // split the surfaces between threads when there are enough of them
+  Vector<Long> grp_dsp(Ngrp+1); // contiguous groups of surfaces, balanced by the number of functions
+  for (Integer g = 0, k = 0; g <= Ngrp; g++) {
+    while (k < Nsurf && dsp[k] < dsp[Nsurf] * g / Ngrp) k++;
+    grp_dsp[g] = (g == Ngrp ? Nsurf : k);
+  }
+
+  if (X       && X      ->Dim() != Nsurf) X      ->ReInit(Nsurf);
+  if (X_theta && X_theta->Dim() != Nsurf) X_theta->ReInit(Nsurf);
+  if (X_phi   && X_phi  ->Dim() != Nsurf) X_phi  ->ReInit(Nsurf);
+  #pragma omp parallel for schedule(static) if (Ngrp > 1)
+  for (Integer g = 0; g < Ngrp; g++) { // transform each group together (the inner parallel regions are serial when the groups run in parallel)
+    const Long k0 = grp_dsp[g], k1 = grp_dsp[g+1];
+    const Long N = dsp[k1] - dsp[k0];
+
+    Vector<Real> S_(N*M);
+    for (Long k = k0; k < k1; k++) { // S_ <-- concat(S)
+      for (Long i = 0; i < S[k].Dim(); i++) S_[(dsp[k]-dsp[k0])*M + i] = S[k][i];
+    }
+
+    Vector<Real> B0, X_, X_theta_, X_phi_;
+    SHCArrange1(S_, arrange, p0, B0);
+    SHC2Grid_(B0, p0, Nt, Np, (X ? &X_ : nullptr), (X_phi ? &X_phi_ : nullptr), (X_theta ? &X_theta_ : nullptr));
+
+    const auto split = [&cnt,&dsp,k0,k1,Nt,Np](Vector<Vector<Real>>& Y, const Vector<Real>& Y_) { // Y <-- split(Y_)
+      for (Long k = k0; k < k1; k++) {
+        if (Y[k].Dim() != cnt[k]*Np*Nt) Y[k].ReInit(cnt[k]*Np*Nt);
+        for (Long i = 0; i < Y[k].Dim(); i++) Y[k][i] = Y_[(dsp[k]-dsp[k0])*Np*Nt + i];
+      }
+    };
+    if (X      ) split(*X      , X_      );
+    if (X_theta) split(*X_theta, X_theta_);
+    if (X_phi  ) split(*X_phi  , X_phi_  );
+  }
+}
+
 template <class Real> void SphericalHarmonics<Real>::SHCEval(const Vector<Real>& S, SHCArrange arrange, Long p0, const Vector<Real>& theta_phi, Vector<Real>& X) {
   Long M = (p0+1) * (p0+1);
 
@@ -2185,15 +2337,18 @@ template <class Real> void SphericalHarmonics<Real>::StokesEvalKSelf(const Vecto
 
 
 template <class Real> void SphericalHarmonics<Real>::Grid2SHC_(const Vector<Real>& X, Long Nt, Long Np, Long p1, Vector<Real>& B1){
-  const auto& Mf = OpFourierInv(Np);
-  assert(Mf.Dim(0) == Np);
-
-  const std::vector<Matrix<Real>>& Ml = SphericalHarmonics<Real>::MatLegendreInv(Nt-1,p1);
-  assert((Long)Ml.size() == p1+1);
-
   Long N = X.Dim() / (Np*Nt);
   assert(X.Dim() == N*Np*Nt);
 
+  const Long batch = std::max<Long>(1, std::min<Long>((Long)FFT_BATCH, N*Nt)); // (cast to avoid odr-use before C++17)
+  const auto Mf_ = OpFourierInv(Np, batch); // hold references until done
+  const auto& Mf = *Mf_;
+  assert(Mf.Dim(0) == Np * batch);
+
+  const auto Ml_ = SphericalHarmonics<Real>::MatLegendreInv(Nt-1,p1);
+  const std::vector<Matrix<Real>>& Ml = *Ml_;
+  assert((Long)Ml.size() == p1+1);
+
   Vector<Real> B0((2*p1+1) * N*Nt);
   #pragma omp parallel
   { // B0 <-- Transpose(FFT(X))
@@ -2202,19 +2357,30 @@ template <class Real> void SphericalHarmonics<Real>::Grid2SHC_(const Vector<Real
     Long a=(tid+0)*N*Nt/omp_p;
     Long b=(tid+1)*N*Nt/omp_p;
 
-    Vector<Real> buff(Mf.Dim(1));
-    Long fft_coeff_len = std::min(buff.Dim(), 2*p1+2);
+    const Long Ncoeff = Mf.Dim(1) / batch;
+    const Long fft_coeff_len = std::min(Ncoeff, 2*p1+2);
+    Vector<Real> buff(Mf.Dim(1)), Xbuff;
     Matrix<Real> B0_(2*p1+1, N*Nt, B0.begin(), false);
-    const Matrix<Real> MX(N * Nt, Np, (Iterator<Real>)X.begin(), false);
-    for (Long i = a; i < b; i++) {
-      { // buff <-- FFT(Xi)
-        const Vector<Real> Xi(Np, (Iterator<Real>)X.begin() + Np * i, false);
+    for (Long i0 = a; i0 < b; i0 += batch) { // FFT in batches of rows
+      const Long cnt = std::min(batch, b - i0);
+      if (cnt == batch) { // buff <-- FFT(X[i0:i0+cnt])
+        const Vector<Real> Xi(cnt * Np, (Iterator<Real>)X.begin() + Np * i0, false);
         Mf.Execute(Xi, buff);
+      } else { // pad the last batch with zeros to use the same plan
+        if (Xbuff.Dim() != Mf.Dim(0)) Xbuff.ReInit(Mf.Dim(0));
+        for (Long i = 0; i < cnt * Np; i++) Xbuff[i] = X[Np * i0 + i];
+        for (Long i = cnt * Np; i < Xbuff.Dim(); i++) Xbuff[i] = 0;
+        Mf.Execute(Xbuff, buff);
       }
       { // B0 <-- Transpose(buff)
-        B0_[0][i] = buff[0]; // skipping buff[1] == 0
-        for (Long j = 2; j < fft_coeff_len; j++) B0_[j-1][i] = buff[j];
-        for (Long j = fft_coeff_len; j < 2*p1+2; j++) B0_[j-1][i] = 0;
+        const Matrix<Real> Mbuff(cnt, Ncoeff, buff.begin(), false);
+        for (Long k = 0; k < cnt; k++) B0_[0][i0+k] = Mbuff[k][0]; // skipping buff[1] == 0
+        for (Long j = 2; j < fft_coeff_len; j++) {
+          for (Long k = 0; k < cnt; k++) B0_[j-1][i0+k] = Mbuff[k][j];
+        }
+        for (Long j = fft_coeff_len; j < 2*p1+2; j++) {
+          for (Long k = 0; k < cnt; k++) B0_[j-1][i0+k] = 0;
+        }
       }
     }
   }
@@ -2449,17 +2615,21 @@ template <class Real> void SphericalHarmonics<Real>::SHCArrange1(const Vector<Re
   }
 }
 template <class Real> void SphericalHarmonics<Real>::SHC2Grid_(const Vector<Real>& B0, Long p0, Long Nt, Long Np, Vector<Real>* X, Vector<Real>* X_phi, Vector<Real>* X_theta){
-  const auto& Mf = OpFourier(Np);
-  assert(Mf.Dim(1) == Np);
+  Long N = B0.Dim() / ((p0+1)*(p0+1));
+  assert(B0.Dim() == N*(p0+1)*(p0+1));
+
+  const Long batch = std::max<Long>(1, std::min<Long>((Long)FFT_BATCH, N*Nt)); // (cast to avoid odr-use before C++17)
+  const auto Mf_ = OpFourier(Np, batch); // hold references until done
+  const auto& Mf = *Mf_;
+  assert(Mf.Dim(1) == Np * batch);
 
-  const std::vector<Matrix<Real>>& Ml =SphericalHarmonics<Real>::MatLegendre    (p0,Nt-1);
-  const std::vector<Matrix<Real>>& Mdl=SphericalHarmonics<Real>::MatLegendreGrad(p0,Nt-1);
+  const auto Ml_ =SphericalHarmonics<Real>::MatLegendre    (p0,Nt-1);
+  const auto Mdl_=SphericalHarmonics<Real>::MatLegendreGrad(p0,Nt-1);
+  const std::vector<Matrix<Real>>& Ml =*Ml_;
+  const std::vector<Matrix<Real>>& Mdl=*Mdl_;
   assert((Long)Ml .size() == p0+1);
   assert((Long)Mdl.size() == p0+1);
 
-  Long N = B0.Dim() / ((p0+1)*(p0+1));
-  assert(B0.Dim() == N*(p0+1)*(p0+1));
-
   if(X       && X      ->Dim()!=N*Np*Nt) X      ->ReInit(N*Np*Nt);
   if(X_theta && X_theta->Dim()!=N*Np*Nt) X_theta->ReInit(N*Np*Nt);
   if(X_phi   && X_phi  ->Dim()!=N*Np*Nt) X_phi  ->ReInit(N*Np*Nt);
@@ -2500,38 +2670,48 @@ template <class Real> void SphericalHarmonics<Real>::SHC2Grid_(const Vector<Real
       Long a=(tid+0)*N*Nt/omp_p;
       Long b=(tid+1)*N*Nt/omp_p;
 
-      Vector<Real> buff(Mf.Dim(0)); buff = 0;
-      Long fft_coeff_len = std::min(buff.Dim(), 2*p0+2);
+      const Long Ncoeff = Mf.Dim(0) / batch;
+      const Long fft_coeff_len = std::min(Ncoeff, 2*p0+2);
+      Vector<Real> buff(Mf.Dim(0)), Xbuff;
       Matrix<Real> B1_(2*p0+1, N*Nt, B1.begin(), false);
-      for (Long i = a; i < b; i++) {
-        { // buff <-- Transpose(B1)
-          buff[0] = B1_[0][i];
-          buff[1] = 0;
-          for (Long j = 2; j < fft_coeff_len; j++) buff[j] = B1_[j-1][i];
-          for (Long j = fft_coeff_len; j < buff.Dim(); j++) buff[j] = 0;
+      const auto fft_rows = [&Mf,&buff,&Xbuff,Np,batch](Iterator<Real> Xi, const Long cnt) { // Xi <-- FFT(buff) for the first cnt rows
+        if (cnt == batch) {
+          Vector<Real> Xi_(cnt * Np, Xi, false);
+          Mf.Execute(buff, Xi_);
+        } else { // the last batch is padded with zeros to use the same plan
+          if (Xbuff.Dim() != Mf.Dim(1)) Xbuff.ReInit(Mf.Dim(1));
+          Mf.Execute(buff, Xbuff);
+          for (Long i = 0; i < cnt * Np; i++) Xi[i] = Xbuff[i];
         }
-        { // X <-- FFT(buff)
-          Vector<Real> Xi(Np, X->begin() + Np * i, false);
-          Mf.Execute(buff, Xi);
+      };
+      for (Long i0 = a; i0 < b; i0 += batch) { // FFT in batches of rows
+        const Long cnt = std::min(batch, b - i0);
+        Matrix<Real> Mbuff(batch, Ncoeff, buff.begin(), false);
+        { // buff <-- Transpose(B1)
+          Mbuff.SetZero();
+          for (Long k = 0; k < cnt; k++) Mbuff[k][0] = B1_[0][i0+k];
+          for (Long j = 2; j < fft_coeff_len; j++) {
+            for (Long k = 0; k < cnt; k++) Mbuff[k][j] = B1_[j-1][i0+k];
+          }
         }
+        if(X) fft_rows(X->begin() + Np * i0, cnt); // X <-- FFT(buff)
 
         if(X_phi){ // Evaluate Fourier gradient
           { // buff <-- Transpose(B1)
-            buff[0] = 0;
-            buff[1] = 0;
-            for (Long j = 2; j < fft_coeff_len; j++) buff[j] = B1_[j-1][i];
-            for (Long j = fft_coeff_len; j < buff.Dim(); j++) buff[j] = 0;
-            for (Long j = 1; j < buff.Dim()/2; j++) {
-              Real x = buff[2*j+0];
-              Real y = buff[2*j+1];
-              buff[2*j+0] = -j*y;
-              buff[2*j+1] =  j*x;
+            Mbuff.SetZero();
+            for (Long j = 2; j < fft_coeff_len; j++) {
+              for (Long k = 0; k < cnt; k++) Mbuff[k][j] = B1_[j-1][i0+k];
+            }
+            for (Long k = 0; k < cnt; k++) {
+              for (Long j = 1; j < Ncoeff/2; j++) {
+                Real x = Mbuff[k][2*j+0];
+                Real y = Mbuff[k][2*j+1];
+                Mbuff[k][2*j+0] = -j*y;
+                Mbuff[k][2*j+1] =  j*x;
+              }
             }
           }
-          { // X_phi <-- FFT(buff)
-            Vector<Real> Xi(Np, X_phi->begin() + Np * i, false);
-            Mf.Execute(buff, Xi);
-          }
+          fft_rows(X_phi->begin() + Np * i0, cnt); // X_phi <-- FFT(buff)
         }
       }
     }
@@ -2571,20 +2751,31 @@ template <class Real> void SphericalHarmonics<Real>::SHC2Grid_(const Vector<Real
       Long a=(tid+0)*N*Nt/omp_p;
       Long b=(tid+1)*N*Nt/omp_p;
 
-      Vector<Real> buff(Mf.Dim(0)); buff = 0;
-      Long fft_coeff_len = std::min(buff.Dim(), 2*p0+2);
+      const Long Ncoeff = Mf.Dim(0) / batch;
+      const Long fft_coeff_len = std::min(Ncoeff, 2*p0+2);
+      Vector<Real> buff(Mf.Dim(0)), Xbuff;
       Matrix<Real> B1_(2*p0+1, N*Nt, B1.begin(), false);
-      for (Long i = a; i < b; i++) {
-        { // buff <-- Transpose(B1)
-          buff[0] = B1_[0][i];
-          buff[1] = 0;
-          for (Long j = 2; j < fft_coeff_len; j++) buff[j] = B1_[j-1][i];
-          for (Long j = fft_coeff_len; j < buff.Dim(); j++) buff[j] = 0;
+      const auto fft_rows = [&Mf,&buff,&Xbuff,Np,batch](Iterator<Real> Xi, const Long cnt) { // Xi <-- FFT(buff) for the first cnt rows
+        if (cnt == batch) {
+          Vector<Real> Xi_(cnt * Np, Xi, false);
+          Mf.Execute(buff, Xi_);
+        } else { // the last batch is padded with zeros to use the same plan
+          if (Xbuff.Dim() != Mf.Dim(1)) Xbuff.ReInit(Mf.Dim(1));
+          Mf.Execute(buff, Xbuff);
+          for (Long i = 0; i < cnt * Np; i++) Xi[i] = Xbuff[i];
         }
-        { // Xi <-- FFT(buff)
-          Vector<Real> Xi(Np, X_theta->begin() + Np * i, false);
-          Mf.Execute(buff, Xi);
+      };
+      for (Long i0 = a; i0 < b; i0 += batch) { // FFT in batches of rows
+        const Long cnt = std::min(batch, b - i0);
+        Matrix<Real> Mbuff(batch, Ncoeff, buff.begin(), false);
+        { // buff <-- Transpose(B1)
+          Mbuff.SetZero();
+          for (Long k = 0; k < cnt; k++) Mbuff[k][0] = B1_[0][i0+k];
+          for (Long j = 2; j < fft_coeff_len; j++) {
+            for (Long k = 0; k < cnt; k++) Mbuff[k][j] = B1_[j-1][i0+k];
+          }
         }
+        fft_rows(X_theta->begin() + Np * i0, cnt); // X_theta <-- FFT(buff)
       }
     }
   }
@@ -2673,33 +2864,256 @@ template <class Real> void SphericalHarmonics<Real>::LegPolyDeriv_(Vector<Real>&
 }
 
 
+template <class Real> SphericalHarmonics<Real>::MatrixStorage::MatrixStorage() : mem_limit(std::numeric_limits<Long>::max()), mem_usage(0), use_count(0) {}
+
+template <class Real> template <class T> std::shared_ptr<const T> SphericalHarmonics<Real>::MatrixStorage::Get(Kind kind, Long p0, Long p1, const std::function<std::shared_ptr<const T>()>& build_fn, bool pinned) {
+  const Key key((Integer)kind, p0, p1);
+  std::promise<std::shared_ptr<const void>> promise;
+  std::shared_future<std::shared_ptr<const void>> data;
+  bool build = false;
+  #pragma omp critical (SCTL_SH_STORE)
+  {
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+      Entry& e = entries[key];
+      e.data = promise.get_future().share();
+      e.bytes = 0;
+      e.last_use = ++use_count;
+      e.pinned = pinned;
+      e.ready = false;
+      data = e.data;
+      build = true;
+    } else {
+      it->second.last_use = ++use_count;
+      data = it->second.data;
+    }
+  }
+  if (!build) return std::static_pointer_cast<const T>(data.get());
+
+  // Build outside of the critical section, since other entries may be needed to build this one.
+  std::shared_ptr<const T> ptr;
+  try {
+    ptr = build_fn();
+  } catch (...) { // remove the entry so that it can be built again, and pass the exception to the waiting threads
+    #pragma omp critical (SCTL_SH_STORE)
+    {
+      auto it = entries.find(key);
+      if (it != entries.end() && !it->second.ready) entries.erase(it);
+    }
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+  promise.set_value(ptr);
+  #pragma omp critical (SCTL_SH_STORE)
+  {
+    auto it = entries.find(key);
+    if (it != entries.end() && !it->second.ready) { // the store may have been cleared in the meantime
+      it->second.bytes = Bytes(*ptr);
+      it->second.ready = true;
+      mem_usage += it->second.bytes;
+      Evict(key);
+    }
+  }
+  return ptr;
+}
+
+template <class Real> void SphericalHarmonics<Real>::MatrixStorage::Clear() {
+  #pragma omp critical (SCTL_SH_STORE)
+  {
+    entries.clear();
+    mem_usage = 0;
+  }
+}
+
+template <class Real> void SphericalHarmonics<Real>::MatrixStorage::SetMemoryLimit(Long max_bytes) {
+  #pragma omp critical (SCTL_SH_STORE)
+  {
+    mem_limit = max_bytes;
+    Evict(Key(-1, -1, -1));
+  }
+}
+
+template <class Real> Long SphericalHarmonics<Real>::MatrixStorage::MemoryUsage() const {
+  Long usage;
+  #pragma omp critical (SCTL_SH_STORE)
+  usage = mem_usage;
+  return usage;
+}
+
+template <class Real> bool SphericalHarmonics<Real>::MatrixStorage::Save(const std::string& fname) const {
+  std::vector<std::pair<Key, std::shared_ptr<const void>>> data;
+  #pragma omp critical (SCTL_SH_STORE)
+  for (const auto& e : entries) {
+    const Kind kind = (Kind)std::get<0>(e.first);
+    if (e.second.ready && kind != Kind::FFT && kind != Kind::FFTInv) data.push_back(std::make_pair(e.first, e.second.data.get()));
+  }
+
+  FILE* f = fopen(fname.c_str(), "wb");
+  if (f == nullptr) return false;
+  bool success = true;
+  const auto write = [&f,&success](const int64_t* ptr, Long count) {
+    success = success && ((Long)fwrite(ptr, sizeof(int64_t), count, f) == count);
+  };
+  const auto write_mat = [&f,&success,&write](const Matrix<Real>& M) {
+    const int64_t dim[2] = {M.Dim(0), M.Dim(1)};
+    write(dim, 2);
+    const Long N = M.Dim(0) * M.Dim(1);
+    if (N) success = success && ((Long)fwrite(&M[0][0], sizeof(Real), N, f) == N);
+  };
+
+  const int64_t header[3] = {(int64_t)0x4853204c544353 /* "SCTL SH" */, (int64_t)sizeof(Real), (int64_t)data.size()};
+  write(header, 3);
+  for (const auto& d : data) {
+    const Kind kind = (Kind)std::get<0>(d.first);
+    const int64_t key[3] = {std::get<0>(d.first), std::get<1>(d.first), std::get<2>(d.first)};
+    write(key, 3);
+    if (kind == Kind::LegNodes || kind == Kind::LegWeights || kind == Kind::SingWeights) {
+      const auto& V = *std::static_pointer_cast<const Vector<Real>>(d.second);
+      const int64_t Nmat = 1;
+      write(&Nmat, 1);
+      write_mat(Matrix<Real>(1, V.Dim(), (Iterator<Real>)V.begin(), false));
+    } else if (kind == Kind::Fourier || kind == Kind::FourierInv || kind == Kind::FourierGrad) {
+      const int64_t Nmat = 1;
+      write(&Nmat, 1);
+      write_mat(*std::static_pointer_cast<const Matrix<Real>>(d.second));
+    } else {
+      const auto& Mvec = *std::static_pointer_cast<const std::vector<Matrix<Real>>>(d.second);
+      const int64_t Nmat = (int64_t)Mvec.size();
+      write(&Nmat, 1);
+      for (const auto& M : Mvec) write_mat(M);
+    }
+  }
+  fclose(f);
+  return success;
+}
+
+template <class Real> bool SphericalHarmonics<Real>::MatrixStorage::Load(const std::string& fname) {
+  FILE* f = fopen(fname.c_str(), "rb");
+  if (f == nullptr) return false;
+  bool success = true;
+  const auto read = [&f,&success](int64_t* ptr, Long count) {
+    success = success && ((Long)fread(ptr, sizeof(int64_t), count, f) == count);
+  };
+  const auto read_mat = [&f,&success,&read](Matrix<Real>& M) {
+    int64_t dim[2] = {0, 0};
+    read(dim, 2);
+    if (!success || dim[0] < 0 || dim[1] < 0) {
+      success = false;
+      return;
+    }
+    M.ReInit(dim[0], dim[1]);
+    const Long N = M.Dim(0) * M.Dim(1);
+    if (N) success = success && ((Long)fread(&M[0][0], sizeof(Real), N, f) == N);
+  };
+
+  int64_t header[3] = {0, 0, 0};
+  read(header, 3);
+  success = success && (header[0] == (int64_t)0x4853204c544353) && (header[1] == (int64_t)sizeof(Real));
+  for (int64_t i = 0; success && i < header[2]; i++) {
+    int64_t key[3], Nmat = 0;
+    read(key, 3);
+    read(&Nmat, 1);
+    if (!success || Nmat < 0) break;
+    std::vector<Matrix<Real>> Mvec(Nmat);
+    for (auto& M : Mvec) read_mat(M);
+    if (!success) break;
+
+    const Kind kind = (Kind)key[0];
+    std::shared_ptr<const void> data;
+    Long bytes = 0;
+    if (kind == Kind::LegNodes || kind == Kind::LegWeights || kind == Kind::SingWeights) {
+      if (Nmat != 1) { success = false; break; }
+      auto V = std::make_shared<Vector<Real>>(Mvec[0].Dim(0) * Mvec[0].Dim(1), Mvec[0].begin());
+      bytes = Bytes(*V);
+      data = V;
+    } else if (kind == Kind::Fourier || kind == Kind::FourierInv || kind == Kind::FourierGrad) {
+      if (Nmat != 1) { success = false; break; }
+      auto M = std::make_shared<Matrix<Real>>(Mvec[0]);
+      bytes = Bytes(*M);
+      data = M;
+    } else if (kind == Kind::Legendre || kind == Kind::LegendreInv || kind == Kind::LegendreGrad || kind == Kind::Rotate) {
+      auto M = std::make_shared<std::vector<Matrix<Real>>>(Mvec);
+      bytes = Bytes(*M);
+      data = M;
+    } else {
+      success = false;
+      break;
+    }
+
+    const Key key_(key[0], key[1], key[2]);
+    #pragma omp critical (SCTL_SH_STORE)
+    if (entries.find(key_) == entries.end()) {
+      Insert(key_, data, bytes, kind == Kind::LegNodes || kind == Kind::LegWeights);
+      Evict(key_);
+    }
+  }
+  fclose(f);
+  return success;
+}
+
+template <class Real> Long SphericalHarmonics<Real>::MatrixStorage::Bytes(const Vector<Real>& v) {
+  return v.Dim() * (Long)sizeof(Real);
+}
+template <class Real> Long SphericalHarmonics<Real>::MatrixStorage::Bytes(const Matrix<Real>& M) {
+  return M.Dim(0) * M.Dim(1) * (Long)sizeof(Real);
+}
+template <class Real> Long SphericalHarmonics<Real>::MatrixStorage::Bytes(const std::vector<Matrix<Real>>& Mvec) {
+  Long bytes = 0;
+  for (const auto& M : Mvec) bytes += Bytes(M);
+  return bytes;
+}
+template <class Real> Long SphericalHarmonics<Real>::MatrixStorage::Bytes(const FFT<Real>& F) {
+  return (F.Dim(0) + F.Dim(1)) * (Long)sizeof(Real); // approximate
+}
+
+template <class Real> void SphericalHarmonics<Real>::MatrixStorage::Insert(const Key& key, const std::shared_ptr<const void>& data, Long bytes, bool pinned) {
+  std::promise<std::shared_ptr<const void>> promise;
+  promise.set_value(data);
+  Entry& e = entries[key];
+  e.data = promise.get_future().share();
+  e.bytes = bytes;
+  e.last_use = ++use_count;
+  e.pinned = pinned;
+  e.ready = true;
+  mem_usage += bytes;
+}
+
+template <class Real> void SphericalHarmonics<Real>::MatrixStorage::Evict(const Key& keep) {
+  while (mem_usage > mem_limit) {
+    auto lru = entries.end();
+    for (auto it = entries.begin(); it != entries.end(); it++) {
+      if (!it->second.ready || it->second.pinned || it->first == keep) continue;
+      if (lru == entries.end() || it->second.last_use < lru->second.last_use) lru = it;
+    }
+    if (lru == entries.end()) break;
+    mem_usage -= lru->second.bytes;
+    entries.erase(lru);
+  }
+}
+
 template <class Real> const Vector<Real>& SphericalHarmonics<Real>::LegendreNodes(Long p){
   assert(p<SCTL_SHMAXDEG);
-  Vector<Real>& Qx=MatrixStore().Qx_[p];
-  #pragma omp critical (SCTL_LEGNODES)
-  if(!Qx.Dim()){
-    LegQuadRule<Real>::ComputeNdsWts(&Qx, nullptr, p+1);
-    for (auto& x : Qx) x = 1-x*2;
-  }
-  return Qx;
+  return *MatrixStore().template Get<Vector<Real>>(MatrixStorage::Kind::LegNodes, p, 0, [p]() {
+    auto Qx = std::make_shared<Vector<Real>>();
+    LegQuadRule<Real>::ComputeNdsWts(Qx.get(), nullptr, p+1);
+    for (auto& x : *Qx) x = 1-x*2;
+    return Qx;
+  }, true);
 }
 
 template <class Real> const Vector<Real>& SphericalHarmonics<Real>::LegendreWeights(Long p){
   assert(p<SCTL_SHMAXDEG);
-  Vector<Real>& Qw=MatrixStore().Qw_[p];
-  #pragma omp critical (SCTL_LEGWEIGHTS)
-  if(!Qw.Dim()){
-    LegQuadRule<Real>::ComputeNdsWts(nullptr, &Qw, p+1);
-    for (auto& w : Qw) w = w*2;
-  }
-  return Qw;
+  return *MatrixStore().template Get<Vector<Real>>(MatrixStorage::Kind::LegWeights, p, 0, [p]() {
+    auto Qw = std::make_shared<Vector<Real>>();
+    LegQuadRule<Real>::ComputeNdsWts(nullptr, Qw.get(), p+1);
+    for (auto& w : *Qw) w = w*2;
+    return Qw;
+  }, true);
 }
 
-template <class Real> const Vector<Real>& SphericalHarmonics<Real>::SingularWeights(Long p1){
+template <class Real> std::shared_ptr<const Vector<Real>> SphericalHarmonics<Real>::SingularWeights(Long p1){
   assert(p1<SCTL_SHMAXDEG);
-  Vector<Real>& Sw=MatrixStore().Sw_[p1];
-  #pragma omp critical (SCTL_SINWEIGHTS)
-  if(!Sw.Dim()){
+  return MatrixStore().template Get<Vector<Real>>(MatrixStorage::Kind::SingWeights, p1, 0, [p1]() {
     const Vector<Real>& qx1 = LegendreNodes(p1);
     const Vector<Real>& qw1 = LegendreWeights(p1);
 
@@ -2719,23 +3133,22 @@ template <class Real> const Vector<Real>& SphericalHarmonics<Real>::SingularWeig
       }
     }
 
-    Sw.ReInit(p1+1);
+    auto Sw = std::make_shared<Vector<Real>>(p1+1);
     for(Long i=0;i<p1+1;i++){
-      Sw[i]=(qw1[i]*M_PI/p1)*Yf[i]/cos(acos(qx1[i])/2);
+      (*Sw)[i]=(qw1[i]*M_PI/p1)*Yf[i]/cos(acos(qx1[i])/2);
     }
-  }
-  return Sw;
+    return Sw;
+  });
 }
 
 
-template <class Real> const Matrix<Real>& SphericalHarmonics<Real>::MatFourier(Long p0, Long p1){
+template <class Real> std::shared_ptr<const Matrix<Real>> SphericalHarmonics<Real>::MatFourier(Long p0, Long p1){
   assert(p0<SCTL_SHMAXDEG && p1<SCTL_SHMAXDEG);
-  Matrix<Real>& Mf =MatrixStore().Mf_ [p0*SCTL_SHMAXDEG+p1];
-  #pragma omp critical (SCTL_MATFOURIER)
-  if(!Mf.Dim(0)){
+  return MatrixStore().template Get<Matrix<Real>>(MatrixStorage::Kind::Fourier, p0, p1, [p0,p1]() {
     const Real SQRT2PI=sqrt(2*M_PI);
+    auto Mf = std::make_shared<Matrix<Real>>(2*p0,2*p1);
     { // Set Mf
-      Matrix<Real> M(2*p0,2*p1);
+      Matrix<Real>& M = *Mf;
       for(Long j=0;j<2*p1;j++){
         M[0][j]=SQRT2PI*1.0;
         for(Long k=1;k<p0;k++){
@@ -2744,45 +3157,41 @@ template <class Real> const Matrix<Real>& SphericalHarmonics<Real>::MatFourier(L
         }
         M[2*p0-1][j]=SQRT2PI*cos(j*p0*M_PI/p1);
       }
-      Mf=M;
     }
-  }
-  return Mf;
+    return Mf;
+  });
 }
 
-template <class Real> const Matrix<Real>& SphericalHarmonics<Real>::MatFourierInv(Long p0, Long p1){
+template <class Real> std::shared_ptr<const Matrix<Real>> SphericalHarmonics<Real>::MatFourierInv(Long p0, Long p1){
   assert(p0<SCTL_SHMAXDEG && p1<SCTL_SHMAXDEG);
-  Matrix<Real>& Mf =MatrixStore().Mfinv_ [p0*SCTL_SHMAXDEG+p1];
-  #pragma omp critical (SCTL_MATFOURIERINV)
-  if(!Mf.Dim(0)){
+  return MatrixStore().template Get<Matrix<Real>>(MatrixStorage::Kind::FourierInv, p0, p1, [p0,p1]() {
     const Real INVSQRT2PI=1.0/sqrt(2*M_PI)/p0;
+    auto Mf = std::make_shared<Matrix<Real>>(2*p0,2*p1);
     { // Set Mf
-      Matrix<Real> M(2*p0,2*p1);
+      Matrix<Real>& M = *Mf;
       M.SetZero();
-      if(p1>p0) p1=p0;
+      const Long p1_ = std::min(p0, p1);
       for(Long j=0;j<2*p0;j++){
         M[j][0]=INVSQRT2PI*0.5;
-        for(Long k=1;k<p1;k++){
+        for(Long k=1;k<p1_;k++){
           M[j][2*k-1]=INVSQRT2PI*cos(j*k*M_PI/p0);
           M[j][2*k-0]=INVSQRT2PI*sin(j*k*M_PI/p0);
         }
-        M[j][2*p1-1]=INVSQRT2PI*cos(j*p1*M_PI/p0);
+        M[j][2*p1_-1]=INVSQRT2PI*cos(j*p1_*M_PI/p0);
       }
-      if(p1==p0) for(Long j=0;j<2*p0;j++) M[j][2*p1-1]*=0.5;
-      Mf=M;
+      if(p1_==p0) for(Long j=0;j<2*p0;j++) M[j][2*p1_-1]*=0.5;
     }
-  }
-  return Mf;
+    return Mf;
+  });
 }
 
-template <class Real> const Matrix<Real>& SphericalHarmonics<Real>::MatFourierGrad(Long p0, Long p1){
+template <class Real> std::shared_ptr<const Matrix<Real>> SphericalHarmonics<Real>::MatFourierGrad(Long p0, Long p1){
   assert(p0<SCTL_SHMAXDEG && p1<SCTL_SHMAXDEG);
-  Matrix<Real>& Mdf=MatrixStore().Mdf_[p0*SCTL_SHMAXDEG+p1];
-  #pragma omp critical (SCTL_MATFOURIERGRAD)
-  if(!Mdf.Dim(0)){
+  return MatrixStore().template Get<Matrix<Real>>(MatrixStorage::Kind::FourierGrad, p0, p1, [p0,p1]() {
     const Real SQRT2PI=sqrt(2*M_PI);
+    auto Mdf = std::make_shared<Matrix<Real>>(2*p0,2*p1);
     { // Set Mdf_
-      Matrix<Real> M(2*p0,2*p1);
+      Matrix<Real>& M = *Mdf;
       for(Long j=0;j<2*p1;j++){
         M[0][j]=SQRT2PI*0.0;
         for(Long k=1;k<p0;k++){
@@ -2791,98 +3200,90 @@ template <class Real> const Matrix<Real>& SphericalHarmonics<Real>::MatFourierGr
         }
         M[2*p0-1][j]=-SQRT2PI*p0*sin(j*p0*M_PI/p1);
       }
-      Mdf=M;
     }
-  }
-  return Mdf;
+    return Mdf;
+  });
 }
 
 
-template <class Real> const FFT<Real>& SphericalHarmonics<Real>::OpFourier(Long Np){
+template <class Real> std::shared_ptr<const FFT<Real>> SphericalHarmonics<Real>::OpFourier(Long Np, Long howmany){
   assert(Np<SCTL_SHMAXDEG);
-  auto& Mf =MatrixStore().Mfftinv_ [Np];
-  #pragma omp critical (SCTL_FFT_PLAN0)
-  if(!Mf.Dim(0)){
+  return MatrixStore().template Get<FFT<Real>>(MatrixStorage::Kind::FFTInv, Np, howmany, [Np,howmany]() {
+    auto Mf = std::make_shared<FFT<Real>>();
     StaticArray<Long,1> fft_dim{Np};
-    Mf.Setup(FFT_Type::C2R, 1, Vector<Long>(1,fft_dim,false));
-  }
-  return Mf;
+    Mf->Setup(FFT_Type::C2R, howmany, Vector<Long>(1,fft_dim,false));
+    return Mf;
+  });
 }
 
-template <class Real> const FFT<Real>& SphericalHarmonics<Real>::OpFourierInv(Long Np){
+template <class Real> std::shared_ptr<const FFT<Real>> SphericalHarmonics<Real>::OpFourierInv(Long Np, Long howmany){
   assert(Np<SCTL_SHMAXDEG);
-  auto& Mf =MatrixStore().Mfft_ [Np];
-  #pragma omp critical (SCTL_FFT_PLAN1)
-  if(!Mf.Dim(0)){
+  return MatrixStore().template Get<FFT<Real>>(MatrixStorage::Kind::FFT, Np, howmany, [Np,howmany]() {
+    auto Mf = std::make_shared<FFT<Real>>();
     StaticArray<Long,1> fft_dim {Np};
-    Mf.Setup(FFT_Type::R2C, 1, Vector<Long>(1,fft_dim,false));
-  }
-  return Mf;
+    Mf->Setup(FFT_Type::R2C, howmany, Vector<Long>(1,fft_dim,false));
+    return Mf;
+  });
 }
 
 
-template <class Real> const std::vector<Matrix<Real>>& SphericalHarmonics<Real>::MatLegendre(Long p0, Long p1){
+template <class Real> std::shared_ptr<const std::vector<Matrix<Real>>> SphericalHarmonics<Real>::MatLegendre(Long p0, Long p1){
   assert(p0<SCTL_SHMAXDEG && p1<SCTL_SHMAXDEG);
-  std::vector<Matrix<Real>>& Ml =MatrixStore().Ml_ [p0*SCTL_SHMAXDEG+p1];
-  #pragma omp critical (SCTL_MATLEG)
-  if(!Ml.size()){
+  return MatrixStore().template Get<std::vector<Matrix<Real>>>(MatrixStorage::Kind::Legendre, p0, p1, [p0,p1]() {
     const Vector<Real>& qx1 = LegendreNodes(p1);
     Vector<Real> alp(qx1.Dim()*(p0+1)*(p0+2)/2);
     LegPoly(alp, qx1, p0);
 
-    Ml.resize(p0+1);
+    auto Ml = std::make_shared<std::vector<Matrix<Real>>>(p0+1);
     auto ptr = alp.begin();
     for(Long i=0;i<=p0;i++){
-      Ml[i].ReInit(p0+1-i, qx1.Dim(), ptr);
-      ptr+=Ml[i].Dim(0)*Ml[i].Dim(1);
+      (*Ml)[i].ReInit(p0+1-i, qx1.Dim(), ptr);
+      ptr+=(*Ml)[i].Dim(0)*(*Ml)[i].Dim(1);
     }
-  }
-  return Ml;
+    return Ml;
+  });
 }
 
-template <class Real> const std::vector<Matrix<Real>>& SphericalHarmonics<Real>::MatLegendreInv(Long p0, Long p1){
+template <class Real> std::shared_ptr<const std::vector<Matrix<Real>>> SphericalHarmonics<Real>::MatLegendreInv(Long p0, Long p1){
   assert(p0<SCTL_SHMAXDEG && p1<SCTL_SHMAXDEG);
-  std::vector<Matrix<Real>>& Ml =MatrixStore().Mlinv_ [p0*SCTL_SHMAXDEG+p1];
-  #pragma omp critical (SCTL_MATLEGINV)
-  if(!Ml.size()){
+  return MatrixStore().template Get<std::vector<Matrix<Real>>>(MatrixStorage::Kind::LegendreInv, p0, p1, [p0,p1]() {
     const Vector<Real>& qx1 = LegendreNodes(p0);
     const Vector<Real>& qw1 = LegendreWeights(p0);
     Vector<Real> alp(qx1.Dim()*(p1+1)*(p1+2)/2);
     LegPoly(alp, qx1, p1);
 
-    Ml.resize(p1+1);
+    auto Ml = std::make_shared<std::vector<Matrix<Real>>>(p1+1);
     auto ptr = alp.begin();
     for(Long i=0;i<=p1;i++){
-      Ml[i].ReInit(qx1.Dim(), p1+1-i);
+      Matrix<Real>& Ml_i = (*Ml)[i];
+      Ml_i.ReInit(qx1.Dim(), p1+1-i);
       Matrix<Real> M(p1+1-i, qx1.Dim(), ptr, false);
       for(Long j=0;j<p1+1-i;j++){ // Transpose and weights
         for(Long k=0;k<qx1.Dim();k++){
-          Ml[i][k][j]=M[j][k]*qw1[k]*2*M_PI;
+          Ml_i[k][j]=M[j][k]*qw1[k]*2*M_PI;
         }
       }
-      ptr+=Ml[i].Dim(0)*Ml[i].Dim(1);
+      ptr+=Ml_i.Dim(0)*Ml_i.Dim(1);
     }
-  }
-  return Ml;
+    return Ml;
+  });
 }
 
-template <class Real> const std::vector<Matrix<Real>>& SphericalHarmonics<Real>::MatLegendreGrad(Long p0, Long p1){
+template <class Real> std::shared_ptr<const std::vector<Matrix<Real>>> SphericalHarmonics<Real>::MatLegendreGrad(Long p0, Long p1){
   assert(p0<SCTL_SHMAXDEG && p1<SCTL_SHMAXDEG);
-  std::vector<Matrix<Real>>& Mdl=MatrixStore().Mdl_[p0*SCTL_SHMAXDEG+p1];
-  #pragma omp critical (SCTL_MATLEGGRAD)
-  if(!Mdl.size()){
+  return MatrixStore().template Get<std::vector<Matrix<Real>>>(MatrixStorage::Kind::LegendreGrad, p0, p1, [p0,p1]() {
     const Vector<Real>& qx1 = LegendreNodes(p1);
     Vector<Real> alp(qx1.Dim()*(p0+1)*(p0+2)/2);
     LegPolyDeriv(alp, qx1, p0);
 
-    Mdl.resize(p0+1);
+    auto Mdl = std::make_shared<std::vector<Matrix<Real>>>(p0+1);
     auto ptr = alp.begin();
     for(Long i=0;i<=p0;i++){
-      Mdl[i].ReInit(p0+1-i, qx1.Dim(), ptr);
-      ptr+=Mdl[i].Dim(0)*Mdl[i].Dim(1);
+      (*Mdl)[i].ReInit(p0+1-i, qx1.Dim(), ptr);
+      ptr+=(*Mdl)[i].Dim(0)*(*Mdl)[i].Dim(1);
     }
-  }
-  return Mdl;
+    return Mdl;
+  });
 }
 
 
@@ -3062,7 +3463,7 @@ template <class Real> void SphericalHarmonics<Real>::VecSHBasisEval(Long p0, con
 }
 
 
-template <class Real> const std::vector<Matrix<Real>>& SphericalHarmonics<Real>::MatRotate(Long p0){
+template <class Real> std::shared_ptr<const std::vector<Matrix<Real>>> SphericalHarmonics<Real>::MatRotate(Long p0){
   std::vector<std::vector<Long>> coeff_perm(p0+1);
   { // Set coeff_perm
     for(Long n=0;n<=p0;n++) coeff_perm[n].resize(std::min(2*n+1,2*p0));
@@ -3077,9 +3478,8 @@ template <class Real> const std::vector<Matrix<Real>>& SphericalHarmonics<Real>:
   }
 
   assert(p0<SCTL_SHMAXDEG);
-  std::vector<Matrix<Real>>& Mr=MatrixStore().Mr_[p0];
-  #pragma omp critical (SCTL_MATROTATE)
-  if(!Mr.size()){
+  return MatrixStore().template Get<std::vector<Matrix<Real>>>(MatrixStorage::Kind::Rotate, p0, 0, [p0,coeff_perm]() {
+    auto Mr = std::make_shared<std::vector<Matrix<Real>>>();
     const Real SQRT2PI=sqrt(2*M_PI);
     Long Ncoef=p0*(p0+2);
     Long Ngrid=2*p0*(p0+1);
@@ -3159,18 +3559,18 @@ template <class Real> const std::vector<Matrix<Real>>& SphericalHarmonics<Real>:
             M[i][j]=Mcoef2coef[coeff_perm[n][i]][coeff_perm[n][j]];
           }
         }
-        Mr.push_back(M);
+        Mr->push_back(M);
       }
     }
-  }
-  return Mr;
+    return Mr;
+  });
 }
 
 
 
 template <class Real> void SphericalHarmonics<Real>::SHC2GridTranspose(const Vector<Real>& X, Long p0, Long p1, Vector<Real>& S){
-  Matrix<Real> Mf =SphericalHarmonics<Real>::MatFourier(p1,p0).Transpose();
-  std::vector<Matrix<Real>> Ml =SphericalHarmonics<Real>::MatLegendre(p1,p0);
+  Matrix<Real> Mf =SphericalHarmonics<Real>::MatFourier(p1,p0)->Transpose();
+  std::vector<Matrix<Real>> Ml =*SphericalHarmonics<Real>::MatLegendre(p1,p0);
   for(Long i=0;i<(Long)Ml.size();i++) Ml[i]=Ml[i].Transpose();
   assert(p1==(Long)Ml.size()-1);
   assert(p0==Mf.Dim(0)/2);
@@ -3255,7 +3655,8 @@ template <class Real> void SphericalHarmonics<Real>::SHC2GridTranspose(const Vec
 }
 
 template <class Real> void SphericalHarmonics<Real>::RotateAll(const Vector<Real>& S, Long p0, Long dof, Vector<Real>& S_){
-  const std::vector<Matrix<Real>>& Mr=MatRotate(p0);
+  const auto Mr_=MatRotate(p0);
+  const std::vector<Matrix<Real>>& Mr=*Mr_;
   std::vector<std::vector<Long>> coeff_perm(p0+1);
   { // Set coeff_perm
     for(Long n=0;n<=p0;n++) coeff_perm[n].resize(std::min(2*n+1,2*p0));
@@ -3343,7 +3744,7 @@ template <class Real> void SphericalHarmonics<Real>::RotateAll(const Vector<Real
 }
 
 template <class Real> void SphericalHarmonics<Real>::RotateTranspose(const Vector<Real>& S_, Long p0, Long dof, Vector<Real>& S){
-  std::vector<Matrix<Real>> Mr=MatRotate(p0);
+  std::vector<Matrix<Real>> Mr=*MatRotate(p0);
   for(Long i=0;i<(Long)Mr.size();i++) Mr[i]=Mr[i].Transpose();
   std::vector<std::vector<Long>> coeff_perm(p0+1);
   { // Set coeff_perm
@@ -3483,7 +3884,8 @@ template <class Real> template <bool SLayer, bool DLayer> void SphericalHarmonic
     assert(X.Dim()==M1*COORD_DIM*N);
     if(SLayer && SL0.Dim()!=N*2*6*M1) SL0.ReInit(2*N*6*M1);
     if(DLayer && DL0.Dim()!=N*2*6*M1) DL0.ReInit(2*N*6*M1);
-    const Vector<Real>& qw=SphericalHarmonics<Real>::SingularWeights(p1);
+    const auto qw_=SphericalHarmonics<Real>::SingularWeights(p1);
+    const Vector<Real>& qw=*qw_;
 
     const Real scal_const_dl = 3.0/(4.0*M_PI);
     const Real scal_const_sl = 1.0/(8.0*M_PI);
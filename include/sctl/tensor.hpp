@@ -12,6 +12,21 @@ namespace sctl {
   template <Long k, Long d0, Long... dd> static constexpr Long TensorArgExtract();
   template <class ValueType, bool own_data, Long... dd> struct TensorRotateLeftType;
   template <class ValueType, bool own_data, Long... dd> struct TensorRotateRightType;
+  template <class ValueType, class Expr, Long... Args> class TensorExpr;
+
+  namespace tensor_detail {
+    template <class ValueType> struct LeafNode;
+    template <class ValueType> struct ScalarNode;
+    template <class Op, class Expr> struct UnaryNode;
+    template <class Op, class Expr1, class Expr2> struct BinaryNode;
+    struct OpNeg;
+    struct OpAdd;
+    struct OpSub;
+    struct OpMul;
+    struct OpDiv;
+
+    template <class ValueType, class Op, class Expr1, class Expr2, Long... Args> using BinaryExpr = TensorExpr<ValueType, BinaryNode<Op, Expr1, Expr2>, Args...>;
+  }
 
   /**
    * A template class representing a multidimensional tensor.
@@ -102,6 +117,14 @@ namespace sctl {
        */
       template <bool own_data_> Tensor(const Tensor<ValueType, own_data_, Args...> &M);
 
+      /**
+       * Constructor evaluating a tensor expression.
+       *
+       * @tparam Expr Node type of the tensor expression.
+       * @param M Tensor expression to evaluate.
+       */
+      template <class Expr> Tensor(const TensorExpr<ValueType, Expr, Args...> &M);
+
       /**
        * Destructor.
        */
@@ -133,6 +156,17 @@ namespace sctl {
        */
       template <bool own_data_> Tensor &operator=(const Tensor<ValueType, own_data_, Args...> &M);
 
+      /**
+       * Assignment operator evaluating a tensor expression into this tensor (in a single pass, without temporaries).
+       * The expression may refer to this tensor itself (e.g. `x = 2*x + y`); if an operand is a view that overlaps
+       * this tensor at a different offset, the expression is evaluated into a temporary first.
+       *
+       * @tparam Expr Node type of the tensor expression.
+       * @param M Tensor expression to evaluate.
+       * @return Reference to this tensor.
+       */
+      template <class Expr> Tensor &operator=(const TensorExpr<ValueType, Expr, Args...> &M);
+
       // Member Functions
 
       /**
@@ -204,66 +238,84 @@ namespace sctl {
       /**
        * Unary positive operator.
        *
-       * @return The tensor itself.
+       * @return Expression for the tensor itself.
        */
-      Tensor<ValueType, true, Args...> operator+() const;
+      TensorExpr<ValueType, tensor_detail::LeafNode<ValueType>, Args...> operator+() const;
 
       /**
        * Unary negative operator.
        *
-       * @return Negated tensor.
+       * @return Expression for the negated tensor.
        */
-      Tensor<ValueType, true, Args...> operator-() const;
+      TensorExpr<ValueType, tensor_detail::UnaryNode<tensor_detail::OpNeg, tensor_detail::LeafNode<ValueType>>, Args...> operator-() const;
 
       /**
        * Addition operator.
        *
        * @param s Scalar value to add to the tensor.
-       * @return Result of addition.
+       * @return Expression for the result of addition.
        */
-      Tensor<ValueType, true, Args...> operator+(const ValueType &s) const;
+      tensor_detail::BinaryExpr<ValueType, tensor_detail::OpAdd, tensor_detail::LeafNode<ValueType>, tensor_detail::ScalarNode<ValueType>, Args...> operator+(const ValueType &s) const;
 
       /**
        * Subtraction operator.
        *
        * @param s Scalar value to subtract from the tensor.
-       * @return Result of subtraction.
+       * @return Expression for the result of subtraction.
        */
-      Tensor<ValueType, true, Args...> operator-(const ValueType &s) const;
+      tensor_detail::BinaryExpr<ValueType, tensor_detail::OpSub, tensor_detail::LeafNode<ValueType>, tensor_detail::ScalarNode<ValueType>, Args...> operator-(const ValueType &s) const;
 
       /**
        * Multiplication operator.
        *
        * @param s Scalar value to multiply the tensor by.
-       * @return Result of multiplication.
+       * @return Expression for the result of multiplication.
        */
-      Tensor<ValueType, true, Args...> operator*(const ValueType &s) const;
+      tensor_detail::BinaryExpr<ValueType, tensor_detail::OpMul, tensor_detail::LeafNode<ValueType>, tensor_detail::ScalarNode<ValueType>, Args...> operator*(const ValueType &s) const;
 
       /**
        * Division operator.
        *
        * @param s Scalar value to divide the tensor by.
-       * @return Result of division.
+       * @return Expression for the result of division.
        */
-      Tensor<ValueType, true, Args...> operator/(const ValueType &s) const;
+      tensor_detail::BinaryExpr<ValueType, tensor_detail::OpDiv, tensor_detail::LeafNode<ValueType>, tensor_detail::ScalarNode<ValueType>, Args...> operator/(const ValueType &s) const;
 
       /**
        * Addition operator.
        *
-       * @tparam own_data_ Boolean indicating whether the resulting tensor owns its data.
+       * @tparam own_data_ Boolean indicating whether the second tensor owns its data.
        * @param M2 Another tensor to add.
-       * @return Result of addition.
+       * @return Expression for the result of addition.
        */
-      template <bool own_data_> Tensor<ValueType, true, Args...> operator+(const Tensor<ValueType, own_data_, Args...> &M2) const;
+      template <bool own_data_> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpAdd, tensor_detail::LeafNode<ValueType>, tensor_detail::LeafNode<ValueType>, Args...> operator+(const Tensor<ValueType, own_data_, Args...> &M2) const;
 
       /**
        * Subtraction operator.
        *
-       * @tparam own_data_ Boolean indicating whether the resulting tensor owns its data.
+       * @tparam own_data_ Boolean indicating whether the second tensor owns its data.
        * @param M2 Another tensor to subtract.
-       * @return Result of subtraction.
+       * @return Expression for the result of subtraction.
+       */
+      template <bool own_data_> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpSub, tensor_detail::LeafNode<ValueType>, tensor_detail::LeafNode<ValueType>, Args...> operator-(const Tensor<ValueType, own_data_, Args...> &M2) const;
+
+      /**
+       * Addition operator.
+       *
+       * @tparam Expr Node type of the tensor expression.
+       * @param M2 Tensor expression to add.
+       * @return Expression for the result of addition.
+       */
+      template <class Expr> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpAdd, tensor_detail::LeafNode<ValueType>, Expr, Args...> operator+(const TensorExpr<ValueType, Expr, Args...> &M2) const;
+
+      /**
+       * Subtraction operator.
+       *
+       * @tparam Expr Node type of the tensor expression.
+       * @param M2 Tensor expression to subtract.
+       * @return Expression for the result of subtraction.
        */
-      template <bool own_data_> Tensor<ValueType, true, Args...> operator-(const Tensor<ValueType, own_data_, Args...> &M2) const;
+      template <class Expr> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpSub, tensor_detail::LeafNode<ValueType>, Expr, Args...> operator-(const TensorExpr<ValueType, Expr, Args...> &M2) const;
 
       /**
        * Multiplication operator.
@@ -278,8 +330,24 @@ namespace sctl {
        */
       template <bool own_data_, Long N1, Long N2> Tensor<ValueType, true, TensorArgExtract<0, Args...>(), N2> operator*(const Tensor<ValueType, own_data_, N1, N2> &M2) const;
 
+      /**
+       * Multiplication operator (matrix multiplication) with a tensor expression, which is evaluated first.
+       *
+       * @tparam Expr Node type of the tensor expression.
+       * @tparam N1 The size of the second dimension of the first tensor.
+       * @tparam N2 The size of the second dimension of the second tensor.
+       * @param M2 Tensor expression to multiply.
+       * @return Result of multiplication.
+       */
+      template <class Expr, Long N1, Long N2> Tensor<ValueType, true, TensorArgExtract<0, Args...>(), N2> operator*(const TensorExpr<ValueType, Expr, N1, N2> &M2) const;
+
     private:
 
+      template <class, bool, Long...> friend class Tensor;
+      template <class, class, Long...> friend class TensorExpr;
+
+      tensor_detail::LeafNode<ValueType> Leaf() const;
+
       template <Integer k> static Long offset();
 
       template <Integer k, class ...PackedLong> static Long offset(Long i, PackedLong... ii);
@@ -292,6 +360,147 @@ namespace sctl {
 
   template <class ValueType, bool own_data, Long N1, Long N2> std::ostream& operator<<(std::ostream &output, const Tensor<ValueType, own_data, N1, N2> &M);
 
+  /**
+   * Lazily evaluated element-wise arithmetic on tensors. The element-wise operators of Tensor (and of TensorExpr)
+   * return a TensorExpr instead of a new tensor, so that an expression such as `a*x + b*y - z` is evaluated in a
+   * single vectorized loop when it is assigned to a Tensor, without creating intermediate tensors.
+   *
+   * A TensorExpr holds references to its tensor operands; it must be evaluated (assigned to a Tensor or by calling
+   * Eval()) while those tensors are still alive. In particular, do not store an expression with `auto` if it refers
+   * to a temporary tensor (e.g. the result of RotateRight() or of a matrix product).
+   *
+   * @tparam ValueType The type of the elements.
+   * @tparam Expr Node type of the expression tree.
+   * @tparam Args The dimensions of the tensor.
+   */
+  template <class ValueType, class Expr, Long... Args> class TensorExpr {
+    public:
+
+      /**
+       * Get the order of the tensor.
+       */
+      static constexpr Long Order();
+
+      /**
+       * Get the total number of elements in the tensor.
+       */
+      static constexpr Long Size();
+
+      /**
+       * Get the size of a specific dimension of the tensor.
+       *
+       * @tparam k The index of the dimension.
+       */
+      template <Long k> static constexpr Long Dim();
+
+      /**
+       * Constructor.
+       *
+       * @param expr Root node of the expression tree.
+       */
+      explicit TensorExpr(const Expr& expr);
+
+      /**
+       * Evaluate the expression.
+       *
+       * @return A new tensor with the result.
+       */
+      Tensor<ValueType, true, Args...> Eval() const;
+
+      /**
+       * Evaluate the expression and write the result to the given memory location.
+       *
+       * @param out Iterator to the output array of length Size().
+       */
+      void EvalTo(Iterator<ValueType> out) const;
+
+      /**
+       * Evaluate a single element of the expression.
+       *
+       * @tparam PackedLong Variadic template parameter for the indices of the element.
+       * @param ii Indices of the element.
+       * @return Value of the element.
+       */
+      template <class ...PackedLong> ValueType operator()(PackedLong... ii) const;
+
+      /**
+       * Evaluate the expression and rotate the dimensions to the left (see Tensor::RotateLeft).
+       */
+      typename TensorRotateLeftType<ValueType, true, Args...>::Value RotateLeft() const;
+
+      /**
+       * Evaluate the expression and rotate the dimensions to the right (see Tensor::RotateRight).
+       */
+      typename TensorRotateRightType<ValueType, true, Args...>::Value RotateRight() const;
+
+      /**
+       * Unary positive operator.
+       */
+      TensorExpr operator+() const;
+
+      /**
+       * Unary negative operator.
+       */
+      TensorExpr<ValueType, tensor_detail::UnaryNode<tensor_detail::OpNeg, Expr>, Args...> operator-() const;
+
+      /**
+       * Element-wise operators with a scalar.
+       *
+       * @param s Scalar value.
+       * @return Expression for the result.
+       */
+      tensor_detail::BinaryExpr<ValueType, tensor_detail::OpAdd, Expr, tensor_detail::ScalarNode<ValueType>, Args...> operator+(const ValueType &s) const;
+      tensor_detail::BinaryExpr<ValueType, tensor_detail::OpSub, Expr, tensor_detail::ScalarNode<ValueType>, Args...> operator-(const ValueType &s) const;
+      tensor_detail::BinaryExpr<ValueType, tensor_detail::OpMul, Expr, tensor_detail::ScalarNode<ValueType>, Args...> operator*(const ValueType &s) const;
+      tensor_detail::BinaryExpr<ValueType, tensor_detail::OpDiv, Expr, tensor_detail::ScalarNode<ValueType>, Args...> operator/(const ValueType &s) const;
+
+      /**
+       * Element-wise addition and subtraction with a tensor.
+       *
+       * @param M2 Tensor operand.
+       * @return Expression for the result.
+       */
+      template <bool own_data_> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpAdd, Expr, tensor_detail::LeafNode<ValueType>, Args...> operator+(const Tensor<ValueType, own_data_, Args...> &M2) const;
+      template <bool own_data_> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpSub, Expr, tensor_detail::LeafNode<ValueType>, Args...> operator-(const Tensor<ValueType, own_data_, Args...> &M2) const;
+
+      /**
+       * Element-wise addition and subtraction with another tensor expression.
+       *
+       * @param M2 Tensor expression operand.
+       * @return Expression for the result.
+       */
+      template <class Expr2> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpAdd, Expr, Expr2, Args...> operator+(const TensorExpr<ValueType, Expr2, Args...> &M2) const;
+      template <class Expr2> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpSub, Expr, Expr2, Args...> operator-(const TensorExpr<ValueType, Expr2, Args...> &M2) const;
+
+      /**
+       * Matrix multiplication; the expression is evaluated first (see Tensor::operator*).
+       *
+       * @param M2 Tensor (or tensor expression) to multiply.
+       * @return Result of multiplication.
+       */
+      template <bool own_data_, Long N1, Long N2> Tensor<ValueType, true, TensorArgExtract<0, Args...>(), N2> operator*(const Tensor<ValueType, own_data_, N1, N2> &M2) const;
+      template <class Expr2, Long N1, Long N2> Tensor<ValueType, true, TensorArgExtract<0, Args...>(), N2> operator*(const TensorExpr<ValueType, Expr2, N1, N2> &M2) const;
+
+    private:
+
+      template <class, bool, Long...> friend class Tensor;
+      template <class, class, Long...> friend class TensorExpr;
+
+      template <Integer k> static Long offset();
+
+      template <Integer k, class ...PackedLong> static Long offset(Long i, PackedLong... ii);
+
+      Expr expr;
+  };
+
+  /**
+   * Multiplication of a tensor (or tensor expression) by a scalar from the left.
+   */
+  template <class ValueType, bool own_data, Long... Args> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpMul, tensor_detail::LeafNode<ValueType>, tensor_detail::ScalarNode<ValueType>, Args...> operator*(const typename tensor_detail::ScalarNode<ValueType>::Type &s, const Tensor<ValueType, own_data, Args...> &M);
+  template <class ValueType, class Expr, Long... Args> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpMul, Expr, tensor_detail::ScalarNode<ValueType>, Args...> operator*(const typename tensor_detail::ScalarNode<ValueType>::Type &s, const TensorExpr<ValueType, Expr, Args...> &M);
+
+  template <class ValueType, class Expr, Long N1, Long N2> std::ostream& operator<<(std::ostream &output, const TensorExpr<ValueType, Expr, N1, N2> &M);
+
 }  // end namespace
 
 #endif // _SCTL_TENSOR_HPP_
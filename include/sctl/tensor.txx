@@ -2,21 +2,72 @@
 #define _SCTL_TENSOR_TXX_
 
 #include <ios>                    // for ios
+#include <algorithm>              // for max
 #include <ostream>                // for ostream
 #include <stdlib.h>               // for drand48
 #include <iomanip>                // for operator<<, setiosflags, setprecision
 #include <iostream>               // for basic_ostream, operator<<, cout
 #include <initializer_list>       // for initializer_list
+#include <utility>                // for declval
 
 #include "sctl/common.hpp"        // for Long, Integer, SCTL_UNUSED, SCTL_NA...
 #include "sctl/tensor.hpp"        // for Tensor, TensorArgExtract, operator<<
 #include "sctl/iterator.hpp"      // for Iterator, ConstIterator
 #include "sctl/iterator.txx"      // for NullIterator, memcopy, Ptr2Itr
+#include "sctl/mat_utils.hpp"     // for gemm_small
+#include "sctl/mat_utils.txx"     // for gemm_small
 #include "sctl/math_utils.hpp"    // for fabs
+#include "sctl/math_utils.txx"    // for machine_eps
 #include "sctl/static-array.hpp"  // for StaticArray
+#include "sctl/vec.hpp"           // for Vec, DefaultVecLen
+#include "sctl/vec.txx"           // for Vec::Load, Vec::Store
 
 namespace sctl {
 
+  namespace tensor_detail {
+
+    // Element-wise operations; Apply is called with scalars and with Vec types.
+    struct OpNeg { template <class T> static T Apply(const T& a) { return -a; } };
+    struct OpAdd { template <class T> static T Apply(const T& a, const T& b) { return a + b; } };
+    struct OpSub { template <class T> static T Apply(const T& a, const T& b) { return a - b; } };
+    struct OpMul { template <class T> static T Apply(const T& a, const T& b) { return a * b; } };
+    struct OpDiv { template <class T> static T Apply(const T& a, const T& b) { return a / b; } };
+
+    // Nodes of the expression tree. Elem(i) evaluates the i-th element (in row-major order) and VecElem(i) evaluates
+    // the elements i, ..., i+VecLen-1. PartialOverlap(out, N) checks whether an operand overlaps the output array
+    // out[0:N] without being aligned with it (element-wise evaluation in place is only safe for aligned operands).
+    template <class ValueType> struct LeafNode {
+      ValueType Elem(Long i) const { return ptr[i]; }
+      template <Integer VecLen> Vec<ValueType,VecLen> VecElem(Long i) const { return Vec<ValueType,VecLen>::Load(&ptr[i]); }
+      template <class T> bool PartialOverlap(const T* out, Long N) const { const T* p = &ptr[0]; return p != out && p < out + N && out < p + N; }
+      ConstIterator<ValueType> ptr;
+    };
+
+    template <class ValueType> struct ScalarNode {
+      using Type = ValueType;
+      ValueType Elem(Long i) const { return s; }
+      template <Integer VecLen> Vec<ValueType,VecLen> VecElem(Long i) const { return Vec<ValueType,VecLen>(s); }
+      template <class T> bool PartialOverlap(const T* out, Long N) const { return false; }
+      ValueType s;
+    };
+
+    template <class Op, class Expr> struct UnaryNode {
+      auto Elem(Long i) const -> decltype(std::declval<Expr>().Elem(i)) { return Op::Apply(e.Elem(i)); }
+      template <Integer VecLen> auto VecElem(Long i) const -> decltype(std::declval<Expr>().template VecElem<VecLen>(i)) { return Op::Apply(e.template VecElem<VecLen>(i)); }
+      template <class T> bool PartialOverlap(const T* out, Long N) const { return e.PartialOverlap(out, N); }
+      Expr e;
+    };
+
+    template <class Op, class Expr1, class Expr2> struct BinaryNode {
+      auto Elem(Long i) const -> decltype(std::declval<Expr1>().Elem(i)) { return Op::Apply(e1.Elem(i), e2.Elem(i)); }
+      template <Integer VecLen> auto VecElem(Long i) const -> decltype(std::declval<Expr1>().template VecElem<VecLen>(i)) { return Op::Apply(e1.template VecElem<VecLen>(i), e2.template VecElem<VecLen>(i)); }
+      template <class T> bool PartialOverlap(const T* out, Long N) const { return e1.PartialOverlap(out, N) || e2.PartialOverlap(out, N); }
+      Expr1 e1;
+      Expr2 e2;
+    };
+
+  }
+
   template <class ValueType, bool own_data, Long... Args> void Tensor<ValueType, own_data, Args...>::test() {
     // Define a tensor with dimensions 2x3
     Tensor<ValueType, true, 2, 3> tensor;
@@ -30,6 +81,45 @@ namespace sctl {
     // Output tensor multiplied by its right rotation
     std::cout << "Tensor multiplied by its right rotation:\n" << tensor * tensor.RotateRight() << std::endl;
 
+    { // Check the product against a direct evaluation
+      const auto M = tensor * tensor.RotateRight();
+      ValueType err = 0;
+      for (Long i = 0; i < 2; i++) {
+        for (Long j = 0; j < 2; j++) {
+          ValueType Mij = 0;
+          for (Long k = 0; k < 3; k++) Mij += tensor(i,k) * tensor.RotateRight()(k,j);
+          err = std::max<ValueType>(err, fabs(M(i,j) - Mij));
+        }
+      }
+      SCTL_ASSERT(err < 10 * machine_eps<ValueType>());
+    }
+
+    { // Check a fused element-wise expression against a direct evaluation
+      Tensor<ValueType, true, 5, 7> x, y, z;
+      for (auto& v : x) v = (ValueType)drand48();
+      for (auto& v : y) v = (ValueType)drand48();
+      for (auto& v : z) v = (ValueType)drand48();
+      const ValueType a = 2, b = 3;
+
+      const Tensor<ValueType, true, 5, 7> w = a*x + y*b - (-z) / a + 1;
+      ValueType err = 0;
+      for (Long i = 0; i < 5; i++) {
+        for (Long j = 0; j < 7; j++) {
+          const ValueType wij = a*x(i,j) + y(i,j)*b + z(i,j) / a + 1;
+          err = std::max<ValueType>(err, fabs(w(i,j) - wij));
+          err = std::max<ValueType>(err, fabs((x - y)(i,j) - (x(i,j) - y(i,j))));
+        }
+      }
+      SCTL_ASSERT(err < 10 * machine_eps<ValueType>());
+
+      const Tensor<ValueType, true, 5, 7> z0 = z;
+      Tensor<ValueType, false, 5, 7> z_(z.begin());
+      z = z + x; // in-place updates, also through a view
+      z_ = z_ - x;
+      for (Long i = 0; i < z.Size(); i++) err = std::max<ValueType>(err, fabs(z.begin()[i] - z0.begin()[i]));
+      SCTL_ASSERT(err < 10 * machine_eps<ValueType>());
+    }
+
     // Output tensor multiplied by its left rotation and then added 5
     std::cout << "Tensor multiplied by its left rotation and then added 5:\n" << tensor * tensor.RotateLeft() + 5 << std::endl;
 
@@ -129,6 +219,12 @@ namespace sctl {
     Init((Iterator<ValueType>)M.begin());
   }
 
+  template <class ValueType, bool own_data, Long... Args> template <class Expr> Tensor<ValueType, own_data, Args...>::Tensor(const TensorExpr<ValueType,Expr,Args...> &M) {
+    static_assert(own_data || !Size(), "Memory pointer must be provided to initialize Tensor types with own_data=false");
+    Init(NullIterator<ValueType>());
+    M.EvalTo(begin());
+  }
+
   template <class ValueType, bool own_data, Long... Args> Tensor<ValueType, own_data, Args...>& Tensor<ValueType, own_data, Args...>::operator=(const Tensor &M) {
     memcopy(begin(), M.begin(), Size());
     return *this;
@@ -144,7 +240,15 @@ namespace sctl {
     return *this;
   }
 
-
+  template <class ValueType, bool own_data, Long... Args> template <class Expr> Tensor<ValueType, own_data, Args...>& Tensor<ValueType, own_data, Args...>::operator=(const TensorExpr<ValueType,Expr,Args...> &M) {
+    if (Size() && M.expr.PartialOverlap(&begin()[0], Size())) { // an operand is a shifted view of the output, evaluate to a temporary first
+      const Tensor<ValueType, true, Args...> M_(M);
+      memcopy(begin(), M_.begin(), Size());
+    } else {
+      M.EvalTo(begin());
+    }
+    return *this;
+  }
 
   template <class ValueType, bool own_data, Long... Args> Iterator<ValueType> Tensor<ValueType, own_data, Args...>::begin() {
     return own_data ? (Iterator<ValueType>)buff : iter_[0];
@@ -201,98 +305,62 @@ namespace sctl {
   }
 
 
-  template <class ValueType, bool own_data, Long... Args> Tensor<ValueType, true, Args...> Tensor<ValueType, own_data, Args...>::operator+() const {
-    return *this;
+  template <class ValueType, bool own_data, Long... Args> tensor_detail::LeafNode<ValueType> Tensor<ValueType, own_data, Args...>::Leaf() const {
+    return tensor_detail::LeafNode<ValueType>{begin()};
   }
 
-  template <class ValueType, bool own_data, Long... Args> Tensor<ValueType, true, Args...> Tensor<ValueType, own_data, Args...>::operator-() const {
-    Tensor<ValueType, true, Args...> M0;
-    const auto &M1 = *this;
-
-    for (Long i = 0; i < Size(); i++) {
-      M0.begin()[i] = -M1.begin()[i];
-    }
-    return M0;
+  template <class ValueType, bool own_data, Long... Args> TensorExpr<ValueType, tensor_detail::LeafNode<ValueType>, Args...> Tensor<ValueType, own_data, Args...>::operator+() const {
+    return TensorExpr<ValueType, tensor_detail::LeafNode<ValueType>, Args...>(Leaf());
   }
 
-  template <class ValueType, bool own_data, Long... Args> Tensor<ValueType, true, Args...> Tensor<ValueType, own_data, Args...>::operator+(const ValueType &s) const {
-    Tensor<ValueType, true, Args...> M0;
-    const auto &M1 = *this;
-
-    for (Long i = 0; i < Size(); i++) {
-      M0.begin()[i] = M1.begin()[i] + s;
-    }
-    return M0;
+  template <class ValueType, bool own_data, Long... Args> TensorExpr<ValueType, tensor_detail::UnaryNode<tensor_detail::OpNeg, tensor_detail::LeafNode<ValueType>>, Args...> Tensor<ValueType, own_data, Args...>::operator-() const {
+    return TensorExpr<ValueType, tensor_detail::UnaryNode<tensor_detail::OpNeg, tensor_detail::LeafNode<ValueType>>, Args...>({Leaf()});
   }
 
-  template <class ValueType, bool own_data, Long... Args> Tensor<ValueType, true, Args...> Tensor<ValueType, own_data, Args...>::operator-(const ValueType &s) const {
-    Tensor<ValueType, true, Args...> M0;
-    const auto &M1 = *this;
-
-    for (Long i = 0; i < Size(); i++) {
-      M0.begin()[i] = M1.begin()[i] - s;
-    }
-    return M0;
+  template <class ValueType, bool own_data, Long... Args> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpAdd, tensor_detail::LeafNode<ValueType>, tensor_detail::ScalarNode<ValueType>, Args...> Tensor<ValueType, own_data, Args...>::operator+(const ValueType &s) const {
+    return tensor_detail::BinaryExpr<ValueType, tensor_detail::OpAdd, tensor_detail::LeafNode<ValueType>, tensor_detail::ScalarNode<ValueType>, Args...>({Leaf(), {s}});
   }
 
-  template <class ValueType, bool own_data, Long... Args> Tensor<ValueType, true, Args...> Tensor<ValueType, own_data, Args...>::operator*(const ValueType &s) const {
-    Tensor<ValueType, true, Args...> M0;
-    const auto &M1 = *this;
-
-    for (Long i = 0; i < Size(); i++) {
-      M0.begin()[i] = M1.begin()[i]*s;
-    }
-    return M0;
+  template <class ValueType, bool own_data, Long... Args> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpSub, tensor_detail::LeafNode<ValueType>, tensor_detail::ScalarNode<ValueType>, Args...> Tensor<ValueType, own_data, Args...>::operator-(const ValueType &s) const {
+    return tensor_detail::BinaryExpr<ValueType, tensor_detail::OpSub, tensor_detail::LeafNode<ValueType>, tensor_detail::ScalarNode<ValueType>, Args...>({Leaf(), {s}});
   }
 
-  template <class ValueType, bool own_data, Long... Args> Tensor<ValueType, true, Args...> Tensor<ValueType, own_data, Args...>::operator/(const ValueType &s) const {
-    Tensor<ValueType, true, Args...> M0;
-    const auto &M1 = *this;
+  template <class ValueType, bool own_data, Long... Args> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpMul, tensor_detail::LeafNode<ValueType>, tensor_detail::ScalarNode<ValueType>, Args...> Tensor<ValueType, own_data, Args...>::operator*(const ValueType &s) const {
+    return tensor_detail::BinaryExpr<ValueType, tensor_detail::OpMul, tensor_detail::LeafNode<ValueType>, tensor_detail::ScalarNode<ValueType>, Args...>({Leaf(), {s}});
+  }
 
-    for (Long i = 0; i < Size(); i++) {
-      M0.begin()[i] = M1.begin()[i]/s;
-    }
-    return M0;
+  template <class ValueType, bool own_data, Long... Args> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpDiv, tensor_detail::LeafNode<ValueType>, tensor_detail::ScalarNode<ValueType>, Args...> Tensor<ValueType, own_data, Args...>::operator/(const ValueType &s) const {
+    return tensor_detail::BinaryExpr<ValueType, tensor_detail::OpDiv, tensor_detail::LeafNode<ValueType>, tensor_detail::ScalarNode<ValueType>, Args...>({Leaf(), {s}});
   }
 
-  template <class ValueType, bool own_data, Long... Args> template <bool own_data_> Tensor<ValueType, true, Args...> Tensor<ValueType, own_data, Args...>::operator+(const Tensor<ValueType, own_data_, Args...> &M2) const {
-    Tensor<ValueType, true, Args...> M0;
-    const auto &M1 = *this;
+  template <class ValueType, bool own_data, Long... Args> template <bool own_data_> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpAdd, tensor_detail::LeafNode<ValueType>, tensor_detail::LeafNode<ValueType>, Args...> Tensor<ValueType, own_data, Args...>::operator+(const Tensor<ValueType, own_data_, Args...> &M2) const {
+    return tensor_detail::BinaryExpr<ValueType, tensor_detail::OpAdd, tensor_detail::LeafNode<ValueType>, tensor_detail::LeafNode<ValueType>, Args...>({Leaf(), M2.Leaf()});
+  }
 
-    for (Long i = 0; i < Size(); i++) {
-      M0.begin()[i] = M1.begin()[i] + M2.begin()[i];
-    }
-    return M0;
+  template <class ValueType, bool own_data, Long... Args> template <bool own_data_> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpSub, tensor_detail::LeafNode<ValueType>, tensor_detail::LeafNode<ValueType>, Args...> Tensor<ValueType, own_data, Args...>::operator-(const Tensor<ValueType, own_data_, Args...> &M2) const {
+    return tensor_detail::BinaryExpr<ValueType, tensor_detail::OpSub, tensor_detail::LeafNode<ValueType>, tensor_detail::LeafNode<ValueType>, Args...>({Leaf(), M2.Leaf()});
   }
 
-  template <class ValueType, bool own_data, Long... Args> template <bool own_data_> Tensor<ValueType, true, Args...> Tensor<ValueType, own_data, Args...>::operator-(const Tensor<ValueType, own_data_, Args...> &M2) const {
-    Tensor<ValueType, true, Args...> M0;
-    const auto &M1 = *this;
+  template <class ValueType, bool own_data, Long... Args> template <class Expr> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpAdd, tensor_detail::LeafNode<ValueType>, Expr, Args...> Tensor<ValueType, own_data, Args...>::operator+(const TensorExpr<ValueType, Expr, Args...> &M2) const {
+    return tensor_detail::BinaryExpr<ValueType, tensor_detail::OpAdd, tensor_detail::LeafNode<ValueType>, Expr, Args...>({Leaf(), M2.expr});
+  }
 
-    for (Long i = 0; i < Size(); i++) {
-      M0.begin()[i] = M1.begin()[i] - M2.begin()[i];
-    }
-    return M0;
+  template <class ValueType, bool own_data, Long... Args> template <class Expr> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpSub, tensor_detail::LeafNode<ValueType>, Expr, Args...> Tensor<ValueType, own_data, Args...>::operator-(const TensorExpr<ValueType, Expr, Args...> &M2) const {
+    return tensor_detail::BinaryExpr<ValueType, tensor_detail::OpSub, tensor_detail::LeafNode<ValueType>, Expr, Args...>({Leaf(), M2.expr});
   }
 
   template <class ValueType, bool own_data, Long... Args> template <bool own_data_, Long N1, Long N2> Tensor<ValueType, true, TensorArgExtract<0, Args...>(), N2> Tensor<ValueType, own_data, Args...>::operator*(const Tensor<ValueType, own_data_, N1, N2> &M2) const {
     static_assert(Order() == 2, "Multiplication is only defined for tensors of order two.");
     static_assert(Dim<1>() == N1, "Tensor dimensions don't match for multiplication.");
     Tensor<ValueType, true, Dim<0>(), N2> M0;
-    const auto &M1 = *this;
-
-    for (Long i = 0; i < Dim<0>(); i++) {
-      for (Long j = 0; j < N2; j++) {
-        ValueType Mij = 0;
-        for (Long k = 0; k < N1; k++) {
-          Mij += M1(i,k)*M2(k,j);
-        }
-        M0(i,j) = Mij;
-      }
-    }
+    mat::gemm_small<Dim<0>(), N2, N1, ValueType>(begin(), M2.begin(), M0.begin());
     return M0;
   }
 
+  template <class ValueType, bool own_data, Long... Args> template <class Expr, Long N1, Long N2> Tensor<ValueType, true, TensorArgExtract<0, Args...>(), N2> Tensor<ValueType, own_data, Args...>::operator*(const TensorExpr<ValueType, Expr, N1, N2> &M2) const {
+    return (*this) * M2.Eval();
+  }
+
   template <class ValueType, bool own_data, Long... Args> template <Integer k> Long Tensor<ValueType, own_data, Args...>::offset() {
     return 0;
   }
@@ -331,6 +399,117 @@ namespace sctl {
     return output;
   }
 
+
+  template <class ValueType, class Expr, Long... Args> constexpr Long TensorExpr<ValueType, Expr, Args...>::Order() {
+    return TensorArgCount<void, Args...>();
+  }
+
+  template <class ValueType, class Expr, Long... Args> constexpr Long TensorExpr<ValueType, Expr, Args...>::Size() {
+    return TensorArgProduct<0, Args...>();
+  }
+
+  template <class ValueType, class Expr, Long... Args> template <Long k> constexpr Long TensorExpr<ValueType, Expr, Args...>::Dim() {
+    return TensorArgExtract<k, Args...>();
+  }
+
+  template <class ValueType, class Expr, Long... Args> TensorExpr<ValueType, Expr, Args...>::TensorExpr(const Expr& expr_) : expr(expr_) {
+  }
+
+  template <class ValueType, class Expr, Long... Args> Tensor<ValueType, true, Args...> TensorExpr<ValueType, Expr, Args...>::Eval() const {
+    return Tensor<ValueType, true, Args...>(*this);
+  }
+
+  template <class ValueType, class Expr, Long... Args> void TensorExpr<ValueType, Expr, Args...>::EvalTo(Iterator<ValueType> out) const {
+    constexpr Integer VecLen = DefaultVecLen<ValueType>();
+    constexpr Long N = Size();
+    constexpr Long N0 = (N / VecLen) * VecLen;
+    for (Long i = 0; i < N0; i += VecLen) {
+      expr.template VecElem<VecLen>(i).Store(&out[i]);
+    }
+    for (Long i = N0; i < N; i++) {
+      out[i] = expr.Elem(i);
+    }
+  }
+
+  template <class ValueType, class Expr, Long... Args> template <class ...PackedLong> ValueType TensorExpr<ValueType, Expr, Args...>::operator()(PackedLong... ii) const {
+    return expr.Elem(offset<0>(ii...));
+  }
+
+  template <class ValueType, class Expr, Long... Args> typename TensorRotateLeftType<ValueType,true,Args...>::Value TensorExpr<ValueType, Expr, Args...>::RotateLeft() const {
+    return Eval().RotateLeft();
+  }
+
+  template <class ValueType, class Expr, Long... Args> typename TensorRotateRightType<ValueType,true,Args...>::Value TensorExpr<ValueType, Expr, Args...>::RotateRight() const {
+    return Eval().RotateRight();
+  }
+
+  template <class ValueType, class Expr, Long... Args> TensorExpr<ValueType, Expr, Args...> TensorExpr<ValueType, Expr, Args...>::operator+() const {
+    return *this;
+  }
+
+  template <class ValueType, class Expr, Long... Args> TensorExpr<ValueType, tensor_detail::UnaryNode<tensor_detail::OpNeg, Expr>, Args...> TensorExpr<ValueType, Expr, Args...>::operator-() const {
+    return TensorExpr<ValueType, tensor_detail::UnaryNode<tensor_detail::OpNeg, Expr>, Args...>({expr});
+  }
+
+  template <class ValueType, class Expr, Long... Args> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpAdd, Expr, tensor_detail::ScalarNode<ValueType>, Args...> TensorExpr<ValueType, Expr, Args...>::operator+(const ValueType &s) const {
+    return tensor_detail::BinaryExpr<ValueType, tensor_detail::OpAdd, Expr, tensor_detail::ScalarNode<ValueType>, Args...>({expr, {s}});
+  }
+
+  template <class ValueType, class Expr, Long... Args> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpSub, Expr, tensor_detail::ScalarNode<ValueType>, Args...> TensorExpr<ValueType, Expr, Args...>::operator-(const ValueType &s) const {
+    return tensor_detail::BinaryExpr<ValueType, tensor_detail::OpSub, Expr, tensor_detail::ScalarNode<ValueType>, Args...>({expr, {s}});
+  }
+
+  template <class ValueType, class Expr, Long... Args> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpMul, Expr, tensor_detail::ScalarNode<ValueType>, Args...> TensorExpr<ValueType, Expr, Args...>::operator*(const ValueType &s) const {
+    return tensor_detail::BinaryExpr<ValueType, tensor_detail::OpMul, Expr, tensor_detail::ScalarNode<ValueType>, Args...>({expr, {s}});
+  }
+
+  template <class ValueType, class Expr, Long... Args> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpDiv, Expr, tensor_detail::ScalarNode<ValueType>, Args...> TensorExpr<ValueType, Expr, Args...>::operator/(const ValueType &s) const {
+    return tensor_detail::BinaryExpr<ValueType, tensor_detail::OpDiv, Expr, tensor_detail::ScalarNode<ValueType>, Args...>({expr, {s}});
+  }
+
+  template <class ValueType, class Expr, Long... Args> template <bool own_data_> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpAdd, Expr, tensor_detail::LeafNode<ValueType>, Args...> TensorExpr<ValueType, Expr, Args...>::operator+(const Tensor<ValueType, own_data_, Args...> &M2) const {
+    return tensor_detail::BinaryExpr<ValueType, tensor_detail::OpAdd, Expr, tensor_detail::LeafNode<ValueType>, Args...>({expr, M2.Leaf()});
+  }
+
+  template <class ValueType, class Expr, Long... Args> template <bool own_data_> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpSub, Expr, tensor_detail::LeafNode<ValueType>, Args...> TensorExpr<ValueType, Expr, Args...>::operator-(const Tensor<ValueType, own_data_, Args...> &M2) const {
+    return tensor_detail::BinaryExpr<ValueType, tensor_detail::OpSub, Expr, tensor_detail::LeafNode<ValueType>, Args...>({expr, M2.Leaf()});
+  }
+
+  template <class ValueType, class Expr, Long... Args> template <class Expr2> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpAdd, Expr, Expr2, Args...> TensorExpr<ValueType, Expr, Args...>::operator+(const TensorExpr<ValueType, Expr2, Args...> &M2) const {
+    return tensor_detail::BinaryExpr<ValueType, tensor_detail::OpAdd, Expr, Expr2, Args...>({expr, M2.expr});
+  }
+
+  template <class ValueType, class Expr, Long... Args> template <class Expr2> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpSub, Expr, Expr2, Args...> TensorExpr<ValueType, Expr, Args...>::operator-(const TensorExpr<ValueType, Expr2, Args...> &M2) const {
+    return tensor_detail::BinaryExpr<ValueType, tensor_detail::OpSub, Expr, Expr2, Args...>({expr, M2.expr});
+  }
+
+  template <class ValueType, class Expr, Long... Args> template <bool own_data_, Long N1, Long N2> Tensor<ValueType, true, TensorArgExtract<0, Args...>(), N2> TensorExpr<ValueType, Expr, Args...>::operator*(const Tensor<ValueType, own_data_, N1, N2> &M2) const {
+    return Eval() * M2;
+  }
+
+  template <class ValueType, class Expr, Long... Args> template <class Expr2, Long N1, Long N2> Tensor<ValueType, true, TensorArgExtract<0, Args...>(), N2> TensorExpr<ValueType, Expr, Args...>::operator*(const TensorExpr<ValueType, Expr2, N1, N2> &M2) const {
+    return Eval() * M2.Eval();
+  }
+
+  template <class ValueType, class Expr, Long... Args> template <Integer k> Long TensorExpr<ValueType, Expr, Args...>::offset() {
+    return 0;
+  }
+  template <class ValueType, class Expr, Long... Args> template <Integer k, class ...PackedLong> Long TensorExpr<ValueType, Expr, Args...>::offset(Long i, PackedLong... ii) {
+    return i * TensorArgProduct<-(k+1),Args...>() + offset<k+1>(ii...);
+  }
+
+  template <class ValueType, bool own_data, Long... Args> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpMul, tensor_detail::LeafNode<ValueType>, tensor_detail::ScalarNode<ValueType>, Args...> operator*(const typename tensor_detail::ScalarNode<ValueType>::Type &s, const Tensor<ValueType, own_data, Args...> &M) {
+    return M * s;
+  }
+
+  template <class ValueType, class Expr, Long... Args> tensor_detail::BinaryExpr<ValueType, tensor_detail::OpMul, Expr, tensor_detail::ScalarNode<ValueType>, Args...> operator*(const typename tensor_detail::ScalarNode<ValueType>::Type &s, const TensorExpr<ValueType, Expr, Args...> &M) {
+    return M * s;
+  }
+
+  template <class ValueType, class Expr, Long N1, Long N2> std::ostream& operator<<(std::ostream &output, const TensorExpr<ValueType, Expr, N1, N2> &M) {
+    return output << M.Eval();
+  }
+
 }  // end namespace
 
 #endif // _SCTL_TENSOR_TXX_
@@ -23,10 +23,17 @@ template <Integer DIM> class Morton;
  * Class template representing a tree data structure.
  *
  * @tparam DIM Number of spatial dimensions.
+ * @tparam MID Type of the node IDs which determines the space-filling curve ordering of the nodes; Morton<DIM>
+ * (default) or Hilbert<DIM>.
  */
-template <Integer DIM> class Tree {
+template <Integer DIM, class MID = Morton<DIM>> class Tree {
   public:
 
+    /**
+     * Type of the node IDs.
+     */
+    typedef MID MIDType;
+
     /**
      * Structure for storing attributes of a tree node.
      */
@@ -44,6 +51,21 @@ template <Integer DIM> class Tree {
       Long nbr[sctl::pow<DIM,Integer>(3)];  ///< index of the neighbors at the same level
     };
 
+    /**
+     * Non-owning (zero-copy) view of the data of a named field, with the offset of the data of each node. The view
+     * does not own the memory and is invalidated by any operation that modifies the data or the tree (AddData,
+     * DeleteData, InterleaveData, ReduceBroadcast, Broadcast, UpdateRefinement, Repartition).
+     */
+    template <class ValueType> struct DataView {
+      Long dof;                ///< number of ValueType elements per data element
+      Vector<ValueType> data;  ///< contiguous data of all nodes
+      Vector<Long> cnt;        ///< number of data elements of each node
+      Vector<Long> dsp;        ///< offset of the data of each node in data (in ValueType elements)
+
+      Iterator<ValueType> operator[](Long i) { return data.begin() + dsp[i]; }  ///< data of node i
+      ConstIterator<ValueType> operator[](Long i) const { return data.begin() + dsp[i]; }  ///< data of node i
+    };
+
     /**
      * @return The number of spatial dimensions.
      */
@@ -62,14 +84,14 @@ template <Integer DIM> class Tree {
     ~Tree();
 
     /**
-     * @return Vector of Morton IDs partitioning the processor domains.
+     * @return Vector of node IDs partitioning the processor domains.
      */
-    const Vector<Morton<DIM>>& GetPartitionMID() const;
+    const Vector<MID>& GetPartitionMID() const;
 
     /**
-     * @return Vector of Morton IDs of tree nodes.
+     * @return Vector of node IDs of tree nodes.
      */
-    const Vector<Morton<DIM>>& GetNodeMID() const;
+    const Vector<MID>& GetNodeMID() const;
 
     /**
      * @return Vector of attributes of tree nodes.
@@ -94,10 +116,34 @@ template <Integer DIM> class Tree {
      * @param[in] balance21 Whether to do level-restriction (2:1 balance refinement).
      * @param[in] periodic Whether the tree is periodic across the faces of the cube.
      * @param[in] halo_size 2^halo_size neighboring boxes will be included in the halo region
+     * @param[in] incremental Keep the current partition of the domain among the processes. Only the particles outside
+     * the Morton range of their process are exchanged (without a global sort) and each process refines its own part of
+     * the tree. The tree is partitioned from scratch when the partition is no longer load balanced (a process has more
+     * than 1.5 times the average number of particles, or none).
      *
      * @note This is a collective operation and must be called from all processes in the communicator.
      */
-    template <class Real> void UpdateRefinement(const Vector<Real>& coord, Long M = 1, bool balance21 = 0, bool periodic = 0, Integer halo_size = -1);
+    template <class Real> void UpdateRefinement(const Vector<Real>& coord, Long M = 1, bool balance21 = 0, bool periodic = 0, Integer halo_size = -1, bool incremental = false);
+
+    /**
+     * Repartition the leaves of the tree among the processes to balance the given per-node weights (for example, the
+     * estimated work of each leaf from PtTree::LeafWeights), and move the node data to the new partition. The
+     * refinement of the tree is not changed.
+     *
+     * @param[in] wts Weight of each tree node (only the weights of the local leaves are used, and are at least 1).
+     * @param[in] periodic Whether the tree is periodic across the faces of the cube.
+     * @param[in] halo_size 2^halo_size neighboring boxes will be included in the halo region.
+     * @param[in] threshold The tree is repartitioned only if the maximum weight of a process exceeds the average by
+     * this factor, to avoid repartitioning for small imbalances.
+     * @param[in] time Measured time (e.g. from Profile) of the work modeled by the weights on this process in the
+     * previous step. If it is positive on all processes, the weights of each process are rescaled so that their sum is
+     * proportional to its measured time.
+     *
+     * @return Whether the tree was repartitioned.
+     *
+     * @note This is a collective operation and must be called from all processes in the communicator.
+     */
+    bool Repartition(const Vector<Long>& wts, bool periodic = 0, Integer halo_size = -1, double threshold = 1.1, double time = 0);
 
     /**
      * Add named data to the tree nodes.
@@ -122,6 +168,28 @@ template <Integer DIM> class Tree {
      */
     template <class ValueType> void GetData(Vector<ValueType>& data, Vector<Long>& cnt, const std::string& name) const;
 
+    /**
+     * Get a view of the node data with precomputed offsets for each node. The data is not copied, and it may be
+     * modified in-place through the view.
+     *
+     * @param[out] view View of the data (see DataView).
+     * @param[in] name Name of the data.
+     */
+    template <class ValueType> void GetDataView(DataView<ValueType>& view, const std::string& name) const;
+
+    /**
+     * Replace several fields (with the same data counts) by a single field in which they are interleaved, i.e. all
+     * the values of the fields for a data element are stored contiguously (in the order of the fields). Loops over
+     * the nodes can then read the values of all fields together instead of from separate arrays. The interleaved
+     * field is handled like any other field (e.g. ReduceBroadcast, Broadcast, UpdateRefinement).
+     *
+     * @param[in] name Name of the interleaved field.
+     * @param[in] fields Names of the fields to be interleaved. These fields are deleted.
+     *
+     * @note This is a collective operation and must be called from all processes in the communicator.
+     */
+    template <class ValueType> void InterleaveData(const std::string& name, const Vector<std::string>& fields);
+
     /**
      * Reduce data on nodes shared between processors and then broadcast the halo/ghost node data. The resulting tree
      * will have ghost nodes added to the tree.
@@ -135,6 +203,9 @@ template <Integer DIM> class Tree {
     /**
      * Broadcast the halo/ghost node data. The resulting tree will have ghost nodes added to the tree.
      *
+     * The communication plan (list of nodes exchanged with each process and their data counts) is built on the first
+     * call after UpdateRefinement and reused by later calls, which then only exchange the data values.
+     *
      * @param[in] name Name of the data.
      *
      * @note This is a collective operation and must be called from all processes in the communicator.
@@ -174,17 +245,76 @@ template <Integer DIM> class Tree {
 
   private:
 
-    Vector<Morton<DIM>> mins;
-    Vector<Morton<DIM>> node_mid;
+    /**
+     * Build the local part of the linear tree (node_mid) in the current partition (mins) with at most M
+     * particles per leaf. The particles outside the Morton range of this process are sent to their owner.
+     *
+     * @return False (without modifying the tree) if the current partition is not load balanced.
+     *
+     * @note This is a collective operation and must be called from all processes in the communicator.
+     */
+    template <class Real> bool LocalRefinement(const Vector<Real>& coord, Long M);
+
+    /**
+     * Build the linear tree of the Morton range of this process in the partition mins, with at most M points pt_mid
+     * (sorted) per leaf. Boxes overlapping the range of the next process are always refined.
+     */
+    void LocalLinearTree(Vector<MID>& mid_lst, const Vector<MID>& pt_mid, Long M) const;
+
+    /**
+     * Complete the refinement after the local part of the linear tree (node_mid) and the partition (mins) are set: 2:1
+     * balance, ghost nodes, node attributes and lists, and move the node data from the previous tree (whose local
+     * nodes were node_mid_orig, at [start_idx_orig, end_idx_orig) in the previous node list).
+     *
+     * @note This is a collective operation and must be called from all processes in the communicator.
+     */
+    void FinishRefinement(Vector<MID>& node_mid_orig, Long start_idx_orig, Long end_idx_orig, bool balance21, bool periodic, Integer halo_size);
+
+    /**
+     * Plan for exchanging the data of a list of tree nodes with other
+     * processes. It is cached for each data name and rebuilt when the tree
+     * refinement or the data counts of the nodes being sent change.
+     */
+    struct CommPlan {
+      Long dof = 0;                            ///< number of ValueType elements per data element
+      Vector<Long> send_node_idx;              ///< index of each node sent (grouped by destination)
+      Vector<Long> send_data_cnt;              ///< data count of each node sent
+      Vector<Long> send_data_dsp;              ///< offset of each node in the send buffer (in data elements)
+      Vector<Long> recv_node_idx;              ///< index of each node received (grouped by source)
+      Vector<Long> recv_data_cnt;              ///< data count of each node received
+      Vector<Long> recv_data_dsp;              ///< offset of each node in the receive buffer (in data elements)
+      Vector<Long> send_buff_cnt, send_buff_dsp;  ///< send counts for each process (in ValueType elements)
+      Vector<Long> recv_buff_cnt, recv_buff_dsp;  ///< receive counts for each process (in ValueType elements)
+    };
+
+    /**
+     * Build a plan for sending the nodes send_mid (grouped by destination
+     * process, with send_node_cnt nodes for each process) with data counts
+     * cnt and dof elements per data element.
+     *
+     * @note This is a collective operation and must be called from all processes in the communicator.
+     */
+    void SetupCommPlan(CommPlan& plan, const Vector<MID>& send_mid, const Vector<Long>& send_node_cnt, const Vector<Long>& cnt, Long dof) const;
+
+    /**
+     * @return True if the plan exists and the current data counts of the nodes that it sends match the plan.
+     */
+    static bool CheckCommPlan(const std::map<std::string, CommPlan>& plan_map, const std::string& name, const Vector<Long>& cnt);
+
+    Vector<MID> mins;
+    Vector<MID> node_mid;
     Vector<NodeAttr> node_attr;
     Vector<NodeLists> node_lst;
 
     std::map<std::string, Vector<char>> node_data;
     std::map<std::string, Vector<Long>> node_cnt;
 
-    Vector<Morton<DIM>> user_mid;
+    Vector<MID> user_mid;
     Vector<Long> user_cnt;
 
+    std::map<std::string, CommPlan> bcast_plan;   // cached plans for Broadcast
+    std::map<std::string, CommPlan> reduce_plan;  // cached plans for the reduction in ReduceBroadcast
+
     Comm comm;
 };
 
@@ -198,6 +328,11 @@ template <Integer DIM> class Tree {
 template <class Real, Integer DIM, class BaseTree = Tree<DIM>> class PtTree : public BaseTree {
   public:
 
+    /**
+     * Type of the node IDs.
+     */
+    typedef typename BaseTree::MIDType MID;
+
     /**
      * Constructor for PtTree.
      *
@@ -219,10 +354,38 @@ template <class Real, Integer DIM, class BaseTree = Tree<DIM>> class PtTree : pu
      *        tree with neighboring boxes within one level of each other.
      * @param periodic Flag indicating periodic boundary conditions.
      * @param[in] halo_size 2^halo_size neighboring boxes will be included in the halo region
+     * @param[in] incremental Keep the current partition and refine locally (see Tree::UpdateRefinement).
+     *
+     * @note This is a collective operation and must be called from all processes in the communicator.
+     */
+    void UpdateRefinement(const Vector<Real>& coord, Long M = 1, bool balance21 = 0, bool periodic = 0, Integer halo_size = -1, bool incremental = false);
+
+    /**
+     * Repartition the tree to balance the given per-node weights and move the particles and their data to the new
+     * partition (see Tree::Repartition).
+     *
+     * @return Whether the tree was repartitioned.
+     *
+     * @note This is a collective operation and must be called from all processes in the communicator.
+     */
+    bool Repartition(const Vector<Long>& wts, bool periodic = 0, Integer halo_size = -1, double threshold = 1.1, double time = 0);
+
+    /**
+     * Estimate the work of each local leaf for a near-field (particle-to-particle) interaction: pair_cost times the
+     * number of particle pairs between the leaf and its neighbors (at the same or a coarser level, including itself),
+     * plus pt_cost times the number of particles in the leaf (for the far-field work). Both costs can be calibrated
+     * from measured timings. The weights of ghost and non-leaf nodes are zero. The neighbors are only found within the
+     * halo of the tree (see UpdateRefinement).
+     *
+     * @param[out] wts Weight of each tree node, to be used with Repartition.
+     * @param[in] particle_name Name of the particle group.
+     * @param[in] pair_cost Cost of one particle-particle interaction.
+     * @param[in] pt_cost Cost per particle.
+     * @param[in] periodic Whether the tree is periodic across the faces of the cube.
      *
      * @note This is a collective operation and must be called from all processes in the communicator.
      */
-    void UpdateRefinement(const Vector<Real>& coord, Long M = 1, bool balance21 = 0, bool periodic = 0, Integer halo_size = -1);
+    void LeafWeights(Vector<Long>& wts, const std::string& particle_name, Long pair_cost = 1, Long pt_cost = 0, bool periodic = 0);
 
     /**
      * Add particles to the point tree.
@@ -256,6 +419,19 @@ template <class Real, Integer DIM, class BaseTree = Tree<DIM>> class PtTree : pu
      */
     void GetParticleData(Vector<Real>& data, const std::string& data_name) const;
 
+    /**
+     * Replace several data fields of the same particle group by a single field in which they are interleaved (see
+     * Tree::InterleaveData). GetParticleData on the new field returns, for each particle, the values of all the fields
+     * together. Use GetDataView for zero-copy access to the particle data in tree order.
+     *
+     * @param data_name Name of the interleaved data.
+     * @param fields Names of the data fields to be interleaved (not including the particle coordinates). These fields
+     * are deleted.
+     *
+     * @note This is a collective operation and must be called from all processes in the communicator.
+     */
+    void InterleaveParticleData(const std::string& data_name, const Vector<std::string>& fields);
+
     /**
      * Delete particle data from the point tree.
      *
@@ -285,8 +461,15 @@ template <class Real, Integer DIM, class BaseTree = Tree<DIM>> class PtTree : pu
 
   private:
 
+    /**
+     * Move the particles and their data to the current partition of the tree and update their node counts.
+     *
+     * @note This is a collective operation and must be called from all processes in the communicator.
+     */
+    void RepartitionParticles();
+
     std::map<std::string, Long> Nlocal;                    ///< Number of local particles for each group.
-    std::map<std::string, Vector<Morton<DIM>>> pt_mid;     ///< Morton indices for each particle group.
+    std::map<std::string, Vector<MID>> pt_mid;     ///< Node IDs (at max depth) for each particle group.
     std::map<std::string, Vector<Long>> scatter_idx;       ///< Scatter indices for each particle group.
     std::map<std::string, std::string> data_pt_name;       ///< Mapping of data name to particle name.
 };
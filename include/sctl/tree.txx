@@ -2,7 +2,7 @@
 #define _SCTL_TREE_TXX_
 
 #include <stdlib.h>               // for drand48
-#include <algorithm>              // for lower_bound, max, min, sort
+#include <algorithm>              // for lower_bound, upper_bound, find, max, min, sort
 #include <cstdint>                // for int32_t, uint8_t
 #include <map>                    // for map, operator!=, __map_iterator
 #include <set>                    // for set, __tree_const_iterator
@@ -48,14 +48,10 @@ namespace sctl {
       //const auto& node_mid = tree.GetNodeMID();
       //const auto& node_attr = tree.GetNodeAttr();
 
-      // get point values and count for each node
-      Vector<Real> value;
-      Vector<Long> cnt, dsp;
-      tree.GetData(value, cnt, "pt-value");
-
-      // compute the dsp (the point offset) for each node
-      dsp.ReInit(cnt.Dim()); dsp = 0;
-      omp_par::scan(cnt.begin(), dsp.begin(), cnt.Dim());
+      // get a view of the point values with the count and offset for each node
+      typename Tree<DIM>::template DataView<Real> value;
+      tree.GetDataView(value, "pt-value");
+      const auto& cnt = value.cnt;
 
       Long node_idx = 0;
       for (Long i = 0; i < cnt.Dim(); i++) { // find the tree node with maximum points
@@ -63,13 +59,13 @@ namespace sctl {
       }
 
       for (Long j = 0; j < cnt[node_idx]; j++) { // for this node, set all pt-value to -1
-        value[dsp[node_idx]+j] = -1;
+        value[node_idx][j] = -1;
       }
 
       for (const Long nbr_idx : node_lst[node_idx].nbr) { // loop over the neighbors and set pt-value to 2
         if (nbr_idx >= 0 && nbr_idx != node_idx) {
           for (Long j = 0; j < cnt[nbr_idx]; j++) {
-            value[dsp[nbr_idx]+j] = 2;
+            value[nbr_idx][j] = 2;
           }
         }
       }
@@ -80,11 +76,11 @@ namespace sctl {
     tree.WriteTreeVTK("tree");
   }
 
-  template <Integer DIM> constexpr Integer Tree<DIM>::Dim() {
+  template <Integer DIM, class MID> constexpr Integer Tree<DIM,MID>::Dim() {
     return DIM;
   }
 
-  template <Integer DIM> Tree<DIM>::Tree(const Comm& comm_) : comm(comm_) {
+  template <Integer DIM, class MID> Tree<DIM,MID>::Tree(const Comm& comm_) : comm(comm_) {
     Integer rank = comm.Rank();
     Integer np = comm.Size();
 
@@ -107,7 +103,7 @@ namespace sctl {
     this->UpdateRefinement(coord);
   }
 
-  template <Integer DIM> Tree<DIM>::~Tree() {
+  template <Integer DIM, class MID> Tree<DIM,MID>::~Tree() {
     #ifdef SCTL_MEMDEBUG
     for (auto& pair : node_data) {
       SCTL_ASSERT(node_cnt.find(pair.first) != node_cnt.end());
@@ -115,39 +111,41 @@ namespace sctl {
     #endif
   }
 
-  template <Integer DIM> const Vector<Morton<DIM>>& Tree<DIM>::GetPartitionMID() const {
+  template <Integer DIM, class MID> const Vector<MID>& Tree<DIM,MID>::GetPartitionMID() const {
     return mins;
   }
-  template <Integer DIM> const Vector<Morton<DIM>>& Tree<DIM>::GetNodeMID() const {
+  template <Integer DIM, class MID> const Vector<MID>& Tree<DIM,MID>::GetNodeMID() const {
     return node_mid;
   }
-  template <Integer DIM> const Vector<typename Tree<DIM>::NodeAttr>& Tree<DIM>::GetNodeAttr() const {
+  template <Integer DIM, class MID> const Vector<typename Tree<DIM,MID>::NodeAttr>& Tree<DIM,MID>::GetNodeAttr() const {
     return node_attr;
   }
-  template <Integer DIM> const Vector<typename Tree<DIM>::NodeLists>& Tree<DIM>::GetNodeLists() const {
+  template <Integer DIM, class MID> const Vector<typename Tree<DIM,MID>::NodeLists>& Tree<DIM,MID>::GetNodeLists() const {
     return node_lst;
   }
-  template <Integer DIM> const Comm& Tree<DIM>::GetComm() const {
+  template <Integer DIM, class MID> const Comm& Tree<DIM,MID>::GetComm() const {
     return comm;
   }
 
-  template <Integer DIM> template <class Real> void Tree<DIM>::UpdateRefinement(const Vector<Real>& coord, Long M, bool balance21, bool periodic, Integer halo_size) {
+  template <Integer DIM, class MID> template <class Real> void Tree<DIM,MID>::UpdateRefinement(const Vector<Real>& coord, Long M, bool balance21, bool periodic, Integer halo_size, bool incremental) {
     const Integer np = comm.Size();
     const Integer rank = comm.Rank();
+    bcast_plan.clear();  // node indices and halo change with the refinement
+    reduce_plan.clear();
 
-    Vector<Morton<DIM>> node_mid_orig;
+    Vector<MID> node_mid_orig;
     Long start_idx_orig, end_idx_orig;
     if (mins.Dim()) { // Set start_idx_orig, end_idx_orig
       start_idx_orig = std::lower_bound(node_mid.begin(), node_mid.end(), mins[rank]) - node_mid.begin();
-      end_idx_orig = std::lower_bound(node_mid.begin(), node_mid.end(), (rank+1==np ? Morton<DIM>().Next() : mins[rank+1])) - node_mid.begin();
+      end_idx_orig = std::lower_bound(node_mid.begin(), node_mid.end(), (rank+1==np ? MID().Next() : mins[rank+1])) - node_mid.begin();
       node_mid_orig.ReInit(end_idx_orig - start_idx_orig, node_mid.begin() + start_idx_orig, true);
     } else {
       start_idx_orig = 0;
       end_idx_orig = 0;
     }
 
-    auto coarsest_ancestor_mid = [](const Morton<DIM>& m0) {
-      Morton<DIM> md;
+    auto coarsest_ancestor_mid = [](const MID& m0) {
+      MID md;
       Integer d0 = m0.Depth();
       for (Integer d = 0; d <= d0; d++) {
         md = m0.Ancestor(d);
@@ -155,47 +153,36 @@ namespace sctl {
       }
       return md;
     };
-    const auto complete_tree = [](Vector<Morton<DIM>>& mid_lst, const Morton<DIM>& mid_begin, const Morton<DIM>& mid_end) {
-      // Fill in the nodes for a completed tree in the interval
-      // [mid_begin, mid_end) and append to mid_lst.
-      // Returns mid_end.
-      SCTL_ASSERT(mid_begin <= mid_end);
-      Morton<DIM> mid_iter = mid_begin;
-      while (mid_iter != mid_end) {
-        mid_lst.PushBack(mid_iter);
-        if (mid_iter.isAncestor(mid_end)) mid_iter = mid_iter.Ancestor(mid_iter.Depth()+1);
-        else mid_iter = mid_iter.Next();
-      }
-      return mid_end;
-    };
 
-    Morton<DIM> pt_mid0;
-    Vector<Morton<DIM>> pt_mid;
-    { // Construct sorted pt_mid
+    const bool local_refinement = (incremental && mins.Dim() == np && LocalRefinement(coord, M));
+
+    MID pt_mid0;
+    Vector<MID> pt_mid;
+    if (!local_refinement) { // Construct sorted pt_mid
       Long Npt = coord.Dim() / DIM;
       pt_mid.ReInit(Npt);
       for (Long i = 0; i < Npt; i++) {
-        pt_mid[i] = Morton<DIM>(coord.begin() + i*DIM);
+        pt_mid[i] = MID(coord.begin() + i*DIM);
       }
-      Vector<Morton<DIM>> sorted_mid;
-      comm.HyperQuickSort(pt_mid, sorted_mid);
+      Vector<MID> sorted_mid;
+      comm.SampleSort(pt_mid, sorted_mid);
       pt_mid.Swap(sorted_mid);
       SCTL_ASSERT(pt_mid.Dim());
       pt_mid0 = pt_mid[0];
     }
-    { // Update M = global_min(pt_mid.Dim(), M)
+    if (!local_refinement) { // Update M = global_min(pt_mid.Dim(), M)
       Long M0, M1, Npt = pt_mid.Dim();
       comm.Allreduce(Ptr2ConstItr<Long>(&M,1), Ptr2Itr<Long>(&M0,1), 1, CommOp::MIN);
       comm.Allreduce(Ptr2ConstItr<Long>(&Npt,1), Ptr2Itr<Long>(&M1,1), 1, CommOp::MIN);
       M = std::min(M0,M1);
       SCTL_ASSERT(M > 0);
     }
-    { // pt_mid <-- [M points from rank-1; pt_mid; M points from rank+1]
+    if (!local_refinement) { // pt_mid <-- [M points from rank-1; pt_mid; M points from rank+1]
       Long send_size0 = (rank+1<np ? M : 0);
       Long send_size1 = (rank  > 0 ? M : 0);
       Long recv_size0 = (rank  > 0 ? M : 0);
       Long recv_size1 = (rank+1<np ? M : 0);
-      Vector<Morton<DIM>> pt_mid_(recv_size0 + pt_mid.Dim() + recv_size1);
+      Vector<MID> pt_mid_(recv_size0 + pt_mid.Dim() + recv_size1);
       memcopy(pt_mid_.begin()+recv_size0, pt_mid.begin(), pt_mid.Dim());
 
       void* recv_req0 = comm.Irecv(pt_mid_.begin(), recv_size0, (rank+np-1)%np, 0);
@@ -208,15 +195,15 @@ namespace sctl {
       comm.Wait(send_req1);
       pt_mid.Swap(pt_mid_);
     }
-    { // Build linear MortonID tree from pt_mid
+    if (!local_refinement) { // Build linear MortonID tree from pt_mid
       node_mid.ReInit(0);
       Long idx = 0;
-      Morton<DIM> m0;
-      const Morton<DIM> mend = Morton<DIM>().Next();
+      MID m0;
+      const MID mend = MID().Next();
       while (m0 < mend) {
         Integer d = m0.Depth();
-        Morton<DIM> m1 = (idx + M < pt_mid.Dim() ? pt_mid[idx+M] : Morton<DIM>().Next());
-        while (d < Morton<DIM>::MAX_DEPTH && m0.Ancestor(d) == m1.Ancestor(d)) {
+        MID m1 = (idx + M < pt_mid.Dim() ? pt_mid[idx+M] : MID().Next());
+        while (d < MID::MAX_DEPTH && m0.Ancestor(d) == m1.Ancestor(d)) {
           node_mid.PushBack(m0.Ancestor(d));
           d++;
         }
@@ -226,23 +213,43 @@ namespace sctl {
         idx = std::lower_bound(pt_mid.begin(), pt_mid.end(), m0) - pt_mid.begin();
       }
     }
-    { // Set mins
+    if (!local_refinement) { // Set mins
       mins.ReInit(np);
       Long min_idx = std::lower_bound(node_mid.begin(), node_mid.end(), pt_mid0) - node_mid.begin() - 1;
       if (!rank || min_idx < 0) min_idx = 0;
-      Morton<DIM> m0 = coarsest_ancestor_mid(node_mid[min_idx]);
-      comm.Allgather(Ptr2ConstItr<Morton<DIM>>(&m0,1), 1, mins.begin(), 1);
+      MID m0 = coarsest_ancestor_mid(node_mid[min_idx]);
+      comm.Allgather(Ptr2ConstItr<MID>(&m0,1), 1, mins.begin(), 1);
     }
+    FinishRefinement(node_mid_orig, start_idx_orig, end_idx_orig, balance21, periodic, halo_size);
+  }
+
+  template <Integer DIM, class MID> void Tree<DIM,MID>::FinishRefinement(Vector<MID>& node_mid_orig, Long start_idx_orig, Long end_idx_orig, bool balance21, bool periodic, Integer halo_size) {
+    const Integer np = comm.Size();
+    const Integer rank = comm.Rank();
+    const auto complete_tree = [](Vector<MID>& mid_lst, const MID& mid_begin, const MID& mid_end) {
+      // Fill in the nodes for a completed tree in the interval
+      // [mid_begin, mid_end) and append to mid_lst.
+      // Returns mid_end.
+      SCTL_ASSERT(mid_begin <= mid_end);
+      MID mid_iter = mid_begin;
+      while (mid_iter != mid_end) {
+        mid_lst.PushBack(mid_iter);
+        if (mid_iter.isAncestor(mid_end)) mid_iter = mid_iter.Ancestor(mid_iter.Depth()+1);
+        else mid_iter = mid_iter.Next();
+      }
+      return mid_end;
+    };
+
     if (balance21) { // 2:1 balance refinement // TODO: optimize
-      Vector<Morton<DIM>> parent_mid;
+      Vector<MID> parent_mid;
       { // add balancing Morton IDs
-        Vector<std::set<Morton<DIM>>> parent_mid_set(Morton<DIM>::MAX_DEPTH+1);
-        Vector<Morton<DIM>> nlst;
+        Vector<std::set<MID>> parent_mid_set(MID::MAX_DEPTH+1);
+        Vector<MID> nlst;
         for (const auto& m0 : node_mid) {
           const Integer d0 = m0.Depth();
           if (d0 > 0) parent_mid_set[d0-1].insert(m0.Ancestor(d0-1));
         }
-        for (Integer d = Morton<DIM>::MAX_DEPTH; d >= 0; d--) {
+        for (Integer d = MID::MAX_DEPTH; d >= 0; d--) {
           for (const auto& m : parent_mid_set[d]) {
             m.NbrList(nlst, d, periodic);
             for (const auto& nbr : nlst) if (nbr.Depth() > 0) parent_mid_set[d-1].insert(nbr.Ancestor(d-1));
@@ -254,8 +261,8 @@ namespace sctl {
       }
 
       { // global_sort parent_mid and remove duplicates
-        Vector<Morton<DIM>> parent_mid_sorted;
-        comm.HyperQuickSort(parent_mid, parent_mid_sorted);
+        Vector<MID> parent_mid_sorted;
+        comm.SampleSort(parent_mid, parent_mid_sorted);
         comm.PartitionS(parent_mid_sorted, mins[comm.Rank()]);
 
         parent_mid.ReInit(0);
@@ -267,8 +274,8 @@ namespace sctl {
       }
 
       if (parent_mid.Dim()) { // add children of parent_mid
-        Vector<Morton<DIM>> clst; // child list
-        std::set<Morton<DIM>> mid_set;
+        Vector<MID> clst; // child list
+        std::set<MID> mid_set;
         for (Integer d = 0; d < mins[rank].Depth(); d++) {
           mins[rank].Ancestor(d).Children(clst);
           mid_set.insert(clst.begin(), clst.end());
@@ -277,7 +284,7 @@ namespace sctl {
           mins[rank+1].Ancestor(d).Children(clst);
           mid_set.insert(clst.begin(), clst.end());
         }
-        mid_set.insert(Morton<DIM>());
+        mid_set.insert(MID());
 
         node_mid.ReInit(0);
         for (const auto m0 : parent_mid) {
@@ -296,21 +303,21 @@ namespace sctl {
       Long start_idx, end_idx;
       { // Set start_idx, end_idx
         start_idx = std::lower_bound(node_mid.begin(), node_mid.end(), mins[rank]) - node_mid.begin();
-        end_idx = std::lower_bound(node_mid.begin(), node_mid.end(), (rank+1==np ? Morton<DIM>().Next() : mins[rank+1])) - node_mid.begin();
+        end_idx = std::lower_bound(node_mid.begin(), node_mid.end(), (rank+1==np ? MID().Next() : mins[rank+1])) - node_mid.begin();
       }
       { // Set user_mid, user_cnt
-        Vector<SortPair<Long,Morton<DIM>>> user_node_lst;
-        Vector<Morton<DIM>> nlst;
+        Vector<SortPair<Long,MID>> user_node_lst;
+        Vector<MID> nlst;
         std::set<Long> user_procs;
         for (Long i = start_idx; i < end_idx; i++) {
-          Morton<DIM> m0 = node_mid[i];
+          MID m0 = node_mid[i];
           Integer d0 = m0.Depth();
           if (halo_size >= 0) m0.NbrList(nlst, std::max<Integer>(d0-halo_size,0), periodic);
           user_procs.clear();
           for (const auto& m : nlst) {
             if (m.Depth() >= 0) {
-              Morton<DIM> m_start = m.DFD();
-              Morton<DIM> m_end = m.Next();
+              MID m_start = m.DFD();
+              MID m_end = m.Next();
               Integer p_start = std::lower_bound(mins.begin(), mins.end(), m_start) - mins.begin() - 1;
               Integer p_end   = std::lower_bound(mins.begin(), mins.end(), m_end  ) - mins.begin();
               SCTL_ASSERT(0 <= p_start);
@@ -322,18 +329,18 @@ namespace sctl {
             }
           }
           for (const auto p : user_procs) {
-            SortPair<Long,Morton<DIM>> pair;
+            SortPair<Long,MID> pair;
             pair.key = p;
             pair.data = m0;
             user_node_lst.PushBack(pair);
           }
         }
-        omp_par::merge_sort(user_node_lst.begin(), user_node_lst.end());
+        omp_par::radix_sort(user_node_lst.begin(), user_node_lst.end(), [](const SortPair<Long,MID>& a) { return a.key; });
 
         user_cnt.ReInit(np);
         user_mid.ReInit(user_node_lst.Dim());
         for (Integer i = 0; i < np; i++) {
-          SortPair<Long,Morton<DIM>> pair_start, pair_end;
+          SortPair<Long,MID> pair_start, pair_end;
           pair_start.key = i;
           pair_end.key = i+1;
           Long cnt_start = std::lower_bound(user_node_lst.begin(), user_node_lst.end(), pair_start) - user_node_lst.begin();
@@ -346,7 +353,7 @@ namespace sctl {
         }
       }
 
-      Vector<Morton<DIM>> ghost_mid;
+      Vector<MID> ghost_mid;
       { // SendRecv user_mid
         const Vector<Long>& send_cnt = user_cnt;
         Vector<Long> send_dsp(np);
@@ -356,7 +363,7 @@ namespace sctl {
         comm.Alltoall(send_cnt.begin(), 1, recv_cnt.begin(), 1);
         scan(recv_dsp, recv_cnt);
 
-        const Vector<Morton<DIM>>& send_mid = user_mid;
+        const Vector<MID>& send_mid = user_mid;
         Long Nsend = send_dsp[np-1] + send_cnt[np-1];
         Long Nrecv = recv_dsp[np-1] + recv_cnt[np-1];
         SCTL_ASSERT(send_mid.Dim() == Nsend);
@@ -367,9 +374,9 @@ namespace sctl {
 
       { // Update node_mid <-- ghost_mid + node_mid
         const Long Nsplit = std::lower_bound(ghost_mid.begin(), ghost_mid.end(), mins[rank]) - ghost_mid.begin();
-        Vector<Morton<DIM>> mid_lst = node_mid;
+        Vector<MID> mid_lst = node_mid;
         node_mid.ReInit(0);
-        Morton<DIM> m;
+        MID m;
         for (Long i = 0; i < Nsplit; i++) {
           m = complete_tree(node_mid, m, ghost_mid[i]);
         }
@@ -381,12 +388,12 @@ namespace sctl {
         for (Long i = Nsplit; i < ghost_mid.Dim(); i++) {
           m = complete_tree(node_mid, m, ghost_mid[i]);
         }
-        complete_tree(node_mid, m, Morton<DIM>().Next());
+        complete_tree(node_mid, m, MID().Next());
       }
     }
     { // Set node_attr
-      Morton<DIM> m0 = (rank      ? mins[rank]   : Morton<DIM>()       );
-      Morton<DIM> m1 = (rank+1<np ? mins[rank+1] : Morton<DIM>().Next());
+      MID m0 = (rank      ? mins[rank]   : MID()       );
+      MID m1 = (rank+1<np ? mins[rank+1] : MID().Next());
       Long Nnodes = node_mid.Dim();
       node_attr.ReInit(Nnodes);
       for (Long i = 0; i < Nnodes; i++) {
@@ -400,8 +407,8 @@ namespace sctl {
       const Long Nnodes = node_mid.Dim();
       node_lst.ReInit(Nnodes);
 
-      Vector<Long> ancestors(Morton<DIM>::MAX_DEPTH+1);
-      Vector<Long> child_cnt(Morton<DIM>::MAX_DEPTH+1);
+      Vector<Long> ancestors(MID::MAX_DEPTH+1);
+      Vector<Long> child_cnt(MID::MAX_DEPTH+1);
       #pragma omp parallel for schedule(static)
       for (Long i = 0; i < Nnodes; i++) {
         node_lst[i].p2n = -1;
@@ -422,7 +429,7 @@ namespace sctl {
           c++;
         }
       }
-      Vector<Morton<DIM>> nlst;
+      Vector<MID> nlst;
       for (Long i = 0; i < Nnodes; i++) { // Set nbr-list // TODO: optimize this
         node_mid[i].NbrList(nlst, node_mid[i].Depth(), periodic);
         for (Long k = 0; k < nlst.Dim(); k++) {
@@ -434,7 +441,7 @@ namespace sctl {
       }
     }
     if (0) { // Check tree
-      Morton<DIM> m0;
+      MID m0;
       SCTL_ASSERT(node_mid.Dim() && m0 == node_mid[0]);
       for (Long i = 1; i < node_mid.Dim(); i++) {
         const auto& m = node_mid[i];
@@ -442,14 +449,14 @@ namespace sctl {
         else m0 = m0.Next();
         SCTL_ASSERT(m0 == m);
       }
-      SCTL_ASSERT(m0.Next() == Morton<DIM>().Next());
+      SCTL_ASSERT(m0.Next() == MID().Next());
     }
 
     { // Update node_data, node_cnt
       Long start_idx, end_idx;
       { // Set start_idx, end_idx
         start_idx = std::lower_bound(node_mid.begin(), node_mid.end(), mins[rank]) - node_mid.begin();
-        end_idx = std::lower_bound(node_mid.begin(), node_mid.end(), (rank+1==np ? Morton<DIM>().Next() : mins[rank+1])) - node_mid.begin();
+        end_idx = std::lower_bound(node_mid.begin(), node_mid.end(), (rank+1==np ? MID().Next() : mins[rank+1])) - node_mid.begin();
       }
 
       comm.PartitionS(node_mid_orig, mins[comm.Rank()]);
@@ -462,7 +469,7 @@ namespace sctl {
         }
         for (Long i = start_idx; i < end_idx; i++) {
           auto m0 = (node_mid[i+0]);
-          auto m1 = (i+1==end_idx ? Morton<DIM>().Next() : (node_mid[i+1]));
+          auto m1 = (i+1==end_idx ? MID().Next() : (node_mid[i+1]));
           new_cnt_range0[i] = std::lower_bound(node_mid_orig.begin(), node_mid_orig.begin() + node_mid_orig.Dim(), m0) - node_mid_orig.begin();
           new_cnt_range1[i] = std::lower_bound(node_mid_orig.begin(), node_mid_orig.begin() + node_mid_orig.Dim(), m1) - node_mid_orig.begin();
         }
@@ -516,7 +523,136 @@ namespace sctl {
     }
   }
 
-  template <Integer DIM> template <class ValueType> void Tree<DIM>::AddData(const std::string& name, const Vector<ValueType>& data, const Vector<Long>& cnt) {
+  template <Integer DIM, class MID> template <class Real> bool Tree<DIM,MID>::LocalRefinement(const Vector<Real>& coord, Long M) {
+    const Integer np = comm.Size();
+    const Integer rank = comm.Rank();
+    SCTL_ASSERT(M > 0);
+
+    Vector<MID> pt_mid;
+    { // Construct sorted pt_mid (send the points outside [mid_begin, mid_end) to their owner)
+      const Long Npt = coord.Dim() / DIM;
+      Vector<MID> pt_mid_(Npt);
+      for (Long i = 0; i < Npt; i++) {
+        pt_mid_[i] = MID(coord.begin() + i*DIM);
+      }
+      omp_par::merge_sort(pt_mid_.begin(), pt_mid_.end());
+
+      Vector<Long> send_cnt(np), send_dsp(np), recv_cnt(np), recv_dsp(np);
+      for (Integer p = 0; p < np; p++) {
+        const Long start = (p      ? std::lower_bound(pt_mid_.begin(), pt_mid_.end(), mins[p  ]) - pt_mid_.begin() : 0);
+        const Long end   = (p+1<np ? std::lower_bound(pt_mid_.begin(), pt_mid_.end(), mins[p+1]) - pt_mid_.begin() : Npt);
+        send_dsp[p] = start;
+        send_cnt[p] = end - start;
+      }
+      const Long Nkeep = send_cnt[rank];
+      send_cnt[rank] = 0;
+      comm.Alltoall(send_cnt.begin(), 1, recv_cnt.begin(), 1);
+      scan(recv_dsp, recv_cnt);
+
+      const Long Nrecv = recv_dsp[np-1] + recv_cnt[np-1];
+      pt_mid.ReInit(Nkeep + Nrecv);
+      memcopy(pt_mid.begin(), pt_mid_.begin() + send_dsp[rank], Nkeep);
+      if (np > 1) {
+        void* req = comm.Ialltoallv_sparse(pt_mid_.begin(), send_cnt.begin(), send_dsp.begin(), pt_mid.begin() + Nkeep, recv_cnt.begin(), recv_dsp.begin());
+        comm.Wait(req);
+      }
+      if (Nrecv) omp_par::merge_sort(pt_mid.begin(), pt_mid.end());
+    }
+    { // Check the load balance of the partition
+      StaticArray<Long,2> Nl, Nmax, Nsum;
+      Nl[0] = pt_mid.Dim();
+      Nl[1] = -pt_mid.Dim();
+      comm.Allreduce((ConstIterator<Long>)Nl, (Iterator<Long>)Nmax, 2, CommOp::MAX);
+      comm.Allreduce((ConstIterator<Long>)Nl, (Iterator<Long>)Nsum, 1, CommOp::SUM);
+      if (Nmax[1] >= 0 || Nmax[0] * np > Nsum[0] * 3 / 2) return false;
+    }
+    LocalLinearTree(node_mid, pt_mid, M);
+    return true;
+  }
+
+  template <Integer DIM, class MID> void Tree<DIM,MID>::LocalLinearTree(Vector<MID>& mid_lst, const Vector<MID>& pt_mid, Long M) const {
+    const Integer np = comm.Size();
+    const Integer rank = comm.Rank();
+    const MID mid_begin = mins[rank];
+    const MID mid_end = (rank+1<np ? mins[rank+1] : MID().Next());
+
+    mid_lst.ReInit(0);
+    Long idx = 0;
+    MID m0 = mid_begin;
+    while (m0 < mid_end) {
+      Integer d = m0.Depth();
+      MID m1 = (idx + M < pt_mid.Dim() ? pt_mid[idx+M] : MID().Next());
+      while (d < MID::MAX_DEPTH && (m0.Ancestor(d) == m1.Ancestor(d) || (rank+1<np && m0.Ancestor(d).isAncestor(mid_end)))) { // more than M points or overlaps the next partition
+        mid_lst.PushBack(m0.Ancestor(d));
+        d++;
+      }
+      m0 = m0.Ancestor(d);
+      mid_lst.PushBack(m0);
+      m0 = m0.Next();
+      idx = std::lower_bound(pt_mid.begin(), pt_mid.end(), m0) - pt_mid.begin();
+    }
+  }
+
+  template <Integer DIM, class MID> bool Tree<DIM,MID>::Repartition(const Vector<Long>& wts, bool periodic, Integer halo_size, double threshold, double time) {
+    const Integer np = comm.Size();
+    const Integer rank = comm.Rank();
+    SCTL_ASSERT(wts.Dim() == node_mid.Dim());
+    if (np == 1) return false;
+
+    const Long start_idx_orig = std::lower_bound(node_mid.begin(), node_mid.end(), mins[rank]) - node_mid.begin();
+    const Long end_idx_orig = std::lower_bound(node_mid.begin(), node_mid.end(), (rank+1==np ? MID().Next() : mins[rank+1])) - node_mid.begin();
+
+    Vector<MID> leaf_mid;
+    Vector<Long> leaf_wts;
+    for (Long i = start_idx_orig; i < end_idx_orig; i++) {
+      if (!node_attr[i].Leaf) continue;
+      leaf_mid.PushBack(node_mid[i]);
+      leaf_wts.PushBack(std::max<Long>(wts[i], 1));
+    }
+    { // Calibrate the weights with the measured time, and check the load balance
+      Long Wl = omp_par::reduce(leaf_wts.begin(), leaf_wts.Dim());
+      StaticArray<double,3> Nl, Ng;
+      Nl[0] = (double)Wl;
+      Nl[1] = time;
+      Nl[2] = (time > 0 ? 0 : 1);
+      comm.Allreduce((ConstIterator<double>)Nl, (Iterator<double>)Ng, 3, CommOp::SUM);
+      if (Ng[2] == 0 && Wl > 0) { // the weight of each process is proportional to its measured time
+        const double scal = (time / Ng[1]) / (Wl / Ng[0]);
+        for (auto& w : leaf_wts) w = std::max<Long>((Long)(w * scal + 0.5), 1);
+        Wl = omp_par::reduce(leaf_wts.begin(), leaf_wts.Dim());
+      }
+
+      StaticArray<Long,1> Wmax, Wsum;
+      comm.Allreduce(Ptr2ConstItr<Long>(&Wl,1), (Iterator<Long>)Wmax, 1, CommOp::MAX);
+      comm.Allreduce(Ptr2ConstItr<Long>(&Wl,1), (Iterator<Long>)Wsum, 1, CommOp::SUM);
+      if (Wmax[0] * np <= threshold * Wsum[0]) return false;
+    }
+    comm.PartitionW(leaf_mid, &leaf_wts);
+    { // Check that no process is left without leaves
+      StaticArray<Long,1> Nl{leaf_mid.Dim()}, Ng;
+      comm.Allreduce((ConstIterator<Long>)Nl, (Iterator<Long>)Ng, 1, CommOp::MIN);
+      if (!Ng[0]) return false;
+    }
+
+    bcast_plan.clear();
+    reduce_plan.clear();
+    Vector<MID> node_mid_orig(end_idx_orig - start_idx_orig, node_mid.begin() + start_idx_orig, true);
+    { // Set mins (coarsest ancestor of the first leaf of each process)
+      const MID m0 = leaf_mid[0];
+      MID md;
+      for (Integer d = 0; d <= m0.Depth(); d++) {
+        md = m0.Ancestor(d);
+        if (md.Ancestor(m0.Depth()) == m0) break;
+      }
+      if (!rank) md = MID();
+      comm.Allgather(Ptr2ConstItr<MID>(&md,1), 1, mins.begin(), 1);
+    }
+    LocalLinearTree(node_mid, leaf_mid, 1); // the same leaves as before
+    FinishRefinement(node_mid_orig, start_idx_orig, end_idx_orig, false, periodic, halo_size);
+    return true;
+  }
+
+  template <Integer DIM, class MID> template <class ValueType> void Tree<DIM,MID>::AddData(const std::string& name, const Vector<ValueType>& data, const Vector<Long>& cnt) {
     Long dof;
     { // Check dof
       StaticArray<Long,2> Nl, Ng;
@@ -532,9 +668,11 @@ namespace sctl {
     SCTL_ASSERT(node_data.find(name) == node_data.end());
     node_data[name].ReInit(data.Dim()*sizeof(ValueType), (Iterator<char>)data.begin(), true);
     node_cnt [name] = cnt;
+    bcast_plan.erase(name);
+    reduce_plan.erase(name);
   }
 
-  template <Integer DIM> template <class ValueType> void Tree<DIM>::GetData(Vector<ValueType>& data, Vector<Long>& cnt, const std::string& name) const {
+  template <Integer DIM, class MID> template <class ValueType> void Tree<DIM,MID>::GetData(Vector<ValueType>& data, Vector<Long>& cnt, const std::string& name) const {
     const auto data_ = node_data.find(name);
     const auto cnt_ = node_cnt.find(name);
     SCTL_ASSERT(data_ != node_data.end());
@@ -544,7 +682,7 @@ namespace sctl {
     cnt .ReInit( cnt_->second.Dim(), (Iterator<Long>)cnt_->second.begin(), false);
   }
 
-  template <Integer DIM> template <class ValueType> void Tree<DIM>::ReduceBroadcast(const std::string& name) {
+  template <Integer DIM, class MID> template <class ValueType> void Tree<DIM,MID>::ReduceBroadcast(const std::string& name) {
     Integer np = comm.Size();
     Integer rank = comm.Rank();
 
@@ -557,101 +695,63 @@ namespace sctl {
     scan(dsp, cnt);
 
     Long dof;
-    { // Set dof
-      StaticArray<Long,2> Nl, Ng;
+    bool plan_valid;
+    { // Set dof, plan_valid
+      StaticArray<Long,3> Nl, Ng;
       Nl[0] = data.Dim();
       Nl[1] = omp_par::reduce(cnt.begin(), cnt.Dim());
-      comm.Allreduce((ConstIterator<Long>)Nl, (Iterator<Long>)Ng, 2, CommOp::SUM);
+      Nl[2] = !CheckCommPlan(reduce_plan, name, cnt);
+      comm.Allreduce((ConstIterator<Long>)Nl, (Iterator<Long>)Ng, 3, CommOp::SUM);
       dof = Ng[0] / std::max<Long>(Ng[1],1);
       SCTL_ASSERT(Nl[0] == Nl[1] * dof);
       SCTL_ASSERT(Ng[0] == Ng[1] * dof);
+      plan_valid = (!Ng[2] && reduce_plan[name].dof == dof);
     }
 
     { // Reduce
-      Vector<Morton<DIM>> send_mid, recv_mid;
-      Vector<Long> send_node_cnt(np), send_node_dsp(np);
-      Vector<Long> recv_node_cnt(np), recv_node_dsp(np);
-      { // Set send_mid, send_node_cnt, send_node_dsp, recv_mid, recv_node_cnt, recv_node_dsp
+      CommPlan& plan = reduce_plan[name];
+      if (!plan_valid) { // Setup plan
+        Vector<MID> send_mid;
+        Vector<Long> send_node_cnt(np);
         { // Set send_mid
-          Morton<DIM> m0 = mins[rank];
+          MID m0 = mins[rank];
           for (Integer d = 0; d < m0.Depth(); d++) {
             send_mid.PushBack(m0.Ancestor(d));
           }
         }
         for (Integer p = 0; p < np; p++) {
           Long start_idx = std::lower_bound(send_mid.begin(), send_mid.end(), mins[p]) - send_mid.begin();
-          Long end_idx = std::lower_bound(send_mid.begin(), send_mid.end(), (p+1==np ? Morton<DIM>().Next() : mins[p+1])) - send_mid.begin();
+          Long end_idx = std::lower_bound(send_mid.begin(), send_mid.end(), (p+1==np ? MID().Next() : mins[p+1])) - send_mid.begin();
           send_node_cnt[p] = end_idx - start_idx;
         }
-        scan(send_node_dsp, send_node_cnt);
-        SCTL_ASSERT(send_node_dsp[np-1]+send_node_cnt[np-1] == send_mid.Dim());
-        comm.Alltoall(send_node_cnt.begin(), 1, recv_node_cnt.begin(), 1);
-        scan(recv_node_dsp, recv_node_cnt);
-
-        recv_mid.ReInit(recv_node_dsp[np-1] + recv_node_cnt[np-1]);
-        comm.Alltoallv(send_mid.begin(), send_node_cnt.begin(), send_node_dsp.begin(), recv_mid.begin(), recv_node_cnt.begin(), recv_node_dsp.begin());
-      }
-
-      Vector<Long> send_data_cnt, send_data_dsp;
-      Vector<Long> recv_data_cnt, recv_data_dsp;
-      { // Set send_data_cnt, send_data_dsp
-        send_data_cnt.ReInit(send_mid.Dim());
-        recv_data_cnt.ReInit(recv_mid.Dim());
-        for (Long i = 0; i < send_mid.Dim(); i++) {
-          Long idx = std::lower_bound(node_mid.begin(), node_mid.end(), send_mid[i]) - node_mid.begin();
-          SCTL_ASSERT(send_mid[i] == node_mid[idx]);
-          send_data_cnt[i] = cnt[idx];
-        }
-        scan(send_data_dsp, send_data_cnt);
-        comm.Alltoallv(send_data_cnt.begin(), send_node_cnt.begin(), send_node_dsp.begin(), recv_data_cnt.begin(), recv_node_cnt.begin(), recv_node_dsp.begin());
-        scan(recv_data_dsp, recv_data_cnt);
+        SetupCommPlan(plan, send_mid, send_node_cnt, cnt, dof);
       }
 
       Vector<ValueType> send_buff, recv_buff;
-      Vector<Long> send_buff_cnt(np), send_buff_dsp(np);
-      Vector<Long> recv_buff_cnt(np), recv_buff_dsp(np);
-      { // Set send_buff, send_buff_cnt, send_buff_dsp, recv_buff, recv_buff_cnt, recv_buff_dsp
-        Long N_send_nodes = send_mid.Dim();
-        Long N_recv_nodes = recv_mid.Dim();
-        if (N_send_nodes) send_buff.ReInit((send_data_dsp[N_send_nodes-1] + send_data_cnt[N_send_nodes-1]) * dof);
-        if (N_recv_nodes) recv_buff.ReInit((recv_data_dsp[N_recv_nodes-1] + recv_data_cnt[N_recv_nodes-1]) * dof);
-        for (Long i = 0; i < N_send_nodes; i++) {
-          Long idx = std::lower_bound(node_mid.begin(), node_mid.end(), send_mid[i]) - node_mid.begin();
-          SCTL_ASSERT(send_mid[i] == node_mid[idx]);
+      { // Set send_buff, recv_buff
+        send_buff.ReInit(plan.send_buff_dsp[np-1] + plan.send_buff_cnt[np-1]);
+        recv_buff.ReInit(plan.recv_buff_dsp[np-1] + plan.recv_buff_cnt[np-1]);
+        for (Long i = 0; i < plan.send_node_idx.Dim(); i++) {
+          const Long idx = plan.send_node_idx[i];
           Long dsp_ = dsp[idx] * dof;
           Long cnt_ = cnt[idx] * dof;
-          Long send_data_dsp_ = send_data_dsp[i] * dof;
-          Long send_data_cnt_ = send_data_cnt[i] * dof;
-          SCTL_ASSERT(send_data_cnt_ == cnt_);
+          Long send_data_dsp_ = plan.send_data_dsp[i] * dof;
           for (Long j = 0; j < cnt_; j++) {
             send_buff[send_data_dsp_+j] = data[dsp_+j];
           }
         }
-        for (Integer p = 0; p < np; p++) {
-          Long send_buff_cnt_ = 0;
-          Long recv_buff_cnt_ = 0;
-          for (Long i = 0; i < send_node_cnt[p]; i++) {
-            send_buff_cnt_ += send_data_cnt[send_node_dsp[p]+i];
-          }
-          for (Long i = 0; i < recv_node_cnt[p]; i++) {
-            recv_buff_cnt_ += recv_data_cnt[recv_node_dsp[p]+i];
-          }
-          send_buff_cnt[p] = send_buff_cnt_ * dof;
-          recv_buff_cnt[p] = recv_buff_cnt_ * dof;
-        }
-        scan(send_buff_dsp, send_buff_cnt);
-        scan(recv_buff_dsp, recv_buff_cnt);
-        comm.Alltoallv(send_buff.begin(), send_buff_cnt.begin(), send_buff_dsp.begin(), recv_buff.begin(), recv_buff_cnt.begin(), recv_buff_dsp.begin());
+        void* req = comm.Ialltoallv_sparse(send_buff.begin(), plan.send_buff_cnt.begin(), plan.send_buff_dsp.begin(), recv_buff.begin(), plan.recv_buff_cnt.begin(), plan.recv_buff_dsp.begin());
+        comm.Wait(req);
       }
 
       { // Reduction
-        Long N_recv_nodes = recv_mid.Dim();
+        Long N_recv_nodes = plan.recv_node_idx.Dim();
         for (Long i = 0; i < N_recv_nodes; i++) {
-          Long idx = std::lower_bound(node_mid.begin(), node_mid.end(), recv_mid[i]) - node_mid.begin();
+          Long idx = plan.recv_node_idx[i];
           Long dsp_ = dsp[idx] * dof;
           Long cnt_ = cnt[idx] * dof;
-          Long recv_data_dsp_ = recv_data_dsp[i] * dof;
-          Long recv_data_cnt_ = recv_data_cnt[i] * dof;
+          Long recv_data_dsp_ = plan.recv_data_dsp[i] * dof;
+          Long recv_data_cnt_ = plan.recv_data_cnt[i] * dof;
           SCTL_ASSERT(recv_data_cnt_ == cnt_ || recv_data_cnt_ == 0);
           if (recv_data_cnt_ == cnt_) {
             for (Long j = 0; j < cnt_; j++) {
@@ -665,7 +765,7 @@ namespace sctl {
     Broadcast<ValueType>(name);
   }
 
-  template <Integer DIM> template <class ValueType> void Tree<DIM>::Broadcast(const std::string& name) {
+  template <Integer DIM, class MID> template <class ValueType> void Tree<DIM,MID>::Broadcast(const std::string& name) {
     Integer np = comm.Size();
     Integer rank = comm.Rank();
 
@@ -678,99 +778,57 @@ namespace sctl {
     scan(dsp, cnt);
 
     Long dof;
-    { // Set dof
-      StaticArray<Long,2> Nl, Ng;
+    bool plan_valid;
+    { // Set dof, plan_valid
+      StaticArray<Long,3> Nl, Ng;
       Nl[0] = data.Dim();
       Nl[1] = omp_par::reduce(cnt.begin(), cnt.Dim());
-      comm.Allreduce((ConstIterator<Long>)Nl, (Iterator<Long>)Ng, 2, CommOp::SUM);
+      Nl[2] = !CheckCommPlan(bcast_plan, name, cnt);
+      comm.Allreduce((ConstIterator<Long>)Nl, (Iterator<Long>)Ng, 3, CommOp::SUM);
       dof = Ng[0] / std::max<Long>(Ng[1],1);
       SCTL_ASSERT(Nl[0] == Nl[1] * dof);
       SCTL_ASSERT(Ng[0] == Ng[1] * dof);
+      plan_valid = (!Ng[2] && bcast_plan[name].dof == dof);
     }
 
     { // Broadcast
-      const Vector<Morton<DIM>>& send_mid = user_mid;
-      const Vector<Long>& send_node_cnt = user_cnt;
-      Vector<Long> send_node_dsp(np);
-      { // Set send_dsp
-        SCTL_ASSERT(send_node_cnt.Dim() == np);
-        scan(send_node_dsp, send_node_cnt);
-        SCTL_ASSERT(send_node_dsp[np-1] + send_node_cnt[np-1] == send_mid.Dim());
-      }
-
-      Vector<Morton<DIM>> recv_mid;
-      Vector<Long> recv_node_cnt(np), recv_node_dsp(np);
-      { // Set recv_mid, recv_node_cnt, recv_node_dsp
-        comm.Alltoall(send_node_cnt.begin(), 1, recv_node_cnt.begin(), 1);
-        scan(recv_node_dsp, recv_node_cnt);
-
-        recv_mid.ReInit(recv_node_dsp[np-1] + recv_node_cnt[np-1]);
-        comm.Alltoallv(send_mid.begin(), send_node_cnt.begin(), send_node_dsp.begin(), recv_mid.begin(), recv_node_cnt.begin(), recv_node_dsp.begin());
-      }
-
-      Vector<Long> send_data_cnt, send_data_dsp;
-      Vector<Long> recv_data_cnt, recv_data_dsp;
-      { // Set send_data_cnt, send_data_dsp
-        send_data_cnt.ReInit(send_mid.Dim());
-        recv_data_cnt.ReInit(recv_mid.Dim());
-        for (Long i = 0; i < send_mid.Dim(); i++) {
-          Long idx = std::lower_bound(node_mid.begin(), node_mid.end(), send_mid[i]) - node_mid.begin();
-          SCTL_ASSERT(send_mid[i] == node_mid[idx]);
-          send_data_cnt[i] = cnt[idx];
-        }
-        scan(send_data_dsp, send_data_cnt);
-        comm.Alltoallv(send_data_cnt.begin(), send_node_cnt.begin(), send_node_dsp.begin(), recv_data_cnt.begin(), recv_node_cnt.begin(), recv_node_dsp.begin());
-        scan(recv_data_dsp, recv_data_cnt);
+      CommPlan& plan = bcast_plan[name];
+      if (!plan_valid) { // Setup plan
+        SCTL_ASSERT(user_cnt.Dim() == np);
+        SetupCommPlan(plan, user_mid, user_cnt, cnt, dof);
       }
 
       Vector<ValueType> send_buff, recv_buff;
-      Vector<Long> send_buff_cnt(np), send_buff_dsp(np);
-      Vector<Long> recv_buff_cnt(np), recv_buff_dsp(np);
-      { // Set send_buff, send_buff_cnt, send_buff_dsp, recv_buff, recv_buff_cnt, recv_buff_dsp
-        Long N_send_nodes = send_mid.Dim();
-        Long N_recv_nodes = recv_mid.Dim();
-        if (N_send_nodes) send_buff.ReInit((send_data_dsp[N_send_nodes-1] + send_data_cnt[N_send_nodes-1]) * dof);
-        if (N_recv_nodes) recv_buff.ReInit((recv_data_dsp[N_recv_nodes-1] + recv_data_cnt[N_recv_nodes-1]) * dof);
-        for (Long i = 0; i < N_send_nodes; i++) {
-          Long idx = std::lower_bound(node_mid.begin(), node_mid.end(), send_mid[i]) - node_mid.begin();
-          SCTL_ASSERT(send_mid[i] == node_mid[idx]);
+      { // Set send_buff, recv_buff
+        send_buff.ReInit(plan.send_buff_dsp[np-1] + plan.send_buff_cnt[np-1]);
+        recv_buff.ReInit(plan.recv_buff_dsp[np-1] + plan.recv_buff_cnt[np-1]);
+        for (Long i = 0; i < plan.send_node_idx.Dim(); i++) {
+          const Long idx = plan.send_node_idx[i];
           Long dsp_ = dsp[idx] * dof;
           Long cnt_ = cnt[idx] * dof;
-          Long send_data_dsp_ = send_data_dsp[i] * dof;
-          Long send_data_cnt_ = send_data_cnt[i] * dof;
-          SCTL_ASSERT(send_data_cnt_ == cnt_);
+          Long send_data_dsp_ = plan.send_data_dsp[i] * dof;
           for (Long j = 0; j < cnt_; j++) {
             send_buff[send_data_dsp_+j] = data[dsp_+j];
           }
         }
-        for (Integer p = 0; p < np; p++) {
-          Long send_buff_cnt_ = 0;
-          Long recv_buff_cnt_ = 0;
-          for (Long i = 0; i < send_node_cnt[p]; i++) {
-            send_buff_cnt_ += send_data_cnt[send_node_dsp[p]+i];
-          }
-          for (Long i = 0; i < recv_node_cnt[p]; i++) {
-            recv_buff_cnt_ += recv_data_cnt[recv_node_dsp[p]+i];
-          }
-          send_buff_cnt[p] = send_buff_cnt_ * dof;
-          recv_buff_cnt[p] = recv_buff_cnt_ * dof;
-        }
-        scan(send_buff_dsp, send_buff_cnt);
-        scan(recv_buff_dsp, recv_buff_cnt);
-        comm.Alltoallv(send_buff.begin(), send_buff_cnt.begin(), send_buff_dsp.begin(), recv_buff.begin(), recv_buff_cnt.begin(), recv_buff_dsp.begin());
+        void* req = comm.Ialltoallv_sparse(send_buff.begin(), plan.send_buff_cnt.begin(), plan.send_buff_dsp.begin(), recv_buff.begin(), plan.recv_buff_cnt.begin(), plan.recv_buff_dsp.begin());
+        comm.Wait(req);
       }
 
       Long start_idx, end_idx;
       { // Set start_idx, end_idx
         start_idx = std::lower_bound(node_mid.begin(), node_mid.end(), mins[rank]) - node_mid.begin();
-        end_idx = std::lower_bound(node_mid.begin(), node_mid.end(), (rank+1==np ? Morton<DIM>().Next() : mins[rank+1])) - node_mid.begin();
+        end_idx = std::lower_bound(node_mid.begin(), node_mid.end(), (rank+1==np ? MID().Next() : mins[rank+1])) - node_mid.begin();
         SCTL_ASSERT(0 <= start_idx);
         SCTL_ASSERT(start_idx < end_idx);
         SCTL_ASSERT(end_idx <= node_mid.Dim());
       }
 
       { // Update data <-- data + recv_buff
-        Long Nsplit = std::lower_bound(recv_mid.begin(), recv_mid.end(), mins[rank]) - recv_mid.begin();
+        const Vector<Long>& recv_node_idx = plan.recv_node_idx;
+        const Vector<Long>& recv_data_cnt = plan.recv_data_cnt;
+        const Vector<Long>& recv_data_dsp = plan.recv_data_dsp;
+        Long Nsplit = std::lower_bound(recv_node_idx.begin(), recv_node_idx.end(), start_idx) - recv_node_idx.begin();
 
         Long N0 = (start_idx ? dsp[start_idx-1] + cnt[start_idx-1] : 0) * dof;
         Long N1 = (end_idx ? dsp[end_idx-1] + cnt[end_idx-1] : 0) * dof;
@@ -784,10 +842,8 @@ namespace sctl {
 
         for (Long i = 0; i < start_idx; i++) cnt[i] = 0;
         for (Long i = end_idx; i < cnt.Dim(); i++) cnt[i] = 0;
-        for (Long i = 0; i < recv_mid.Dim(); i++) {
-          const auto idx = std::lower_bound(node_mid.begin(), node_mid.end(), recv_mid[i]) - node_mid.begin();
-          SCTL_ASSERT(node_mid[idx] == recv_mid[i]);
-          cnt[idx] = recv_data_cnt[i];
+        for (Long i = 0; i < recv_node_idx.Dim(); i++) {
+          cnt[recv_node_idx[i]] = recv_data_cnt[i];
         }
 
         memcopy(data.begin(), recv_buff.begin(), Ns);
@@ -796,14 +852,91 @@ namespace sctl {
     }
   }
 
-  template <Integer DIM> void Tree<DIM>::DeleteData(const std::string& name) {
+  template <Integer DIM, class MID> void Tree<DIM,MID>::SetupCommPlan(CommPlan& plan, const Vector<MID>& send_mid, const Vector<Long>& send_node_cnt, const Vector<Long>& cnt, Long dof) const {
+    Integer np = comm.Size();
+    plan.dof = dof;
+
+    Vector<Long> send_node_dsp(np);
+    scan(send_node_dsp, send_node_cnt);
+    SCTL_ASSERT(send_node_dsp[np-1] + send_node_cnt[np-1] == send_mid.Dim());
+
+    Vector<MID> recv_mid;
+    Vector<Long> recv_node_cnt(np), recv_node_dsp(np);
+    { // Set recv_mid, recv_node_cnt, recv_node_dsp
+      comm.Alltoall(send_node_cnt.begin(), 1, recv_node_cnt.begin(), 1);
+      scan(recv_node_dsp, recv_node_cnt);
+
+      recv_mid.ReInit(recv_node_dsp[np-1] + recv_node_cnt[np-1]);
+      comm.Alltoallv(send_mid.begin(), send_node_cnt.begin(), send_node_dsp.begin(), recv_mid.begin(), recv_node_cnt.begin(), recv_node_dsp.begin());
+    }
+
+    { // Set send_node_idx, recv_node_idx
+      plan.send_node_idx.ReInit(send_mid.Dim());
+      plan.recv_node_idx.ReInit(recv_mid.Dim());
+      for (Long i = 0; i < send_mid.Dim(); i++) {
+        Long idx = std::lower_bound(node_mid.begin(), node_mid.end(), send_mid[i]) - node_mid.begin();
+        SCTL_ASSERT(send_mid[i] == node_mid[idx]);
+        plan.send_node_idx[i] = idx;
+      }
+      for (Long i = 0; i < recv_mid.Dim(); i++) {
+        Long idx = std::lower_bound(node_mid.begin(), node_mid.end(), recv_mid[i]) - node_mid.begin();
+        SCTL_ASSERT(idx < node_mid.Dim() && node_mid[idx] == recv_mid[i]);
+        plan.recv_node_idx[i] = idx;
+      }
+    }
+
+    { // Set send_data_cnt, send_data_dsp, recv_data_cnt, recv_data_dsp
+      plan.send_data_cnt.ReInit(send_mid.Dim());
+      plan.recv_data_cnt.ReInit(recv_mid.Dim());
+      for (Long i = 0; i < send_mid.Dim(); i++) {
+        plan.send_data_cnt[i] = cnt[plan.send_node_idx[i]];
+      }
+      scan(plan.send_data_dsp, plan.send_data_cnt);
+      comm.Alltoallv(plan.send_data_cnt.begin(), send_node_cnt.begin(), send_node_dsp.begin(), plan.recv_data_cnt.begin(), recv_node_cnt.begin(), recv_node_dsp.begin());
+      scan(plan.recv_data_dsp, plan.recv_data_cnt);
+    }
+
+    { // Set send_buff_cnt, send_buff_dsp, recv_buff_cnt, recv_buff_dsp
+      plan.send_buff_cnt.ReInit(np);
+      plan.recv_buff_cnt.ReInit(np);
+      for (Integer p = 0; p < np; p++) {
+        Long send_buff_cnt_ = 0;
+        Long recv_buff_cnt_ = 0;
+        for (Long i = 0; i < send_node_cnt[p]; i++) {
+          send_buff_cnt_ += plan.send_data_cnt[send_node_dsp[p]+i];
+        }
+        for (Long i = 0; i < recv_node_cnt[p]; i++) {
+          recv_buff_cnt_ += plan.recv_data_cnt[recv_node_dsp[p]+i];
+        }
+        plan.send_buff_cnt[p] = send_buff_cnt_ * dof;
+        plan.recv_buff_cnt[p] = recv_buff_cnt_ * dof;
+      }
+      scan(plan.send_buff_dsp, plan.send_buff_cnt);
+      scan(plan.recv_buff_dsp, plan.recv_buff_cnt);
+    }
+  }
+
+  template <Integer DIM, class MID> bool Tree<DIM,MID>::CheckCommPlan(const std::map<std::string, CommPlan>& plan_map, const std::string& name, const Vector<Long>& cnt) {
+    const auto it = plan_map.find(name);
+    if (it == plan_map.end()) return false;
+    const CommPlan& plan = it->second;
+    for (Long i = 0; i < plan.send_node_idx.Dim(); i++) {
+      const Long idx = plan.send_node_idx[i];
+      if (idx >= cnt.Dim() || cnt[idx] != plan.send_data_cnt[i]) return false;
+    }
+    return true;
+  }
+
+  template <Integer DIM, class MID> void Tree<DIM,MID>::DeleteData(const std::string& name) {
     SCTL_ASSERT(node_data.find(name) != node_data.end());
     SCTL_ASSERT(node_cnt .find(name) != node_cnt .end());
     node_data.erase(name);
     node_cnt .erase(name);
+    bcast_plan.erase(name);
+    reduce_plan.erase(name);
   }
 
-  template <Integer DIM> void Tree<DIM>::WriteTreeVTK(std::string fname, bool show_ghost) const {
+  template <Integer DIM, class MID> void Tree<DIM,MID>::WriteTreeVTK(std::string fname, bool show_ghost) const {
     typedef typename VTUData::VTKReal VTKReal;
     VTUData vtu_data;
     if (DIM <= 3) {  // Set vtu data
@@ -820,7 +953,7 @@ namespace sctl {
       Long point_cnt = coord.Dim() / 3;
       Long connect_cnt = connect.Dim();
       for (Long nid = 0; nid < node_mid.Dim(); nid++) {
-        const Morton<DIM> &mid = node_mid[nid];
+        const MID &mid = node_mid[nid];
         const NodeAttr &attr = node_attr[nid];
         if (!show_ghost && attr.Ghost) continue;
         if (!attr.Leaf) continue;
@@ -846,7 +979,61 @@ namespace sctl {
     vtu_data.WriteVTK(fname, comm);
   }
 
-  template <Integer DIM> void Tree<DIM>::GetData_(Iterator<Vector<char>>& data, Iterator<Vector<Long>>& cnt, const std::string& name) {
+  template <Integer DIM, class MID> template <class ValueType> void Tree<DIM,MID>::GetDataView(DataView<ValueType>& view, const std::string& name) const {
+    GetData(view.data, view.cnt, name);
+    scan(view.dsp, view.cnt);
+
+    const Long Nn = view.cnt.Dim();
+    const Long N = (Nn ? view.dsp[Nn-1] + view.cnt[Nn-1] : 0);
+    view.dof = (N ? view.data.Dim() / N : 0);
+    SCTL_ASSERT(view.data.Dim() == N * view.dof);
+    if (view.dof != 1) {
+      #pragma omp parallel for schedule(static)
+      for (Long i = 0; i < Nn; i++) view.dsp[i] *= view.dof;
+    }
+  }
+  template <Integer DIM, class MID> template <class ValueType> void Tree<DIM,MID>::InterleaveData(const std::string& name, const Vector<std::string>& fields) {
+    const Long Nf = fields.Dim();
+    if (!Nf) return;
+
+    Vector<Vector<ValueType>> data(Nf);
+    Vector<Long> cnt, dsp, dof(Nf);
+    { // Set data, cnt, dof
+      Vector<Long> cnt_;
+      Vector<Long> Nl(2*Nf), Ng(2*Nf);
+      for (Long k = 0; k < Nf; k++) {
+        GetData(data[k], cnt_, fields[k]);
+        if (!k) cnt = cnt_;
+        SCTL_ASSERT(cnt_.Dim() == cnt.Dim());
+        for (Long i = 0; i < cnt.Dim(); i++) SCTL_ASSERT(cnt_[i] == cnt[i]);
+        Nl[2*k+0] = data[k].Dim();
+        Nl[2*k+1] = omp_par::reduce(cnt.begin(), cnt.Dim());
+      }
+      comm.Allreduce((ConstIterator<Long>)Nl.begin(), Ng.begin(), 2*Nf, CommOp::SUM);
+      for (Long k = 0; k < Nf; k++) dof[k] = Ng[2*k+0] / std::max<Long>(Ng[2*k+1],1);
+      scan(dsp, cnt);
+    }
+
+    const Long Nn = cnt.Dim();
+    const Long N = (Nn ? dsp[Nn-1] + cnt[Nn-1] : 0);
+    const Long dof_sum = omp_par::reduce(dof.begin(), Nf);
+    Vector<ValueType> data_(N * dof_sum);
+    #pragma omp parallel for schedule(static)
+    for (Long i = 0; i < Nn; i++) {
+      for (Long j = dsp[i]; j < dsp[i] + cnt[i]; j++) {
+        Long offset = j * dof_sum;
+        for (Long k = 0; k < Nf; k++) {
+          for (Long l = 0; l < dof[k]; l++) data_[offset+l] = data[k][j*dof[k]+l];
+          offset += dof[k];
+        }
+      }
+    }
+
+    data.ReInit(0);
+    for (Long k = 0; k < Nf; k++) DeleteData(fields[k]);
+    AddData(name, data_, cnt);
+  }
+  template <Integer DIM, class MID> void Tree<DIM,MID>::GetData_(Iterator<Vector<char>>& data, Iterator<Vector<Long>>& cnt, const std::string& name) {
     auto data_ = node_data.find(name);
     const auto cnt_ = node_cnt.find(name);
     SCTL_ASSERT(data_ != node_data.end());
@@ -855,7 +1042,7 @@ namespace sctl {
     cnt  = Ptr2Itr<Vector<Long>>(& cnt_->second,1);
   }
 
-  template <Integer DIM> void Tree<DIM>::scan(Vector<Long>& dsp, const Vector<Long>& cnt) {
+  template <Integer DIM, class MID> void Tree<DIM,MID>::scan(Vector<Long>& dsp, const Vector<Long>& cnt) {
     dsp.ReInit(cnt.Dim());
     if (cnt.Dim()) dsp[0] = 0;
     omp_par::scan(cnt.begin(), dsp.begin(), cnt.Dim());
@@ -876,9 +1063,78 @@ namespace sctl {
     #endif
   }
 
-  template <class Real, Integer DIM, class BaseTree> void PtTree<Real,DIM,BaseTree>::UpdateRefinement(const Vector<Real>& coord, Long M, bool balance21, bool periodic, Integer halo_size) {
+  template <class Real, Integer DIM, class BaseTree> void PtTree<Real,DIM,BaseTree>::UpdateRefinement(const Vector<Real>& coord, Long M, bool balance21, bool periodic, Integer halo_size, bool incremental) {
+    BaseTree::UpdateRefinement(coord, M, balance21, periodic, halo_size, incremental);
+    RepartitionParticles();
+  }
+
+  template <class Real, Integer DIM, class BaseTree> bool PtTree<Real,DIM,BaseTree>::Repartition(const Vector<Long>& wts, bool periodic, Integer halo_size, double threshold, double time) {
+    if (!BaseTree::Repartition(wts, periodic, halo_size, threshold, time)) return false;
+    RepartitionParticles();
+    return true;
+  }
+
+  template <class Real, Integer DIM, class BaseTree> void PtTree<Real,DIM,BaseTree>::LeafWeights(Vector<Long>& wts, const std::string& particle_name, Long pair_cost, Long pt_cost, bool periodic) {
+    const auto& node_mid = this->GetNodeMID();
+    const auto& node_attr = this->GetNodeAttr();
+    const auto& node_lst = this->GetNodeLists();
+    const Long Nnodes = node_mid.Dim();
+    SCTL_ASSERT(Nlocal.find(particle_name) != Nlocal.end());
+
+    Vector<Long> pt_cnt;
+    { // Set pt_cnt, the number of particles in the subtree of each node (including ghost nodes)
+      Vector<Real> X;
+      Vector<Long> cnt, node_cnt(Nnodes);
+      this->GetData(X, cnt, particle_name);
+      pt_cnt.ReInit(Nnodes);
+      for (Long i = 0; i < Nnodes; i++) {
+        pt_cnt[i] = (node_attr[i].Ghost ? 0 : cnt[i]);
+        node_cnt[i] = 1;
+      }
+      for (Long i = Nnodes-1; i > 0; i--) {
+        const Long p = node_lst[i].parent;
+        if (p >= 0) pt_cnt[p] += pt_cnt[i];
+      }
+      this->AddData("pt_tree_cnt", pt_cnt, node_cnt);
+      this->template ReduceBroadcast<Long>("pt_tree_cnt");
+      this->GetData(cnt, node_cnt, "pt_tree_cnt");
+      SCTL_ASSERT(node_cnt.Dim() == Nnodes);
+      for (Long i = 0, offset = 0; i < Nnodes; i++) { // ghost nodes outside the halo have no data
+        pt_cnt[i] = (node_cnt[i] ? cnt[offset] : 0);
+        offset += node_cnt[i];
+      }
+      this->DeleteData("pt_tree_cnt");
+    }
+
+    wts.ReInit(Nnodes);
+    #pragma omp parallel
+    {
+      Vector<MID> nlst;
+      Vector<Long> near_lst;
+      #pragma omp for schedule(static)
+      for (Long i = 0; i < Nnodes; i++) {
+        wts[i] = 0;
+        if (!node_attr[i].Leaf || node_attr[i].Ghost) continue;
+
+        // the neighbors at the same level (with their subtrees) or the coarser leaves containing them
+        near_lst.ReInit(0);
+        node_mid[i].NbrList(nlst, node_mid[i].Depth(), periodic);
+        for (const auto& m : nlst) {
+          if (m.Depth() < 0) continue;
+          const Long j = std::upper_bound(node_mid.begin(), node_mid.end(), m) - node_mid.begin() - 1;
+          if (j < 0 || !(node_mid[j] == m || (node_attr[j].Leaf && node_mid[j].isAncestor(m)))) continue;
+          if (std::find(near_lst.begin(), near_lst.end(), j) == near_lst.end()) near_lst.PushBack(j);
+        }
+
+        Long near_cnt = 0;
+        for (const Long j : near_lst) near_cnt += pt_cnt[j];
+        wts[i] = pt_cnt[i] * (pair_cost * near_cnt + pt_cost);
+      }
+    }
+  }
+
+  template <class Real, Integer DIM, class BaseTree> void PtTree<Real,DIM,BaseTree>::RepartitionParticles() {
     const auto& comm = this->GetComm();
-    BaseTree::UpdateRefinement(coord, M, balance21, periodic, halo_size);
 
     Long start_node_idx, end_node_idx;
     { // Set start_node_idx, end_node_idx
@@ -887,7 +1143,7 @@ namespace sctl {
       Integer np = comm.Size();
       Integer rank = comm.Rank();
       start_node_idx = std::lower_bound(node_mid.begin(), node_mid.end(), mins[rank]) - node_mid.begin();
-      end_node_idx = std::lower_bound(node_mid.begin(), node_mid.end(), (rank+1==np ? Morton<DIM>().Next() : mins[rank+1])) - node_mid.begin();
+      end_node_idx = std::lower_bound(node_mid.begin(), node_mid.end(), (rank+1==np ? MID().Next() : mins[rank+1])) - node_mid.begin();
     }
 
     const auto& mins = this->GetPartitionMID();
@@ -902,7 +1158,7 @@ namespace sctl {
       Vector<Long> pt_cnt(node_mid.Dim());
       for (Long i = 0; i < node_mid.Dim(); i++) { // Set pt_cnt
         Long start = std::lower_bound(pt_mid_.begin(), pt_mid_.end(), node_mid[i]) - pt_mid_.begin();
-        Long end = std::lower_bound(pt_mid_.begin(), pt_mid_.end(), (i+1==node_mid.Dim() ? Morton<DIM>().Next() : node_mid[i+1])) - pt_mid_.begin();
+        Long end = std::lower_bound(pt_mid_.begin(), pt_mid_.end(), (i+1==node_mid.Dim() ? MID().Next() : node_mid[i+1])) - pt_mid_.begin();
         if (i == 0) SCTL_ASSERT(start == 0);
         if (i+1 == node_mid.Dim()) SCTL_ASSERT(end == pt_mid_.Dim());
         pt_cnt[i] = end - start;
@@ -956,10 +1212,10 @@ namespace sctl {
     SCTL_ASSERT(coord.Dim() == N * DIM);
     Nlocal[name] = N;
 
-    Vector<Morton<DIM>>& pt_mid_ = pt_mid[name];
+    Vector<MID>& pt_mid_ = pt_mid[name];
     if (pt_mid_.Dim() != N) pt_mid_.ReInit(N);
     for (Long i = 0; i < N; i++) {
-      pt_mid_[i] = Morton<DIM>(coord.begin() + i*DIM);
+      pt_mid_[i] = MID(coord.begin() + i*DIM);
     }
     comm.SortScatterIndex(pt_mid_, scatter_idx_, &mins[comm.Rank()]);
     comm.ScatterForward(pt_mid_, scatter_idx_);
@@ -972,7 +1228,7 @@ namespace sctl {
       cnt_[0].ReInit(node_mid.Dim());
       for (Long i = 0; i < node_mid.Dim(); i++) {
         Long start = std::lower_bound(pt_mid_.begin(), pt_mid_.end(), node_mid[i]) - pt_mid_.begin();
-        Long end = std::lower_bound(pt_mid_.begin(), pt_mid_.end(), (i+1==node_mid.Dim() ? Morton<DIM>().Next() : node_mid[i+1])) - pt_mid_.begin();
+        Long end = std::lower_bound(pt_mid_.begin(), pt_mid_.end(), (i+1==node_mid.Dim() ? MID().Next() : node_mid[i+1])) - pt_mid_.begin();
         if (i == 0) SCTL_ASSERT(start == 0);
         if (i+1 == node_mid.Dim()) SCTL_ASSERT(end == pt_mid_.Dim());
         cnt_[0][i] = end - start;
@@ -1028,7 +1284,7 @@ namespace sctl {
     BaseTree::scan(dsp, cnt_);
     { // Set dof
       Long Nn = node_mid.Dim();
-      StaticArray<Long,2> Ng, Nl = {data_.Dim(), dsp[Nn-1]+cnt_[Nn-1]};
+      StaticArray<Long,2> Ng, Nl{data_.Dim(), dsp[Nn-1]+cnt_[Nn-1]};
       comm.Allreduce((ConstIterator<Long>)Nl, (Iterator<Long>)Ng, 2, CommOp::SUM);
       dof = Ng[0] / std::max<Long>(Ng[1],1);
     }
@@ -1036,7 +1292,7 @@ namespace sctl {
       Integer np = comm.Size();
       Integer rank = comm.Rank();
       Long N0 = std::lower_bound(node_mid.begin(), node_mid.end(), mins[rank]) - node_mid.begin();
-      Long N1 = std::lower_bound(node_mid.begin(), node_mid.end(), (rank==np-1 ? Morton<DIM>().Next() : mins[rank+1])) - node_mid.begin();
+      Long N1 = std::lower_bound(node_mid.begin(), node_mid.end(), (rank==np-1 ? MID().Next() : mins[rank+1])) - node_mid.begin();
       Long start = dsp[N0] * dof;
       Long end = (N1 ? (dsp[N1-1]+cnt_[N1-1])*dof : start);
       data.ReInit(end-start, data_.begin()+start, true);
@@ -1045,6 +1301,21 @@ namespace sctl {
     }
   }
 
+  template <class Real, Integer DIM, class BaseTree> void PtTree<Real,DIM,BaseTree>::InterleaveParticleData(const std::string& data_name, const Vector<std::string>& fields) {
+    if (!fields.Dim()) return;
+    SCTL_ASSERT(data_pt_name.find(fields[0]) != data_pt_name.end());
+    const std::string particle_name = data_pt_name[fields[0]];
+    for (const auto& field : fields) {
+      SCTL_ASSERT(data_pt_name.find(field) != data_pt_name.end());
+      SCTL_ASSERT(data_pt_name[field] == particle_name);
+      SCTL_ASSERT(field != particle_name);
+    }
+    SCTL_ASSERT(data_pt_name.find(data_name) == data_pt_name.end() || data_pt_name[data_name] == particle_name);
+
+    this->template InterleaveData<Real>(data_name, fields);
+    for (const auto& field : fields) data_pt_name.erase(field);
+    data_pt_name[data_name] = particle_name;
+  }
   template <class Real, Integer DIM, class BaseTree> void PtTree<Real,DIM,BaseTree>::DeleteParticleData(const std::string& data_name) {
     SCTL_ASSERT(data_pt_name.find(data_name) != data_pt_name.end());
     auto particle_name = data_pt_name[data_name];
@@ -1061,6 +1332,8 @@ namespace sctl {
         }
       }
       Nlocal.erase(particle_name);
+      pt_mid.erase(particle_name);
+      scatter_idx.erase(particle_name);
     }
     this->DeleteData(data_name);
     data_pt_name.erase(data_name);
@@ -1083,7 +1356,7 @@ namespace sctl {
       Long value_dof = 0;
       { // Set pt_coord, pt_cnt, pt_dsp
         this->GetData(pt_coord, pt_cnt, particle_name);
-        Tree<DIM>::scan(pt_dsp, pt_cnt);
+        BaseTree::scan(pt_dsp, pt_cnt);
       }
       if (particle_name != data_name) { // Set pt_value, value_dof
         Vector<Long> pt_cnt;
@@ -56,7 +56,7 @@ namespace sctl {
       }
 
       static void test_all() {
-        if (N*sizeof(ScalarType)*8<=512) {
+        if (N*sizeof(ScalarType)*8<=(SCTL_ALIGN_BYTES*8>512 ? SCTL_ALIGN_BYTES*8 : 512)) {
           test_align();
           test_init();
           test_bitwise(); // TODO: fails for 'long double'
@@ -68,7 +68,7 @@ namespace sctl {
       }
 
       static void test_reals() {
-        if (N*sizeof(ScalarType)*8<=512) {
+        if (N*sizeof(ScalarType)*8<=(SCTL_ALIGN_BYTES*8>512 ? SCTL_ALIGN_BYTES*8 : 512)) {
           test_reals_convert(); // TODO: fails for 'long double'
           test_reals_specialfunc();
           test_reals_rsqrt();
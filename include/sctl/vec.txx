@@ -24,7 +24,13 @@ namespace sctl {
 
 
   template <class ScalarType> constexpr Integer DefaultVecLen() {
-    #if defined(__AVX512__) || defined(__AVX512F__)
+    #if defined(SCTL_SVE_BITS)
+    static_assert(SCTL_ALIGN_BYTES >= SCTL_SVE_BITS/8, "Insufficient memory alignment for SIMD vector types");
+    return SCTL_SVE_BITS/8/sizeof(ScalarType);
+    #elif defined(SCTL_RVV_BITS)
+    static_assert(SCTL_ALIGN_BYTES >= SCTL_RVV_BITS/8, "Insufficient memory alignment for SIMD vector types");
+    return SCTL_RVV_BITS/8/sizeof(ScalarType);
+    #elif defined(__AVX512__) || defined(__AVX512F__)
     static_assert(SCTL_ALIGN_BYTES >= 64, "Insufficient memory alignment for SIMD vector types");
     return 64/sizeof(ScalarType);
     #elif defined(__AVX__)
@@ -12,6 +12,7 @@ namespace sctl {
 
 // forward declaration
 template <class ValueType> Iterator<ValueType> NullIterator();
+class MemoryArena;
 
 /**
  * A contiguous array of elements. The elements can be accesses with a non-negative index.  The vector can be the
@@ -44,6 +45,16 @@ template <class ValueType> class Vector {
    */
   explicit Vector(Long dim, Iterator<ValueType> data = NullIterator<ValueType>(), bool own_data = true);
 
+  /**
+   * Constructor with memory allocated from a MemoryArena. Subsequent
+   * reallocations (ReInit, PushBack) also use the arena, therefore the vector
+   * must not be used after the enclosing MemoryArena::Scope ends.
+   *
+   * @param dim Dimension of the vector.
+   * @param arena MemoryArena to allocate from.
+   */
+  Vector(Long dim, MemoryArena& arena);
+
   /**
    * Copy constructor.
    *
@@ -362,13 +373,15 @@ template <class ValueType> class Vector {
    * @param dim Dimension of the vector.
    * @param data Pointer to the data.
    * @param own_data Flag indicating ownership of data.
+   * @param arena MemoryArena to allocate from (nullptr for the global MemoryManager).
    */
-  void Init(Long dim, Iterator<ValueType> data = NullIterator<ValueType>(), bool own_data = true);
+  void Init(Long dim, Iterator<ValueType> data = NullIterator<ValueType>(), bool own_data = true, MemoryArena* arena = nullptr);
 
   Long dim; /**< Dimension of the vector. */
   Long capacity; /**< Capacity of the vector. */
   Iterator<ValueType> data_ptr; /**< Pointer to the data. */
   bool own_data; /**< Flag indicating ownership of the data. */
+  MemoryArena* arena; /**< MemoryArena used for allocations (or nullptr). */
 };
 
 // Function template declarations for vector-scalar operations...
@@ -15,6 +15,7 @@
 #include "sctl/vector.hpp"        // for Vector, operator*, operator+, opera...
 #include "sctl/iterator.hpp"      // for Iterator, ConstIterator
 #include "sctl/iterator.txx"      // for NullIterator, memcopy, Ptr2Itr, Ptr...
+#include "sctl/mapped_file.txx"   // for mapped_file_detail::WriteHeader, ReadHeader
 #include "sctl/mem_mgr.txx"       // for aligned_delete, aligned_new
 #include "sctl/profile.hpp"       // for Profile, ProfileCounter
 #include "sctl/profile.txx"       // for Profile::IncrementCounter
@@ -23,15 +24,18 @@
 
 namespace sctl {
 
-template <class ValueType> void Vector<ValueType>::Init(Long dim_, Iterator<ValueType> data_, bool own_data_) {
+template <class ValueType> void Vector<ValueType>::Init(Long dim_, Iterator<ValueType> data_, bool own_data_, MemoryArena* arena_) {
   dim = dim_;
   capacity = dim;
   own_data = own_data_;
+  arena = arena_;
   if (own_data) {
     if (dim > 0) {
-      data_ptr = aligned_new<ValueType>(capacity);
+      data_ptr = (arena ? aligned_new<ValueType>(capacity, *arena) : aligned_new<ValueType>(capacity));
       if (data_ != NullIterator<ValueType>()) {
         memcopy(data_ptr, data_, dim);
+      } else if (!arena) {
+        first_touch(data_ptr, dim);
       }
     } else
       data_ptr = NullIterator<ValueType>();
@@ -47,6 +51,10 @@ template <class ValueType> Vector<ValueType>::Vector(Long dim_, Iterator<ValueTy
   Init(dim_, data_, own_data_);
 }
 
+template <class ValueType> Vector<ValueType>::Vector(Long dim_, MemoryArena& arena_) {
+  Init(dim_, NullIterator<ValueType>(), true, &arena_);
+}
+
 template <class ValueType> Vector<ValueType>::Vector(const Vector<ValueType>& V) {
   Init(V.Dim(), (Iterator<ValueType>)V.begin());
 }
@@ -75,21 +83,25 @@ template <class ValueType> void Vector<ValueType>::Swap(Vector<ValueType>& v1) {
   Long capacity_ = capacity;
   Iterator<ValueType> data_ptr_ = data_ptr;
   bool own_data_ = own_data;
+  MemoryArena* arena_ = arena;
 
   dim = v1.dim;
   capacity = v1.capacity;
   data_ptr = v1.data_ptr;
   own_data = v1.own_data;
+  arena = v1.arena;
 
   v1.dim = dim_;
   v1.capacity = capacity_;
   v1.data_ptr = data_ptr_;
   v1.own_data = own_data_;
+  v1.arena = arena_;
 }
 
 template <class ValueType> void Vector<ValueType>::ReInit(Long dim_, Iterator<ValueType> data_, bool own_data_) {
 #ifdef SCTL_MEMDEBUG
-  Vector<ValueType> tmp(dim_, data_, own_data_);
+  Vector<ValueType> tmp;
+  tmp.Init(dim_, data_, own_data_, arena);
   this->Swap(tmp);
 #else
   if (own_data_ && own_data && dim_ <= capacity) {
@@ -98,7 +110,8 @@ template <class ValueType> void Vector<ValueType>::ReInit(Long dim_, Iterator<Va
       memcopy(data_ptr, data_, dim);
     }
   } else {
-    Vector<ValueType> tmp(dim_, data_, own_data_);
+    Vector<ValueType> tmp;
+    tmp.Init(dim_, data_, own_data_, arena);
     this->Swap(tmp);
   }
 #endif
@@ -110,11 +123,8 @@ template <class ValueType> void Vector<ValueType>::Write(const char* fname) cons
     std::cout << "Unable to open file for writing: " << fname << '\n';
     return;
   }
-  StaticArray<uint64_t, 2> dim_;
-  dim_[0] = (uint64_t)Dim();
-  dim_[1] = 1;
-  fwrite(&dim_[0], sizeof(uint64_t), 2, f1);
-  if (dim_[0] && dim_[1]) fwrite(&data_ptr[0], sizeof(ValueType), dim_[0] * dim_[1], f1);
+  mapped_file_detail::WriteHeader<ValueType>(f1, Dim(), 1);
+  if (Dim()) fwrite(&data_ptr[0], sizeof(ValueType), Dim(), f1);
   fclose(f1);
 }
 
@@ -127,24 +137,23 @@ template <class ValueType> template <class Type> void Vector<ValueType>::Write(c
 }
 
 template <class ValueType> void Vector<ValueType>::Read(const char* fname) {
-  FILE* f1 = fopen(fname, "r");
+  FILE* f1 = fopen(fname, "rb");
   if (f1 == nullptr) {
     std::cout << "Unable to open file for reading: " << fname << '\n';
     return;
   }
-  StaticArray<uint64_t, 2> dim_;
-  Long readlen = fread(&dim_[0], sizeof(uint64_t), 2, f1);
-  if(readlen != 2) {
-    std::cout << "Reading file failed: " << fname << '\n';
+  StaticArray<Long, 2> dim_;
+  Long data_offset;
+  if (!mapped_file_detail::ReadHeader<ValueType>(f1, dim_, data_offset, fname)) {
     ReInit(0);
     fclose(f1);
     return;
   }
 
-  if (Dim() != (Long)(dim_[0] * dim_[1])) ReInit(dim_[0] * dim_[1]);
+  if (Dim() != dim_[0] * dim_[1]) ReInit(dim_[0] * dim_[1]);
   if (dim_[0] && dim_[1]) {
-    readlen = fread(&data_ptr[0], sizeof(ValueType), dim_[0] * dim_[1], f1);
-    if (readlen != (Long)(dim_[0] * dim_[1])) {
+    Long readlen = fread(&data_ptr[0], sizeof(ValueType), dim_[0] * dim_[1], f1);
+    if (readlen != dim_[0] * dim_[1]) {
       std::cout << "Reading file failed: " << fname << '\n';
       ReInit(0);
     }
@@ -187,7 +196,8 @@ template <class ValueType> void Vector<ValueType>::PushBack(const ValueType& x)
 //#ifdef SCTL_MEMDEBUG
 //    Vector<ValueType> v((Long)capacity + 1); // TODO: this is slow but required to catch memory errors
 //#else
-    Vector<ValueType> v((Long)(capacity * 1.6) + 1);
+    Vector<ValueType> v;
+    v.Init((Long)(capacity * 1.6) + 1, NullIterator<ValueType>(), true, arena);
 //#endif
     memcopy(v.data_ptr, data_ptr, dim);
     v.dim = dim;
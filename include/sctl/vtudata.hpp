@@ -44,6 +44,29 @@ class VTUData {
      */
     void WriteVTK(const std::string& fname, const Comm& comm = Comm::Self()) const;
 
+    /**
+     * Write the VTU data from all processes to a single file (fname.vtu) using collective MPI-IO, instead of one file
+     * per process and a .pvtu index as in WriteVTK. The data of all processes is written as a single piece in raw
+     * appended format, optionally with zlib block compression (requires SCTL_HAVE_ZLIB). Building with
+     * SCTL_VTU_SINGLE_FILE makes WriteVTK (and therefore Tree::WriteTreeVTK) use this format.
+     *
+     * @param fname File name for the output file (without the extension).
+     * @param comm MPI communicator.
+     * @param compress Compress the data arrays (ignored without SCTL_HAVE_ZLIB).
+     * @param async If true, return as soon as the data has been prepared and write it in the background; the write
+     * is completed by WaitVTU().
+     *
+     * @note This is a collective operation and must be called from all processes in the communicator.
+     */
+    void WriteVTU(const std::string& fname, const Comm& comm = Comm::Self(), bool compress = true, bool async = false) const;
+
+    /**
+     * Wait for all writes started by WriteVTU with async=true to complete.
+     *
+     * @note This is a collective operation over the communicators of the pending writes.
+     */
+    static void WaitVTU();
+
     /**
      * Example code showing how to use the VTUData class.
      */
@@ -2,11 +2,19 @@
 #define _SCTL_VTUDATA_TXX_
 
 #include <stdlib.h>               // for drand48
+#include <algorithm>              // for min
 #include <cstdint>                // for int32_t, uint32_t, uint8_t, uint16_t
 #include <fstream>                // for basic_ofstream, basic_ostream, oper...
 #include <iomanip>                // for operator<<, setfill, setw
 #include <sstream>                // for basic_stringstream
 #include <string>                 // for char_traits, allocator, basic_string
+#include <memory>                 // for unique_ptr
+#include <thread>                 // for thread
+#include <utility>                // for move, swap
+#include <vector>                 // for vector
+#ifdef SCTL_HAVE_ZLIB
+#include <zlib.h>                 // for compress2, compressBound
+#endif
 
 #include "sctl/common.hpp"        // for Integer, Long, SCTL_ASSERT, SCTL_NA...
 #include "sctl/vtudata.hpp"       // for VTUData
@@ -46,9 +54,16 @@ inline void VTUData::test() {
   vtu_data.offset.PushBack(vtu_data.connect.Dim());
 
   vtu_data.WriteVTK("vtudata-test");
+
+  // Write a single file for all processes, in the background
+  vtu_data.WriteVTU("vtudata-test-single", Comm::World(), true, true);
+  VTUData::WaitVTU();
 }
 
 inline void VTUData::WriteVTK(const std::string& fname, const Comm& comm) const {
+#ifdef SCTL_VTU_SINGLE_FILE
+  WriteVTU(fname, comm);
+#else
   typedef typename VTUData::VTKReal VTKReal;
   Long value_dof = 0;
   {  // Write vtu file.
@@ -201,8 +216,319 @@ inline void VTUData::WriteVTK(const std::string& fname, const Comm& comm) const
     }
     pvtufile.close();  // close file
   }
+#endif
 };
 
+namespace vtu_detail {
+
+  static constexpr Long BLOCK_SIZE = 65536;  // uncompressed size of the compressed blocks (in bytes)
+
+  /**
+   * Copy count elements from ptr to buff[offset:] (as bytes) and return the offset after them. The buffer must be
+   * large enough.
+   */
+  template <class T> inline Long CopyBytes(Vector<char>& buff, Long offset, ConstIterator<T> ptr, Long count) {
+    const Long bytes = count * (Long)sizeof(T);
+    SCTL_ASSERT(offset + bytes <= buff.Dim());
+    if (bytes) memcopy(buff.begin() + offset, Ptr2ConstItr<char>((const char*)&ptr[0], bytes), bytes);
+    return offset + bytes;
+  }
+
+  /**
+   * Set buff to the bytes of the vector v.
+   */
+  template <class T> inline void ToBytes(Vector<char>& buff, const Vector<T>& v) {
+    buff.ReInit(v.Dim() * (Long)sizeof(T));
+    CopyBytes<T>(buff, 0, v.begin(), v.Dim());
+  }
+
+  /**
+   * Encode a distributed data array for the appended data section of a VTU file (with header_type="UInt64").
+   *
+   * @param[out] buff local part of the encoded array.
+   * @param[out] buff_offset offset of the local part in the encoded array.
+   * @param[in] data_ local part of the data array (in bytes).
+   * @return total size of the encoded array.
+   */
+  inline Long EncodeArray(Vector<char>& buff, Long& buff_offset, const Vector<char>& data_, bool compress, const Comm& comm) {
+    const Integer rank = comm.Rank();
+    StaticArray<Long,2> N{data_.Dim(), 0}, dsp{data_.Dim(), 0};
+    comm.Allreduce(N+0, N+1, 1, CommOp::SUM);
+    comm.Scan(dsp+0, dsp+1, 1, CommOp::SUM);
+
+    if (!compress) { // [size][data]
+      const uint64_t header = (uint64_t)N[1];
+      buff.ReInit((rank ? 0 : (Long)sizeof(uint64_t)) + data_.Dim());
+      const Long offset = (rank ? 0 : CopyBytes<uint64_t>(buff, 0, Ptr2ConstItr<uint64_t>(&header, 1), 1));
+      CopyBytes<char>(buff, offset, data_.begin(), data_.Dim());
+      buff_offset = (rank ? (Long)sizeof(uint64_t) + dsp[1] - dsp[0] : 0);
+      return (Long)sizeof(uint64_t) + N[1];
+    }
+
+#ifdef SCTL_HAVE_ZLIB
+    // Repartition the data so that each process has whole blocks.
+    const Integer np = comm.Size();
+    const Long Nblocks = (N[1] + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const Long blk0 = Nblocks * rank / np, blk1 = Nblocks * (rank+1) / np;
+    Vector<char> data_part;
+    if (np > 1) { // (a copy is only needed in parallel)
+      data_part = data_;
+      comm.PartitionN(data_part, std::min(blk1 * BLOCK_SIZE, N[1]) - std::min(blk0 * BLOCK_SIZE, N[1]));
+    }
+    const Vector<char>& data = (np > 1 ? data_part : data_);
+
+    // Compress the blocks: [Nblocks][BLOCK_SIZE][size of last block][compressed size of each block][compressed blocks]
+    const Long Nblk = blk1 - blk0;
+    Vector<Vector<char>> cdata(Nblk);
+    Vector<Long> csize(Nblk);
+    #pragma omp parallel for schedule(dynamic)
+    for (Long i = 0; i < Nblk; i++) {
+      const Long size = std::min(BLOCK_SIZE, data.Dim() - i * BLOCK_SIZE);
+      uLongf csize_ = compressBound((uLong)size);
+      cdata[i].ReInit((Long)csize_);
+      SCTL_ASSERT(compress2((Bytef*)&cdata[i][0], &csize_, (const Bytef*)&data[i * BLOCK_SIZE], (uLong)size, Z_BEST_SPEED) == Z_OK);
+      csize[i] = (Long)csize_;
+    }
+
+    Vector<Long> cnt(np), dsp_(np), csize_glb(Nblocks);
+    for (Integer i = 0; i < np; i++) {
+      cnt[i] = Nblocks * (i+1) / np - Nblocks * i / np;
+      dsp_[i] = Nblocks * i / np;
+    }
+    comm.Allgatherv(csize.begin(), Nblk, csize_glb.begin(), cnt.begin(), dsp_.begin());
+
+    const Long header_size = (3 + Nblocks) * (Long)sizeof(uint64_t);
+    Long total_size = header_size;
+    buff_offset = header_size;
+    for (Long i = 0; i < Nblocks; i++) {
+      if (i < blk0) buff_offset += csize_glb[i];
+      total_size += csize_glb[i];
+    }
+    Long buff_size = (rank ? 0 : header_size);
+    for (Long i = 0; i < Nblk; i++) buff_size += csize[i];
+    buff.ReInit(buff_size);
+    Long offset = 0;
+    if (!rank) {
+      Vector<uint64_t> header(3 + Nblocks);
+      header[0] = (uint64_t)Nblocks;
+      header[1] = (uint64_t)BLOCK_SIZE;
+      header[2] = (uint64_t)(Nblocks ? N[1] - (Nblocks - 1) * BLOCK_SIZE : 0);
+      for (Long i = 0; i < Nblocks; i++) header[3+i] = (uint64_t)csize_glb[i];
+      offset = CopyBytes<uint64_t>(buff, offset, header.begin(), header.Dim());
+      buff_offset = 0;
+    }
+    for (Long i = 0; i < Nblk; i++) offset = CopyBytes<char>(buff, offset, cdata[i].begin(), csize[i]);
+    return total_size;
+#else
+    SCTL_ASSERT_MSG(false, "Compression requires SCTL_HAVE_ZLIB");
+    return 0;
+#endif
+  }
+
+  /**
+   * A write started by VTUData::WriteVTU with async=true.
+   */
+  struct PendingWrite {
+#ifndef SCTL_HAVE_MPI
+    ~PendingWrite() { // a pending write not completed by WaitVTU is joined here (e.g. at exit)
+      if (thread.joinable()) thread.join();
+    }
+#endif
+
+    Vector<char> buff;  // data to be written (must be kept until the write completes)
+#ifdef SCTL_HAVE_MPI
+    MPI_File file;
+    MPI_Datatype filetype;
+    MPI_Request request;
+#else
+    std::thread thread;
+#endif
+  };
+
+  inline std::vector<std::unique_ptr<PendingWrite>>& PendingWrites() {
+    static std::vector<std::unique_ptr<PendingWrite>> pending;
+    return pending;
+  }
+
+  /**
+   * Write the blocks (offset[i], size[i]) concatenated in buff to the file.
+   */
+  inline void WriteBlocks(const std::string& fname, const Vector<Long>& offset, const Vector<Long>& size, Vector<char>&& buff, bool async, const Comm& comm) {
+    std::unique_ptr<PendingWrite> w(new PendingWrite);
+    w->buff.Swap(buff);
+#ifdef SCTL_HAVE_MPI
+    MPI_File_open(comm.GetMPI_Comm(), fname.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &w->file);
+    MPI_File_set_size(w->file, 0);
+
+    std::vector<int> blocklen;
+    std::vector<MPI_Aint> displ;
+    for (Long i = 0; i < offset.Dim(); i++) {
+      if (!size[i]) continue;
+      SCTL_ASSERT(size[i] <= comm_detail::MPIIntLimit());
+      blocklen.push_back((int)size[i]);
+      displ.push_back((MPI_Aint)offset[i]);
+    }
+    MPI_Type_create_hindexed((int)blocklen.size(), blocklen.data(), displ.data(), MPI_BYTE, &w->filetype);
+    MPI_Type_commit(&w->filetype);
+    MPI_File_set_view(w->file, 0, MPI_BYTE, w->filetype, "native", MPI_INFO_NULL);
+
+    SCTL_ASSERT(w->buff.Dim() <= comm_detail::MPIIntLimit());
+    char* ptr = (w->buff.Dim() ? &w->buff[0] : nullptr);
+    if (async) {
+      MPI_File_iwrite_all(w->file, ptr, (int)w->buff.Dim(), MPI_BYTE, &w->request);
+      #pragma omp critical(SCTL_VTU_PENDING)
+      PendingWrites().push_back(std::move(w));
+    } else {
+      MPI_File_write_all(w->file, ptr, (int)w->buff.Dim(), MPI_BYTE, MPI_STATUS_IGNORE);
+      MPI_Type_free(&w->filetype);
+      MPI_File_close(&w->file);
+    }
+#else
+    auto write = [fname,offset,size](const Vector<char>& buff) {
+      std::ofstream file(fname.c_str(), std::ios::binary | std::ios::trunc);
+      if (file.fail()) return;
+      Long dsp = 0;
+      for (Long i = 0; i < offset.Dim(); i++) {
+        file.seekp(offset[i]);
+        if (size[i]) file.write(&buff[dsp], size[i]);
+        dsp += size[i];
+      }
+    };
+    SCTL_UNUSED(comm);
+    if (async) {
+      PendingWrite& w_ = *w;
+      w->thread = std::thread([write,&w_]() { write(w_.buff); });
+      #pragma omp critical(SCTL_VTU_PENDING)
+      PendingWrites().push_back(std::move(w));
+    } else {
+      write(w->buff);
+    }
+#endif
+  }
+
+}
+
+inline void VTUData::WriteVTU(const std::string& fname, const Comm& comm, bool compress, bool async) const {
+  typedef typename VTUData::VTKReal VTKReal;
+#ifndef SCTL_HAVE_ZLIB
+  compress = false;
+#endif
+  const Integer rank = comm.Rank();
+  const Long pt_cnt = coord.Dim() / 3;
+  const Long cell_cnt = types.Dim();
+
+  StaticArray<Long,4> loc_cnt{pt_cnt, cell_cnt, value.Dim(), connect.Dim()}, glb_cnt, glb_dsp;
+  comm.Allreduce(loc_cnt+0, glb_cnt+0, 4, CommOp::SUM);
+  comm.Scan(loc_cnt+0, glb_dsp+0, 4, CommOp::SUM);
+  for (Integer i = 0; i < 4; i++) glb_dsp[i] -= loc_cnt[i];
+  const Long value_dof = (glb_cnt[0] ? glb_cnt[2] / glb_cnt[0] : 0);
+
+  Vector<Vector<char>> data_arrays;
+  { // Set data_arrays (the points and connectivity are numbered globally)
+    Vector<int32_t> mpi_rank(pt_cnt);
+    Vector<int64_t> connect_(connect.Dim()), offset_(offset.Dim());
+    for (Long i = 0; i < pt_cnt; i++) mpi_rank[i] = (int32_t)rank;
+    for (Long i = 0; i < connect.Dim(); i++) connect_[i] = connect[i] + glb_dsp[0];
+    for (Long i = 0; i < offset.Dim(); i++) offset_[i] = offset[i] + glb_dsp[3];
+
+    data_arrays.ReInit(value_dof ? 6 : 5);
+    Integer k = 0;
+    vtu_detail::ToBytes<VTKReal>(data_arrays[k++], coord);
+    if (value_dof) vtu_detail::ToBytes<VTKReal>(data_arrays[k++], value);
+    vtu_detail::ToBytes<int32_t>(data_arrays[k++], mpi_rank);
+    vtu_detail::ToBytes<int64_t>(data_arrays[k++], connect_);
+    vtu_detail::ToBytes<int64_t>(data_arrays[k++], offset_);
+    vtu_detail::ToBytes<uint8_t>(data_arrays[k++], types);
+  }
+
+  const Long Narrays = data_arrays.Dim();
+  Vector<Vector<char>> buff(Narrays);
+  Vector<Long> buff_offset(Narrays), array_offset(Narrays+1);
+  array_offset[0] = 0;
+  for (Long k = 0; k < Narrays; k++) {
+    array_offset[k+1] = array_offset[k] + vtu_detail::EncodeArray(buff[k], buff_offset[k], data_arrays[k], compress, comm);
+    data_arrays[k].ReInit(0);
+  }
+
+  std::string header, footer;
+  if (!rank) { // Set header, footer
+    bool isLittleEndian;
+    {  // Set isLittleEndian
+      uint16_t number = 0x1;
+      uint8_t *numPtr = (uint8_t *)&number;
+      isLittleEndian = (numPtr[0] == 1);
+    }
+
+    std::stringstream vtufile;
+    Integer k = 0;
+    vtufile << "<?xml version=\"1.0\"?>\n";
+    vtufile << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"" << (isLittleEndian ? "LittleEndian" : "BigEndian") << "\" header_type=\"UInt64\"" << (compress ? " compressor=\"vtkZLibDataCompressor\"" : "") << ">\n";
+    vtufile << "  <UnstructuredGrid>\n";
+    vtufile << "    <Piece NumberOfPoints=\"" << glb_cnt[0] << "\" NumberOfCells=\"" << glb_cnt[1] << "\">\n";
+    vtufile << "      <Points>\n";
+    vtufile << "        <DataArray type=\"Float" << sizeof(VTKReal) * 8 << "\" NumberOfComponents=\"3\" Name=\"Position\" format=\"appended\" offset=\"" << array_offset[k++] << "\" />\n";
+    vtufile << "      </Points>\n";
+    vtufile << "      <PointData>\n";
+    if (value_dof) vtufile << "        <DataArray type=\"Float" << sizeof(VTKReal) * 8 << "\" NumberOfComponents=\"" << value_dof << "\" Name=\"value\" format=\"appended\" offset=\"" << array_offset[k++] << "\" />\n";
+    vtufile << "        <DataArray type=\"Int32\" NumberOfComponents=\"1\" Name=\"mpi_rank\" format=\"appended\" offset=\"" << array_offset[k++] << "\" />\n";
+    vtufile << "      </PointData>\n";
+    vtufile << "      <Cells>\n";
+    vtufile << "        <DataArray type=\"Int64\" Name=\"connectivity\" format=\"appended\" offset=\"" << array_offset[k++] << "\" />\n";
+    vtufile << "        <DataArray type=\"Int64\" Name=\"offsets\" format=\"appended\" offset=\"" << array_offset[k++] << "\" />\n";
+    vtufile << "        <DataArray type=\"UInt8\" Name=\"types\" format=\"appended\" offset=\"" << array_offset[k++] << "\" />\n";
+    vtufile << "      </Cells>\n";
+    vtufile << "    </Piece>\n";
+    vtufile << "  </UnstructuredGrid>\n";
+    vtufile << "  <AppendedData encoding=\"raw\">\n";
+    vtufile << "    _";
+    header = vtufile.str();
+    footer = "\n  </AppendedData>\n</VTKFile>\n";
+  }
+  StaticArray<Long,2> header_size{(Long)header.size(), 0};
+  comm.Allreduce(header_size+0, header_size+1, 1, CommOp::SUM);
+
+  Vector<Long> block_offset, block_size;
+  if (!rank) {
+    block_offset.PushBack(0);
+    block_size.PushBack((Long)header.size());
+  }
+  for (Long k = 0; k < Narrays; k++) {
+    block_offset.PushBack(header_size[1] + array_offset[k] + buff_offset[k]);
+    block_size.PushBack(buff[k].Dim());
+  }
+  if (!rank) {
+    block_offset.PushBack(header_size[1] + array_offset[Narrays]);
+    block_size.PushBack((Long)footer.size());
+  }
+
+  Long block_data_size = 0, block_data_offset = 0;
+  for (Long i = 0; i < block_size.Dim(); i++) block_data_size += block_size[i];
+  Vector<char> block_data(block_data_size);
+  if (!rank) block_data_offset = vtu_detail::CopyBytes<char>(block_data, block_data_offset, Ptr2ConstItr<char>(header.c_str(), (Long)header.size()), (Long)header.size());
+  for (Long k = 0; k < Narrays; k++) {
+    block_data_offset = vtu_detail::CopyBytes<char>(block_data, block_data_offset, buff[k].begin(), buff[k].Dim());
+    buff[k].ReInit(0);
+  }
+  if (!rank) block_data_offset = vtu_detail::CopyBytes<char>(block_data, block_data_offset, Ptr2ConstItr<char>(footer.c_str(), (Long)footer.size()), (Long)footer.size());
+
+  vtu_detail::WriteBlocks(fname + ".vtu", block_offset, block_size, std::move(block_data), async, comm);
+}
+
+inline void VTUData::WaitVTU() {
+  std::vector<std::unique_ptr<vtu_detail::PendingWrite>> pending;
+  #pragma omp critical(SCTL_VTU_PENDING)
+  std::swap(pending, vtu_detail::PendingWrites());
+  for (auto& w : pending) {
+#ifdef SCTL_HAVE_MPI
+    MPI_Wait(&w->request, MPI_STATUS_IGNORE);
+    MPI_Type_free(&w->filetype);
+    MPI_File_close(&w->file);
+#else
+    w->thread.join();
+#endif
+  }
+}
+
 template <class ElemLst> inline void VTUData::AddElems(const ElemLst elem_lst, Integer order, const Comm& comm) {
   constexpr Integer COORD_DIM = ElemLst::CoordDim();
   constexpr Integer ElemDim = ElemLst::ElemDim();
@@ -0,0 +1,361 @@
+// Benchmark driver for the main computational kernels in SCTL.
+//
+// Usage: bench [output.json] [min-time-per-case (seconds)]
+//
+// Each case is repeated until at least min-time seconds have elapsed (after
+// one warm-up run), for each thread count 1, 2, 4, ..., omp_get_max_threads().
+// The results are written as a JSON array of records with the fields:
+//   name, threads, procs, size, reps, time (seconds per repetition),
+//   flop, gflops, bytes, gbytes_per_sec, flop_source
+// where flop is taken from ProfileCounter::FLOP when the kernel instruments it
+// (flop_source = "counter") and from an operation-count model otherwise
+// (flop_source = "model"). For communication cases, bytes is taken from
+// ProfileCounter::PROF_MPI_BYTES and PROF_MPI_COLLECTIVE_BYTES; for all other
+// cases it is a model of the compulsory memory traffic.
+
+#include "sctl.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace sctl;
+
+class BenchLog {
+  public:
+
+    BenchLog(const Comm& comm, double min_time) : comm_(comm), min_time_(min_time) {}
+
+    /**
+     * Time fn() and record the result.
+     *
+     * @param[in] flop_model operation count per call (used when the FLOP
+     * counter is not incremented by the kernel).
+     *
+     * @param[in] bytes_model bytes moved per call (used when the
+     * communication counters are not incremented).
+     */
+    template <class Fn> void Run(const std::string& name, const std::string& size, double flop_model, double bytes_model, Fn&& fn) {
+      fn(); // warm-up
+
+      const Long flop0 = Profile::IncrementCounter(ProfileCounter::FLOP, 0);
+      const Long bytes0 = Profile::IncrementCounter(ProfileCounter::PROF_MPI_BYTES, 0) + Profile::IncrementCounter(ProfileCounter::PROF_MPI_COLLECTIVE_BYTES, 0);
+      comm_.Barrier();
+      const double t0 = omp_get_wtime();
+      Long reps = 0;
+      while (true) {
+        fn();
+        reps++;
+        double tt = omp_get_wtime() - t0, tt_max;
+        comm_.Allreduce<double>(Ptr2ConstItr<double>(&tt,1), Ptr2Itr<double>(&tt_max,1), 1, CommOp::MAX);
+        if (tt_max >= min_time_) break;
+      }
+      double t = (omp_get_wtime() - t0) / reps;
+      const Long flop1 = Profile::IncrementCounter(ProfileCounter::FLOP, 0);
+      const Long bytes1 = Profile::IncrementCounter(ProfileCounter::PROF_MPI_BYTES, 0) + Profile::IncrementCounter(ProfileCounter::PROF_MPI_COLLECTIVE_BYTES, 0);
+
+      const bool flop_counter = (flop1 > flop0);
+      double flop = (flop_counter ? (double)(flop1 - flop0) / reps : flop_model);
+      double bytes = (bytes1 > bytes0 ? (double)(bytes1 - bytes0) / reps : bytes_model);
+      { // sum over processes, max of time
+        StaticArray<double,2> loc{flop, bytes}, glb;
+        comm_.Allreduce<double>(loc, glb, 2, CommOp::SUM);
+        flop = glb[0];
+        bytes = glb[1];
+        double t_max;
+        comm_.Allreduce<double>(Ptr2ConstItr<double>(&t,1), Ptr2Itr<double>(&t_max,1), 1, CommOp::MAX);
+        t = t_max;
+      }
+
+      const std::string sep = (record_.size() ? ",\n" : "");
+      char buff[1024];
+      snprintf(buff, sizeof(buff), "%s  {\"name\": \"%s\", \"threads\": %d, \"procs\": %d, \"size\": \"%s\", \"reps\": %ld, \"time\": %e, \"flop\": %e, \"gflops\": %f, \"bytes\": %e, \"gbytes_per_sec\": %f, \"flop_source\": \"%s\"}",
+          sep.c_str(), name.c_str(), (int)omp_get_max_threads(), (int)comm_.Size(), size.c_str(), (long)reps, t, flop, flop/t*1e-9, bytes, bytes/t*1e-9, (flop_counter ? "counter" : "model"));
+      record_ += buff;
+      if (!comm_.Rank()) {
+        std::printf("%-32s threads=%-3d size=%-20s time=%10.3e  GFLOP/s=%9.3f  GB/s=%9.3f\n", name.c_str(), (int)omp_get_max_threads(), size.c_str(), t, flop/t*1e-9, bytes/t*1e-9);
+        std::fflush(stdout);
+      }
+    }
+
+    void Write(const char* fname) const {
+      if (comm_.Rank()) return;
+      FILE* f = (fname ? std::fopen(fname, "w") : stdout);
+      SCTL_ASSERT_MSG(f, std::string("could not open file: ") + fname);
+      std::fprintf(f, "[\n%s\n]\n", record_.c_str());
+      if (fname) std::fclose(f);
+    }
+
+  private:
+
+    const Comm comm_;
+    const double min_time_;
+    std::string record_;
+};
+
+/**
+ * A simple element list for benchmarking BoundaryIntegralOp: the unit sphere
+ * split into Nt x Np patches in spherical coordinates, each discretized by
+ * q x q midpoint-rule nodes. The near and self interactions use the same
+ * (smooth) quadrature rule, so the operator is not accurate for on-surface
+ * targets, but the setup and evaluation exercise the same code paths.
+ */
+template <class Real> class SphereElemList : public ElementListBase<Real> {
+  public:
+
+    SphereElemList(Long Nt = 8, Long Np = 16, Long q = 4) : Nt_(Nt), Np_(Np), q_(q) {
+      const Long N = Nt_*Np_*q_*q_;
+      X_.ReInit(N*3);
+      Xn_.ReInit(N*3);
+      wts_.ReInit(N);
+      const Real dt = const_pi<Real>()/(Nt_*q_), dp = 2*const_pi<Real>()/(Np_*q_);
+      for (Long i = 0; i < Nt_; i++) {
+        for (Long j = 0; j < Np_; j++) {
+          for (Long k0 = 0; k0 < q_; k0++) {
+            for (Long k1 = 0; k1 < q_; k1++) {
+              const Long idx = ((i*Np_+j)*q_+k0)*q_+k1;
+              const Real t = (i*q_+k0+(Real)0.5)*dt, p = (j*q_+k1+(Real)0.5)*dp;
+              X_[idx*3+0] = Xn_[idx*3+0] = sin<Real>(t)*cos<Real>(p);
+              X_[idx*3+1] = Xn_[idx*3+1] = sin<Real>(t)*sin<Real>(p);
+              X_[idx*3+2] = Xn_[idx*3+2] = cos<Real>(t);
+              wts_[idx] = sin<Real>(t)*dt*dp;
+            }
+          }
+        }
+      }
+    }
+
+    Long Size() const override { return Nt_*Np_; }
+
+    void GetNodeCoord(Vector<Real>* X, Vector<Real>* Xn, Vector<Long>* element_wise_node_cnt) const override {
+      if (X) (*X) = X_;
+      if (Xn) (*Xn) = Xn_;
+      if (element_wise_node_cnt) {
+        element_wise_node_cnt->ReInit(Size());
+        (*element_wise_node_cnt) = q_*q_;
+      }
+    }
+
+    void GetFarFieldNodes(Vector<Real>& X, Vector<Real>& Xn, Vector<Real>& wts, Vector<Real>& dist_far, Vector<Long>& element_wise_node_cnt, const Real tol) const override {
+      GetNodeCoord(&X, &Xn, &element_wise_node_cnt);
+      wts = wts_;
+      dist_far.ReInit(wts_.Dim());
+      dist_far = 2*const_pi<Real>()/Nt_;
+    }
+
+    template <class Kernel> static void SelfInterac(Vector<Matrix<Real>>& M_lst, const Kernel& ker, Real tol, bool trg_dot_prod, const ElementListBase<Real>* self) {
+      const auto& elem_lst = *dynamic_cast<const SphereElemList*>(self);
+      const Long Nelem = elem_lst.Size(), Nnds = elem_lst.q_*elem_lst.q_;
+      if (M_lst.Dim() != Nelem) M_lst.ReInit(Nelem);
+      for (Long i = 0; i < Nelem; i++) {
+        const Vector<Real> X(Nnds*3, (Iterator<Real>)elem_lst.X_.begin()+i*Nnds*3, false);
+        elem_lst.ElemMatrix(M_lst[i], X, ker, i);
+      }
+    }
+
+    template <class Kernel> static void NearInterac(Matrix<Real>& M, const Vector<Real>& Xt, const Vector<Real>& normal_trg, const Kernel& ker, Real tol, const Long elem_idx, const ElementListBase<Real>* self) {
+      const auto& elem_lst = *dynamic_cast<const SphereElemList*>(self);
+      elem_lst.ElemMatrix(M, Xt, ker, elem_idx);
+    }
+
+  private:
+
+    // Quadrature matrix from the nodes of element elem_idx to the targets Xt.
+    template <class Kernel> void ElemMatrix(Matrix<Real>& M, const Vector<Real>& Xt, const Kernel& ker, const Long elem_idx) const {
+      const Long Nnds = q_*q_;
+      const Vector<Real> Xs(Nnds*3, (Iterator<Real>)X_.begin()+elem_idx*Nnds*3, false);
+      const Vector<Real> Xn(Nnds*3, (Iterator<Real>)Xn_.begin()+elem_idx*Nnds*3, false);
+      ker.KernelMatrix(M, Xt, Xs, Xn);
+      for (Long i = 0; i < Nnds; i++) {
+        for (Long k = 0; k < Kernel::SrcDim(); k++) {
+          for (Long j = 0; j < M.Dim(1); j++) M[i*Kernel::SrcDim()+k][j] *= wts_[elem_idx*Nnds+i];
+        }
+      }
+    }
+
+    Long Nt_, Np_, q_;
+    Vector<Real> X_, Xn_, wts_;
+};
+
+template <class Real> static Vector<Real> RandVec(Long N) {
+  Vector<Real> v(N);
+  for (auto& x : v) x = (Real)drand48();
+  return v;
+}
+
+template <class Real, class Kernel> static void BenchKernel(BenchLog& log, const std::string& name, const Kernel& ker, const Vector<Long>& Nlst) {
+  for (const Long N : Nlst) {
+    constexpr Integer DIM = Kernel::CoordDim();
+    const Vector<Real> Xs = RandVec<Real>(N*DIM), Xt = RandVec<Real>(N*DIM);
+    const Vector<Real> Xn = RandVec<Real>(N*Kernel::NormalDim());
+    const Vector<Real> F = RandVec<Real>(N*Kernel::SrcDim());
+    Vector<Real> U(N*Kernel::TrgDim());
+    const double bytes = (double)sizeof(Real) * N * (2*DIM + Kernel::NormalDim() + Kernel::SrcDim() + Kernel::TrgDim());
+    log.Run("GenericKernel::Eval(" + name + ")", std::to_string(N) + "x" + std::to_string(N), 0, bytes, [&](){
+      U = 0;
+      ker.template Eval<Real,true>(U, Xt, Xs, Xn, F);
+    });
+  }
+}
+
+template <class Real, class Kernel> static void BenchKernelBatch(BenchLog& log, const std::string& name, const Kernel& ker, const Long N, const Vector<Long>& Ndlst) {
+  for (const Long Nd : Ndlst) {
+    constexpr Integer DIM = Kernel::CoordDim();
+    const Vector<Real> Xs = RandVec<Real>(N*DIM), Xt = RandVec<Real>(N*DIM);
+    const Vector<Real> Xn = RandVec<Real>(N*Kernel::NormalDim());
+    Matrix<Real> F(Nd, N*Kernel::SrcDim()), U(Nd, N*Kernel::TrgDim());
+    for (auto& x : F) x = (Real)drand48();
+    const double bytes = (double)sizeof(Real) * N * (2*DIM + Kernel::NormalDim() + Nd*(Kernel::SrcDim() + Kernel::TrgDim()));
+    log.Run("GenericKernel::Eval(" + name + ",batch)", std::to_string(Nd) + "x" + std::to_string(N) + "x" + std::to_string(N), 0, bytes, [&](){
+      U = 0;
+      ker.template Eval<Real,true>(U, Xt, Xs, Xn, F);
+    });
+  }
+}
+
+template <class Real> static void BenchGEMM(BenchLog& log, const Vector<Long>& Nlst) {
+  for (const Long N : Nlst) {
+    Matrix<Real> A(N, N), B(N, N), C(N, N);
+    for (auto& x : A) x = (Real)drand48();
+    for (auto& x : B) x = (Real)drand48();
+    log.Run("Matrix::GEMM", std::to_string(N) + "x" + std::to_string(N) + "x" + std::to_string(N), 2.0*N*N*N, 3.0*sizeof(Real)*N*N, [&](){
+      Matrix<Real>::GEMM(C, A, B);
+    });
+  }
+}
+
+template <class Real> static void BenchFFT(BenchLog& log, const Vector<Long>& Nlst, Long howmany) {
+  for (const Long N : Nlst) {
+    Vector<Long> dim_vec(1);
+    dim_vec[0] = N;
+    FFT<Real> fft;
+    fft.Setup(FFT_Type::C2C, howmany, dim_vec, omp_get_max_threads());
+    const Vector<Real> in = RandVec<Real>(fft.Dim(0));
+    Vector<Real> out;
+    log.Run("FFT::Execute(C2C)", std::to_string(howmany) + "x" + std::to_string(N), 5.0*howmany*N*log2((double)N), (double)sizeof(Real)*(fft.Dim(0)+fft.Dim(1)), [&](){
+      fft.Execute(in, out);
+    });
+  }
+}
+
+template <class Real> static void BenchSHT(BenchLog& log, const Vector<Long>& Plst, Long Nsurf) {
+  for (const Long p : Plst) {
+    const Long Nt = p+1, Np = 2*p+2;
+    const Vector<Real> X = RandVec<Real>(Nsurf*Nt*Np);
+    Vector<Real> S;
+    // Legendre transform (p^3/3 complex multiply-adds) + FFT (5 Nlog(N) per latitude)
+    const double flop = Nsurf * (8.0*p*p*p/3 + 5.0*Nt*Np*log2((double)Np));
+    log.Run("SphericalHarmonics::Grid2SHC", std::to_string(Nsurf) + "xp" + std::to_string(p), flop, (double)sizeof(Real)*Nsurf*(Nt*Np+(p+1)*(p+2)), [&](){
+      SphericalHarmonics<Real>::Grid2SHC(X, Nt, Np, p, S, SHCArrange::ROW_MAJOR);
+    });
+  }
+}
+
+template <class Real> static void BenchBIOp(BenchLog& log, const Comm& comm, const Vector<Long>& Nlst) {
+  const Laplace3D_FxU ker;
+  for (const Long Nt : Nlst) {
+    const SphereElemList<Real> elem_lst(Nt, 2*Nt, 4);
+    const Long N = elem_lst.Size() * 16;
+    const std::string size = std::to_string(elem_lst.Size()) + "elem";
+    const double bytes = (double)sizeof(Real)*N*N; // near/self matrices (upper bound)
+    log.Run("BoundaryIntegralOp::Setup", size, 0, bytes, [&](){
+      BoundaryIntegralOp<Real,Laplace3D_FxU> BIOp(ker, false, comm);
+      BIOp.SetAccuracy((Real)1e-6);
+      BIOp.AddElemList(elem_lst);
+      BIOp.Setup();
+    });
+
+    BoundaryIntegralOp<Real,Laplace3D_FxU> BIOp(ker, false, comm);
+    BIOp.SetAccuracy((Real)1e-6);
+    BIOp.AddElemList(elem_lst);
+    BIOp.Setup();
+    const Vector<Real> F = RandVec<Real>(BIOp.Dim(0));
+    Vector<Real> U;
+    log.Run("BoundaryIntegralOp::ComputePotential", size, 0, bytes, [&](){
+      BIOp.ComputePotential(U, F);
+    });
+  }
+}
+
+static void BenchTree(BenchLog& log, const Comm& comm, const Vector<Long>& Nlst) {
+  for (const Long N : Nlst) {
+    const Long N_loc = N / comm.Size();
+    const Vector<double> X = RandVec<double>(N_loc*3);
+    log.Run("Tree::UpdateRefinement", std::to_string(N), 0, (double)sizeof(double)*N_loc*3, [&](){
+      Tree<3> tree(comm);
+      tree.UpdateRefinement(X, 100, true, false);
+    });
+  }
+}
+
+static void BenchComm(BenchLog& log, const Comm& comm, const Vector<Long>& Nlst) {
+  const Long np = comm.Size();
+  for (const Long N : Nlst) { // N doubles per process pair
+    Vector<double> sbuf = RandVec<double>(N*np), rbuf(N*np);
+    Vector<Long> cnt(np), dsp(np);
+    for (Long i = 0; i < np; i++) {
+      cnt[i] = N;
+      dsp[i] = N*i;
+    }
+    const std::string size = std::to_string(N*sizeof(double)) + "B";
+    log.Run("Comm::Allreduce", size, 0, (double)sizeof(double)*N, [&](){
+      comm.Allreduce<double>(sbuf.begin(), rbuf.begin(), N, CommOp::SUM);
+    });
+    log.Run("Comm::Allgatherv", size, 0, (double)sizeof(double)*N*np, [&](){
+      comm.Allgatherv(sbuf.begin(), N, rbuf.begin(), cnt.begin(), dsp.begin());
+    });
+    log.Run("Comm::Alltoallv", size, 0, (double)sizeof(double)*N*np, [&](){
+      comm.Alltoallv(sbuf.begin(), cnt.begin(), dsp.begin(), rbuf.begin(), cnt.begin(), dsp.begin());
+    });
+  }
+}
+
+int main(int argc, char** argv) {
+  Comm::MPI_Init(&argc, &argv);
+
+  {
+    const Comm comm = Comm::World();
+    const char* fname = (argc > 1 ? argv[1] : nullptr);
+    const double min_time = (argc > 2 ? atof(argv[2]) : 0.1);
+    BenchLog log(comm, min_time);
+
+    std::vector<Integer> thread_lst;
+    const Integer max_threads = omp_get_max_threads();
+    for (Integer t = 1; t < max_threads; t *= 2) thread_lst.push_back(t);
+    thread_lst.push_back(max_threads);
+
+    double wavenumber = 10;
+    Helmholtz3D_FxU helmholtz_ker;
+    ModHelmholtz3D_FxU mod_helmholtz_ker;
+    helmholtz_ker.SetCtxPtr(&wavenumber);
+    mod_helmholtz_ker.SetCtxPtr(&wavenumber);
+
+    for (const Integer t : thread_lst) {
+      omp_set_num_threads(t);
+      BenchKernel<double>(log, "Laplace3D_FxU", Laplace3D_FxU(), Vector<Long>{1000, 4000});
+      BenchKernel<double>(log, "Laplace3D_DxU", Laplace3D_DxU(), Vector<Long>{1000, 4000});
+      BenchKernel<double>(log, "Laplace3D_FxdU", Laplace3D_FxdU(), Vector<Long>{1000, 4000});
+      BenchKernel<double>(log, "Stokes3D_FxU", Stokes3D_FxU(), Vector<Long>{1000, 4000});
+      BenchKernel<double>(log, "Stokes3D_DxU", Stokes3D_DxU(), Vector<Long>{1000, 4000});
+      BenchKernel<double>(log, "Stokes3D_FxT", Stokes3D_FxT(), Vector<Long>{1000, 4000});
+      BenchKernel<double>(log, "Stokes3D_FSxU", Stokes3D_FSxU(), Vector<Long>{1000, 4000});
+      BenchKernel<double>(log, "Stokes3D_FxUP", Stokes3D_FxUP(), Vector<Long>{1000, 4000});
+      BenchKernel<double>(log, "Helmholtz3D_FxU", helmholtz_ker, Vector<Long>{1000, 4000});
+      BenchKernel<double>(log, "ModHelmholtz3D_FxU", mod_helmholtz_ker, Vector<Long>{1000, 4000});
+      BenchKernelBatch<double>(log, "Laplace3D_FxU", Laplace3D_FxU(), 2000, Vector<Long>{1, 8, 32});
+      BenchKernelBatch<double>(log, "Stokes3D_FxU", Stokes3D_FxU(), 2000, Vector<Long>{1, 8, 32});
+      BenchGEMM<double>(log, Vector<Long>{64, 256, 1024});
+      BenchFFT<double>(log, Vector<Long>{64, 256}, 256);
+      BenchSHT<double>(log, Vector<Long>{16, 32, 64}, 8);
+      BenchBIOp<double>(log, comm, Vector<Long>{4, 8});
+      BenchTree(log, comm, Vector<Long>{10000, 100000});
+      BenchComm(log, comm, Vector<Long>{1000, 100000});
+    }
+    omp_set_num_threads(max_threads);
+
+    log.Write(fname);
+  }
+
+  Comm::MPI_Finalize();
+  return 0;
+}
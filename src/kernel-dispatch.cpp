@@ -0,0 +1,19 @@
+// Kernels compiled for runtime CPU dispatch. This file is compiled once with
+// the baseline flags and once for each architecture in CPU_DISPATCH (see the
+// Makefile); the resulting objects are linked with the executables.
+#include "sctl.hpp"
+
+SCTL_CPU_DISPATCH_KERNEL(Laplace3D_FxU, sctl::Laplace3D_FxU)
+SCTL_CPU_DISPATCH_KERNEL(Laplace3D_DxU, sctl::Laplace3D_DxU)
+SCTL_CPU_DISPATCH_KERNEL(Laplace3D_FxdU, sctl::Laplace3D_FxdU)
+SCTL_CPU_DISPATCH_KERNEL(Stokes3D_FxU, sctl::Stokes3D_FxU)
+SCTL_CPU_DISPATCH_KERNEL(Stokes3D_DxU, sctl::Stokes3D_DxU)
+SCTL_CPU_DISPATCH_KERNEL(Stokes3D_FxT, sctl::Stokes3D_FxT)
+SCTL_CPU_DISPATCH_KERNEL(Stokes3D_FSxU, sctl::Stokes3D_FSxU)
+SCTL_CPU_DISPATCH_KERNEL(Stokes3D_FxUP, sctl::Stokes3D_FxUP)
+SCTL_CPU_DISPATCH_KERNEL(Helmholtz3D_FxU, sctl::Helmholtz3D_FxU)
+SCTL_CPU_DISPATCH_KERNEL(Helmholtz3D_DxU, sctl::Helmholtz3D_DxU)
+SCTL_CPU_DISPATCH_KERNEL(Helmholtz3D_FxdU, sctl::Helmholtz3D_FxdU)
+SCTL_CPU_DISPATCH_KERNEL(ModHelmholtz3D_FxU, sctl::ModHelmholtz3D_FxU)
+SCTL_CPU_DISPATCH_KERNEL(ModHelmholtz3D_DxU, sctl::ModHelmholtz3D_DxU)
+SCTL_CPU_DISPATCH_KERNEL(ModHelmholtz3D_FxdU, sctl::ModHelmholtz3D_FxdU)
@@ -326,6 +326,28 @@ void TestIalltoallvSparse(const Comm& comm) {
   CheckAlltoallvPayload(recv, recv_cnt, recv_dsp, rank);
 }
 
+void TestSampleSort(const Comm& comm) {
+  const Integer rank = comm.Rank();
+  for (Integer mode = 0; mode < 3; mode++) {
+    const Long N = (mode == 2 && rank % 2 ? 0 : 100 + 7 * rank);
+    Vector<Long> keys(N);
+    for (Long i = 0; i < N; i++) {
+      if (mode == 0) {  // random
+        keys[i] = ((rank * 7919 + i) * 104729) % 10007;
+      } else {  // nearly sorted, with a few elements out of place
+        keys[i] = (rank * 200 + i) * 10 + (i % 31 == 0 ? 500 * ((i / 31) % 3) : 0);
+      }
+    }
+
+    Vector<Long> sorted0, sorted1;
+    comm.HyperQuickSort(keys, sorted0);
+    comm.SampleSort(keys, sorted1);
+    AssertEqual(sorted0.Dim(), sorted1.Dim());
+    for (Long i = 0; i < sorted0.Dim(); i++) AssertEqual(sorted0[i], sorted1[i]);
+    for (Long i = 1; i < sorted1.Dim(); i++) SCTL_ASSERT(sorted1[i - 1] <= sorted1[i]);
+  }
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -343,6 +365,25 @@ int main(int argc, char** argv) {
   TestAlltoall(comm);
   TestAlltoallv(comm);
   TestIalltoallvSparse(comm);
+  TestSampleSort(comm);
+
+  {  // Node-aware collectives, grouping pairs of consecutive ranks as one node
+    Comm hier_comm = comm;
+    hier_comm.SetHierarchical(true, 2);
+    TestAllgather(hier_comm);
+    TestAllgatherv(hier_comm);
+    TestAllgathervMixedTypes(hier_comm);
+    TestAlltoallv(hier_comm);
+    TestSampleSort(hier_comm);
+
+    const bool hier = hier_comm.IsHierarchical();  // (always false without MPI)
+    Comm hier_copy = hier_comm;  // shares the node and leader communicators
+    SCTL_ASSERT(hier_copy.IsHierarchical() == hier);
+    TestAlltoallv(hier_copy);
+    hier_comm.SetHierarchical(false);
+    SCTL_ASSERT(hier_copy.IsHierarchical() == hier && !hier_comm.IsHierarchical());
+    TestAllgatherv(hier_copy);
+  }
 
   comm.Barrier();
   if (!comm.Rank()) {
@@ -1,11 +1,15 @@
 #include "sctl.hpp"
 
 int main(int argc, char** argv) {
+  sctl::Comm::MPI_Init(&argc, &argv);
+
   sctl::FFT<float>::test();
   sctl::FFT<double>::test();
   sctl::FFT<long double>::test();
 #ifdef SCTL_QUAD_T
   sctl::FFT<sctl::QuadReal>::test();
 #endif
+
+  sctl::Comm::MPI_Finalize();
   return 0;
 }
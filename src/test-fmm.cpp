@@ -1,11 +1,340 @@
+#include <complex>
+
 #include "sctl.hpp"
 
+template <sctl::Integer digits, class Kernel> double KernelDigitsError(const Kernel& ker, const sctl::Long N, const double shift) {
+  const sctl::Integer KDIM0 = Kernel::SrcDim(), NDIM = Kernel::NormalDim();
+  sctl::Vector<double> Xs(N*3), Xt(N*3), Xn(N*NDIM), F(N*KDIM0);
+  for (sctl::Long i = 0; i < N*3; i++) {
+    Xs[i] = shift + drand48();
+    Xt[i] = (i < N*3/2 ? Xs[i] + 1e-4 * drand48() : shift + drand48());  // half of the targets are close to a source
+  }
+  for (auto& x : Xn) x = drand48();
+  for (auto& x : F) x = drand48() - 0.5;
+
+  sctl::Vector<double> U0, U1;
+  ker.template Eval<double,false,-1>(U0, Xt, Xs, Xn, F);
+  ker.template Eval<double,false,digits>(U1, Xt, Xs, Xn, F);
+  double max_err = 0, max_val = 0;
+  for (sctl::Long i = 0; i < U0.Dim(); i++) {
+    max_err = std::max<double>(max_err, fabs(U1[i] - U0[i]));
+    max_val = std::max<double>(max_val, fabs(U0[i]));
+  }
+  return max_err / max_val;
+}
+
+void TestKernelDigits() {  // double-precision kernels evaluated in single precision for digits <= SCTL_KERNEL_FLOAT_MAX_DIGITS
+  for (const double shift : {0.0, 1000.0}) {
+    double err3 = 0, err6 = 0;
+    err3 = std::max(err3, KernelDigitsError<3>(sctl::Laplace3D_FxU(), 2000, shift));
+    err6 = std::max(err6, KernelDigitsError<6>(sctl::Laplace3D_FxU(), 2000, shift));
+    err6 = std::max(err6, KernelDigitsError<6>(sctl::Laplace3D_DxU(), 2000, shift));
+    err6 = std::max(err6, KernelDigitsError<6>(sctl::Stokes3D_FxU(), 2000, shift));
+    err6 = std::max(err6, KernelDigitsError<6>(sctl::Stokes3D_DxU(), 2000, shift));
+    std::cout << "Maximum relative error (digits=3, shift=" << shift << "): " << err3 << '\n';
+    std::cout << "Maximum relative error (digits=6, shift=" << shift << "): " << err6 << '\n';
+    SCTL_ASSERT(err3 < 1e-3);
+    SCTL_ASSERT(err6 < 1e-5);
+  }
+}
+
+template <class Kernel> double KernelSelfError(const Kernel& ker, const sctl::Long N) {
+  const sctl::Integer KDIM0 = Kernel::SrcDim(), NDIM = Kernel::NormalDim();
+  sctl::Vector<double> X(N*3), Xn(N*NDIM), F(N*KDIM0);
+  for (auto& x : X) x = drand48();
+  for (auto& x : Xn) x = drand48();
+  for (auto& x : F) x = drand48() - 0.5;
+
+  const auto rel_err = [](const sctl::Vector<double>& A, const sctl::Vector<double>& B) {
+    double max_err = 0, max_val = 0;
+    for (sctl::Long i = 0; i < A.Dim(); i++) {
+      max_err = std::max<double>(max_err, fabs(A[i] - B[i]));
+      max_val = std::max<double>(max_val, fabs(A[i]));
+    }
+    return max_err / max_val;
+  };
+
+  sctl::Vector<double> U0, U1, U2;
+  ker.template Eval<double,false>(U0, X, X, Xn, F);
+  ker.template EvalSelf<double,false>(U1, X, Xn, F);
+  ker.template EvalSelf<double,true>(U2, X, Xn, F);
+  double err = std::max(rel_err(U0, U1), rel_err(U0, U2));
+
+  sctl::Matrix<double> M0, M1;
+  ker.template KernelMatrix<double,true>(M0, X, X, Xn);
+  ker.template KernelMatrixSelf<double,true>(M1, X, Xn);
+  err = std::max(err, rel_err(sctl::Vector<double>(M0.Dim(0)*M0.Dim(1), M0.begin(), false), sctl::Vector<double>(M1.Dim(0)*M1.Dim(1), M1.begin(), false)));
+  return err;
+}
+
+void TestKernelSelf() {  // EvalSelf and KernelMatrixSelf against Eval(X,X) and KernelMatrix(X,X)
+  double err = 0;
+  for (const sctl::Long N : {7, 100, 1000}) {  // KernelMatrixSelf uses the full KernelMatrix above 1 MB
+    err = std::max(err, KernelSelfError(sctl::Laplace3D_FxU(), N));
+    err = std::max(err, KernelSelfError(sctl::Stokes3D_FxU(), N));
+    err = std::max(err, KernelSelfError(sctl::Laplace3D_DxU(), N));  // not symmetric
+  }
+  std::cout << "Maximum relative error (self interaction): " << err << '\n';
+  SCTL_ASSERT(err < 1e-12);
+}
+
+void TestKernelReducedTeam() {  // Eval when the runtime starts fewer threads than omp_get_max_threads()
+  const sctl::Long Ns = 5000, Nt = 333;
+  sctl::Vector<double> Xs(Ns*3), Xt(Nt*3), Xn, F(Ns);
+  for (auto& x : Xs) x = drand48();
+  for (auto& x : Xt) x = drand48();
+  for (auto& x : F) x = drand48() - 0.5;
+
+  sctl::Vector<double> U0, U1;
+  sctl::Laplace3D_FxU().template Eval<double,false>(U0, Xt, Xs, Xn, F);
+  const int omp_p = omp_get_max_threads();
+  const int dynamic = omp_get_dynamic();
+  omp_set_num_threads(4 * omp_get_num_procs());  // with dynamic adjustment, the team is limited to the available processors
+  omp_set_dynamic(1);
+  sctl::Laplace3D_FxU().template Eval<double,true>(U1, Xt, Xs, Xn, F);
+  omp_set_dynamic(dynamic);
+  omp_set_num_threads(omp_p);
+
+  double max_err = 0, max_val = 0;
+  for (sctl::Long i = 0; i < U0.Dim(); i++) {
+    max_err = std::max<double>(max_err, fabs(U1[i] - U0[i]));
+    max_val = std::max<double>(max_val, fabs(U0[i]));
+  }
+  std::cout << "Maximum relative error (reduced thread team): " << max_err / max_val << '\n';
+  SCTL_ASSERT(max_err / max_val < 1e-12);
+}
+
+template <class Real, sctl::Integer digits=-1> Real HelmholtzError(const Real k, const sctl::Long Ns, const sctl::Long Nt) {  // against std::complex reference sums
+  using Complex = std::complex<double>;
+  sctl::Vector<Real> Xs(Ns*3), Xn(Ns*3), Xt(Nt*3), F(Ns*2);
+  for (auto& x : Xs) x = (Real)drand48();
+  for (auto& x : Xn) x = (Real)(drand48() - 0.5);
+  for (auto& x : Xt) x = (Real)drand48();
+  for (auto& x : F) x = (Real)(drand48() - 0.5);
+
+  sctl::Helmholtz3D_FxU helm_sl;
+  sctl::Helmholtz3D_DxU helm_dl;
+  sctl::ModHelmholtz3D_FxU mod_helm_sl;
+  helm_sl.SetCtxPtr((void*)&k);  // the wavenumber has the type of the evaluation precision
+  helm_dl.SetCtxPtr((void*)&k);
+  mod_helm_sl.SetCtxPtr((void*)&k);
+  sctl::Vector<Real> U_sl, U_dl, U_mod;
+  helm_sl.template Eval<Real,false,digits>(U_sl, Xt, Xs, Xn, F);
+  helm_dl.template Eval<Real,false,digits>(U_dl, Xt, Xs, Xn, F);
+  mod_helm_sl.template Eval<Real,false,digits>(U_mod, Xt, Xs, Xn, sctl::Vector<Real>(Ns, F.begin(), false));
+
+  double max_err = 0, max_val = 0;
+  const auto update = [&max_err, &max_val](const Complex& u, const Complex& u_ref) {
+    max_err = std::max<double>(max_err, std::abs(u - u_ref));
+    max_val = std::max<double>(max_val, std::abs(u_ref));
+  };
+  const Complex I(0, 1);
+  const double scal = 1 / (4 * sctl::const_pi<double>());
+  for (sctl::Long t = 0; t < Nt; t++) {
+    Complex u_sl = 0, u_dl = 0, u_mod = 0;
+    for (sctl::Long s = 0; s < Ns; s++) {
+      const double dx[3] = {(double)Xt[t*3+0]-(double)Xs[s*3+0], (double)Xt[t*3+1]-(double)Xs[s*3+1], (double)Xt[t*3+2]-(double)Xs[s*3+2]};
+      const double r = sqrt(dx[0]*dx[0] + dx[1]*dx[1] + dx[2]*dx[2]);
+      const double rdotn = dx[0]*(double)Xn[s*3+0] + dx[1]*(double)Xn[s*3+1] + dx[2]*(double)Xn[s*3+2];
+      const Complex f((double)F[s*2+0], (double)F[s*2+1]);
+      u_sl += scal * std::exp(I*(double)k*r) / r * f;
+      u_dl += scal * std::exp(I*(double)k*r) * (1.0 - I*(double)k*r) * rdotn / (r*r*r) * f;
+      u_mod += scal * exp(-(double)k*r) / r * (double)F[s];
+    }
+    update(Complex(U_sl[t*2+0], U_sl[t*2+1]), u_sl);
+    update(Complex(U_dl[t*2+0], U_dl[t*2+1]), u_dl);
+    update(Complex(U_mod[t], 0), u_mod);
+  }
+  return (Real)(max_err / max_val);
+}
+
+void TestHelmholtz() {
+  for (const double k : {0.5, 10.0}) {
+    const double err_d = HelmholtzError<double>(k, 500, 300);
+    const double err_d6 = HelmholtzError<double,6>(k, 500, 300);
+    const float err_f = HelmholtzError<float>((float)k, 500, 300);
+    std::cout << "Maximum relative error (Helmholtz, k=" << k << "): " << err_d << " (double), " << err_d6 << " (double, digits=6), " << err_f << " (float)\n";
+    SCTL_ASSERT(err_d < 1e-12);
+    SCTL_ASSERT(err_d6 < 1e-5);
+    SCTL_ASSERT(err_f < 1e-4);
+  }
+}
+
+template <class KerM2L, class KerS2T> void FMMSetup(sctl::ParticleFMM<double,3>& fmm, const sctl::Integer digits) {
+  const KerM2L ker_m2l;
+  const KerS2T ker_s2t;
+  fmm.SetAccuracy(digits);
+  fmm.SetKernels(ker_m2l, ker_m2l, ker_s2t);
+  fmm.AddTrg("Trg", ker_m2l, ker_s2t);
+  fmm.AddSrc("Src", ker_s2t, ker_s2t);
+  fmm.SetKernelS2T("Src", "Trg", ker_s2t);
+}
+
+template <class KerM2L, class KerS2T> double FMMError(const sctl::Comm& comm, const sctl::ParticleFMM<double,3>& fmm, const sctl::Vector<double>& Xt, const sctl::Vector<double>& Xs, const sctl::Matrix<double>& F) {  // Eval(Matrix) against the full-precision direct evaluation
+  sctl::ParticleFMM<double,3> fmm_ref(comm);
+  FMMSetup<KerM2L,KerS2T>(fmm_ref, 15);
+  fmm_ref.SetTrgCoord("Trg", Xt);
+  fmm_ref.SetSrcCoord("Src", Xs);
+  fmm_ref.SetSrcDensity("Src", F);
+
+  sctl::Matrix<double> U, Uref;
+  fmm.Eval(U, "Trg");
+  fmm_ref.EvalDirect(Uref, "Trg");
+  SCTL_ASSERT(U.Dim(0) == Uref.Dim(0) && U.Dim(1) == Uref.Dim(1));
+  sctl::StaticArray<double,2> loc_err{0,0}, glb_err{0,0};
+  for (sctl::Long i = 0; i < U.Dim(0)*U.Dim(1); i++) {
+    loc_err[0] = std::max<double>(loc_err[0], fabs(U[0][i] - Uref[0][i]));
+    loc_err[1] = std::max<double>(loc_err[1], fabs(Uref[0][i]));
+  }
+  comm.Allreduce<double>(loc_err, glb_err, 2, sctl::CommOp::MAX);
+  return glb_err[0] / glb_err[1];
+}
+
+template <class KerM2L, class KerS2T> double FMMError(const sctl::Comm& comm, const sctl::Integer digits, const sctl::Long Ns, const sctl::Long Nt, const sctl::Long Nd = 1) {
+  sctl::Vector<double> Xt(Nt/comm.Size()*3), Xs(Ns/comm.Size()*3);
+  sctl::Matrix<double> F(Nd, Ns/comm.Size()*KerS2T::SrcDim());
+  for (auto& x : Xt) x = drand48() - 0.5;
+  for (auto& x : Xs) x = drand48() - 0.5;
+  for (auto& x : F) x = drand48() - 0.5;
+
+  sctl::ParticleFMM<double,3> fmm(comm);
+  FMMSetup<KerM2L,KerS2T>(fmm, digits);
+  fmm.SetTrgCoord("Trg", Xt);
+  fmm.SetSrcCoord("Src", Xs);
+  fmm.SetSrcDensity("Src", F);
+  return FMMError<KerM2L,KerS2T>(comm, fmm, Xt, Xs, F);
+}
+
+void TestFMMAccuracy(const sctl::Comm& comm) {  // more than 40000 targets, so that Eval does not use the direct evaluation
+  const sctl::Integer digits = 6;
+  const double err_laplace = FMMError<sctl::Laplace3D_FxU, sctl::Laplace3D_FxU>(comm, digits, 20000, 48000);
+  const double err_stokes = FMMError<sctl::Stokes3D_FxU, sctl::Stokes3D_FxU>(comm, digits, 20000, 48000);
+  const double err_batch = FMMError<sctl::Laplace3D_FxU, sctl::Laplace3D_FxU>(comm, digits, 20000, 48000, 3);
+  if (!comm.Rank()) std::cout << "Maximum relative error (FMM, digits=" << digits << "): " << err_laplace << " (Laplace), " << err_stokes << " (Stokes), " << err_batch << " (Laplace, batch of 3 densities)\n";
+  SCTL_ASSERT(err_laplace < 1e-6);
+  SCTL_ASSERT(err_stokes < 1e-6);
+  SCTL_ASSERT(err_batch < 1e-6);
+}
+
+void TestFMMIncremental(const sctl::Comm& comm) {  // SetIncrementalUpdate with moving particles
+  using Ker = sctl::Laplace3D_FxU;
+  const sctl::Long Ns = 20000/comm.Size(), Nt = 48000/comm.Size();
+  sctl::Vector<double> Xt(Nt*3), Xs(Ns*3);
+  sctl::Matrix<double> F(1, Ns);
+  for (auto& x : Xt) x = drand48() - 0.5;
+  for (auto& x : Xs) x = drand48() - 0.5;
+  for (auto& x : F) x = drand48() - 0.5;
+
+  sctl::ParticleFMM<double,3> fmm(comm);
+  FMMSetup<Ker,Ker>(fmm, 6);
+  fmm.SetIncrementalUpdate(true);
+  fmm.SetTrgCoord("Trg", Xt);
+  fmm.SetSrcCoord("Src", Xs);
+  fmm.SetSrcDensity("Src", F);
+  double err = FMMError<Ker,Ker>(comm, fmm, Xt, Xs, F);
+
+  for (auto& x : Xs) x += 1e-3 * (drand48() - 0.5);  // small displacements: particles are re-sorted into the same tree
+  for (auto& x : Xt) x += 1e-3 * (drand48() - 0.5);
+  fmm.SetSrcCoord("Src", Xs);
+  fmm.SetTrgCoord("Trg", Xt);
+  err = std::max(err, FMMError<Ker,Ker>(comm, fmm, Xt, Xs, F));
+
+  for (sctl::Long i = 0; i < Ns/2*3; i++) Xs[i] = 0.1 * Xs[i] + 0.25;  // clustered sources: boxes overflow and the tree is rebuilt
+  fmm.SetSrcCoord("Src", Xs);
+  err = std::max(err, FMMError<Ker,Ker>(comm, fmm, Xt, Xs, F));
+
+  if (!comm.Rank() && Ns) Xs[0] = 2;  // a source outside the root box
+  fmm.SetSrcCoord("Src", Xs);
+  err = std::max(err, FMMError<Ker,Ker>(comm, fmm, Xt, Xs, F));
+
+  if (!comm.Rank()) std::cout << "Maximum relative error (FMM, incremental update): " << err << '\n';
+  SCTL_ASSERT(err < 1e-6);
+}
+
+void TestFMMRepartition(const sctl::Comm& comm) {  // SetIncrementalUpdate when the work is not balanced by the point counts
+  using Ker = sctl::Laplace3D_FxU;
+  const sctl::Long Ns = 20000/comm.Size(), Nt = 48000/comm.Size();
+  sctl::Vector<double> Xt(Nt*3), Xs(Ns*3);
+  sctl::Matrix<double> F(1, Ns);
+  for (auto& x : Xt) x = drand48() - 0.5;
+  for (sctl::Long i = 0; i < Ns*3; i++) Xs[i] = (i % 3 ? drand48() - 0.5 : 0.25 * drand48() - 0.5);  // sources in a quarter of the box
+  for (auto& x : F) x = drand48() - 0.5;
+
+  sctl::ParticleFMM<double,3> fmm(comm);
+  FMMSetup<Ker,Ker>(fmm, 6);
+  fmm.SetIncrementalUpdate(true);
+  fmm.SetTrgCoord("Trg", Xt);
+  fmm.SetSrcCoord("Src", Xs);
+  fmm.SetSrcDensity("Src", F);
+  double err = FMMError<Ker,Ker>(comm, fmm, Xt, Xs, F);
+
+  for (sctl::Integer iter = 0; iter < 2; iter++) { // the tree is reused and repartitioned with the measured time of the previous evaluation
+    for (auto& x : Xs) x += 1e-3 * (drand48() - 0.5);
+    for (auto& x : Xt) x += 1e-3 * (drand48() - 0.5);
+    fmm.SetSrcCoord("Src", Xs);
+    fmm.SetTrgCoord("Trg", Xt);
+    err = std::max(err, FMMError<Ker,Ker>(comm, fmm, Xt, Xs, F));
+  }
+
+  if (!comm.Rank()) std::cout << "Maximum relative error (FMM, incremental update with repartitioning): " << err << '\n';
+  SCTL_ASSERT(err < 1e-6);
+}
+
+#ifdef SCTL_HAVE_OMP_TARGET
+template <class Real, class Kernel> Real DeviceEvalError(const Kernel& ker, const sctl::Vector<Real>& Xt, const sctl::Vector<Real>& Xs, const sctl::Vector<Real>& Xn, const sctl::Vector<Real>& F) {
+  sctl::Vector<Real> U0, U1;
+  ker.template Eval<Real,false>(U0, Xt, Xs, Xn, F);  // host
+  ker.template Eval<Real,true>(U1, Xt, Xs, Xn, F);  // device code path
+  Real max_err = 0, max_val = 0;
+  for (sctl::Long i = 0; i < U0.Dim(); i++) {
+    max_err = std::max<Real>(max_err, sctl::fabs(U1[i] - U0[i]));
+    max_val = std::max<Real>(max_val, sctl::fabs(U0[i]));
+  }
+  return max_err / max_val;
+}
+
+template <class Real> void TestDeviceEval() {  // GenericKernel::Eval on the OpenMP target device (or the host fallback)
+  const bool host_fallback = sctl::DeviceCoordCache::HostFallback(true);
+  const sctl::Long Ns = 1500, Nt = 1000;  // Ns*Nt >= SCTL_OMP_TARGET_MIN_INTERAC
+  sctl::Vector<Real> Xs(Ns*3), Xn(Ns*3), Xt(Nt*3), F(Ns*3);
+  for (auto& x : Xs) x = (Real)drand48();
+  for (auto& x : Xn) x = (Real)drand48();
+  for (auto& x : Xt) x = (Real)drand48();
+  for (auto& x : F) x = (Real)drand48();
+  const sctl::Vector<Real> F1(Ns, F.begin(), false);
+
+  Real err = DeviceEvalError(sctl::Laplace3D_FxU(), Xt, Xs, Xn, F1);
+  err = std::max(err, DeviceEvalError(sctl::Laplace3D_DxU(), Xt, Xs, Xn, F1));
+  err = std::max(err, DeviceEvalError(sctl::Stokes3D_FxU(), Xt, Xs, Xn, F));
+  for (auto& x : Xs) x = (Real)drand48();  // the cached coordinates must be updated
+  err = std::max(err, DeviceEvalError(sctl::Stokes3D_FxU(), Xt, Xs, Xn, F));
+  std::cout << "Maximum relative error (device evaluation): " << err << '\n';
+  SCTL_ASSERT(err < 100 * sctl::machine_eps<Real>());
+
+  sctl::DeviceCoordCache::Clear();
+  sctl::DeviceCoordCache::HostFallback(host_fallback);
+}
+#endif
+
 int main(int argc, char** argv) {
   sctl::Comm::MPI_Init(&argc, &argv);
 
   sctl::ParticleFMM<double,2>::test(sctl::Comm::World());
   //sctl::ParticleFMM<float,2>::test(sctl::Comm::World());
   //sctl::ParticleFMM<sctl::QuadReal,2>::test(sctl::Comm::World());
+  TestFMMAccuracy(sctl::Comm::World());
+  TestFMMIncremental(sctl::Comm::World());
+  TestFMMRepartition(sctl::Comm::World());
+
+  if (!sctl::Comm::World().Rank()) {  // kernel tests on a single process
+    TestKernelDigits();
+    TestKernelSelf();
+    TestKernelReducedTeam();
+    TestHelmholtz();
+#ifdef SCTL_HAVE_OMP_TARGET
+    TestDeviceEval<double>();
+#endif
+  }
 
   sctl::Comm::MPI_Finalize();
   return 0;
@@ -1,9 +1,51 @@
 #include "sctl.hpp"
 
+void TestPrecond(const long N = 200) {  // GMRES<double> (through PETSc, if enabled) with a fixed right preconditioner
+  srand48(1);
+  sctl::Matrix<double> A(N, N);
+  sctl::Vector<double> b(N), x;
+  for (long i = 0; i < N; i++) {
+    b[i] = drand48();
+    for (long j = 0; j < N; j++) A[i][j] = (drand48() - 0.5) / N + (i == j ? i + 1 : 0);  // badly scaled diagonal
+  }
+  const auto LinOp = [&A](sctl::Vector<double>* Ax, const sctl::Vector<double>& x) {
+    const long N = x.Dim();
+    Ax->ReInit(N);
+    sctl::Matrix<double> Ax_(N, 1, Ax->begin(), false);
+    Ax_ = A * sctl::Matrix<double>(N, 1, (sctl::Iterator<double>)x.begin(), false);
+  };
+  const auto residual = [&]() {
+    sctl::Vector<double> Ax;
+    LinOp(&Ax, x);
+    double max_err = 0;
+    for (long i = 0; i < N; i++) max_err = std::max(max_err, fabs(Ax[i] - b[i]));
+    return max_err;
+  };
+
+  sctl::Long iter0, iter1;
+  sctl::GMRES<double> solver(sctl::Comm::Self(), false);
+  solver(&x, LinOp, b, 1e-10, -1, false, &iter0);
+  const double err0 = residual();
+
+  sctl::KrylovPrecond<double> precond;
+  precond.SetPrecond([&A](sctl::Vector<double>* Mx, const sctl::Vector<double>& x) {  // Jacobi
+    Mx->ReInit(x.Dim());
+    for (long i = 0; i < x.Dim(); i++) (*Mx)[i] = x[i] / A[i][i];
+  });
+  x.ReInit(0);
+  solver(&x, LinOp, b, 1e-10, -1, false, &iter1, &precond);
+  const double err1 = residual();
+
+  std::cout << "GMRES<double> iterations = " << iter0 << " (error = " << err0 << "), with preconditioner = " << iter1 << " (error = " << err1 << ")\n";
+  SCTL_ASSERT(err0 < 1e-7 && err1 < 1e-7);
+  SCTL_ASSERT(iter1 < iter0 / 2);
+}
+
 int main(int argc, char** argv) {
   sctl::Comm::MPI_Init(&argc, &argv);
 
   sctl::GMRES<long double>::test();
+  TestPrecond();
 
   sctl::Comm::MPI_Finalize();
   return 0;
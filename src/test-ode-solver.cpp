@@ -1,6 +1,6 @@
 #include "sctl.hpp"
 
-template <class Real> void test_adaptive_solve(const int Order, const Real tol) {
+template <class Real> void test_adaptive_solve(const int Order, const Real tol, const sctl::SDCSweep sweep = sctl::SDCSweep::GaussSeidel) {
   auto ref_sol = [](Real t) { return sctl::cos(-t); };
   auto fn = [](sctl::Vector<Real>* dudt, const sctl::Vector<Real>& u) {
     (*dudt)[0] = -u[1];
@@ -12,6 +12,7 @@ template <class Real> void test_adaptive_solve(const int Order, const Real tol)
   Real T = 10.0, dt = 1.0e-1;
 
   sctl::SDC<Real> ode_solver(Order);
+  ode_solver.SetSweep(sweep);
   Real t = ode_solver.AdaptiveSolve(&u, dt, T, u0, fn, tol);
 
   if (t == T) {
@@ -25,9 +26,12 @@ int main(int argc, char** argv) {
 
   test_adaptive_solve<double>(5, 1e-5); // 5-th order scheme
   test_adaptive_solve<double>(12, 1e-12); // 12-th order scheme
+  test_adaptive_solve<double>(12, 1e-12, sctl::SDCSweep::Jacobi); // with concurrent evaluations at the substeps
 
   //test_adaptive_solve<double>(12, 1e-18);
 
+  sctl::SDC<double>::test_parareal(); // parallel-in-time, one time slice per process
+
   sctl::Comm::MPI_Finalize();
   return 0;
 }
@@ -1,10 +1,219 @@
 #include <sctl.hpp>
 
+template <class Real, class Tree> sctl::Long MaxLeafCount(const Tree& tree, const std::string& particle_name) {  // maximum number of particles in a leaf (over all processes)
+  const auto& node_attr = tree.GetNodeAttr();
+  sctl::Vector<Real> X;
+  sctl::Vector<sctl::Long> cnt;
+  tree.GetData(X, cnt, particle_name);
+
+  sctl::StaticArray<sctl::Long,2> max_cnt{0,0};
+  for (sctl::Long i = 0; i < cnt.Dim(); i++) {
+    if (node_attr[i].Leaf && !node_attr[i].Ghost) max_cnt[0] = std::max(max_cnt[0], cnt[i]);
+  }
+  tree.GetComm().Allreduce(max_cnt+0, max_cnt+1, 1, sctl::CommOp::MAX);
+  return max_cnt[1];
+}
+
+template <class Real, sctl::Integer DIM> void TestIncrementalRefinement(const sctl::Comm& comm) {  // move the particles and refine the tree incrementally
+  const sctl::Long N = 20000, M = 100;
+  srand48(comm.Rank() + 1);
+  sctl::Vector<Real> X(N*DIM), f(N);
+  for (sctl::Long i = 0; i < N; i++) {
+    for (sctl::Integer k = 0; k < DIM; k++) X[i*DIM+k] = (Real)(sctl::pow<3>(drand48()*2-1.0)*0.5+0.5);
+    f[i] = (Real)(comm.Rank() * N + i);
+  }
+
+  sctl::PtTree<Real,DIM> tree(comm);
+  tree.AddParticles("pt", X);
+  tree.AddParticleData("pt-value", "pt", f);
+  tree.UpdateRefinement(X, M);
+
+  for (sctl::Integer iter = 0; iter < 4; iter++) {
+    for (auto& x : X) { // move the particles (by up to half a leaf at depth 5)
+      x += (Real)((drand48()-0.5) / 64);
+      x = std::min<Real>(std::max<Real>(x, 0), (Real)0.999);
+    }
+    tree.DeleteParticleData("pt");
+    tree.AddParticles("pt", X);
+    tree.AddParticleData("pt-value", "pt", f);
+    const auto mins = tree.GetPartitionMID();
+    tree.UpdateRefinement(X, M, false, false, -1, true);
+    for (sctl::Long i = 0; i < mins.Dim(); i++) SCTL_ASSERT(tree.GetPartitionMID()[i] == mins[i]); // the partition is kept while it is balanced
+
+    sctl::Vector<Real> X_, f_;
+    tree.GetParticleData(X_, "pt");
+    tree.GetParticleData(f_, "pt-value");
+    SCTL_ASSERT(X_.Dim() == X.Dim() && f_.Dim() == f.Dim());
+    for (sctl::Long i = 0; i < X.Dim(); i++) SCTL_ASSERT(X_[i] == X[i]);
+    for (sctl::Long i = 0; i < f.Dim(); i++) SCTL_ASSERT(f_[i] == f[i]);
+
+    const sctl::Long max_cnt = MaxLeafCount<Real>(tree, "pt");
+    if (!comm.Rank()) std::cout << "Incremental refinement " << iter << ": max points per leaf = " << max_cnt << '\n';
+    SCTL_ASSERT(max_cnt <= M);
+  }
+}
+
+template <class Real, sctl::Integer DIM> double LeafWeightImbalance(sctl::Long& local_wt, sctl::PtTree<Real,DIM>& tree) {  // local leaf weight and the ratio of the maximum to the average (over all processes)
+  const auto& comm = tree.GetComm();
+  sctl::Vector<sctl::Long> wts;
+  tree.LeafWeights(wts, "pt");
+  local_wt = 0;
+  for (const auto w : wts) local_wt += w;
+
+  sctl::StaticArray<sctl::Long,1> Wmax, Wsum;
+  comm.Allreduce(sctl::Ptr2ConstItr<sctl::Long>(&local_wt,1), (sctl::Iterator<sctl::Long>)Wmax, 1, sctl::CommOp::MAX);
+  comm.Allreduce(sctl::Ptr2ConstItr<sctl::Long>(&local_wt,1), (sctl::Iterator<sctl::Long>)Wsum, 1, sctl::CommOp::SUM);
+  return Wmax[0] * comm.Size() / (double)Wsum[0];
+}
+
+template <class Real, sctl::Integer DIM> void TestRepartition(const sctl::Comm& comm) {  // balance the near-field work of clustered particles
+  const sctl::Long N = 20000, M = 100;
+  const sctl::Integer np = comm.Size();
+  srand48(comm.Rank() + 1);
+  sctl::Vector<Real> X(N*DIM), f(N);
+  for (sctl::Long i = 0; i < N; i++) {
+    for (sctl::Integer k = 0; k < DIM; k++) X[i*DIM+k] = (Real)(i % 2 ? drand48() * 0.999 : 0.4 + 0.1 * drand48()); // half of the particles in a small cube
+    f[i] = (Real)(comm.Rank() * N + i);
+  }
+
+  sctl::PtTree<Real,DIM> tree(comm);
+  tree.AddParticles("pt", X);
+  tree.AddParticleData("pt-value", "pt", f);
+  tree.UpdateRefinement(X, M, false, false, 0);
+
+  sctl::Long wt;
+  sctl::Vector<sctl::Long> wts;
+  const double imb0 = LeafWeightImbalance(wt, tree);
+  tree.LeafWeights(wts, "pt");
+  tree.Repartition(wts, false, 0);
+  const double imb1 = LeafWeightImbalance(wt, tree);
+  SCTL_ASSERT(np == 1 || (imb0 > 1.2 && imb1 < 1.1));
+
+  // the first process takes twice as long as its weight predicts, so it should get about half of the work of the others
+  tree.LeafWeights(wts, "pt");
+  tree.Repartition(wts, false, 0, 1.1, (double)wt * (comm.Rank() ? 1 : 2));
+  const double imb2 = LeafWeightImbalance(wt, tree);
+  sctl::StaticArray<sctl::Long,1> Wsum;
+  sctl::Long wt0 = wt;
+  comm.Allreduce(sctl::Ptr2ConstItr<sctl::Long>(&wt,1), (sctl::Iterator<sctl::Long>)Wsum, 1, sctl::CommOp::SUM);
+  comm.Bcast(sctl::Ptr2Itr<sctl::Long>(&wt0,1), 1, 0);
+  SCTL_ASSERT(np == 1 || wt0 * np < 0.8 * Wsum[0]);
+
+  sctl::Vector<Real> f_;
+  tree.GetParticleData(f_, "pt-value");
+  SCTL_ASSERT(f_.Dim() == f.Dim());
+  for (sctl::Long i = 0; i < f.Dim(); i++) SCTL_ASSERT(f_[i] == f[i]);
+  SCTL_ASSERT(MaxLeafCount<Real>(tree, "pt") <= M);
+
+  if (!comm.Rank()) std::cout << "Leaf weight imbalance: " << imb0 << " (initial), " << imb1 << " (repartitioned), " << imb2 << " (with measured time)" << '\n';
+}
+
+template <sctl::Integer DIM> void TestHilbertOrder(const sctl::Comm& comm) {  // the children (and the tree nodes) follow the Hilbert curve
+  using HID = sctl::Hilbert<DIM>;
+  const sctl::Integer depth = 4;
+  sctl::Vector<HID> lst(1), lst_, children;
+  for (sctl::Integer d = 0; d < depth; d++) { // all the boxes at the given depth, in the order of the children
+    lst_.ReInit(0);
+    for (const auto& m : lst) {
+      m.Children(children);
+      SCTL_ASSERT(children.Dim() == (1 << DIM));
+      for (const auto& c : children) {
+        SCTL_ASSERT(m.isAncestor(c) && c.Depth() == d+1);
+        lst_.PushBack(c);
+      }
+    }
+    lst.Swap(lst_);
+  }
+  for (sctl::Long i = 0; i+1 < lst.Dim(); i++) {
+    SCTL_ASSERT(lst[i] < lst[i+1]);
+    SCTL_ASSERT(lst[i].Next().Ancestor(depth) == lst[i+1]);
+
+    sctl::StaticArray<double,DIM> x0, x1;
+    lst[i].Coord(x0);
+    lst[i+1].Coord(x1);
+    double dist = 0;
+    for (sctl::Integer k = 0; k < DIM; k++) dist += fabs(x1[k] - x0[k]);
+    SCTL_ASSERT(dist == sctl::pow<double>(0.5, depth)); // consecutive boxes share a face
+  }
+
+  const sctl::Long N = 20000;
+  srand48(comm.Rank() + 1);
+  sctl::Vector<double> X(N*DIM), f(N);
+  for (auto& x : X) x = sctl::pow<3>(drand48()*2-1.0)*0.5+0.5;
+  for (sctl::Long i = 0; i < N; i++) f[i] = (double)(comm.Rank() * N + i);
+
+  sctl::PtTree<double,DIM,sctl::Tree<DIM,HID>> tree(comm);
+  tree.AddParticles("pt", X);
+  tree.AddParticleData("pt-value", "pt", f);
+  tree.UpdateRefinement(X, 100);
+  const auto& node_mid = tree.GetNodeMID();
+  const auto& node_lst = tree.GetNodeLists();
+  for (sctl::Long i = 0; i+1 < node_mid.Dim(); i++) SCTL_ASSERT(node_mid[i] < node_mid[i+1]);
+  for (sctl::Long i = 0; i < node_mid.Dim(); i++) {
+    const sctl::Long p = node_lst[i].parent;
+    if (p >= 0) SCTL_ASSERT(node_mid[p].isAncestor(node_mid[i]));
+  }
+
+  sctl::Vector<double> f_;
+  tree.GetParticleData(f_, "pt-value");
+  SCTL_ASSERT(f_.Dim() == f.Dim());
+  for (sctl::Long i = 0; i < f.Dim(); i++) SCTL_ASSERT(f_[i] == f[i]);
+  SCTL_ASSERT(MaxLeafCount<double>(tree, "pt") <= 100);
+}
+
+template <class Real, sctl::Integer DIM> void TestInterleaveData(const sctl::Comm& comm) {  // interleave a scalar and a vector field of the same particles
+  const sctl::Long N = 20000;
+  srand48(comm.Rank() + 1);
+  sctl::Vector<Real> X(N*DIM), f(N), g(N*DIM);
+  for (auto& x : X) x = (Real)(sctl::pow<3>(drand48()*2-1.0)*0.5+0.5);
+  for (sctl::Long i = 0; i < N; i++) {
+    f[i] = (Real)(comm.Rank() * N + i);
+    for (sctl::Integer k = 0; k < DIM; k++) g[i*DIM+k] = -f[i] - (Real)k / DIM;
+  }
+
+  sctl::PtTree<Real,DIM> tree(comm);
+  tree.AddParticles("pt", X);
+  tree.AddParticleData("pt-f", "pt", f);
+  tree.AddParticleData("pt-g", "pt", g);
+  tree.UpdateRefinement(X, 100);
+  tree.InterleaveParticleData("pt-fg", sctl::Vector<std::string>{"pt-f", "pt-g"});
+
+  const auto check_data = [&]() {
+    sctl::Vector<Real> fg;
+    tree.GetParticleData(fg, "pt-fg");
+    SCTL_ASSERT(fg.Dim() == N*(DIM+1));
+    for (sctl::Long i = 0; i < N; i++) {
+      SCTL_ASSERT(fg[i*(DIM+1)] == f[i]);
+      for (sctl::Integer k = 0; k < DIM; k++) SCTL_ASSERT(fg[i*(DIM+1)+1+k] == g[i*DIM+k]);
+    }
+
+    typename sctl::Tree<DIM>::template DataView<Real> view;
+    tree.GetDataView(view, "pt-fg");
+    SCTL_ASSERT(view.dof == DIM+1);
+    for (sctl::Long i = 0; i < view.cnt.Dim(); i++) { // the scalar value is followed by the vector of each particle
+      for (sctl::Long j = 0; j < view.cnt[i]; j++) {
+        for (sctl::Integer k = 0; k < DIM; k++) SCTL_ASSERT(view[i][j*(DIM+1)+1+k] == -view[i][j*(DIM+1)] - (Real)k / DIM);
+      }
+    }
+  };
+  check_data();
+
+  tree.template Broadcast<Real>("pt-fg"); // the ghost nodes get the interleaved data
+  check_data();
+
+  tree.UpdateRefinement(X, 50); // the interleaved field is moved to the new tree nodes
+  check_data();
+}
+
 int main(int argc, char** argv) {
   sctl::Comm::MPI_Init(&argc, &argv);
   sctl::PtTree<double,2>::test();
+  TestIncrementalRefinement<double,3>(sctl::Comm::World());
+  TestRepartition<double,3>(sctl::Comm::World());
+  TestHilbertOrder<2>(sctl::Comm::World());
+  TestHilbertOrder<3>(sctl::Comm::World());
+  TestInterleaveData<double,3>(sctl::Comm::World());
   sctl::Comm::MPI_Finalize();
 
   return 0;
 }
-
@@ -1,6 +1,7 @@
 #include "sctl.hpp"
 
 int main(int argc, char** argv) {
+  sctl::SphericalHarmonics<double>::test();
   sctl::SphericalHarmonics<double>::test_stokes();
   return 0;
 }
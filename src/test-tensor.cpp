@@ -3,9 +3,54 @@
 
 using namespace sctl;
 
+void TestTensorExprLifetime() {  // expressions hold references to the tensor operands and copies of the scalars
+  Tensor<double, true, 3, 4> x, y;
+  for (auto& v : x) v = drand48();
+  for (auto& v : y) v = drand48();
+
+  const auto e = x * (1.0 + 1.0) + y;  // the scalar temporary is copied into the expression
+  x = 1.0;  // the expression sees later updates of its operands
+  const Tensor<double, true, 3, 4> w = e;
+  double err = 0;
+  for (Long i = 0; i < w.Size(); i++) err = std::max(err, fabs(w.begin()[i] - (2 + y.begin()[i])));
+
+  // temporary tensors used within one full-expression
+  const Tensor<double, true, 3, 4> z = x.RotateRight().RotateLeft() * 2 - (x + y).Eval() + (-y).Eval().RotateLeft().RotateRight();
+  for (Long i = 0; i < z.Size(); i++) err = std::max(err, fabs(z.begin()[i] - (1 - 2 * y.begin()[i])));
+
+  std::cout << "TensorExpr lifetime error: " << err << '\n';
+  SCTL_ASSERT(err < 10 * machine_eps<double>());
+}
+
+void TestTensorExprAliasing() {  // assignment of expressions that read from the output tensor
+  constexpr Long N = 21;
+  Tensor<double, true, N + 1> buff;
+  for (Long i = 0; i < N + 1; i++) buff(i) = (double)i;
+  Tensor<double, false, N> u(buff.begin()), v(buff.begin() + 1);  // overlapping views, shifted by one element
+
+  double err = 0;
+  v = u * 2 + 1;  // v(i) = 2*i + 1 (must not read the updated values)
+  for (Long i = 0; i < N; i++) err = std::max(err, fabs(buff(i + 1) - (2 * i + 1)));
+  SCTL_ASSERT(buff(0) == 0);
+
+  u = v - u + u;  // u(i) = v(i) = 2*i + 1, with both an aligned and a shifted operand
+  for (Long i = 0; i < N; i++) err = std::max(err, fabs(buff(i) - (2 * i + 1)));
+
+  Tensor<double, true, 5, 7> x;
+  for (auto& a : x) a = drand48();
+  const Tensor<double, true, 5, 7> x0 = x;
+  x = x * 2 + x;  // aligned, evaluated in place
+  for (Long i = 0; i < x.Size(); i++) err = std::max(err, fabs(x.begin()[i] - 3 * x0.begin()[i]));
+
+  std::cout << "TensorExpr aliasing error: " << err << '\n';
+  SCTL_ASSERT(err == 0);
+}
+
 int main() {
 
   Tensor<double,false,0>::test();
+  TestTensorExprLifetime();
+  TestTensorExprAliasing();
 
     return 0;
 }
@@ -1,3 +1,7 @@
+#include <deque>
+#include <glob.h>
+#include <unistd.h>
+
 #include "sctl.hpp"
 
 void ProfileMemgr() {
@@ -38,6 +42,80 @@ void ProfileMemgr() {
 
     sctl::Profile::Toc();
   }
+  {  // Small allocations (reused from per-thread caches)
+    sctl::Profile::Tic("Small-Alloc");
+#pragma omp parallel for schedule(static)
+    for (long i = 0; i < 10000; i++) {
+      sctl::Vector<double> v(i % 100 + 1);
+      v[0] = (double)i;
+    }
+#if !defined(SCTL_MEMDEBUG) && SCTL_MEM_THREAD_CACHE > 0
+    {  // a freed block is reused from the cache of the thread
+      auto A = sctl::aligned_new<double>(100);
+      const double* A_ptr = &A[0];
+      sctl::aligned_delete(A);
+      const long cached_count = sctl::Profile::IncrementCounter(sctl::ProfileCounter::HEAP_ALLOC_CACHED_COUNT, 0);
+      auto B = sctl::aligned_new<double>(100);
+      SCTL_ASSERT(&B[0] == A_ptr);
+      SCTL_ASSERT(SCTL_PROFILE < 0 || sctl::Profile::IncrementCounter(sctl::ProfileCounter::HEAP_ALLOC_CACHED_COUNT, 0) == cached_count + 1);
+      sctl::aligned_delete(B);
+    }
+#endif
+    sctl::Profile::Toc();
+  }
+  {  // Allocations from (NUMA-aware) pools of a memory buffer
+    sctl::Profile::Tic("Pool-Alloc");
+    sctl::MemoryManager mem_mgr(64 * 1024 * 1024);
+#pragma omp parallel for schedule(static)
+    for (long i = 0; i < 1000; i++) {
+      auto A = sctl::aligned_new<double>(i * 100 + 1, &mem_mgr);
+      A[0] = (double)i;
+      sctl::aligned_delete(A, &mem_mgr);
+    }
+    mem_mgr.FlushThreadCaches();
+    {  // when the pool of the thread is full, blocks are allocated from the other pools and then from the system
+      const long block_size = 4 * 1024 * 1024;  // larger than the blocks kept in the thread caches
+      std::vector<sctl::Iterator<char>> blocks;
+      for (long i = 0; i < 8; i++) {  // half of the buffer, more than fits in one pool when there are several
+        blocks.push_back(sctl::aligned_new<char>(block_size, &mem_mgr));
+        SCTL_ASSERT(sctl::MemoryManager::GetMemHead(&blocks.back()[0]).n_indx > 0);  // from the buffer
+      }
+      blocks.push_back(sctl::aligned_new<char>(64 * 1024 * 1024, &mem_mgr));
+      SCTL_ASSERT(sctl::MemoryManager::GetMemHead(&blocks.back()[0]).n_indx == 0);  // from the system
+      for (auto& A : blocks) sctl::aligned_delete(A, &mem_mgr);
+    }
+    sctl::Profile::Toc();
+  }
+  {  // Scratch allocations from an arena
+    sctl::Profile::Tic("Arena-Alloc");
+#pragma omp parallel
+    {
+      sctl::Profile::Scoped prof("Arena-Thread");  // recorded only in the trace
+      sctl::MemoryArena arena;
+#pragma omp for schedule(static)
+      for (long i = 0; i < 10000; i++) {
+        SCTL_ASSERT(arena.Size() == 0);  // released by the Scope of the previous iteration
+        sctl::MemoryArena::Scope arena_scope(arena);
+        sctl::Vector<double> v(i % 100 + 1, arena);
+        sctl::Matrix<double> M(i % 10 + 1, 10, arena);
+        v[0] = M[0][0] = (double)i;
+      }
+      {  // nested scopes restore the offset at their start
+        sctl::MemoryArena::Scope arena_scope0(arena);
+        sctl::Vector<double> v0(100, arena);
+        const long offset = arena.Size();
+        SCTL_ASSERT(offset > 0);
+        {
+          sctl::MemoryArena::Scope arena_scope1(arena);
+          sctl::Vector<double> v1(100, arena);
+          SCTL_ASSERT(arena.Size() > offset);
+        }
+        SCTL_ASSERT(arena.Size() == offset);
+      }
+      SCTL_ASSERT(arena.Size() == 0);
+    }
+    sctl::Profile::Toc();
+  }
 }
 
 void TestMatrix() {
@@ -54,9 +132,385 @@ void TestMatrix() {
   sctl::Matrix<double> M3 = M1 * M2;
   sctl::Profile::Toc();
 
+  {  // Check the native GEMM against a direct evaluation
+    double max_err = 0;
+    for (int trans = 0; trans < 4; trans++) {
+      for (long n : {3, 17, 70}) {
+        const char TransA = (trans & 1 ? 'T' : 'N'), TransB = (trans & 2 ? 'T' : 'N');
+        const long M = n, N = n + 5, K = 2 * n + 1;
+        sctl::Matrix<double> A(M, K), B(K, N), C(M, N);
+        for (long i = 0; i < M * K; i++) A[0][i] = drand48();
+        for (long i = 0; i < K * N; i++) B[0][i] = drand48();
+        sctl::Matrix<double> A_ = (trans & 1 ? A.Transpose() : A), B_ = (trans & 2 ? B.Transpose() : B);
+        C = 1;
+        // row-major C = A * B is column-major C^T = B^T * A^T
+        sctl::mat::gemm_native<double>(TransB, TransA, N, M, K, 2.0, B_.begin(), B_.Dim(1), A_.begin(), A_.Dim(1), 0.5, C.begin(), N);
+        for (long i = 0; i < M; i++) {
+          for (long j = 0; j < N; j++) {
+            double Cij = 0.5;
+            for (long k = 0; k < K; k++) Cij += 2.0 * A[i][k] * B[k][j];
+            max_err = std::max(max_err, fabs(C[i][j] - Cij));
+          }
+        }
+      }
+    }
+    std::cout << "GEMM error: " << max_err << '\n';
+    SCTL_ASSERT(max_err < 1e-12);
+  }
+
   sctl::Profile::Toc();
 }
 
+void TestSort() {  // Compare radix_sort (used automatically by merge_sort for Morton keys) against std::sort
+  const long N = 100000;
+  sctl::Vector<long> A(N), B;
+  sctl::Vector<sctl::Morton<3>> M(N), M_;
+  for (long i = 0; i < N; i++) {
+    A[i] = (long)(drand48() * 2e12) - (long)1e12;
+    const double x[3] = {drand48(), drand48(), drand48()};
+    M[i] = sctl::Morton<3>(sctl::Ptr2ConstItr<double>(x, 3), (uint8_t)(drand48() * 10));
+  }
+  B = A;
+  M_ = M;
+  std::deque<long> D(A.begin(), A.end());  // not contiguous
+  sctl::omp_par::radix_sort(A.begin(), A.end());
+  sctl::omp_par::radix_sort(D.begin(), D.end());
+  sctl::omp_par::merge_sort(M.begin(), M.end());
+  std::sort(B.begin(), B.end());
+  std::sort(M_.begin(), M_.end());
+  for (long i = 0; i < N; i++) SCTL_ASSERT(A[i] == B[i] && D[i] == B[i] && M[i] == M_[i]);
+
+  sctl::Vector<std::pair<long,long>> P(N);  // key-value variant (stable)
+  for (long i = 0; i < N; i++) P[i] = std::make_pair(B[(i * 7919) % N] % 1000, i);
+  sctl::omp_par::radix_sort(P.begin(), P.end(), [](const std::pair<long,long>& p) { return p.first; });
+  for (long i = 1; i < N; i++) SCTL_ASSERT(P[i-1] < P[i]);
+}
+
+void TestFileIO() {  // Versioned binary format, legacy format and read-only memory mapping
+  sctl::Matrix<double> M(37, 11), M_;
+  for (long i = 0; i < M.Dim(0) * M.Dim(1); i++) M[0][i] = drand48();
+  M.Write("test-matrix.bin");
+  M_.Read("test-matrix.bin");
+  SCTL_ASSERT(M_.Dim(0) == M.Dim(0) && M_.Dim(1) == M.Dim(1));
+  for (long i = 0; i < M.Dim(0) * M.Dim(1); i++) SCTL_ASSERT(M_[0][i] == M[0][i]);
+
+  sctl::Vector<float> V;
+  V.Read("test-matrix.bin");  // type mismatch
+  SCTL_ASSERT(V.Dim() == 0);
+
+  {
+    sctl::MappedFile file("test-matrix.bin");
+    const sctl::Matrix<double> Mmap = file.MatrixView<double>();
+    const sctl::Vector<double> Vmap = file.VectorView<double>();
+    SCTL_ASSERT(Mmap.Dim(0) == M.Dim(0) && Mmap.Dim(1) == M.Dim(1) && Vmap.Dim() == M.Dim(0) * M.Dim(1));
+    for (long i = 0; i < M.Dim(0) * M.Dim(1); i++) SCTL_ASSERT(Mmap[0][i] == M[0][i] && Vmap[i] == M[0][i]);
+  }
+
+  {  // legacy format (uint64 dim0, dim1, data), with trailing bytes
+    FILE* f = fopen("test-matrix.bin", "wb");
+    const uint64_t dim[2] = {(uint64_t)M.Dim(0), (uint64_t)M.Dim(1)};
+    fwrite(dim, sizeof(uint64_t), 2, f);
+    fwrite(&M[0][0], sizeof(double), M.Dim(0) * M.Dim(1), f);
+    fwrite(dim, sizeof(uint64_t), 2, f);
+    fclose(f);
+    M_.ReInit(0, 0);
+    M_.Read("test-matrix.bin");
+    SCTL_ASSERT(M_.Dim(0) == M.Dim(0) && M_.Dim(1) == M.Dim(1));
+    sctl::MappedFile file("test-matrix.bin");
+    const sctl::Matrix<double> Mmap = file.MatrixView<double>();
+    for (long i = 0; i < M.Dim(0) * M.Dim(1); i++) SCTL_ASSERT(M_[0][i] == M[0][i] && Mmap[0][i] == M[0][i]);
+  }
+  std::remove("test-matrix.bin");
+}
+
+void TestVTU() {  // Single-file VTU writer: every rank adds a line segment
+  const sctl::Comm comm = sctl::Comm::World();
+  const long rank = comm.Rank(), np = comm.Size();
+  sctl::VTUData vtu_data;
+  for (long i = 0; i < 6; i++) vtu_data.coord.PushBack((sctl::VTUData::VTKReal)(6 * rank + i));
+  for (long i = 0; i < 2; i++) vtu_data.value.PushBack((sctl::VTUData::VTKReal)rank);
+  vtu_data.types.PushBack(3);  // VTK_LINE (=3)
+  for (long i = 0; i < 2; i++) vtu_data.connect.PushBack(i);
+  vtu_data.offset.PushBack(vtu_data.connect.Dim());
+
+  vtu_data.WriteVTU("test-vtu", comm, false, false);
+  vtu_data.WriteVTU("test-vtu-async", comm, false, true);
+  sctl::VTUData::WaitVTU();
+  comm.Barrier();
+
+  if (!rank) {
+    const auto read_file = [](const char* fname) {
+      std::ifstream file(fname, std::ios::binary);
+      SCTL_ASSERT(!file.fail());
+      return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    };
+    const std::string data = read_file("test-vtu.vtu");
+    SCTL_ASSERT(data == read_file("test-vtu-async.vtu"));
+    SCTL_ASSERT(data.find("NumberOfPoints=\"" + std::to_string(2 * np) + "\" NumberOfCells=\"" + std::to_string(np) + "\"") != std::string::npos);
+
+    // Appended arrays: [size][Position][size][value][size][mpi_rank][size][connectivity]...
+    const std::string footer = "\n  </AppendedData>\n</VTKFile>\n";
+    size_t offset = data.find("<AppendedData encoding=\"raw\">\n    _");
+    SCTL_ASSERT(offset != std::string::npos && data.size() >= footer.size() && data.compare(data.size() - footer.size(), footer.size(), footer) == 0);
+    offset = data.find('_', offset) + 1;
+    const auto read_array = [&data, &offset](std::vector<char>& array) {
+      uint64_t size;
+      SCTL_ASSERT(offset + sizeof(uint64_t) <= data.size());
+      memcpy(&size, &data[offset], sizeof(uint64_t));
+      SCTL_ASSERT(offset + sizeof(uint64_t) + size <= data.size());
+      array.assign(data.begin() + offset + sizeof(uint64_t), data.begin() + offset + sizeof(uint64_t) + size);
+      offset += sizeof(uint64_t) + size;
+    };
+    std::vector<char> coord, value, mpi_rank, connect;
+    read_array(coord);
+    read_array(value);
+    read_array(mpi_rank);
+    read_array(connect);
+    SCTL_ASSERT(coord.size() == 6 * np * sizeof(sctl::VTUData::VTKReal) && connect.size() == 2 * np * sizeof(int64_t));
+    for (long i = 0; i < 6 * np; i++) {
+      sctl::VTUData::VTKReal x;
+      memcpy(&x, &coord[i * sizeof(x)], sizeof(x));
+      SCTL_ASSERT(x == (sctl::VTUData::VTKReal)i);
+    }
+    for (long i = 0; i < 2 * np; i++) {
+      int64_t j;
+      memcpy(&j, &connect[i * sizeof(j)], sizeof(j));
+      SCTL_ASSERT(j == i);  // numbered globally
+    }
+    std::remove("test-vtu.vtu");
+    std::remove("test-vtu-async.vtu");
+  }
+  comm.Barrier();
+}
+
+void TestChebBasis() {  // Fast (DCT) transforms at high order and concurrent use of the precomputed matrices
+  for (const long order : {20, 33, 256}) {  // dof rows, in full and partial batches of the cached FFT plans
+    const long dof = 19;
+    sctl::Vector<double> x, fn(dof * order), coeff, fn_;
+    sctl::ChebBasis<double>::Nodes<1>(order, x);
+    for (long k = 0; k < dof; k++) {
+      for (long i = 0; i < order; i++) fn[k * order + i] = exp(x[i] + 0.1 * k);
+    }
+    sctl::ChebBasis<double>::Approx<1>(order, fn, coeff);
+    sctl::ChebBasis<double>::Eval<1>(order, coeff, sctl::Ptr2ConstItr<sctl::Vector<double>>(&x, 1), fn_);  // at the nodes
+    double max_err = 0;
+    for (long k = 0; k < dof; k++) {
+      for (long i = 0; i < order; i++) max_err = std::max(max_err, fabs(fn_[i * dof + k] - fn[k * order + i]));
+    }
+    sctl::Vector<double> y(100);
+    for (auto& y_ : y) y_ = drand48();
+    sctl::ChebBasis<double>::Eval<1>(order, coeff, sctl::Ptr2ConstItr<sctl::Vector<double>>(&y, 1), fn_);  // at other points
+    for (long k = 0; k < dof; k++) {
+      for (long i = 0; i < y.Dim(); i++) max_err = std::max(max_err, fabs(fn_[i * dof + k] - exp(y[i] + 0.1 * k)));
+    }
+    std::cout << "ChebBasis error (order " << order << "): " << max_err << '\n';
+    SCTL_ASSERT(max_err < 1e-12);
+  }
+
+  #pragma omp parallel for schedule(static)
+  for (long i = 0; i < 64; i++) {
+    const long order_ = 2 + i % 32;  // (both below and above SCTL_CHEB_DCT_MIN_ORDER)
+    sctl::Vector<double> fn0(order_ * order_), coeff0;
+    fn0 = 1;
+    sctl::ChebBasis<double>::Approx<2>(order_, fn0, coeff0);
+    SCTL_ASSERT(fabs(coeff0[0] - 1) < 1e-12);
+  }
+}
+
+void TestMetrics() {  // Per-thread recording, cross-rank reduction and export
+  const sctl::Comm comm = sctl::Comm::World();
+  sctl::Metrics::Reset();
+  #pragma omp parallel for schedule(static)
+  for (long i = 0; i < 1000; i++) sctl::Metrics::Record(sctl::Metric::CUSTOM1, (double)(i % 4 + 1));
+  { sctl::Vector<double> v(1000000); }  // larger than the blocks kept in the thread caches (not recorded)
+  double x = 1, y;
+  comm.Allreduce(sctl::Ptr2ConstItr<double>(&x, 1), sctl::Ptr2Itr<double>(&y, 1), 1, sctl::CommOp::SUM);
+
+  sctl::Metrics::StartReduce(comm);
+  sctl::Metrics::FinishReduce();
+  std::stringstream json, prom;
+  sctl::Metrics::WriteJSON(json, &comm);
+  sctl::Metrics::WritePrometheus(prom, &comm);
+  const std::string rank = std::to_string(comm.Rank()), np = std::to_string(1000 * comm.Size());
+
+  std::string line;
+  bool found_local = false, found_all = false, found_alloc = false, found_allreduce = false;
+  while (std::getline(json, line)) {
+    if (line.find("\"metric\":\"custom1\",\"rank\":" + rank + ",\"count\":1000,\"sum\":2500,\"min\":1,\"max\":4") == 1) found_local = true;
+    if (line.find("\"metric\":\"custom1\",\"rank\":\"all\",\"count\":" + np + ",") == 1) found_all = true;
+    if (line.find("\"metric\":\"mem_alloc_bytes\"") == 1) found_alloc = true;
+    if (line.find("\"metric\":\"comm_allreduce_bytes\"") == 1) found_allreduce = true;
+    if (line.find("custom1") != std::string::npos) std::cout << line << '\n';
+  }
+  SCTL_ASSERT(found_local && found_alloc);
+#ifdef SCTL_HAVE_MPI
+  SCTL_ASSERT(found_allreduce);
+#else
+  SCTL_UNUSED(found_allreduce);
+#endif
+  SCTL_ASSERT(found_all == (comm.Rank() == 0));
+  SCTL_ASSERT(prom.str().find("sctl_custom1_count{rank=\"" + rank + "\"} 1000\n") != std::string::npos);
+  SCTL_ASSERT(prom.str().find("sctl_custom1_bucket{rank=\"" + rank + "\",le=\"2\"} 500\n") != std::string::npos);
+}
+
+class SphereElemList : public sctl::ElementListBase<double> {  // unit sphere split into Nt x Np patches, with q x q midpoint-rule nodes each
+  public:
+    SphereElemList(long Nt, long Np, long q) : Nt_(Nt), Np_(Np), q_(q) {
+      const long N = Nt * Np * q * q;
+      X_.ReInit(N * 3);
+      wts_.ReInit(N);
+      const double dt = sctl::const_pi<double>() / (Nt * q), dp = 2 * sctl::const_pi<double>() / (Np * q);
+      for (long i = 0; i < Nt * q; i++) {
+        for (long j = 0; j < Np * q; j++) {
+          const long idx = (((i / q) * Np + j / q) * q + i % q) * q + j % q;
+          const double t = (i + 0.5) * dt, p = (j + 0.5) * dp;
+          X_[idx * 3 + 0] = sin(t) * cos(p);
+          X_[idx * 3 + 1] = sin(t) * sin(p);
+          X_[idx * 3 + 2] = cos(t);
+          wts_[idx] = sin(t) * dt * dp;
+        }
+      }
+    }
+
+    sctl::Long Size() const override { return Nt_ * Np_; }
+
+    void GetNodeCoord(sctl::Vector<double>* X, sctl::Vector<double>* Xn, sctl::Vector<sctl::Long>* element_wise_node_cnt) const override {
+      if (X) (*X) = X_;
+      if (Xn) (*Xn) = X_;
+      if (element_wise_node_cnt) {
+        element_wise_node_cnt->ReInit(Size());
+        (*element_wise_node_cnt) = q_ * q_;
+      }
+    }
+
+    void GetFarFieldNodes(sctl::Vector<double>& X, sctl::Vector<double>& Xn, sctl::Vector<double>& wts, sctl::Vector<double>& dist_far, sctl::Vector<sctl::Long>& element_wise_node_cnt, const double tol) const override {
+      GetNodeCoord(&X, &Xn, &element_wise_node_cnt);
+      wts = wts_;
+      dist_far.ReInit(wts_.Dim());
+      dist_far = 2 * sctl::const_pi<double>() / Nt_;
+    }
+
+    template <class Kernel> static void SelfInterac(sctl::Vector<sctl::Matrix<double>>& M_lst, const Kernel& ker, double tol, bool trg_dot_prod, const sctl::ElementListBase<double>* self) {
+      const auto& elem_lst = *dynamic_cast<const SphereElemList*>(self);
+      const long Nnds = elem_lst.q_ * elem_lst.q_;
+      if (M_lst.Dim() != elem_lst.Size()) M_lst.ReInit(elem_lst.Size());
+      for (long i = 0; i < elem_lst.Size(); i++) {
+        const sctl::Vector<double> X(Nnds * 3, (sctl::Iterator<double>)elem_lst.X_.begin() + i * Nnds * 3, false);
+        elem_lst.ElemMatrix(M_lst[i], X, ker, i);
+      }
+      interac_count++;
+    }
+
+    template <class Kernel> static void NearInterac(sctl::Matrix<double>& M, const sctl::Vector<double>& Xt, const sctl::Vector<double>& normal_trg, const Kernel& ker, double tol, const sctl::Long elem_idx, const sctl::ElementListBase<double>* self) {
+      dynamic_cast<const SphereElemList*>(self)->ElemMatrix(M, Xt, ker, elem_idx);
+      for (long i = 0; i < M.Dim(0) * M.Dim(1); i++) M[0][i] *= 1.5;  // differs from the far-field quadrature
+      #pragma omp atomic update
+      interac_count++;
+    }
+
+    static long interac_count;  // number of self and near interaction setups
+
+  private:
+    template <class Kernel> void ElemMatrix(sctl::Matrix<double>& M, const sctl::Vector<double>& Xt, const Kernel& ker, const sctl::Long elem_idx) const {
+      const long Nnds = q_ * q_;
+      const sctl::Vector<double> Xs(Nnds * 3, (sctl::Iterator<double>)X_.begin() + elem_idx * Nnds * 3, false);
+      ker.KernelMatrix(M, Xt, Xs, Xs);
+      for (long i = 0; i < Nnds * Kernel::SrcDim(); i++) {
+        for (long j = 0; j < M.Dim(1); j++) M[i][j] *= wts_[elem_idx * Nnds + i / Kernel::SrcDim()];
+      }
+    }
+
+    long Nt_, Np_, q_;
+    sctl::Vector<double> X_, wts_;
+};
+long SphereElemList::interac_count = 0;
+
+void TestSetupCache() {  // BoundaryIntegralOp setup read from the on-disk cache
+  const char* tmp_dir = getenv("TMPDIR");
+  std::string prefix = std::string(tmp_dir ? tmp_dir : "/tmp") + "/sctl-setup-cache-XXXXXX";
+  const int fd = mkstemp(&prefix[0]);
+  SCTL_ASSERT(fd >= 0);
+  close(fd);
+
+  const sctl::Laplace3D_FxU ker;
+  const auto compute_potential = [&](sctl::Vector<double>& U, long Nt, bool cache, const sctl::Laplace3D_FxU& kernel, const std::string& key) {  // returns the number of interaction setups
+    const SphereElemList elem_lst(Nt, 2 * Nt, 4);
+    sctl::BoundaryIntegralOp<double,sctl::Laplace3D_FxU> BIOp(kernel, false, sctl::Comm::Self());
+    if (cache) BIOp.SetSetupCache(prefix, key);
+    BIOp.AddElemList(elem_lst);
+    sctl::Vector<double> F(BIOp.Dim(0));
+    for (long i = 0; i < F.Dim(); i++) F[i] = sin((double)i);
+    SphereElemList::interac_count = 0;
+    BIOp.ComputePotential(U, F);
+    return SphereElemList::interac_count;
+  };
+
+  sctl::Vector<double> U0, U1, U2, U3, U4;
+  SCTL_ASSERT(compute_potential(U0, 6, false, ker, "") > 0);
+  SCTL_ASSERT(compute_potential(U1, 6, true, ker, "") > 0);  // setup and write the cache
+  SCTL_ASSERT(compute_potential(U2, 6, true, ker, "") == 0);  // read from the cache
+  SCTL_ASSERT(compute_potential(U3, 8, true, ker, "") > 0);  // a different discretization has a different key
+  SCTL_ASSERT(compute_potential(U4, 6, true, ker, "k=1") > 0);  // a different caller-supplied key
+
+  int ctx = 0;
+  sctl::Laplace3D_FxU ker_ctx;
+  ker_ctx.SetCtxPtr(&ctx);
+  SCTL_ASSERT(compute_potential(U4, 6, true, ker_ctx, "") > 0);  // no caching for a kernel with context and no key
+  SCTL_ASSERT(compute_potential(U4, 6, true, ker_ctx, "") > 0);
+  SCTL_ASSERT(compute_potential(U4, 6, true, ker_ctx, "k=1") == 0);
+  SCTL_ASSERT(U0.Dim() == U2.Dim());
+  for (long i = 0; i < U0.Dim(); i++) SCTL_ASSERT(U1[i] == U0[i] && U2[i] == U0[i]);
+
+  glob_t files;
+  SCTL_ASSERT(!glob((prefix + "-*.bin").c_str(), 0, nullptr, &files));
+  std::cout << "Setup cache files: " << files.gl_pathc << '\n';
+  SCTL_ASSERT(files.gl_pathc == 3);
+  for (size_t i = 0; i < files.gl_pathc; i++) std::remove(files.gl_pathv[i]);
+  globfree(&files);
+  std::remove(prefix.c_str());
+}
+
+void TestBlockGMRES() {  // block GMRES with the batched BoundaryIntegralOp evaluation
+  const sctl::Laplace3D_FxU ker;
+  const SphereElemList elem_lst(6, 12, 4);
+  sctl::BoundaryIntegralOp<double,sctl::Laplace3D_FxU> BIOp(ker, false, sctl::Comm::Self());
+  BIOp.AddElemList(elem_lst);
+  const long k = 3, N = BIOp.Dim(0);
+
+  long apply_count = 0;
+  const auto BlockOp = [&](sctl::Matrix<double>* U, const sctl::Matrix<double>& F) {  // (I + K) F, for all rows of F together
+    BIOp.ComputePotential(*U, F);
+    (*U) += F;
+    apply_count++;
+  };
+  const auto LinOp = [&](sctl::Vector<double>* U, const sctl::Vector<double>& F) {
+    BIOp.ComputePotential(*U, F);
+    (*U) += F;
+    apply_count++;
+  };
+
+  sctl::Matrix<double> B(k, N), X;
+  for (long i = 0; i < k * N; i++) B[0][i] = sin(0.1 * (double)i) + (i % N < N / 2 ? 1 : 0);
+  const sctl::GMRES<double> solver(sctl::Comm::Self(), false);
+  solver(&X, BlockOp, B, 1e-10);
+  const long block_count = apply_count;
+
+  apply_count = 0;
+  double max_err = 0, max_val = 0;
+  for (long l = 0; l < k; l++) {  // compare with separate solves
+    const sctl::Vector<double> b(N, B[l], false);
+    sctl::Vector<double> x;
+    solver(&x, LinOp, b, 1e-10);
+    for (long i = 0; i < N; i++) {
+      max_err = std::max(max_err, fabs(X[l][i] - x[i]));
+      max_val = std::max(max_val, fabs(x[i]));
+    }
+  }
+  std::cout << "Block GMRES operator applies = " << block_count << ", separate = " << apply_count << ", relative difference = " << max_err / max_val << '\n';
+  SCTL_ASSERT(max_err < 1e-8 * max_val);
+  SCTL_ASSERT(block_count < apply_count);
+}
+
 int main(int argc, char** argv) {
   sctl::Comm::MPI_Init(&argc, &argv);
 
@@ -65,14 +519,35 @@ int main(int argc, char** argv) {
 
   // With profiling enabled
   sctl::Profile::Enable(true);
+  sctl::Profile::EnableTrace(true);
   ProfileMemgr();
 
   TestMatrix();
+  TestSort();
+  if (!sctl::Comm::World().Rank()) TestFileIO();
+  TestVTU();
+  TestChebBasis();
+  TestMetrics();
+  if (!sctl::Comm::World().Rank()) TestSetupCache();
+  if (!sctl::Comm::World().Rank()) TestBlockGMRES();
+  sctl::LagrangeInterp<double>::test();
 
   // Print profiling results
   sctl::Profile::SetProfField("alloc/s", sctl::Profile::GetProfField("alloc_count")/sctl::Profile::GetProfField("t"));
-  sctl::Profile::print(nullptr, {"t", "alloc/s"}, {"%.8f"});
+  sctl::Profile::print(nullptr, {"t", "alloc/s", "alloc_cached_count"}, {"%.8f", "%.4f", "%.0f"});
   sctl::Profile::print();
+  {  // Write the trace to a temporary file
+    const char* tmp_dir = getenv("TMPDIR");
+    std::string fname = std::string(tmp_dir ? tmp_dir : "/tmp") + "/sctl-trace-XXXXXX";
+    const int fd = mkstemp(&fname[0]);
+    SCTL_ASSERT(fd >= 0);
+    close(fd);
+    sctl::Profile::WriteTrace(fname.c_str());
+    FILE* f = fopen(fname.c_str(), "rb");
+    SCTL_ASSERT(f && fgetc(f) == '{');
+    fclose(f);
+    std::remove(fname.c_str());
+  }
 
   {  // Test out-of-bound writes
     sctl::Iterator<char> A = sctl::aligned_new<char>(10);